@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * arch/arm64/lib/csum-neon.c
+ *
+ * NEON bulk loop for do_csum(). Must be called between kernel_neon_begin()
+ * and kernel_neon_end().
+ */
+
+#include <linux/types.h>
+#include <asm/neon-intrinsics.h>
+
+u64 csum_neon_blocks(const unsigned char *buff, int len);
+
+/*
+ * Sums len bytes as native endian 32-bit words into 64-bit lanes. The
+ * one's complement sum is invariant to the word size used, so the caller
+ * only has to fold the returned value. len must be a multiple of 64.
+ */
+u64 csum_neon_blocks(const unsigned char *buff, int len)
+{
+	const uint32_t *p = (const uint32_t *)buff;
+	uint64x2_t acc0 = vdupq_n_u64(0);
+	uint64x2_t acc1 = vdupq_n_u64(0);
+	uint64x2_t acc2 = vdupq_n_u64(0);
+	uint64x2_t acc3 = vdupq_n_u64(0);
+	u64 lo, hi;
+
+	while (len >= 64) {
+		acc0 = vpadalq_u32(acc0, vld1q_u32(p + 0));
+		acc1 = vpadalq_u32(acc1, vld1q_u32(p + 4));
+		acc2 = vpadalq_u32(acc2, vld1q_u32(p + 8));
+		acc3 = vpadalq_u32(acc3, vld1q_u32(p + 12));
+
+		p += 16;
+		len -= 64;
+	}
+
+	/* Each lane stays well below 2^64 for any int sized length */
+	acc0 = vaddq_u64(vaddq_u64(acc0, acc1), vaddq_u64(acc2, acc3));
+
+	lo = vgetq_lane_u64(acc0, 0);
+	hi = vgetq_lane_u64(acc0, 1);
+	lo += hi;
+
+	return lo + (lo < hi);
+}
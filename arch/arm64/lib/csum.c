@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * arch/arm64/lib/csum.c
+ *
+ * Internet checksum core with an optional NEON accelerated bulk loop.
+ */
+
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <asm/checksum.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+/*
+ * Below this length the cost of preserving the FPSIMD state outweighs the
+ * wider NEON accumulation.
+ */
+#define CSUM_NEON_THRESHOLD	512
+#define CSUM_NEON_BLOCK		64
+
+u64 csum_neon_blocks(const unsigned char *buff, int len);
+
+static inline u64 csum_accumulate(u64 sum, u64 data)
+{
+	sum += data;
+	return sum + (sum < data);
+}
+
+static inline unsigned int csum_from64to16(u64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return sum;
+}
+
+unsigned int do_csum(const unsigned char *buff, int len)
+{
+	unsigned int result;
+	u64 sum = 0;
+	int odd;
+
+	if (len <= 0)
+		return 0;
+
+	odd = 1 & (unsigned long)buff;
+	if (odd) {
+#ifdef __LITTLE_ENDIAN
+		sum = *buff << 8;
+#else
+		sum = *buff;
+#endif
+		len--;
+		buff++;
+	}
+
+	while (len >= 2 && (7 & (unsigned long)buff)) {
+		sum += *(const u16 *)buff;
+		len -= 2;
+		buff += 2;
+	}
+
+	if (IS_ENABLED(CONFIG_KERNEL_MODE_NEON) &&
+	    len >= CSUM_NEON_THRESHOLD && may_use_simd()) {
+		int blocks = len & ~(CSUM_NEON_BLOCK - 1);
+
+		kernel_neon_begin();
+		sum = csum_accumulate(sum, csum_neon_blocks(buff, blocks));
+		kernel_neon_end();
+
+		len -= blocks;
+		buff += blocks;
+	}
+
+	while (len >= 8) {
+		sum = csum_accumulate(sum, *(const u64 *)buff);
+		len -= 8;
+		buff += 8;
+	}
+
+	if (len & 4) {
+		sum = csum_accumulate(sum, *(const u32 *)buff);
+		buff += 4;
+	}
+
+	if (len & 2) {
+		sum = csum_accumulate(sum, *(const u16 *)buff);
+		buff += 2;
+	}
+
+	if (len & 1)
+#ifdef __LITTLE_ENDIAN
+		sum = csum_accumulate(sum, *buff);
+#else
+		sum = csum_accumulate(sum, *buff << 8);
+#endif
+
+	result = csum_from64to16(sum);
+	if (odd)
+		result = ((result >> 8) & 0xff) | ((result & 0xff) << 8);
+
+	return result;
+}
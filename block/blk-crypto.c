@@ -304,3 +304,31 @@ int blk_crypto_evict_key(struct request_queue *q,
 	return blk_crypto_fallback_evict_key(key);
 }
 EXPORT_SYMBOL_GPL(blk_crypto_evict_key);
+
+/**
+ * blk_crypto_preload_key() - Program a key into inline encryption hardware
+ *			      before its first use
+ * @q: The request queue whose keyslot manager the key should be programmed into
+ * @key: The key to program
+ *
+ * Upper layers may call this when a key is about to be used heavily, e.g. when
+ * a user's keys are added at unlock, so that the first I/O with the key isn't
+ * stalled programming it. This is only a hint: the key is not pinned and is
+ * still subject to LRU eviction. Keys handled by blk-crypto-fallback are
+ * skipped.
+ *
+ * Return: 0 on success or if there is nothing to preload, -errno on error.
+ */
+int blk_crypto_preload_key(struct request_queue *q,
+			   const struct blk_crypto_key *key)
+{
+	if (q->ksm &&
+	    keyslot_manager_crypto_mode_supported(q->ksm, key->crypto_mode,
+						  blk_crypto_key_dun_bytes(key),
+						  key->data_unit_size,
+						  key->is_hw_wrapped))
+		return keyslot_manager_preload_key(q->ksm, key);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blk_crypto_preload_key);
@@ -0,0 +1,583 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *  Flash I/O scheduler - a FIFO based blk-mq scheduler for UFS class flash
+ *  storage which favours synchronous reads and throttles background writes
+ *  against the observed read latency.
+ *
+ *  Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/blk-mq.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/init.h>
+#include <linux/compiler.h>
+
+#include "blk.h"
+#include "blk-mq.h"
+#include "blk-mq-debugfs.h"
+#include "blk-mq-sched.h"
+#include "blk-stat.h"
+
+/*
+ * Requests are sorted into three classes: reads, synchronous writes (REQ_SYNC,
+ * FUA and flushes) and asynchronous writes (writeback, discards). Reads are
+ * dispatched first, synchronous writes next, and asynchronous writes only
+ * while fewer than async_depth of them are in flight. async_depth backs off
+ * multiplicatively while the read latency EWMA is above read_lat_target and
+ * grows back by one per adjust window otherwise. When the device reports that
+ * its write buffer is disabled or nearly full, writes land on the slow native
+ * cells and the effective depth is halved.
+ */
+static const int read_expire = HZ / 8;	/* max time before a read is submitted */
+static const int write_expire = 2 * HZ;	/* ditto for writes, these are SOFT */
+static const int writes_starved = 4;	/* max times reads can starve a write */
+static const int read_lat_target_us = 2000;
+static const int async_depth_max = 32;
+
+#define FLASH_ADJUST_MS		10
+#define FLASH_WBUF_FULL_PCT	90
+
+enum flash_class {
+	FLASH_READ,
+	FLASH_SYNC_WRITE,
+	FLASH_ASYNC_WRITE,
+	FLASH_NR_CLASSES,
+};
+
+struct flash_data {
+	/*
+	 * run time data
+	 */
+	struct list_head fifo_list[FLASH_NR_CLASSES];
+	struct list_head dispatch;
+	unsigned int starved;		/* times reads have starved writes */
+	unsigned int async_depth;	/* current async write depth */
+	unsigned long next_adjust;	/* jiffies of the next depth update */
+	atomic_t async_inflight;
+	u64 read_lat_ns;		/* read latency EWMA */
+
+	/* statistics */
+	u64 dispatched[FLASH_NR_CLASSES];
+	u64 throttled;
+	u64 expired;
+
+	/*
+	 * settings that change how the i/o scheduler behaves
+	 */
+	int fifo_expire[2];
+	int writes_starved;
+	int read_lat_target_us;
+	int async_depth_max;
+
+	spinlock_t lock;
+};
+
+static inline enum flash_class flash_rq_class(struct request *rq)
+{
+	if (!op_is_write(req_op(rq)))
+		return FLASH_READ;
+	if (op_is_sync(rq->cmd_flags))
+		return FLASH_SYNC_WRITE;
+	return FLASH_ASYNC_WRITE;
+}
+
+/* Async writes currently dispatched to the driver are tagged in priv[0] */
+static inline bool flash_rq_async_inflight(struct request *rq)
+{
+	return rq->elv.priv[0] != NULL;
+}
+
+static void flash_remove_request(struct request_queue *q, struct request *rq)
+{
+	list_del_init(&rq->queuelist);
+
+	elv_rqhash_del(q, rq);
+	if (q->last_merge == rq)
+		q->last_merge = NULL;
+}
+
+static void flash_merged_requests(struct request_queue *q, struct request *req,
+				  struct request *next)
+{
+	/*
+	 * if next expires before rq, assign its expire time to rq
+	 * and move into next position (next will be deleted) in fifo
+	 */
+	if (!list_empty(&req->queuelist) && !list_empty(&next->queuelist)) {
+		if (time_before((unsigned long)next->fifo_time,
+				(unsigned long)req->fifo_time)) {
+			list_move(&req->queuelist, &next->queuelist);
+			req->fifo_time = next->fifo_time;
+		}
+	}
+
+	flash_remove_request(q, next);
+}
+
+static inline bool flash_fifo_expired(struct flash_data *fd,
+				      enum flash_class class)
+{
+	struct request *rq;
+
+	if (list_empty(&fd->fifo_list[class]))
+		return false;
+
+	rq = rq_entry_fifo(fd->fifo_list[class].next);
+	return time_after_eq(jiffies, (unsigned long)rq->fifo_time);
+}
+
+/*
+ * Recompute the async write depth from the read latency once per adjust
+ * window, and derate it while the device write buffer cannot absorb writes.
+ */
+static unsigned int flash_async_depth(struct flash_data *fd,
+				      struct request_queue *q)
+{
+	unsigned int depth;
+
+	if (time_after_eq(jiffies, fd->next_adjust)) {
+		u64 target = (u64)fd->read_lat_target_us * NSEC_PER_USEC;
+
+		if (READ_ONCE(fd->read_lat_ns) > target)
+			fd->async_depth = max(1U, fd->async_depth / 2);
+		else if (fd->async_depth < fd->async_depth_max)
+			fd->async_depth++;
+		fd->async_depth = min_t(unsigned int, fd->async_depth,
+					fd->async_depth_max);
+		fd->next_adjust = jiffies + msecs_to_jiffies(FLASH_ADJUST_MS);
+	}
+
+	depth = fd->async_depth;
+	if (!READ_ONCE(q->wbuf_enabled) ||
+	    READ_ONCE(q->wbuf_fill_pct) >= FLASH_WBUF_FULL_PCT)
+		depth = max(1U, depth / 2);
+
+	return depth;
+}
+
+static struct request *flash_fifo_pop(struct flash_data *fd,
+				      enum flash_class class)
+{
+	struct request *rq;
+
+	if (list_empty(&fd->fifo_list[class]))
+		return NULL;
+
+	rq = rq_entry_fifo(fd->fifo_list[class].next);
+	flash_remove_request(rq->q, rq);
+	fd->dispatched[class]++;
+
+	if (class == FLASH_ASYNC_WRITE) {
+		rq->elv.priv[0] = (void *)1;
+		atomic_inc(&fd->async_inflight);
+	}
+
+	return rq;
+}
+
+static struct request *__flash_dispatch_request(struct flash_data *fd,
+						struct blk_mq_hw_ctx *hctx)
+{
+	struct request_queue *q = hctx->queue;
+	bool async_ok;
+	struct request *rq;
+
+	if (!list_empty(&fd->dispatch)) {
+		rq = list_first_entry(&fd->dispatch, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		goto done;
+	}
+
+	async_ok = atomic_read(&fd->async_inflight) <
+			flash_async_depth(fd, q);
+
+	/* Expired writes go first so that reads cannot starve them forever */
+	if (flash_fifo_expired(fd, FLASH_SYNC_WRITE)) {
+		fd->expired++;
+		rq = flash_fifo_pop(fd, FLASH_SYNC_WRITE);
+		goto done;
+	}
+	if (flash_fifo_expired(fd, FLASH_ASYNC_WRITE)) {
+		fd->expired++;
+		rq = flash_fifo_pop(fd, FLASH_ASYNC_WRITE);
+		goto done;
+	}
+
+	if (!list_empty(&fd->fifo_list[FLASH_READ])) {
+		bool writes = !list_empty(&fd->fifo_list[FLASH_SYNC_WRITE]) ||
+			(async_ok &&
+			 !list_empty(&fd->fifo_list[FLASH_ASYNC_WRITE]));
+
+		if (!writes || fd->starved++ < fd->writes_starved) {
+			rq = flash_fifo_pop(fd, FLASH_READ);
+			goto done;
+		}
+	}
+
+	fd->starved = 0;
+
+	rq = flash_fifo_pop(fd, FLASH_SYNC_WRITE);
+	if (rq)
+		goto done;
+
+	if (!list_empty(&fd->fifo_list[FLASH_ASYNC_WRITE])) {
+		if (async_ok) {
+			rq = flash_fifo_pop(fd, FLASH_ASYNC_WRITE);
+			goto done;
+		}
+		/* Run the queue again once an in-flight request completes */
+		fd->throttled++;
+		blk_mq_sched_mark_restart_hctx(hctx);
+	}
+
+	return NULL;
+
+done:
+	rq->rq_flags |= RQF_STARTED;
+	return rq;
+}
+
+/*
+ * Like mq-deadline, the scheduler state is shared by all hardware queues, so
+ * the request returned may belong to a different hardware queue.
+ */
+static struct request *flash_dispatch_request(struct blk_mq_hw_ctx *hctx)
+{
+	struct flash_data *fd = hctx->queue->elevator->elevator_data;
+	struct request *rq;
+
+	spin_lock(&fd->lock);
+	rq = __flash_dispatch_request(fd, hctx);
+	spin_unlock(&fd->lock);
+
+	return rq;
+}
+
+static void flash_exit_queue(struct elevator_queue *e)
+{
+	struct flash_data *fd = e->elevator_data;
+	int i;
+
+	for (i = 0; i < FLASH_NR_CLASSES; i++)
+		WARN_ON(!list_empty(&fd->fifo_list[i]));
+
+	kfree(fd);
+}
+
+/*
+ * initialize elevator private data (flash_data).
+ */
+static int flash_init_queue(struct request_queue *q, struct elevator_type *e)
+{
+	struct flash_data *fd;
+	struct elevator_queue *eq;
+	int i;
+
+	eq = elevator_alloc(q, e);
+	if (!eq)
+		return -ENOMEM;
+
+	fd = kzalloc_node(sizeof(*fd), GFP_KERNEL, q->node);
+	if (!fd) {
+		kobject_put(&eq->kobj);
+		return -ENOMEM;
+	}
+	eq->elevator_data = fd;
+
+	for (i = 0; i < FLASH_NR_CLASSES; i++)
+		INIT_LIST_HEAD(&fd->fifo_list[i]);
+	INIT_LIST_HEAD(&fd->dispatch);
+	fd->fifo_expire[READ] = read_expire;
+	fd->fifo_expire[WRITE] = write_expire;
+	fd->writes_starved = writes_starved;
+	fd->read_lat_target_us = read_lat_target_us;
+	fd->async_depth_max = async_depth_max;
+	fd->async_depth = async_depth_max;
+	fd->next_adjust = jiffies;
+	atomic_set(&fd->async_inflight, 0);
+	spin_lock_init(&fd->lock);
+
+	/* Needed for rq->io_start_time_ns */
+	blk_stat_enable_accounting(q);
+
+	q->elevator = eq;
+	return 0;
+}
+
+static bool flash_bio_merge(struct request_queue *q, struct bio *bio,
+			    unsigned int nr_segs)
+{
+	struct flash_data *fd = q->elevator->elevator_data;
+	struct request *free = NULL;
+	bool ret;
+
+	spin_lock(&fd->lock);
+	ret = blk_mq_sched_try_merge(q, bio, nr_segs, &free);
+	spin_unlock(&fd->lock);
+
+	if (free)
+		blk_mq_free_request(free);
+
+	return ret;
+}
+
+static void flash_insert_request(struct blk_mq_hw_ctx *hctx,
+				 struct request *rq, bool at_head)
+{
+	struct request_queue *q = hctx->queue;
+	struct flash_data *fd = q->elevator->elevator_data;
+	enum flash_class class = flash_rq_class(rq);
+
+	/* A requeued async write is no longer in flight */
+	if (flash_rq_async_inflight(rq)) {
+		rq->elv.priv[0] = NULL;
+		atomic_dec(&fd->async_inflight);
+	}
+
+	if (blk_mq_sched_try_insert_merge(q, rq))
+		return;
+
+	blk_mq_sched_request_inserted(rq);
+
+	if (at_head || blk_rq_is_passthrough(rq)) {
+		if (at_head)
+			list_add(&rq->queuelist, &fd->dispatch);
+		else
+			list_add_tail(&rq->queuelist, &fd->dispatch);
+		return;
+	}
+
+	if (rq_mergeable(rq)) {
+		elv_rqhash_add(q, rq);
+		if (!q->last_merge)
+			q->last_merge = rq;
+	}
+
+	rq->fifo_time = jiffies + fd->fifo_expire[rq_data_dir(rq)];
+	list_add_tail(&rq->queuelist, &fd->fifo_list[class]);
+}
+
+static void flash_insert_requests(struct blk_mq_hw_ctx *hctx,
+				  struct list_head *list, bool at_head)
+{
+	struct request_queue *q = hctx->queue;
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	spin_lock(&fd->lock);
+	while (!list_empty(list)) {
+		struct request *rq;
+
+		rq = list_first_entry(list, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		flash_insert_request(hctx, rq, at_head);
+	}
+	spin_unlock(&fd->lock);
+}
+
+/*
+ * Defined so that .finish_request is called upon request completion, which
+ * releases the async write depth slot.
+ */
+static void flash_prepare_request(struct request *rq, struct bio *bio)
+{
+	rq->elv.priv[0] = NULL;
+}
+
+static void flash_finish_request(struct request *rq)
+{
+	struct flash_data *fd = rq->q->elevator->elevator_data;
+
+	if (flash_rq_async_inflight(rq)) {
+		rq->elv.priv[0] = NULL;
+		atomic_dec(&fd->async_inflight);
+	}
+}
+
+static void flash_completed_request(struct request *rq, u64 now)
+{
+	struct flash_data *fd = rq->q->elevator->elevator_data;
+	u64 lat, ewma;
+
+	if (op_is_write(req_op(rq)) || !rq->io_start_time_ns ||
+	    now <= rq->io_start_time_ns)
+		return;
+
+	lat = now - rq->io_start_time_ns;
+	ewma = READ_ONCE(fd->read_lat_ns);
+	WRITE_ONCE(fd->read_lat_ns, ewma ? (ewma * 7 + lat) >> 3 : lat);
+}
+
+static bool flash_has_work(struct blk_mq_hw_ctx *hctx)
+{
+	struct flash_data *fd = hctx->queue->elevator->elevator_data;
+	int i;
+
+	if (!list_empty_careful(&fd->dispatch))
+		return true;
+
+	for (i = 0; i < FLASH_NR_CLASSES; i++)
+		if (!list_empty_careful(&fd->fifo_list[i]))
+			return true;
+
+	return false;
+}
+
+/*
+ * sysfs parts below
+ */
+static ssize_t
+flash_var_show(int var, char *page)
+{
+	return sprintf(page, "%d\n", var);
+}
+
+static void
+flash_var_store(int *var, const char *page)
+{
+	char *p = (char *) page;
+
+	*var = simple_strtol(p, &p, 10);
+}
+
+#define SHOW_FUNCTION(__FUNC, __VAR, __CONV)				\
+static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
+{									\
+	struct flash_data *fd = e->elevator_data;			\
+	int __data = __VAR;						\
+	if (__CONV)							\
+		__data = jiffies_to_msecs(__data);			\
+	return flash_var_show(__data, (page));				\
+}
+SHOW_FUNCTION(flash_read_expire_show, fd->fifo_expire[READ], 1);
+SHOW_FUNCTION(flash_write_expire_show, fd->fifo_expire[WRITE], 1);
+SHOW_FUNCTION(flash_writes_starved_show, fd->writes_starved, 0);
+SHOW_FUNCTION(flash_read_lat_target_us_show, fd->read_lat_target_us, 0);
+SHOW_FUNCTION(flash_async_depth_max_show, fd->async_depth_max, 0);
+#undef SHOW_FUNCTION
+
+#define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
+static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)	\
+{									\
+	struct flash_data *fd = e->elevator_data;			\
+	int __data;							\
+	flash_var_store(&__data, (page));				\
+	if (__data < (MIN))						\
+		__data = (MIN);						\
+	else if (__data > (MAX))					\
+		__data = (MAX);						\
+	if (__CONV)							\
+		*(__PTR) = msecs_to_jiffies(__data);			\
+	else								\
+		*(__PTR) = __data;					\
+	return count;							\
+}
+STORE_FUNCTION(flash_read_expire_store, &fd->fifo_expire[READ], 0, INT_MAX, 1);
+STORE_FUNCTION(flash_write_expire_store, &fd->fifo_expire[WRITE], 0, INT_MAX, 1);
+STORE_FUNCTION(flash_writes_starved_store, &fd->writes_starved, 0, INT_MAX, 0);
+STORE_FUNCTION(flash_read_lat_target_us_store, &fd->read_lat_target_us, 1, INT_MAX, 0);
+STORE_FUNCTION(flash_async_depth_max_store, &fd->async_depth_max, 1, INT_MAX, 0);
+#undef STORE_FUNCTION
+
+#define FLASH_ATTR(name) \
+	__ATTR(name, 0644, flash_##name##_show, flash_##name##_store)
+
+static struct elv_fs_entry flash_attrs[] = {
+	FLASH_ATTR(read_expire),
+	FLASH_ATTR(write_expire),
+	FLASH_ATTR(writes_starved),
+	FLASH_ATTR(read_lat_target_us),
+	FLASH_ATTR(async_depth_max),
+	__ATTR_NULL
+};
+
+#ifdef CONFIG_BLK_DEBUG_FS
+static int flash_async_depth_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	seq_printf(m, "%u inflight %d\n", fd->async_depth,
+		   atomic_read(&fd->async_inflight));
+	return 0;
+}
+
+static int flash_read_lat_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	seq_printf(m, "%llu\n", div_u64(READ_ONCE(fd->read_lat_ns),
+					NSEC_PER_USEC));
+	return 0;
+}
+
+static int flash_stats_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+	struct flash_data *fd = q->elevator->elevator_data;
+
+	spin_lock(&fd->lock);
+	seq_printf(m, "reads %llu sync_writes %llu async_writes %llu\n",
+		   fd->dispatched[FLASH_READ],
+		   fd->dispatched[FLASH_SYNC_WRITE],
+		   fd->dispatched[FLASH_ASYNC_WRITE]);
+	seq_printf(m, "throttled %llu expired %llu\n", fd->throttled,
+		   fd->expired);
+	seq_printf(m, "wbuf %s fill %u%%\n",
+		   READ_ONCE(q->wbuf_enabled) ? "on" : "off",
+		   READ_ONCE(q->wbuf_fill_pct));
+	spin_unlock(&fd->lock);
+	return 0;
+}
+
+static const struct blk_mq_debugfs_attr flash_queue_debugfs_attrs[] = {
+	{"async_depth", 0400, flash_async_depth_show},
+	{"read_lat_us", 0400, flash_read_lat_show},
+	{"stats", 0400, flash_stats_show},
+	{},
+};
+#endif
+
+static struct elevator_type flash_iosched = {
+	.ops = {
+		.insert_requests	= flash_insert_requests,
+		.dispatch_request	= flash_dispatch_request,
+		.prepare_request	= flash_prepare_request,
+		.finish_request		= flash_finish_request,
+		.completed_request	= flash_completed_request,
+		.bio_merge		= flash_bio_merge,
+		.requests_merged	= flash_merged_requests,
+		.has_work		= flash_has_work,
+		.init_sched		= flash_init_queue,
+		.exit_sched		= flash_exit_queue,
+	},
+
+#ifdef CONFIG_BLK_DEBUG_FS
+	.queue_debugfs_attrs = flash_queue_debugfs_attrs,
+#endif
+	.elevator_attrs = flash_attrs,
+	.elevator_name = "flash",
+	.elevator_owner = THIS_MODULE,
+};
+MODULE_ALIAS("flash-iosched");
+
+static int __init flash_init(void)
+{
+	return elv_register(&flash_iosched);
+}
+
+static void __exit flash_exit(void)
+{
+	elv_unregister(&flash_iosched);
+}
+
+module_init(flash_init);
+module_exit(flash_exit);
+
+MODULE_LICENSE("GPL v2");
+MODULE_DESCRIPTION("Flash I/O scheduler");
@@ -24,6 +24,12 @@
  *
  * Upper layers will call keyslot_manager_get_slot_for_key() to program a
  * key into some slot in the inline encryption hardware.
+ *
+ * Programming a key can be slow (e.g. a call into the secure world), so keys
+ * stay programmed after their last user is gone and idle slots are reused in
+ * LRU order.  Upper layers that know a key is about to become hot, e.g. when
+ * a user's keys are added at unlock, can call keyslot_manager_preload_key() so
+ * that the first I/O with that key doesn't wait for it to be programmed.
  */
 #include <crypto/algapi.h>
 #include <linux/keyslot-manager.h>
@@ -32,12 +38,28 @@
 #include <linux/pm_runtime.h>
 #include <linux/wait.h>
 #include <linux/blkdev.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 struct keyslot {
 	atomic_t slot_refs;
 	struct list_head idle_slot_node;
 	struct hlist_node hash_node;
 	struct blk_crypto_key key;
+	/* Lookups that found the key in this slot since it was programmed */
+	atomic64_t hits;
+};
+
+/* Keyslot usage statistics, exposed in debugfs */
+struct keyslot_stats {
+	atomic64_t hits;
+	atomic64_t misses;
+	atomic64_t waits;
+	/* Protected by the keyslot manager's lock */
+	u64 evictions;
+	u64 preloads;
+	u64 program_ns;
+	u64 program_max_ns;
 };
 
 struct keyslot_manager {
@@ -70,6 +92,9 @@ struct keyslot_manager {
 	struct hlist_head *slot_hashtable;
 	unsigned int slot_hashtable_size;
 
+	struct keyslot_stats stats;
+	struct dentry *debugfs;
+
 	/* Per-keyslot data */
 	struct keyslot slots[];
 };
@@ -79,6 +104,69 @@ static inline bool keyslot_manager_is_passthrough(struct keyslot_manager *ksm)
 	return ksm->num_slots == 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static struct dentry *keyslot_manager_debugfs_root;
+
+static int keyslot_manager_stats_show(struct seq_file *s, void *unused)
+{
+	struct keyslot_manager *ksm = s->private;
+	struct keyslot_stats *stats = &ksm->stats;
+	unsigned int slot;
+
+	down_read(&ksm->lock);
+	seq_printf(s, "hits: %lld\nmisses: %lld\nwaits: %lld\n",
+		   atomic64_read(&stats->hits), atomic64_read(&stats->misses),
+		   atomic64_read(&stats->waits));
+	seq_printf(s, "evictions: %llu\npreloads: %llu\n",
+		   stats->evictions, stats->preloads);
+	seq_printf(s, "program_us: %llu\nprogram_max_us: %llu\n",
+		   div_u64(stats->program_ns, NSEC_PER_USEC),
+		   div_u64(stats->program_max_ns, NSEC_PER_USEC));
+
+	seq_puts(s, "slot refs hits mode data_unit_size wrapped key_hash\n");
+	for (slot = 0; slot < ksm->num_slots; slot++) {
+		const struct keyslot *slotp = &ksm->slots[slot];
+
+		if (slotp->key.crypto_mode == BLK_ENCRYPTION_MODE_INVALID)
+			continue;
+		seq_printf(s, "%u %d %lld %d %u %d %08x\n", slot,
+			   atomic_read(&slotp->slot_refs),
+			   atomic64_read(&slotp->hits), slotp->key.crypto_mode,
+			   slotp->key.data_unit_size, slotp->key.is_hw_wrapped,
+			   blk_crypto_key_hash(&slotp->key));
+	}
+	up_read(&ksm->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(keyslot_manager_stats);
+
+static void keyslot_manager_debugfs_init(struct keyslot_manager *ksm,
+					 struct device *dev)
+{
+	if (!dev)
+		return;
+
+	ksm->debugfs = debugfs_create_dir(dev_name(dev),
+					  keyslot_manager_debugfs_root);
+	debugfs_create_file("stats", 0400, ksm->debugfs, ksm,
+			    &keyslot_manager_stats_fops);
+}
+
+static int __init keyslot_manager_debugfs_setup(void)
+{
+	keyslot_manager_debugfs_root = debugfs_create_dir("keyslot_manager",
+							  NULL);
+	return 0;
+}
+subsys_initcall(keyslot_manager_debugfs_setup);
+#else /* CONFIG_DEBUG_FS */
+static inline void keyslot_manager_debugfs_init(struct keyslot_manager *ksm,
+						struct device *dev)
+{
+}
+#endif /* !CONFIG_DEBUG_FS */
+
 #ifdef CONFIG_PM
 static inline void keyslot_manager_set_dev(struct keyslot_manager *ksm,
 					   struct device *dev)
@@ -208,6 +296,8 @@ struct keyslot_manager *keyslot_manager_create(
 	for (i = 0; i < ksm->slot_hashtable_size; i++)
 		INIT_HLIST_HEAD(&ksm->slot_hashtable[i]);
 
+	keyslot_manager_debugfs_init(ksm, dev);
+
 	return ksm;
 
 err_free_ksm:
@@ -265,6 +355,8 @@ static int find_and_grab_keyslot(struct keyslot_manager *ksm,
 	slot = find_keyslot(ksm, key);
 	if (slot < 0)
 		return slot;
+	atomic64_inc(&ksm->slots[slot].hits);
+	atomic64_inc(&ksm->stats.hits);
 	if (atomic_inc_return(&ksm->slots[slot].slot_refs) == 1) {
 		/* Took first reference to this slot; remove it from LRU list */
 		remove_slot_from_lru_list(ksm, slot);
@@ -272,6 +364,37 @@ static int find_and_grab_keyslot(struct keyslot_manager *ksm,
 	return slot;
 }
 
+/* Program @key into the idle @slot and point the slot at it. */
+static int keyslot_manager_program_slot(struct keyslot_manager *ksm,
+					const struct blk_crypto_key *key,
+					struct keyslot *idle_slot)
+{
+	struct keyslot_stats *stats = &ksm->stats;
+	int slot = idle_slot - ksm->slots;
+	ktime_t start = ktime_get();
+	u64 delta;
+	int err;
+
+	err = ksm->ksm_ll_ops.keyslot_program(ksm, key, slot);
+	if (err)
+		return err;
+
+	delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+	stats->program_ns += delta;
+	stats->program_max_ns = max(stats->program_max_ns, delta);
+
+	/* Move this slot to the hash list for the new key. */
+	if (idle_slot->key.crypto_mode != BLK_ENCRYPTION_MODE_INVALID) {
+		hlist_del(&idle_slot->hash_node);
+		stats->evictions++;
+	}
+	hlist_add_head(&idle_slot->hash_node, hash_bucket_for_key(ksm, key));
+
+	idle_slot->key = *key;
+	atomic64_set(&idle_slot->hits, 0);
+	return 0;
+}
+
 /**
  * keyslot_manager_get_slot_for_key() - Program a key into a keyslot.
  * @ksm: The keyslot manager to program the key into.
@@ -301,6 +424,7 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 	if (slot != -ENOKEY)
 		return slot;
 
+	atomic64_inc(&ksm->stats.misses);
 	for (;;) {
 		keyslot_manager_hw_enter(ksm);
 		slot = find_and_grab_keyslot(ksm, key);
@@ -317,6 +441,7 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 			break;
 
 		keyslot_manager_hw_exit(ksm);
+		atomic64_inc(&ksm->stats.waits);
 		wait_event(ksm->idle_slots_wait_queue,
 			   !list_empty(&ksm->idle_slots));
 	}
@@ -325,20 +450,14 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 					     idle_slot_node);
 	slot = idle_slot - ksm->slots;
 
-	err = ksm->ksm_ll_ops.keyslot_program(ksm, key, slot);
+	err = keyslot_manager_program_slot(ksm, key, idle_slot);
 	if (err) {
 		wake_up(&ksm->idle_slots_wait_queue);
 		keyslot_manager_hw_exit(ksm);
 		return err;
 	}
 
-	/* Move this slot to the hash list for the new key. */
-	if (idle_slot->key.crypto_mode != BLK_ENCRYPTION_MODE_INVALID)
-		hlist_del(&idle_slot->hash_node);
-	hlist_add_head(&idle_slot->hash_node, hash_bucket_for_key(ksm, key));
-
 	atomic_set(&idle_slot->slot_refs, 1);
-	idle_slot->key = *key;
 
 	remove_slot_from_lru_list(ksm, slot);
 
@@ -346,6 +465,61 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 	return slot;
 }
 
+/**
+ * keyslot_manager_preload_key() - Program a key ahead of its first use.
+ * @ksm: The keyslot manager to program the key into.
+ * @key: The key to program.
+ *
+ * Make sure @key sits in a keyslot without taking a reference to it, so that
+ * the first I/O with the key finds it already programmed.  The key's slot is
+ * moved to the most recently used end of the LRU list.  If the key isn't
+ * programmed yet, the least recently used idle slot is taken for it.  This
+ * never waits for a slot to become idle.
+ *
+ * Context: Process context. Takes and releases ksm->lock.
+ * Return: 0 on success, -EBUSY if every keyslot is in use, or another -errno
+ *	   value on other error.
+ */
+int keyslot_manager_preload_key(struct keyslot_manager *ksm,
+				const struct blk_crypto_key *key)
+{
+	struct keyslot *slotp;
+	unsigned long flags;
+	int slot;
+	int err = 0;
+
+	if (keyslot_manager_is_passthrough(ksm))
+		return 0;
+
+	keyslot_manager_hw_enter(ksm);
+
+	slot = find_keyslot(ksm, key);
+	if (slot >= 0) {
+		slotp = &ksm->slots[slot];
+	} else {
+		if (list_empty(&ksm->idle_slots)) {
+			err = -EBUSY;
+			goto out_unlock;
+		}
+		slotp = list_first_entry(&ksm->idle_slots, struct keyslot,
+					 idle_slot_node);
+		err = keyslot_manager_program_slot(ksm, key, slotp);
+		if (err)
+			goto out_unlock;
+		ksm->stats.preloads++;
+	}
+
+	spin_lock_irqsave(&ksm->idle_slots_lock, flags);
+	if (atomic_read(&slotp->slot_refs) == 0)
+		list_move_tail(&slotp->idle_slot_node, &ksm->idle_slots);
+	spin_unlock_irqrestore(&ksm->idle_slots_lock, flags);
+
+out_unlock:
+	keyslot_manager_hw_exit(ksm);
+	return err;
+}
+EXPORT_SYMBOL_GPL(keyslot_manager_preload_key);
+
 /**
  * keyslot_manager_get_slot() - Increment the refcount on the specified slot.
  * @ksm: The keyslot manager that we want to modify.
@@ -484,6 +658,7 @@ int keyslot_manager_evict_key(struct keyslot_manager *ksm,
 
 	hlist_del(&slotp->hash_node);
 	memzero_explicit(&slotp->key, sizeof(slotp->key));
+	atomic64_set(&slotp->hits, 0);
 	err = 0;
 out_unlock:
 	keyslot_manager_hw_exit(ksm);
@@ -537,6 +712,7 @@ EXPORT_SYMBOL_GPL(keyslot_manager_private);
 void keyslot_manager_destroy(struct keyslot_manager *ksm)
 {
 	if (ksm) {
+		debugfs_remove_recursive(ksm->debugfs);
 		kvfree(ksm->slot_hashtable);
 		memzero_explicit(ksm, struct_size(ksm, slots, ksm->num_slots));
 		kvfree(ksm);
@@ -257,9 +257,19 @@ static void
 _binder_inner_proc_lock(struct binder_proc *proc, int line)
 	__acquires(&proc->inner_lock)
 {
+	struct binder_proc_ext *eproc;
+	ktime_t start;
+
 	binder_debug(BINDER_DEBUG_SPINLOCKS,
 		     "%s: line=%d\n", __func__, line);
+	if (spin_trylock(&proc->inner_lock))
+		return;
+
+	start = ktime_get();
 	spin_lock(&proc->inner_lock);
+	eproc = container_of(proc, struct binder_proc_ext, proc);
+	eproc->inner_lock_contended++;
+	eproc->inner_lock_wait_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
 }
 
 /**
@@ -925,10 +935,12 @@ static struct binder_node *binder_new_node(struct binder_proc *proc,
 					   struct flat_binder_object *fp)
 {
 	struct binder_node *node;
-	struct binder_node *new_node = kzalloc(sizeof(*node), GFP_KERNEL);
+	struct binder_node_ext *enode = kzalloc(sizeof(*enode), GFP_KERNEL);
+	struct binder_node *new_node;
 
-	if (!new_node)
+	if (!enode)
 		return NULL;
+	new_node = &enode->node;
 	binder_inner_proc_lock(proc);
 	node = binder_init_node_ilocked(proc, new_node, fp);
 	binder_inner_proc_unlock(proc);
@@ -2909,6 +2921,7 @@ static void binder_transaction(struct binder_proc *proc,
 {
 	int ret;
 	struct binder_transaction *t;
+	struct binder_transaction_ext *t_ext;
 	struct binder_work *w;
 	struct binder_work *tcomplete;
 	binder_size_t buffer_offset = 0;
@@ -3127,13 +3140,15 @@ static void binder_transaction(struct binder_proc *proc,
 	e->to_proc = target_proc->pid;
 
 	/* TODO: reuse incoming transaction for reply */
-	t = kzalloc(sizeof(*t), GFP_KERNEL);
-	if (t == NULL) {
+	t_ext = kzalloc(sizeof(*t_ext), GFP_KERNEL);
+	if (t_ext == NULL) {
 		return_error = BR_FAILED_REPLY;
 		return_error_param = -ENOMEM;
 		return_error_line = __LINE__;
 		goto err_alloc_t_failed;
 	}
+	t_ext->start = ktime_get();
+	t = &t_ext->t;
 	INIT_LIST_HEAD(&t->fd_fixups);
 	binder_stats_created(BINDER_STAT_TRANSACTION);
 	spin_lock_init(&t->lock);
@@ -4331,6 +4346,35 @@ static int binder_apply_fd_fixups(struct binder_proc *proc,
 	return ret;
 }
 
+/*
+ * Account the time @t spent between binder_transaction() and being picked
+ * up by a thread of @proc, against the target node or, for replies, against
+ * @proc itself.
+ */
+static void binder_account_latency_ilocked(struct binder_proc *proc,
+					   struct binder_transaction *t)
+{
+	struct binder_transaction_ext *t_ext =
+		container_of(t, struct binder_transaction_ext, t);
+	struct binder_node *node = t->buffer ? t->buffer->target_node : NULL;
+	struct binder_lat_hist *lat;
+	u64 us;
+	int bucket;
+
+	if (node)
+		lat = &container_of(node, struct binder_node_ext, node)->lat;
+	else
+		lat = &container_of(proc, struct binder_proc_ext,
+				    proc)->reply_lat;
+
+	us = ktime_us_delta(ktime_get(), t_ext->start);
+	bucket = min_t(int, fls64(us), BINDER_LAT_BUCKETS - 1);
+	lat->bucket[bucket]++;
+	lat->count++;
+	lat->total_us += us;
+	lat->max_us = max(lat->max_us, us);
+}
+
 static int binder_thread_read(struct binder_proc *proc,
 			      struct binder_thread *thread,
 			      binder_uintptr_t binder_buffer, size_t size,
@@ -4418,8 +4462,9 @@ static int binder_thread_read(struct binder_proc *proc,
 
 		switch (w->type) {
 		case BINDER_WORK_TRANSACTION: {
-			binder_inner_proc_unlock(proc);
 			t = container_of(w, struct binder_transaction, work);
+			binder_account_latency_ilocked(proc, t);
+			binder_inner_proc_unlock(proc);
 		} break;
 		case BINDER_WORK_RETURN_ERROR: {
 			struct binder_error *e = container_of(
@@ -6349,6 +6394,56 @@ int binder_stats_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static void print_binder_lat_hist(struct seq_file *m, const char *prefix,
+				  struct binder_lat_hist *lat)
+{
+	int i;
+
+	seq_printf(m, "%s count %llu avg_us %llu max_us %llu hist",
+		   prefix, lat->count,
+		   lat->count ? div64_u64(lat->total_us, lat->count) : 0,
+		   lat->max_us);
+	for (i = 0; i < BINDER_LAT_BUCKETS; i++)
+		seq_printf(m, " %u", lat->bucket[i]);
+	seq_puts(m, "\n");
+}
+
+int binder_latency_show(struct seq_file *m, void *unused)
+{
+	struct binder_proc *proc;
+	struct binder_proc_ext *eproc;
+	struct binder_node_ext *enode;
+	struct rb_node *n;
+	char prefix[32];
+
+	seq_puts(m, "binder latency:\n");
+	mutex_lock(&binder_procs_lock);
+	hlist_for_each_entry(proc, &binder_procs, proc_node) {
+		eproc = container_of(proc, struct binder_proc_ext, proc);
+
+		binder_inner_proc_lock(proc);
+		seq_printf(m, "proc %d: inner_lock contended %llu wait_us %llu\n",
+			   proc->pid, eproc->inner_lock_contended,
+			   div_u64(eproc->inner_lock_wait_ns, NSEC_PER_USEC));
+		if (eproc->reply_lat.count)
+			print_binder_lat_hist(m, "  reply:", &eproc->reply_lat);
+		for (n = rb_first(&proc->nodes); n != NULL; n = rb_next(n)) {
+			enode = container_of(rb_entry(n, struct binder_node,
+						      rb_node),
+					     struct binder_node_ext, node);
+			if (!enode->lat.count)
+				continue;
+			snprintf(prefix, sizeof(prefix), "  node %d:",
+				 enode->node.debug_id);
+			print_binder_lat_hist(m, prefix, &enode->lat);
+		}
+		binder_inner_proc_unlock(proc);
+	}
+	mutex_unlock(&binder_procs_lock);
+
+	return 0;
+}
+
 int binder_transactions_show(struct seq_file *m, void *unused)
 {
 	struct binder_proc *proc;
@@ -6512,6 +6607,11 @@ static int __init binder_init(void)
 				    binder_debugfs_dir_entry_root,
 				    &binder_transaction_log_failed,
 				    &binder_transaction_log_fops);
+		debugfs_create_file("latency",
+				    0444,
+				    binder_debugfs_dir_entry_root,
+				    NULL,
+				    &binder_latency_fops);
 	}
 
 	if (!IS_ENABLED(CONFIG_ANDROID_BINDERFS) &&
@@ -41,6 +41,15 @@ static uint32_t binder_alloc_debug_mask = BINDER_DEBUG_USER_ERROR;
 module_param_named(debug_mask, binder_alloc_debug_mask,
 		   uint, 0644);
 
+/*
+ * Number of KB at the start of each binder mapping to back with pages at
+ * mmap time, so the first transactions don't take mmap_sem and allocate in
+ * the transaction path. The pages start out on binder_alloc_lru and can be
+ * reclaimed by the shrinker like any other unused binder page.
+ */
+static uint32_t binder_alloc_prefault_kb;
+module_param_named(prefault_kb, binder_alloc_prefault_kb, uint, 0644);
+
 #define binder_alloc_debug(mask, x...) \
 	do { \
 		if (binder_alloc_debug_mask & mask) \
@@ -236,6 +245,7 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 
 			on_lru = list_lru_del(&binder_alloc_lru, &page->lru);
 			WARN_ON(!on_lru);
+			alloc->pages_reused++;
 
 			trace_binder_alloc_lru_end(alloc, index);
 			continue;
@@ -266,6 +276,7 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 
 		if (index + 1 > alloc->pages_high)
 			alloc->pages_high = index + 1;
+		alloc->pages_faulted++;
 
 		trace_binder_alloc_page_end(alloc, index);
 		/* vm_insert_page does not seem to increment the refcount */
@@ -738,6 +749,45 @@ void binder_alloc_free_buf(struct binder_alloc *alloc,
  *      -EBUSY = address space already mapped
  *      -ENOMEM = failed to map memory to given address space
  */
+/*
+ * Populate the first binder_alloc_prefault_kb of the mapping. Called from
+ * the mmap handler with mmap_sem held for writing, after the vma has been
+ * published, and before userspace can see the mapping. A failure here is
+ * not fatal, the remaining pages are faulted in on demand as usual.
+ */
+static void binder_alloc_prefault(struct binder_alloc *alloc,
+				  struct vm_area_struct *vma)
+{
+	struct binder_lru_page *page;
+	size_t index, nr_pages;
+
+	nr_pages = min_t(size_t, (size_t)binder_alloc_prefault_kb * SZ_1K,
+			 alloc->buffer_size) / PAGE_SIZE;
+
+	for (index = 0; index < nr_pages; index++) {
+		page = &alloc->pages[index];
+		page->page_ptr = alloc_page(GFP_KERNEL |
+					    __GFP_HIGHMEM |
+					    __GFP_ZERO |
+					    __GFP_NOWARN);
+		if (!page->page_ptr)
+			break;
+		page->alloc = alloc;
+		INIT_LIST_HEAD(&page->lru);
+
+		if (vm_insert_page(vma, (uintptr_t)alloc->buffer +
+				   index * PAGE_SIZE, page->page_ptr)) {
+			__free_page(page->page_ptr);
+			page->page_ptr = NULL;
+			break;
+		}
+
+		list_lru_add(&binder_alloc_lru, &page->lru);
+		alloc->pages_high = index + 1;
+		alloc->pages_prefaulted++;
+	}
+}
+
 int binder_alloc_mmap_handler(struct binder_alloc *alloc,
 			      struct vm_area_struct *vma)
 {
@@ -781,6 +831,9 @@ int binder_alloc_mmap_handler(struct binder_alloc *alloc,
 	binder_alloc_set_vma(alloc, vma);
 	mmgrab(alloc->vma_vm_mm);
 
+	if (binder_alloc_prefault_kb)
+		binder_alloc_prefault(alloc, vma);
+
 	return 0;
 
 err_alloc_buf_struct_failed:
@@ -929,6 +982,9 @@ void binder_alloc_print_pages(struct seq_file *m,
 	mutex_unlock(&alloc->mutex);
 	seq_printf(m, "  pages: %d:%d:%d\n", active, lru, free);
 	seq_printf(m, "  pages high watermark: %zu\n", alloc->pages_high);
+	seq_printf(m, "  pages faulted:%zu reused:%zu prefaulted:%zu reclaimed:%zu\n",
+		   alloc->pages_faulted, alloc->pages_reused,
+		   alloc->pages_prefaulted, alloc->pages_reclaimed);
 }
 
 /**
@@ -1021,6 +1077,7 @@ enum lru_status binder_alloc_free_page(struct list_head *item,
 
 	__free_page(page->page_ptr);
 	page->page_ptr = NULL;
+	alloc->pages_reclaimed++;
 
 	trace_binder_unmap_kernel_end(alloc, index);
 
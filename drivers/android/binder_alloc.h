@@ -87,6 +87,10 @@ struct binder_lru_page {
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
  * @pages_high:         high watermark of offset in @pages
+ * @pages_faulted:      pages allocated and mapped in the transaction path
+ * @pages_reused:       pages taken back from binder_alloc_lru instead
+ * @pages_prefaulted:   pages populated at mmap time
+ * @pages_reclaimed:    pages released by the shrinker
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -107,6 +111,10 @@ struct binder_alloc {
 	uint32_t buffer_free;
 	int pid;
 	size_t pages_high;
+	size_t pages_faulted;
+	size_t pages_reused;
+	size_t pages_prefaulted;
+	size_t pages_reclaimed;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
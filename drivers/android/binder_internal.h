@@ -5,6 +5,7 @@
 
 #include <linux/export.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/miscdevice.h>
 #include <linux/mutex.h>
@@ -119,6 +120,29 @@ DEFINE_SHOW_ATTRIBUTE(binder_transactions);
 int binder_transaction_log_show(struct seq_file *m, void *unused);
 DEFINE_SHOW_ATTRIBUTE(binder_transaction_log);
 
+int binder_latency_show(struct seq_file *m, void *unused);
+DEFINE_SHOW_ATTRIBUTE(binder_latency);
+
+/*
+ * Transaction latency buckets: bucket 0 counts pickups under 1us, bucket n
+ * counts [2^(n-1), 2^n) us, and the last bucket everything from ~262ms up.
+ */
+#define BINDER_LAT_BUCKETS	20
+
+/**
+ * struct binder_lat_hist - latency from binder_transaction() to pickup
+ * @bucket:   log2(us) histogram
+ * @count:    number of transactions accounted
+ * @total_us: sum of all latencies
+ * @max_us:   largest latency seen
+ */
+struct binder_lat_hist {
+	u32 bucket[BINDER_LAT_BUCKETS];
+	u64 count;
+	u64 total_us;
+	u64 max_us;
+};
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int debug_id_done;
@@ -290,6 +314,21 @@ struct binder_node {
 	struct list_head async_todo;
 };
 
+/**
+ * struct binder_node_ext - binder node bookkeeping
+ * @node:            the binder_node
+ * @lat:             latency of transactions to this node, from send to
+ *                   pickup by a thread of @node->proc
+ *                   (protected by @node->proc->inner_lock)
+ *
+ * Extended binder_node -- needed to add the latency stats without
+ * changing the KMI for binder_node.
+ */
+struct binder_node_ext {
+	struct binder_node node;
+	struct binder_lat_hist lat;
+};
+
 struct binder_ref_death {
 	/**
 	 * @work: worklist element for death notifications
@@ -481,6 +520,13 @@ struct binder_proc {
  * @cred                  struct cred associated with the `struct file`
  *                        in binder_open()
  *                        (invariant after initialized)
+ * @reply_lat:            latency of replies to this process, from send to
+ *                        pickup by the waiting thread
+ *                        (protected by @proc.inner_lock)
+ * @inner_lock_contended: number of times @proc.inner_lock was found held
+ *                        (protected by @proc.inner_lock)
+ * @inner_lock_wait_ns:   total time spent waiting for @proc.inner_lock
+ *                        (protected by @proc.inner_lock)
  *
  * Extended binder_proc -- needed to add the "cred" field without
  * changing the KMI for binder_proc.
@@ -488,6 +534,9 @@ struct binder_proc {
 struct binder_proc_ext {
 	struct binder_proc proc;
 	const struct cred *cred;
+	struct binder_lat_hist reply_lat;
+	u64 inner_lock_contended;
+	u64 inner_lock_wait_ns;
 };
 
 static inline const struct cred *binder_get_cred(struct binder_proc *proc)
@@ -611,6 +660,19 @@ struct binder_transaction {
 	ANDROID_VENDOR_DATA(1);
 };
 
+/**
+ * struct binder_transaction_ext - binder transaction bookkeeping
+ * @t:               the binder_transaction
+ * @start:           time binder_transaction() created @t
+ *
+ * Extended binder_transaction -- needed to add the timestamp without
+ * changing the KMI for binder_transaction.
+ */
+struct binder_transaction_ext {
+	struct binder_transaction t;
+	ktime_t start;
+};
+
 /**
  * struct binder_object - union of flat binder object types
  * @hdr:   generic object header
@@ -208,6 +208,17 @@ static int mhi_runtime_suspend(struct device *dev)
 		return 0;
 	}
 
+	/*
+	 * next burst is due before an M3 exit would pay off, stay in M0/M2.
+	 * updating last_busy makes runtime pm reschedule the autosuspend.
+	 */
+	if (mhi_pm_burst_expected(mhi_cntrl)) {
+		MHI_LOG("Burst expected, defer suspend\n");
+		pm_runtime_mark_last_busy(dev);
+		ret = -EBUSY;
+		goto exit_runtime_suspend;
+	}
+
 	/* if drv is supported we will always go into drv */
 	if (mhi_dev->drv_supported) {
 		ret = mhi_pm_fast_suspend(mhi_cntrl, true);
@@ -630,6 +641,34 @@ static ssize_t timeout_ms_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(timeout_ms);
 
+static ssize_t m3_break_even_ms_show(struct device *dev,
+				     struct device_attribute *attr,
+				     char *buf)
+{
+	struct mhi_device *mhi_dev = to_mhi_device(dev);
+	struct mhi_controller *mhi_cntrl = mhi_dev->mhi_cntrl;
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", mhi_cntrl->m3_break_even_ms);
+}
+
+static ssize_t m3_break_even_ms_store(struct device *dev,
+				      struct device_attribute *attr,
+				      const char *buf,
+				      size_t count)
+{
+	struct mhi_device *mhi_dev = to_mhi_device(dev);
+	struct mhi_controller *mhi_cntrl = mhi_dev->mhi_cntrl;
+	u32 break_even_ms;
+
+	if (kstrtou32(buf, 0, &break_even_ms) < 0)
+		return -EINVAL;
+
+	mhi_cntrl->m3_break_even_ms = break_even_ms;
+
+	return count;
+}
+static DEVICE_ATTR_RW(m3_break_even_ms);
+
 static ssize_t power_up_store(struct device *dev,
 			      struct device_attribute *attr,
 			      const char *buf,
@@ -683,6 +722,7 @@ static DEVICE_ATTR_RO(oempkhash_info);
 
 static struct attribute *mhi_qcom_attrs[] = {
 	&dev_attr_timeout_ms.attr,
+	&dev_attr_m3_break_even_ms.attr,
 	&dev_attr_power_up.attr,
 	&dev_attr_serial_info.attr,
 	&dev_attr_oempkhash_info.attr,
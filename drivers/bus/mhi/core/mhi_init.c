@@ -418,6 +418,9 @@ void mhi_deinit_free_irq(struct mhi_controller *mhi_cntrl)
 		if (!mhi_event->request_irq)
 			continue;
 
+		if (mhi_event->irq_cpu >= 0)
+			irq_set_affinity_hint(mhi_cntrl->irq[mhi_event->msi],
+					      NULL);
 		free_irq(mhi_cntrl->irq[mhi_event->msi], mhi_event);
 	}
 
@@ -453,6 +456,11 @@ int mhi_init_irq_setup(struct mhi_controller *mhi_cntrl)
 					mhi_cntrl->irq[mhi_event->msi], i);
 			goto error_request;
 		}
+
+		/* hint to irqbalance, ignore failure as it is not fatal */
+		if (mhi_event->irq_cpu >= 0)
+			irq_set_affinity_hint(mhi_cntrl->irq[mhi_event->msi],
+					      cpumask_of(mhi_event->irq_cpu));
 	}
 
 	return 0;
@@ -462,6 +470,9 @@ int mhi_init_irq_setup(struct mhi_controller *mhi_cntrl)
 		if (!mhi_event->request_irq)
 			continue;
 
+		if (mhi_event->irq_cpu >= 0)
+			irq_set_affinity_hint(mhi_cntrl->irq[mhi_event->msi],
+					      NULL);
 		free_irq(mhi_cntrl->irq[mhi_event->msi], mhi_event);
 	}
 	free_irq(mhi_cntrl->irq[0], mhi_cntrl);
@@ -1050,6 +1061,35 @@ int mhi_init_mmio(struct mhi_controller *mhi_cntrl)
 	return 0;
 }
 
+static void mhi_init_bb_pool(struct mhi_controller *mhi_cntrl,
+			     struct mhi_chan *mhi_chan)
+{
+	struct mhi_ring *buf_ring = &mhi_chan->buf_ring;
+	struct mhi_buf_info *buf_info = buf_ring->base;
+	size_t len = MHI_BB_POOL_EL_SIZE;
+	int i;
+
+	if (!mhi_cntrl->bounce_buf)
+		return;
+
+	mhi_chan->bb_pool_len = len * buf_ring->elements;
+	mhi_chan->bb_pool = mhi_alloc_coherent(mhi_cntrl, mhi_chan->bb_pool_len,
+					       &mhi_chan->bb_pool_addr,
+					       GFP_KERNEL | __GFP_NOWARN);
+	if (!mhi_chan->bb_pool) {
+		/* not fatal, transfers allocate their own bounce buffer */
+		MHI_LOG("No bb pool for chan:%d, use per transfer bb\n",
+			mhi_chan->chan);
+		mhi_chan->bb_pool_len = 0;
+		return;
+	}
+
+	for (i = 0; i < buf_ring->elements; i++, buf_info++) {
+		buf_info->pool_addr = mhi_chan->bb_pool + i * len;
+		buf_info->pool_p_addr = mhi_chan->bb_pool_addr + i * len;
+	}
+}
+
 void mhi_deinit_chan_ctxt(struct mhi_controller *mhi_cntrl,
 			  struct mhi_chan *mhi_chan)
 {
@@ -1063,6 +1103,12 @@ void mhi_deinit_chan_ctxt(struct mhi_controller *mhi_cntrl,
 
 	mhi_free_coherent(mhi_cntrl, tre_ring->alloc_size,
 			  tre_ring->pre_aligned, tre_ring->dma_handle);
+	if (mhi_chan->bb_pool) {
+		mhi_free_coherent(mhi_cntrl, mhi_chan->bb_pool_len,
+				  mhi_chan->bb_pool, mhi_chan->bb_pool_addr);
+		mhi_chan->bb_pool = NULL;
+		mhi_chan->bb_pool_len = 0;
+	}
 	vfree(buf_ring->base);
 
 	buf_ring->base = tre_ring->base = NULL;
@@ -1105,6 +1151,8 @@ int mhi_init_chan_ctxt(struct mhi_controller *mhi_cntrl,
 		return -ENOMEM;
 	}
 
+	mhi_init_bb_pool(mhi_cntrl, mhi_chan);
+
 	chan_ctxt->chstate = MHI_CH_STATE_ENABLED;
 	chan_ctxt->rbase = tre_ring->iommu_base;
 	chan_ctxt->rp = chan_ctxt->wp = chan_ctxt->rbase;
@@ -1299,6 +1347,24 @@ static int of_parse_ev_cfg(struct mhi_controller *mhi_cntrl,
 		mhi_event->offload_ev = of_property_read_bool(child,
 							      "mhi,offload");
 
+		/* optional budgeted napi polling for data event rings */
+		mhi_event->napi = of_property_read_bool(child, "mhi,napi");
+		if (mhi_event->napi &&
+		    (mhi_event->data_type != MHI_ER_DATA_ELEMENT_TYPE ||
+		     mhi_event->cl_manage || mhi_event->offload_ev ||
+		     IS_MHI_ER_PRIORITY_SPECIAL(mhi_event)))
+			goto error_ev_cfg;
+
+		ret = of_property_read_u32(child, "mhi,napi-budget",
+					   &mhi_event->napi_budget);
+		if (ret || !mhi_event->napi_budget)
+			mhi_event->napi_budget = NAPI_POLL_WEIGHT;
+
+		ret = of_property_read_u32(child, "mhi,irq-cpu",
+					   (u32 *)&mhi_event->irq_cpu);
+		if (ret || mhi_event->irq_cpu >= nr_cpu_ids)
+			mhi_event->irq_cpu = -1;
+
 		/*
 		 * special purpose events are handled in a separate kthread
 		 * to allow for sleeping functions to be called.
@@ -1525,6 +1591,10 @@ static int of_parse_dt(struct mhi_controller *mhi_cntrl,
 	if (ret)
 		mhi_cntrl->timeout_ms = MHI_TIMEOUT_MS;
 
+	/* predictive M3 hold off is disabled unless a break-even is given */
+	of_property_read_u32(of_node, "mhi,m3-break-even-ms",
+			     &mhi_cntrl->m3_break_even_ms);
+
 	mhi_cntrl->bounce_buf = of_property_read_bool(of_node, "mhi,use-bb");
 	ret = of_property_read_u32(of_node, "mhi,buffer-len",
 				   (u32 *)&mhi_cntrl->buffer_len);
@@ -1563,6 +1633,58 @@ static int of_parse_dt(struct mhi_controller *mhi_cntrl,
 	return ret;
 }
 
+static void mhi_deinit_napi(struct mhi_controller *mhi_cntrl)
+{
+	struct mhi_event *mhi_event = mhi_cntrl->mhi_event;
+	int i;
+
+	if (!mhi_cntrl->napi_dev)
+		return;
+
+	for (i = 0; i < mhi_cntrl->total_ev_rings; i++, mhi_event++) {
+		if (!mhi_event->napi)
+			continue;
+
+		napi_disable(&mhi_event->napi_poll);
+		netif_napi_del(&mhi_event->napi_poll);
+	}
+
+	kfree(mhi_cntrl->napi_dev);
+	mhi_cntrl->napi_dev = NULL;
+}
+
+static int mhi_init_napi(struct mhi_controller *mhi_cntrl)
+{
+	struct mhi_event *mhi_event = mhi_cntrl->mhi_event;
+	int i;
+
+	for (i = 0; i < mhi_cntrl->total_ev_rings; i++, mhi_event++)
+		if (mhi_event->napi)
+			break;
+
+	/* no event ring opted in to napi polling */
+	if (i == mhi_cntrl->total_ev_rings)
+		return 0;
+
+	mhi_cntrl->napi_dev = kzalloc(sizeof(*mhi_cntrl->napi_dev),
+				      GFP_KERNEL);
+	if (!mhi_cntrl->napi_dev)
+		return -ENOMEM;
+
+	init_dummy_netdev(mhi_cntrl->napi_dev);
+
+	for (; i < mhi_cntrl->total_ev_rings; i++, mhi_event++) {
+		if (!mhi_event->napi)
+			continue;
+
+		netif_napi_add(mhi_cntrl->napi_dev, &mhi_event->napi_poll,
+			       mhi_ev_napi_poll, mhi_event->napi_budget);
+		napi_enable(&mhi_event->napi_poll);
+	}
+
+	return 0;
+}
+
 int of_register_mhi_controller(struct mhi_controller *mhi_cntrl)
 {
 	int ret;
@@ -1633,6 +1755,10 @@ int of_register_mhi_controller(struct mhi_controller *mhi_cntrl)
 				     (ulong)mhi_event);
 	}
 
+	ret = mhi_init_napi(mhi_cntrl);
+	if (ret)
+		goto error_alloc_dev;
+
 	mhi_chan = mhi_cntrl->mhi_chan;
 	for (i = 0; i < mhi_cntrl->max_chan; i++, mhi_chan++) {
 		mutex_init(&mhi_chan->mutex);
@@ -1730,6 +1856,7 @@ int of_register_mhi_controller(struct mhi_controller *mhi_cntrl)
 	mhi_dealloc_device(mhi_cntrl, mhi_dev);
 
 error_alloc_dev:
+	mhi_deinit_napi(mhi_cntrl);
 	kfree(mhi_cntrl->mhi_cmd);
 	destroy_workqueue(mhi_cntrl->wq);
 
@@ -1748,6 +1875,7 @@ void mhi_unregister_mhi_controller(struct mhi_controller *mhi_cntrl)
 
 	destroy_workqueue(mhi_cntrl->wq);
 
+	mhi_deinit_napi(mhi_cntrl);
 	kfree(mhi_cntrl->mhi_cmd);
 	kfree(mhi_cntrl->mhi_event);
 	vfree(mhi_cntrl->mhi_chan);
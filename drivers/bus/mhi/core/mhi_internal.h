@@ -2,6 +2,7 @@
 /* Copyright (c) 2018-2020, The Linux Foundation. All rights reserved. */
 
 #include <linux/msm_rtb.h>
+#include <linux/netdevice.h>
 
 #ifndef _MHI_INT_H
 #define _MHI_INT_H
@@ -365,6 +366,14 @@ enum mhi_cmd_type {
 
 #define MHI_RSC_MIN_CREDITS (8)
 
+/* max buffers queued with MHI_DB_DEFER before the doorbell is forced */
+#define MHI_DB_DEFER_MAX (16)
+
+/* idle gap on a channel that marks the start of a new traffic burst */
+#define MHI_BURST_GAP_MIN_NS (NSEC_PER_MSEC)
+/* weight of the newest gap in the inter-burst moving average, 1/2^n */
+#define MHI_BURST_GAP_EWMA_SHIFT (2)
+
 enum MHI_CMD {
 	MHI_CMD_RESET_CHAN,
 	MHI_CMD_START_CHAN,
@@ -527,6 +536,8 @@ enum MHI_XFER_TYPE {
 #define MHI_BW_SCALE_CHAN_DB (126)
 #define MHI_DEV_WAKE_DB (127)
 #define MHI_MAX_MTU (0xffff)
+/* per element size of the channel bounce buffer pool */
+#define MHI_BB_POOL_EL_SIZE (2048)
 
 #define MHI_TIMESYNC_DB_SETUP(er_index) ((MHI_TIMESYNC_CHAN_DB << \
 	TIMESYNC_CFG_CHAN_DB_ID_SHIFT) & TIMESYNC_CFG_CHAN_DB_ID_MASK | \
@@ -635,6 +646,8 @@ struct mhi_buf_info {
 	dma_addr_t p_addr;
 	void *v_addr;
 	void *bb_addr;
+	void *pool_addr; /* pre-mapped bounce buffer owned by this element */
+	dma_addr_t pool_p_addr;
 	void *wp;
 	size_t len;
 	void *cb_buf;
@@ -660,6 +673,10 @@ struct mhi_event {
 	spinlock_t lock;
 	struct mhi_chan *mhi_chan; /* dedicated to channel */
 	struct tasklet_struct task;
+	bool napi; /* process events from napi poll instead of tasklet */
+	u32 napi_budget;
+	int irq_cpu; /* affinity hint for the event ring msi, -1 if none */
+	struct napi_struct napi_poll;
 	int (*process_event)(struct mhi_controller *mhi_cntrl,
 			     struct mhi_event *mhi_event,
 			     u32 event_quota);
@@ -694,6 +711,12 @@ struct mhi_chan {
 	bool pre_alloc;
 	bool auto_start;
 	bool wake_capable; /* channel should wake up system */
+	u32 db_deferred; /* buffers queued since the last doorbell */
+	void *bb_pool; /* coherent bounce buffers, one per buf_ring element */
+	dma_addr_t bb_pool_addr;
+	size_t bb_pool_len;
+	u64 last_xfer_ns; /* last transfer queued on this channel */
+	u64 burst_gap_ns; /* moving average of idle gaps between bursts */
 	/* functions that generate the transfer ring elements */
 	int (*gen_tre)(struct mhi_controller *mhi_cntrl,
 		       struct mhi_chan *mhi_chan, void *buf, void *cb,
@@ -788,6 +811,8 @@ void mhi_ctrl_ev_task(unsigned long data);
 int mhi_pm_m0_transition(struct mhi_controller *mhi_cntrl);
 void mhi_pm_m1_transition(struct mhi_controller *mhi_cntrl);
 int mhi_pm_m3_transition(struct mhi_controller *mhi_cntrl);
+void mhi_pm_note_xfer(struct mhi_controller *mhi_cntrl,
+		      struct mhi_chan *mhi_chan);
 void mhi_notify(struct mhi_device *mhi_dev, enum MHI_CB cb_reason);
 int mhi_process_data_event_ring(struct mhi_controller *mhi_cntrl,
 				struct mhi_event *mhi_event, u32 event_quota);
@@ -983,6 +1008,7 @@ irqreturn_t mhi_msi_handlr(int irq_number, void *dev);
 irqreturn_t mhi_intvec_threaded_handlr(int irq_number, void *dev);
 irqreturn_t mhi_intvec_handlr(int irq_number, void *dev);
 void mhi_ev_task(unsigned long data);
+int mhi_ev_napi_poll(struct napi_struct *napi, int budget);
 
 #define MHI_ASSERT(cond, fmt, ...) do { \
 	if (cond) \
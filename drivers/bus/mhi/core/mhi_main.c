@@ -230,6 +230,20 @@ void mhi_ring_chan_db(struct mhi_controller *mhi_cntrl,
 				    db);
 }
 
+/* returns true if the doorbell for this queue request may be skipped */
+static bool mhi_chan_db_defer(struct mhi_chan *mhi_chan,
+			      enum MHI_FLAGS mflags)
+{
+	if (!(mflags & MHI_DB_DEFER) ||
+	    mhi_chan->db_deferred >= MHI_DB_DEFER_MAX) {
+		mhi_chan->db_deferred = 0;
+		return false;
+	}
+
+	mhi_chan->db_deferred++;
+	return true;
+}
+
 static enum mhi_ee mhi_translate_dev_ee(struct mhi_controller *mhi_cntrl,
 					u32 dev_ee)
 {
@@ -415,11 +429,22 @@ int mhi_map_single_no_bb(struct mhi_controller *mhi_cntrl,
 int mhi_map_single_use_bb(struct mhi_controller *mhi_cntrl,
 			  struct mhi_buf_info *buf_info)
 {
-	void *buf = mhi_alloc_coherent(mhi_cntrl, buf_info->len,
-				       &buf_info->p_addr, GFP_ATOMIC);
+	void *buf;
 
-	if (!buf)
-		return -ENOMEM;
+	/*
+	 * buf_ring elements are consumed in order, so each element can own
+	 * a slot of the channel pool without any locking. Fall back to a
+	 * per transfer allocation if there is no pool or buffer is too big.
+	 */
+	if (buf_info->pool_addr && buf_info->len <= MHI_BB_POOL_EL_SIZE) {
+		buf = buf_info->pool_addr;
+		buf_info->p_addr = buf_info->pool_p_addr;
+	} else {
+		buf = mhi_alloc_coherent(mhi_cntrl, buf_info->len,
+					 &buf_info->p_addr, GFP_ATOMIC);
+		if (!buf)
+			return -ENOMEM;
+	}
 
 	if (buf_info->dir == DMA_TO_DEVICE)
 		memcpy(buf, buf_info->v_addr, buf_info->len);
@@ -442,6 +467,9 @@ void mhi_unmap_single_use_bb(struct mhi_controller *mhi_cntrl,
 	if (buf_info->dir == DMA_FROM_DEVICE)
 		memcpy(buf_info->v_addr, buf_info->bb_addr, buf_info->len);
 
+	if (buf_info->bb_addr == buf_info->pool_addr)
+		return;
+
 	mhi_free_coherent(mhi_cntrl, buf_info->len, buf_info->bb_addr,
 			  buf_info->p_addr);
 }
@@ -507,7 +535,10 @@ int mhi_queue_skb(struct mhi_device *mhi_dev,
 	if (mhi_chan->dir == DMA_TO_DEVICE)
 		atomic_inc(&mhi_cntrl->pending_pkts);
 
-	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl))) {
+	mhi_pm_note_xfer(mhi_cntrl, mhi_chan);
+
+	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl)) &&
+	    !mhi_chan_db_defer(mhi_chan, mflags)) {
 		read_lock_bh(&mhi_chan->lock);
 		mhi_ring_chan_db(mhi_cntrl, mhi_chan);
 		read_unlock_bh(&mhi_chan->lock);
@@ -605,7 +636,10 @@ int mhi_queue_dma(struct mhi_device *mhi_dev,
 	if (mhi_chan->dir == DMA_TO_DEVICE)
 		atomic_inc(&mhi_cntrl->pending_pkts);
 
-	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl)) && ring_db) {
+	mhi_pm_note_xfer(mhi_cntrl, mhi_chan);
+
+	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl)) && ring_db &&
+	    !mhi_chan_db_defer(mhi_chan, mflags)) {
 		read_lock_bh(&mhi_chan->lock);
 		mhi_ring_chan_db(mhi_cntrl, mhi_chan);
 		read_unlock_bh(&mhi_chan->lock);
@@ -706,7 +740,10 @@ int mhi_queue_buf(struct mhi_device *mhi_dev,
 	if (mhi_chan->dir == DMA_TO_DEVICE)
 		atomic_inc(&mhi_cntrl->pending_pkts);
 
-	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl))) {
+	mhi_pm_note_xfer(mhi_cntrl, mhi_chan);
+
+	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl)) &&
+	    !mhi_chan_db_defer(mhi_chan, mflags)) {
 		unsigned long flags;
 
 		read_lock_irqsave(&mhi_chan->lock, flags);
@@ -1597,6 +1634,51 @@ void mhi_ev_task(unsigned long data)
 	spin_unlock_irqrestore(&mhi_event->lock, flags);
 }
 
+static bool mhi_ev_ring_pending(struct mhi_controller *mhi_cntrl,
+				struct mhi_event *mhi_event)
+{
+	struct mhi_event_ctxt *er_ctxt =
+		&mhi_cntrl->mhi_ctxt->er_ctxt[mhi_event->er_index];
+	struct mhi_ring *ev_ring = &mhi_event->ring;
+
+	return ev_ring->rp != mhi_to_virtual(ev_ring, er_ctxt->rp);
+}
+
+int mhi_ev_napi_poll(struct napi_struct *napi, int budget)
+{
+	struct mhi_event *mhi_event = container_of(napi, struct mhi_event,
+						   napi_poll);
+	struct mhi_controller *mhi_cntrl = mhi_event->mhi_cntrl;
+	int ret;
+
+	MHI_VERB("Enter for ev_index:%d budget:%d\n", mhi_event->er_index,
+		 budget);
+
+	spin_lock_bh(&mhi_event->lock);
+	ret = mhi_event->process_event(mhi_cntrl, mhi_event, budget);
+	spin_unlock_bh(&mhi_event->lock);
+
+	/* no event access, stop polling until the next msi */
+	if (ret < 0) {
+		napi_complete(napi);
+		return 0;
+	}
+
+	/* budget exhausted, stay scheduled and let other softirqs run */
+	if (ret >= budget)
+		return budget;
+
+	/*
+	 * msi is edge triggered and was ignored while we were scheduled,
+	 * re-arm by checking for events device posted after the last read.
+	 */
+	if (napi_complete_done(napi, ret) &&
+	    mhi_ev_ring_pending(mhi_cntrl, mhi_event))
+		napi_schedule(napi);
+
+	return ret;
+}
+
 void mhi_ctrl_ev_task(unsigned long data)
 {
 	struct mhi_event *mhi_event = (struct mhi_event *)data;
@@ -1647,13 +1729,9 @@ irqreturn_t mhi_msi_handlr(int irq_number, void *dev)
 {
 	struct mhi_event *mhi_event = dev;
 	struct mhi_controller *mhi_cntrl = mhi_event->mhi_cntrl;
-	struct mhi_event_ctxt *er_ctxt =
-		&mhi_cntrl->mhi_ctxt->er_ctxt[mhi_event->er_index];
-	struct mhi_ring *ev_ring = &mhi_event->ring;
-	void *dev_rp = mhi_to_virtual(ev_ring, er_ctxt->rp);
 
 	/* confirm ER has pending events to process before scheduling work */
-	if (ev_ring->rp == dev_rp)
+	if (!mhi_ev_ring_pending(mhi_cntrl, mhi_event))
 		return IRQ_HANDLED;
 
 	/* client managed event ring, notify pending data */
@@ -1667,7 +1745,9 @@ irqreturn_t mhi_msi_handlr(int irq_number, void *dev)
 		return IRQ_HANDLED;
 	}
 
-	if (IS_MHI_ER_PRIORITY_HIGH(mhi_event))
+	if (mhi_event->napi)
+		napi_schedule_irqoff(&mhi_event->napi_poll);
+	else if (IS_MHI_ER_PRIORITY_HIGH(mhi_event))
 		tasklet_hi_schedule(&mhi_event->task);
 	else
 		tasklet_schedule(&mhi_event->task);
@@ -2223,13 +2303,14 @@ int mhi_debugfs_mhi_states_show(struct seq_file *m, void *d)
 	struct mhi_controller *mhi_cntrl = m->private;
 
 	seq_printf(m,
-		   "[%llu ns]: pm_state:%s dev_state:%s EE:%s M0:%u M2:%u M3:%u M3_Fast:%u wake:%d dev_wake:%u alloc_size:%u pending_pkts:%u\n",
+		   "[%llu ns]: pm_state:%s dev_state:%s EE:%s M0:%u M2:%u M3:%u M3_Fast:%u M3_Hold:%u break_even:%ums wake:%d dev_wake:%u alloc_size:%u pending_pkts:%u\n",
 		   sched_clock(),
 		   to_mhi_pm_state_str(mhi_cntrl->pm_state),
 		   TO_MHI_STATE_STR(mhi_cntrl->dev_state),
 		   TO_MHI_EXEC_STR(mhi_cntrl->ee),
 		   mhi_cntrl->M0, mhi_cntrl->M2, mhi_cntrl->M3,
-		   mhi_cntrl->M3_FAST, mhi_cntrl->wake_set,
+		   mhi_cntrl->M3_FAST, mhi_cntrl->M3_HOLD,
+		   mhi_cntrl->m3_break_even_ms, mhi_cntrl->wake_set,
 		   atomic_read(&mhi_cntrl->dev_wake),
 		   atomic_read(&mhi_cntrl->alloc_size),
 		   atomic_read(&mhi_cntrl->pending_pkts));
@@ -2549,6 +2630,68 @@ int mhi_get_no_free_descriptors(struct mhi_device *mhi_dev,
 }
 EXPORT_SYMBOL(mhi_get_no_free_descriptors);
 
+int mhi_flush_transfer(struct mhi_device *mhi_dev,
+		       enum dma_data_direction dir)
+{
+	struct mhi_controller *mhi_cntrl = mhi_dev->mhi_cntrl;
+	struct mhi_chan *mhi_chan = (dir == DMA_TO_DEVICE) ?
+		mhi_dev->ul_chan : mhi_dev->dl_chan;
+	struct mhi_ring *tre_ring;
+	unsigned long flags;
+	int n_queued_tre;
+
+	if (!mhi_chan)
+		return -EINVAL;
+
+	tre_ring = &mhi_chan->tre_ring;
+
+	read_lock_irqsave(&mhi_cntrl->pm_lock, flags);
+	if (unlikely(MHI_PM_IN_ERROR_STATE(mhi_cntrl->pm_state))) {
+		read_unlock_irqrestore(&mhi_cntrl->pm_lock, flags);
+		return -EIO;
+	}
+
+	mhi_chan->db_deferred = 0;
+	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl))) {
+		read_lock(&mhi_chan->lock);
+		/* keep the RSC minimum credit rule of mhi_queue_dma() */
+		n_queued_tre = tre_ring->elements -
+			get_nr_avail_ring_elements(mhi_cntrl, tre_ring);
+		if (mhi_chan->xfer_type != MHI_XFER_RSC_DMA ||
+		    !mhi_chan->db_cfg.db_mode ||
+		    n_queued_tre >= MHI_RSC_MIN_CREDITS)
+			mhi_ring_chan_db(mhi_cntrl, mhi_chan);
+		read_unlock(&mhi_chan->lock);
+	}
+	read_unlock_irqrestore(&mhi_cntrl->pm_lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(mhi_flush_transfer);
+
+int mhi_queue_transfer_n(struct mhi_device *mhi_dev,
+			 enum dma_data_direction dir,
+			 void **bufs,
+			 size_t *lens,
+			 int num,
+			 enum MHI_FLAGS mflags)
+{
+	int i, ret = 0;
+
+	for (i = 0; i < num; i++) {
+		ret = mhi_queue_transfer(mhi_dev, dir, bufs[i], lens[i],
+					 mflags | MHI_DB_DEFER);
+		if (ret)
+			break;
+	}
+
+	if (i)
+		mhi_flush_transfer(mhi_dev, dir);
+
+	return i ? i : ret;
+}
+EXPORT_SYMBOL(mhi_queue_transfer_n);
+
 static int __mhi_bdf_to_controller(struct device *dev, const void *tmp)
 {
 	struct mhi_device *mhi_dev = to_mhi_device(dev);
@@ -451,6 +451,66 @@ void mhi_pm_m1_transition(struct mhi_controller *mhi_cntrl)
 	mhi_cntrl->status_cb(mhi_cntrl, mhi_cntrl->priv_data, MHI_CB_IDLE);
 }
 
+void mhi_pm_note_xfer(struct mhi_controller *mhi_cntrl,
+		      struct mhi_chan *mhi_chan)
+{
+	u64 now, last, gap;
+
+	if (!mhi_cntrl->m3_break_even_ms)
+		return;
+
+	now = ktime_get_ns();
+	last = mhi_chan->last_xfer_ns;
+	mhi_chan->last_xfer_ns = now;
+	gap = now - last;
+
+	/* first transfer or still within the current burst */
+	if (!last || gap < MHI_BURST_GAP_MIN_NS)
+		return;
+
+	if (!mhi_chan->burst_gap_ns) {
+		mhi_chan->burst_gap_ns = gap;
+		return;
+	}
+
+	mhi_chan->burst_gap_ns += (s64)(gap - mhi_chan->burst_gap_ns) >>
+		MHI_BURST_GAP_EWMA_SHIFT;
+}
+
+bool mhi_pm_burst_expected(struct mhi_controller *mhi_cntrl)
+{
+	struct mhi_chan *mhi_chan = mhi_cntrl->mhi_chan;
+	u64 now, next, break_even;
+	int i;
+
+	if (!mhi_cntrl->m3_break_even_ms)
+		return false;
+
+	now = ktime_get_ns();
+	break_even = (u64)mhi_cntrl->m3_break_even_ms * NSEC_PER_MSEC;
+
+	for (i = 0; i < mhi_cntrl->max_chan; i++, mhi_chan++) {
+		if (!mhi_chan->burst_gap_ns)
+			continue;
+
+		/*
+		 * next burst is predicted one average gap after the last
+		 * transfer, once that point has passed stop holding the link
+		 * so a channel that went quiet does not keep us out of M3.
+		 */
+		next = mhi_chan->last_xfer_ns + mhi_chan->burst_gap_ns;
+		if (now < next && next - now <= break_even) {
+			mhi_cntrl->M3_HOLD++;
+			MHI_VERB("Burst due on chan:%u in %llu ns, hold M3\n",
+				 mhi_chan->chan, next - now);
+			return true;
+		}
+	}
+
+	return false;
+}
+EXPORT_SYMBOL(mhi_pm_burst_expected);
+
 int mhi_pm_m3_transition(struct mhi_controller *mhi_cntrl)
 {
 	enum MHI_PM_STATE state;
@@ -656,7 +716,10 @@ static void mhi_pm_disable_transition(struct mhi_controller *mhi_cntrl,
 	for (i = 0; i < mhi_cntrl->total_ev_rings; i++, mhi_event++) {
 		if (!mhi_event->request_irq)
 			continue;
-		tasklet_kill(&mhi_event->task);
+		if (mhi_event->napi)
+			napi_synchronize(&mhi_event->napi_poll);
+		else
+			tasklet_kill(&mhi_event->task);
 	}
 
 	mutex_unlock(&mhi_cntrl->pm_mutex);
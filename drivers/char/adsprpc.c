@@ -23,6 +23,7 @@
 #include <linux/cdev.h>
 #include <linux/list.h>
 #include <linux/hash.h>
+#include <linux/hashtable.h>
 #include <linux/msm_ion.h>
 #include <soc/qcom/secure_buffer.h>
 #include <linux/rpmsg.h>
@@ -53,6 +54,7 @@
 #include <linux/stat.h>
 #include <linux/preempt.h>
 #include <linux/of_reserved_mem.h>
+#include <linux/soc/qcom/cdsprm.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/fastrpc.h>
@@ -192,6 +194,16 @@
 /* Maximum buffers cached in cached buffer list */
 #define MAX_CACHED_BUFS   (32)
 
+/*
+ * Cached buffers are kept in power of two size classes starting at
+ * PAGE_SIZE, class i holds buffers of at least PAGE_SIZE << i bytes.
+ */
+#define FASTRPC_BUF_CACHE_CLASSES \
+	(order_base_2(MAX_CACHE_BUF_SIZE) - PAGE_SHIFT)
+
+/* Per process mappings are indexed by fd in a hash of this order */
+#define FASTRPC_MAP_HASH_BITS (6)
+
 /* Max no. of persistent headers pre-allocated per process */
 #define MAX_PERSISTENT_HEADERS    (25)
 
@@ -338,6 +350,7 @@ struct fastrpc_file;
 
 struct fastrpc_buf {
 	struct hlist_node hn;
+	struct list_head lru;	/* Used only while buffer is cached */
 	struct hlist_node hn_rem;
 	struct hlist_node hn_init;
 	struct fastrpc_file *fl;
@@ -534,6 +547,8 @@ struct fastrpc_apps {
 	struct hlist_head drivers;
 	spinlock_t hlock;
 	struct device *dev;
+	/* Serializes cached buffer trimming against file release */
+	struct mutex buf_cache_mutex;
 	/* Indicates fastrpc device node info */
 	struct device *dev_fastrpc;
 	unsigned int latency;
@@ -560,6 +575,7 @@ struct fastrpc_apps {
 
 struct fastrpc_mmap {
 	struct hlist_node hn;
+	struct hlist_node hn_fd;	/* Per process maps only, hashed by fd */
 	struct fastrpc_file *fl;
 	struct fastrpc_apps *apps;
 	int fd;
@@ -604,8 +620,19 @@ struct fastrpc_file {
 	struct hlist_node hn;
 	spinlock_t hlock;
 	struct hlist_head maps;
-	struct hlist_head cached_bufs;
+	/* Index of maps by fd, protected by map_mutex like maps */
+	DECLARE_HASHTABLE(map_hash, FASTRPC_MAP_HASH_BITS);
+	/* Lookups in map_hash and maps compared by them */
+	uint64_t map_lookups;
+	uint64_t map_probes;
+	/* Cached buffers per size class, see FASTRPC_BUF_CACHE_CLASSES */
+	struct hlist_head cached_bufs[FASTRPC_BUF_CACHE_CLASSES];
+	/* Cached buffers, most recently released first */
+	struct list_head cached_lru;
 	uint32_t num_cached_buf;
+	uint64_t cache_hits;
+	uint64_t cache_misses;
+	uint64_t cache_trims;
 	struct hlist_head remote_bufs;
 	struct fastrpc_ctx_lst clst;
 	struct fastrpc_session_ctx *sctx;
@@ -643,6 +670,10 @@ struct fastrpc_file {
 	int debug_buf_alloced_attempted;
 	/* Flag to enable PM wake/relax voting for every remote invoke */
 	int wake_enable;
+	/* Busy poll for completion of sync invocations before waiting */
+	bool poll_mode;
+	/* Max busy poll time in us when poll mode is enabled */
+	uint32_t poll_timeout;
 	struct gid_list gidlist;
 	/* Number of jobs pending in Async Queue */
 	atomic_t async_queue_job_count;
@@ -768,14 +799,13 @@ static inline int64_t get_timestamp_in_ns(void)
 	ns = timespec64_to_ns(&ts);
 	return ns;
 }
-static inline int poll_on_early_response(struct smq_invoke_ctx *ctx)
+static inline uint32_t *fastrpc_get_poll_memory(struct smq_invoke_ctx *ctx)
 {
-	int ii, jj, err = -EIO;
 	uint32_t sc = ctx->sc;
 	struct smq_invoke_buf *list;
 	struct smq_phy_page *pages;
 	uint64_t *fdlist = NULL;
-	uint32_t *crclist = NULL, *poll = NULL;
+	uint32_t *crclist = NULL;
 	unsigned int inbufs, outbufs, handles;
 
 	/* calculate poll memory location */
@@ -786,7 +816,14 @@ static inline int poll_on_early_response(struct smq_invoke_ctx *ctx)
 	pages = smq_phy_page_start(sc, list);
 	fdlist = (uint64_t *)(pages + inbufs + outbufs + handles);
 	crclist = (uint32_t *)(fdlist + M_FDLIST);
-	poll = (uint32_t *)(crclist + M_CRCLIST);
+
+	return (uint32_t *)(crclist + M_CRCLIST);
+}
+
+static inline int poll_on_early_response(struct smq_invoke_ctx *ctx)
+{
+	int ii, jj, err = -EIO;
+	uint32_t *poll = fastrpc_get_poll_memory(ctx);
 
 	/*
 	 * poll on memory for actual completion after receiving
@@ -812,6 +849,51 @@ static inline int poll_on_early_response(struct smq_invoke_ctx *ctx)
 	return err;
 }
 
+/*
+ * poll_for_remote_response - busy poll for completion of an invocation
+ * @ctx     : Context of the invocation
+ * @timeout : Max time in us to poll
+ *
+ * Used in poll mode right after the invocation is sent, instead of waiting
+ * for the response interrupt. Remote processor writes the poll memory on
+ * successful completion and the COMPLETE_SIGNAL that follows is ignored.
+ * Polling stops early if a response is received meanwhile, so that it is
+ * consumed by fastrpc_wait_for_completion. Returns 0 if the job completed.
+ */
+static int poll_for_remote_response(struct smq_invoke_ctx *ctx,
+					uint32_t timeout)
+{
+	int ii, jj, err = -EIO;
+	uint32_t *poll;
+
+	if (!ctx->rpra)
+		return err;
+
+	poll = fastrpc_get_poll_memory(ctx);
+	preempt_disable();
+	for (ii = 0, jj = 0; ii < timeout; ii++, jj++) {
+		if (READ_ONCE(*poll) == FASTRPC_EARLY_WAKEUP_POLL) {
+			/* Make sure output written by DSP is read after poll */
+			rmb();
+			ctx->retval = 0;
+			ctx->is_work_done = true;
+			err = 0;
+			break;
+		}
+		if (completion_done(&ctx->work))
+			break;
+		if (jj == FASTRPC_POLL_TIME_WITHOUT_PREEMPT) {
+			/* limit preempt disable time with no rescheduling */
+			preempt_enable();
+			preempt_disable();
+			jj = 0;
+		}
+		udelay(1);
+	}
+	preempt_enable();
+	return err;
+}
+
 /**
  * fastrpc_update_txmsg_buf - Update history of sent glink messages
  * @chan           : Channel context
@@ -995,9 +1077,34 @@ static int fastrpc_minidump_remove_region(struct fastrpc_mmap *map)
 }
 
 
+static inline unsigned int fastrpc_buf_cache_class(size_t size)
+{
+	if (size <= PAGE_SIZE)
+		return 0;
+
+	return min_t(unsigned int, ilog2(size) - PAGE_SHIFT,
+			FASTRPC_BUF_CACHE_CLASSES - 1);
+}
+
+/* Remove least recently used buffer from cache, called with fl->hlock held */
+static struct fastrpc_buf *fastrpc_cached_buf_evict(struct fastrpc_file *fl)
+{
+	struct fastrpc_buf *buf = NULL;
+
+	if (list_empty(&fl->cached_lru))
+		return NULL;
+
+	buf = list_last_entry(&fl->cached_lru, struct fastrpc_buf, lru);
+	list_del_init(&buf->lru);
+	hlist_del_init(&buf->hn);
+	fl->num_cached_buf--;
+	return buf;
+}
+
 static void fastrpc_buf_free(struct fastrpc_buf *buf, int cache)
 {
 	struct fastrpc_file *fl = buf == NULL ? NULL : buf->fl;
+	struct fastrpc_buf *lru = NULL;
 	int vmid, err = 0, cid = -1;
 
 	if (!fl)
@@ -1011,14 +1118,17 @@ static void fastrpc_buf_free(struct fastrpc_buf *buf, int cache)
 	}
 	if (cache && buf->size < MAX_CACHE_BUF_SIZE) {
 		spin_lock(&fl->hlock);
-		if (fl->num_cached_buf > MAX_CACHED_BUFS) {
-			spin_unlock(&fl->hlock);
-			goto skip_buf_cache;
-		}
-		hlist_add_head(&buf->hn, &fl->cached_bufs);
+		/* Cache is full, make room by dropping least recently used */
+		if (fl->num_cached_buf > MAX_CACHED_BUFS)
+			lru = fastrpc_cached_buf_evict(fl);
+		hlist_add_head(&buf->hn,
+			&fl->cached_bufs[fastrpc_buf_cache_class(buf->size)]);
+		list_add(&buf->lru, &fl->cached_lru);
 		fl->num_cached_buf++;
 		spin_unlock(&fl->hlock);
 		buf->type = -1;
+		if (lru)
+			fastrpc_buf_free(lru, 0);
 		return;
 	}
 skip_buf_cache:
@@ -1070,25 +1180,86 @@ static void fastrpc_buf_free(struct fastrpc_buf *buf, int cache)
 
 static void fastrpc_cached_buf_list_free(struct fastrpc_file *fl)
 {
-	struct fastrpc_buf *buf, *free;
+	struct fastrpc_buf *free;
 
+	/* Wait for any trimming of this file's cache in progress */
+	mutex_lock(&fl->apps->buf_cache_mutex);
 	do {
-		struct hlist_node *n;
-
-		free = NULL;
 		spin_lock(&fl->hlock);
-		hlist_for_each_entry_safe(buf, n, &fl->cached_bufs, hn) {
-			hlist_del_init(&buf->hn);
-			fl->num_cached_buf--;
-			free = buf;
-			break;
-		}
+		free = fastrpc_cached_buf_evict(fl);
 		spin_unlock(&fl->hlock);
 		if (free)
 			fastrpc_buf_free(free, 0);
 	} while (free);
+	mutex_unlock(&fl->apps->buf_cache_mutex);
+}
+
+static unsigned long fastrpc_buf_cache_count(struct shrinker *shrink,
+		struct shrink_control *sc)
+{
+	struct fastrpc_apps *me = &gfa;
+	struct fastrpc_file *fl;
+	unsigned long count = 0;
+
+	spin_lock(&me->hlock);
+	hlist_for_each_entry(fl, &me->drivers, hn)
+		count += READ_ONCE(fl->num_cached_buf);
+	spin_unlock(&me->hlock);
+
+	return count;
+}
+
+static unsigned long fastrpc_buf_cache_scan(struct shrinker *shrink,
+		struct shrink_control *sc)
+{
+	struct fastrpc_apps *me = &gfa;
+	struct fastrpc_buf *buf, *n;
+	struct fastrpc_file *fl;
+	unsigned long freed = 0;
+	LIST_HEAD(trim);
+
+	/*
+	 * Freeing a buffer may allocate (hyp_assign_phys), so never wait
+	 * here as we may already be reclaiming on behalf of a trim.
+	 */
+	if (!mutex_trylock(&me->buf_cache_mutex))
+		return SHRINK_STOP;
+
+	spin_lock(&me->hlock);
+	hlist_for_each_entry(fl, &me->drivers, hn) {
+		spin_lock(&fl->hlock);
+		while (freed < sc->nr_to_scan &&
+			(buf = fastrpc_cached_buf_evict(fl)) != NULL) {
+			list_add_tail(&buf->lru, &trim);
+			fl->cache_trims++;
+			freed++;
+		}
+		spin_unlock(&fl->hlock);
+		if (freed >= sc->nr_to_scan)
+			break;
+	}
+	spin_unlock(&me->hlock);
+
+	/*
+	 * Files being released drop off the drivers list before freeing
+	 * their cache, which blocks on buf_cache_mutex, so buf->fl remains
+	 * valid until trimmed buffers are released here.
+	 */
+	list_for_each_entry_safe(buf, n, &trim, lru) {
+		list_del_init(&buf->lru);
+		fastrpc_buf_free(buf, 0);
+	}
+	mutex_unlock(&me->buf_cache_mutex);
+
+	return freed;
 }
 
+static struct shrinker fastrpc_buf_shrinker = {
+	.count_objects = fastrpc_buf_cache_count,
+	.scan_objects = fastrpc_buf_cache_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
 static void fastrpc_remote_buf_list_free(struct fastrpc_file *fl)
 {
 	struct fastrpc_buf *buf, *free;
@@ -1121,9 +1292,16 @@ static void fastrpc_mmap_add(struct fastrpc_mmap *map)
 		struct fastrpc_file *fl = map->fl;
 
 		hlist_add_head(&map->hn, &fl->maps);
+		hash_add(fl->map_hash, &map->hn_fd, map->fd);
 	}
 }
 
+static inline void fastrpc_mmap_unlink(struct fastrpc_mmap *map)
+{
+	hlist_del_init(&map->hn);
+	hash_del(&map->hn_fd);
+}
+
 static int fastrpc_mmap_find(struct fastrpc_file *fl, int fd,
 		uintptr_t va, size_t len, int mflags, int refs,
 		struct fastrpc_mmap **ppmap)
@@ -1154,7 +1332,9 @@ static int fastrpc_mmap_find(struct fastrpc_file *fl, int fd,
 		}
 		spin_unlock(&me->hlock);
 	} else {
-		hlist_for_each_entry_safe(map, n, &fl->maps, hn) {
+		fl->map_lookups++;
+		hash_for_each_possible(fl->map_hash, map, hn_fd, fd) {
+			fl->map_probes++;
 			if (va >= map->va &&
 				va + len <= map->va + map->len &&
 				map->fd == fd) {
@@ -1240,7 +1420,7 @@ static int fastrpc_mmap_remove(struct fastrpc_file *fl, int fd, uintptr_t va,
 			/* Remove map if not used in process initialization */
 			!map->is_filemap) {
 			match = map;
-			hlist_del_init(&map->hn);
+			fastrpc_mmap_unlink(map);
 			break;
 		}
 	}
@@ -1293,7 +1473,7 @@ static void fastrpc_mmap_free(struct fastrpc_mmap *map, uint32_t flags)
 	} else {
 		map->refs--;
 		if (!map->refs && !map->ctx_refs)
-			hlist_del_init(&map->hn);
+			fastrpc_mmap_unlink(map);
 		if (map->refs > 0 && !flags)
 			return;
 	}
@@ -1657,20 +1837,31 @@ static inline bool fastrpc_get_cached_buf(struct fastrpc_file *fl,
 {
 	bool found = false;
 	struct fastrpc_buf *buf = NULL, *fr = NULL;
-	struct hlist_node *n = NULL;
+	unsigned int i;
 
-	if (buf_type == USERHEAP_BUF)
+	if (buf_type == USERHEAP_BUF || size >= MAX_CACHE_BUF_SIZE)
 		goto bail;
 
-	/* find the smallest buffer that fits in the cache */
+	/*
+	 * Take the most recently cached buffer of the smallest size class
+	 * that fits, buffers of a class only differ in their tail size.
+	 */
 	spin_lock(&fl->hlock);
-	hlist_for_each_entry_safe(buf, n, &fl->cached_bufs, hn) {
-		if (buf->size >= size && (!fr || fr->size > buf->size))
-			fr = buf;
+	for (i = get_order(size); i < FASTRPC_BUF_CACHE_CLASSES && !fr; i++) {
+		hlist_for_each_entry(buf, &fl->cached_bufs[i], hn) {
+			if (buf->size >= size) {
+				fr = buf;
+				break;
+			}
+		}
 	}
 	if (fr) {
 		hlist_del_init(&fr->hn);
+		list_del_init(&fr->lru);
 		fl->num_cached_buf--;
+		fl->cache_hits++;
+	} else {
+		fl->cache_misses++;
 	}
 	spin_unlock(&fl->hlock);
 	if (fr) {
@@ -1753,6 +1944,14 @@ static int fastrpc_buf_alloc(struct fastrpc_file *fl, size_t size,
 	if (fastrpc_get_cached_buf(fl, size, buf_type, obuf))
 		return err;
 
+	/*
+	 * Round cacheable buffers up to their size class so that they can be
+	 * reused by any later request of the same class.
+	 */
+	if ((buf_type == METADATA_BUF || buf_type == COPYDATA_BUF) &&
+		(PAGE_SIZE << get_order(size)) < MAX_CACHE_BUF_SIZE)
+		size = PAGE_SIZE << get_order(size);
+
 	/* If unable to get persistent or cached buf, allocate new buffer */
 	VERIFY(err, NULL != (buf = kzalloc(sizeof(*buf), GFP_KERNEL)));
 	if (err) {
@@ -1760,6 +1959,7 @@ static int fastrpc_buf_alloc(struct fastrpc_file *fl, size_t size,
 		goto bail;
 	}
 	INIT_HLIST_NODE(&buf->hn);
+	INIT_LIST_HEAD(&buf->lru);
 	buf->fl = fl;
 	buf->virt = NULL;
 	buf->phys = 0;
@@ -3083,6 +3283,7 @@ static void fastrpc_init(struct fastrpc_apps *me)
 	spin_lock_init(&me->hlock);
 	me->channel = &gcinfo[0];
 	mutex_init(&me->mut_uid);
+	mutex_init(&me->buf_cache_mutex);
 	for (i = 0; i < NUM_CHANNELS; i++) {
 		init_completion(&me->channel[i].work);
 		init_completion(&me->channel[i].workport);
@@ -3352,7 +3553,11 @@ static int fastrpc_internal_invoke(struct fastrpc_file *fl, uint32_t mode,
 	if (isasyncinvoke)
 		goto invoke_end;
  wait:
-	fastrpc_wait_for_completion(ctx, &interrupted, kernel, 0, &isworkdone);
+	if (fl->poll_mode && !ctx->is_work_done)
+		poll_for_remote_response(ctx, fl->poll_timeout);
+	if (!ctx->is_work_done)
+		fastrpc_wait_for_completion(ctx, &interrupted, kernel, 0,
+						&isworkdone);
 	VERIFY(err, 0 == (err = interrupted));
 	if (err)
 		goto bail;
@@ -3504,6 +3709,54 @@ static int fastrpc_get_async_response(
 	return err;
 }
 
+static int fastrpc_submit_async_batch(struct fastrpc_file *fl,
+			struct fastrpc_ioctl_async_batch *batch)
+{
+	struct fastrpc_ioctl_invoke_async __user *list =
+		(struct fastrpc_ioctl_invoke_async __user *)batch->list;
+	struct fastrpc_ioctl_invoke_async inv;
+	int err = 0;
+
+	for (batch->done = 0; batch->done < batch->count; batch->done++) {
+		K_COPY_FROM_USER(err, 0, &inv, &list[batch->done], sizeof(inv));
+		if (err) {
+			err = -EFAULT;
+			break;
+		}
+		VERIFY(err, inv.job != NULL);
+		if (err) {
+			err = -EINVAL;
+			break;
+		}
+		VERIFY(err, 0 == (err = fastrpc_internal_invoke(fl, fl->mode,
+					USER_MSG, &inv)));
+		if (err)
+			break;
+	}
+	/* Report the error only if nothing was submitted */
+	return batch->done ? 0 : err;
+}
+
+static int fastrpc_get_async_response_batch(struct fastrpc_file *fl,
+			struct fastrpc_ioctl_async_batch *batch)
+{
+	struct fastrpc_ioctl_async_response __user *list =
+		(struct fastrpc_ioctl_async_response __user *)batch->list;
+	struct fastrpc_ioctl_async_response async_res;
+	int err = 0;
+
+	for (batch->done = 0; batch->done < batch->count; batch->done++) {
+		/* Only wait for the first response, then reap what is queued */
+		if (batch->done && !atomic_read(&fl->async_queue_job_count))
+			break;
+		err = fastrpc_get_async_response(&async_res,
+				&list[batch->done], fl);
+		if (err)
+			break;
+	}
+	return batch->done ? 0 : err;
+}
+
 static int fastrpc_create_persistent_headers(struct fastrpc_file *fl,
 			uint32_t user_concurrency)
 {
@@ -3579,6 +3832,7 @@ static int fastrpc_internal_invoke2(struct fastrpc_file *fl,
 		struct fastrpc_ioctl_invoke_async inv;
 		struct fastrpc_ioctl_invoke_async_no_perf inv3;
 		struct fastrpc_ioctl_async_response async_res;
+		struct fastrpc_ioctl_async_batch batch;
 		uint32_t user_concurrency;
 	} p;
 	struct fastrpc_dsp_capabilities *dsp_cap_ptr = NULL;
@@ -3586,7 +3840,9 @@ static int fastrpc_internal_invoke2(struct fastrpc_file *fl,
 	int err = 0, domain = fl->cid;
 
 	if (inv2->req == FASTRPC_INVOKE2_ASYNC ||
-		inv2->req == FASTRPC_INVOKE2_ASYNC_RESPONSE) {
+		inv2->req == FASTRPC_INVOKE2_ASYNC_RESPONSE ||
+		inv2->req == FASTRPC_INVOKE2_ASYNC_BATCH ||
+		inv2->req == FASTRPC_INVOKE2_ASYNC_RESPONSE_BATCH) {
 		VERIFY(err, domain == CDSP_DOMAIN_ID && fl->sctx != NULL);
 		if (err)
 			goto bail;
@@ -3646,6 +3902,26 @@ static int fastrpc_internal_invoke2(struct fastrpc_file *fl,
 		err = fastrpc_create_persistent_headers(fl,
 				p.user_concurrency);
 		break;
+	case FASTRPC_INVOKE2_ASYNC_BATCH:
+	case FASTRPC_INVOKE2_ASYNC_RESPONSE_BATCH:
+		size = sizeof(struct fastrpc_ioctl_async_batch);
+		if (inv2->size != size) {
+			err = -EBADE;
+			goto bail;
+		}
+		K_COPY_FROM_USER(err, 0, &p.batch, (void *)inv2->invparam,
+				size);
+		if (err)
+			goto bail;
+		if (inv2->req == FASTRPC_INVOKE2_ASYNC_BATCH)
+			err = fastrpc_submit_async_batch(fl, &p.batch);
+		else
+			err = fastrpc_get_async_response_batch(fl, &p.batch);
+		if (err)
+			goto bail;
+		K_COPY_TO_USER(err, 0, (void *)inv2->invparam, &p.batch,
+				size);
+		break;
 	default:
 		err = -ENOTTY;
 		break;
@@ -5403,7 +5679,7 @@ static int fastrpc_file_free(struct fastrpc_file *fl)
 	do {
 		lmap = NULL;
 		hlist_for_each_entry_safe(map, n, &fl->maps, hn) {
-			hlist_del_init(&map->hn);
+			fastrpc_mmap_unlink(map);
 			lmap = map;
 			break;
 		}
@@ -5616,6 +5892,14 @@ static ssize_t fastrpc_debugfs_read(struct file *filp, char __user *buffer,
 				"%-20d|0x%-20lX\n\n",
 				map->secure, map->attr);
 		}
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"%-20s|%-20s|%-20s\n",
+			"map lookups", "map probes", "probes per lookup");
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"%-20llu|%-20llu|%-20llu\n",
+			fl->map_lookups, fl->map_probes,
+			fl->map_lookups ?
+			div64_u64(fl->map_probes, fl->map_lookups) : 0);
 		mutex_unlock(&fl->map_mutex);
 		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
 			"\n======%s %s %s======\n", title,
@@ -5627,12 +5911,19 @@ static ssize_t fastrpc_debugfs_read(struct file *filp, char __user *buffer,
 		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
 			"%s%s%s%s%s\n", single_line, single_line,
 			single_line, single_line, single_line);
-		hlist_for_each_entry_safe(buf, n, &fl->cached_bufs, hn) {
+		list_for_each_entry(buf, &fl->cached_lru, lru) {
 			len += scnprintf(fileinfo + len,
 				DEBUGFS_SIZE - len,
 				"0x%-17p|0x%-17llX|%-19zu\n",
 				buf->virt, (uint64_t)buf->phys, buf->size);
 		}
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"\n%-19s|%-19s|%-19s|%-19s\n",
+			"cached", "hits", "misses", "trims");
+		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
+			"%-19u|%-19llu|%-19llu|%-19llu\n",
+			fl->num_cached_buf, fl->cache_hits,
+			fl->cache_misses, fl->cache_trims);
 
 		len += scnprintf(fileinfo + len, DEBUGFS_SIZE - len,
 			"\n%s %s %s\n", title,
@@ -5749,7 +6040,7 @@ static inline void fastrpc_register_wakeup_source(struct device *dev,
 
 static int fastrpc_device_open(struct inode *inode, struct file *filp)
 {
-	int err = 0;
+	int err = 0, i;
 	struct fastrpc_file *fl = NULL;
 	struct fastrpc_apps *me = &gfa;
 
@@ -5777,7 +6068,10 @@ static int fastrpc_device_open(struct inode *inode, struct file *filp)
 	spin_lock_init(&fl->hlock);
 	spin_lock_init(&fl->aqlock);
 	INIT_HLIST_HEAD(&fl->maps);
-	INIT_HLIST_HEAD(&fl->cached_bufs);
+	hash_init(fl->map_hash);
+	for (i = 0; i < FASTRPC_BUF_CACHE_CLASSES; i++)
+		INIT_HLIST_HEAD(&fl->cached_bufs[i]);
+	INIT_LIST_HEAD(&fl->cached_lru);
 	fl->num_cached_buf = 0;
 	INIT_HLIST_HEAD(&fl->remote_bufs);
 	init_waitqueue_head(&fl->async_wait_queue);
@@ -6029,6 +6323,23 @@ static int fastrpc_internal_control(struct fastrpc_file *fl,
 	case FASTRPC_CONTROL_DSPPROCESS_CLEAN:
 		(void)fastrpc_release_current_dsp_process(fl);
 		break;
+	case FASTRPC_CONTROL_RPC_POLL:
+		fl->poll_timeout = min_t(uint32_t, cp->poll.timeout,
+						FASTRPC_POLL_TIME);
+		fl->poll_mode = cp->poll.enable && fl->poll_timeout;
+		/* Remote processor writes poll memory only with early wakeup */
+		if (fl->poll_mode)
+			fastrpc_send_cpuinfo_to_dsp(fl);
+		break;
+	case FASTRPC_CONTROL_WORKLOAD_HINT:
+		VERIFY(err, fl->cid == CDSP_DOMAIN_ID);
+		if (err) {
+			err = -EPERM;
+			goto bail;
+		}
+		err = cdsprm_session_hint(cp->hint.duration,
+					  cp->hint.priority);
+		break;
 	default:
 		err = -EBADRQC;
 		break;
@@ -7064,6 +7375,9 @@ static int __init fastrpc_device_init(void)
 	fastrpc_get_dsp_status(me);
 	me->dev = NULL;
 	me->legacy_remote_heap = false;
+	VERIFY(err, 0 == register_shrinker(&fastrpc_buf_shrinker));
+	if (err)
+		goto register_bail;
 	VERIFY(err, 0 == platform_driver_register(&fastrpc_driver));
 	if (err)
 		goto register_bail;
@@ -7162,6 +7476,7 @@ static int __init fastrpc_device_init(void)
 	unregister_chrdev_region(me->dev_no, NUM_CHANNELS);
 alloc_chrdev_bail:
 register_bail:
+	unregister_shrinker(&fastrpc_buf_shrinker);
 	fastrpc_deinit();
 	return err;
 }
@@ -7171,6 +7486,7 @@ static void __exit fastrpc_device_exit(void)
 	struct fastrpc_apps *me = &gfa;
 	int i;
 
+	unregister_shrinker(&fastrpc_buf_shrinker);
 	fastrpc_file_list_dtor(me);
 	fastrpc_deinit();
 	wakeup_source_unregister(me->wake_source);
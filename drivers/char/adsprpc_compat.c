@@ -212,6 +212,16 @@ struct compat_fastrpc_ctrl_pm {
 	compat_uint_t timeout;	/* timeout(in ms) for PM to keep system awake */
 };
 
+struct compat_fastrpc_ctrl_poll {
+	compat_uint_t enable;	/* poll mode enable */
+	compat_uint_t timeout;	/* max busy poll time in us */
+};
+
+struct compat_fastrpc_ctrl_hint {
+	compat_uint_t duration;	/* expected workload duration in ms */
+	compat_uint_t priority;	/* compute priority, 0 for no change */
+};
+
 struct compat_fastrpc_ioctl_control {
 	compat_uint_t req;
 	union {
@@ -219,6 +229,8 @@ struct compat_fastrpc_ioctl_control {
 		struct compat_fastrpc_ctrl_kalloc kalloc;
 		struct compat_fastrpc_ctrl_wakelock wp;
 		struct compat_fastrpc_ctrl_pm pm;
+		struct compat_fastrpc_ctrl_poll poll;
+		struct compat_fastrpc_ctrl_hint hint;
 	};
 };
 
@@ -649,6 +661,16 @@ static int compat_get_fastrpc_ioctl_control(
 	} else if (p == FASTRPC_CONTROL_PM) {
 		err |= get_user(p, &ctrl32->pm.timeout);
 		err |= put_user(p, &ctrl->pm.timeout);
+	} else if (p == FASTRPC_CONTROL_RPC_POLL) {
+		err |= get_user(p, &ctrl32->poll.enable);
+		err |= put_user(p, &ctrl->poll.enable);
+		err |= get_user(p, &ctrl32->poll.timeout);
+		err |= put_user(p, &ctrl->poll.timeout);
+	} else if (p == FASTRPC_CONTROL_WORKLOAD_HINT) {
+		err |= get_user(p, &ctrl32->hint.duration);
+		err |= put_user(p, &ctrl->hint.duration);
+		err |= get_user(p, &ctrl32->hint.priority);
+		err |= put_user(p, &ctrl->hint.priority);
 	}
 
 	return err;
@@ -262,10 +262,20 @@ struct fastrpc_ioctl_async_response {
 	uint32_t sc;
 };
 
+struct fastrpc_ioctl_async_batch {
+	uintptr_t list;	/* array of invoke_async or async_response */
+	uint32_t count;	/* number of entries in list */
+	uint32_t done;	/* entries submitted or reaped, set by driver */
+};
+
 enum fastrpc_invoke2_type {
 	FASTRPC_INVOKE2_ASYNC		   = 1,
 	FASTRPC_INVOKE2_ASYNC_RESPONSE = 2,
 	FASTRPC_INVOKE2_KERNEL_OPTIMIZATIONS,
+	/* Submit a list of async invocations */
+	FASTRPC_INVOKE2_ASYNC_BATCH,
+	/* Reap up to a list of async responses, waiting for the first only */
+	FASTRPC_INVOKE2_ASYNC_RESPONSE_BATCH,
 };
 
 enum fastrpc_process_exit_states {
@@ -435,6 +445,10 @@ enum fastrpc_control_type {
 	FASTRPC_CONTROL_PM		=	5,
 /* Clean process on DSP */
 	FASTRPC_CONTROL_DSPPROCESS_CLEAN	=	6,
+/* Busy poll for RPC completion before waiting for DSP response */
+	FASTRPC_CONTROL_RPC_POLL	=	7,
+/* Workload hint for CDSP clock and QoS pre-voting */
+	FASTRPC_CONTROL_WORKLOAD_HINT	=	8,
 };
 
 struct fastrpc_ctrl_latency {
@@ -454,6 +468,16 @@ struct fastrpc_ctrl_pm {
 	uint32_t timeout;	/* timeout(in ms) for PM to keep system awake */
 };
 
+struct fastrpc_ctrl_poll {
+	uint32_t enable;	/* poll mode enable */
+	uint32_t timeout;	/* max busy poll time in us */
+};
+
+struct fastrpc_ctrl_hint {
+	uint32_t duration;	/* expected workload duration in ms */
+	uint32_t priority;	/* compute priority, 0 for no change */
+};
+
 struct fastrpc_ioctl_control {
 	uint32_t req;
 	union {
@@ -461,6 +485,8 @@ struct fastrpc_ioctl_control {
 		struct fastrpc_ctrl_kalloc kalloc;
 		struct fastrpc_ctrl_wakelock wp;
 		struct fastrpc_ctrl_pm pm;
+		struct fastrpc_ctrl_poll poll;
+		struct fastrpc_ctrl_hint hint;
 	};
 };
 
@@ -96,6 +96,9 @@ struct clk_core {
 #define CREATE_TRACE_POINTS
 #include <trace/events/clk.h>
 
+EXPORT_TRACEPOINT_SYMBOL_GPL(clk_rcg2_set_rate);
+EXPORT_TRACEPOINT_SYMBOL_GPL(clk_rcg2_set_rate_complete);
+
 struct clk {
 	struct clk_core	*core;
 	struct device *dev;
@@ -144,6 +144,9 @@ extern const struct clk_ops clk_dyn_rcg_ops;
  * @clkr: regmap clock handle
  * @cfg_off: defines the cfg register offset from the CMD_RCGR + CFG_REG
  * @flags: additional flag parameters for the RCG
+ * @lookup_rate: rate of the last frequency table lookup
+ * @lookup_floor: whether the last lookup rounded down
+ * @lookup_f: frequency table entry found by the last lookup
  */
 struct clk_rcg2 {
 	u32			cmd_rcgr;
@@ -160,6 +163,9 @@ struct clk_rcg2 {
 #define FORCE_ENABLE_RCG	BIT(0)
 #define HW_CLK_CTRL_MODE	BIT(1)
 #define DFS_SUPPORT		BIT(2)
+	unsigned long		lookup_rate;
+	bool			lookup_floor;
+	const struct freq_tbl	*lookup_f;
 };
 
 #define to_clk_rcg2(_hw) container_of(to_clk_regmap(_hw), struct clk_rcg2, clkr)
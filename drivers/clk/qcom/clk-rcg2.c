@@ -15,8 +15,10 @@
 #include <linux/rational.h>
 #include <linux/math64.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
 
 #include <asm/div64.h>
+#include <trace/events/clk.h>
 
 #include "clk-rcg.h"
 #include "common.h"
@@ -555,14 +557,20 @@ static long clk_rcg2_list_rate(struct clk_hw *hw, unsigned int n,
 	return (rcg->freq_tbl + n)->freq;
 }
 
-static int __clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
-			       enum freq_policy policy)
+/*
+ * DCVS keeps asking for the same handful of rates, so remember the result of
+ * the last frequency table walk. The clock framework serializes set_rate
+ * calls, so the cache needs no locking of its own.
+ */
+static const struct freq_tbl *clk_rcg2_find_freq(struct clk_rcg2 *rcg,
+				unsigned long rate, enum freq_policy policy)
 {
-	struct clk_rcg2 *rcg = to_clk_rcg2(hw);
-	const struct freq_tbl *f, *f_curr;
-	int ret, curr_src_index, new_src_index;
-	struct clk_hw *curr_src = NULL, *new_src = NULL;
-	bool force_enabled = false;
+	const struct freq_tbl *f;
+	bool floor = policy == FLOOR;
+
+	if (rcg->lookup_f && rcg->lookup_rate == rate &&
+	    rcg->lookup_floor == floor)
+		return rcg->lookup_f;
 
 	switch (policy) {
 	case FLOOR:
@@ -572,9 +580,52 @@ static int __clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
 		f = qcom_find_freq(rcg->freq_tbl, rate);
 		break;
 	default:
-		return -EINVAL;
+		return NULL;
 	};
 
+	if (f) {
+		rcg->lookup_rate = rate;
+		rcg->lookup_floor = floor;
+		rcg->lookup_f = f;
+	}
+
+	return f;
+}
+
+/*
+ * Check whether the RCG already runs the configuration in @f with no update
+ * pending, in which case reprogramming it and polling for the update can be
+ * skipped.
+ */
+static bool clk_rcg2_config_matches(struct clk_rcg2 *rcg,
+				    const struct freq_tbl *f)
+{
+	u32 cmd;
+
+	/* clk_rcg2_current_config() does not account for cfg_off */
+	if (rcg->cfg_off)
+		return false;
+
+	if (regmap_read(rcg->clkr.regmap, rcg->cmd_rcgr + CMD_REG, &cmd))
+		return false;
+
+	if (cmd & (CMD_UPDATE | CMD_DIRTY_CFG | CMD_DIRTY_N | CMD_DIRTY_M |
+		   CMD_DIRTY_D))
+		return false;
+
+	return clk_rcg2_current_config(rcg, f);
+}
+
+static int _clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
+			      enum freq_policy policy, bool *skipped)
+{
+	struct clk_rcg2 *rcg = to_clk_rcg2(hw);
+	const struct freq_tbl *f, *f_curr;
+	int ret, curr_src_index, new_src_index;
+	struct clk_hw *curr_src = NULL, *new_src = NULL;
+	bool force_enabled = false;
+
+	f = clk_rcg2_find_freq(rcg, rate, policy);
 	if (!f)
 		return -EINVAL;
 
@@ -587,6 +638,12 @@ static int __clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
 		return 0;
 	}
 
+	if (clk_rcg2_config_matches(rcg, f)) {
+		*skipped = true;
+		rcg->current_freq = rate;
+		return 0;
+	}
+
 	if (rcg->flags & FORCE_ENABLE_RCG) {
 		rcg->current_freq = DIV_ROUND_CLOSEST_ULL(
 					clk_get_rate(hw->clk), 1000) * 1000;
@@ -636,6 +693,25 @@ static int __clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
 	return ret;
 }
 
+static int __clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
+			       enum freq_policy policy)
+{
+	const char *name = clk_hw_get_name(hw);
+	bool skipped = false;
+	ktime_t start;
+	int ret;
+
+	trace_clk_rcg2_set_rate(name, rate);
+	start = ktime_get();
+
+	ret = _clk_rcg2_set_rate(hw, rate, policy, &skipped);
+
+	trace_clk_rcg2_set_rate_complete(name, rate, skipped,
+			ktime_to_ns(ktime_sub(ktime_get(), start)), ret);
+
+	return ret;
+}
+
 static int clk_rcg2_set_rate(struct clk_hw *hw, unsigned long rate,
 			    unsigned long parent_rate)
 {
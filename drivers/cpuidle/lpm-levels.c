@@ -102,9 +102,56 @@ struct ipi_history {
 	ktime_t cpu_idle_resched_ts;
 };
 
+/*
+ * lpm_predictor selects how the residency of a cpu level is predicted:
+ * LPM_PREDICTOR_HISTORY - the last MAXSAMPLES residencies and IPI
+ *			   intervals (lpm_cpuidle_predict())
+ * LPM_PREDICTOR_TIMER   - the timer based sleep length, corrected by how
+ *			   often this cpu woke up early from each level
+ *			   (timer/IPI correlation, like the TEO governor)
+ */
+enum lpm_predictor {
+	LPM_PREDICTOR_HISTORY,
+	LPM_PREDICTOR_TIMER,
+};
+
+static uint lpm_predictor = LPM_PREDICTOR_HISTORY;
+module_param_named(lpm_predictor, lpm_predictor, uint, 0664);
+
+enum lpm_pred_src {
+	LPM_PRED_NONE,
+	LPM_PRED_HISTORY,
+	LPM_PRED_RESTRICT,
+	LPM_PRED_IPI,
+	LPM_PRED_TIMER,
+	LPM_PRED_NR,
+};
+
+static const char * const lpm_pred_src_names[LPM_PRED_NR] = {
+	"none", "history", "restrict", "ipi", "timer",
+};
+
+/* Decayed weights of the timer predictor, in 1/1024 units */
+#define LPM_TEO_WEIGHT		1024
+#define LPM_TEO_DECAY_SHIFT	3
+
+struct lpm_pred_stats {
+	uint32_t sleep_us;
+	enum lpm_pred_src src;
+	uint32_t entries[NR_LPM_LEVELS];
+	uint32_t hits[NR_LPM_LEVELS];
+	uint32_t premature[NR_LPM_LEVELS];
+	uint32_t too_shallow[NR_LPM_LEVELS];
+	uint32_t src_entries[LPM_PRED_NR];
+	uint32_t src_premature[LPM_PRED_NR];
+	uint32_t teo_hits[NR_LPM_LEVELS];
+	uint32_t teo_early[NR_LPM_LEVELS];
+};
+
 static DEFINE_PER_CPU(ktime_t, next_hrtimer);
 static DEFINE_PER_CPU(struct lpm_history, hist);
 static DEFINE_PER_CPU(struct ipi_history, cpu_ipi_history);
+static DEFINE_PER_CPU(struct lpm_pred_stats, pred_stats);
 static DEFINE_PER_CPU(struct lpm_cpu*, cpu_lpm);
 static bool suspend_in_progress;
 static DEFINE_PER_CPU(struct hrtimer, histtimer);
@@ -688,11 +735,125 @@ static inline uint32_t get_cpus_qos(const struct cpumask *mask)
 		n = cpuidle_governor_latency_req(cpu);
 		if (n < latency)
 			latency = n;
+		n = sched_cpu_wake_lat_us(cpu);
+		if (n < latency)
+			latency = n;
 	}
 
 	return latency;
 }
 
+/* Deepest level whose minimum residency fits in @residency_us */
+static int residency_to_level(struct lpm_cpu *cpu, uint32_t residency_us)
+{
+	int i;
+
+	for (i = cpu->nlevels - 1; i > 0; i--)
+		if (residency_us >= cpu->levels[i].pwr.min_residency)
+			break;
+
+	return i;
+}
+
+/*
+ * Timer predictor: @idx is the level picked from the timer sleep length.
+ * If this cpu woke up early, into shallower levels, more often than it
+ * slept as long as the timer said, pick the level in which the median of
+ * those early wakeups fell.
+ */
+static int lpm_timer_predict(struct cpuidle_device *dev, struct lpm_cpu *cpu,
+			     int idx)
+{
+	struct lpm_pred_stats *stats = &per_cpu(pred_stats, dev->cpu);
+	uint64_t early = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < idx; i++)
+		early += stats->teo_early[i];
+
+	if (early <= stats->teo_hits[idx] + stats->teo_early[idx])
+		return idx;
+
+	for (i = idx - 1; i > 0; i--) {
+		sum += stats->teo_early[i];
+		if (sum * 2 >= early)
+			break;
+	}
+
+	while (i > 0 && !lpm_cpu_mode_allow(dev->cpu, i, true))
+		i--;
+
+	return i;
+}
+
+static void update_pred_stats(struct cpuidle_device *dev,
+			      struct lpm_cpu *cpu, int idx)
+{
+	struct lpm_pred_stats *stats = &per_cpu(pred_stats, dev->cpu);
+	struct power_params *pwr = &cpu->levels[idx].pwr;
+	uint32_t resi = dev->last_residency;
+	int i, timer_idx, meas_idx;
+
+	stats->entries[idx]++;
+	stats->src_entries[stats->src]++;
+
+	if (resi < pwr->min_residency) {
+		stats->premature[idx]++;
+		stats->src_premature[stats->src]++;
+	} else if (idx < cpu->nlevels - 1 && resi > pwr->max_residency) {
+		stats->too_shallow[idx]++;
+	} else {
+		stats->hits[idx]++;
+	}
+
+	for (i = 0; i < cpu->nlevels; i++) {
+		stats->teo_hits[i] -= stats->teo_hits[i] >> LPM_TEO_DECAY_SHIFT;
+		stats->teo_early[i] -=
+			stats->teo_early[i] >> LPM_TEO_DECAY_SHIFT;
+	}
+
+	timer_idx = residency_to_level(cpu, stats->sleep_us);
+	meas_idx = residency_to_level(cpu, resi);
+	if (meas_idx >= timer_idx)
+		stats->teo_hits[timer_idx] += LPM_TEO_WEIGHT;
+	else
+		stats->teo_early[meas_idx] += LPM_TEO_WEIGHT;
+}
+
+static ssize_t pred_stats_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	struct lpm_pred_stats *stats;
+	struct lpm_cpu *lpm_cpu;
+	unsigned int cpu;
+	ssize_t cnt = 0;
+	int i;
+
+	for_each_possible_cpu(cpu) {
+		lpm_cpu = per_cpu(cpu_lpm, cpu);
+		stats = &per_cpu(pred_stats, cpu);
+		if (!lpm_cpu)
+			continue;
+
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt, "cpu%u\n", cpu);
+		for (i = 0; i < lpm_cpu->nlevels; i++)
+			cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"\t%s: entries=%u hits=%u premature=%u too_shallow=%u\n",
+				lpm_cpu->levels[i].name, stats->entries[i],
+				stats->hits[i], stats->premature[i],
+				stats->too_shallow[i]);
+		for (i = 0; i < LPM_PRED_NR; i++)
+			cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"\tpred_%s: entries=%u premature=%u\n",
+				lpm_pred_src_names[i], stats->src_entries[i],
+				stats->src_premature[i]);
+	}
+
+	return cnt;
+}
+
+static struct kobj_attribute pred_stats_attr = __ATTR_RO(pred_stats);
+
 static int cpu_power_select(struct cpuidle_device *dev,
 		struct lpm_cpu *cpu)
 {
@@ -707,6 +868,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	uint32_t next_wakeup_us = (uint32_t)sleep_us;
 	uint32_t min_residency, max_residency;
 	struct power_params *pwr_params;
+	bool timer_predictor = lpm_predictor == LPM_PREDICTOR_TIMER;
+	int timer_level = 0;
 
 	if (lpm_disallowed(sleep_us, dev->cpu, cpu))
 		goto done_select;
@@ -731,7 +894,9 @@ static int cpu_power_select(struct cpuidle_device *dev,
 			 * deeper low power modes than clock gating do not
 			 * call prediction.
 			 */
-			if (next_wakeup_us > max_residency) {
+			if (timer_predictor) {
+				invalidate_predict_history(dev);
+			} else if (next_wakeup_us > max_residency) {
 				predicted = lpm_cpuidle_predict(dev, cpu,
 					&idx_restrict, &idx_restrict_time,
 					&ipi_predicted);
@@ -751,6 +916,11 @@ static int cpu_power_select(struct cpuidle_device *dev,
 			break;
 	}
 
+	if (timer_predictor) {
+		timer_level = best_level;
+		best_level = lpm_timer_predict(dev, cpu, best_level);
+	}
+
 	/*
 	 * Start timer to avoid staying in shallower mode forever
 	 * incase of misprediciton
@@ -773,9 +943,20 @@ static int cpu_power_select(struct cpuidle_device *dev,
 		if ((next_wakeup_us > htime) &&
 			((next_wakeup_us - htime) > max_residency))
 			histtimer_start(htime);
+	} else if (best_level < timer_level && lpm_prediction &&
+		   cpu->lpm_prediction) {
+		htime = max_residency;
+		if ((next_wakeup_us > htime) &&
+			((next_wakeup_us - htime) > max_residency))
+			histtimer_start(htime);
 	}
 
 done_select:
+	per_cpu(pred_stats, dev->cpu).sleep_us = next_wakeup_us;
+	per_cpu(pred_stats, dev->cpu).src = idx_restrict_time ?
+		LPM_PRED_RESTRICT : (ipi_predicted ? LPM_PRED_IPI :
+		(predicted ? LPM_PRED_HISTORY : (best_level < timer_level ?
+		LPM_PRED_TIMER : LPM_PRED_NONE)));
 	trace_cpu_power_select(best_level, sleep_us, latency_us, cpu->bias);
 
 	trace_cpu_pred_select(idx_restrict_time ? 2 : (ipi_predicted ?
@@ -1495,6 +1676,7 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 	cpu_unprepare(cpu, idx, true);
 	dev->last_residency = ktime_us_delta(ktime_get(), start);
 	update_history(dev, idx);
+	update_pred_stats(dev, cpu, idx);
 	RCU_NONIDLE(trace_cpu_idle_exit(idx, ret));
 	if (lpm_prediction && cpu->lpm_prediction) {
 		histtimer_cancel();
@@ -1841,6 +2023,10 @@ static int lpm_probe(struct platform_device *pdev)
 		goto failed;
 	}
 
+	ret = sysfs_create_file(module_kobj, &pred_stats_attr.attr);
+	if (ret)
+		pr_err("Failed to create pred_stats node: %d\n", ret);
+
 	suspend_set_ops(&lpm_suspend_ops);
 	s2idle_set_ops(&lpm_s2idle_ops);
 
@@ -82,6 +82,12 @@ struct cpu_data {
  * @wb_ev:			The cache writeback perf event exclusive to this
  *				mon. Optional - only needed for writeback
  *				percent.
+ * @lat_ev_id:			The event code corresponding to the @lat_ev
+ *				perf event. Optional - only needed for the
+ *				stall budget model.
+ * @lat_ev:			Counts cycles with a miss outstanding at the
+ *				cache level this mon covers. Optional - only
+ *				needed for the stall budget model.
  * @requested_update_ms:	The mon's desired polling rate. The lowest
  *				@requested_update_ms of all mons determines
  *				@cpu_grp's update_ms.
@@ -95,10 +101,12 @@ struct memlat_mon {
 	unsigned int		miss_ev_id;
 	unsigned int		access_ev_id;
 	unsigned int		wb_ev_id;
+	unsigned int		lat_ev_id;
 	unsigned int		requested_update_ms;
 	struct event_data	*miss_ev;
 	struct event_data	*access_ev;
 	struct event_data	*wb_ev;
+	struct event_data	*lat_ev;
 	struct memlat_hwmon	hw;
 
 	struct memlat_cpu_grp	*cpu_grp;
@@ -230,6 +238,8 @@ static void update_counts(struct memlat_cpu_grp *cpu_grp)
 				read_event(&mon->wb_ev[mon_idx]);
 				read_event(&mon->access_ev[mon_idx]);
 			}
+			if (mon->lat_ev)
+				read_event(&mon->lat_ev[mon_idx]);
 			cpu_grp->read_event_cpu = -1;
 		}
 	}
@@ -267,6 +277,13 @@ static unsigned long get_cnt(struct memlat_hwmon *hw)
 					  mon->access_ev[mon_idx].last_delta);
 		else
 			devstats->wb_pct = 0;
+
+		if (mon->lat_ev && common_evs[CYC_IDX].last_delta)
+			devstats->lat_pct =
+				mult_frac(100, mon->lat_ev[mon_idx].last_delta,
+					  common_evs[CYC_IDX].last_delta);
+		else
+			devstats->lat_pct = 0;
 	}
 
 	return 0;
@@ -420,6 +437,9 @@ static int memlat_idle_read_events(unsigned int cpu)
 		if (mon->miss_ev[idx].pevent)
 			ret = perf_event_read_local(mon->miss_ev[idx].pevent,
 			&mon->miss_ev[idx].cached_total_count, NULL, NULL);
+		if (mon->lat_ev && mon->lat_ev[idx].pevent)
+			ret = perf_event_read_local(mon->lat_ev[idx].pevent,
+			&mon->lat_ev[idx].cached_total_count, NULL, NULL);
 	}
 exit:
 	spin_unlock_irqrestore(&cpu_grp->mon_active_lock, flags);
@@ -472,8 +492,19 @@ static int memlat_hp_restart_events(unsigned int cpu, bool cpu_up)
 					mon->miss_ev[idx], cpu, ret);
 				goto exit;
 			}
+			if (mon->lat_ev) {
+				ret = set_event(&mon->lat_ev[idx], cpu,
+						mon->lat_ev_id, attr);
+				if (ret) {
+					pr_err("event %d not set for cpu %d ret %d\n",
+						mon->lat_ev_id, cpu, ret);
+					goto exit;
+				}
+			}
 		} else {
 			delete_event(&mon->miss_ev[idx]);
+			if (mon->lat_ev)
+				delete_event(&mon->lat_ev[idx]);
 		}
 	}
 
@@ -622,6 +653,13 @@ static int start_hwmon(struct memlat_hwmon *hw)
 				if (ret)
 					goto unlock_out;
 			}
+
+			if (mon->lat_ev) {
+				ret = set_event(&mon->lat_ev[idx], cpu,
+						mon->lat_ev_id, attr);
+				if (ret)
+					goto unlock_out;
+			}
 		}
 	}
 
@@ -665,12 +703,15 @@ static void stop_hwmon(struct memlat_hwmon *hw)
 				delete_event(&mon->wb_ev[idx]);
 			if (mon->access_ev)
 				delete_event(&mon->access_ev[idx]);
+			if (mon->lat_ev)
+				delete_event(&mon->lat_ev[idx]);
 		}
 		devstats->inst_count = 0;
 		devstats->mem_count = 0;
 		devstats->freq = 0;
 		devstats->stall_pct = 0;
 		devstats->wb_pct = 0;
+		devstats->lat_pct = 0;
 	}
 
 	if (!cpu_grp->num_active_mons) {
@@ -943,6 +984,7 @@ static int memlat_mon_probe(struct platform_device *pdev, bool is_compute)
 		mon->miss_ev_id = 0;
 		mon->access_ev_id = 0;
 		mon->wb_ev_id = 0;
+		mon->lat_ev_id = 0;
 		ret = register_compute(dev, hw);
 	} else {
 		mon->miss_ev =
@@ -996,6 +1038,21 @@ static int memlat_mon_probe(struct platform_device *pdev, bool is_compute)
 			}
 		}
 
+		ret = of_property_read_u32(dev->of_node, "qcom,miss-lat-ev",
+					   &event_id);
+		if (ret) {
+			dev_dbg(dev, "Miss latency event not specified. Skipping.\n");
+		} else {
+			mon->lat_ev_id = event_id;
+			mon->lat_ev =
+				devm_kzalloc(dev, num_cpus *
+					     sizeof(*mon->lat_ev), GFP_KERNEL);
+			if (!mon->lat_ev) {
+				ret = -ENOMEM;
+				goto unlock_out;
+			}
+		}
+
 		ret = register_memlat(dev, hw);
 	}
 
@@ -26,6 +26,7 @@
 #include "governor_bw_hwmon.h"
 
 #define NUM_MBPS_ZONES		10
+#define NUM_UNDERPROV_BUCKETS	5
 struct hwmon_node {
 	unsigned int		guard_band_mbps;
 	unsigned int		decay_rate;
@@ -42,6 +43,8 @@ struct hwmon_node {
 	unsigned int		idle_mbps;
 	unsigned int		use_ab;
 	unsigned int		mbps_zones[NUM_MBPS_ZONES];
+	unsigned int		fast_boost;
+	unsigned int		fast_decay;
 
 	unsigned long		prev_ab;
 	unsigned long		*dev_ab;
@@ -56,6 +59,8 @@ struct hwmon_node {
 	unsigned long		hyst_trig_win;
 	unsigned long		hyst_en;
 	unsigned long		prev_req;
+	unsigned long		boost_mbps;
+	u64			underprov_us[NUM_UNDERPROV_BUCKETS];
 	unsigned int		wake;
 	unsigned int		down_cnt;
 	ktime_t			prev_ts;
@@ -174,6 +179,31 @@ static unsigned int mbps_to_bytes(unsigned long mbps, unsigned int ms)
 	return mbps;
 }
 
+/*
+ * Upper bounds, as a percentage of the current vote, of how far the measured
+ * bandwidth overshot the vote in a sample. The last bucket is open ended.
+ */
+static const unsigned int underprov_pct[NUM_UNDERPROV_BUCKETS - 1] = {
+	10, 25, 50, 100,
+};
+
+/* Account @us of a sample that measured @mbps against the current vote. */
+static void account_underprov(struct hwmon_node *node, unsigned long mbps,
+			      unsigned int us)
+{
+	unsigned long over;
+	int i;
+
+	if (!node->prev_ab || mbps <= node->prev_ab)
+		return;
+
+	over = ((mbps - node->prev_ab) * 100) / node->prev_ab;
+	for (i = 0; i < NUM_UNDERPROV_BUCKETS - 1; i++)
+		if (over < underprov_pct[i])
+			break;
+	node->underprov_us[i] += us;
+}
+
 static int __bw_hwmon_sw_sample_end(struct bw_hwmon *hwmon)
 {
 	struct devfreq *df;
@@ -195,6 +225,7 @@ static int __bw_hwmon_sw_sample_end(struct bw_hwmon *hwmon)
 
 	mbps = bytes_to_mbps(bytes, us);
 	node->max_mbps = max(node->max_mbps, mbps);
+	account_underprov(node, mbps, us);
 
 	/*
 	 * If the measured bandwidth in a micro sample is greater than the
@@ -243,6 +274,7 @@ static int __bw_hwmon_hw_sample_end(struct bw_hwmon *hwmon)
 	bytes = hwmon->get_bytes_and_clear(hwmon);
 	mbps = bytes_to_mbps(bytes, node->sample_ms * USEC_PER_MSEC);
 	node->max_mbps = mbps;
+	account_underprov(node, mbps, node->sample_ms * USEC_PER_MSEC);
 
 	if (mbps > node->hw->up_wake_mbps)
 		wake = UP_WAKE;
@@ -370,6 +402,25 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 		req_mbps = min(req_mbps, meas_mbps_zone);
 	}
 
+	/*
+	 * Fast ramp: a wake up IRQ means the vote was overrun within a micro
+	 * sample. Add a boost proportional to the overshoot on top of the
+	 * measurement, beyond the zone limit, so that a burst does not stay
+	 * under-provisioned until the next full window. The boost then decays
+	 * by fast_decay percent on every following decision.
+	 */
+	if (node->wake == UP_WAKE && node->fast_boost &&
+	    meas_mbps > node->prev_req)
+		node->boost_mbps = max(node->boost_mbps,
+				       ((meas_mbps - node->prev_req)
+					* node->fast_boost) / 100);
+	else
+		node->boost_mbps = (node->boost_mbps
+				    * (100 - node->fast_decay)) / 100;
+
+	if (node->boost_mbps)
+		req_mbps = max(req_mbps, meas_mbps + node->boost_mbps);
+
 	hyst_lo_tol = (node->hyst_mbps * HIST_PEAK_TOL) / 100;
 	if (meas_mbps > node->hyst_mbps && meas_mbps > MIN_MBPS) {
 		hyst_lo_tol = (meas_mbps * HIST_PEAK_TOL) / 100;
@@ -789,6 +840,37 @@ static ssize_t sample_ms_show(struct device *dev,
 
 static DEVICE_ATTR_RW(sample_ms);
 
+static ssize_t underprov_hist_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct devfreq *df = to_devfreq(dev);
+	struct hwmon_node *node = df->data;
+	u64 hist[NUM_UNDERPROV_BUCKETS];
+	unsigned long flags;
+	unsigned int cnt = 0;
+	int i;
+
+	spin_lock_irqsave(&irq_lock, flags);
+	memcpy(hist, node->underprov_us, sizeof(hist));
+	spin_unlock_irqrestore(&irq_lock, flags);
+
+	cnt += scnprintf(buf, PAGE_SIZE, "Overshoot (%%)\tTime (us)\n");
+	for (i = 0; i < NUM_UNDERPROV_BUCKETS; i++) {
+		if (i < NUM_UNDERPROV_BUCKETS - 1)
+			cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+					 "<%u\t\t%llu\n", underprov_pct[i],
+					 hist[i]);
+		else
+			cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+					 ">=%u\t\t%llu\n", underprov_pct[i - 1],
+					 hist[i]);
+	}
+
+	return cnt;
+}
+
+static DEVICE_ATTR_RO(underprov_hist);
+
 show_attr(guard_band_mbps);
 store_attr(guard_band_mbps, 0U, 2000U);
 static DEVICE_ATTR_RW(guard_band_mbps);
@@ -831,6 +913,12 @@ static DEVICE_ATTR_RW(use_ab);
 show_list_attr(mbps_zones, NUM_MBPS_ZONES);
 store_list_attr(mbps_zones, NUM_MBPS_ZONES, 0U, UINT_MAX);
 static DEVICE_ATTR_RW(mbps_zones);
+show_attr(fast_boost);
+store_attr(fast_boost, 0U, 500U);
+static DEVICE_ATTR_RW(fast_boost);
+show_attr(fast_decay);
+store_attr(fast_decay, 0U, 100U);
+static DEVICE_ATTR_RW(fast_decay);
 
 static struct attribute *dev_attr[] = {
 	&dev_attr_guard_band_mbps.attr,
@@ -849,6 +937,9 @@ static struct attribute *dev_attr[] = {
 	&dev_attr_use_ab.attr,
 	&dev_attr_mbps_zones.attr,
 	&dev_attr_throttle_adj.attr,
+	&dev_attr_fast_boost.attr,
+	&dev_attr_fast_decay.attr,
+	&dev_attr_underprov_hist.attr,
 	NULL,
 };
 
@@ -996,6 +1087,8 @@ int register_bw_hwmon(struct device *dev, struct bw_hwmon *hwmon)
 	node->idle_mbps = 400;
 	node->use_ab = 1;
 	node->mbps_zones[0] = 0;
+	node->fast_boost = 0;
+	node->fast_decay = 50;
 	node->hw = hwmon;
 
 	mutex_init(&node->mon_lock);
@@ -31,6 +31,8 @@ struct memlat_node {
 	unsigned int		stall_floor;
 	unsigned int		wb_pct_thres;
 	unsigned int		wb_filter_ratio;
+	unsigned int		stall_model;
+	unsigned int		stall_budget;
 	bool			mon_started;
 	bool			already_zero;
 	struct list_head	list;
@@ -119,6 +121,70 @@ static unsigned long core_to_dev_freq(struct memlat_node *node,
 	return freq;
 }
 
+/*
+ * Lowest device frequency in the core-dev table that is at or above @need.
+ * Falls back to the highest entry when nothing in the table is fast enough.
+ */
+static unsigned long lowest_dev_freq_above(struct memlat_node *node,
+					   unsigned long need)
+{
+	struct core_dev_map *map = node->hw->freq_map;
+	unsigned long best = ULONG_MAX, top = 0;
+
+	for (; map->core_mhz; map++) {
+		if (map->target_freq >= need && map->target_freq < best)
+			best = map->target_freq;
+		top = max_t(unsigned long, top, map->target_freq);
+	}
+
+	return best == ULONG_MAX ? top : best;
+}
+
+/*
+ * Stall budget model. The share of cycles a core spends waiting on memory
+ * is taken to be the backend stall percentage, bounded by the share of
+ * cycles with a miss outstanding when the monitor counts that. Only the
+ * memory-bound part is assumed to scale with the device frequency, so at
+ * device frequency f the memory-bound share becomes
+ *
+ *	s(f) = m * cur / f / ((1 - m) + m * cur / f)
+ *
+ * where m is the measured share at the current frequency cur. Solving
+ * s(f) <= budget for f gives the lowest device frequency that keeps the
+ * core within its stall budget.
+ */
+static unsigned long stall_model_freq(struct devfreq *df,
+				      struct dev_stats *stats)
+{
+	struct memlat_node *node = df->data;
+	unsigned long cur = df->previous_freq;
+	unsigned long mem_pct, need, vote;
+	unsigned int budget = node->stall_budget;
+
+	mem_pct = stats->stall_pct;
+	if (stats->lat_pct)
+		mem_pct = min(mem_pct, stats->lat_pct);
+
+	if (!cur)
+		cur = lowest_dev_freq_above(node, ULONG_MAX);
+
+	if (!mem_pct)
+		need = 0;
+	else if (mem_pct >= 100)
+		need = ULONG_MAX;
+	else
+		need = div64_u64((u64)cur * mem_pct * (100 - budget),
+				 (u64)budget * (100 - mem_pct));
+
+	vote = need ? lowest_dev_freq_above(node, need) : 0;
+
+	trace_memlat_stall_model(dev_name(df->dev.parent), stats->id,
+				 stats->stall_pct, stats->lat_pct, mem_pct,
+				 cur, need, vote);
+
+	return vote;
+}
+
 static struct memlat_node *find_memlat_node(struct devfreq *df)
 {
 	struct memlat_node *node, *found = NULL;
@@ -301,6 +367,17 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 					hw->core_stats[i].stall_pct,
 					hw->core_stats[i].wb_pct, ratio);
 
+		if (node->stall_model) {
+			unsigned long f = stall_model_freq(df,
+						&hw->core_stats[i]);
+
+			if (f > max_freq) {
+				lat_dev = i;
+				max_freq = f;
+			}
+			continue;
+		}
+
 		if (((ratio <= node->ratio_ceil
 		      && hw->core_stats[i].stall_pct >= node->stall_floor) ||
 		      (hw->core_stats[i].wb_pct >= node->wb_pct_thres
@@ -311,7 +388,7 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 		}
 	}
 
-	if (max_freq)
+	if (max_freq && !node->stall_model)
 		max_freq = core_to_dev_freq(node, max_freq);
 
 	if (max_freq || !node->already_zero) {
@@ -341,6 +418,12 @@ static DEVICE_ATTR_RW(wb_pct_thres);
 show_attr(wb_filter_ratio);
 store_attr(wb_filter_ratio, 0U, 50000U);
 static DEVICE_ATTR_RW(wb_filter_ratio);
+show_attr(stall_model);
+store_attr(stall_model, 0U, 1U);
+static DEVICE_ATTR_RW(stall_model);
+show_attr(stall_budget);
+store_attr(stall_budget, 1U, 99U);
+static DEVICE_ATTR_RW(stall_budget);
 
 static struct attribute *memlat_dev_attr[] = {
 	&dev_attr_ratio_ceil.attr,
@@ -348,6 +431,8 @@ static struct attribute *memlat_dev_attr[] = {
 	&dev_attr_freq_map.attr,
 	&dev_attr_wb_pct_thres.attr,
 	&dev_attr_wb_filter_ratio.attr,
+	&dev_attr_stall_model.attr,
+	&dev_attr_stall_budget.attr,
 	NULL,
 };
 
@@ -520,6 +605,7 @@ static struct memlat_node *register_common(struct device *dev,
 	node->ratio_ceil = 10;
 	node->wb_pct_thres = 100;
 	node->wb_filter_ratio = 25000;
+	node->stall_budget = 20;
 	node->hw = hw;
 
 	if (hw->get_child_of_node)
@@ -18,6 +18,9 @@
  * @wb_pct:			The ratio of writebacks to accesses. Used as an
  *				indirect way to identify memory latency due to
  *				snoop activity.
+ * @lat_pct:			Percentage of cycles with a miss outstanding at
+ *				the monitored cache level. 0 when the monitor
+ *				has no such counter.
  */
 struct dev_stats {
 	int		id;
@@ -26,6 +29,7 @@ struct dev_stats {
 	unsigned long	freq;
 	unsigned long	stall_pct;
 	unsigned long	wb_pct;
+	unsigned long	lat_pct;
 };
 
 struct core_dev_map {
@@ -65,6 +65,9 @@ int adreno_wake_nice = -7;
 /* Number of milliseconds to stay active active after a wake on touch */
 unsigned int adreno_wake_timeout = 100;
 
+/* Microseconds to spin on the timestamp for KGSL_CONTEXT_BUSY_WAIT waiters */
+unsigned int adreno_busy_wait_us = 200;
+
 static u32 get_ucode_version(const u32 *data)
 {
 	u32 version;
@@ -385,18 +388,12 @@ static void adreno_input_work(struct work_struct *work)
 }
 
 /*
- * Process input events and schedule work if needed.  At this point we are only
- * interested in groking EV_ABS touchscreen events
+ * Start bringing the GPU out of slumber ahead of an expected submission, either
+ * on a touch event or on an explicit KGSL_PROP_GPU_PREWAKE hint
  */
-static void adreno_input_event(struct input_handle *handle, unsigned int type,
-		unsigned int code, int value)
+static void adreno_prewake(struct adreno_device *adreno_dev)
 {
-	struct kgsl_device *device = handle->handler->private;
-	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
-
-	/* Only consider EV_ABS (touch) events */
-	if (type != EV_ABS)
-		return;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 
 	/*
 	 * Don't do anything if anything hasn't been rendered since we've been
@@ -431,6 +428,22 @@ static void adreno_input_event(struct input_handle *handle, unsigned int type,
 	}
 }
 
+/*
+ * Process input events and schedule work if needed.  At this point we are only
+ * interested in groking EV_ABS touchscreen events
+ */
+static void adreno_input_event(struct input_handle *handle, unsigned int type,
+		unsigned int code, int value)
+{
+	struct kgsl_device *device = handle->handler->private;
+
+	/* Only consider EV_ABS (touch) events */
+	if (type != EV_ABS)
+		return;
+
+	adreno_prewake(ADRENO_DEVICE(device));
+}
+
 #ifdef CONFIG_INPUT
 static int adreno_input_connect(struct input_handler *handler,
 		struct input_dev *dev, const struct input_device_id *id)
@@ -2743,6 +2756,42 @@ static int adreno_setproperty(struct kgsl_device_private *dev_priv,
 			kgsl_context_put(context);
 		}
 		break;
+	case KGSL_PROP_CONTEXT_DEADLINE: {
+			struct kgsl_context_deadline deadline;
+			struct kgsl_context *context;
+
+			if (sizebytes != sizeof(deadline))
+				break;
+
+			if (copy_from_user(&deadline, value,
+				sizeof(deadline))) {
+				status = -EFAULT;
+				break;
+			}
+
+			if (deadline.__pad)
+				break;
+
+			context = kgsl_context_get_owner(dev_priv,
+							deadline.context_id);
+
+			if (context == NULL)
+				break;
+
+			WRITE_ONCE(ADRENO_CONTEXT(context)->deadline,
+				deadline.deadline);
+
+			kgsl_context_put(context);
+			status = 0;
+		}
+		break;
+	case KGSL_PROP_GPU_PREWAKE:
+		if (sizebytes)
+			break;
+
+		adreno_prewake(adreno_dev);
+		status = 0;
+		break;
 	default:
 		status = -ENODEV;
 		break;
@@ -905,6 +905,7 @@ extern const struct adreno_gpudev adreno_a6xx_hwsched_gpudev;
 
 extern int adreno_wake_nice;
 extern unsigned int adreno_wake_timeout;
+extern unsigned int adreno_busy_wait_us;
 
 int adreno_start(struct kgsl_device *device, int priority);
 long adreno_ioctl(struct kgsl_device_private *dev_priv,
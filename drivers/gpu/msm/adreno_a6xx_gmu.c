@@ -2930,6 +2930,7 @@ static int a6xx_boot(struct adreno_device *adreno_dev)
 {
 	struct a6xx_gmu_device *gmu = to_a6xx_gmu(adreno_dev);
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	ktime_t start = ktime_get();
 	int ret;
 
 	WARN_ON(test_bit(GMU_PRIV_GPU_STARTED, &gmu->flags));
@@ -2955,6 +2956,8 @@ static int a6xx_boot(struct adreno_device *adreno_dev)
 
 	trace_kgsl_pwr_set_state(device, KGSL_STATE_ACTIVE);
 
+	kgsl_pwrctrl_wake_latency(device, start, false);
+
 	return ret;
 }
 
@@ -3266,6 +3269,7 @@ static void a6xx_gmu_touch_wakeup(struct adreno_device *adreno_dev)
 {
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 	struct a6xx_gmu_device *gmu = to_a6xx_gmu(adreno_dev);
+	ktime_t start = ktime_get();
 	int ret;
 
 	/*
@@ -3298,6 +3302,8 @@ static void a6xx_gmu_touch_wakeup(struct adreno_device *adreno_dev)
 
 	trace_kgsl_pwr_set_state(device, KGSL_STATE_ACTIVE);
 
+	kgsl_pwrctrl_wake_latency(device, start, true);
+
 done:
 	/*
 	 * When waking up from a touch event we want to stay active long enough
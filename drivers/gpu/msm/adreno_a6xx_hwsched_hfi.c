@@ -729,6 +729,8 @@ void a6xx_hwsched_hfi_stop(struct adreno_device *adreno_dev)
 
 	reset_hfi_queues(adreno_dev);
 
+	hfi->pending_irq = 0;
+
 	kgsl_pwrctrl_axi(KGSL_DEVICE(adreno_dev), KGSL_PWRFLAGS_OFF);
 
 	clear_bit(GMU_PRIV_HFI_STARTED, &gmu->flags);
@@ -909,7 +911,6 @@ int a6xx_hwsched_cp_init(struct adreno_device *adreno_dev)
 static void process_ts_retire(struct adreno_device *adreno_dev, u32 *rcvd)
 {
 	log_profiling_info(adreno_dev, rcvd);
-	adreno_hwsched_trigger(adreno_dev);
 }
 
 static void process_ctx_bad(struct adreno_device *adreno_dev, void *rcvd)
@@ -948,6 +949,8 @@ static int hfi_f2h_main(void *arg)
 	struct f2h_packet *pkt, *tmp;
 
 	while (!kthread_should_stop()) {
+		bool retired = false;
+
 		wait_event_interruptible(hfi->f2h_wq,
 			((!llist_empty(&hfi->f2h_msglist) ||
 			  !llist_empty(&hfi->f2h_secondary_list))
@@ -961,8 +964,10 @@ static int hfi_f2h_main(void *arg)
 		list = llist_reverse_order(list);
 
 		llist_for_each_entry_safe(pkt, tmp, list, node) {
-			if (MSG_HDR_GET_ID(pkt->rcvd[0]) == F2H_MSG_TS_RETIRE)
+			if (MSG_HDR_GET_ID(pkt->rcvd[0]) == F2H_MSG_TS_RETIRE) {
 				process_ts_retire(adreno_dev, pkt->rcvd);
+				retired = true;
+			}
 
 			if (MSG_HDR_GET_ID(pkt->rcvd[0]) == F2H_MSG_CONTEXT_BAD)
 				process_ctx_bad(adreno_dev, pkt->rcvd);
@@ -970,6 +975,10 @@ static int hfi_f2h_main(void *arg)
 			kmem_cache_free(f2h_cache, pkt);
 		}
 
+		/* One dispatcher run retires everything the batch completed */
+		if (retired)
+			adreno_hwsched_trigger(adreno_dev);
+
 		/* Process packets on the secondary list after the primary list */
 		list = llist_del_all(&hfi->f2h_secondary_list);
 		list = llist_reverse_order(list);
@@ -1178,6 +1187,7 @@ int a6xx_hwsched_submit_cmdobj(struct adreno_device *adreno_dev,
 	struct kgsl_drawobj_cmd *cmdobj)
 {
 	struct a6xx_hfi *hfi = to_a6xx_hfi(adreno_dev);
+	struct a6xx_hwsched_hfi *hw_hfi = to_a6xx_hwsched_hfi(adreno_dev);
 	struct kgsl_memobj_node *ib;
 	int ret = 0;
 	u32 numibs = 0, cmd_sizebytes;
@@ -1250,19 +1260,15 @@ int a6xx_hwsched_submit_cmdobj(struct adreno_device *adreno_dev,
 	if (ret)
 		goto free;
 
-	/*
-	 * Memory barrier to make sure packet and write index are written before
-	 * an interrupt is raised
-	 */
-	wmb();
-
 	add_profile_events(adreno_dev, drawobj, &time);
 
 	cmdobj->submit_ticks = time.ticks;
 
-	/* Send interrupt to GMU to receive the message */
-	gmu_core_regwrite(KGSL_DEVICE(adreno_dev), A6XX_GMU_HOST2GMU_INTR_SET,
-		DISPQ_IRQ_BIT(drawobj->context->gmu_dispatch_queue));
+	hw_hfi->pending_irq |=
+		DISPQ_IRQ_BIT(drawobj->context->gmu_dispatch_queue);
+
+	if (!hw_hfi->defer_irq)
+		a6xx_hwsched_flush_submits(adreno_dev);
 
 	/* Put the profiling information in the user profiling buffer */
 	adreno_profile_submit_time(&time);
@@ -1273,6 +1279,26 @@ int a6xx_hwsched_submit_cmdobj(struct adreno_device *adreno_dev,
 	return ret;
 }
 
+void a6xx_hwsched_flush_submits(struct adreno_device *adreno_dev)
+{
+	struct a6xx_hwsched_hfi *hfi = to_a6xx_hwsched_hfi(adreno_dev);
+
+	if (!hfi->pending_irq)
+		return;
+
+	/*
+	 * Memory barrier to make sure packets and write indices are written
+	 * before an interrupt is raised
+	 */
+	wmb();
+
+	/* Send interrupt to GMU to receive the messages */
+	gmu_core_regwrite(KGSL_DEVICE(adreno_dev), A6XX_GMU_HOST2GMU_INTR_SET,
+		hfi->pending_irq);
+
+	hfi->pending_irq = 0;
+}
+
 static int send_context_unregister_hfi(struct adreno_device *adreno_dev,
 	struct kgsl_context *context, u32 ts)
 {
@@ -129,6 +129,14 @@ struct a6xx_hwsched_hfi {
 	struct llist_head f2h_secondary_list;
 	/** @f2h_wq: Waitqueue for the f2h_task */
 	wait_queue_head_t f2h_wq;
+	/**
+	 * @defer_irq: Set while the dispatcher batches submissions. Packets
+	 * are only written to the dispatch queues and the GMU is interrupted
+	 * for all of them by a6xx_hwsched_flush_submits()
+	 */
+	bool defer_irq;
+	/** @pending_irq: Dispatch queue interrupt bits not yet sent to GMU */
+	u32 pending_irq;
 };
 
 struct kgsl_drawobj_cmd;
@@ -206,6 +214,16 @@ int a6xx_hfi_send_cmd_async(struct adreno_device *adreno_dev, void *data);
 int a6xx_hwsched_submit_cmdobj(struct adreno_device *adreno_dev,
 	struct kgsl_drawobj_cmd *cmdobj);
 
+/**
+ * a6xx_hwsched_flush_submits - Tell GMU about batched submissions
+ * @adreno_dev: Pointer to adreno device structure
+ *
+ * Interrupt the GMU once for every dispatch queue that got packets while
+ * submissions were deferred. This function must be called with the device
+ * mutex held.
+ */
+void a6xx_hwsched_flush_submits(struct adreno_device *adreno_dev);
+
 /**
  * a6xx_hwsched_context_detach - Unregister a context with GMU
  * @drawctxt: Pointer to the adreno context
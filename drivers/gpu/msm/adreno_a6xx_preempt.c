@@ -214,26 +214,47 @@ static void _a6xx_preemption_worker(struct work_struct *work)
 	mutex_unlock(&device->mutex);
 }
 
-/* Find the highest priority active ringbuffer */
+/*
+ * Find the highest priority active ringbuffer, unless a lower priority one
+ * holds work whose deadline falls within the deadline window. In that case
+ * the active ringbuffer with the earliest deadline goes first.
+ */
 static struct adreno_ringbuffer *a6xx_next_ringbuffer(
 		struct adreno_device *adreno_dev)
 {
-	struct adreno_ringbuffer *rb;
+	struct adreno_ringbuffer *rb, *next = NULL, *urgent = NULL;
+	u64 limit, urgent_deadline = 0;
 	unsigned long flags;
 	unsigned int i;
 
+	limit = ktime_get_ns() +
+		(u64) READ_ONCE(adreno_deadline_window) * NSEC_PER_MSEC;
+
 	FOR_EACH_RINGBUFFER(adreno_dev, rb, i) {
 		bool empty;
+		u64 deadline;
 
 		spin_lock_irqsave(&rb->preempt_lock, flags);
 		empty = adreno_rb_empty(rb);
+		if (empty)
+			rb->deadline = 0;
+		deadline = rb->deadline;
 		spin_unlock_irqrestore(&rb->preempt_lock, flags);
 
-		if (!empty)
-			return rb;
+		if (empty)
+			continue;
+
+		if (!next)
+			next = rb;
+
+		if (deadline && deadline <= limit &&
+			(!urgent || deadline < urgent_deadline)) {
+			urgent = rb;
+			urgent_deadline = deadline;
+		}
 	}
 
-	return NULL;
+	return urgent ? urgent : next;
 }
 
 void a6xx_preemption_trigger(struct adreno_device *adreno_dev)
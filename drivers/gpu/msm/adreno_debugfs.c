@@ -4,8 +4,11 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
 
 #include "adreno.h"
+#include "adreno_pm4types.h"
 extern struct dentry *kgsl_debugfs_dir;
 
 static void set_isdb(struct adreno_device *adreno_dev, void *priv)
@@ -362,6 +365,356 @@ adreno_context_debugfs_init(struct adreno_device *adreno_dev,
 				adreno_dev->ctx_d_debugfs, ctx, &ctx_fops);
 }
 
+/*
+ * Submission microbenchmark: creates internal contexts on a kernel opened
+ * instance of the device and queues streams of NOP IBs through the
+ * dispatcher to measure the CPU cost of queue_cmds(), the time spent in
+ * adreno_ringbuffer_submitcmd(), submit to retire latency and the time from
+ * the retire event to the waiter running again.
+ */
+#define SUBMIT_BENCH_MAX_SUBMITS	10000
+#define SUBMIT_BENCH_MAX_CONTEXTS	8
+#define SUBMIT_BENCH_TIMEOUT_MS		1000
+
+struct submit_bench_sample {
+	struct completion done;
+	u64 start;
+	u64 queued;
+	u64 retired;
+	u64 woken;
+	int result;
+};
+
+struct submit_bench_stat {
+	u32 count;
+	u64 avg;
+	u64 p50;
+	u64 p90;
+	u64 p99;
+	u64 max;
+};
+
+static struct {
+	struct mutex lock;
+	struct kgsl_memdesc *ib;
+	u32 submits;
+	u32 ib_dwords;
+	u32 ibs;
+	u32 contexts;
+	bool serial;
+	int err;
+	u32 completed;
+	u64 wall_ns;
+	u64 rb_ns;
+	u64 rb_submits;
+	struct submit_bench_stat queue;
+	struct submit_bench_stat retire;
+	struct submit_bench_stat wake;
+} submit_bench = {
+	.submits = 1000,
+	.ib_dwords = 4,
+	.ibs = 1,
+	.contexts = 1,
+	.serial = true,
+};
+
+static int submit_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void submit_bench_stat(struct submit_bench_stat *stat, u64 *vals,
+		u32 count)
+{
+	u64 total = 0;
+	u32 i;
+
+	memset(stat, 0, sizeof(*stat));
+	if (!count)
+		return;
+
+	sort(vals, count, sizeof(*vals), submit_bench_cmp, NULL);
+
+	for (i = 0; i < count; i++)
+		total += vals[i];
+
+	stat->count = count;
+	stat->avg = div_u64(total, count);
+	stat->p50 = vals[count / 2];
+	stat->p90 = vals[(u64)count * 90 / 100];
+	stat->p99 = vals[(u64)count * 99 / 100];
+	stat->max = vals[count - 1];
+}
+
+static void submit_bench_retired(struct kgsl_device *device,
+		struct kgsl_event_group *group, void *priv, int result)
+{
+	struct submit_bench_sample *sample = priv;
+
+	sample->retired = local_clock();
+	sample->result = result;
+	complete(&sample->done);
+}
+
+static int submit_bench_one(struct kgsl_device_private *dev_priv,
+		struct kgsl_context *context, struct submit_bench_sample *sample)
+{
+	struct kgsl_device *device = dev_priv->device;
+	struct kgsl_drawobj_cmd *cmdobj;
+	struct kgsl_drawobj *drawobj;
+	struct kgsl_ibdesc ibdesc;
+	u32 i, timestamp;
+	int ret;
+
+	cmdobj = kgsl_drawobj_cmd_create(device, context, 0, CMDOBJ_TYPE);
+	if (IS_ERR(cmdobj))
+		return PTR_ERR(cmdobj);
+
+	drawobj = DRAWOBJ(cmdobj);
+
+	for (i = 0; i < submit_bench.ibs; i++) {
+		memset(&ibdesc, 0, sizeof(ibdesc));
+		ibdesc.gpuaddr = submit_bench.ib->gpuaddr;
+		ibdesc.sizedwords = submit_bench.ib_dwords;
+
+		ret = kgsl_drawobj_cmd_add_ibdesc(device, cmdobj, &ibdesc);
+		if (ret) {
+			kgsl_drawobj_destroy(drawobj);
+			return ret;
+		}
+	}
+
+	init_completion(&sample->done);
+
+	sample->start = local_clock();
+	ret = device->ftbl->queue_cmds(dev_priv, context, &drawobj, 1,
+		&timestamp);
+	sample->queued = local_clock();
+
+	if (ret) {
+		kgsl_drawobj_destroy(drawobj);
+		return ret;
+	}
+
+	return kgsl_add_event(device, &context->events, timestamp,
+		submit_bench_retired, sample);
+}
+
+static void submit_bench_wait(struct submit_bench_sample *sample)
+{
+	if (wait_for_completion_timeout(&sample->done,
+			msecs_to_jiffies(SUBMIT_BENCH_TIMEOUT_MS)))
+		sample->woken = local_clock();
+}
+
+static void submit_bench_report(struct submit_bench_sample *samples, u32 n)
+{
+	u64 *vals;
+	u32 i, count;
+
+	vals = vmalloc(array_size(n ? n : 1, sizeof(*vals)));
+	if (!vals)
+		return;
+
+	for (i = 0; i < n; i++)
+		vals[i] = samples[i].queued - samples[i].start;
+	submit_bench_stat(&submit_bench.queue, vals, n);
+
+	for (i = 0, count = 0; i < n; i++)
+		if (samples[i].result == KGSL_EVENT_RETIRED)
+			vals[count++] = samples[i].retired - samples[i].start;
+	submit_bench_stat(&submit_bench.retire, vals, count);
+	submit_bench.completed = count;
+
+	for (i = 0, count = 0; i < n; i++)
+		if (samples[i].result == KGSL_EVENT_RETIRED &&
+				samples[i].woken)
+			vals[count++] = samples[i].woken - samples[i].retired;
+	submit_bench_stat(&submit_bench.wake, vals, count);
+
+	vfree(vals);
+}
+
+static int submit_bench_run(struct kgsl_device *device)
+{
+	struct adreno_dispatcher *dispatcher =
+		&ADRENO_DEVICE(device)->dispatcher;
+	struct kgsl_context *contexts[SUBMIT_BENCH_MAX_CONTEXTS] = { NULL };
+	struct submit_bench_sample *samples;
+	struct kgsl_device_private *dev_priv;
+	struct kgsl_context *context;
+	u64 rb_ns, rb_submits;
+	struct file *filp;
+	char path[32];
+	u32 i, n = 0;
+	int ret = 0;
+
+	if (!submit_bench.submits ||
+		submit_bench.submits > SUBMIT_BENCH_MAX_SUBMITS ||
+		!submit_bench.ibs || !submit_bench.ib_dwords ||
+		submit_bench.ib_dwords > PAGE_SIZE >> 2 ||
+		!submit_bench.contexts ||
+		submit_bench.contexts > SUBMIT_BENCH_MAX_CONTEXTS)
+		return -EINVAL;
+
+	samples = vzalloc(array_size(submit_bench.submits, sizeof(*samples)));
+	if (!samples)
+		return -ENOMEM;
+
+	/* Use a regular open so the contexts get a process and pagetable */
+	snprintf(path, sizeof(path), "/dev/%s", device->name);
+	filp = filp_open(path, O_RDWR, 0);
+	if (IS_ERR(filp)) {
+		vfree(samples);
+		return PTR_ERR(filp);
+	}
+
+	dev_priv = filp->private_data;
+
+	for (i = 0; i < submit_bench.contexts; i++) {
+		u32 flags = KGSL_CONTEXT_PREAMBLE | KGSL_CONTEXT_NO_GMEM_ALLOC |
+			KGSL_CONTEXT_NO_SNAPSHOT;
+
+		context = device->ftbl->drawctxt_create(dev_priv, &flags);
+		if (IS_ERR(context)) {
+			ret = PTR_ERR(context);
+			goto done;
+		}
+
+		write_lock(&device->context_lock);
+		idr_replace(&device->context_idr, context, context->id);
+		write_unlock(&device->context_lock);
+
+		contexts[i] = context;
+	}
+
+	rb_ns = READ_ONCE(dispatcher->submit_ns);
+	rb_submits = READ_ONCE(dispatcher->submits);
+	submit_bench.wall_ns = local_clock();
+
+	for (n = 0; n < submit_bench.submits; n++) {
+		ret = submit_bench_one(dev_priv,
+			contexts[n % submit_bench.contexts], &samples[n]);
+		if (ret)
+			break;
+
+		if (submit_bench.serial)
+			submit_bench_wait(&samples[n]);
+	}
+
+	if (!submit_bench.serial)
+		for (i = 0; i < n; i++)
+			wait_for_completion_timeout(&samples[i].done,
+				msecs_to_jiffies(SUBMIT_BENCH_TIMEOUT_MS));
+
+	submit_bench.wall_ns = local_clock() - submit_bench.wall_ns;
+	submit_bench.rb_ns = READ_ONCE(dispatcher->submit_ns) - rb_ns;
+	submit_bench.rb_submits = READ_ONCE(dispatcher->submits) - rb_submits;
+
+done:
+	/*
+	 * Detaching cancels any outstanding events. The callbacks run from the
+	 * events workqueue so flush it before the samples go away.
+	 */
+	for (i = 0; i < submit_bench.contexts && contexts[i]; i++)
+		kgsl_context_detach(contexts[i]);
+
+	flush_workqueue(device->events_wq);
+	filp_close(filp, NULL);
+
+	submit_bench_report(samples, n);
+	vfree(samples);
+
+	return ret;
+}
+
+static ssize_t submit_bench_run_write(struct file *file,
+		const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	struct kgsl_device *device = file->private_data;
+	int ret;
+
+	mutex_lock(&submit_bench.lock);
+	ret = submit_bench_run(device);
+	submit_bench.err = ret;
+	mutex_unlock(&submit_bench.lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations submit_bench_run_fops = {
+	.open = simple_open,
+	.write = submit_bench_run_write,
+	.llseek = no_llseek,
+};
+
+static void submit_bench_print(struct seq_file *s, const char *name,
+		struct submit_bench_stat *stat)
+{
+	seq_printf(s, "%-8s n=%u avg=%llu p50=%llu p90=%llu p99=%llu max=%llu\n",
+		name, stat->count, stat->avg, stat->p50, stat->p90, stat->p99,
+		stat->max);
+}
+
+static int submit_bench_results_show(struct seq_file *s, void *unused)
+{
+	mutex_lock(&submit_bench.lock);
+
+	seq_printf(s, "err: %d retired: %u wall: %llu ns\n", submit_bench.err,
+		submit_bench.completed, submit_bench.wall_ns);
+	if (submit_bench.wall_ns)
+		seq_printf(s, "submits/sec: %llu\n",
+			div64_u64((u64)submit_bench.queue.count * NSEC_PER_SEC,
+				submit_bench.wall_ns));
+	if (submit_bench.rb_submits)
+		seq_printf(s, "ringbuffer submitcmd: n=%llu avg=%llu ns\n",
+			submit_bench.rb_submits,
+			div64_u64(submit_bench.rb_ns,
+				submit_bench.rb_submits));
+
+	seq_puts(s, "latencies in ns:\n");
+	submit_bench_print(s, "queue", &submit_bench.queue);
+	submit_bench_print(s, "retire", &submit_bench.retire);
+	submit_bench_print(s, "wake", &submit_bench.wake);
+
+	mutex_unlock(&submit_bench.lock);
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(submit_bench_results);
+
+static void submit_bench_init(struct adreno_device *adreno_dev)
+{
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	struct dentry *dir;
+	u32 *cmds;
+	int i;
+
+	submit_bench.ib = kgsl_allocate_global(device, PAGE_SIZE, 0,
+		KGSL_MEMFLAGS_GPUREADONLY, 0, "submit_bench_ib");
+	if (IS_ERR(submit_bench.ib))
+		return;
+
+	/* Every dword is an empty NOP so any IB length up to a page works */
+	cmds = submit_bench.ib->hostptr;
+	for (i = 0; i < PAGE_SIZE >> 2; i++)
+		cmds[i] = cp_packet(adreno_dev, CP_NOP, 0);
+
+	mutex_init(&submit_bench.lock);
+
+	dir = debugfs_create_dir("submit_bench", device->d_debugfs);
+	debugfs_create_u32("submits", 0644, dir, &submit_bench.submits);
+	debugfs_create_u32("ib_dwords", 0644, dir, &submit_bench.ib_dwords);
+	debugfs_create_u32("ibs", 0644, dir, &submit_bench.ibs);
+	debugfs_create_u32("contexts", 0644, dir, &submit_bench.contexts);
+	debugfs_create_bool("serial", 0644, dir, &submit_bench.serial);
+	debugfs_create_file("run", 0200, dir, device, &submit_bench_run_fops);
+	debugfs_create_file("results", 0444, dir, NULL,
+		&submit_bench_results_fops);
+}
+
 void adreno_debugfs_init(struct adreno_device *adreno_dev)
 {
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
@@ -390,4 +743,6 @@ void adreno_debugfs_init(struct adreno_device *adreno_dev)
 	if (adreno_is_a5xx(adreno_dev))
 		debugfs_create_file("isdb", 0644, device->d_debugfs,
 			device, &_isdb_fops);
+
+	submit_bench_init(adreno_dev);
 }
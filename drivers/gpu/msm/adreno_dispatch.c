@@ -23,6 +23,9 @@ static unsigned int _context_queue_wait = 10000;
 /* Number of drawobjs sent at a time from a single context */
 static unsigned int _context_drawobj_burst = 5;
 
+/* Number of drawobjs from a context sharing one ringbuffer wptr write */
+static unsigned int _context_coalesce_count = 5;
+
 /*
  * GFT throttle parameters. If GFT recovered more than
  * X times in Y ms invalidate the context and do not attempt recovery.
@@ -47,6 +50,12 @@ static unsigned int _dispatcher_q_inflight_lo = 4;
 /* Command batch timeout (in milliseconds) */
 unsigned int adreno_drawobj_timeout = 2000;
 
+/*
+ * Milliseconds before a context deadline at which its ringbuffer may preempt
+ * higher priority ringbuffers
+ */
+unsigned int adreno_deadline_window = 4;
+
 /* Interval for reading and comparing fault detection registers */
 static unsigned int _fault_timer_interval = 200;
 
@@ -562,15 +571,68 @@ static int dispatcher_queue_context(struct adreno_device *adreno_dev,
 	return 0;
 }
 
+/*
+ * Commands that were replayed or skipped after a fault, that need a wait for
+ * idle or that are profiled get a ringbuffer submission of their own. The
+ * rest can share a single wptr update with the other commands of a burst.
+ */
+static bool _cmdobj_can_coalesce(struct adreno_device *adreno_dev,
+		struct kgsl_drawobj_cmd *cmdobj)
+{
+	if (cmdobj->fault_recovery || test_bit(CMDOBJ_SKIP, &cmdobj->priv) ||
+		test_bit(CMDOBJ_WFI, &cmdobj->priv) ||
+		test_bit(CMDOBJ_FAULT, &cmdobj->priv))
+		return false;
+
+	if ((DRAWOBJ(cmdobj)->flags & KGSL_DRAWOBJ_PROFILING) ||
+		test_bit(ADRENO_DEVICE_DRAWOBJ_PROFILE, &adreno_dev->priv))
+		return false;
+
+	return true;
+}
+
 /**
  * sendcmd() - Send a drawobj to the GPU hardware
  * @dispatcher: Pointer to the adreno dispatcher struct
  * @drawobj: Pointer to the KGSL drawobj being sent
+ * @defer: Leave the wptr update to adreno_ringbuffer_flush_wptr()
  *
  * Send a KGSL drawobj to the GPU hardware
  */
+/*
+ * Deadlines that are this far in the past are stale, the context stopped
+ * updating them so treat it as a regular context again
+ */
+#define DEADLINE_STALE_NS NSEC_PER_SEC
+
+static u64 _drawctxt_deadline(struct adreno_context *drawctxt, u64 now)
+{
+	u64 deadline = READ_ONCE(drawctxt->deadline);
+
+	if (!deadline || deadline + DEADLINE_STALE_NS < now)
+		return 0;
+
+	return deadline;
+}
+
+/* Remember the earliest deadline submitted to the ringbuffer for preemption */
+static void _rb_update_deadline(struct adreno_context *drawctxt)
+{
+	struct adreno_ringbuffer *rb = drawctxt->rb;
+	u64 deadline = _drawctxt_deadline(drawctxt, ktime_get_ns());
+	unsigned long flags;
+
+	if (!deadline)
+		return;
+
+	spin_lock_irqsave(&rb->preempt_lock, flags);
+	if (!rb->deadline || deadline < rb->deadline)
+		rb->deadline = deadline;
+	spin_unlock_irqrestore(&rb->preempt_lock, flags);
+}
+
 static int sendcmd(struct adreno_device *adreno_dev,
-	struct kgsl_drawobj_cmd *cmdobj)
+	struct kgsl_drawobj_cmd *cmdobj, bool defer)
 {
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 	struct kgsl_drawobj *drawobj = DRAWOBJ(cmdobj);
@@ -585,6 +647,7 @@ static int sendcmd(struct adreno_device *adreno_dev,
 	unsigned long nsecs = 0;
 	int ret;
 	struct submission_info info = {0};
+	u64 start;
 
 	mutex_lock(&device->mutex);
 	if (adreno_gpu_halt(adreno_dev) != 0) {
@@ -619,7 +682,12 @@ static int sendcmd(struct adreno_device *adreno_dev,
 			ADRENO_DRAWOBJ_PROFILE_COUNT;
 	}
 
+	drawctxt->rb->defer_wptr = defer;
+	start = local_clock();
 	ret = adreno_ringbuffer_submitcmd(adreno_dev, cmdobj, &time);
+	dispatcher->submit_ns += local_clock() - start;
+	dispatcher->submits++;
+	drawctxt->rb->defer_wptr = false;
 
 	/*
 	 * On the first command, if the submission was successful, then read the
@@ -679,6 +747,8 @@ static int sendcmd(struct adreno_device *adreno_dev,
 		return ret;
 	}
 
+	_rb_update_deadline(drawctxt);
+
 	secs = time.ktime;
 	nsecs = do_div(secs, 1000000000);
 
@@ -754,6 +824,7 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 	int ret = 0;
 	int inflight = _drawqueue_inflight(dispatch_q);
 	unsigned int timestamp;
+	unsigned int deferred = 0;
 
 	if (dispatch_q->inflight >= inflight) {
 		spin_lock(&drawctxt->lock);
@@ -769,6 +840,7 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 		(dispatch_q->inflight < inflight)) {
 		struct kgsl_drawobj *drawobj;
 		struct kgsl_drawobj_cmd *cmdobj;
+		bool coalesce;
 
 		if (adreno_gpu_fault(adreno_dev) != 0)
 			break;
@@ -794,7 +866,9 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 
 		timestamp = drawobj->timestamp;
 		cmdobj = CMDOBJ(drawobj);
-		ret = sendcmd(adreno_dev, cmdobj);
+		coalesce = (deferred + 1 < _context_coalesce_count) &&
+			_cmdobj_can_coalesce(adreno_dev, cmdobj);
+		ret = sendcmd(adreno_dev, cmdobj, coalesce);
 
 		/*
 		 * On error from sendcmd() try to requeue the cmdobj
@@ -821,9 +895,26 @@ static int dispatcher_context_sendcmds(struct adreno_device *adreno_dev,
 
 		drawctxt->submitted_timestamp = timestamp;
 
+		/* A regular submission also publishes the deferred ones */
+		deferred = coalesce ? deferred + 1 : 0;
+
 		count++;
 	}
 
+	/* Let the hardware see the whole burst with a single wptr write */
+	if (deferred) {
+		struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+		const struct adreno_gpudev *gpudev =
+			ADRENO_GPU_DEVICE(adreno_dev);
+
+		mutex_lock(&device->mutex);
+		adreno_ringbuffer_flush_wptr(drawctxt->rb);
+		mutex_unlock(&device->mutex);
+
+		if (gpudev->preemption_schedule)
+			gpudev->preemption_schedule(adreno_dev);
+	}
+
 	/*
 	 * Wake up any snoozing threads if we have consumed any real commands
 	 * or marker commands and we have room in the context queue.
@@ -850,6 +941,47 @@ static bool adreno_gpu_stopped(struct adreno_device *adreno_dev)
 	return (adreno_gpu_fault(adreno_dev) || adreno_gpu_halt(adreno_dev));
 }
 
+/*
+ * Order a job list so that contexts with a deadline go first, earliest
+ * deadline first, followed by the rest of the jobs in their original order
+ */
+static struct llist_node *_jobs_by_deadline(struct llist_node *list)
+{
+	struct llist_node *sorted = NULL, *rest = NULL;
+	struct llist_node **tail = &rest, **pos;
+	struct adreno_dispatch_job *job, *next;
+	u64 now = ktime_get_ns();
+
+	llist_for_each_entry_safe(job, next, list, node) {
+		job->deadline = _drawctxt_deadline(job->drawctxt, now);
+		job->node.next = NULL;
+
+		if (!job->deadline) {
+			*tail = &job->node;
+			tail = &job->node.next;
+			continue;
+		}
+
+		/* Equal deadlines keep their order so nobody gets starved */
+		for (pos = &sorted; *pos; pos = &(*pos)->next) {
+			struct adreno_dispatch_job *cur = llist_entry(*pos,
+				struct adreno_dispatch_job, node);
+
+			if (job->deadline < cur->deadline)
+				break;
+		}
+
+		job->node.next = *pos;
+		*pos = &job->node;
+	}
+
+	for (pos = &sorted; *pos; pos = &(*pos)->next)
+		;
+	*pos = rest;
+
+	return sorted;
+}
+
 static void dispatcher_handle_jobs_list(struct adreno_device *adreno_dev,
 		int id, unsigned long *map, struct llist_node *list)
 {
@@ -862,6 +994,8 @@ static void dispatcher_handle_jobs_list(struct adreno_device *adreno_dev,
 	/* Reverse the order so the oldest context is considered first */
 	list = llist_reverse_order(list);
 
+	list = _jobs_by_deadline(list);
+
 	llist_for_each_entry_safe(job, next, list, node) {
 		int ret;
 
@@ -2031,7 +2165,7 @@ static void recover_dispatch_q(struct kgsl_device *device,
 
 		set_bit(CMDOBJ_WFI, &replay[i]->priv);
 
-		ret = sendcmd(adreno_dev, replay[i]);
+		ret = sendcmd(adreno_dev, replay[i], false);
 
 		/*
 		 * If sending the command fails, then try to recover by
@@ -2358,8 +2492,10 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 			       context->id, drawobj->timestamp,
 			       !!(drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME));
 
-	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME)
+	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME) {
 		atomic64_inc(&context->proc_priv->frame_count);
+		kgsl_pwrscale_frame_retired(KGSL_DEVICE(adreno_dev));
+	}
 
 	/*
 	 * For A3xx we still get the rptr from the CP_RB_RPTR instead of
@@ -2909,8 +3045,11 @@ static DISPATCHER_UINT_ATTR(context_drawqueue_size, 0644,
 	ADRENO_CONTEXT_DRAWQUEUE_SIZE - 1, _context_drawqueue_size);
 static DISPATCHER_UINT_ATTR(context_burst_count, 0644, 0,
 	_context_drawobj_burst);
+static DISPATCHER_UINT_ATTR(context_coalesce_count, 0644,
+	ADRENO_DISPATCH_DRAWQUEUE_SIZE, _context_coalesce_count);
 static DISPATCHER_UINT_ATTR(drawobj_timeout, 0644, 0,
 	adreno_drawobj_timeout);
+static DISPATCHER_UINT_ATTR(deadline_window, 0644, 0, adreno_deadline_window);
 static DISPATCHER_UINT_ATTR(context_queue_wait, 0644, 0, _context_queue_wait);
 static DISPATCHER_UINT_ATTR(fault_detect_interval, 0644, 0,
 	_fault_timer_interval);
@@ -2924,7 +3063,9 @@ static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_inflight_low_latency.attr,
 	&dispatcher_attr_context_drawqueue_size.attr,
 	&dispatcher_attr_context_burst_count.attr,
+	&dispatcher_attr_context_coalesce_count.attr,
 	&dispatcher_attr_drawobj_timeout.attr,
+	&dispatcher_attr_deadline_window.attr,
 	&dispatcher_attr_context_queue_wait.attr,
 	&dispatcher_attr_fault_detect_interval.attr,
 	&dispatcher_attr_fault_throttle_time.attr,
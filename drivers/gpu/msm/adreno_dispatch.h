@@ -11,6 +11,7 @@
 #include <linux/llist.h>
 
 extern unsigned int adreno_drawobj_timeout;
+extern unsigned int adreno_deadline_window;
 
 /*
  * Maximum size of the dispatcher ringbuffer - the actual inflight size will be
@@ -44,6 +45,7 @@ struct adreno_dispatcher_drawqueue {
  * struct adreno_dispatch_job - An instance of work for the dispatcher
  * @node: llist node for the list of jobs
  * @drawctxt: A pointer to an adreno draw context
+ * @deadline: Deadline of @drawctxt sampled when the job list is sorted
  *
  * This struct defines work for the dispatcher. When a drawctxt is ready to send
  * commands it will attach itself to the appropriate list for it's priority.
@@ -53,6 +55,7 @@ struct adreno_dispatcher_drawqueue {
 struct adreno_dispatch_job {
 	struct llist_node node;
 	struct adreno_context *drawctxt;
+	u64 deadline;
 };
 
 /**
@@ -81,6 +84,10 @@ struct adreno_dispatcher {
 	struct kthread_work work;
 	struct kobject kobj;
 	struct completion idle_gate;
+	/** @submit_ns: Total time spent in adreno_ringbuffer_submitcmd() */
+	u64 submit_ns;
+	/** @submits: Number of submissions accounted in @submit_ns */
+	u64 submits;
 };
 
 enum adreno_dispatcher_flags {
@@ -4,6 +4,7 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/sched/signal.h>
 
 #include "adreno.h"
 #include "adreno_iommu.h"
@@ -27,6 +28,40 @@ static int _check_context_timestamp(struct kgsl_device *device,
 	return kgsl_check_timestamp(device, context, timestamp);
 }
 
+/* Upper bound for adreno_busy_wait_us so a bad value can't hog a CPU */
+#define BUSY_WAIT_MAX_US 2000
+
+/*
+ * Spin on the memstore retired timestamp for up to adreno_busy_wait_us
+ * before falling back to the interrupt driven wait. Work that finishes
+ * within a few hundred microseconds is then seen without paying for the
+ * retire interrupt and the wakeup of the sleeping waiter.
+ */
+static bool _busy_wait_timestamp(struct kgsl_device *device,
+		struct kgsl_context *context, unsigned int timestamp)
+{
+	unsigned int usecs = min_t(unsigned int, READ_ONCE(adreno_busy_wait_us),
+		BUSY_WAIT_MAX_US);
+	ktime_t end;
+
+	if (!usecs)
+		return false;
+
+	end = ktime_add_us(ktime_get(), usecs);
+
+	do {
+		if (_check_context_timestamp(device, context, timestamp))
+			return true;
+
+		if (need_resched() || signal_pending(current))
+			break;
+
+		cpu_relax();
+	} while (ktime_before(ktime_get(), end));
+
+	return false;
+}
+
 /**
  * adreno_drawctxt_dump() - dump information about a draw context
  * @device: KGSL device that owns the context
@@ -152,6 +187,12 @@ int adreno_drawctxt_wait(struct adreno_device *adreno_dev,
 
 	trace_adreno_drawctxt_wait_start(-1, context->id, timestamp);
 
+	if ((context->flags & KGSL_CONTEXT_BUSY_WAIT) &&
+		_busy_wait_timestamp(device, context, timestamp)) {
+		ret = 0;
+		goto check;
+	}
+
 	ret = kgsl_add_event(device, &context->events, timestamp,
 		wait_callback, (void *) drawctxt);
 	if (ret)
@@ -177,6 +218,7 @@ int adreno_drawctxt_wait(struct adreno_device *adreno_dev,
 	}
 	ret = 0;
 
+check:
 	/* -EDEADLK if the context was invalidated while we were waiting */
 	if (kgsl_context_invalid(context))
 		ret = -EDEADLK;
@@ -321,6 +363,7 @@ adreno_drawctxt_create(struct kgsl_device_private *dev_priv,
 		KGSL_CONTEXT_USER_GENERATED_TS |
 		KGSL_CONTEXT_NO_FAULT_TOLERANCE |
 		KGSL_CONTEXT_INVALIDATE_ON_FAULT |
+		KGSL_CONTEXT_BUSY_WAIT |
 		KGSL_CONTEXT_CTX_SWITCH |
 		KGSL_CONTEXT_PRIORITY_MASK |
 		KGSL_CONTEXT_TYPE_MASK |
@@ -47,6 +47,8 @@ struct kgsl_device_private;
  *		 be written.
  * @active_node: Linkage for nodes in active_list
  * @active_time: Time when this context last seen
+ * @deadline: CLOCK_MONOTONIC time in ns the context's queued work should
+ * retire by, 0 if the context doesn't use deadline scheduling
  */
 struct adreno_context {
 	struct kgsl_context base;
@@ -75,6 +77,7 @@ struct adreno_context {
 
 	struct list_head active_node;
 	unsigned long active_time;
+	u64 deadline;
 };
 
 /* Flag definitions for flag field in adreno_context */
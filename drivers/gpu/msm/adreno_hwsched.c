@@ -31,6 +31,9 @@ static u32 _context_drawqueue_size = ADRENO_CONTEXT_DRAWQUEUE_SIZE - 1;
 /* Number of milliseconds to wait for the context queue to clear */
 static unsigned int _context_queue_wait = 10000;
 
+/* Number of drawobjs from a context sharing one GMU interrupt */
+static unsigned int _context_submit_batch = 8;
+
 /* Use a kmem cache to speed up allocations for dispatcher jobs */
 static struct kmem_cache *jobs_cache;
 /* Use a kmem cache to speed up allocations for inflight command objects */
@@ -307,12 +310,14 @@ static bool hwsched_in_fault(struct adreno_hwsched *hwsched)
  * sendcmd() - Send a drawobj to the GPU hardware
  * @dispatcher: Pointer to the adreno dispatcher struct
  * @drawobj: Pointer to the KGSL drawobj being sent
+ * @defer: Only queue the packet, a6xx_hwsched_flush_submits() tells the GMU
  *
  * Send a KGSL drawobj to the GPU hardware
  */
 static int hwsched_sendcmd(struct adreno_device *adreno_dev,
-	struct kgsl_drawobj_cmd *cmdobj)
+	struct kgsl_drawobj_cmd *cmdobj, bool defer)
 {
+	struct a6xx_hwsched_hfi *hfi = to_a6xx_hwsched_hfi(adreno_dev);
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
 	struct adreno_hwsched *hwsched = to_hwsched(adreno_dev);
 	struct kgsl_drawobj *drawobj = DRAWOBJ(cmdobj);
@@ -354,7 +359,9 @@ static int hwsched_sendcmd(struct adreno_device *adreno_dev,
 		set_bit(ADRENO_HWSCHED_POWER, &hwsched->flags);
 	}
 
+	hfi->defer_irq = defer;
 	ret = a6xx_hwsched_submit_cmdobj(adreno_dev, cmdobj);
+	hfi->defer_irq = false;
 	if (ret) {
 		/*
 		 * If the first submission failed, then put back the active
@@ -429,7 +436,8 @@ static int hwsched_sendcmds(struct adreno_device *adreno_dev,
 
 		timestamp = drawobj->timestamp;
 		cmdobj = CMDOBJ(drawobj);
-		ret = hwsched_sendcmd(adreno_dev, cmdobj);
+		ret = hwsched_sendcmd(adreno_dev, cmdobj,
+			(count + 1) % _context_submit_batch);
 
 		/*
 		 * On error from hwsched_sendcmd() try to requeue the cmdobj
@@ -459,6 +467,15 @@ static int hwsched_sendcmds(struct adreno_device *adreno_dev,
 		count++;
 	}
 
+	/* Interrupt the GMU for whatever is left of the last batch */
+	if (count % _context_submit_batch) {
+		struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+
+		mutex_lock(&device->mutex);
+		a6xx_hwsched_flush_submits(adreno_dev);
+		mutex_unlock(&device->mutex);
+	}
+
 	/*
 	 * Wake up any snoozing threads if we have consumed any real commands
 	 * or marker commands and we have room in the context queue.
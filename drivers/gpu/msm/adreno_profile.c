@@ -64,6 +64,27 @@
 #define SIZE_PIPE_ENTRY(cnt) (50 + (cnt) * 62)
 #define SIZE_LOG_ENTRY(cnt) (6 + (cnt) * 5)
 
+/*
+ * Sampling ring IB sizes (in dwords), the post IB also writes the slot's
+ * done flag:
+ *        : 2 - NOP start identifier
+ * [loop count start] - for each counter to watch
+ *        : 4 - Register read lo
+ *        : 4 - Register read high
+ * [loop end]
+ *        : 4 - done (post IB only)
+ *        : 2 - NOP end identifier
+ */
+#define RING_PREIB_DWORDS SIZE_POSTIB(ADRENO_PROFILE_RING_COUNTERS)
+#define RING_POSTIB_DWORDS (RING_PREIB_DWORDS + 4)
+#define RING_IB_DWORDS (RING_PREIB_DWORDS + RING_POSTIB_DWORDS)
+
+#define RING_COUNTER_SIZE \
+	sizeof(((struct adreno_profile_ring_slot *) 0)->counters[0])
+
+#define RING_SIZE (PAGE_SIZE + ADRENO_PROFILE_RING_SLOTS * \
+		sizeof(struct adreno_profile_ring_slot))
+
 static inline uint _ib_cmd_mem_write(struct adreno_device *adreno_dev,
 			uint *cmds, uint64_t gpuaddr, uint val, uint *off)
 {
@@ -199,6 +220,183 @@ static int _build_post_ib_cmds(struct adreno_device *adreno_dev,
 			ibcmds - start, ib_offset * sizeof(unsigned int));
 }
 
+static struct adreno_profile_ring_slot *_ring_slot(
+		struct adreno_profile *profile, unsigned int index)
+{
+	struct adreno_profile_ring_slot *slots = profile->ring->hostptr +
+		PAGE_SIZE;
+
+	return &slots[index];
+}
+
+static uint64_t _ring_slot_gpuaddr(struct adreno_profile *profile,
+		unsigned int index)
+{
+	return profile->ring->gpuaddr + PAGE_SIZE +
+		index * sizeof(struct adreno_profile_ring_slot);
+}
+
+/*
+ * Build the pre and post IBs of one ring slot. They only depend on the
+ * assignments and the slot address so they are written once when the ring
+ * is enabled and referenced from the ringbuffer on every submission.
+ */
+static void _build_ring_ibs(struct adreno_device *adreno_dev,
+		struct adreno_profile *profile, unsigned int index)
+{
+	struct adreno_profile_assigns_list *entry;
+	uint64_t gpuaddr = _ring_slot_gpuaddr(profile, index);
+	unsigned int *start, *ibcmds;
+	unsigned int i, off;
+
+	start = ((unsigned int *) profile->ring_ib->hostptr) +
+		index * RING_IB_DWORDS;
+	ibcmds = start;
+
+	ibcmds += cp_identifier(adreno_dev, ibcmds, START_PROFILE_IDENTIFIER);
+	i = 0;
+	list_for_each_entry(entry, &profile->assignments_list, list) {
+		off = offsetof(struct adreno_profile_ring_slot,
+			counters[0].pre) + i++ * RING_COUNTER_SIZE;
+		ibcmds += _ib_cmd_reg_to_mem(adreno_dev, ibcmds,
+				gpuaddr + off, entry->offset, &off);
+		ibcmds += _ib_cmd_reg_to_mem(adreno_dev, ibcmds,
+				gpuaddr + off, entry->offset_hi, &off);
+	}
+	ibcmds += cp_identifier(adreno_dev, ibcmds, END_PROFILE_IDENTIFIER);
+	profile->ring_preib_dwords = ibcmds - start;
+
+	start += RING_PREIB_DWORDS;
+	ibcmds = start;
+
+	ibcmds += cp_identifier(adreno_dev, ibcmds, START_PROFILE_IDENTIFIER);
+	i = 0;
+	list_for_each_entry(entry, &profile->assignments_list, list) {
+		off = offsetof(struct adreno_profile_ring_slot,
+			counters[0].post) + i++ * RING_COUNTER_SIZE;
+		ibcmds += _ib_cmd_reg_to_mem(adreno_dev, ibcmds,
+				gpuaddr + off, entry->offset, &off);
+		ibcmds += _ib_cmd_reg_to_mem(adreno_dev, ibcmds,
+				gpuaddr + off, entry->offset_hi, &off);
+	}
+	off = offsetof(struct adreno_profile_ring_slot, done);
+	ibcmds += _ib_cmd_mem_write(adreno_dev, ibcmds, gpuaddr + off, 1, &off);
+	ibcmds += cp_identifier(adreno_dev, ibcmds, END_PROFILE_IDENTIFIER);
+	profile->ring_postib_dwords = ibcmds - start;
+}
+
+static int _ring_start(struct adreno_device *adreno_dev,
+		struct adreno_profile *profile)
+{
+	struct adreno_profile_ring_header *hdr;
+	struct adreno_profile_assigns_list *entry;
+	unsigned int i = 0;
+
+	if (IS_ERR_OR_NULL(profile->ring) || IS_ERR_OR_NULL(profile->ring_ib))
+		return -ENODEV;
+
+	if (!profile->assignment_count ||
+		profile->assignment_count > ADRENO_PROFILE_RING_COUNTERS)
+		return -EINVAL;
+
+	memset(profile->ring->hostptr, 0, RING_SIZE);
+
+	hdr = profile->ring->hostptr;
+	hdr->magic = ADRENO_PROFILE_RING_MAGIC;
+	hdr->slot_offset = PAGE_SIZE;
+	hdr->slot_size = sizeof(struct adreno_profile_ring_slot);
+	hdr->nslots = ADRENO_PROFILE_RING_SLOTS;
+	hdr->count = profile->assignment_count;
+
+	list_for_each_entry(entry, &profile->assignments_list, list) {
+		hdr->counters[i].groupid = entry->groupid;
+		hdr->counters[i++].countable = entry->countable;
+	}
+
+	for (i = 0; i < ADRENO_PROFILE_RING_SLOTS; i++) {
+		/* Every slot starts out free */
+		_ring_slot(profile, i)->done = 1;
+		_build_ring_ibs(adreno_dev, profile, i);
+	}
+
+	/* Make sure the IBs are visible before the first submission uses them */
+	wmb();
+
+	profile->ring_head = 0;
+	profile->ring_enabled = true;
+	profile->enabled = true;
+
+	return 0;
+}
+
+/*
+ * A slot can be reused once the GPU wrote its done flag, or, if the
+ * submission never got to the post IB because of a fault, once its
+ * timestamp retired on the ringbuffer it was issued on.
+ */
+static bool _ring_slot_free(struct adreno_device *adreno_dev,
+		struct adreno_profile_ring_slot *slot)
+{
+	struct adreno_ringbuffer *rb;
+	unsigned int ts;
+
+	if (READ_ONCE(slot->done))
+		return true;
+
+	if (slot->rb_id >= adreno_dev->num_ringbuffers)
+		return true;
+
+	rb = &adreno_dev->ringbuffers[slot->rb_id];
+
+	if (adreno_rb_readtimestamp(adreno_dev, rb, KGSL_TIMESTAMP_RETIRED,
+		&ts))
+		return false;
+
+	return timestamp_cmp(ts, slot->timestamp) >= 0;
+}
+
+static int _ring_preib(struct adreno_device *adreno_dev,
+		struct adreno_context *drawctxt, unsigned int *rbcmds)
+{
+	struct adreno_profile *profile = &adreno_dev->profile;
+	struct adreno_profile_ring_header *hdr = profile->ring->hostptr;
+	unsigned int index = profile->ring_head % ADRENO_PROFILE_RING_SLOTS;
+	struct adreno_profile_ring_slot *slot = _ring_slot(profile, index);
+
+	if (!_ring_slot_free(adreno_dev, slot)) {
+		hdr->dropped++;
+		return 0;
+	}
+
+	slot->seq = profile->ring_head;
+	slot->done = 0;
+	slot->context_id = drawctxt->base.id;
+	slot->pid = pid_nr(drawctxt->base.proc_priv->pid);
+	slot->timestamp = drawctxt->rb->timestamp;
+	slot->rb_id = drawctxt->rb->id;
+
+	/* Publish the slot before moving the head readers poll on */
+	smp_wmb();
+	hdr->head = ++profile->ring_head;
+
+	profile->ring_slot = index;
+
+	return _create_ib_ref(adreno_dev, profile->ring_ib, rbcmds,
+			profile->ring_preib_dwords,
+			index * RING_IB_DWORDS * sizeof(unsigned int));
+}
+
+static int _ring_postib(struct adreno_device *adreno_dev,
+		unsigned int *rbcmds)
+{
+	struct adreno_profile *profile = &adreno_dev->profile;
+	unsigned int off = (profile->ring_slot * RING_IB_DWORDS +
+		RING_PREIB_DWORDS) * sizeof(unsigned int);
+
+	return _create_ib_ref(adreno_dev, profile->ring_ib, rbcmds,
+			profile->ring_postib_dwords, off);
+}
+
 static bool shared_buf_empty(struct adreno_profile *profile)
 {
 	if (profile->shared_buffer->hostptr == NULL ||
@@ -487,6 +685,12 @@ static int profile_enable_set(void *data, u64 val)
 
 	mutex_lock(&device->mutex);
 
+	/* The sampling ring owns the assignments while it is running */
+	if (profile->ring_enabled) {
+		mutex_unlock(&device->mutex);
+		return -EBUSY;
+	}
+
 	if (val && profile->log_buffer == NULL) {
 		/* allocate profile_log_buffer the first time enabled */
 		profile->log_buffer = vmalloc(ADRENO_PROFILE_LOG_BUF_SIZE);
@@ -505,6 +709,63 @@ static int profile_enable_set(void *data, u64 val)
 	return 0;
 }
 
+static int profile_ring_enable_get(void *data, u64 *val)
+{
+	struct kgsl_device *device = data;
+	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+
+	mutex_lock(&device->mutex);
+	*val = adreno_dev->profile.ring_enabled;
+	mutex_unlock(&device->mutex);
+
+	return 0;
+}
+
+static int profile_ring_enable_set(void *data, u64 val)
+{
+	struct kgsl_device *device = data;
+	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+	struct adreno_profile *profile = &adreno_dev->profile;
+	int ret = 0;
+
+	mutex_lock(&device->mutex);
+
+	if (!val) {
+		if (profile->ring_enabled) {
+			profile->ring_enabled = false;
+			profile->enabled = false;
+		}
+	} else if (!profile->ring_enabled) {
+		/* Don't steal the assignments from the pipe based profiler */
+		if (profile->enabled)
+			ret = -EBUSY;
+		else
+			ret = _ring_start(adreno_dev, profile);
+	}
+
+	mutex_unlock(&device->mutex);
+
+	return ret;
+}
+
+static int profile_ring_mmap(struct file *filep, struct vm_area_struct *vma)
+{
+	struct kgsl_device *device = filep->private_data;
+	struct adreno_device *adreno_dev = ADRENO_DEVICE(device);
+	struct kgsl_memdesc *ring = adreno_dev->profile.ring;
+
+	if (IS_ERR_OR_NULL(ring) || !ring->pages)
+		return -ENODEV;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	return vm_map_pages_zero(vma, ring->pages, ring->page_count);
+}
+
 static ssize_t profile_assignments_read(struct file *filep,
 		char __user *ubuf, size_t max, loff_t *ppos)
 {
@@ -1008,10 +1269,21 @@ static const struct file_operations profile_assignments_fops = {
 	.llseek = noop_llseek,
 };
 
+static const struct file_operations profile_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.mmap = profile_ring_mmap,
+	.llseek = noop_llseek,
+};
+
 DEFINE_DEBUGFS_ATTRIBUTE(profile_enable_fops,
 			profile_enable_get,
 			profile_enable_set, "%llu\n");
 
+DEFINE_DEBUGFS_ATTRIBUTE(profile_ring_enable_fops,
+			profile_ring_enable_get,
+			profile_ring_enable_set, "%llu\n");
+
 void adreno_profile_init(struct adreno_device *adreno_dev)
 {
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
@@ -1032,6 +1304,13 @@ void adreno_profile_init(struct adreno_device *adreno_dev)
 
 	INIT_LIST_HEAD(&profile->assignments_list);
 
+	/* Globals can only be allocated at init so reserve the ring up front */
+	profile->ring = kgsl_allocate_global(device, RING_SIZE, 0,
+		KGSL_MEMFLAGS_GPUREADONLY, 0, "profile_ring");
+	profile->ring_ib = kgsl_allocate_global(device,
+		ADRENO_PROFILE_RING_SLOTS * RING_IB_DWORDS * sizeof(unsigned int),
+		0, KGSL_MEMFLAGS_GPUREADONLY, 0, "profile_ring_ib");
+
 	/* Create perf counter debugfs */
 	profile_dir = debugfs_create_dir("profiling", device->d_debugfs);
 	if (IS_ERR(profile_dir))
@@ -1045,6 +1324,10 @@ void adreno_profile_init(struct adreno_device *adreno_dev)
 			&profile_pipe_fops);
 	debugfs_create_file("assignments", 0644, profile_dir, device,
 			&profile_assignments_fops);
+	debugfs_create_file("ring_enable", 0644, profile_dir, device,
+			&profile_ring_enable_fops);
+	debugfs_create_file("ring", 0400, profile_dir, device,
+			&profile_ring_fops);
 }
 
 void adreno_profile_close(struct adreno_device *adreno_dev)
@@ -1053,6 +1336,7 @@ void adreno_profile_close(struct adreno_device *adreno_dev)
 	struct adreno_profile_assigns_list *entry, *tmp;
 
 	profile->enabled = false;
+	profile->ring_enabled = false;
 	vfree(profile->log_buffer);
 	profile->log_buffer = NULL;
 	profile->log_head = NULL;
@@ -1104,6 +1388,13 @@ void adreno_profile_preib_processing(struct adreno_device *adreno_dev,
 	if (!adreno_profile_assignments_ready(profile))
 		goto done;
 
+	if (profile->ring_enabled) {
+		ret = _ring_preib(adreno_dev, drawctxt, rbcmds);
+		if (ret)
+			*cmd_flags |= KGSL_CMD_FLAGS_PROFILE;
+		goto done;
+	}
+
 	/*
 	 * check if space available, include the post_ib in space available
 	 * check so don't have to handle trying to undo the pre_ib insertion in
@@ -1164,6 +1455,11 @@ void adreno_profile_postib_processing(struct adreno_device *adreno_dev,
 	if (!(*cmd_flags & KGSL_CMD_FLAGS_PROFILE))
 		goto done;
 
+	if (profile->ring_enabled) {
+		ret = _ring_postib(adreno_dev, rbcmds);
+		goto done;
+	}
+
 	/* create the shared ibdesc */
 	ret = _build_post_ib_cmds(adreno_dev, profile, rbcmds, entry_head);
 
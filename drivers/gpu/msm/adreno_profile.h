@@ -22,6 +22,60 @@ struct adreno_profile_assigns_list {
 	unsigned int offset_hi; /* HI offset */
 };
 
+#define ADRENO_PROFILE_RING_MAGIC 0x474e4952 /* "RING" */
+#define ADRENO_PROFILE_RING_COUNTERS 8
+#define ADRENO_PROFILE_RING_SLOTS 128
+
+/**
+ * struct adreno_profile_ring_header - First page of the profiling/ring mapping
+ * @magic: ADRENO_PROFILE_RING_MAGIC
+ * @slot_offset: Byte offset of slot 0 from the start of the mapping
+ * @slot_size: Size of one struct adreno_profile_ring_slot in bytes
+ * @nslots: Number of slots in the ring
+ * @count: Number of counters sampled into every slot
+ * @head: Sequence number of the next slot to be written
+ * @dropped: Submissions not sampled because their slot was still in flight
+ * @counters: Group id and countable of each sampled counter
+ */
+struct adreno_profile_ring_header {
+	u32 magic;
+	u32 slot_offset;
+	u32 slot_size;
+	u32 nslots;
+	u32 count;
+	u32 head;
+	u32 dropped;
+	u32 __pad;
+	struct {
+		u32 groupid;
+		u32 countable;
+	} counters[ADRENO_PROFILE_RING_COUNTERS];
+};
+
+/**
+ * struct adreno_profile_ring_slot - Counter sample for one submission
+ * @seq: Sequence number of the sample, the slot index is @seq % nslots
+ * @done: Written to 1 by the GPU once the @counters post values have landed
+ * @context_id: Context that owns the submission
+ * @pid: Process that owns the context
+ * @timestamp: Ringbuffer timestamp of the submission
+ * @rb_id: Ringbuffer the submission was issued on
+ * @counters: Counter values before and after the submission's IBs
+ */
+struct adreno_profile_ring_slot {
+	u32 seq;
+	u32 done;
+	u32 context_id;
+	u32 pid;
+	u32 timestamp;
+	u32 rb_id;
+	u32 __pad[2];
+	struct {
+		u64 pre;
+		u64 post;
+	} counters[ADRENO_PROFILE_RING_COUNTERS];
+};
+
 struct adreno_profile {
 	struct list_head assignments_list; /* list of all assignments */
 	unsigned int assignment_count;  /* Number of assigned counters */
@@ -43,6 +97,18 @@ struct adreno_profile {
 	unsigned int shared_head;
 	unsigned int shared_tail;
 	unsigned int shared_size;
+	/*
+	 * Always-on sampling ring: ring holds the header page and the
+	 * slots and is mapped read only through debugfs, ring_ib holds the
+	 * pre and post IBs of every slot, built once when the ring is enabled
+	 */
+	struct kgsl_memdesc *ring;
+	struct kgsl_memdesc *ring_ib;
+	bool ring_enabled;
+	unsigned int ring_head;
+	unsigned int ring_slot;
+	unsigned int ring_preib_dwords;
+	unsigned int ring_postib_dwords;
 };
 
 #define ADRENO_PROFILE_SHARED_BUF_SIZE_DWORDS (48 * 4096 / sizeof(uint))
@@ -128,9 +128,28 @@ void adreno_ringbuffer_submit(struct adreno_ringbuffer *rb,
 		adreno_profile_submit_time(time);
 	}
 
+	/* The dispatcher will write the wptr once for the whole burst */
+	if (rb->defer_wptr)
+		return;
+
 	adreno_ringbuffer_wptr(adreno_dev, rb);
 }
 
+/**
+ * adreno_ringbuffer_flush_wptr() - Write any deferred wptr to the hardware
+ * @rb: Pointer to the ringbuffer
+ *
+ * Publish the commands that were added while @rb->defer_wptr was set. Must be
+ * called with the device mutex held.
+ */
+void adreno_ringbuffer_flush_wptr(struct adreno_ringbuffer *rb)
+{
+	struct adreno_device *adreno_dev = ADRENO_RB_DEVICE(rb);
+
+	if (rb->wptr != rb->_wptr)
+		adreno_ringbuffer_wptr(adreno_dev, rb);
+}
+
 int adreno_ringbuffer_submit_spin_nosync(struct adreno_ringbuffer *rb,
 		struct adreno_submit_time *time, unsigned int timeout)
 {
@@ -345,6 +364,15 @@ int adreno_ringbuffer_init(struct adreno_device *adreno_dev)
 void adreno_ringbuffer_close(struct adreno_device *adreno_dev)
 {
 	struct adreno_preemption *preempt = &adreno_dev->preempt;
+	int i;
+
+	for (i = 0; i < adreno_dev->num_ringbuffers; i++) {
+		struct adreno_ringbuffer *rb = &adreno_dev->ringbuffers[i];
+
+		kvfree(rb->submit_cmds);
+		rb->submit_cmds = NULL;
+		rb->submit_cmds_dwords = 0;
+	}
 
 	if (!ADRENO_FEATURE(adreno_dev, ADRENO_PREEMPTION))
 		return;
@@ -859,12 +887,84 @@ static int set_user_profiling(struct adreno_device *adreno_dev,
 }
 
 /* adreno_rindbuffer_submitcmd - submit userspace IBs to the GPU */
+static void _submit_template_build(struct adreno_device *adreno_dev,
+		struct adreno_submit_template *tmpl, bool preempt)
+{
+	const struct adreno_gpudev *gpudev = ADRENO_GPU_DEVICE(adreno_dev);
+
+	tmpl->ib_hdr = cp_mem_packet(adreno_dev, CP_INDIRECT_BUFFER_PFE, 2, 1);
+	tmpl->nop_hdr = cp_mem_packet(adreno_dev, CP_NOP, 3, 1);
+
+	tmpl->start_dwords = cp_identifier(adreno_dev, tmpl->start,
+		START_IB_IDENTIFIER);
+	tmpl->end_dwords = cp_identifier(adreno_dev, tmpl->end,
+		END_IB_IDENTIFIER);
+
+	tmpl->marker_dwords = 0;
+	if (gpudev->set_marker) {
+		tmpl->marker_dwords = gpudev->set_marker(tmpl->ib1list_start,
+			IB1LIST_START);
+		gpudev->set_marker(tmpl->ib1list_end, IB1LIST_END);
+	}
+
+	tmpl->post_dwords = 0;
+	if (gpudev->ccu_invalidate)
+		tmpl->post_dwords += gpudev->ccu_invalidate(adreno_dev,
+			tmpl->post);
+
+	if (preempt && gpudev->preemption_yield_enable)
+		tmpl->post_dwords += gpudev->preemption_yield_enable(
+			tmpl->post + tmpl->post_dwords);
+
+	tmpl->preempt = preempt;
+	tmpl->valid = true;
+}
+
+static struct adreno_submit_template *
+_submit_template(struct adreno_device *adreno_dev,
+		struct adreno_ringbuffer *rb)
+{
+	struct adreno_submit_template *tmpl = &rb->submit_tmpl;
+	bool preempt = adreno_is_preemption_enabled(adreno_dev);
+
+	/* Preemption can be toggled at runtime, rebuild when it changes */
+	if (!tmpl->valid || tmpl->preempt != preempt)
+		_submit_template_build(adreno_dev, tmpl, preempt);
+
+	return tmpl;
+}
+
+static u32 *_submit_cmds(struct adreno_ringbuffer *rb, u32 dwords)
+{
+	u32 *cmds;
+
+	if (dwords <= rb->submit_cmds_dwords)
+		return rb->submit_cmds;
+
+	dwords = roundup_pow_of_two(dwords);
+
+	cmds = kvmalloc_array(dwords, sizeof(*cmds), GFP_KERNEL);
+	if (!cmds)
+		return NULL;
+
+	kvfree(rb->submit_cmds);
+	rb->submit_cmds = cmds;
+	rb->submit_cmds_dwords = dwords;
+
+	return cmds;
+}
+
+static inline u32 *_submit_copy(u32 *cmds, const u32 *src, u32 dwords)
+{
+	memcpy(cmds, src, dwords * sizeof(*cmds));
+	return cmds + dwords;
+}
+
 int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 		struct kgsl_drawobj_cmd *cmdobj,
 		struct adreno_submit_time *time)
 {
 	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
-	const struct adreno_gpudev *gpudev = ADRENO_GPU_DEVICE(adreno_dev);
 	struct kgsl_drawobj *drawobj = DRAWOBJ(cmdobj);
 	struct kgsl_memobj_node *ib;
 	unsigned int numibs = 0;
@@ -880,6 +980,7 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 	struct adreno_ringbuffer *rb;
 	unsigned int dwords = 0;
 	struct adreno_submit_time local;
+	struct adreno_submit_template *tmpl;
 	bool set_ib1list_marker = false;
 
 	memset(&local, 0x0, sizeof(local));
@@ -892,6 +993,7 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 		numibs++;
 
 	rb = drawctxt->rb;
+	tmpl = _submit_template(adreno_dev, rb);
 
 	/* process any profiling results that are available into the log_buf */
 	adreno_profile_process_results(adreno_dev);
@@ -984,27 +1086,25 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 			dwords += 2;
 	}
 
-	if (adreno_is_preemption_enabled(adreno_dev))
-		if (gpudev->preemption_yield_enable)
-			dwords += 8;
+	dwords += tmpl->post_dwords;
 
-	if (gpudev->set_marker && numibs) {
+	if (tmpl->marker_dwords && numibs) {
 		set_ib1list_marker = true;
-		dwords += 4;
+		dwords += 2 * tmpl->marker_dwords;
 	}
 
-	if (gpudev->ccu_invalidate)
-		dwords += 4;
-
-	link = kvcalloc(dwords, sizeof(unsigned int), GFP_KERNEL);
+	/*
+	 * The IB list is only needed until it is copied into the ringbuffer
+	 * so build it in the ringbuffer's scratch buffer. Submissions to a
+	 * ringbuffer are serialized by the device mutex.
+	 */
+	link = _submit_cmds(rb, dwords);
 	if (!link) {
 		ret = -ENOMEM;
 		goto done;
 	}
 
-	cmds = link;
-
-	cmds += cp_identifier(adreno_dev, cmds, START_IB_IDENTIFIER);
+	cmds = _submit_copy(link, tmpl->start, tmpl->start_dwords);
 
 	if (kernel_profiling) {
 		cmds += _get_alwayson_counter(adreno_dev, cmds,
@@ -1026,7 +1126,8 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 
 	if (numibs) {
 		if (set_ib1list_marker)
-			cmds += gpudev->set_marker(cmds, IB1LIST_START);
+			cmds = _submit_copy(cmds, tmpl->ib1list_start,
+				tmpl->marker_dwords);
 
 		list_for_each_entry(ib, &cmdobj->cmdlist, node) {
 			/*
@@ -1035,11 +1136,9 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 			 */
 			if (ib->priv & MEMOBJ_SKIP ||
 				(ib->priv & MEMOBJ_PREAMBLE && !use_preamble))
-				*cmds++ = cp_mem_packet(adreno_dev, CP_NOP,
-						3, 1);
+				*cmds++ = tmpl->nop_hdr;
 
-			*cmds++ = cp_mem_packet(adreno_dev,
-					CP_INDIRECT_BUFFER_PFE, 2, 1);
+			*cmds++ = tmpl->ib_hdr;
 			cmds += cp_gpuaddr(adreno_dev, cmds, ib->gpuaddr);
 			/*
 			 * Never allow bit 20 (IB_PRIV) to be set. All IBs MUST
@@ -1052,15 +1151,11 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 		}
 
 		if (set_ib1list_marker)
-			cmds += gpudev->set_marker(cmds, IB1LIST_END);
+			cmds = _submit_copy(cmds, tmpl->ib1list_end,
+				tmpl->marker_dwords);
 	}
 
-	if (gpudev->ccu_invalidate)
-		cmds += gpudev->ccu_invalidate(adreno_dev, cmds);
-
-	if (adreno_is_preemption_enabled(adreno_dev))
-		if (gpudev->preemption_yield_enable)
-			cmds += gpudev->preemption_yield_enable(cmds);
+	cmds = _submit_copy(cmds, tmpl->post, tmpl->post_dwords);
 
 	if (kernel_profiling) {
 		cmds += _get_alwayson_counter(adreno_dev, cmds,
@@ -1080,7 +1175,7 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 			gpu_ticks_retired));
 	}
 
-	cmds += cp_identifier(adreno_dev, cmds, END_IB_IDENTIFIER);
+	cmds = _submit_copy(cmds, tmpl->end, tmpl->end_dwords);
 
 	/* Context switches commands should *always* be on the GPU */
 	ret = adreno_drawctxt_switch(adreno_dev, rb, drawctxt);
@@ -1129,7 +1224,6 @@ int adreno_ringbuffer_submitcmd(struct adreno_device *adreno_dev,
 	trace_kgsl_issueibcmds(device, context->id, numibs, drawobj->timestamp,
 			drawobj->flags, ret, drawctxt->type);
 
-	kvfree(link);
 	return ret;
 }
 
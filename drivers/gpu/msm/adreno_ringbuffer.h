@@ -40,6 +40,38 @@ struct adreno_submit_time {
 	struct kgsl_drawobj *drawobj;
 };
 
+/**
+ * struct adreno_submit_template - Fixed parts of a submission's IB list
+ * @valid: The template has been built
+ * @preempt: Preemption state the template was built for
+ * @ib_hdr: INDIRECT_BUFFER_PFE packet header
+ * @nop_hdr: NOP header used to skip an IB
+ * @start: Dwords written before any IB (start identifier)
+ * @ib1list_start: IB1 list start marker, @marker_dwords long
+ * @ib1list_end: IB1 list end marker, @marker_dwords long
+ * @post: Dwords written after the IBs (CCU invalidate, preemption yield)
+ * @end: Dwords written at the very end (end identifier)
+ *
+ * None of these depend on the submission itself, so they are built once
+ * and copied into every IB list instead of being regenerated through the
+ * gpudev hooks each time.
+ */
+struct adreno_submit_template {
+	bool valid;
+	bool preempt;
+	u32 ib_hdr;
+	u32 nop_hdr;
+	u32 start[4];
+	u32 start_dwords;
+	u32 ib1list_start[4];
+	u32 ib1list_end[4];
+	u32 marker_dwords;
+	u32 post[16];
+	u32 post_dwords;
+	u32 end[4];
+	u32 end_dwords;
+};
+
 /**
  * struct adreno_ringbuffer_pagetable_info - Contains fields used during a
  * pagetable switch.
@@ -98,6 +130,11 @@ struct adreno_ringbuffer_pagetable_info {
  * @preempt_lock: Lock to protect the wptr pointer while it is being updated
  * @skip_inline_wptr: Used during preemption to make sure wptr is updated in
  * hardware
+ * @defer_wptr: Set while the dispatcher coalesces submissions, commands are
+ * only written to the ringbuffer and adreno_ringbuffer_flush_wptr() tells the
+ * hardware about all of them at once
+ * @deadline: Earliest context deadline submitted to the ringbuffer since it was
+ * last seen empty, 0 if none. Protected by @preempt_lock
  */
 struct adreno_ringbuffer {
 	uint32_t flags;
@@ -121,6 +158,8 @@ struct adreno_ringbuffer {
 	int preempted_midway;
 	spinlock_t preempt_lock;
 	bool skip_inline_wptr;
+	bool defer_wptr;
+	u64 deadline;
 	/**
 	 * @profile_desc: global memory to construct IB1s to do user side
 	 * profiling
@@ -133,6 +172,15 @@ struct adreno_ringbuffer {
 	 * enough.
 	 */
 	u32 profile_index;
+	/** @submit_tmpl: Fixed commands of every IB list on this ringbuffer */
+	struct adreno_submit_template submit_tmpl;
+	/**
+	 * @submit_cmds: Scratch buffer IB lists are built in, reused across
+	 * submissions under the device mutex and grown when needed
+	 */
+	u32 *submit_cmds;
+	/** @submit_cmds_dwords: Size of @submit_cmds in dwords */
+	u32 submit_cmds_dwords;
 };
 
 /* Returns the current ringbuffer */
@@ -163,6 +211,8 @@ int adreno_ringbuffer_issue_internal_cmds(struct adreno_ringbuffer *rb,
 void adreno_ringbuffer_submit(struct adreno_ringbuffer *rb,
 		struct adreno_submit_time *time);
 
+void adreno_ringbuffer_flush_wptr(struct adreno_ringbuffer *rb);
+
 int adreno_ringbuffer_submit_spin_nosync(struct adreno_ringbuffer *rb,
 		struct adreno_submit_time *time, unsigned int timeout);
 
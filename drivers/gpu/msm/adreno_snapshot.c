@@ -202,6 +202,13 @@ void adreno_parse_ib(struct kgsl_device *device,
 					gpuaddr, dwords << 2))
 		return;
 
+	/*
+	 * IBs that weren't executing at the time of the fault aren't needed
+	 * for recovery, let the snapshot worker parse them
+	 */
+	if (!kgsl_snapshot_defer_ib(snapshot, process, gpuaddr, dwords))
+		return;
+
 	if (-E2BIG == adreno_ib_create_object_list(device, process,
 				gpuaddr, dwords, snapshot->ib2base,
 				&ib_obj_list))
@@ -157,15 +157,76 @@ static ssize_t mod_percent_show(struct device *dev,
 	return scnprintf(buf, PAGE_SIZE, "%u\n", priv->mod_percent);
 }
 
+static ssize_t frame_aware_store(struct device *dev,
+			struct device_attribute *attr,
+			const char *buf, size_t count)
+{
+	int ret;
+	bool val;
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+
+	ret = kstrtobool(buf, &val);
+	if (ret)
+		return ret;
+
+	mutex_lock(&devfreq->lock);
+	priv->frame.enable = val;
+	priv->frame.expires = 0;
+	mutex_unlock(&devfreq->lock);
+
+	return count;
+}
+
+static ssize_t frame_aware_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", priv->frame.enable);
+}
+
+static ssize_t frame_headroom_store(struct device *dev,
+			struct device_attribute *attr,
+			const char *buf, size_t count)
+{
+	int ret;
+	unsigned int val;
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	priv->frame.headroom = min_t(u32, val, 50);
+
+	return count;
+}
+
+static ssize_t frame_headroom_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct devfreq *devfreq = to_devfreq(dev);
+	struct devfreq_msm_adreno_tz_data *priv = devfreq->data;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", priv->frame.headroom);
+}
+
 static DEVICE_ATTR_RO(gpu_load);
 
 static DEVICE_ATTR_RO(suspend_time);
 static DEVICE_ATTR_RW(mod_percent);
+static DEVICE_ATTR_RW(frame_aware);
+static DEVICE_ATTR_RW(frame_headroom);
 
 static const struct device_attribute *adreno_tz_attr_list[] = {
 		&dev_attr_gpu_load,
 		&dev_attr_suspend_time,
 		&dev_attr_mod_percent,
+		&dev_attr_frame_aware,
+		&dev_attr_frame_headroom,
 		NULL
 };
 
@@ -349,6 +410,59 @@ static inline int devfreq_get_freq_level(struct devfreq *devfreq,
 	return -EINVAL;
 }
 
+/*
+ * Fold the frame that just retired into the prediction for the next one. The
+ * prediction follows heavier frames right away and decays slowly after lighter
+ * ones so a single cheap frame doesn't drop the clock under the next heavy one.
+ * This function expects devfreq->lock to be held.
+ */
+static void tz_frame_sample(struct devfreq_msm_adreno_tz_data *priv)
+{
+	u64 cycles = priv->frame.sample_cycles;
+	u64 period = priv->frame.sample_period;
+
+	if (priv->frame.expires < ktime_to_us(ktime_get())) {
+		priv->frame.cycles = cycles;
+		priv->frame.period = period;
+	} else {
+		if (cycles >= priv->frame.cycles)
+			priv->frame.cycles = cycles;
+		else
+			priv->frame.cycles = (priv->frame.cycles * 3 + cycles) >> 2;
+
+		priv->frame.period = (priv->frame.period * 3 + period) >> 2;
+	}
+
+	priv->frame.expires = ktime_to_us(ktime_get()) + 4 * priv->frame.period;
+}
+
+/*
+ * Pick the lowest frequency that finishes the predicted frame cycles within
+ * the frame period, less the headroom kept for prediction misses. Returns
+ * false if there is no current prediction and the regular algorithm has to
+ * decide.
+ */
+static bool tz_frame_target_freq(struct devfreq *devfreq,
+		struct devfreq_msm_adreno_tz_data *priv, unsigned long *freq)
+{
+	u64 budget, need;
+	int lev;
+
+	if (!priv->frame.enable || !priv->frame.period ||
+		priv->frame.expires < ktime_to_us(ktime_get()))
+		return false;
+
+	budget = priv->frame.period * (100 - priv->frame.headroom);
+	need = div64_u64(priv->frame.cycles * 100 * USEC_PER_SEC, budget);
+
+	for (lev = devfreq->profile->max_state - 1; lev > 0; lev--)
+		if (devfreq->profile->freq_table[lev] >= need)
+			break;
+
+	*freq = devfreq->profile->freq_table[lev];
+	return true;
+}
+
 static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
 {
 	int result = 0;
@@ -382,6 +496,13 @@ static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
 
 	/* Update the GPU load statistics */
 	compute_work_load(stats, priv, devfreq);
+
+	/* Frame aware scaling overrides the window based algorithm */
+	if (tz_frame_target_freq(devfreq, priv, freq)) {
+		priv->bin.total_time = 0;
+		priv->bin.busy_time = 0;
+		return 0;
+	}
 	/*
 	 * Do not waste CPU cycles running this algorithm if
 	 * the GPU just started, or if less than FLOOR time
@@ -435,6 +556,12 @@ static int tz_notify(struct notifier_block *nb, unsigned long type, void *devp)
 	struct devfreq *devfreq = devp;
 
 	switch (type) {
+	case ADRENO_DEVFREQ_NOTIFY_FRAME:
+		mutex_lock(&devfreq->lock);
+		tz_frame_sample(devfreq->data);
+		result = update_devfreq(devfreq);
+		mutex_unlock(&devfreq->lock);
+		break;
 	case ADRENO_DEVFREQ_NOTIFY_IDLE:
 	case ADRENO_DEVFREQ_NOTIFY_RETIRE:
 		mutex_lock(&devfreq->lock);
@@ -538,6 +665,7 @@ static int tz_suspend(struct devfreq *devfreq)
 
 	priv->bin.total_time = 0;
 	priv->bin.busy_time = 0;
+	priv->frame.expires = 0;
 	return 0;
 }
 
@@ -28,6 +28,7 @@
 #include "kgsl_device.h"
 #include "kgsl_mmu.h"
 #include "kgsl_pool.h"
+#include "kgsl_reclaim.h"
 #include "kgsl_sync.h"
 #include "kgsl_sysfs.h"
 #include "kgsl_trace.h"
@@ -80,6 +81,7 @@ static inline struct kgsl_pagetable *_get_memdesc_pagetable(
 }
 
 static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry);
+static void kgsl_mem_entry_unlink(struct kgsl_mem_entry *entry);
 
 static const struct file_operations kgsl_fops;
 
@@ -412,6 +414,88 @@ static void kgsl_process_sub_stats(struct kgsl_process_private *priv,
 	atomic64_sub(size, &priv->stats[type].cur);
 }
 
+/* Free the memory of an entry that is no longer mapped in the GPU */
+static void kgsl_mem_entry_free(struct kgsl_mem_entry *entry)
+{
+	/* pull out the memtype before the flags get cleared */
+	if (kgsl_memdesc_usermem_type(&entry->memdesc) != KGSL_MEM_ENTRY_KERNEL)
+		atomic_long_sub(entry->memdesc.size,
+			&kgsl_driver.stats.mapped);
+
+	kgsl_sharedmem_free(&entry->memdesc);
+
+	kfree(entry);
+}
+
+/*
+ * Entries still mapped in a process pagetable are unmapped by the reap
+ * worker, so that the unmaps of many entries share one TLB invalidate.
+ */
+static bool kgsl_mem_entry_can_reap(struct kgsl_mem_entry *entry)
+{
+	struct kgsl_memdesc *memdesc = &entry->memdesc;
+
+	return entry->priv && memdesc->pagetable &&
+		!kgsl_memdesc_is_global(memdesc) &&
+		(memdesc->priv & KGSL_MEMDESC_MAPPED);
+}
+
+/* Scheduled by kgsl_mem_entry_destroy() for entries taking the reap path */
+static void kgsl_mem_entry_reap(struct work_struct *work)
+{
+	struct kgsl_memdesc *batch[KGSL_MMU_UNMAP_BATCH];
+	struct llist_node *list = llist_del_all(&kgsl_driver.mem_reap_list);
+
+	while (list) {
+		struct kgsl_pagetable *pagetable = NULL;
+		struct llist_node *node, *next, *rest = NULL;
+		struct kgsl_mem_entry *entry;
+		int i, count = 0;
+
+		/* Pick the entries of one pagetable, leave the rest for later */
+		llist_for_each_safe(node, next, list) {
+			entry = llist_entry(node, struct kgsl_mem_entry,
+				reap_node);
+
+			if (!pagetable)
+				pagetable = entry->memdesc.pagetable;
+
+			if (entry->memdesc.pagetable != pagetable ||
+				count == KGSL_MMU_UNMAP_BATCH) {
+				node->next = rest;
+				rest = node;
+				continue;
+			}
+
+			batch[count++] = &entry->memdesc;
+		}
+
+		kgsl_mmu_put_gpuaddr_batch(pagetable, batch, count);
+
+		for (i = 0; i < count; i++) {
+			entry = container_of(batch[i], struct kgsl_mem_entry,
+				memdesc);
+
+			/* The process reference kept the pagetable alive */
+			kgsl_process_private_put(entry->priv);
+			entry->priv = NULL;
+
+			kgsl_mem_entry_free(entry);
+		}
+
+		list = rest;
+	}
+}
+
+/*
+ * Wait for the reap worker so that the GPU addresses of freed entries can be
+ * allocated again. Returns true if there was anything to wait for.
+ */
+static bool kgsl_mem_entry_reap_sync(void)
+{
+	return flush_work(&kgsl_driver.mem_reap_work);
+}
+
 void
 kgsl_mem_entry_destroy(struct kref *kref)
 {
@@ -423,21 +507,24 @@ kgsl_mem_entry_destroy(struct kref *kref)
 	if (entry == NULL)
 		return;
 
-	/* pull out the memtype before the flags get cleared */
 	memtype = kgsl_memdesc_usermem_type(&entry->memdesc);
 
 	kgsl_process_sub_stats(entry->priv, memtype, entry->memdesc.size);
 
-	/* Detach from process list */
-	kgsl_mem_entry_detach_process(entry);
+	if (kgsl_mem_entry_can_reap(entry)) {
+		/* Nobody can look the entry up anymore, unmap it later */
+		kgsl_mem_entry_unlink(entry);
 
-	if (memtype != KGSL_MEM_ENTRY_KERNEL)
-		atomic_long_sub(entry->memdesc.size,
-			&kgsl_driver.stats.mapped);
+		if (llist_add(&entry->reap_node, &kgsl_driver.mem_reap_list))
+			queue_work(kgsl_driver.mem_workqueue,
+				&kgsl_driver.mem_reap_work);
+		return;
+	}
 
-	kgsl_sharedmem_free(&entry->memdesc);
+	/* Detach from process list */
+	kgsl_mem_entry_detach_process(entry);
 
-	kfree(entry);
+	kgsl_mem_entry_free(entry);
 }
 
 /* Allocate a IOVA for memory objects that don't use SVM */
@@ -446,6 +533,7 @@ static int kgsl_mem_entry_track_gpuaddr(struct kgsl_device *device,
 		struct kgsl_mem_entry *entry)
 {
 	struct kgsl_pagetable *pagetable;
+	int ret;
 
 	/*
 	 * If SVM is enabled for this object then the address needs to be
@@ -459,7 +547,13 @@ static int kgsl_mem_entry_track_gpuaddr(struct kgsl_device *device,
 	pagetable = kgsl_memdesc_is_secured(&entry->memdesc) ?
 		device->mmu.securepagetable : process->pagetable;
 
-	return kgsl_mmu_get_gpuaddr(pagetable, &entry->memdesc);
+	ret = kgsl_mmu_get_gpuaddr(pagetable, &entry->memdesc);
+
+	/* Freed entries may still be holding on to the address space */
+	if (ret && kgsl_mem_entry_reap_sync())
+		ret = kgsl_mmu_get_gpuaddr(pagetable, &entry->memdesc);
+
+	return ret;
 }
 
 /* Commit the entry to the process so it can be accessed by other operations */
@@ -529,11 +623,8 @@ static int kgsl_mem_entry_attach_process(struct kgsl_device *device,
 }
 
 /* Detach a memory entry from a process and unmap it from the MMU */
-static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
+static void kgsl_mem_entry_unlink(struct kgsl_mem_entry *entry)
 {
-	if (entry == NULL)
-		return;
-
 	/*
 	 * First remove the entry from mem_idr list
 	 * so that no one can operate on obsolete values
@@ -544,6 +635,14 @@ static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
 	entry->id = 0;
 
 	spin_unlock(&entry->priv->mem_lock);
+}
+
+static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
+{
+	if (entry == NULL)
+		return;
+
+	kgsl_mem_entry_unlink(entry);
 
 	kgsl_mmu_put_gpuaddr(&entry->memdesc);
 
@@ -726,6 +825,9 @@ int kgsl_context_init(struct kgsl_device_private *dev_priv,
 	kgsl_add_event_group(device, &context->events, context,
 		kgsl_readtimestamp, context, "context-%d", id);
 
+	kthread_init_work(&context->sync_sched_work,
+		kgsl_drawobj_sync_sched_work);
+
 out:
 	if (ret) {
 		atomic_dec(&proc_priv->ctxt_count);
@@ -989,6 +1091,8 @@ static struct kgsl_process_private *kgsl_process_private_new(
 	spin_lock_init(&private->mem_lock);
 	spin_lock_init(&private->syncsource_lock);
 	spin_lock_init(&private->ctxt_count_lock);
+	init_rwsem(&private->reclaim_sem);
+	private->last_active = jiffies;
 
 	idr_init(&private->mem_idr);
 	idr_init(&private->syncsource_idr);
@@ -2568,6 +2672,11 @@ static int kgsl_setup_anon_useraddr(struct kgsl_pagetable *pagetable,
 		ret = kgsl_mmu_set_svm_region(pagetable,
 			(uint64_t) hostptr, (uint64_t) size);
 
+		/* A freed entry of the same range may not be unmapped yet */
+		if (ret && kgsl_mem_entry_reap_sync())
+			ret = kgsl_mmu_set_svm_region(pagetable,
+				(uint64_t) hostptr, (uint64_t) size);
+
 		if (ret)
 			return ret;
 
@@ -2883,7 +2992,9 @@ long kgsl_ioctl_gpuobj_import(struct kgsl_device_private *dev_priv,
 	if (ret)
 		goto out;
 
-	if (entry->memdesc.size >= SZ_1M)
+	if (entry->memdesc.size >= SZ_2M)
+		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_2M));
+	else if (entry->memdesc.size >= SZ_1M)
 		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_1M));
 	else if (entry->memdesc.size >= SZ_64K)
 		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_64K));
@@ -3221,7 +3332,7 @@ long kgsl_ioctl_map_user_mem(struct kgsl_device_private *dev_priv,
 	else if (entry->memdesc.size >= SZ_1M)
 		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_1M));
 	else if (entry->memdesc.size >= SZ_64K)
-		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_64));
+		kgsl_memdesc_set_align(&entry->memdesc, ilog2(SZ_64K));
 
 	/* echo back flags */
 	param->flags = (unsigned int) entry->memdesc.flags;
@@ -3571,7 +3682,12 @@ struct kgsl_mem_entry *gpumem_alloc_entry(
 		| KGSL_MEMFLAGS_SECURE
 		| KGSL_MEMFLAGS_FORCE_32BIT
 		| KGSL_MEMFLAGS_IOCOHERENT
-		| KGSL_MEMFLAGS_GUARD_PAGE;
+		| KGSL_MEMFLAGS_GUARD_PAGE
+		| KGSL_MEMFLAGS_RECLAIMABLE;
+
+	/* Secure memory can't be copied out, so it is never reclaimed */
+	if (flags & KGSL_MEMFLAGS_SECURE)
+		flags &= ~((uint64_t) KGSL_MEMFLAGS_RECLAIMABLE);
 
 	/* Return not supported error if secure memory isn't enabled */
 	if (!kgsl_mmu_is_secured(mmu) &&
@@ -3613,6 +3729,18 @@ struct kgsl_mem_entry *gpumem_alloc_entry(
 	if (ret != 0)
 		goto err;
 
+	/*
+	 * The pool hands out the biggest chunks first. Align the GPU address
+	 * to the first chunk so the IOMMU can map chunks as block entries.
+	 */
+	if (entry->memdesc.pages) {
+		unsigned int order = compound_order(entry->memdesc.pages[0]);
+
+		if (PAGE_SHIFT + order > kgsl_memdesc_get_align(&entry->memdesc))
+			kgsl_memdesc_set_align(&entry->memdesc,
+				PAGE_SHIFT + order);
+	}
+
 	ret = kgsl_mem_entry_attach_process(dev_priv->device, private, entry);
 	if (ret != 0) {
 		kgsl_sharedmem_free(&entry->memdesc);
@@ -4074,9 +4202,15 @@ static unsigned long set_svm_area(struct file *file,
 	ret = current->mm->get_unmapped_area(file, addr, len, 0,
 		flags & MAP_FIXED);
 
+	if (IS_ERR_VALUE(ret))
+		return ret;
+
 	/* If it passes, attempt to set the region in the SVM */
-	if (!IS_ERR_VALUE(ret))
-		return _gpu_set_svm_region(private, entry, addr, len);
+	ret = _gpu_set_svm_region(private, entry, addr, len);
+
+	/* A freed entry of the same range may not be unmapped yet */
+	if (ret == (unsigned long) -ENOMEM && kgsl_mem_entry_reap_sync())
+		ret = _gpu_set_svm_region(private, entry, addr, len);
 
 	return ret;
 }
@@ -4206,14 +4340,21 @@ static int kgsl_mmap(struct file *file, struct vm_area_struct *vma)
 	if (vma_offset == (unsigned long) KGSL_MEMSTORE_TOKEN_ADDRESS)
 		return kgsl_mmap_memstore(file, device, vma);
 
+	/* Bring the pages back and keep them until map_count is raised */
+	ret = kgsl_reclaim_get(private);
+	if (ret)
+		return ret;
+
 	/*
 	 * The reference count on the entry that we get from
 	 * get_mmap_entry() will be held until kgsl_gpumem_vm_close().
 	 */
 	ret = get_mmap_entry(private, &entry, vma->vm_pgoff,
 				vma->vm_end - vma->vm_start);
-	if (ret)
+	if (ret) {
+		kgsl_reclaim_put(private);
 		return ret;
+	}
 
 	vma->vm_flags |= entry->memdesc.ops->vmflags;
 
@@ -4261,6 +4402,7 @@ static int kgsl_mmap(struct file *file, struct vm_area_struct *vma)
 	atomic64_add(entry->memdesc.size, &entry->priv->gpumem_mapped);
 
 	atomic_inc(&entry->map_count);
+	kgsl_reclaim_put(private);
 
 	trace_kgsl_mem_mmap(entry, vma->vm_start);
 	return 0;
@@ -4315,6 +4457,8 @@ struct kgsl_driver kgsl_driver  = {
 	.stats.secure_max = ATOMIC_LONG_INIT(0),
 	.stats.mapped = ATOMIC_LONG_INIT(0),
 	.stats.mapped_max = ATOMIC_LONG_INIT(0),
+	.stats.reclaimed = ATOMIC_LONG_INIT(0),
+	.stats.reclaimed_max = ATOMIC_LONG_INIT(0),
 };
 
 static void _unregister_device(struct kgsl_device *device)
@@ -4589,6 +4733,8 @@ void kgsl_device_platform_remove(struct kgsl_device *device)
 
 void kgsl_core_exit(void)
 {
+	kgsl_reclaim_close();
+
 	kgsl_exit_page_pools();
 
 	if (kgsl_driver.workqueue) {
@@ -4711,6 +4857,9 @@ int __init kgsl_core_init(void)
 
 	INIT_LIST_HEAD(&kgsl_driver.pagetable_list);
 
+	init_llist_head(&kgsl_driver.mem_reap_list);
+	INIT_WORK(&kgsl_driver.mem_reap_work, kgsl_mem_entry_reap);
+
 	kgsl_driver.workqueue = alloc_workqueue("kgsl-workqueue",
 		WQ_UNBOUND | WQ_MEM_RECLAIM | WQ_SYSFS, 0);
 
@@ -4729,6 +4878,8 @@ int __init kgsl_core_init(void)
 		goto err;
 	}
 
+	kgsl_reclaim_init();
+
 	if (IS_ERR_VALUE(kgsl_run_one_worker(&kgsl_driver.worker,
 			&kgsl_driver.worker_thread,
 			"kgsl_worker_thread")) ||
@@ -11,6 +11,7 @@
 #include <linux/compat.h>
 #include <linux/interrupt.h>
 #include <linux/kthread.h>
+#include <linux/llist.h>
 #include <linux/mm.h>
 #include <linux/uaccess.h>
 
@@ -118,6 +119,8 @@ struct kgsl_context;
  * @full_cache_threshold: the threshold that triggers a full cache flush
  * @workqueue: Pointer to a single threaded workqueue
  * @mem_workqueue: Pointer to a workqueue for deferring memory entries
+ * @mem_reap_list: Freed memory entries waiting for their GPU unmap
+ * @mem_reap_work: Work item that unmaps and frees @mem_reap_list in batches
  */
 struct kgsl_driver {
 	struct cdev cdev;
@@ -144,10 +147,14 @@ struct kgsl_driver {
 		atomic_long_t secure_max;
 		atomic_long_t mapped;
 		atomic_long_t mapped_max;
+		atomic_long_t reclaimed;
+		atomic_long_t reclaimed_max;
 	} stats;
 	unsigned int full_cache_threshold;
 	struct workqueue_struct *workqueue;
 	struct workqueue_struct *mem_workqueue;
+	struct llist_head mem_reap_list;
+	struct work_struct mem_reap_work;
 	struct kthread_worker worker;
 	struct kthread_worker low_prio_worker;
 	struct task_struct *worker_thread;
@@ -186,6 +193,16 @@ struct kgsl_memdesc_ops {
 #define KGSL_MEMDESC_RANDOM BIT(8)
 /* Allocate memory from the system instead of the pools */
 #define KGSL_MEMDESC_SYSMEM BIT(9)
+/* The pages were moved to @shmem_filp and the object is not GPU mapped */
+#define KGSL_MEMDESC_RECLAIMED BIT(10)
+
+/* GPU page table granularities tracked for each mapping */
+enum kgsl_map_granule {
+	KGSL_MAP_GRANULE_4K = 0,
+	KGSL_MAP_GRANULE_64K,
+	KGSL_MAP_GRANULE_2M,
+	KGSL_MAP_GRANULE_MAX,
+};
 
 /**
  * struct kgsl_memdesc - GPU memory object descriptor
@@ -203,6 +220,8 @@ struct kgsl_memdesc_ops {
  * @attrs: dma attributes for this memory
  * @pages: An array of pointers to allocated pages
  * @page_count: Total number of pages allocated
+ * @map_granule: Pages mapped with each GPU page table granularity
+ * @shmem_filp: Shmem file holding the pages of a reclaimed object
  */
 struct kgsl_memdesc {
 	struct kgsl_pagetable *pagetable;
@@ -219,6 +238,8 @@ struct kgsl_memdesc {
 	unsigned long attrs;
 	struct page **pages;
 	unsigned int page_count;
+	unsigned int map_granule[KGSL_MAP_GRANULE_MAX];
+	struct file *shmem_filp;
 	/*
 	 * @lock: Spinlock to protect the gpuaddr from being accessed by
 	 * multiple entities trying to map the same SVM region at once
@@ -280,6 +301,11 @@ struct kgsl_mem_entry {
 	 * debugfs accounting
 	 */
 	atomic_t map_count;
+	/**
+	 * @reap_node: Node in the driver list of entries waiting to be
+	 * unmapped from the GPU and freed
+	 */
+	struct llist_node reap_node;
 };
 
 struct kgsl_device_private;
@@ -303,9 +329,10 @@ const char *prio_to_string(enum kgsl_priority prio);
  * @timestamp: Timestamp for the event to expire
  * @func: Callback function for for the event when it expires
  * @priv: Private data passed to the callback function
- * @node: List node for the kgsl_event_group list
+ * @node: List node for the kgsl_event_group list, sorted by timestamp
  * @created: Jiffies when the event was created
- * @work: Work struct for dispatching the callback
+ * @retire_node: Node in the device list of events ready for their callback
+ * @signaled: Time in ns when the event was moved to the device list
  * @result: KGSL event result type to pass to the callback
  * group: The event group this event belongs to
  */
@@ -317,7 +344,8 @@ struct kgsl_event {
 	void *priv;
 	struct list_head node;
 	unsigned int created;
-	struct work_struct work;
+	struct llist_node retire_node;
+	u64 signaled;
 	int result;
 	enum kgsl_priority prio;
 	struct kgsl_event_group *group;
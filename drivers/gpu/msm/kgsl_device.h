@@ -316,6 +316,24 @@ struct kgsl_device {
 	struct list_head event_groups;
 	/** @event_groups_lock: A R/W lock for the events group list */
 	rwlock_t event_groups_lock;
+	/** @events_retired: Events waiting for their callbacks to run */
+	struct llist_head events_retired;
+	/** @events_work: Runs the callbacks of all @events_retired at once */
+	struct work_struct events_work;
+	/**
+	 * @events_stats: Event callback counters, only updated from
+	 * @events_work
+	 */
+	struct {
+		/** @fired: Number of event callbacks that were run */
+		u64 fired;
+		/** @batches: Number of times @events_work ran callbacks */
+		u64 batches;
+		/** @latency_total: Sum of ns from signal to callback */
+		u64 latency_total;
+		/** @latency_max: Longest ns from signal to callback */
+		u64 latency_max;
+	} events_stats;
 	/** @speed_bin: Speed bin for the GPU device if applicable */
 	u32 speed_bin;
 	/** @gmu_fault: Set when a gmu or rgmu fault is encountered */
@@ -337,6 +355,8 @@ struct kgsl_device {
  * @KGSL_CONTEXT_PRIV_INVALID - The context has been destroyed by the kernel
  *	because it caused a GPU fault.
  * @KGSL_CONTEXT_PRIV_PAGEFAULT - The context has caused a page fault.
+ * @KGSL_CONTEXT_PRIV_SYNC_SCHED - A dispatcher kick for expired sync points
+ *	is queued for the context.
  * @KGSL_CONTEXT_PRIV_DEVICE_SPECIFIC - this value and higher values are
  *	reserved for devices specific use.
  */
@@ -345,6 +365,7 @@ enum kgsl_context_priv {
 	KGSL_CONTEXT_PRIV_DETACHED,
 	KGSL_CONTEXT_PRIV_INVALID,
 	KGSL_CONTEXT_PRIV_PAGEFAULT,
+	KGSL_CONTEXT_PRIV_SYNC_SCHED,
 	KGSL_CONTEXT_PRIV_DEVICE_SPECIFIC = 16,
 };
 
@@ -403,6 +424,11 @@ struct kgsl_context {
 	 * submitted
 	 */
 	u32 gmu_dispatch_queue;
+	/**
+	 * @sync_sched_work: work collapsing sync point expiries into one
+	 * dispatcher kick
+	 */
+	struct kthread_work sync_sched_work;
 };
 
 #define _context_comm(_c) \
@@ -438,6 +464,9 @@ struct kgsl_context {
  * @ctxt_count: Count for the number of contexts for this process
  * @ctxt_count_lock: Spinlock to protect ctxt_count
  * @frame_count: Count for the number of frames processed
+ * @reclaim_sem: Held for write while memory is reclaimed or restored
+ * @cmd_count: Number of command objects that are not retired yet
+ * @last_active: Time in jiffies the last command object was retired
  */
 struct kgsl_process_private {
 	unsigned long priv;
@@ -462,14 +491,19 @@ struct kgsl_process_private {
 	atomic_t ctxt_count;
 	spinlock_t ctxt_count_lock;
 	atomic64_t frame_count;
+	struct rw_semaphore reclaim_sem;
+	atomic_t cmd_count;
+	unsigned long last_active;
 };
 
 /**
  * enum kgsl_process_priv_flags - Private flags for kgsl_process_private
  * @KGSL_PROCESS_INIT: Set if the process structure has been set up
+ * @KGSL_PROCESS_RECLAIMED: Set if some memory of the process was reclaimed
  */
 enum kgsl_process_priv_flags {
 	KGSL_PROCESS_INIT = 0,
+	KGSL_PROCESS_RECLAIMED,
 };
 
 struct kgsl_device_private {
@@ -494,6 +528,7 @@ struct kgsl_device_private {
  * @mempool_size: Size of the memory pool
  * @obj_list: List of frozen GPU buffers that are waiting to be dumped.
  * @cp_list: List of IB's to be dumped.
+ * @ib_list: List of IB's to be parsed by the worker once recovery is underway
  * @work: worker to dump the frozen memory
  * @dump_gate: completion gate signaled by worker when it is finished.
  * @process: the process that caused the hang, if known.
@@ -517,6 +552,7 @@ struct kgsl_snapshot {
 	size_t mempool_size;
 	struct list_head obj_list;
 	struct list_head cp_list;
+	struct list_head ib_list;
 	struct work_struct work;
 	struct completion dump_gate;
 	struct kgsl_process_private *process;
@@ -954,6 +990,9 @@ struct adreno_ib_object_list;
 int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	struct adreno_ib_object_list *ib_obj_list);
 
+int kgsl_snapshot_defer_ib(struct kgsl_snapshot *snapshot,
+	struct kgsl_process_private *process, u64 gpuaddr, u64 dwords);
+
 void kgsl_snapshot_add_section(struct kgsl_device *device, u16 id,
 	struct kgsl_snapshot *snapshot,
 	size_t (*func)(struct kgsl_device *, u8 *, size_t, void *),
@@ -20,11 +20,13 @@
 
 #include <linux/slab.h>
 #include <linux/dma-fence-array.h>
+#include <linux/sync_file.h>
 
 #include "adreno_drawctxt.h"
 #include "kgsl_compat.h"
 #include "kgsl_device.h"
 #include "kgsl_drawobj.h"
+#include "kgsl_reclaim.h"
 #include "kgsl_sync.h"
 #include "kgsl_timeline.h"
 #include "kgsl_trace.h"
@@ -74,6 +76,10 @@ void kgsl_drawobj_destroy_object(struct kref *kref)
 	struct kgsl_drawobj *drawobj = container_of(kref,
 		struct kgsl_drawobj, refcount);
 
+	/* Commands keep the memory of the process resident until retired */
+	if (drawobj->type & (CMDOBJ_TYPE | MARKEROBJ_TYPE))
+		kgsl_reclaim_cmd_done(drawobj->context->proc_priv);
+
 	kgsl_context_put(drawobj->context);
 	drawobj->destroy_object(drawobj);
 }
@@ -199,6 +205,46 @@ static void syncobj_timer(struct timer_list *t)
 	dev_err(device->dev, "--gpu syncpoint deadlock print end--\n");
 }
 
+/**
+ * kgsl_drawobj_sync_sched_work() - Kick the dispatcher for a context whose
+ * sync points expired
+ * @work: The context's sync_sched_work
+ */
+void kgsl_drawobj_sync_sched_work(struct kthread_work *work)
+{
+	struct kgsl_context *context = container_of(work, struct kgsl_context,
+		sync_sched_work);
+	struct kgsl_device *device = context->device;
+
+	/* Expiries from here on need a new kick */
+	clear_bit(KGSL_CONTEXT_PRIV_SYNC_SCHED, &context->priv);
+
+	device->ftbl->drawctxt_sched(device, context);
+	kgsl_context_put(context);
+}
+
+/*
+ * Sync objects of a context tend to expire in bursts, e.g. all the fences
+ * of a frame signaling together. Funnel them through one queued work so the
+ * dispatcher gets kicked once per burst rather than once per sync object.
+ */
+static void drawobj_sync_sched(struct kgsl_device *device,
+	struct kgsl_context *context)
+{
+	if (!device->ftbl->drawctxt_sched)
+		return;
+
+	if (test_and_set_bit(KGSL_CONTEXT_PRIV_SYNC_SCHED, &context->priv))
+		return;
+
+	if (!_kgsl_context_get(context)) {
+		clear_bit(KGSL_CONTEXT_PRIV_SYNC_SCHED, &context->priv);
+		return;
+	}
+
+	kthread_queue_work(&kgsl_driver.worker, &context->sync_sched_work);
+}
+
 /*
  * a generic function to retire a pending sync event and (possibly) kick the
  * dispatcher.
@@ -224,9 +270,7 @@ static bool drawobj_sync_expire(struct kgsl_device *device,
 	if (!kgsl_drawobj_events_pending(event->syncobj)) {
 		del_timer(&syncobj->timer);
 
-		if (device->ftbl->drawctxt_sched)
-			device->ftbl->drawctxt_sched(device,
-				event->syncobj->base.context);
+		drawobj_sync_sched(device, event->syncobj->base.context);
 	}
 	return true;
 }
@@ -537,11 +581,27 @@ static int drawobj_add_sync_fence(struct kgsl_device *device,
 	struct kgsl_drawobj *drawobj = DRAWOBJ(syncobj);
 	struct kgsl_drawobj_sync_event *event;
 	struct event_fence_info *priv;
+	struct dma_fence *fence;
 	unsigned int id, i;
 
 	if (copy_struct_from_user(&sync, sizeof(sync), data, datasize))
 		return -EFAULT;
 
+	/*
+	 * Most fences handed in by userspace have signaled by the time the
+	 * command is submitted - don't set up a wait for those
+	 */
+	fence = sync_file_get_fence(sync.fd);
+	if (fence) {
+		bool signaled = dma_fence_is_signaled(fence);
+
+		dma_fence_put(fence);
+		if (signaled) {
+			trace_syncpoint_fence_expire(syncobj, "signaled");
+			return 0;
+		}
+	}
+
 	kref_get(&drawobj->refcount);
 
 	id = syncobj->numsyncs++;
@@ -630,6 +690,14 @@ static int drawobj_add_sync_timestamp(struct kgsl_device *device,
 		}
 	}
 
+	/* Nothing to wait for if the timestamp already retired */
+	if (kgsl_check_timestamp(device, context, timestamp->timestamp)) {
+		trace_syncpoint_timestamp_expire(syncobj, context,
+			timestamp->timestamp);
+		kgsl_context_put(context);
+		return 0;
+	}
+
 	kref_get(&drawobj->refcount);
 
 	id = syncobj->numsyncs++;
@@ -980,6 +1048,14 @@ struct kgsl_drawobj_cmd *kgsl_drawobj_cmd_create(struct kgsl_device *device,
 		return ERR_PTR(ret);
 	}
 
+	/* Fault back any reclaimed memory before the GPU gets to see it */
+	ret = kgsl_reclaim_cmd_start(context->proc_priv);
+	if (ret) {
+		kgsl_context_put(context);
+		kfree(cmdobj);
+		return ERR_PTR(ret);
+	}
+
 	cmdobj->base.destroy = cmdobj_destroy;
 	cmdobj->base.destroy_object = cmdobj_destroy_object;
 
@@ -237,6 +237,8 @@ void kgsl_dump_syncpoints(struct kgsl_device *device,
 
 void kgsl_drawobj_destroy(struct kgsl_drawobj *drawobj);
 
+void kgsl_drawobj_sync_sched_work(struct kthread_work *work);
+
 void kgsl_drawobj_destroy_object(struct kref *kref);
 
 static inline bool kgsl_drawobj_events_pending(
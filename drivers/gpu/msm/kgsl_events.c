@@ -16,12 +16,24 @@
  */
 static struct kmem_cache *events_cache;
 
+/*
+ * Hand the event over to the device callback worker. Only the first event
+ * added to an empty list needs to kick the worker, the rest ride along.
+ */
+static void queue_event(struct kgsl_device *device, struct kgsl_event *event)
+{
+	event->signaled = ktime_get_ns();
+
+	if (llist_add(&event->retire_node, &device->events_retired))
+		queue_work(device->events_wq, &device->events_work);
+}
+
 static inline void signal_event(struct kgsl_device *device,
 		struct kgsl_event *event, int result)
 {
 	list_del(&event->node);
 	event->result = result;
-	queue_work(device->events_wq, &event->work);
+	queue_event(device, event);
 }
 
 static const char *priorities[KGSL_EVENT_NUM_PRIORITIES] = {
@@ -39,23 +51,63 @@ const char *prio_to_string(enum kgsl_priority prio)
 
 /**
  * _kgsl_event_worker() - Work handler for processing GPU event callbacks
- * @work: Pointer to the work_struct for the event
+ * @work: Pointer to the events work_struct of the device
  *
- * Each event callback has its own work struct and is run on a event specific
- * workqeuue.  This is the worker that queues up the event callback function.
+ * All the events signaled since the last run are collected in a single list
+ * on the device, so one pass of this worker runs every callback that became
+ * ready during a retire interrupt, in the order they were signaled.
  */
 static void _kgsl_event_worker(struct work_struct *work)
 {
-	struct kgsl_event *event = container_of(work, struct kgsl_event, work);
-	int id = KGSL_CONTEXT_ID(event->context);
+	struct kgsl_device *device = container_of(work, struct kgsl_device,
+		events_work);
+	struct llist_node *list = llist_del_all(&device->events_retired);
+	struct kgsl_event *event, *tmp;
 
-	trace_kgsl_fire_event(id, event->timestamp, event->result,
-		jiffies - event->created, event->func, event->prio);
+	if (!list)
+		return;
 
-	event->func(event->device, event->group, event->priv, event->result);
+	device->events_stats.batches++;
 
-	kgsl_context_put(event->context);
-	kmem_cache_free(events_cache, event);
+	list = llist_reverse_order(list);
+
+	llist_for_each_entry_safe(event, tmp, list, retire_node) {
+		int id = KGSL_CONTEXT_ID(event->context);
+		u64 latency = ktime_get_ns() - event->signaled;
+
+		device->events_stats.fired++;
+		device->events_stats.latency_total += latency;
+		if (latency > device->events_stats.latency_max)
+			device->events_stats.latency_max = latency;
+
+		trace_kgsl_fire_event(id, event->timestamp, event->result,
+			jiffies - event->created, event->func, event->prio);
+
+		event->func(event->device, event->group, event->priv,
+			event->result);
+
+		kgsl_context_put(event->context);
+		kmem_cache_free(events_cache, event);
+	}
+}
+
+/*
+ * Keep the group list sorted by timestamp. New events are almost always for
+ * the newest timestamp, so look for the spot starting from the tail.
+ */
+static void _add_event_sorted(struct kgsl_event_group *group,
+		struct kgsl_event *event)
+{
+	struct kgsl_event *pos;
+
+	list_for_each_entry_reverse(pos, &group->events, node) {
+		if (timestamp_cmp(pos->timestamp, event->timestamp) <= 0) {
+			list_add(&event->node, &pos->node);
+			return;
+		}
+	}
+
+	list_add(&event->node, &group->events);
 }
 
 /* return true if the group needs to be processed */
@@ -107,7 +159,9 @@ static void _process_event_group(struct kgsl_device *device,
 			signal_event(device, event, KGSL_EVENT_RETIRED);
 		else if (flush)
 			signal_event(device, event, KGSL_EVENT_CANCELLED);
-
+		else
+			/* The list is sorted so the rest are still pending */
+			break;
 	}
 
 	group->processed = timestamp;
@@ -276,8 +330,6 @@ static int kgsl_add_event_common(struct kgsl_device *device,
 	event->group = group;
 	event->prio = prio;
 
-	INIT_WORK(&event->work, _kgsl_event_worker);
-
 	trace_kgsl_register_event(
 		KGSL_CONTEXT_ID(context), timestamp, func, prio);
 
@@ -292,13 +344,13 @@ static int kgsl_add_event_common(struct kgsl_device *device,
 
 	if (timestamp_cmp(retired, timestamp) >= 0) {
 		event->result = KGSL_EVENT_RETIRED;
-		queue_work(device->events_wq, &event->work);
+		queue_event(device, event);
 		spin_unlock(&group->lock);
 		return 0;
 	}
 
 	/* Add the event to the group list */
-	list_add_tail(&event->node, &group->events);
+	_add_event_sorted(group, event);
 
 	spin_unlock(&group->lock);
 
@@ -409,6 +461,12 @@ static int events_debugfs_print(struct seq_file *s, void *unused)
 {
 	struct kgsl_device *device = s->private;
 	struct kgsl_event_group *group;
+	u64 fired = device->events_stats.fired;
+
+	seq_printf(s, "callbacks: %llu batches: %llu latency avg: %lluns max: %lluns\n\n",
+		fired, device->events_stats.batches,
+		fired ? div64_u64(device->events_stats.latency_total, fired) : 0,
+		device->events_stats.latency_max);
 
 	seq_puts(s, "event groups:\n");
 	seq_puts(s, "--------------\n");
@@ -452,6 +510,9 @@ void kgsl_device_events_probe(struct kgsl_device *device)
 	INIT_LIST_HEAD(&device->event_groups);
 	rwlock_init(&device->event_groups_lock);
 
+	init_llist_head(&device->events_retired);
+	INIT_WORK(&device->events_work, _kgsl_event_worker);
+
 	debugfs_create_file("events", 0444, device->d_debugfs, device,
 		&events_fops);
 }
@@ -406,6 +406,56 @@ static int _iommu_map_sg(struct kgsl_pagetable *pt,
 	return 0;
 }
 
+static enum kgsl_map_granule _iommu_granule(size_t pgsize)
+{
+	if (pgsize >= SZ_2M)
+		return KGSL_MAP_GRANULE_2M;
+	else if (pgsize >= SZ_64K)
+		return KGSL_MAP_GRANULE_64K;
+
+	return KGSL_MAP_GRANULE_4K;
+}
+
+/*
+ * Record the page sizes the IOMMU picks for a sg mapping. This follows the
+ * same largest-fit split that iommu_map() does for each sg entry.
+ */
+static void _iommu_count_granules(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc, uint64_t addr,
+		struct scatterlist *sgl, int nents)
+{
+	struct kgsl_iommu_pt *iommu_pt = pt->priv;
+	unsigned long pgsizes = iommu_pt->domain->pgsize_bitmap;
+	struct scatterlist *sg;
+	int i;
+
+	memset(memdesc->map_granule, 0, sizeof(memdesc->map_granule));
+
+	for_each_sg(sgl, sg, nents, i) {
+		phys_addr_t phys = sg_phys(sg);
+		size_t len = sg->length;
+
+		while (len) {
+			unsigned long mask = pgsizes & GENMASK(__fls(len), 0);
+			size_t pgsize;
+
+			if (addr | phys)
+				mask &= GENMASK(__ffs(addr | phys), 0);
+
+			if (!mask)
+				return;
+
+			pgsize = BIT(__fls(mask));
+			memdesc->map_granule[_iommu_granule(pgsize)] +=
+				pgsize >> PAGE_SHIFT;
+
+			addr += pgsize;
+			phys += pgsize;
+			len -= pgsize;
+		}
+	}
+}
+
 /*
  * One page allocation for a guard region to protect against over-zealous
  * GPU pre-fetch
@@ -1602,6 +1652,50 @@ kgsl_iommu_unmap(struct kgsl_pagetable *pt, struct kgsl_memdesc *memdesc)
 		kgsl_memdesc_footprint(memdesc));
 }
 
+/*
+ * Unmap a batch of memdescs and invalidate the TLB once for all of them.
+ * Returns a mask of the memdescs that could not be unmapped.
+ */
+static u64
+kgsl_iommu_unmap_batch(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc **memdescs, int count)
+{
+	struct kgsl_device *device = KGSL_MMU_DEVICE(pt->mmu);
+	struct kgsl_iommu_pt *iommu_pt = pt->priv;
+	struct iommu_iotlb_gather gather;
+	u64 failed = 0;
+	int i;
+
+	iommu_iotlb_gather_init(&gather);
+
+	for (i = 0; i < count; i++) {
+		uint64_t addr = memdescs[i]->gpuaddr;
+		uint64_t size = kgsl_memdesc_footprint(memdescs[i]);
+		size_t unmapped;
+
+		if (memdescs[i]->size == 0 || addr == 0) {
+			failed |= BIT_ULL(i);
+			continue;
+		}
+
+		/* Sign extend TTBR1 addresses all the way to avoid warning */
+		if (addr & (1ULL << 48))
+			addr |= 0xffff000000000000;
+
+		unmapped = iommu_unmap_fast(iommu_pt->domain, addr, size,
+			&gather);
+		if (unmapped != size) {
+			dev_err(device->dev, "unmap err: 0x%016llx, 0x%llx, %zd\n",
+				addr, size, unmapped);
+			failed |= BIT_ULL(i);
+		}
+	}
+
+	iommu_tlb_sync(iommu_pt->domain, &gather);
+
+	return failed;
+}
+
 /**
  * _iommu_map_guard_page - Map iommu guard page
  * @pt - Pointer to kgsl pagetable structure
@@ -1719,6 +1813,8 @@ kgsl_iommu_map(struct kgsl_pagetable *pt,
 	if (ret)
 		goto done;
 
+	_iommu_count_granules(pt, memdesc, addr, sgt->sgl, sgt->nents);
+
 	ret = _iommu_map_guard_page(pt, memdesc, addr + size, flags);
 	if (ret)
 		_iommu_unmap(pt, addr, size);
@@ -2560,6 +2656,7 @@ static const struct kgsl_mmu_ops kgsl_iommu_ops = {
 static const struct kgsl_mmu_pt_ops iommu_pt_ops = {
 	.mmu_map = kgsl_iommu_map,
 	.mmu_unmap = kgsl_iommu_unmap,
+	.mmu_unmap_batch = kgsl_iommu_unmap_batch,
 	.mmu_destroy_pagetable = kgsl_iommu_destroy_pagetable,
 	.get_ttbr0 = kgsl_iommu_get_ttbr0,
 	.get_contextidr = kgsl_iommu_get_contextidr,
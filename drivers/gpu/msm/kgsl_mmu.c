@@ -446,6 +446,55 @@ void kgsl_mmu_put_gpuaddr(struct kgsl_memdesc *memdesc)
 
 }
 
+/**
+ * kgsl_mmu_put_gpuaddr_batch() - Unmap and release several GPU addresses
+ * @pagetable: Pagetable all of the memdescs are mapped in
+ * @memdescs: Array of up to KGSL_MMU_UNMAP_BATCH mapped, non global memdescs
+ * @count: Number of memdescs in @memdescs
+ *
+ * Works like kgsl_mmu_put_gpuaddr() on each memdesc, but the TLB is
+ * invalidated once for the whole batch. No GPU address is handed back to the
+ * pagetable before that invalidate, so none can be reused while stale TLB
+ * entries may still point at it.
+ */
+void kgsl_mmu_put_gpuaddr_batch(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc **memdescs, int count)
+{
+	struct kgsl_device *device = KGSL_MMU_DEVICE(pagetable->mmu);
+	u64 failed;
+	int i;
+
+	if (!PT_OP_VALID(pagetable, mmu_unmap_batch)) {
+		for (i = 0; i < count; i++)
+			kgsl_mmu_put_gpuaddr(memdescs[i]);
+		return;
+	}
+
+	failed = pagetable->pt_ops->mmu_unmap_batch(pagetable, memdescs, count);
+
+	for (i = 0; i < count; i++) {
+		struct kgsl_memdesc *memdesc = memdescs[i];
+		uint64_t size = kgsl_memdesc_footprint(memdesc);
+
+		atomic_dec(&pagetable->stats.entries);
+		atomic_long_sub(size, &pagetable->stats.mapped);
+
+		memdesc->priv &= ~KGSL_MEMDESC_MAPPED;
+		if (!(memdesc->flags & KGSL_MEMFLAGS_USERMEM_ION))
+			kgsl_trace_gpu_mem_total(device, -(size));
+
+		/* Keep addresses that failed to unmap out of circulation */
+		if (PT_OP_VALID(pagetable, put_gpuaddr) &&
+				!(failed & BIT_ULL(i)))
+			pagetable->pt_ops->put_gpuaddr(memdesc);
+
+		memdesc->pagetable = NULL;
+		memdesc->gpuaddr = 0;
+	}
+
+	kgsl_mmu_trace_gpu_mem_pagetable(pagetable);
+}
+
 /**
  * kgsl_mmu_svm_range() - Return the range for SVM (if applicable)
  * @pagetable: Pagetable to query the range from
@@ -73,11 +73,16 @@ struct kgsl_mmu_ops {
 		struct kgsl_memdesc *memdesc, u32 padding);
 };
 
+/* Max number of memdescs unmapped with a single TLB invalidate */
+#define KGSL_MMU_UNMAP_BATCH 64
+
 struct kgsl_mmu_pt_ops {
 	int (*mmu_map)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc);
 	int (*mmu_unmap)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc);
+	u64 (*mmu_unmap_batch)(struct kgsl_pagetable *pt,
+			struct kgsl_memdesc **memdescs, int count);
 	void (*mmu_destroy_pagetable)(struct kgsl_pagetable *pt);
 	u64 (*get_ttbr0)(struct kgsl_pagetable *pt);
 	u32 (*get_contextidr)(struct kgsl_pagetable *pt);
@@ -171,6 +176,8 @@ int kgsl_mmu_map(struct kgsl_pagetable *pagetable,
 int kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
 		    struct kgsl_memdesc *memdesc);
 void kgsl_mmu_put_gpuaddr(struct kgsl_memdesc *memdesc);
+void kgsl_mmu_put_gpuaddr_batch(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc **memdescs, int count);
 unsigned int kgsl_virtaddr_to_physaddr(void *virtaddr);
 unsigned int kgsl_mmu_log_fault_addr(struct kgsl_mmu *mmu,
 		u64 ttbr0, uint64_t addr);
@@ -6,13 +6,49 @@
 #include <asm/cacheflush.h>
 #include <linux/highmem.h>
 #include <linux/of.h>
+#include <linux/percpu.h>
 #include <linux/scatterlist.h>
+#include <linux/workqueue.h>
 
 #include "kgsl_device.h"
 #include "kgsl_pool.h"
 #include "kgsl_sharedmem.h"
 #include "kgsl_trace.h"
 
+/* Max number of pages held in each per cpu magazine */
+#define KGSL_POOL_PCP_MAX 16
+
+/* Max size of each per cpu magazine, bigger pages skip the magazine */
+#define KGSL_POOL_PCP_BYTES SZ_256K
+
+/* Upper limit for the prefill target, same as for reserved pages */
+#define KGSL_POOL_PREFILL_MAX 4096
+
+/*
+ * Largest chunk handed out for big buffers so the GPU can map it with a
+ * single block entry. Without a pool of this order it is taken straight
+ * from the buddy allocator without reclaim.
+ */
+#define KGSL_POOL_BLOCK_SIZE SZ_2M
+
+/**
+ * struct kgsl_pool_pcp - Per cpu magazine of pages in front of a pool
+ * @count: Number of pages in @pages
+ * @hits: Pages handed out from the pool on this cpu
+ * @misses: Allocations on this cpu that found the pool empty
+ * @refills: Batches moved from the pool list into the magazine
+ * @drains: Batches moved from the magazine back to the pool list
+ * @pages: Stack of pages, the most recently freed on top
+ */
+struct kgsl_pool_pcp {
+	unsigned int count;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long refills;
+	unsigned long drains;
+	struct page *pages[KGSL_POOL_PCP_MAX];
+};
+
 /**
  * struct kgsl_page_pool - Structure to hold information for the pool
  * @pool_order: Page order describing the size of the page
@@ -20,6 +56,11 @@
  * @reserved_pages: Number of pages reserved at init for the pool
  * @list_lock: Spinlock for page list in the pool
  * @page_list: List of pages held/reserved in this pool
+ * @pcp: Per cpu magazines, taken and refilled without @list_lock
+ * @pcp_size: Capacity of each magazine, 0 if magazines are not used
+ * @pcp_count: Number of pages held in all magazines of the pool
+ * @zeroed_list: Pages already zeroed and cleaned for kgsl_pool_zero_dev
+ * @zeroed_count: Number of pages in @zeroed_list, also under @list_lock
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -27,13 +68,33 @@ struct kgsl_page_pool {
 	unsigned int reserved_pages;
 	spinlock_t list_lock;
 	struct list_head page_list;
+	struct kgsl_pool_pcp __percpu *pcp;
+	unsigned int pcp_size;
+	atomic_t pcp_count;
+	struct list_head zeroed_list;
+	unsigned int zeroed_count;
 };
 
 static struct kgsl_page_pool kgsl_pools[6];
 static int kgsl_num_pools;
 static int kgsl_pool_max_pages;
 
+/* Pages the prefill worker keeps in the list of every pool */
+static unsigned int kgsl_pool_prefill_pages;
+/* Pages the prefill worker keeps zeroed and cleaned in every pool */
+static unsigned int kgsl_pool_prezero_pages;
+/* Device the zeroed pages were synced for, first seen at allocation */
+static struct device *kgsl_pool_zero_dev;
+/* Last time the shrinker asked for pages, pauses the prefill worker */
+static unsigned long kgsl_pool_last_shrink;
+static bool kgsl_pool_sysfs;
+
 static void kgsl_pool_free_page(struct page *page);
+static void kgsl_pool_prefill(struct work_struct *work);
+static void kgsl_pool_drain_pcp(struct work_struct *work);
+
+static DECLARE_WORK(kgsl_pool_prefill_work, kgsl_pool_prefill);
+static DECLARE_WORK(kgsl_pool_drain_work, kgsl_pool_drain_pcp);
 
 /* Return the index of the pool for the specified order */
 static int kgsl_get_pool_index(int order)
@@ -138,23 +199,189 @@ _kgsl_pool_get_page(struct kgsl_page_pool *pool)
 	return p;
 }
 
-/* Returns the number of pages in all kgsl page pools */
-static int kgsl_pool_size_total(void)
+/* Move a batch of pages from the pool list into the magazine */
+static void kgsl_pool_pcp_refill(struct kgsl_page_pool *pool,
+		struct kgsl_pool_pcp *pcp)
+{
+	unsigned int batch = max(pool->pcp_size >> 1, 1U);
+	struct page *p;
+
+	spin_lock(&pool->list_lock);
+	while (batch-- && pcp->count < pool->pcp_size) {
+		p = list_first_entry_or_null(&pool->page_list, struct page,
+				lru);
+		if (!p)
+			break;
+
+		list_del(&p->lru);
+		pool->page_count--;
+		pcp->pages[pcp->count++] = p;
+		atomic_inc(&pool->pcp_count);
+	}
+	spin_unlock(&pool->list_lock);
+
+	pcp->refills++;
+}
+
+/* Move the @nr least recently freed pages of the magazine to the pool list */
+static void kgsl_pool_pcp_drain(struct kgsl_page_pool *pool,
+		struct kgsl_pool_pcp *pcp, unsigned int nr)
+{
+	unsigned int i;
+
+	nr = min(nr, pcp->count);
+	if (!nr)
+		return;
+
+	spin_lock(&pool->list_lock);
+	for (i = 0; i < nr; i++)
+		list_add_tail(&pcp->pages[i]->lru, &pool->page_list);
+	pool->page_count += nr;
+	spin_unlock(&pool->list_lock);
+
+	pcp->count -= nr;
+	memmove(pcp->pages, pcp->pages + nr, pcp->count * sizeof(*pcp->pages));
+	atomic_sub(nr, &pool->pcp_count);
+
+	pcp->drains++;
+}
+
+static void kgsl_pool_kick_prefill(struct kgsl_page_pool *pool)
+{
+	if ((READ_ONCE(pool->page_count) < READ_ONCE(kgsl_pool_prefill_pages) ||
+		READ_ONCE(pool->zeroed_count) <
+			READ_ONCE(kgsl_pool_prezero_pages)) &&
+			!work_pending(&kgsl_pool_prefill_work))
+		queue_work(system_unbound_wq, &kgsl_pool_prefill_work);
+}
+
+/* Returns a page from the zeroed list of the pool, if usable for @dev */
+static struct page *
+_kgsl_pool_get_zeroed_page(struct kgsl_page_pool *pool, struct device *dev)
+{
+	struct page *p;
+
+	if (!READ_ONCE(pool->zeroed_count))
+		return NULL;
+
+	/* Pages were only cleaned for kgsl_pool_zero_dev */
+	if (dev && dev != READ_ONCE(kgsl_pool_zero_dev))
+		return NULL;
+
+	spin_lock(&pool->list_lock);
+	p = list_first_entry_or_null(&pool->zeroed_list, struct page, lru);
+	if (p) {
+		list_del(&p->lru);
+		pool->zeroed_count--;
+	}
+	spin_unlock(&pool->list_lock);
+
+	if (!p)
+		return NULL;
+
+	trace_kgsl_pool_get_page(pool->pool_order, pool->page_count);
+	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
+			-(1 << pool->pool_order));
+	kgsl_pool_kick_prefill(pool);
+
+	return p;
+}
+
+/* Returns a page from the magazine of this cpu or else the pool list */
+static struct page *kgsl_pool_get_page(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_pcp *pcp;
+	struct page *p = NULL;
+
+	if (!pool->pcp_size) {
+		p = _kgsl_pool_get_page(pool);
+		kgsl_pool_kick_prefill(pool);
+		goto done;
+	}
+
+	pcp = get_cpu_ptr(pool->pcp);
+	if (!pcp->count) {
+		kgsl_pool_pcp_refill(pool, pcp);
+		kgsl_pool_kick_prefill(pool);
+	}
+	if (pcp->count) {
+		p = pcp->pages[--pcp->count];
+		atomic_dec(&pool->pcp_count);
+	}
+	put_cpu_ptr(pool->pcp);
+
+	if (p) {
+		trace_kgsl_pool_get_page(pool->pool_order, pool->page_count);
+		mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
+				-(1 << pool->pool_order));
+	}
+done:
+	if (p)
+		this_cpu_inc(pool->pcp->hits);
+	else
+		this_cpu_inc(pool->pcp->misses);
+
+	return p;
+}
+
+/* Returns a page to the magazine of this cpu, draining it if full */
+static void kgsl_pool_put_page(struct kgsl_page_pool *pool, struct page *p)
+{
+	struct kgsl_pool_pcp *pcp;
+
+	if (!pool->pcp_size) {
+		_kgsl_pool_add_page(pool, p);
+		return;
+	}
+
+	/* Same check as _kgsl_pool_add_page() */
+	if (WARN_ON(unlikely(page_count(p) > 1))) {
+		__free_pages(p, pool->pool_order);
+		return;
+	}
+
+	pcp = get_cpu_ptr(pool->pcp);
+	if (pcp->count == pool->pcp_size)
+		kgsl_pool_pcp_drain(pool, pcp, max(pool->pcp_size >> 1, 1U));
+	pcp->pages[pcp->count++] = p;
+	atomic_inc(&pool->pcp_count);
+	put_cpu_ptr(pool->pcp);
+
+	trace_kgsl_pool_add_page(pool->pool_order, pool->page_count);
+	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
+				(1 << pool->pool_order));
+}
+
+/*
+ * Returns the number of pages in all kgsl page pools, including or not
+ * the pages held in the per cpu magazines. This is only a snapshot and is
+ * read without the pool locks.
+ */
+static int kgsl_pool_size(bool pcp)
 {
 	int i;
 	int total = 0;
 
 	for (i = 0; i < kgsl_num_pools; i++) {
 		struct kgsl_page_pool *kgsl_pool = &kgsl_pools[i];
+		int count = READ_ONCE(kgsl_pool->page_count) +
+			READ_ONCE(kgsl_pool->zeroed_count);
 
-		spin_lock(&kgsl_pool->list_lock);
-		total += kgsl_pool->page_count * (1 << kgsl_pool->pool_order);
-		spin_unlock(&kgsl_pool->list_lock);
+		if (pcp)
+			count += atomic_read(&kgsl_pool->pcp_count);
+
+		total += count * (1 << kgsl_pool->pool_order);
 	}
 
 	return total;
 }
 
+/* Returns the number of pages in all kgsl page pools */
+static int kgsl_pool_size_total(void)
+{
+	return kgsl_pool_size(true);
+}
+
 /*
  * Returns a page from specified pool only if pool
  * currently holds more number of pages than reserved
@@ -210,6 +437,9 @@ _kgsl_pool_shrink(struct kgsl_page_pool *pool,
 	for (j = 0; j < num_pages; j++) {
 		struct page *page = get_page(pool);
 
+		/* Zeroed pages are only a latency optimization, drop them too */
+		if (!page)
+			page = _kgsl_pool_get_zeroed_page(pool, NULL);
 		if (!page)
 			break;
 
@@ -337,7 +567,7 @@ static bool kgsl_pool_available(unsigned int page_size)
 {
 	int order = ilog2(page_size >> PAGE_SHIFT);
 
-	if (!kgsl_num_pools)
+	if (!kgsl_num_pools || page_size == KGSL_POOL_BLOCK_SIZE)
 		return true;
 
 	return (kgsl_get_pool_index(order) >= 0);
@@ -347,7 +577,7 @@ static int kgsl_get_page_size(size_t size, unsigned int align)
 {
 	size_t pool;
 
-	for (pool = SZ_1M; pool > PAGE_SIZE; pool >>= 1)
+	for (pool = KGSL_POOL_BLOCK_SIZE; pool > PAGE_SIZE; pool >>= 1)
 		if ((align >= ilog2(pool)) && (size >= pool) &&
 			kgsl_pool_available(pool))
 			return pool;
@@ -376,6 +606,7 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	int order = get_order(*page_size);
 	int pool_idx;
 	size_t size = 0;
+	bool zeroed = false;
 
 	if ((pages == NULL) || pages_len < (*page_size >> PAGE_SHIFT))
 		return -EINVAL;
@@ -400,6 +631,15 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 
 	pool = _kgsl_get_pool_from_order(order);
 	if (pool == NULL) {
+		/* Block sized chunks are only tried opportunistically */
+		if (*page_size == KGSL_POOL_BLOCK_SIZE) {
+			page = alloc_pages(kgsl_gfp_mask(order), order);
+			if (page) {
+				trace_kgsl_pool_alloc_page_system(order);
+				goto done;
+			}
+		}
+
 		/* Retry with lower order pages */
 		if (order > 0) {
 			size = PAGE_SIZE << kgsl_pool_get_retry_order(order);
@@ -420,7 +660,18 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	}
 
 	pool_idx = kgsl_get_pool_index(order);
-	page = _kgsl_pool_get_page(pool);
+
+	/* Remember the device so the prefill worker can clean pages for it */
+	if (dev && !READ_ONCE(kgsl_pool_zero_dev))
+		WRITE_ONCE(kgsl_pool_zero_dev, dev);
+
+	page = _kgsl_pool_get_zeroed_page(pool, dev);
+	if (page) {
+		zeroed = true;
+		goto done;
+	}
+
+	page = kgsl_pool_get_page(pool);
 
 	/* Allocate a new page if not allocated from pool */
 	if (page == NULL) {
@@ -442,7 +693,8 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	}
 
 done:
-	_kgsl_pool_zero_page(page, order, dev);
+	if (!zeroed)
+		_kgsl_pool_zero_page(page, order, dev);
 
 	for (j = 0; j < (*page_size >> PAGE_SHIFT); j++) {
 		p = nth_page(page, j);
@@ -475,8 +727,8 @@ int kgsl_pool_alloc_pages(u64 size, struct page ***pages, struct device *dev)
 	if (!local)
 		return -ENOMEM;
 
-	/* Start with 1MB alignment to get the biggest page we can */
-	align = ilog2(SZ_1M);
+	/* Start with block alignment to get the biggest page we can */
+	align = ilog2(KGSL_POOL_BLOCK_SIZE);
 
 	page_size = kgsl_get_page_size(len, align);
 
@@ -535,7 +787,7 @@ static void kgsl_pool_free_page(struct page *page)
 			(kgsl_pool_size_total() < kgsl_pool_max_pages)) {
 		pool = _kgsl_get_pool_from_order(page_order);
 		if (pool != NULL) {
-			_kgsl_pool_add_page(pool, page);
+			kgsl_pool_put_page(pool, page);
 			return;
 		}
 	}
@@ -545,14 +797,143 @@ static void kgsl_pool_free_page(struct page *page)
 	trace_kgsl_pool_free_page(page_order);
 }
 
+static bool kgsl_pool_under_pressure(void)
+{
+	return time_before(jiffies, READ_ONCE(kgsl_pool_last_shrink) + HZ);
+}
+
+/* Zero and clean pages into the zeroed list of the pool */
+static void kgsl_pool_prezero(struct kgsl_page_pool *pool, gfp_t gfp_mask)
+{
+	struct device *dev = READ_ONCE(kgsl_pool_zero_dev);
+
+	/* Nothing to clean the pages for until the first allocation */
+	if (!dev)
+		return;
+
+	while (READ_ONCE(pool->zeroed_count) <
+			READ_ONCE(kgsl_pool_prezero_pages)) {
+		struct page *page;
+
+		if (kgsl_pool_under_pressure())
+			return;
+
+		/* Recycle dirty pages of the pool before adding new ones */
+		spin_lock(&pool->list_lock);
+		page = list_first_entry_or_null(&pool->page_list, struct page,
+				lru);
+		if (page) {
+			list_del(&page->lru);
+			pool->page_count--;
+		}
+		spin_unlock(&pool->list_lock);
+
+		if (!page) {
+			if (kgsl_pool_max_pages &&
+				kgsl_pool_size_total() >= kgsl_pool_max_pages)
+				return;
+
+			page = alloc_pages(gfp_mask, pool->pool_order);
+			if (!page)
+				return;
+
+			mod_node_page_state(page_pgdat(page),
+				NR_KERNEL_MISC_RECLAIMABLE,
+				(1 << pool->pool_order));
+		}
+
+		_kgsl_pool_zero_page(page, pool->pool_order, dev);
+
+		spin_lock(&pool->list_lock);
+		list_add_tail(&page->lru, &pool->zeroed_list);
+		pool->zeroed_count++;
+		spin_unlock(&pool->list_lock);
+
+		cond_resched();
+	}
+}
+
+/*
+ * Keep the pool lists topped up to kgsl_pool_prefill_pages and the zeroed
+ * lists to kgsl_pool_prezero_pages. Paused while the shrinker is active.
+ */
+static void kgsl_pool_prefill(struct work_struct *work)
+{
+	int i;
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+		/* Never reclaim to fill the pool, it would fight the shrinker */
+		gfp_t gfp_mask = (kgsl_gfp_mask(pool->pool_order) |
+				__GFP_NOWARN) & ~__GFP_DIRECT_RECLAIM;
+
+		while (READ_ONCE(pool->page_count) <
+				READ_ONCE(kgsl_pool_prefill_pages)) {
+			struct page *page;
+
+			if (kgsl_pool_under_pressure())
+				return;
+
+			if (kgsl_pool_max_pages &&
+				kgsl_pool_size_total() >= kgsl_pool_max_pages)
+				return;
+
+			page = alloc_pages(gfp_mask, pool->pool_order);
+			if (!page)
+				break;
+
+			_kgsl_pool_add_page(pool, page);
+		}
+
+		kgsl_pool_prezero(pool, gfp_mask);
+	}
+}
+
+/* Return the magazine pages of the local cpu to the pool lists */
+static void kgsl_pool_drain_local_pcp(struct work_struct *work)
+{
+	int i;
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+		struct kgsl_pool_pcp *pcp;
+
+		if (!pool->pcp_size)
+			continue;
+
+		pcp = get_cpu_ptr(pool->pcp);
+		kgsl_pool_pcp_drain(pool, pcp, pcp->count);
+		put_cpu_ptr(pool->pcp);
+	}
+}
+
+static void kgsl_pool_drain_pcp(struct work_struct *work)
+{
+	schedule_on_each_cpu(kgsl_pool_drain_local_pcp);
+}
+
 /* Functions for the shrinker */
 
 static unsigned long
 kgsl_pool_shrink_scan_objects(struct shrinker *shrinker,
 					struct shrink_control *sc)
 {
+	unsigned long pcount;
+
+	WRITE_ONCE(kgsl_pool_last_shrink, jiffies);
+
 	/* sc->nr_to_scan represents number of pages to be removed*/
-	return kgsl_pool_reduce(sc->nr_to_scan, false);
+	pcount = kgsl_pool_reduce(sc->nr_to_scan, false);
+
+	/*
+	 * Pages in per cpu magazines can only be reached from their own cpu,
+	 * hand them back to the pool lists for the next scan.
+	 */
+	if (pcount < sc->nr_to_scan &&
+			kgsl_pool_size(true) > kgsl_pool_size(false))
+		schedule_work(&kgsl_pool_drain_work);
+
+	return pcount;
 }
 
 static unsigned long
@@ -611,12 +992,109 @@ static int kgsl_of_parse_mempool(struct kgsl_page_pool *pool,
 
 	spin_lock_init(&pool->list_lock);
 	INIT_LIST_HEAD(&pool->page_list);
+	INIT_LIST_HEAD(&pool->zeroed_list);
+	pool->zeroed_count = 0;
+
+	pool->pcp = alloc_percpu(struct kgsl_pool_pcp);
+	if (!pool->pcp)
+		return -ENOMEM;
+
+	pool->pcp_size = min_t(unsigned int, KGSL_POOL_PCP_MAX,
+			KGSL_POOL_PCP_BYTES >> (PAGE_SHIFT + order));
+	atomic_set(&pool->pcp_count, 0);
 
 	kgsl_pool_reserve_pages(pool, node);
 
 	return 0;
 }
 
+static ssize_t page_pool_stats_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	ssize_t len = 0;
+	int i, cpu;
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+		unsigned long hits = 0, misses = 0, refills = 0, drains = 0;
+
+		for_each_possible_cpu(cpu) {
+			struct kgsl_pool_pcp *pcp = per_cpu_ptr(pool->pcp, cpu);
+
+			hits += pcp->hits;
+			misses += pcp->misses;
+			refills += pcp->refills;
+			drains += pcp->drains;
+		}
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+			"order %u pages %u pcp %d zeroed %u reserved %u hits %lu misses %lu refills %lu drains %lu\n",
+			pool->pool_order, READ_ONCE(pool->page_count),
+			atomic_read(&pool->pcp_count),
+			READ_ONCE(pool->zeroed_count), pool->reserved_pages,
+			hits, misses, refills, drains);
+	}
+
+	return len;
+}
+
+static ssize_t page_pool_prefill_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", kgsl_pool_prefill_pages);
+}
+
+static ssize_t page_pool_prefill_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(kgsl_pool_prefill_pages, min_t(unsigned int, val,
+				KGSL_POOL_PREFILL_MAX));
+	queue_work(system_unbound_wq, &kgsl_pool_prefill_work);
+
+	return count;
+}
+
+static ssize_t page_pool_prezero_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", kgsl_pool_prezero_pages);
+}
+
+static ssize_t page_pool_prezero_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(kgsl_pool_prezero_pages, min_t(unsigned int, val,
+				KGSL_POOL_PREFILL_MAX));
+	queue_work(system_unbound_wq, &kgsl_pool_prefill_work);
+
+	return count;
+}
+
+static DEVICE_ATTR_RO(page_pool_stats);
+static DEVICE_ATTR_RW(page_pool_prefill);
+static DEVICE_ATTR_RW(page_pool_prezero);
+
+static const struct attribute *pool_attr_list[] = {
+	&dev_attr_page_pool_stats.attr,
+	&dev_attr_page_pool_prefill.attr,
+	&dev_attr_page_pool_prezero.attr,
+	NULL,
+};
+
 void kgsl_probe_page_pools(void)
 {
 	struct device_node *node, *child;
@@ -630,6 +1108,8 @@ void kgsl_probe_page_pools(void)
 	of_property_read_u32(node, "qcom,mempool-max-pages",
 			&kgsl_pool_max_pages);
 
+	kgsl_pool_last_shrink = jiffies - HZ;
+
 	for_each_child_of_node(node, child) {
 		if (!kgsl_of_parse_mempool(&kgsl_pools[index], child))
 			index++;
@@ -643,16 +1123,44 @@ void kgsl_probe_page_pools(void)
 	kgsl_num_pools = index;
 	of_node_put(node);
 
+	if (kgsl_num_pools && !sysfs_create_files(&kgsl_driver.virtdev.kobj,
+				pool_attr_list))
+		kgsl_pool_sysfs = true;
+
 	/* Initialize shrinker */
 	register_shrinker(&kgsl_pool_shrinker);
 }
 
 void kgsl_exit_page_pools(void)
 {
-	/* Release all pages in pools, if any.*/
-	kgsl_pool_reduce(INT_MAX, true);
+	int i, cpu;
+
+	if (kgsl_pool_sysfs) {
+		sysfs_remove_files(&kgsl_driver.virtdev.kobj, pool_attr_list);
+		kgsl_pool_sysfs = false;
+	}
 
 	/* Unregister shrinker */
 	unregister_shrinker(&kgsl_pool_shrinker);
+
+	cancel_work_sync(&kgsl_pool_prefill_work);
+	cancel_work_sync(&kgsl_pool_drain_work);
+
+	/* Return pages in magazines to the pool lists */
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+
+		for_each_possible_cpu(cpu)
+			kgsl_pool_pcp_drain(pool, per_cpu_ptr(pool->pcp, cpu),
+				KGSL_POOL_PCP_MAX);
+	}
+
+	/* Release all pages in pools, if any.*/
+	kgsl_pool_reduce(INT_MAX, true);
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		free_percpu(kgsl_pools[i].pcp);
+		kgsl_pools[i].pcp = NULL;
+	}
 }
 
@@ -639,6 +639,28 @@ static ssize_t gpu_clock_stats_show(struct device *dev,
 	return num_chars;
 }
 
+static ssize_t wake_latency_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct kgsl_device *device = dev_get_drvdata(dev);
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	int i, num_chars;
+
+	num_chars = scnprintf(buf, PAGE_SIZE, "%-10s %10s %10s\n", "usecs",
+			"wake", "prewake");
+
+	mutex_lock(&device->mutex);
+	for (i = 0; i < KGSL_WAKE_HIST_BUCKETS; i++)
+		num_chars += scnprintf(buf + num_chars, PAGE_SIZE - num_chars,
+			"%s%-9lu %10u %10u\n",
+			i == KGSL_WAKE_HIST_BUCKETS - 1 ? ">=" : "<",
+			BIT(i == KGSL_WAKE_HIST_BUCKETS - 1 ? i - 1 : i),
+			pwr->wake_hist[i], pwr->prewake_hist[i]);
+	mutex_unlock(&device->mutex);
+
+	return num_chars;
+}
+
 static ssize_t reset_count_show(struct device *dev,
 				struct device_attribute *attr, char *buf)
 {
@@ -1090,6 +1112,7 @@ static DEVICE_ATTR_RW(min_pwrlevel);
 static DEVICE_ATTR_RW(thermal_pwrlevel);
 static DEVICE_ATTR_RO(num_pwrlevels);
 static DEVICE_ATTR_RO(reset_count);
+static DEVICE_ATTR_RO(wake_latency);
 static DEVICE_ATTR_RW(force_clk_on);
 static DEVICE_ATTR_RW(force_bus_on);
 static DEVICE_ATTR_RW(force_rail_on);
@@ -1118,6 +1141,7 @@ static const struct attribute *pwrctrl_attr_list[] = {
 	&dev_attr_thermal_pwrlevel.attr,
 	&dev_attr_num_pwrlevels.attr,
 	&dev_attr_reset_count.attr,
+	&dev_attr_wake_latency.attr,
 	&dev_attr_force_clk_on.attr,
 	&dev_attr_force_bus_on.attr,
 	&dev_attr_force_rail_on.attr,
@@ -1762,6 +1786,23 @@ static int kgsl_pwrctrl_enable(struct kgsl_device *device)
 	return device->ftbl->regulator_enable(device);
 }
 
+void kgsl_pwrctrl_wake_latency(struct kgsl_device *device, ktime_t start,
+		bool prewake)
+{
+	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	s64 usecs = ktime_us_delta(ktime_get(), start);
+	u32 bucket = 0;
+
+	if (usecs > 0)
+		bucket = min_t(u32, ilog2(usecs) + 1,
+				KGSL_WAKE_HIST_BUCKETS - 1);
+
+	if (prewake)
+		pwr->prewake_hist[bucket]++;
+	else
+		pwr->wake_hist[bucket]++;
+}
+
 void kgsl_pwrctrl_clear_l3_vote(struct kgsl_device *device)
 {
 	int status;
@@ -1846,6 +1887,8 @@ static int _init(struct kgsl_device *device)
 static int _wake(struct kgsl_device *device)
 {
 	struct kgsl_pwrctrl *pwr = &device->pwrctrl;
+	unsigned int state = device->state;
+	ktime_t start = ktime_get();
 	int status = 0;
 
 	switch (device->state) {
@@ -1897,6 +1940,10 @@ static int _wake(struct kgsl_device *device)
 		pwr->previous_pwrlevel = pwr->active_pwrlevel;
 		kgsl_start_idle_timer(device);
 		del_timer_sync(&device->pwrctrl.minbw_timer);
+
+		if (state == KGSL_STATE_SLUMBER)
+			kgsl_pwrctrl_wake_latency(device, start,
+				device->flags & KGSL_FLAG_WAKE_ON_TOUCH);
 		break;
 	case KGSL_STATE_AWARE:
 		kgsl_pwrctrl_clk_set_options(device, true);
@@ -21,6 +21,9 @@
 
 #define KGSL_MAX_PWRLEVELS 16
 
+/* Log2 microsecond buckets for the slumber exit latency histogram */
+#define KGSL_WAKE_HIST_BUCKETS 16
+
 #define KGSL_PWRFLAGS_POWER_ON 0
 #define KGSL_PWRFLAGS_CLK_ON   1
 #define KGSL_PWRFLAGS_AXI_ON   2
@@ -179,6 +182,16 @@ struct kgsl_pwrctrl {
 	u64 time_in_pwrlevel[KGSL_MAX_PWRLEVELS];
 	/** @last_stat_updated: The last time stats were updated */
 	ktime_t last_stat_updated;
+	/**
+	 * @wake_hist: Slumber exit latency of wakes started by a submission,
+	 * bucket n counts wakes taking less than 2^n usecs
+	 */
+	u32 wake_hist[KGSL_WAKE_HIST_BUCKETS];
+	/**
+	 * @prewake_hist: Slumber exit latency of wakes started ahead of time
+	 * by a touch event or a KGSL_PROP_GPU_PREWAKE hint
+	 */
+	u32 prewake_hist[KGSL_WAKE_HIST_BUCKETS];
 };
 
 int kgsl_pwrctrl_init(struct kgsl_device *device);
@@ -268,4 +281,15 @@ void kgsl_pwrctrl_irq(struct kgsl_device *device, int state);
  * Clear the l3 vote when going into slumber
  */
 void kgsl_pwrctrl_clear_l3_vote(struct kgsl_device *device);
+
+/**
+ * kgsl_pwrctrl_wake_latency - Account a slumber exit in the wake histogram
+ * @device: Handle to the kgsl device
+ * @start: Time the wake started
+ * @prewake: True if the wake was started ahead of time by a hint
+ *
+ * Must be called with the device mutex held.
+ */
+void kgsl_pwrctrl_wake_latency(struct kgsl_device *device, ktime_t start,
+		bool prewake);
 #endif /* __KGSL_PWRCTRL_H */
@@ -17,8 +17,14 @@ static struct devfreq_msm_adreno_tz_data adreno_tz_data = {
 		.floating = true,
 	},
 	.mod_percent = 100,
+	.frame = {
+		.headroom = 10,
+	},
 };
 
+/* Frames further apart than this are idle gaps, not a frame rate */
+#define KGSL_FRAME_MAX_PERIOD_US 100000
+
 /**
  * struct kgsl_midframe_info - midframe power stats sampling info
  * @timer - midframe sampling timer
@@ -34,6 +40,7 @@ static struct kgsl_midframe_info {
 static void do_devfreq_suspend(struct work_struct *work);
 static void do_devfreq_resume(struct work_struct *work);
 static void do_devfreq_notify(struct work_struct *work);
+static void do_devfreq_frame(struct work_struct *work);
 
 /*
  * These variables are used to keep the latest data
@@ -75,6 +82,8 @@ void kgsl_pwrscale_wake(struct kgsl_device *device)
 	/* clear old stats before waking */
 	memset(&psc->accum_stats, 0, sizeof(psc->accum_stats));
 	memset(&last_xstats, 0, sizeof(last_xstats));
+	psc->frame_cycles = 0;
+	psc->frame_time = 0;
 
 	/* and any hw activity from waking up*/
 	device->ftbl->power_stats(device, &stats);
@@ -125,6 +134,8 @@ void kgsl_pwrscale_update_stats(struct kgsl_device *device)
 		ktime_t cur_time = ktime_get();
 
 		device->ftbl->power_stats(device, &stats);
+		psc->frame_cycles += stats.busy_time *
+			div_u64(kgsl_pwrctrl_active_freq(pwrctrl), USEC_PER_SEC);
 		device->pwrscale.accum_stats.busy_time += stats.busy_time;
 		device->pwrscale.accum_stats.ram_time += stats.ram_time;
 		device->pwrscale.accum_stats.ram_wait += stats.ram_wait;
@@ -136,6 +147,23 @@ void kgsl_pwrscale_update_stats(struct kgsl_device *device)
 	}
 }
 
+/**
+ * kgsl_pwrscale_frame_retired() - a frame finished on the GPU
+ * @device: The device
+ *
+ * Called when a command marked as the end of a frame retires so a frame aware
+ * governor can size the GPU clock for the next frame.
+ */
+void kgsl_pwrscale_frame_retired(struct kgsl_device *device)
+{
+	struct kgsl_pwrscale *psc = &device->pwrscale;
+
+	if (!psc->enabled || !adreno_tz_data.frame.enable)
+		return;
+
+	queue_work(psc->devfreq_wq, &psc->devfreq_frame_ws);
+}
+
 /**
  * kgsl_pwrscale_update() - update device busy statistics
  * @device: The device
@@ -822,6 +850,10 @@ int kgsl_pwrscale_init(struct kgsl_device *device, struct platform_device *pdev,
 		of_property_read_bool(pdev->dev.of_node,
 		"qcom,disable-busy-time-burst");
 
+	adreno_tz_data.frame.enable =
+		of_property_read_bool(pdev->dev.of_node,
+		"qcom,frame-aware-dcvs");
+
 	if (pwrscale->ctxt_aware_enable) {
 		adreno_tz_data.ctxt_aware_enable = pwrscale->ctxt_aware_enable;
 		adreno_tz_data.bin.ctxt_aware_target_pwrlevel =
@@ -891,6 +923,7 @@ int kgsl_pwrscale_init(struct kgsl_device *device, struct platform_device *pdev,
 	INIT_WORK(&pwrscale->devfreq_suspend_ws, do_devfreq_suspend);
 	INIT_WORK(&pwrscale->devfreq_resume_ws, do_devfreq_resume);
 	INIT_WORK(&pwrscale->devfreq_notify_ws, do_devfreq_notify);
+	INIT_WORK(&pwrscale->devfreq_frame_ws, do_devfreq_frame);
 	if (kgsl_midframe)
 		INIT_WORK(&kgsl_midframe->timer_check_ws,
 				kgsl_pwrscale_midframe_timer_check);
@@ -977,3 +1010,43 @@ static void do_devfreq_notify(struct work_struct *work)
 				 ADRENO_DEVFREQ_NOTIFY_RETIRE,
 				 devfreq);
 }
+
+static void do_devfreq_frame(struct work_struct *work)
+{
+	struct kgsl_pwrscale *pwrscale = container_of(work,
+			struct kgsl_pwrscale, devfreq_frame_ws);
+	struct kgsl_device *device = container_of(pwrscale,
+			struct kgsl_device, pwrscale);
+	struct devfreq_msm_adreno_tz_data *priv =
+			pwrscale->gpu_profile.private_data;
+	u64 cycles, period;
+	ktime_t now;
+
+	mutex_lock(&device->mutex);
+
+	kgsl_pwrscale_update_stats(device);
+
+	now = ktime_get();
+	period = pwrscale->frame_time ?
+		ktime_us_delta(now, pwrscale->frame_time) : 0;
+	cycles = pwrscale->frame_cycles;
+
+	pwrscale->frame_time = now;
+	pwrscale->frame_cycles = 0;
+
+	mutex_unlock(&device->mutex);
+
+	if (!period || period > KGSL_FRAME_MAX_PERIOD_US)
+		return;
+
+	/*
+	 * The devfreq workqueue is ordered so the governor consumes the sample
+	 * before the next frame can overwrite it
+	 */
+	priv->frame.sample_cycles = cycles;
+	priv->frame.sample_period = period;
+
+	srcu_notifier_call_chain(&pwrscale->nh,
+				 ADRENO_DEVFREQ_NOTIFY_FRAME,
+				 pwrscale->devfreqptr);
+}
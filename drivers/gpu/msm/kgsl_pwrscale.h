@@ -34,6 +34,9 @@ struct kgsl_power_stats {
  * @devfreq_suspend_ws - Pass device suspension to devfreq
  * @devfreq_resume_ws - Pass device resume to devfreq
  * @devfreq_notify_ws - Notify devfreq to update sampling
+ * @devfreq_frame_ws - Pass a frame boundary to devfreq
+ * @frame_cycles - GPU busy cycles since the last frame boundary
+ * @frame_time - Timestamp of the last frame boundary
  * @next_governor_call - Timestamp after which the governor may be notified of
  * a new sample
  * @cooling_dev - Thermal cooling device handle
@@ -58,6 +61,9 @@ struct kgsl_pwrscale {
 	struct work_struct devfreq_suspend_ws;
 	struct work_struct devfreq_resume_ws;
 	struct work_struct devfreq_notify_ws;
+	struct work_struct devfreq_frame_ws;
+	u64 frame_cycles;
+	ktime_t frame_time;
 	ktime_t next_governor_call;
 	struct thermal_cooling_device *cooling_dev;
 	bool ctxt_aware_enable;
@@ -84,6 +90,7 @@ void kgsl_pwrscale_update_stats(struct kgsl_device *device);
 void kgsl_pwrscale_busy(struct kgsl_device *device);
 void kgsl_pwrscale_sleep(struct kgsl_device *device);
 void kgsl_pwrscale_wake(struct kgsl_device *device);
+void kgsl_pwrscale_frame_retired(struct kgsl_device *device);
 
 void kgsl_pwrscale_midframe_timer_restart(struct kgsl_device *device);
 void kgsl_pwrscale_midframe_timer_cancel(struct kgsl_device *device);
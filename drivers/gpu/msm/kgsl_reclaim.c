@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#include <linux/shrinker.h>
+#include <linux/workqueue.h>
+
+#include "kgsl_device.h"
+#include "kgsl_reclaim.h"
+#include "kgsl_sharedmem.h"
+
+/* Set from sysfs to let the shrinker reclaim memory of idle processes */
+static unsigned int kgsl_reclaim_enable;
+/* Time a process has to be idle before its memory can be reclaimed */
+static unsigned int kgsl_reclaim_idle_ms = 5000;
+/* Pages the shrinker asked for since the last run of the worker */
+static atomic_long_t kgsl_reclaim_target;
+static bool kgsl_reclaim_sysfs;
+static bool kgsl_reclaim_registered;
+
+static void kgsl_reclaim_worker(struct work_struct *work);
+
+static DECLARE_WORK(kgsl_reclaim_work, kgsl_reclaim_worker);
+
+/* Get a reference to the next entry of the process starting at @id */
+static struct kgsl_mem_entry *_next_entry(struct kgsl_process_private *process,
+		int *id)
+{
+	struct kgsl_mem_entry *entry;
+
+	spin_lock(&process->mem_lock);
+	while ((entry = idr_get_next(&process->mem_idr, id))) {
+		(*id)++;
+
+		if (!entry->pending_free && kgsl_mem_entry_get(entry))
+			break;
+	}
+	spin_unlock(&process->mem_lock);
+
+	return entry;
+}
+
+/* Must be called with the reclaim_sem held for write */
+static int _restore_process(struct kgsl_process_private *process)
+{
+	struct kgsl_mem_entry *entry;
+	int id = 0, ret = 0;
+
+	while (!ret && (entry = _next_entry(process, &id))) {
+		ret = kgsl_memdesc_restore(&entry->memdesc);
+		kgsl_mem_entry_put(entry);
+	}
+
+	if (!ret)
+		clear_bit(KGSL_PROCESS_RECLAIMED, &process->priv);
+
+	return ret;
+}
+
+int kgsl_reclaim_get(struct kgsl_process_private *process)
+{
+	int ret = 0;
+
+	down_read(&process->reclaim_sem);
+	if (!test_bit(KGSL_PROCESS_RECLAIMED, &process->priv))
+		return 0;
+	up_read(&process->reclaim_sem);
+
+	down_write(&process->reclaim_sem);
+	if (test_bit(KGSL_PROCESS_RECLAIMED, &process->priv))
+		ret = _restore_process(process);
+	downgrade_write(&process->reclaim_sem);
+
+	if (ret)
+		up_read(&process->reclaim_sem);
+
+	return ret;
+}
+
+void kgsl_reclaim_put(struct kgsl_process_private *process)
+{
+	up_read(&process->reclaim_sem);
+}
+
+int kgsl_reclaim_cmd_start(struct kgsl_process_private *process)
+{
+	int ret;
+
+	/* Count the command first so the reclaimer backs off from now on */
+	atomic_inc(&process->cmd_count);
+
+	ret = kgsl_reclaim_get(process);
+	if (ret) {
+		kgsl_reclaim_cmd_done(process);
+		return ret;
+	}
+
+	kgsl_reclaim_put(process);
+	return 0;
+}
+
+void kgsl_reclaim_cmd_done(struct kgsl_process_private *process)
+{
+	WRITE_ONCE(process->last_active, jiffies);
+	smp_mb__before_atomic();
+	atomic_dec(&process->cmd_count);
+}
+
+static bool _entry_reclaimable(struct kgsl_mem_entry *entry)
+{
+	struct kgsl_memdesc *memdesc = &entry->memdesc;
+
+	if (!(memdesc->flags & KGSL_MEMFLAGS_RECLAIMABLE))
+		return false;
+
+	if (memdesc->priv & (KGSL_MEMDESC_RECLAIMED | KGSL_MEMDESC_SECURE))
+		return false;
+
+	/* Leave anything alone that the CPU or the kernel can still touch */
+	return !atomic_read(&entry->map_count) && !memdesc->hostptr;
+}
+
+static unsigned long _reclaim_process(struct kgsl_process_private *process)
+{
+	unsigned long idle = msecs_to_jiffies(READ_ONCE(kgsl_reclaim_idle_ms));
+	struct kgsl_mem_entry *entry;
+	unsigned long pages = 0;
+	int id = 0;
+
+	/* Somebody is restoring or using the memory, the process isn't idle */
+	if (!down_write_trylock(&process->reclaim_sem))
+		return 0;
+
+	if (atomic_read(&process->cmd_count) ||
+		time_before(jiffies, READ_ONCE(process->last_active) + idle))
+		goto out;
+
+	while ((entry = _next_entry(process, &id))) {
+		if (_entry_reclaimable(entry) &&
+			!kgsl_memdesc_reclaim(&entry->memdesc)) {
+			set_bit(KGSL_PROCESS_RECLAIMED, &process->priv);
+			pages += entry->memdesc.size >> PAGE_SHIFT;
+		}
+
+		kgsl_mem_entry_put(entry);
+	}
+
+out:
+	up_write(&process->reclaim_sem);
+	return pages;
+}
+
+/* Get a reference to the process after @prev and drop the one on @prev */
+static struct kgsl_process_private *
+_next_process(struct kgsl_process_private *prev)
+{
+	struct kgsl_process_private *process;
+
+	read_lock(&kgsl_driver.proclist_lock);
+	process = list_prepare_entry(prev, &kgsl_driver.process_list, list);
+	list_for_each_entry_continue(process, &kgsl_driver.process_list, list) {
+		if (kgsl_process_private_get(process))
+			break;
+	}
+
+	if (&process->list == &kgsl_driver.process_list)
+		process = NULL;
+	read_unlock(&kgsl_driver.proclist_lock);
+
+	/* The reference kept @prev in the list until now */
+	kgsl_process_private_put(prev);
+
+	return process;
+}
+
+static void kgsl_reclaim_worker(struct work_struct *work)
+{
+	struct kgsl_process_private *process = NULL;
+	long target = atomic_long_xchg(&kgsl_reclaim_target, 0);
+
+	while (target > 0 && (process = _next_process(process)))
+		target -= _reclaim_process(process);
+
+	kgsl_process_private_put(process);
+}
+
+/* Functions for the shrinker */
+
+static unsigned long
+kgsl_reclaim_shrink_scan_objects(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	/*
+	 * Copying the pages to shmem allocates memory, so do it from the
+	 * worker instead of from inside of the reclaim path. The freed pages
+	 * show up on later scans.
+	 */
+	atomic_long_add(sc->nr_to_scan, &kgsl_reclaim_target);
+	queue_work(kgsl_driver.mem_workqueue, &kgsl_reclaim_work);
+
+	return SHRINK_STOP;
+}
+
+static unsigned long
+kgsl_reclaim_shrink_count_objects(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	if (!READ_ONCE(kgsl_reclaim_enable))
+		return 0;
+
+	/* Upper bound, only idle memory that opted in is reclaimed */
+	return atomic_long_read(&kgsl_driver.stats.page_alloc) >> PAGE_SHIFT;
+}
+
+static struct shrinker kgsl_reclaim_shrinker = {
+	.count_objects = kgsl_reclaim_shrink_count_objects,
+	.scan_objects = kgsl_reclaim_shrink_scan_objects,
+	.seeks = DEFAULT_SEEKS,
+	.batch = 0,
+};
+
+static ssize_t reclaim_enable_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", kgsl_reclaim_enable);
+}
+
+static ssize_t reclaim_enable_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(kgsl_reclaim_enable, val ? 1 : 0);
+	return count;
+}
+
+static ssize_t reclaim_idle_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", kgsl_reclaim_idle_ms);
+}
+
+static ssize_t reclaim_idle_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val = 0;
+	int ret;
+
+	ret = kgsl_sysfs_store(buf, &val);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(kgsl_reclaim_idle_ms, val);
+	return count;
+}
+
+static DEVICE_ATTR_RW(reclaim_enable);
+static DEVICE_ATTR_RW(reclaim_idle_ms);
+
+static const struct attribute *reclaim_attr_list[] = {
+	&dev_attr_reclaim_enable.attr,
+	&dev_attr_reclaim_idle_ms.attr,
+	NULL,
+};
+
+void kgsl_reclaim_init(void)
+{
+	if (!sysfs_create_files(&kgsl_driver.virtdev.kobj, reclaim_attr_list))
+		kgsl_reclaim_sysfs = true;
+
+	if (!register_shrinker(&kgsl_reclaim_shrinker))
+		kgsl_reclaim_registered = true;
+}
+
+void kgsl_reclaim_close(void)
+{
+	if (kgsl_reclaim_sysfs) {
+		sysfs_remove_files(&kgsl_driver.virtdev.kobj,
+			reclaim_attr_list);
+		kgsl_reclaim_sysfs = false;
+	}
+
+	if (kgsl_reclaim_registered) {
+		unregister_shrinker(&kgsl_reclaim_shrinker);
+		kgsl_reclaim_registered = false;
+	}
+
+	cancel_work_sync(&kgsl_reclaim_work);
+}
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef __KGSL_RECLAIM_H
+#define __KGSL_RECLAIM_H
+
+struct kgsl_process_private;
+
+/**
+ * kgsl_reclaim_get - Keep the memory of a process from being reclaimed
+ * @process: Pointer to the KGSL process
+ *
+ * Restore the memory of @process if it was reclaimed and hold it resident
+ * until kgsl_reclaim_put() is called.
+ *
+ * Return: 0 on success or negative if the memory could not be restored
+ */
+int kgsl_reclaim_get(struct kgsl_process_private *process);
+
+/**
+ * kgsl_reclaim_put - Allow the memory of a process to be reclaimed again
+ * @process: Pointer to the KGSL process
+ */
+void kgsl_reclaim_put(struct kgsl_process_private *process);
+
+/**
+ * kgsl_reclaim_cmd_start - Account for a new command object of a process
+ * @process: Pointer to the KGSL process
+ *
+ * Restore the memory of @process before a command is submitted and keep it
+ * resident until the command is retired with kgsl_reclaim_cmd_done().
+ *
+ * Return: 0 on success or negative if the memory could not be restored
+ */
+int kgsl_reclaim_cmd_start(struct kgsl_process_private *process);
+
+/**
+ * kgsl_reclaim_cmd_done - Account for a retired command object of a process
+ * @process: Pointer to the KGSL process
+ */
+void kgsl_reclaim_cmd_done(struct kgsl_process_private *process);
+
+void kgsl_reclaim_init(void);
+void kgsl_reclaim_close(void);
+
+#endif /* __KGSL_RECLAIM_H */
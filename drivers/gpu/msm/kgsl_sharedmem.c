@@ -8,6 +8,7 @@
 #include <linux/highmem.h>
 #include <linux/slab.h>
 #include <linux/random.h>
+#include <linux/shmem_fs.h>
 
 #include "kgsl_device.h"
 #include "kgsl_pool.h"
@@ -176,11 +177,33 @@ gpumem_unmapped_show(struct kgsl_process_private *priv, int type, char *buf)
 			gpumem_total - gpumem_mapped);
 }
 
+/* Show the bytes mapped in the GPU pagetable with the given granularity */
+static ssize_t
+gpumem_granule_show(struct kgsl_process_private *priv, int type, char *buf)
+{
+	struct kgsl_mem_entry *entry;
+	u64 pages = 0;
+	int id;
+
+	spin_lock(&priv->mem_lock);
+	idr_for_each_entry(&priv->mem_idr, entry, id)
+		pages += READ_ONCE(entry->memdesc.map_granule[type]);
+	spin_unlock(&priv->mem_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%llu\n", pages << PAGE_SHIFT);
+}
+
 static struct kgsl_mem_entry_attribute debug_memstats[] = {
 	__MEM_ENTRY_ATTR(0, imported_mem, imported_mem_show),
 	__MEM_ENTRY_ATTR(0, gpumem_mapped, gpumem_mapped_show),
 	__MEM_ENTRY_ATTR(KGSL_MEM_ENTRY_KERNEL, gpumem_unmapped,
 				gpumem_unmapped_show),
+	__MEM_ENTRY_ATTR(KGSL_MAP_GRANULE_4K, gpumem_mapped_4k,
+				gpumem_granule_show),
+	__MEM_ENTRY_ATTR(KGSL_MAP_GRANULE_64K, gpumem_mapped_64k,
+				gpumem_granule_show),
+	__MEM_ENTRY_ATTR(KGSL_MAP_GRANULE_2M, gpumem_mapped_2m,
+				gpumem_granule_show),
 };
 
 /**
@@ -399,6 +422,10 @@ static ssize_t memstat_show(struct device *dev,
 		val = atomic_long_read(&kgsl_driver.stats.mapped);
 	else if (!strcmp(attr->attr.name, "mapped_max"))
 		val = atomic_long_read(&kgsl_driver.stats.mapped_max);
+	else if (!strcmp(attr->attr.name, "reclaimed"))
+		val = atomic_long_read(&kgsl_driver.stats.reclaimed);
+	else if (!strcmp(attr->attr.name, "reclaimed_max"))
+		val = atomic_long_read(&kgsl_driver.stats.reclaimed_max);
 
 	return scnprintf(buf, PAGE_SIZE, "%llu\n", val);
 }
@@ -436,6 +463,8 @@ static DEVICE_ATTR(secure, 0444, memstat_show, NULL);
 static DEVICE_ATTR(secure_max, 0444, memstat_show, NULL);
 static DEVICE_ATTR(mapped, 0444, memstat_show, NULL);
 static DEVICE_ATTR(mapped_max, 0444, memstat_show, NULL);
+static DEVICE_ATTR(reclaimed, 0444, memstat_show, NULL);
+static DEVICE_ATTR(reclaimed_max, 0444, memstat_show, NULL);
 static DEVICE_ATTR_RW(full_cache_threshold);
 
 static const struct attribute *drv_attr_list[] = {
@@ -449,6 +478,8 @@ static const struct attribute *drv_attr_list[] = {
 	&dev_attr_secure_max.attr,
 	&dev_attr_mapped.attr,
 	&dev_attr_mapped_max.attr,
+	&dev_attr_reclaimed.attr,
+	&dev_attr_reclaimed_max.attr,
 	&dev_attr_full_cache_threshold.attr,
 	NULL,
 };
@@ -569,6 +600,10 @@ static int kgsl_paged_map_kernel(struct kgsl_memdesc *memdesc)
 	if (memdesc->size > ULONG_MAX)
 		return -ENOMEM;
 
+	/* The pages of a reclaimed object have to be restored first */
+	if (memdesc->priv & KGSL_MEMDESC_RECLAIMED)
+		return -EBUSY;
+
 	mutex_lock(&kernel_map_global_lock);
 	if ((!memdesc->hostptr) && (memdesc->pages != NULL)) {
 		pgprot_t page_prot = pgprot_writecombine(PAGE_KERNEL);
@@ -729,6 +764,15 @@ void kgsl_sharedmem_free(struct kgsl_memdesc *memdesc)
 	/* Make sure the memory object has been unmapped */
 	kgsl_mmu_put_gpuaddr(memdesc);
 
+	/* A reclaimed object only owns the shmem copy of its pages */
+	if (memdesc->priv & KGSL_MEMDESC_RECLAIMED) {
+		atomic_long_sub(memdesc->size, &kgsl_driver.stats.reclaimed);
+		fput(memdesc->shmem_filp);
+		memdesc->shmem_filp = NULL;
+		memdesc->priv &= ~KGSL_MEMDESC_RECLAIMED;
+		return;
+	}
+
 	/* Assume if no operations were specified something went bad early */
 	if (!memdesc->ops || !memdesc->ops->free)
 		return;
@@ -1239,6 +1283,126 @@ static int kgsl_alloc_pages(struct kgsl_device *device,
 	return 0;
 }
 
+int kgsl_memdesc_reclaim(struct kgsl_memdesc *memdesc)
+{
+	struct address_space *mapping;
+	struct file *filp;
+	gfp_t gfp;
+	int i, ret;
+
+	if (memdesc->priv & KGSL_MEMDESC_RECLAIMED)
+		return 0;
+
+	if (!memdesc->pages || memdesc->hostptr || !memdesc->pagetable ||
+		!(memdesc->priv & KGSL_MEMDESC_MAPPED))
+		return -EINVAL;
+
+	if (memdesc->ops != &kgsl_pool_ops && memdesc->ops != &kgsl_system_ops)
+		return -EINVAL;
+
+	filp = shmem_file_setup("kgsl-reclaim", memdesc->size, VM_NORESERVE);
+	if (IS_ERR(filp))
+		return PTR_ERR(filp);
+
+	/* Don't dig into the reserves, it is better to keep the pages */
+	mapping = filp->f_mapping;
+	gfp = mapping_gfp_mask(mapping) | __GFP_NORETRY | __GFP_NOWARN;
+
+	for (i = 0; i < memdesc->page_count; i++) {
+		struct page *page = shmem_read_mapping_page_gfp(mapping, i, gfp);
+
+		if (IS_ERR(page)) {
+			fput(filp);
+			return PTR_ERR(page);
+		}
+
+		/* Drop stale lines so the copy sees what the GPU wrote */
+		if (!(memdesc->flags & KGSL_MEMFLAGS_IOCOHERENT))
+			_dma_cache_op(memdesc->dev, memdesc->pages[i],
+				KGSL_CACHE_OP_INV);
+
+		copy_highpage(page, memdesc->pages[i]);
+		set_page_dirty(page);
+		put_page(page);
+	}
+
+	ret = kgsl_mmu_unmap(memdesc->pagetable, memdesc);
+	if (ret) {
+		/* Keep the pages and let the final free retry the unmap */
+		memdesc->priv |= KGSL_MEMDESC_MAPPED;
+		fput(filp);
+		return ret;
+	}
+
+	/* The GPU address stays reserved so the object comes back in place */
+	memdesc->ops->free(memdesc);
+
+	memdesc->shmem_filp = filp;
+	memdesc->priv |= KGSL_MEMDESC_RECLAIMED;
+
+	KGSL_STATS_ADD(memdesc->size, &kgsl_driver.stats.reclaimed,
+		&kgsl_driver.stats.reclaimed_max);
+
+	return 0;
+}
+
+int kgsl_memdesc_restore(struct kgsl_memdesc *memdesc)
+{
+	struct address_space *mapping;
+	struct page **pages;
+	int i, count, ret;
+
+	if (!(memdesc->priv & KGSL_MEMDESC_RECLAIMED))
+		return 0;
+
+	if (memdesc->priv & KGSL_MEMDESC_SYSMEM)
+		count = kgsl_system_alloc_pages(memdesc->size, &pages,
+			memdesc->dev);
+	else
+		count = kgsl_pool_alloc_pages(memdesc->size, &pages,
+			memdesc->dev);
+
+	if (count < 0)
+		return count;
+
+	memdesc->pages = pages;
+	memdesc->page_count = count;
+
+	KGSL_STATS_ADD(memdesc->size, &kgsl_driver.stats.page_alloc,
+		&kgsl_driver.stats.page_alloc_max);
+
+	mapping = memdesc->shmem_filp->f_mapping;
+
+	for (i = 0; i < count; i++) {
+		struct page *page = shmem_read_mapping_page(mapping, i);
+
+		if (IS_ERR(page)) {
+			ret = PTR_ERR(page);
+			goto err;
+		}
+
+		copy_highpage(pages[i], page);
+		put_page(page);
+
+		_dma_cache_op(memdesc->dev, pages[i], KGSL_CACHE_OP_FLUSH);
+	}
+
+	ret = kgsl_mmu_map(memdesc->pagetable, memdesc);
+	if (ret)
+		goto err;
+
+	atomic_long_sub(memdesc->size, &kgsl_driver.stats.reclaimed);
+	fput(memdesc->shmem_filp);
+	memdesc->shmem_filp = NULL;
+	memdesc->priv &= ~KGSL_MEMDESC_RECLAIMED;
+
+	return 0;
+
+err:
+	memdesc->ops->free(memdesc);
+	return ret;
+}
+
 static int _kgsl_alloc_contiguous(struct device *dev,
 		struct kgsl_memdesc *memdesc, u64 size, unsigned long attrs)
 {
@@ -61,6 +61,29 @@ int kgsl_cache_range_op(struct kgsl_memdesc *memdesc,
 void kgsl_memdesc_init(struct kgsl_device *device,
 			struct kgsl_memdesc *memdesc, uint64_t flags);
 
+/**
+ * kgsl_memdesc_reclaim - Move the pages of a memory object to shmem
+ * @memdesc: A paged memory object that is not mapped by the CPU
+ *
+ * Copy the pages of @memdesc to a shmem file that the core mm can swap or
+ * compress, unmap @memdesc from its pagetable and free the pages. The GPU
+ * address stays reserved for kgsl_memdesc_restore().
+ *
+ * Return: 0 on success or negative on failure
+ */
+int kgsl_memdesc_reclaim(struct kgsl_memdesc *memdesc);
+
+/**
+ * kgsl_memdesc_restore - Bring back the pages of a reclaimed memory object
+ * @memdesc: A memory object that went through kgsl_memdesc_reclaim()
+ *
+ * Allocate new pages for @memdesc, fill them from the shmem copy and map them
+ * at the original GPU address.
+ *
+ * Return: 0 on success or negative on failure
+ */
+int kgsl_memdesc_restore(struct kgsl_memdesc *memdesc);
+
 void kgsl_process_init_sysfs(struct kgsl_device *device,
 		struct kgsl_process_private *private);
 void kgsl_process_uninit_sysfs(struct kgsl_process_private *private);
@@ -23,6 +23,16 @@ struct kgsl_snapshot_cp_obj {
 	struct list_head node;
 };
 
+/* An IB found during snapshot that gets parsed for objects by the worker */
+
+struct kgsl_snapshot_parse_ib {
+	struct kgsl_process_private *process;
+	struct kgsl_mem_entry *entry;
+	u64 gpuaddr;
+	u64 dwords;
+	struct list_head node;
+};
+
 struct snapshot_obj_itr {
 	u8 *buf;      /* Buffer pointer to write to */
 	int pos;        /* Current position in the sequence */
@@ -830,6 +840,7 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	init_completion(&snapshot->dump_gate);
 	INIT_LIST_HEAD(&snapshot->obj_list);
 	INIT_LIST_HEAD(&snapshot->cp_list);
+	INIT_LIST_HEAD(&snapshot->ib_list);
 	INIT_WORK(&snapshot->work, kgsl_snapshot_save_frozen_objs);
 
 	snapshot->start = device->snapshot_memory.ptr;
@@ -1355,6 +1366,90 @@ int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	return 0;
 }
 
+/**
+ * kgsl_snapshot_defer_ib() - Parse an IB for objects after the snapshot
+ * @snapshot: The snapshot data
+ * @process: The process that owns the IB
+ * @gpuaddr: The GPU address of the IB
+ * @dwords: The size of the IB in dwords
+ *
+ * Walking an IB for the buffers it references is the slow part of a snapshot.
+ * Only remember the IB here and keep its memory entry referenced, the worker
+ * that saves the frozen objects parses it while the GPU is already being
+ * recovered. Returns 0 on success or a negative error code.
+ */
+int kgsl_snapshot_defer_ib(struct kgsl_snapshot *snapshot,
+	struct kgsl_process_private *process, u64 gpuaddr, u64 dwords)
+{
+	struct kgsl_snapshot_parse_ib *ib;
+
+	list_for_each_entry(ib, &snapshot->ib_list, node) {
+		if (ib->process == process && ib->gpuaddr == gpuaddr) {
+			ib->dwords = max(ib->dwords, dwords);
+			return 0;
+		}
+	}
+
+	ib = kzalloc(sizeof(*ib), GFP_KERNEL);
+	if (!ib)
+		return -ENOMEM;
+
+	ib->entry = kgsl_sharedmem_find(process, gpuaddr);
+	if (!ib->entry) {
+		kfree(ib);
+		return -EINVAL;
+	}
+
+	if (!kgsl_process_private_get(process)) {
+		kgsl_mem_entry_put(ib->entry);
+		kfree(ib);
+		return -EINVAL;
+	}
+
+	ib->process = process;
+	ib->gpuaddr = gpuaddr;
+	ib->dwords = dwords;
+	list_add_tail(&ib->node, &snapshot->ib_list);
+
+	return 0;
+}
+
+/*
+ * Parse the IBs deferred during snapshot and queue the objects they reference
+ * on the IB object list. If @parse is false just drop the IBs.
+ */
+static void kgsl_snapshot_parse_deferred_ibs(struct kgsl_snapshot *snapshot,
+	bool parse)
+{
+	struct kgsl_snapshot_parse_ib *ib, *tmp;
+	bool max_objs = false;
+
+	list_for_each_entry_safe(ib, tmp, &snapshot->ib_list, node) {
+		struct adreno_ib_object_list *ib_obj_list = NULL;
+
+		if (parse && !kgsl_snapshot_have_object(snapshot, ib->process,
+				ib->gpuaddr, ib->dwords << 2)) {
+			if (-E2BIG == adreno_ib_create_object_list(
+				snapshot->device, ib->process, ib->gpuaddr,
+				ib->dwords, snapshot->ib2base, &ib_obj_list))
+				max_objs = true;
+
+			if (ib_obj_list &&
+				kgsl_snapshot_add_ib_obj_list(snapshot,
+					ib_obj_list))
+				adreno_ib_destroy_obj_list(ib_obj_list);
+		}
+
+		list_del(&ib->node);
+		kgsl_mem_entry_put(ib->entry);
+		kgsl_process_private_put(ib->process);
+		kfree(ib);
+	}
+
+	if (max_objs)
+		dev_err(snapshot->device->dev, "Max objects found in IB\n");
+}
+
 static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 		struct kgsl_snapshot_object *obj)
 {
@@ -1411,8 +1506,12 @@ static void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 	size_t size = 0;
 	void *ptr;
 
-	if (snapshot->device->gmu_fault)
+	if (snapshot->device->gmu_fault) {
+		kgsl_snapshot_parse_deferred_ibs(snapshot, false);
 		goto gmu_only;
+	}
+
+	kgsl_snapshot_parse_deferred_ibs(snapshot, true);
 
 	kgsl_snapshot_process_ib_obj_list(snapshot);
 
@@ -20,17 +20,58 @@ struct kgsl_timeline_fence {
 	struct list_head node;
 };
 
-struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
-		u64 timelines, u32 count, u64 usize, bool any)
+/*
+ * Copy an array of &struct kgsl_timeline_val from userspace in one go and
+ * validate every entry before any of them is acted on.
+ */
+static struct kgsl_timeline_val *kgsl_timeline_vals_copy(u64 timelines,
+		u32 count, u64 usize)
 {
 	void __user *uptr = u64_to_user_ptr(timelines);
-	struct dma_fence_array *array;
-	struct dma_fence **fences;
-	int i, ret = 0;
+	struct kgsl_timeline_val *vals;
+	int i;
 
 	if (!count || count > INT_MAX)
 		return ERR_PTR(-EINVAL);
 
+	vals = kvcalloc(count, sizeof(*vals), GFP_KERNEL);
+	if (!vals)
+		return ERR_PTR(-ENOMEM);
+
+	if (usize == sizeof(*vals)) {
+		if (copy_from_user(vals, uptr, count * sizeof(*vals)))
+			goto fault;
+	} else {
+		for (i = 0; i < count; i++) {
+			if (copy_struct_from_user(&vals[i], sizeof(*vals),
+				uptr, usize))
+				goto fault;
+
+			uptr += usize;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		if (vals[i].padding) {
+			kvfree(vals);
+			return ERR_PTR(-EINVAL);
+		}
+	}
+
+	return vals;
+
+fault:
+	kvfree(vals);
+	return ERR_PTR(-EFAULT);
+}
+
+static struct dma_fence *_timelines_to_fence_array(struct kgsl_device *device,
+		struct kgsl_timeline_val *vals, u32 count, bool any)
+{
+	struct dma_fence_array *array;
+	struct dma_fence **fences;
+	int i, ret = 0;
+
 	fences = kcalloc(count, sizeof(*fences),
 		GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
 
@@ -38,34 +79,21 @@ struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
 		return ERR_PTR(-ENOMEM);
 
 	for (i = 0; i < count; i++) {
-		struct kgsl_timeline_val val;
 		struct kgsl_timeline *timeline;
 
-		if (copy_struct_from_user(&val, sizeof(val), uptr, usize)) {
-			ret = -EFAULT;
-			goto err;
-		}
-
-		if (val.padding) {
-			ret = -EINVAL;
-			goto err;
-		}
-
-		timeline = kgsl_timeline_by_id(device, val.timeline);
+		timeline = kgsl_timeline_by_id(device, vals[i].timeline);
 		if (!timeline) {
 			ret = -ENOENT;
 			goto err;
 		}
 
-		fences[i] = kgsl_timeline_fence_alloc(timeline, val.seqno);
+		fences[i] = kgsl_timeline_fence_alloc(timeline, vals[i].seqno);
 		kgsl_timeline_put(timeline);
 
 		if (IS_ERR(fences[i])) {
 			ret = PTR_ERR(fences[i]);
 			goto err;
 		}
-
-		uptr += usize;
 	}
 
 	/* No need for a fence array for only one fence */
@@ -93,6 +121,50 @@ struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
 	return ERR_PTR(ret);
 }
 
+struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
+		u64 timelines, u32 count, u64 usize, bool any)
+{
+	struct kgsl_timeline_val *vals;
+	struct dma_fence *fence;
+
+	vals = kgsl_timeline_vals_copy(timelines, count, usize);
+	if (IS_ERR(vals))
+		return ERR_CAST(vals);
+
+	fence = _timelines_to_fence_array(device, vals, count, any);
+	kvfree(vals);
+
+	return fence;
+}
+
+/*
+ * Check the timeline values directly so that waits which are already
+ * satisfied don't need to create and tear down fences. Returns 1 if the wait
+ * condition is met, 0 if it isn't or a negative error code.
+ */
+static int _timelines_expired(struct kgsl_device *device,
+		struct kgsl_timeline_val *vals, u32 count, bool any)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		struct kgsl_timeline *timeline;
+		bool expired;
+
+		timeline = kgsl_timeline_by_id(device, vals[i].timeline);
+		if (!timeline)
+			return -ENOENT;
+
+		expired = READ_ONCE(timeline->value) >= vals[i].seqno;
+		kgsl_timeline_put(timeline);
+
+		if (expired == any)
+			return any ? 1 : 0;
+	}
+
+	return any ? 0 : 1;
+}
+
 void kgsl_timeline_destroy(struct kref *kref)
 {
 	struct kgsl_timeline *timeline = container_of(kref,
@@ -166,19 +238,14 @@ static void timeline_fence_release(struct dma_fence *fence)
 {
 	struct kgsl_timeline_fence *f = to_timeline_fence(fence);
 	struct kgsl_timeline *timeline = f->timeline;
-	struct kgsl_timeline_fence *cur, *temp;
 	unsigned long flags;
 
+	/*
+	 * If the fence is still on the active list, remove it. Fences taken
+	 * off the list for signaling always have their node reinitialized.
+	 */
 	spin_lock_irqsave(&timeline->fence_lock, flags);
-
-	/* If the fence is still on the active list, remove it */
-	list_for_each_entry_safe(cur, temp, &timeline->fences, node) {
-		if (f != cur)
-			continue;
-
-		list_del_init(&f->node);
-		break;
-	}
+	list_del_init(&f->node);
 	spin_unlock_irqrestore(&timeline->fence_lock, flags);
 	trace_kgsl_timeline_fence_release(f->timeline->id, fence->seqno);
 
@@ -240,16 +307,20 @@ static void kgsl_timeline_add_fence(struct kgsl_timeline *timeline,
 	struct kgsl_timeline_fence *entry;
 	unsigned long flags;
 
+	/*
+	 * Keep the list sorted by seqno. New fences are usually for the
+	 * latest point on the timeline so look for the spot from the tail.
+	 */
 	spin_lock_irqsave(&timeline->fence_lock, flags);
-	list_for_each_entry(entry, &timeline->fences, node) {
-		if (fence->base.seqno < entry->base.seqno) {
-			list_add_tail(&fence->node, &entry->node);
+	list_for_each_entry_reverse(entry, &timeline->fences, node) {
+		if (entry->base.seqno <= fence->base.seqno) {
+			list_add(&fence->node, &entry->node);
 			spin_unlock_irqrestore(&timeline->fence_lock, flags);
 			return;
 		}
 	}
 
-	list_add_tail(&fence->node, &timeline->fences);
+	list_add(&fence->node, &timeline->fences);
 	spin_unlock_irqrestore(&timeline->fence_lock, flags);
 }
 
@@ -269,14 +340,22 @@ void kgsl_timeline_signal(struct kgsl_timeline *timeline, u64 seqno)
 
 	timeline->value = seqno;
 
+	/*
+	 * The list is sorted so only the signaled fences at the head need to
+	 * be looked at
+	 */
 	spin_lock(&timeline->fence_lock);
-	list_for_each_entry_safe(fence, tmp, &timeline->fences, node)
-		if (timeline_fence_signaled(&fence->base) &&
-				kref_get_unless_zero(&fence->base.refcount))
-			list_move(&fence->node, &temp);
+	list_for_each_entry_safe(fence, tmp, &timeline->fences, node) {
+		if (!timeline_fence_signaled(&fence->base))
+			break;
+
+		if (kref_get_unless_zero(&fence->base.refcount))
+			list_move_tail(&fence->node, &temp);
+	}
 	spin_unlock(&timeline->fence_lock);
 
 	list_for_each_entry_safe(fence, tmp, &temp, node) {
+		list_del_init(&fence->node);
 		dma_fence_signal_locked(&fence->base);
 		dma_fence_put(&fence->base);
 	}
@@ -360,6 +439,8 @@ long kgsl_ioctl_timeline_wait(struct kgsl_device_private *dev_priv,
 {
 	struct kgsl_device *device = dev_priv->device;
 	struct kgsl_timeline_wait *param = data;
+	bool any = (param->flags == KGSL_TIMELINE_WAIT_ANY);
+	struct kgsl_timeline_val *vals;
 	struct dma_fence *fence;
 	unsigned long timeout;
 	signed long ret;
@@ -371,9 +452,22 @@ long kgsl_ioctl_timeline_wait(struct kgsl_device_private *dev_priv,
 	if (param->padding)
 		return -EINVAL;
 
-	fence = kgsl_timelines_to_fence_array(device, param->timelines,
-		param->count, param->timelines_size,
-		(param->flags == KGSL_TIMELINE_WAIT_ANY));
+	vals = kgsl_timeline_vals_copy(param->timelines, param->count,
+		param->timelines_size);
+	if (IS_ERR(vals))
+		return PTR_ERR(vals);
+
+	/* Don't bother with fences if the timelines are already there */
+	ret = _timelines_expired(device, vals, param->count, any);
+	if (ret) {
+		kvfree(vals);
+		trace_kgsl_timeline_wait(param->flags, param->tv_sec,
+			param->tv_nsec);
+		return ret < 0 ? ret : 0;
+	}
+
+	fence = _timelines_to_fence_array(device, vals, param->count, any);
+	kvfree(vals);
 
 	if (IS_ERR(fence))
 		return PTR_ERR(fence);
@@ -472,42 +566,35 @@ long kgsl_ioctl_timeline_signal(struct kgsl_device_private *dev_priv,
 {
 	struct kgsl_device *device = dev_priv->device;
 	struct kgsl_timeline_signal *param = data;
-	u64 timelines;
-	int i;
+	struct kgsl_timeline_val *vals;
+	int i, ret = 0;
 
 	if (!param->timelines_size) {
 		param->timelines_size = sizeof(struct kgsl_timeline_val);
 		return -EAGAIN;
 	}
 
-	if (!param->count)
-		return -EINVAL;
-
-	timelines = param->timelines;
+	vals = kgsl_timeline_vals_copy(param->timelines, param->count,
+		param->timelines_size);
+	if (IS_ERR(vals))
+		return PTR_ERR(vals);
 
 	for (i = 0; i < param->count; i++) {
 		struct kgsl_timeline *timeline;
-		struct kgsl_timeline_val val;
-
-		if (copy_struct_from_user(&val, sizeof(val),
-			u64_to_user_ptr(timelines), param->timelines_size))
-			return -EFAULT;
 
-		if (val.padding)
-			return -EINVAL;
-
-		timeline = kgsl_timeline_by_id(device, val.timeline);
-		if (!timeline)
-			return -ENODEV;
+		timeline = kgsl_timeline_by_id(device, vals[i].timeline);
+		if (!timeline) {
+			ret = -ENODEV;
+			break;
+		}
 
-		kgsl_timeline_signal(timeline, val.seqno);
+		kgsl_timeline_signal(timeline, vals[i].seqno);
 
 		kgsl_timeline_put(timeline);
-
-		timelines += param->timelines_size;
 	}
 
-	return 0;
+	kvfree(vals);
+	return ret;
 }
 
 long kgsl_ioctl_timeline_destroy(struct kgsl_device_private *dev_priv,
@@ -553,6 +640,7 @@ long kgsl_ioctl_timeline_destroy(struct kgsl_device_private *dev_priv,
 
 	spin_lock_irq(&timeline->lock);
 	list_for_each_entry_safe(fence, tmp, &temp, node) {
+		list_del_init(&fence->node);
 		dma_fence_set_error(&fence->base, -ENOENT);
 		dma_fence_signal_locked(&fence->base);
 		dma_fence_put(&fence->base);
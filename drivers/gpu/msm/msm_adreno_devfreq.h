@@ -12,6 +12,7 @@
 #define ADRENO_DEVFREQ_NOTIFY_SUBMIT	1
 #define ADRENO_DEVFREQ_NOTIFY_RETIRE	2
 #define ADRENO_DEVFREQ_NOTIFY_IDLE	3
+#define ADRENO_DEVFREQ_NOTIFY_FRAME	4
 
 #define DEVFREQ_FLAG_WAKEUP_MAXFREQ	0x2
 #define DEVFREQ_FLAG_FAST_HINT		0x4
@@ -63,6 +64,21 @@ struct devfreq_msm_adreno_tz_data {
 	bool ctxt_aware_enable;
 	/* Multiplier to change gpu busy status */
 	u32 mod_percent;
+	/*
+	 * Frame aware DCVS: sample_* hold the GPU cycles and length in usecs
+	 * of the frame that just retired, cycles and period the prediction
+	 * for the next one. expires is the ktime in usecs after which the
+	 * prediction is stale because frames stopped coming.
+	 */
+	struct {
+		bool enable;
+		u32 headroom;
+		u64 sample_cycles;
+		u64 sample_period;
+		u64 cycles;
+		u64 period;
+		s64 expires;
+	} frame;
 };
 
 struct msm_adreno_extended_profile {
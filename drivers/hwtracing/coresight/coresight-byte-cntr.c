@@ -8,11 +8,13 @@
 #include <linux/fs.h>
 #include <linux/of_irq.h>
 #include <linux/moduleparam.h>
+#include <linux/poll.h>
 #include <linux/delay.h>
 #include <linux/uaccess.h>
 #include <linux/usb/usb_qdss.h>
 #include <linux/time.h>
 #include <linux/slab.h>
+#include <uapi/linux/coresight-byte-cntr.h>
 
 #include "coresight-byte-cntr.h"
 #include "coresight-priv.h"
@@ -76,54 +78,78 @@ static void tmc_etr_flush_bytes(loff_t *ppos, size_t bytes, size_t *len)
 	}
 }
 
-static ssize_t tmc_etr_byte_cntr_read(struct file *fp, char __user *data,
-			       size_t len, loff_t *ppos)
+/*
+ * Find the next block of trace at *ppos, waiting for the byte counter to
+ * signal one unless @nonblock. Called and returns with byte_cntr_lock held.
+ */
+static int tmc_etr_byte_cntr_next_block(struct byte_cntr *byte_cntr_data,
+					loff_t *ppos, size_t *len,
+					char **bufp, bool nonblock)
 {
-	struct byte_cntr *byte_cntr_data = fp->private_data;
-	char *bufp;
-	int ret = 0;
-	if (!data)
+	if (!byte_cntr_data->read_active)
 		return -EINVAL;
 
-	mutex_lock(&byte_cntr_data->byte_cntr_lock);
-	if (!byte_cntr_data->read_active) {
-		ret = -EINVAL;
-		goto err0;
-	}
-
 	if (byte_cntr_data->enable) {
 		if (!atomic_read(&byte_cntr_data->irq_cnt)) {
+			if (nonblock)
+				return -EAGAIN;
+
 			mutex_unlock(&byte_cntr_data->byte_cntr_lock);
 			if (wait_event_interruptible(byte_cntr_data->wq,
 				atomic_read(&byte_cntr_data->irq_cnt) > 0
-				|| !byte_cntr_data->enable))
+				|| !byte_cntr_data->enable)) {
+				mutex_lock(&byte_cntr_data->byte_cntr_lock);
 				return -ERESTARTSYS;
-			mutex_lock(&byte_cntr_data->byte_cntr_lock);
-			if (!byte_cntr_data->read_active) {
-				ret = -EINVAL;
-				goto err0;
 			}
-
+			mutex_lock(&byte_cntr_data->byte_cntr_lock);
+			if (!byte_cntr_data->read_active)
+				return -EINVAL;
 		}
 
 		tmc_etr_read_bytes(byte_cntr_data, ppos,
-				   byte_cntr_data->block_size, &len, &bufp);
+				   byte_cntr_data->block_size, len, bufp);
 
 	} else {
 		if (!atomic_read(&byte_cntr_data->irq_cnt)) {
 			tmc_etr_flush_bytes(ppos, byte_cntr_data->block_size,
-						  &len);
-			if (!len) {
-				ret = -EINVAL;
-				goto err0;
-			}
+						  len);
+			if (!*len)
+				return -EINVAL;
+			*len = tmc_etr_buf_get_data(tmcdrvdata->sysfs_buf,
+						    *ppos, *len, bufp);
 		} else {
 			tmc_etr_read_bytes(byte_cntr_data, ppos,
 						   byte_cntr_data->block_size,
-						   &len, &bufp);
+						   len, bufp);
 		}
 	}
 
+	return 0;
+}
+
+static void tmc_etr_byte_cntr_advance(loff_t *ppos, size_t len)
+{
+	if (*ppos + len >= tmcdrvdata->size)
+		*ppos = 0;
+	else
+		*ppos += len;
+}
+
+static ssize_t tmc_etr_byte_cntr_read(struct file *fp, char __user *data,
+			       size_t len, loff_t *ppos)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+	char *bufp;
+	int ret = 0;
+	if (!data)
+		return -EINVAL;
+
+	mutex_lock(&byte_cntr_data->byte_cntr_lock);
+	ret = tmc_etr_byte_cntr_next_block(byte_cntr_data, ppos, &len, &bufp,
+					   false);
+	if (ret)
+		goto err0;
+
 	if (copy_to_user(data, bufp, len)) {
 		mutex_unlock(&byte_cntr_data->byte_cntr_lock);
 		dev_dbg(&tmcdrvdata->csdev->dev,
@@ -131,11 +157,7 @@ static ssize_t tmc_etr_byte_cntr_read(struct file *fp, char __user *data,
 		return -EFAULT;
 	}
 
-	if (*ppos + len >= tmcdrvdata->size)
-		*ppos = 0;
-	else
-		*ppos += len;
-
+	tmc_etr_byte_cntr_advance(ppos, len);
 	goto out;
 
 err0:
@@ -146,6 +168,83 @@ static ssize_t tmc_etr_byte_cntr_read(struct file *fp, char __user *data,
 	return len;
 }
 
+/*
+ * Zero-copy alternative to read(): hand out the position of the next block
+ * in the buffer mapped through tmc_etr_byte_cntr_mmap() instead of copying
+ * the block out.
+ */
+static int tmc_etr_byte_cntr_get_block(struct file *fp,
+				       struct byte_cntr_block __user *argp)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+	struct byte_cntr_block block;
+	size_t len = byte_cntr_data->block_size;
+	char *bufp;
+	int ret;
+
+	mutex_lock(&byte_cntr_data->byte_cntr_lock);
+	ret = tmc_etr_byte_cntr_next_block(byte_cntr_data, &fp->f_pos, &len,
+					   &bufp, fp->f_flags & O_NONBLOCK);
+	if (ret)
+		goto out;
+
+	tmc_etr_buf_sync_for_cpu(tmcdrvdata->sysfs_buf, fp->f_pos, len);
+	block.offset = fp->f_pos;
+	block.len = len;
+	tmc_etr_byte_cntr_advance(&fp->f_pos, len);
+out:
+	mutex_unlock(&byte_cntr_data->byte_cntr_lock);
+
+	if (!ret && copy_to_user(argp, &block, sizeof(block)))
+		ret = -EFAULT;
+	return ret;
+}
+
+static long tmc_etr_byte_cntr_ioctl(struct file *fp, unsigned int cmd,
+				    unsigned long arg)
+{
+	u64 size;
+
+	switch (cmd) {
+	case BYTE_CNTR_IOC_BUF_SIZE:
+		size = tmcdrvdata->size;
+		if (copy_to_user((void __user *)arg, &size, sizeof(size)))
+			return -EFAULT;
+		return 0;
+	case BYTE_CNTR_IOC_GET_BLOCK:
+		return tmc_etr_byte_cntr_get_block(fp, (void __user *)arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
+static int tmc_etr_byte_cntr_mmap(struct file *fp, struct vm_area_struct *vma)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+	int ret = -EINVAL;
+
+	mutex_lock(&byte_cntr_data->byte_cntr_lock);
+	if (byte_cntr_data->read_active && tmcdrvdata->sysfs_buf)
+		ret = tmc_etr_buf_mmap(tmcdrvdata->sysfs_buf, vma);
+	mutex_unlock(&byte_cntr_data->byte_cntr_lock);
+
+	return ret;
+}
+
+static __poll_t tmc_etr_byte_cntr_poll(struct file *fp, poll_table *wait)
+{
+	struct byte_cntr *byte_cntr_data = fp->private_data;
+
+	poll_wait(fp, &byte_cntr_data->wq, wait);
+
+	if (!byte_cntr_data->read_active)
+		return EPOLLERR;
+	if (atomic_read(&byte_cntr_data->irq_cnt) > 0 ||
+	    !byte_cntr_data->enable)
+		return EPOLLIN | EPOLLRDNORM;
+	return 0;
+}
+
 void tmc_etr_byte_cntr_start(struct byte_cntr *byte_cntr_data)
 {
 	if (!byte_cntr_data)
@@ -350,6 +449,10 @@ static const struct file_operations byte_cntr_fops = {
 	.owner		= THIS_MODULE,
 	.open		= tmc_etr_byte_cntr_open,
 	.read		= tmc_etr_byte_cntr_read,
+	.poll		= tmc_etr_byte_cntr_poll,
+	.mmap		= tmc_etr_byte_cntr_mmap,
+	.unlocked_ioctl	= tmc_etr_byte_cntr_ioctl,
+	.compat_ioctl	= tmc_etr_byte_cntr_ioctl,
 	.release	= tmc_etr_byte_cntr_release,
 	.llseek		= no_llseek,
 };
@@ -32,7 +32,9 @@ static uint32_t stm_channel_alloc(void)
 	uint32_t ch, off, num_ch_per_cpu;
 	int cpu;
 
-	num_ch_per_cpu = drvdata->numsp/num_present_cpus();
+	/* Channels at the top are reserved for user space mappings */
+	num_ch_per_cpu = (drvdata->numsp - drvdata->user_nr) /
+			 num_present_cpus();
 
 	cpu = get_cpu();
 
@@ -312,6 +312,15 @@ stm_mmio_addr(struct stm_data *stm_data, unsigned int master,
 						   struct stm_drvdata, stm);
 	phys_addr_t addr;
 
+	/*
+	 * With OST in use the kernel picks channels from the whole stimulus
+	 * port space, so user space may only map the reserved window at the
+	 * top of it.
+	 */
+	if ((stm_ost_configured() || drvdata->user_nr) &&
+	    channel < drvdata->numsp - drvdata->user_nr)
+		return 0;
+
 	addr = drvdata->chs.phys + channel * BYTES_PER_CHANNEL;
 
 	if (offset_in_page(addr) ||
@@ -580,6 +589,54 @@ static ssize_t traceid_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(traceid);
 
+static ssize_t user_channels_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct stm_drvdata *drvdata = dev_get_drvdata(dev->parent);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", drvdata->user_nr);
+}
+
+static int stm_set_user_channels(struct stm_drvdata *drvdata, u32 nr)
+{
+	/* Each user mapping covers whole pages of stimulus ports */
+	if (nr % (PAGE_SIZE / BYTES_PER_CHANNEL))
+		return -EINVAL;
+
+	/* Leave every CPU at least one channel for kernel OST writes */
+	if (nr > drvdata->numsp ||
+	    (stm_ost_configured() &&
+	     drvdata->numsp - nr < num_present_cpus()))
+		return -EINVAL;
+
+	drvdata->user_nr = nr;
+	return 0;
+}
+
+static ssize_t user_channels_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t size)
+{
+	struct stm_drvdata *drvdata = dev_get_drvdata(dev->parent);
+	u32 val;
+	int ret;
+
+	if (kstrtou32(buf, 0, &val))
+		return -EINVAL;
+
+	/*
+	 * The OST allocator reads the window locklessly, so only move it
+	 * while the STM is idle.
+	 */
+	if (local_read(&drvdata->mode) != CS_MODE_DISABLED)
+		return -EBUSY;
+
+	ret = stm_set_user_channels(drvdata, val);
+
+	return ret ? ret : size;
+}
+static DEVICE_ATTR_RW(user_channels);
+
 #ifdef CONFIG_CORESIGHT_QGKI
 static ssize_t entities_show(struct device *dev,
 				struct device_attribute *attr, char *buf)
@@ -649,6 +706,7 @@ static struct attribute *coresight_stm_attrs[] = {
 	&dev_attr_port_enable.attr,
 	&dev_attr_port_select.attr,
 	&dev_attr_traceid.attr,
+	&dev_attr_user_channels.attr,
 #ifdef CONFIG_CORESIGHT_QGKI
 	&dev_attr_entities.attr,
 #endif
@@ -857,6 +915,7 @@ static void stm_init_generic_data(struct stm_drvdata *drvdata,
 static int stm_probe(struct amba_device *adev, const struct amba_id *id)
 {
 	int ret;
+	u32 nr;
 	void __iomem *base;
 	unsigned long *guaranteed;
 	struct device *dev = &adev->dev;
@@ -918,6 +977,10 @@ static int stm_probe(struct amba_device *adev, const struct amba_id *id)
 		return -ENOMEM;
 	drvdata->chs.guaranteed = guaranteed;
 
+	if (!of_property_read_u32(dev->of_node, "qcom,user-channels", &nr) &&
+	    stm_set_user_channels(drvdata, nr))
+		dev_warn(dev, "invalid qcom,user-channels %u\n", nr);
+
 	spin_lock_init(&drvdata->spinlock);
 
 	stm_init_default_data(drvdata);
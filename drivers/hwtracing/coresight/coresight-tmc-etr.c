@@ -9,6 +9,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/iommu.h>
 #include <linux/idr.h>
+#include <linux/mm.h>
 #include <linux/mutex.h>
 #include <linux/refcount.h>
 #include <linux/slab.h>
@@ -943,6 +944,51 @@ ssize_t tmc_etr_buf_get_data(struct etr_buf *etr_buf,
 	return etr_buf->ops->get_data(etr_buf, (u64)offset, len, bufpp);
 }
 
+/*
+ * tmc_etr_buf_sync_for_cpu: Make @size bytes of trace at @offset visible to
+ * the CPU, including through userspace mappings of the buffer.
+ */
+void tmc_etr_buf_sync_for_cpu(struct etr_buf *etr_buf, u64 offset, u64 size)
+{
+	struct etr_sg_table *etr_table = etr_buf->private;
+
+	if (etr_buf->mode == ETR_MODE_ETR_SG)
+		tmc_sg_table_sync_data_range(etr_table->sg_table, offset, size);
+}
+
+/*
+ * tmc_etr_buf_mmap: Map the data pages of an SG mode @etr_buf read-only
+ * into @vma. Each page is referenced by the mapping, so it remains valid
+ * even if the buffer is freed before it is unmapped.
+ */
+int tmc_etr_buf_mmap(struct etr_buf *etr_buf, struct vm_area_struct *vma)
+{
+	struct etr_sg_table *etr_table = etr_buf->private;
+	struct tmc_pages *data;
+	unsigned long addr = vma->vm_start;
+	int i, nr_pages, ret;
+
+	if (etr_buf->mode != ETR_MODE_ETR_SG)
+		return -EOPNOTSUPP;
+
+	data = &etr_table->sg_table->data_pages;
+	nr_pages = vma_pages(vma);
+	if (vma->vm_pgoff || nr_pages > data->nr_pages)
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	for (i = 0; i < nr_pages; i++, addr += PAGE_SIZE) {
+		ret = vm_insert_page(vma, addr, data->pages[i]);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 static inline s64
 tmc_etr_buf_insert_barrier_packet(struct etr_buf *etr_buf, u64 offset)
 {
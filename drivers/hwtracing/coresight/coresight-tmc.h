@@ -364,6 +364,8 @@ ssize_t tmc_etr_buf_get_data(struct etr_buf *etr_buf,
 				u64 offset, size_t len, char **bufpp);
 int tmc_etr_switch_mode(struct tmc_drvdata *drvdata, const char *out_mode);
 long tmc_sg_get_rwp_offset(struct tmc_drvdata *drvdata);
+void tmc_etr_buf_sync_for_cpu(struct etr_buf *etr_buf, u64 offset, u64 size);
+int tmc_etr_buf_mmap(struct etr_buf *etr_buf, struct vm_area_struct *vma);
 
 #define TMC_REG_PAIR(name, lo_off, hi_off)				\
 static inline u64							\
@@ -20,6 +20,7 @@
 #include <linux/acpi.h>
 #include <linux/acpi_iort.h>
 #include <linux/bitfield.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-iommu.h>
@@ -795,11 +796,32 @@ static void arm_smmu_domain_power_off(struct iommu_domain *domain,
 	arm_smmu_power_off(smmu, smmu->pwr);
 }
 
+/*
+ * Largest unmap, in pages of the smallest supported size, that is flushed
+ * with per-VA TLBIs rather than a single TLBIASID. Past this the cost of
+ * the individual register writes outweighs refilling the ASID's TLB.
+ */
+static unsigned int tlbi_va_max_pages = 32;
+module_param(tlbi_va_max_pages, uint, 0644);
+
+static void arm_smmu_tlbi_sync_account(struct arm_smmu_device *smmu,
+				       ktime_t start)
+{
+	struct arm_smmu_tlbi_stats *stats = &smmu->tlbi_stats;
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	atomic64_inc(&stats->syncs);
+	atomic64_add(ns, &stats->sync_ns);
+	if (ns > READ_ONCE(stats->sync_max_ns))
+		WRITE_ONCE(stats->sync_max_ns, ns);
+}
+
 /* Wait for any pending TLB invalidations to complete */
 static int __arm_smmu_tlb_sync(struct arm_smmu_device *smmu, int page,
 				int sync, int status)
 {
 	unsigned int inc, delay;
+	ktime_t start;
 	u32 reg;
 
 	/*
@@ -813,11 +835,14 @@ static int __arm_smmu_tlb_sync(struct arm_smmu_device *smmu, int page,
 	    test_bit(0, &smmu->sync_timed_out))
 		return -EINVAL;
 
+	start = ktime_get();
 	arm_smmu_writel(smmu, page, sync, QCOM_DUMMY_VAL);
 	for (delay = 1, inc = 1; delay < TLB_LOOP_TIMEOUT; delay += inc) {
 		reg = arm_smmu_readl(smmu, page, status);
-		if (!(reg & sTLBGSTATUS_GSACTIVE))
+		if (!(reg & sTLBGSTATUS_GSACTIVE)) {
+			arm_smmu_tlbi_sync_account(smmu, start);
 			return 0;
+		}
 
 		cpu_relax();
 		udelay(inc);
@@ -872,6 +897,36 @@ static void arm_smmu_tlb_sync_vmid(void *cookie)
 	arm_smmu_tlb_sync_global(smmu_domain->smmu);
 }
 
+static void arm_smmu_tlb_inv_range_s1(unsigned long iova, size_t size,
+				      size_t granule, bool leaf, void *cookie);
+
+/*
+ * io-pgtable finishes every unmap with a flush of the whole context. When
+ * that flush is issued from arm_smmu_unmap() for a small range, invalidate
+ * just that range instead so the rest of the ASID's TLB entries survive.
+ * Non-leaf TLBIVAs are used since the unmap may also have freed tables.
+ */
+static bool arm_smmu_tlb_inv_unmap_range(struct arm_smmu_domain *smmu_domain)
+{
+	struct arm_smmu_device *smmu = smmu_domain->smmu;
+	size_t granule = 1UL << __ffs(smmu->pgsize_bitmap);
+	unsigned long iova = smmu_domain->unmap_iova;
+	size_t size = smmu_domain->unmap_size;
+
+	if (!size || smmu->options & ARM_SMMU_OPT_NO_ASID_RETENTION)
+		return false;
+
+	iova = round_down(iova, granule);
+	size = round_up(smmu_domain->unmap_iova + size, granule) - iova;
+	if (size / granule > tlbi_va_max_pages)
+		return false;
+
+	arm_smmu_tlb_inv_range_s1(iova, size, granule, false, smmu_domain);
+	atomic64_inc(&smmu->tlbi_stats.va_flushes);
+	atomic64_add(size / granule, &smmu->tlbi_stats.va_ops);
+	return true;
+}
+
 static void arm_smmu_tlb_inv_context_s1(void *cookie)
 {
 	struct arm_smmu_domain *smmu_domain = cookie;
@@ -884,6 +939,15 @@ static void arm_smmu_tlb_inv_context_s1(void *cookie)
 
 	trace_tlbi_start(dev, 0);
 
+	if (arm_smmu_tlb_inv_unmap_range(smmu_domain)) {
+		arm_smmu_tlb_sync_context(cookie);
+		/* Invalidations deferred during this unmap are covered too */
+		smmu_domain->defer_flush = false;
+		trace_tlbi_end(dev, ktime_us_delta(ktime_get(), cur));
+		return;
+	}
+
+	atomic64_inc(&smmu->tlbi_stats.asid_flushes);
 	if (!use_tlbiall) {
 		wmb();
 		arm_smmu_cb_write(smmu, idx, ARM_SMMU_CB_S1_TLBIASID,
@@ -3298,7 +3362,17 @@ static size_t arm_smmu_unmap(struct iommu_domain *domain, unsigned long iova,
 
 	arm_smmu_rpm_get(smmu);
 	spin_lock_irqsave(&smmu_domain->cb_lock, flags);
+	/*
+	 * Invalidations left deferred by an earlier operation are not confined
+	 * to this range, nor is a VA meaningful on its own with split tables.
+	 */
+	if (!smmu_domain->defer_flush &&
+	    !test_bit(DOMAIN_ATTR_SPLIT_TABLES, smmu_domain->attributes)) {
+		smmu_domain->unmap_iova = iova;
+		smmu_domain->unmap_size = size;
+	}
 	ret = ops->unmap(ops, iova, size, gather);
+	smmu_domain->unmap_size = 0;
 	spin_unlock_irqrestore(&smmu_domain->cb_lock, flags);
 	arm_smmu_rpm_put(smmu);
 
@@ -4836,6 +4910,51 @@ static const struct of_device_id arm_smmu_of_match[] = {
 };
 MODULE_DEVICE_TABLE(of, arm_smmu_of_match);
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static struct dentry *debugfs_tlbi_dir;
+
+static int arm_smmu_tlbi_stats_show(struct seq_file *s, void *unused)
+{
+	struct arm_smmu_device *smmu = s->private;
+	struct arm_smmu_tlbi_stats *stats = &smmu->tlbi_stats;
+	u64 syncs = atomic64_read(&stats->syncs);
+	u64 sync_ns = atomic64_read(&stats->sync_ns);
+
+	seq_printf(s, "va_flushes: %lld\n", atomic64_read(&stats->va_flushes));
+	seq_printf(s, "va_ops: %lld\n", atomic64_read(&stats->va_ops));
+	seq_printf(s, "asid_flushes: %lld\n",
+		   atomic64_read(&stats->asid_flushes));
+	seq_printf(s, "syncs: %llu\n", syncs);
+	seq_printf(s, "sync_avg_ns: %llu\n",
+		   syncs ? div64_u64(sync_ns, syncs) : 0);
+	seq_printf(s, "sync_max_ns: %llu\n", READ_ONCE(stats->sync_max_ns));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(arm_smmu_tlbi_stats);
+
+static void arm_smmu_tlbi_debugfs_init(struct arm_smmu_device *smmu)
+{
+	if (!iommu_debugfs_dir)
+		return;
+
+	if (!debugfs_tlbi_dir) {
+		debugfs_tlbi_dir = debugfs_create_dir("tlbi", iommu_debugfs_dir);
+		if (IS_ERR(debugfs_tlbi_dir)) {
+			debugfs_tlbi_dir = NULL;
+			return;
+		}
+	}
+
+	smmu->debugfs_tlbi = debugfs_create_file(dev_name(smmu->dev), 0400,
+						 debugfs_tlbi_dir, smmu,
+						 &arm_smmu_tlbi_stats_fops);
+}
+#else
+static void arm_smmu_tlbi_debugfs_init(struct arm_smmu_device *smmu)
+{
+}
+#endif
+
 #ifdef CONFIG_ACPI
 static int acpi_smmu_get_data(u32 model, struct arm_smmu_device *smmu)
 {
@@ -5093,6 +5212,7 @@ static int arm_smmu_device_dt_probe(struct platform_device *pdev)
 		return err;
 	}
 	platform_set_drvdata(pdev, smmu);
+	arm_smmu_tlbi_debugfs_init(smmu);
 	arm_smmu_device_reset(smmu);
 	arm_smmu_test_smr_masks(smmu);
 	arm_smmu_interrupt_selftest(smmu);
@@ -5165,6 +5285,7 @@ static int arm_smmu_device_remove(struct platform_device *pdev)
 
 	arm_smmu_bus_init(NULL);
 	iommu_device_unregister(&smmu->iommu);
+	debugfs_remove(smmu->debugfs_tlbi);
 
 	if (smmu->impl && smmu->impl->device_remove)
 		smmu->impl->device_remove(smmu);
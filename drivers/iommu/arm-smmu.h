@@ -333,6 +333,16 @@ struct arm_smmu_smr {
 	bool				valid;
 };
 
+/* Stage 1 context invalidation counters, exported through debugfs */
+struct arm_smmu_tlbi_stats {
+	atomic64_t			va_flushes;
+	atomic64_t			va_ops;
+	atomic64_t			asid_flushes;
+	atomic64_t			syncs;
+	atomic64_t			sync_ns;
+	u64				sync_max_ns;
+};
+
 struct arm_smmu_device {
 	struct device			*dev;
 
@@ -405,6 +415,9 @@ struct arm_smmu_device {
 	struct idr			asid_idr;
 
 	unsigned long			sync_timed_out;
+
+	struct arm_smmu_tlbi_stats	tlbi_stats;
+	struct dentry			*debugfs_tlbi;
 };
 
 struct qsmmuv500_tbu_device {
@@ -494,6 +507,13 @@ struct arm_smmu_domain {
 	struct iommu_debug_attachment	*logger;
 	struct msm_iommu_domain		domain;
 	bool				defer_flush;
+	/*
+	 * Range being torn down by arm_smmu_unmap(), protected by cb_lock.
+	 * Lets the context flush at the end of the unmap invalidate by VA
+	 * instead of dropping every TLB entry of the ASID.
+	 */
+	unsigned long			unmap_iova;
+	size_t				unmap_size;
 };
 
 
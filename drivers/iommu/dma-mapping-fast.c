@@ -13,6 +13,7 @@
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
 #include <linux/pci.h>
+#include <linux/percpu.h>
 #include <linux/dma-iommu.h>
 #include <linux/iova.h>
 #include <trace/events/iommu.h>
@@ -23,6 +24,24 @@
 #define FAST_PAGE_SIZE (1UL << FAST_PAGE_SHIFT)
 #define FAST_PAGE_MASK (~(PAGE_SIZE - 1))
 
+/*
+ * Single page IOVAs are served from per-CPU magazines so that high rate
+ * map/unmap users don't serialise on mapping->lock. The ready magazine
+ * holds TLB-clean IOVAs taken from the bitmap in one batch; the dirty
+ * magazine holds unmapped IOVAs whose TLB entries may still be live, and
+ * is handed back to the bitmap in one batch, where the usual stale TLB
+ * tracking takes over until the next wrap-around invalidation.
+ */
+#define FAST_IOVA_MAG_SIZE	32
+
+struct fast_iova_magazine {
+	spinlock_t lock;
+	unsigned int nr_ready;
+	unsigned int nr_dirty;
+	dma_addr_t ready[FAST_IOVA_MAG_SIZE];
+	dma_addr_t dirty[FAST_IOVA_MAG_SIZE];
+};
+
 static pgprot_t __get_dma_pgprot(unsigned long attrs, pgprot_t prot,
 				 bool coherent)
 {
@@ -158,6 +177,112 @@ static void __fast_smmu_free_iova(struct dma_fast_smmu_mapping *mapping,
 	mapping->have_stale_tlbs = true;
 }
 
+/* Hand a magazine's unmapped IOVAs back to the bitmap. Called with both locks */
+static void __fast_smmu_flush_dirty(struct dma_fast_smmu_mapping *mapping,
+				    struct fast_iova_magazine *mag)
+{
+	while (mag->nr_dirty)
+		__fast_smmu_free_iova(mapping, mag->dirty[--mag->nr_dirty],
+				      FAST_PAGE_SIZE);
+}
+
+static void __fast_smmu_refill_ready(struct dma_fast_smmu_mapping *mapping,
+				     struct fast_iova_magazine *mag,
+				     unsigned long attrs)
+{
+	dma_addr_t iova;
+
+	__fast_smmu_flush_dirty(mapping, mag);
+	while (mag->nr_ready < FAST_IOVA_MAG_SIZE / 2) {
+		iova = __fast_smmu_alloc_iova(mapping, attrs, FAST_PAGE_SIZE);
+		if (iova == DMA_ERROR_CODE)
+			break;
+		mag->ready[mag->nr_ready++] = iova;
+	}
+}
+
+/* Return every IOVA parked in a magazine, used when the bitmap runs dry */
+static void fast_smmu_drain_magazines(struct dma_fast_smmu_mapping *mapping)
+{
+	struct fast_iova_magazine *mag;
+	unsigned long flags, bit;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		mag = per_cpu_ptr(mapping->mags, cpu);
+		spin_lock_irqsave(&mag->lock, flags);
+		spin_lock(&mapping->lock);
+		__fast_smmu_flush_dirty(mapping, mag);
+		/* Ready IOVAs were never mapped, so they are still TLB-clean */
+		while (mag->nr_ready) {
+			bit = (mag->ready[--mag->nr_ready] - mapping->base) >>
+			      FAST_PAGE_SHIFT;
+			__clear_bit(bit, mapping->bitmap);
+			__clear_bit(bit, mapping->clean_bitmap);
+		}
+		spin_unlock(&mapping->lock);
+		spin_unlock_irqrestore(&mag->lock, flags);
+	}
+}
+
+static dma_addr_t fast_smmu_alloc_iova(struct dma_fast_smmu_mapping *mapping,
+				       unsigned long attrs, size_t size)
+{
+	struct fast_iova_magazine *mag;
+	dma_addr_t iova = DMA_ERROR_CODE;
+	unsigned long flags;
+
+	if (size == FAST_PAGE_SIZE && mapping->mags) {
+		mag = raw_cpu_ptr(mapping->mags);
+		spin_lock_irqsave(&mag->lock, flags);
+		if (!mag->nr_ready) {
+			spin_lock(&mapping->lock);
+			__fast_smmu_refill_ready(mapping, mag, attrs);
+			spin_unlock(&mapping->lock);
+		}
+		if (mag->nr_ready)
+			iova = mag->ready[--mag->nr_ready];
+		spin_unlock_irqrestore(&mag->lock, flags);
+		if (likely(iova != DMA_ERROR_CODE))
+			return iova;
+	} else {
+		spin_lock_irqsave(&mapping->lock, flags);
+		iova = __fast_smmu_alloc_iova(mapping, attrs, size);
+		spin_unlock_irqrestore(&mapping->lock, flags);
+		if (likely(iova != DMA_ERROR_CODE) || !mapping->mags)
+			return iova;
+	}
+
+	fast_smmu_drain_magazines(mapping);
+	spin_lock_irqsave(&mapping->lock, flags);
+	iova = __fast_smmu_alloc_iova(mapping, attrs, size);
+	spin_unlock_irqrestore(&mapping->lock, flags);
+	return iova;
+}
+
+static void fast_smmu_free_iova(struct dma_fast_smmu_mapping *mapping,
+				dma_addr_t iova, size_t size)
+{
+	struct fast_iova_magazine *mag;
+	unsigned long flags;
+
+	if (size != FAST_PAGE_SIZE || !mapping->mags) {
+		spin_lock_irqsave(&mapping->lock, flags);
+		__fast_smmu_free_iova(mapping, iova, size);
+		spin_unlock_irqrestore(&mapping->lock, flags);
+		return;
+	}
+
+	mag = raw_cpu_ptr(mapping->mags);
+	spin_lock_irqsave(&mag->lock, flags);
+	if (mag->nr_dirty == FAST_IOVA_MAG_SIZE) {
+		spin_lock(&mapping->lock);
+		__fast_smmu_flush_dirty(mapping, mag);
+		spin_unlock(&mapping->lock);
+	}
+	mag->dirty[mag->nr_dirty++] = iova & FAST_PAGE_MASK;
+	spin_unlock_irqrestore(&mag->lock, flags);
+}
 
 static void __fast_dma_page_cpu_to_dev(struct page *page, unsigned long off,
 				       size_t size, enum dma_data_direction dir)
@@ -185,7 +310,6 @@ static dma_addr_t fast_smmu_map_page(struct device *dev, struct page *page,
 {
 	struct dma_fast_smmu_mapping *mapping = dev_get_mapping(dev);
 	dma_addr_t iova;
-	unsigned long flags;
 	phys_addr_t phys_plus_off = page_to_phys(page) + offset;
 	phys_addr_t phys_to_map = round_down(phys_plus_off, FAST_PAGE_SIZE);
 	unsigned long offset_from_phys_to_map = phys_plus_off & ~FAST_PAGE_MASK;
@@ -198,28 +322,20 @@ static dma_addr_t fast_smmu_map_page(struct device *dev, struct page *page,
 		__fast_dma_page_cpu_to_dev(phys_to_page(phys_to_map),
 					   offset_from_phys_to_map, size, dir);
 
-	spin_lock_irqsave(&mapping->lock, flags);
-
-	iova = __fast_smmu_alloc_iova(mapping, attrs, len);
+	iova = fast_smmu_alloc_iova(mapping, attrs, len);
 
 	if (unlikely(iova == DMA_ERROR_CODE))
-		goto fail;
+		return DMA_ERROR_CODE;
 
 	if (unlikely(av8l_fast_map_public(mapping->pgtbl_ops, iova,
-					  phys_to_map, len, prot)))
-		goto fail_free_iova;
-
-	spin_unlock_irqrestore(&mapping->lock, flags);
+					  phys_to_map, len, prot))) {
+		fast_smmu_free_iova(mapping, iova, len);
+		return DMA_ERROR_CODE;
+	}
 
 	trace_map(to_msm_iommu_domain(mapping->domain), iova, phys_to_map, len,
 		  prot);
 	return iova + offset_from_phys_to_map;
-
-fail_free_iova:
-	__fast_smmu_free_iova(mapping, iova, size);
-fail:
-	spin_unlock_irqrestore(&mapping->lock, flags);
-	return DMA_ERROR_CODE;
 }
 
 static void fast_smmu_unmap_page(struct device *dev, dma_addr_t iova,
@@ -227,7 +343,6 @@ static void fast_smmu_unmap_page(struct device *dev, dma_addr_t iova,
 			       unsigned long attrs)
 {
 	struct dma_fast_smmu_mapping *mapping = dev_get_mapping(dev);
-	unsigned long flags;
 	unsigned long offset = iova & ~FAST_PAGE_MASK;
 	size_t len = ALIGN(size + offset, FAST_PAGE_SIZE);
 	bool skip_sync = (attrs & DMA_ATTR_SKIP_CPU_SYNC);
@@ -243,10 +358,8 @@ static void fast_smmu_unmap_page(struct device *dev, dma_addr_t iova,
 						size, dir);
 	}
 
-	spin_lock_irqsave(&mapping->lock, flags);
 	av8l_fast_unmap_public(mapping->pgtbl_ops, iova, len);
-	__fast_smmu_free_iova(mapping, iova, len);
-	spin_unlock_irqrestore(&mapping->lock, flags);
+	fast_smmu_free_iova(mapping, iova, len);
 
 	trace_unmap(to_msm_iommu_domain(mapping->domain), iova - offset, len,
 		    len);
@@ -328,14 +441,11 @@ static int fast_smmu_map_sg(struct device *dev, struct scatterlist *sg,
 	int prot = dma_info_to_prot(dir, is_coherent, attrs);
 	int ret;
 	dma_addr_t iova;
-	unsigned long flags;
 	size_t unused;
 
 	iova_len = iommu_dma_prepare_map_sg(dev, mapping->iovad, sg, nents);
 
-	spin_lock_irqsave(&mapping->lock, flags);
-	iova = __fast_smmu_alloc_iova(mapping, attrs, iova_len);
-	spin_unlock_irqrestore(&mapping->lock, flags);
+	iova = fast_smmu_alloc_iova(mapping, attrs, iova_len);
 
 	if (unlikely(iova == DMA_ERROR_CODE))
 		goto fail;
@@ -362,7 +472,6 @@ static void fast_smmu_unmap_sg(struct device *dev,
 			       unsigned long attrs)
 {
 	struct dma_fast_smmu_mapping *mapping = dev_get_mapping(dev);
-	unsigned long flags;
 	dma_addr_t start;
 	size_t len, offset;
 	struct scatterlist *tmp;
@@ -387,9 +496,7 @@ static void fast_smmu_unmap_sg(struct device *dev,
 
 	av8l_fast_unmap_public(mapping->pgtbl_ops, start, len);
 
-	spin_lock_irqsave(&mapping->lock, flags);
-	__fast_smmu_free_iova(mapping, start, len);
-	spin_unlock_irqrestore(&mapping->lock, flags);
+	fast_smmu_free_iova(mapping, start, len);
 	trace_unmap(to_msm_iommu_domain(mapping->domain), start, len, len);
 }
 
@@ -808,6 +915,7 @@ static struct dma_fast_smmu_mapping *__fast_smmu_create_mapping_sized(
 	dma_addr_t base, u64 size)
 {
 	struct dma_fast_smmu_mapping *fast;
+	int cpu;
 
 	fast = kzalloc(sizeof(struct dma_fast_smmu_mapping), GFP_KERNEL);
 	if (!fast)
@@ -836,15 +944,22 @@ static struct dma_fast_smmu_mapping *__fast_smmu_create_mapping_sized(
 
 	spin_lock_init(&fast->lock);
 
+	/* Without magazines every IOVA goes through the shared bitmap */
+	fast->mags = alloc_percpu(struct fast_iova_magazine);
+	if (fast->mags)
+		for_each_possible_cpu(cpu)
+			spin_lock_init(&per_cpu_ptr(fast->mags, cpu)->lock);
+
 	fast->iovad = kzalloc(sizeof(*fast->iovad), GFP_KERNEL);
 	if (!fast->iovad)
-		goto err_free_bitmap;
+		goto err_free_mags;
 	init_iova_domain(fast->iovad, FAST_PAGE_SIZE,
 			base >> FAST_PAGE_SHIFT);
 
 	return fast;
 
-err_free_bitmap:
+err_free_mags:
+	free_percpu(fast->mags);
 	kvfree(fast->clean_bitmap);
 err3:
 	kvfree(fast->bitmap);
@@ -917,6 +1032,7 @@ void fast_smmu_put_dma_cookie(struct iommu_domain *domain)
 	if (fast->clean_bitmap)
 		kvfree(fast->clean_bitmap);
 
+	free_percpu(fast->mags);
 	kfree(fast);
 	domain->iova_cookie = NULL;
 }
@@ -31,6 +31,7 @@
 
 #define AV8L_FAST_PTE_NSTABLE		(((av8l_fast_iopte)1) << 63)
 #define AV8L_FAST_PTE_XN		(((av8l_fast_iopte)3) << 53)
+#define AV8L_FAST_PTE_CONT		(((av8l_fast_iopte)1) << 52)
 #define AV8L_FAST_PTE_AF		(((av8l_fast_iopte)1) << 10)
 #define AV8L_FAST_PTE_SH_NS		(((av8l_fast_iopte)0) << 8)
 #define AV8L_FAST_PTE_SH_OS		(((av8l_fast_iopte)2) << 8)
@@ -121,6 +122,10 @@
 
 #define AV8L_FAST_PAGE_SHIFT		12
 
+/* A contiguous run is 16 4K entries mapping an aligned 64K region */
+#define AV8L_FAST_CONT_PTES		16
+#define AV8L_FAST_CONT_SIZE		(AV8L_FAST_CONT_PTES << AV8L_FAST_PAGE_SHIFT)
+
 #define PTE_MAIR_IDX(pte)				\
 	((pte >> AV8L_FAST_PTE_ATTRINDX_SHIFT) &	\
 	 AV8L_FAST_PTE_ATTRINDX_MASK)
@@ -245,21 +250,43 @@ av8l_fast_prot_to_pte(struct av8l_fast_io_pgtable *data, int prot)
 	return pte;
 }
 
+/*
+ * Fill the PTEs for a physically contiguous range without cleaning them
+ * to memory. Runs of 16 entries that map an aligned 64K region get the
+ * contiguous hint, which needs the IOVA and the physical address to share
+ * their offset within 64K.
+ */
+static void __av8l_fast_set_ptes(av8l_fast_iopte *ptep, unsigned long iova,
+				 phys_addr_t paddr, unsigned long nptes,
+				 av8l_fast_iopte pte)
+{
+	unsigned long i;
+	av8l_fast_iopte cont = 0;
+	bool use_cont = IS_ENABLED(CONFIG_IOMMU_IO_PGTABLE_FAST_CONT_HINT) &&
+			!((iova ^ paddr) & (AV8L_FAST_CONT_SIZE - 1));
+
+	paddr &= AV8L_FAST_PTE_ADDR_MASK;
+	for (i = 0; i < nptes; i++, ptep++, iova += SZ_4K, paddr += SZ_4K) {
+		/* Decide at each 64K boundary whether a full run follows */
+		if (IS_ALIGNED(iova, AV8L_FAST_CONT_SIZE))
+			cont = (use_cont && nptes - i >= AV8L_FAST_CONT_PTES) ?
+				AV8L_FAST_PTE_CONT : 0;
+		__av8l_check_for_stale_tlb(ptep);
+		*ptep = pte | cont | paddr;
+	}
+}
+
 static int av8l_fast_map(struct io_pgtable_ops *ops, unsigned long iova,
 			 phys_addr_t paddr, size_t size, int prot)
 {
 	struct av8l_fast_io_pgtable *data = iof_pgtable_ops_to_data(ops);
 	struct io_pgtable *iop = iof_pgtable_ops_to_pgtable(ops);
 	av8l_fast_iopte *ptep = iopte_pmd_offset(data->pmds, data->base, iova);
-	unsigned long i, nptes = size >> AV8L_FAST_PAGE_SHIFT;
+	unsigned long nptes = size >> AV8L_FAST_PAGE_SHIFT;
 	av8l_fast_iopte pte;
 
 	pte = av8l_fast_prot_to_pte(data, prot);
-	paddr &= AV8L_FAST_PTE_ADDR_MASK;
-	for (i = 0; i < nptes; i++, paddr += SZ_4K) {
-		__av8l_check_for_stale_tlb(ptep + i);
-		*(ptep + i) = pte | paddr;
-	}
+	__av8l_fast_set_ptes(ptep, iova, paddr, nptes, pte);
 	av8l_clean_range(&iop->cfg, ptep, ptep + nptes);
 
 	return 0;
@@ -307,18 +334,35 @@ static size_t av8l_fast_unmap(struct io_pgtable_ops *ops, unsigned long iova,
 	return __av8l_fast_unmap(ops, iova, size, false);
 }
 
+/*
+ * The segments are mapped back to back, so fill in all of their PTEs first
+ * and clean the whole range to memory once instead of once per segment.
+ */
 static int av8l_fast_map_sg(struct io_pgtable_ops *ops,
 			unsigned long iova, struct scatterlist *sgl,
 			unsigned int nents, int prot, size_t *size)
 {
+	struct av8l_fast_io_pgtable *data = iof_pgtable_ops_to_data(ops);
+	struct io_pgtable *iop = iof_pgtable_ops_to_pgtable(ops);
+	av8l_fast_iopte *start = iopte_pmd_offset(data->pmds, data->base, iova);
+	av8l_fast_iopte *ptep = start;
+	av8l_fast_iopte pte = av8l_fast_prot_to_pte(data, prot);
+	unsigned long nptes;
 	struct scatterlist *sg;
+	size_t mapped = 0;
 	int i;
 
 	for_each_sg(sgl, sg, nents, i) {
-		av8l_fast_map(ops, iova, sg_phys(sg), sg->length, prot);
+		nptes = sg->length >> AV8L_FAST_PAGE_SHIFT;
+		__av8l_fast_set_ptes(ptep, iova, sg_phys(sg), nptes, pte);
+		ptep += nptes;
 		iova += sg->length;
+		mapped += sg->length;
 	}
+	av8l_clean_range(&iop->cfg, start, ptep);
 
+	if (size)
+		*size = mapped;
 	return nents;
 }
 
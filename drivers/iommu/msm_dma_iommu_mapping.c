@@ -11,6 +11,9 @@
 #include <linux/module.h>
 #include <linux/mutex.h>
 #include <linux/err.h>
+#include <linux/debugfs.h>
+#include <linux/moduleparam.h>
+#include <linux/seq_file.h>
 #include <asm/barrier.h>
 
 #include <linux/msm_dma_iommu_mapping.h>
@@ -26,6 +29,10 @@
  * @ref - for reference counting this mapping
  * @attrs - dma mapping attributes
  * @buf_start_addr - address of start of buffer
+ * @lru - node in the idle list while only the lazy reference is held
+ * @cache - per-device accounting this mapping is charged to
+ * @size - bytes covered by the mapping
+ * @lazy - mapping holds an extra reference until the buffer is freed
  *
  * Represents a mapping of one dma_buf buffer to a particular device
  * and address range. There may exist other mappings of this buffer in
@@ -42,6 +49,28 @@ struct msm_iommu_map {
 	struct kref ref;
 	unsigned long attrs;
 	dma_addr_t buf_start_addr;
+	struct list_head lru;
+	struct msm_iommu_dev_cache *cache;
+	size_t size;
+	bool lazy;
+};
+
+/**
+ * struct msm_iommu_dev_cache - lazy mapping accounting for one device
+ * @node - entry in msm_iommu_dev_caches
+ * @dev - the device
+ * @idle_bytes - bytes of lazy mappings currently not in use by the client
+ * @hits - map requests served by an existing mapping
+ * @misses - map requests that created a new mapping
+ * @evictions - idle mappings unmapped to stay within the budget
+ */
+struct msm_iommu_dev_cache {
+	struct list_head node;
+	struct device *dev;
+	size_t idle_bytes;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
 };
 
 struct msm_iommu_meta {
@@ -55,6 +84,67 @@ struct msm_iommu_meta {
 static struct rb_root iommu_root;
 static DEFINE_MUTEX(msm_iommu_map_mutex);
 
+/*
+ * Idle lazy mappings, oldest first. Protected by msm_iommu_lru_lock, which
+ * nests inside the meta locks.
+ */
+static LIST_HEAD(msm_iommu_lru);
+static LIST_HEAD(msm_iommu_dev_caches);
+static DEFINE_SPINLOCK(msm_iommu_lru_lock);
+
+/* Per-device budget of idle lazy mappings in MB, 0 for unlimited */
+static unsigned int lazy_budget_mb = 512;
+module_param(lazy_budget_mb, uint, 0644);
+
+static struct msm_iommu_dev_cache *msm_iommu_dev_cache_get(struct device *dev)
+{
+	struct msm_iommu_dev_cache *cache, *new;
+
+	spin_lock(&msm_iommu_lru_lock);
+	list_for_each_entry(cache, &msm_iommu_dev_caches, node)
+		if (cache->dev == dev)
+			goto out;
+	spin_unlock(&msm_iommu_lru_lock);
+
+	new = kzalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return NULL;
+	new->dev = dev;
+
+	spin_lock(&msm_iommu_lru_lock);
+	list_for_each_entry(cache, &msm_iommu_dev_caches, node)
+		if (cache->dev == dev) {
+			kfree(new);
+			goto out;
+		}
+	cache = new;
+	list_add_tail(&cache->node, &msm_iommu_dev_caches);
+out:
+	spin_unlock(&msm_iommu_lru_lock);
+	return cache;
+}
+
+/* Called with the meta lock held */
+static void msm_iommu_map_set_idle(struct msm_iommu_map *map, bool idle)
+{
+	spin_lock(&msm_iommu_lru_lock);
+	if (idle && list_empty(&map->lru)) {
+		list_add_tail(&map->lru, &msm_iommu_lru);
+		map->cache->idle_bytes += map->size;
+	} else if (!idle && !list_empty(&map->lru)) {
+		list_del_init(&map->lru);
+		map->cache->idle_bytes -= map->size;
+	}
+	spin_unlock(&msm_iommu_lru_lock);
+}
+
+static bool msm_iommu_over_budget(struct msm_iommu_dev_cache *cache)
+{
+	size_t budget = (size_t)READ_ONCE(lazy_budget_mb) << 20;
+
+	return budget && cache->idle_bytes > budget;
+}
+
 static void msm_iommu_meta_add(struct msm_iommu_meta *meta)
 {
 	struct rb_root *root = &iommu_root;
@@ -141,6 +231,59 @@ static struct msm_iommu_meta *msm_iommu_meta_create(struct dma_buf *dma_buf)
 }
 
 static void msm_iommu_meta_put(struct msm_iommu_meta *meta);
+static void msm_iommu_map_release(struct kref *kref);
+
+/*
+ * Unmap the oldest idle mappings of a device until its idle mappings fit
+ * in the budget again. Called without any of the mapping locks held.
+ */
+static void msm_iommu_evict(struct msm_iommu_dev_cache *cache)
+{
+	struct msm_iommu_map *map;
+	struct msm_iommu_meta *meta;
+	bool found;
+
+	/* Holding msm_iommu_map_mutex keeps the metas from being destroyed */
+	mutex_lock(&msm_iommu_map_mutex);
+	for (;;) {
+		meta = NULL;
+		spin_lock(&msm_iommu_lru_lock);
+		if (msm_iommu_over_budget(cache)) {
+			list_for_each_entry(map, &msm_iommu_lru, lru) {
+				if (map->cache == cache) {
+					meta = map->meta;
+					break;
+				}
+			}
+		}
+		spin_unlock(&msm_iommu_lru_lock);
+		if (!meta)
+			break;
+
+		/*
+		 * The map may have gone away before the meta lock was taken,
+		 * so look it up again; no map of this meta can be released
+		 * while we hold its lock.
+		 */
+		mutex_lock(&meta->lock);
+		found = false;
+		spin_lock(&msm_iommu_lru_lock);
+		list_for_each_entry(map, &msm_iommu_lru, lru) {
+			if (map->cache == cache && map->meta == meta) {
+				list_del_init(&map->lru);
+				cache->idle_bytes -= map->size;
+				cache->evictions++;
+				found = true;
+				break;
+			}
+		}
+		spin_unlock(&msm_iommu_lru_lock);
+		if (found)
+			kref_put(&map->ref, msm_iommu_map_release);
+		mutex_unlock(&meta->lock);
+	}
+	mutex_unlock(&msm_iommu_map_mutex);
+}
 
 static struct scatterlist *clone_sgl(struct scatterlist *sg, int nents)
 {
@@ -193,12 +336,23 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 	mutex_lock(&iommu_meta->lock);
 	iommu_map = msm_iommu_lookup(iommu_meta, dev);
 	if (!iommu_map) {
+		struct msm_iommu_dev_cache *cache = msm_iommu_dev_cache_get(dev);
+		struct scatterlist *s;
+		int i;
+
 		iommu_map = kmalloc(sizeof(*iommu_map), GFP_KERNEL);
 
-		if (!iommu_map) {
+		if (!iommu_map || !cache) {
+			kfree(iommu_map);
 			ret = -ENOMEM;
 			goto out_unlock;
 		}
+		INIT_LIST_HEAD(&iommu_map->lru);
+		iommu_map->cache = cache;
+		iommu_map->lazy = late_unmap;
+		iommu_map->size = 0;
+		for_each_sg(sg, s, nents, i)
+			iommu_map->size += s->length;
 
 		ret = dma_map_sg_attrs(dev, sg, nents, dir, attrs);
 		if (!ret) {
@@ -224,6 +378,9 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 		iommu_map->meta = iommu_meta;
 		msm_iommu_add(iommu_meta, iommu_map);
 
+		spin_lock(&msm_iommu_lru_lock);
+		cache->misses++;
+		spin_unlock(&msm_iommu_lru_lock);
 	} else {
 		if (nents == iommu_map->nents &&
 		    dir == iommu_map->dir &&
@@ -246,6 +403,10 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 			}
 
 			kref_get(&iommu_map->ref);
+			msm_iommu_map_set_idle(iommu_map, false);
+			spin_lock(&msm_iommu_lru_lock);
+			iommu_map->cache->hits++;
+			spin_unlock(&msm_iommu_lru_lock);
 
 			if ((attrs & DMA_ATTR_SKIP_CPU_SYNC) == 0)
 				dma_sync_sg_for_device(dev, iommu_map->sgl,
@@ -354,6 +515,7 @@ static void msm_iommu_map_release(struct kref *kref)
 	table.nents = table.orig_nents = map->nents;
 	table.sgl = map->sgl;
 	list_del(&map->lnode);
+	msm_iommu_map_set_idle(map, false);
 
 	/* Skip an additional cache maintenance on the dma unmap path */
 	if (!(map->attrs & DMA_ATTR_SKIP_CPU_SYNC))
@@ -370,6 +532,7 @@ void msm_dma_unmap_sg_attrs(struct device *dev, struct scatterlist *sgl,
 {
 	struct msm_iommu_map *iommu_map;
 	struct msm_iommu_meta *meta;
+	struct msm_iommu_dev_cache *cache = NULL;
 
 	mutex_lock(&msm_iommu_map_mutex);
 	meta = msm_iommu_meta_lookup(dma_buf->priv);
@@ -399,11 +562,19 @@ void msm_dma_unmap_sg_attrs(struct device *dev, struct scatterlist *sgl,
 		dma_sync_sg_for_cpu(dev, iommu_map->sgl, iommu_map->nents, dir);
 
 	iommu_map->attrs = attrs;
-	kref_put(&iommu_map->ref, msm_iommu_map_release);
+	if (!kref_put(&iommu_map->ref, msm_iommu_map_release) &&
+	    iommu_map->lazy && kref_read(&iommu_map->ref) == 1) {
+		/* Only the lazy reference is left, the mapping is now idle */
+		msm_iommu_map_set_idle(iommu_map, true);
+		cache = iommu_map->cache;
+	}
 	mutex_unlock(&meta->lock);
 
 	msm_iommu_meta_put(meta);
 
+	if (cache && msm_iommu_over_budget(cache))
+		msm_iommu_evict(cache);
+
 out:
 	return;
 }
@@ -477,4 +648,27 @@ void msm_dma_buf_freed(void *buffer)
 }
 EXPORT_SYMBOL(msm_dma_buf_freed);
 
+static int msm_dma_iommu_stats_show(struct seq_file *s, void *unused)
+{
+	struct msm_iommu_dev_cache *cache;
+
+	seq_printf(s, "budget per device: %u MB\n", READ_ONCE(lazy_budget_mb));
+	spin_lock(&msm_iommu_lru_lock);
+	list_for_each_entry(cache, &msm_iommu_dev_caches, node)
+		seq_printf(s, "%s: idle %zu KB hits %lu misses %lu evictions %lu\n",
+			   dev_name(cache->dev), cache->idle_bytes >> 10,
+			   cache->hits, cache->misses, cache->evictions);
+	spin_unlock(&msm_iommu_lru_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(msm_dma_iommu_stats);
+
+static int __init msm_dma_iommu_debugfs_init(void)
+{
+	debugfs_create_file("msm_dma_iommu_mapping", 0444, NULL, NULL,
+			    &msm_dma_iommu_stats_fops);
+	return 0;
+}
+late_initcall(msm_dma_iommu_debugfs_init);
+
 MODULE_LICENSE("GPL v2");
@@ -253,6 +253,11 @@ static int default_key_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		goto bad;
 	}
 
+	/* Every I/O through this target uses the key, program it up front */
+	err = blk_crypto_preload_key(dkc->dev->bdev->bd_queue, &dkc->key);
+	if (err)
+		DMWARN("Failed to preload key: %d", err);
+
 	ti->num_flush_bios = 1;
 
 	ti->may_passthrough_inline_crypto = true;
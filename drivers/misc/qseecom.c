@@ -87,6 +87,7 @@
 
 #define QSEECOM_SEND_CMD_CRYPTO_TIMEOUT	2000
 #define QSEECOM_LOAD_APP_CRYPTO_TIMEOUT	2000
+#define QSEECOM_SEND_CMD_MIN_HOLD	50	/* ms */
 #define TWO 2
 #define QSEECOM_UFS_ICE_CE_NUM 10
 #define QSEECOM_SDCC_ICE_CE_NUM 20
@@ -216,6 +217,12 @@ struct qseecom_registered_listener_list {
 	bool                       listener_in_use;
 	/* wq for thread blocked on this listener*/
 	wait_queue_head_t          listener_block_app_wq;
+	/* wq for CA threads waiting on this listener's response */
+	wait_queue_head_t          send_resp_wq;
+	ktime_t                    req_start;
+	u64                        req_cnt;
+	u64                        req_total_us;
+	u64                        req_max_us;
 	struct sglist_info         *sglistinfo_ptr;
 	struct qtee_shm            sglistinfo_shm;
 	uint32_t                   sglist_cnt;
@@ -339,6 +346,8 @@ struct qseecom_control {
 	struct task_struct *unload_app_kthread_task;
 	wait_queue_head_t unload_app_kthread_wq;
 	atomic_t unload_app_kthread_state;
+
+	struct dentry *debugfs_root;
 };
 
 struct qseecom_unload_app_pending_list {
@@ -374,6 +383,10 @@ struct qseecom_client_handle {
 	bool from_smcinvoke;
 	struct qtee_shm shm; /* kernel client's shm for req/rsp buf */
 	bool unload_pending;
+	bool sb_cached;		/* shared buffer needs cache maintenance */
+	bool sb_partial;	/* exporter can maintain a sub-range */
+	ktime_t last_cmd;	/* when the last command was sent */
+	u32 cmd_gap_ms;		/* average time between commands */
 };
 
 struct qseecom_listener_handle {
@@ -1250,6 +1263,64 @@ static int qseecom_dmabuf_cache_operations(struct dma_buf *dmabuf,
 	return ret;
 }
 
+static int __qseecom_sb_cache_range(struct dma_buf *dmabuf,
+				unsigned int offset, unsigned int len,
+				enum qseecom_cache_ops cache_op)
+{
+	enum dma_data_direction begin, end;
+	int ret;
+
+	if (!len)
+		return 0;
+
+	if (cache_op == QSEECOM_CACHE_CLEAN) {
+		begin = DMA_BIDIRECTIONAL;
+		end = DMA_BIDIRECTIONAL;
+	} else {
+		begin = DMA_TO_DEVICE;
+		end = DMA_FROM_DEVICE;
+	}
+
+	ret = dma_buf_begin_cpu_access_partial(dmabuf, begin, offset, len);
+	if (ret)
+		return ret;
+	return dma_buf_end_cpu_access_partial(dmabuf, end, offset, len);
+}
+
+/*
+ * Maintain only the request and response windows of a client's shared
+ * buffer rather than the whole buffer. Falls back to the full buffer when
+ * the addresses are physical or the heap cannot do partial maintenance.
+ */
+static int __qseecom_sb_cache_operations(struct qseecom_dev_handle *data,
+				struct qseecom_send_cmd_req *req,
+				bool is_phys_adr,
+				enum qseecom_cache_ops cache_op)
+{
+	struct qseecom_client_handle *client = &data->client;
+	int ret;
+
+	if (!client->dmabuf || !client->sb_cached)
+		return 0;
+
+	if (client->sb_partial && !is_phys_adr) {
+		ret = __qseecom_sb_cache_range(client->dmabuf,
+				(uintptr_t)req->cmd_req_buf -
+				client->user_virt_sb_base,
+				req->cmd_req_len, cache_op);
+		if (!ret)
+			ret = __qseecom_sb_cache_range(client->dmabuf,
+				(uintptr_t)req->resp_buf -
+				client->user_virt_sb_base,
+				req->resp_len, cache_op);
+		if (ret != -EOPNOTSUPP)
+			return ret;
+		client->sb_partial = false;
+	}
+
+	return qseecom_dmabuf_cache_operations(client->dmabuf, cache_op);
+}
+
 static int qseecom_destroy_bridge_callback(
 				struct dma_buf *dmabuf, void *dtor_data)
 {
@@ -1612,6 +1683,7 @@ static int qseecom_register_listener(struct qseecom_dev_handle *data,
 
 	init_waitqueue_head(&new_entry->rcv_req_wq);
 	init_waitqueue_head(&new_entry->listener_block_app_wq);
+	init_waitqueue_head(&new_entry->send_resp_wq);
 	new_entry->send_resp_flag = 0;
 	new_entry->listener_in_use = false;
 	list_add_tail(&new_entry->list, &qseecom.registered_listener_list_head);
@@ -1696,6 +1768,7 @@ static int qseecom_unregister_listener(struct qseecom_dev_handle *data)
 	/* stop CA thread waiting for listener response */
 	ptr_svc->abort = 1;
 	wake_up_interruptible_all(&qseecom.send_resp_wq);
+	wake_up_interruptible_all(&ptr_svc->send_resp_wq);
 
 	/* stop listener thread waiting for listener request */
 	data->abort = 1;
@@ -2012,6 +2085,36 @@ static void __qseecom_add_bw_scale_down_timer(uint32_t duration)
 	mutex_unlock(&qsee_bw_mutex);
 }
 
+/*
+ * Hold the crypto clock and bus vote for 1.5x the average gap between this
+ * TA's commands, so the next command of a burst (fingerprint match,
+ * keymaster operations) finds them still up and skips the ramp. A TA that
+ * calls more rarely than the default hold would ramp anyway, so its vote
+ * is dropped quickly instead.
+ */
+static uint32_t __qseecom_send_cmd_hold(struct qseecom_dev_handle *data)
+{
+	struct qseecom_client_handle *client = &data->client;
+	ktime_t now = ktime_get();
+	bool first = !client->last_cmd;
+	u32 gap;
+
+	gap = min_t(s64, ktime_ms_delta(now, client->last_cmd),
+		    QSEECOM_SEND_CMD_CRYPTO_TIMEOUT * 2);
+	client->last_cmd = now;
+	if (first)
+		return QSEECOM_SEND_CMD_CRYPTO_TIMEOUT;
+
+	client->cmd_gap_ms = client->cmd_gap_ms ?
+			     (client->cmd_gap_ms * 7 + gap) / 8 : gap;
+	if (client->cmd_gap_ms > QSEECOM_SEND_CMD_CRYPTO_TIMEOUT)
+		return QSEECOM_SEND_CMD_MIN_HOLD;
+
+	return clamp_t(u32, client->cmd_gap_ms * 3 / 2,
+		       QSEECOM_SEND_CMD_MIN_HOLD,
+		       QSEECOM_SEND_CMD_CRYPTO_TIMEOUT);
+}
+
 static void __qseecom_disable_clk_scale_down(struct qseecom_dev_handle *data)
 {
 	if (!qseecom.support_bus_scaling)
@@ -2042,6 +2145,7 @@ static int qseecom_set_client_mem_param(struct qseecom_dev_handle *data,
 {
 	int32_t ret;
 	struct qseecom_set_sb_mem_param_req req;
+	unsigned long flags = 0;
 	size_t len;
 
 	/* Copy the relevant information needed for loading the image */
@@ -2077,6 +2181,15 @@ static int qseecom_set_client_mem_param(struct qseecom_dev_handle *data,
 	data->client.sb_length = req.sb_len;
 	data->client.user_virt_sb_base = (uintptr_t)req.virt_sb_base;
 
+	/* look the cache attributes up once, not on every command */
+	data->client.sb_cached = true;
+	if (!dma_buf_get_flags(data->client.dmabuf, &flags) &&
+	    !(flags & ION_FLAG_CACHED))
+		data->client.sb_cached = false;
+	data->client.sb_partial =
+		data->client.dmabuf->ops->begin_cpu_access_partial &&
+		data->client.dmabuf->ops->end_cpu_access_partial;
+
 	return ret;
 exit:
 	if (data->client.dmabuf) {
@@ -2107,6 +2220,32 @@ static int __qseecom_reentrancy_listener_has_sent_rsp(
 	return ret || data->abort || ptr_svc->abort;
 }
 
+static void __qseecom_listener_req_start(
+			struct qseecom_registered_listener_list *ptr_svc)
+{
+	ptr_svc->req_start = ktime_get();
+}
+
+static void __qseecom_listener_req_done(
+			struct qseecom_registered_listener_list *ptr_svc)
+{
+	u64 us = ktime_us_delta(ktime_get(), ptr_svc->req_start);
+
+	ptr_svc->req_cnt++;
+	ptr_svc->req_total_us += us;
+	ptr_svc->req_max_us = max(ptr_svc->req_max_us, us);
+}
+
+/* CA threads of different listeners wait on their listener's own queue */
+static void __qseecom_wake_listener_resp_waiters(void)
+{
+	struct qseecom_registered_listener_list *ptr_svc;
+
+	list_for_each_entry(ptr_svc,
+			&qseecom.registered_listener_list_head, list)
+		wake_up_interruptible_all(&ptr_svc->send_resp_wq);
+}
+
 static void __qseecom_clean_listener_sglistinfo(
 			struct qseecom_registered_listener_list *ptr_svc)
 {
@@ -2154,6 +2293,7 @@ static int __qseecom_process_incomplete_cmd(struct qseecom_dev_handle *data,
 					status = QSEOS_RESULT_FAILURE;
 					goto err_resp;
 				}
+				__qseecom_listener_req_start(ptr_svc);
 				wake_up_interruptible(&ptr_svc->rcv_req_wq);
 				break;
 			}
@@ -2219,6 +2359,7 @@ static int __qseecom_process_incomplete_cmd(struct qseecom_dev_handle *data,
 			}
 		} while (1);
 		mutex_lock(&listener_access_lock);
+		__qseecom_listener_req_done(ptr_svc);
 		/* restore signal mask */
 		sigprocmask(SIG_SETMASK, &old_sigset, NULL);
 		if (data->abort || ptr_svc->abort) {
@@ -2493,6 +2634,7 @@ static int __qseecom_reentrancy_process_incomplete_cmd(
 					status = QSEOS_RESULT_FAILURE;
 					goto err_resp;
 				}
+				__qseecom_listener_req_start(ptr_svc);
 				wake_up_interruptible(&ptr_svc->rcv_req_wq);
 				break;
 			}
@@ -2537,11 +2679,15 @@ static int __qseecom_reentrancy_process_incomplete_cmd(
 		/* block all signals */
 		sigprocmask(SIG_SETMASK, &new_sigset, &old_sigset);
 
-		/* unlock mutex btw waking listener and sleep-wait */
+		/*
+		 * unlock mutex btw waking listener and sleep-wait; only a
+		 * response or abort for this listener wakes us, so requests to
+		 * independent listeners are serviced in parallel
+		 */
 		mutex_unlock(&listener_access_lock);
 		mutex_unlock(&app_access_lock);
 		do {
-			if (!wait_event_interruptible(qseecom.send_resp_wq,
+			if (!wait_event_interruptible(ptr_svc->send_resp_wq,
 				__qseecom_reentrancy_listener_has_sent_rsp(
 						data, ptr_svc))) {
 				break;
@@ -2550,6 +2696,7 @@ static int __qseecom_reentrancy_process_incomplete_cmd(
 		/* lock mutex again after resp sent */
 		mutex_lock(&app_access_lock);
 		mutex_lock(&listener_access_lock);
+		__qseecom_listener_req_done(ptr_svc);
 		ptr_svc->send_resp_flag = 0;
 		qseecom.send_resp_flag = 0;
 
@@ -3042,6 +3189,7 @@ static int __qseecom_cleanup_app(struct qseecom_dev_handle *data)
 	int ret = 1;	/* Set unload app */
 
 	wake_up_all(&qseecom.send_resp_wq);
+	__qseecom_wake_listener_resp_waiters();
 	if (qseecom.qsee_reentrancy_support)
 		mutex_unlock(&app_access_lock);
 	while (atomic_read(&data->ioctl_count) > 1) {
@@ -3800,13 +3948,11 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 	else
 		*(uint32_t *)cmd_buf = QSEOS_CLIENT_SEND_DATA_COMMAND_WHITELIST;
 
-	if (data->client.dmabuf) {
-		ret = qseecom_dmabuf_cache_operations(data->client.dmabuf,
+	ret = __qseecom_sb_cache_operations(data, req, is_phys_adr,
 					QSEECOM_CACHE_CLEAN);
-		if (ret) {
-			pr_err("cache operation failed %d\n", ret);
-			return ret;
-		}
+	if (ret) {
+		pr_err("cache operation failed %d\n", ret);
+		return ret;
 	}
 
 	__qseecom_reentrancy_check_if_this_app_blocked(ptr_app);
@@ -3842,14 +3988,10 @@ static int __qseecom_send_cmd(struct qseecom_dev_handle *data,
 		}
 	}
 
-	if (data->client.dmabuf) {
-		ret = qseecom_dmabuf_cache_operations(data->client.dmabuf,
+	ret = __qseecom_sb_cache_operations(data, req, is_phys_adr,
 					QSEECOM_CACHE_INVALIDATE);
-		if (ret) {
-			pr_err("cache operation failed %d\n", ret);
-			goto exit;
-		}
-	}
+	if (ret)
+		pr_err("cache operation failed %d\n", ret);
 exit:
 	return ret;
 }
@@ -5423,6 +5565,7 @@ static int qseecom_reentrancy_send_resp(struct qseecom_dev_handle *data)
 	qseecom.send_resp_flag = 1;
 	this_lstnr->send_resp_flag = 1;
 	wake_up_interruptible(&qseecom.send_resp_wq);
+	wake_up_interruptible(&this_lstnr->send_resp_wq);
 	return 0;
 }
 
@@ -5510,6 +5653,7 @@ static int __qseecom_send_modfd_resp(struct qseecom_dev_handle *data,
 	qseecom.send_resp_flag = 1;
 	this_lstnr->send_resp_flag = 1;
 	wake_up_interruptible(&qseecom.send_resp_wq);
+	wake_up_interruptible(&this_lstnr->send_resp_wq);
 	return 0;
 }
 
@@ -7690,7 +7834,7 @@ long qseecom_ioctl(struct file *file,
 		ret = qseecom_send_cmd(data, argp);
 		if (qseecom.support_bus_scaling)
 			__qseecom_add_bw_scale_down_timer(
-				QSEECOM_SEND_CMD_CRYPTO_TIMEOUT);
+				__qseecom_send_cmd_hold(data));
 		if (perf_enabled) {
 			qsee_disable_clock_vote(data, CLK_DFAB);
 			qsee_disable_clock_vote(data, CLK_SFPB);
@@ -7754,7 +7898,7 @@ long qseecom_ioctl(struct file *file,
 			ret = qseecom_send_modfd_cmd_64(data, argp);
 		if (qseecom.support_bus_scaling)
 			__qseecom_add_bw_scale_down_timer(
-				QSEECOM_SEND_CMD_CRYPTO_TIMEOUT);
+				__qseecom_send_cmd_hold(data));
 		if (perf_enabled) {
 			qsee_disable_clock_vote(data, CLK_DFAB);
 			qsee_disable_clock_vote(data, CLK_SFPB);
@@ -9601,6 +9745,25 @@ static void qseecom_deregister_shmbridge(void)
 	qtee_shmbridge_deregister(qseecom.ta_bridge_handle);
 }
 
+static int qseecom_listener_stats_show(struct seq_file *s, void *unused)
+{
+	struct qseecom_registered_listener_list *ptr_svc;
+
+	seq_puts(s, "listener requests avg_us max_us\n");
+	mutex_lock(&listener_access_lock);
+	list_for_each_entry(ptr_svc,
+			&qseecom.registered_listener_list_head, list)
+		seq_printf(s, "%8u %8llu %6llu %6llu\n",
+			ptr_svc->svc.listener_id, ptr_svc->req_cnt,
+			ptr_svc->req_cnt ? div64_u64(ptr_svc->req_total_us,
+						     ptr_svc->req_cnt) : 0,
+			ptr_svc->req_max_us);
+	mutex_unlock(&listener_access_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(qseecom_listener_stats);
+
 static int qseecom_probe(struct platform_device *pdev)
 {
 	int rc;
@@ -9641,6 +9804,10 @@ static int qseecom_probe(struct platform_device *pdev)
 	if (rc)
 		goto exit_deinit_bus;
 
+	qseecom.debugfs_root = debugfs_create_dir("qseecom", NULL);
+	debugfs_create_file("listener_stats", 0444, qseecom.debugfs_root,
+			    NULL, &qseecom_listener_stats_fops);
+
 	atomic_set(&qseecom.qseecom_state, QSEECOM_STATE_READY);
 	return 0;
 
@@ -9694,6 +9861,7 @@ static int qseecom_remove(struct platform_device *pdev)
 	if (qseecom.qseos_version > QSEEE_VERSION_00)
 		qseecom_unload_commonlib_image();
 
+	debugfs_remove_recursive(qseecom.debugfs_root);
 	qseecom_deregister_shmbridge();
 	kthread_stop(qseecom.unload_app_kthread_task);
 	kthread_stop(qseecom.unregister_lsnr_kthread_task);
@@ -0,0 +1,518 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * RMNET synthetic data path benchmark
+ *
+ * Builds aggregated MAP frames in memory and feeds them to
+ * rmnet_rx_handler(), and builds IP packets and feeds them to
+ * rmnet_egress_handler(), so the software data path can be measured
+ * without a modem. The real device must already carry rmnet links for the
+ * configured mux ids; a tun device in IFF_TUN mode works well since its
+ * transmit side simply drops when nobody reads it.
+ *
+ * /sys/kernel/debug/rmnet_bench/
+ *	real_dev	name of the rmnet real device
+ *	sizes		IP packet sizes used round robin, e.g. "64 576 1500"
+ *	mux_ids		mux ids used round robin
+ *	frames		aggregated frames (rx) per run
+ *	pkts_per_frame	packets per aggregated frame
+ *	csum_trailer	append MAPv4 downlink checksum trailers
+ *	tx_packets	packets sent per tx run
+ *	run		write "rx" or "tx" to run a pass
+ *	results		report of the last run
+ */
+
+#include <linux/debugfs.h>
+#include <linux/etherdevice.h>
+#include <linux/ip.h>
+#include <linux/kernel.h>
+#include <linux/netdevice.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
+#include <linux/udp.h>
+#include <linux/vmalloc.h>
+#include <net/checksum.h>
+#include <net/ip.h>
+#include "rmnet_config.h"
+#include "rmnet_handlers.h"
+#include "rmnet_map.h"
+#include "rmnet_private.h"
+
+#define RMNET_BENCH_MAX_MIX	8
+#define RMNET_BENCH_MAX_RUN	100000
+#define RMNET_BENCH_SRC_IP	0x0a000001
+#define RMNET_BENCH_DST_IP	0x0a000002
+#define RMNET_BENCH_PORT	9
+
+struct rmnet_bench_mix {
+	u32 val[RMNET_BENCH_MAX_MIX];
+	u32 cnt;
+};
+
+struct rmnet_bench_result {
+	const char *stage;
+	u32 calls;
+	u64 pkts;
+	u64 bytes;
+	u64 total_ns;
+	u64 p50_ns;
+	u64 p90_ns;
+	u64 p99_ns;
+	u64 max_ns;
+	int err;
+};
+
+static struct rmnet_bench {
+	struct dentry *dir;
+	struct mutex lock;
+	char real_dev[IFNAMSIZ];
+	struct rmnet_bench_mix sizes;
+	struct rmnet_bench_mix mux_ids;
+	u32 frames;
+	u32 pkts_per_frame;
+	u32 tx_packets;
+	bool csum_trailer;
+	struct rmnet_bench_result result;
+} bench = {
+	.sizes = { .val = { 1500 }, .cnt = 1 },
+	.mux_ids = { .val = { 1 }, .cnt = 1 },
+	.frames = 1000,
+	.pkts_per_frame = 16,
+	.tx_packets = 10000,
+};
+
+/* Fills in an IPv4/UDP packet of @len bytes with a valid UDP checksum */
+static void rmnet_bench_fill_ip(void *data, u32 len)
+{
+	struct iphdr *iph = data;
+	struct udphdr *uh = data + sizeof(*iph);
+	u32 ulen = len - sizeof(*iph);
+
+	memset(data, 0, len);
+	iph->version = 4;
+	iph->ihl = 5;
+	iph->ttl = 64;
+	iph->protocol = IPPROTO_UDP;
+	iph->tot_len = htons(len);
+	iph->saddr = htonl(RMNET_BENCH_SRC_IP);
+	iph->daddr = htonl(RMNET_BENCH_DST_IP);
+	iph->check = ip_fast_csum(iph, iph->ihl);
+
+	uh->source = htons(RMNET_BENCH_PORT);
+	uh->dest = htons(RMNET_BENCH_PORT);
+	uh->len = htons(ulen);
+	uh->check = csum_tcpudp_magic(iph->saddr, iph->daddr, ulen,
+				      IPPROTO_UDP, csum_partial(uh, ulen, 0));
+	if (!uh->check)
+		uh->check = CSUM_MANGLED_0;
+}
+
+static u32 rmnet_bench_frame_len(u32 first, u32 pkts)
+{
+	u32 i, len = 0;
+
+	for (i = 0; i < pkts; i++) {
+		u32 ip_len = bench.sizes.val[(first + i) % bench.sizes.cnt];
+
+		len += sizeof(struct rmnet_map_header) + ALIGN(ip_len, 4);
+		if (bench.csum_trailer)
+			len += sizeof(struct rmnet_map_dl_csum_trailer);
+	}
+
+	return len;
+}
+
+static struct sk_buff *rmnet_bench_build_frame(struct net_device *real_dev,
+					       u32 first, u32 pkts)
+{
+	struct rmnet_map_dl_csum_trailer *trailer;
+	struct rmnet_map_header *maph;
+	struct sk_buff *skb;
+	u32 i, ip_len, pad;
+	void *ip;
+
+	skb = netdev_alloc_skb(real_dev, rmnet_bench_frame_len(first, pkts));
+	if (!skb)
+		return NULL;
+
+	for (i = 0; i < pkts; i++) {
+		ip_len = bench.sizes.val[(first + i) % bench.sizes.cnt];
+		pad = ALIGN(ip_len, 4) - ip_len;
+
+		maph = skb_put(skb, sizeof(*maph));
+		memset(maph, 0, sizeof(*maph));
+		maph->mux_id = bench.mux_ids.val[(first + i) %
+						 bench.mux_ids.cnt];
+		maph->pad_len = pad;
+		maph->pkt_len = htons(ip_len + pad);
+
+		ip = skb_put(skb, ip_len + pad);
+		rmnet_bench_fill_ip(ip, ip_len);
+		memset(ip + ip_len, 0, pad);
+
+		if (!bench.csum_trailer)
+			continue;
+
+		/* Inverse of what rmnet_map_ipv4_dl_csum_trailer() checks */
+		trailer = skb_put(skb, sizeof(*trailer));
+		memset(trailer, 0, sizeof(*trailer));
+		trailer->valid = 1;
+		trailer->csum_value = htons((__force u16)
+				csum_fold(csum_partial(ip, ip_len, 0)));
+	}
+
+	skb->protocol = htons(ETH_P_MAP);
+	skb->dev = real_dev;
+
+	return skb;
+}
+
+static struct sk_buff *rmnet_bench_build_ul(struct net_device *vnd, u32 len)
+{
+	struct sk_buff *skb;
+
+	skb = alloc_skb(len + LL_RESERVED_SPACE(vnd), GFP_KERNEL);
+	if (!skb)
+		return NULL;
+
+	skb_reserve(skb, LL_RESERVED_SPACE(vnd));
+	skb_reset_network_header(skb);
+	rmnet_bench_fill_ip(skb_put(skb, len), len);
+	skb->protocol = htons(ETH_P_IP);
+	skb->dev = vnd;
+
+	return skb;
+}
+
+static int rmnet_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void rmnet_bench_finish(struct rmnet_bench_result *res, u64 *samples)
+{
+	u32 n = res->calls;
+
+	if (!n)
+		return;
+
+	sort(samples, n, sizeof(*samples), rmnet_bench_cmp, NULL);
+	res->p50_ns = samples[n / 2];
+	res->p90_ns = samples[(u64)n * 90 / 100];
+	res->p99_ns = samples[(u64)n * 99 / 100];
+	res->max_ns = samples[n - 1];
+}
+
+static int rmnet_bench_run_rx(struct net_device *real_dev, u64 *samples)
+{
+	struct rmnet_bench_result *res = &bench.result;
+	struct sk_buff *skb;
+	u32 i, first = 0;
+	u64 start;
+
+	for (i = 0; i < bench.frames; i++) {
+		skb = rmnet_bench_build_frame(real_dev, first,
+					      bench.pkts_per_frame);
+		if (!skb)
+			return -ENOMEM;
+
+		res->bytes += skb->len;
+		first += bench.pkts_per_frame;
+
+		local_bh_disable();
+		rcu_read_lock();
+		start = local_clock();
+		rmnet_rx_handler(&skb);
+		samples[i] = local_clock() - start;
+		rcu_read_unlock();
+		local_bh_enable();
+
+		res->total_ns += samples[i];
+		res->pkts += bench.pkts_per_frame;
+		res->calls++;
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int rmnet_bench_run_tx(struct net_device *real_dev, u64 *samples)
+{
+	struct rmnet_bench_result *res = &bench.result;
+	struct net_device *vnd[RMNET_BENCH_MAX_MIX];
+	struct rmnet_endpoint *ep;
+	struct rmnet_port *port;
+	struct sk_buff *skb;
+	u32 i, len;
+	u64 start;
+
+	rcu_read_lock();
+	port = rmnet_get_port_rcu(real_dev);
+	for (i = 0; i < bench.mux_ids.cnt; i++) {
+		ep = port ? rmnet_get_endpoint(port, bench.mux_ids.val[i]) :
+			    NULL;
+		vnd[i] = ep ? READ_ONCE(ep->egress_dev) : NULL;
+		if (!vnd[i])
+			break;
+		dev_hold(vnd[i]);
+	}
+	rcu_read_unlock();
+
+	if (i < bench.mux_ids.cnt) {
+		while (i--)
+			dev_put(vnd[i]);
+		return -ENODEV;
+	}
+
+	for (i = 0; i < bench.tx_packets; i++) {
+		len = bench.sizes.val[i % bench.sizes.cnt];
+		skb = rmnet_bench_build_ul(vnd[i % bench.mux_ids.cnt], len);
+		if (!skb)
+			break;
+
+		local_bh_disable();
+		rcu_read_lock();
+		start = local_clock();
+		rmnet_egress_handler(skb);
+		samples[i] = local_clock() - start;
+		rcu_read_unlock();
+		local_bh_enable();
+
+		res->total_ns += samples[i];
+		res->bytes += len;
+		res->pkts++;
+		res->calls++;
+		cond_resched();
+	}
+
+	for (i = 0; i < bench.mux_ids.cnt; i++)
+		dev_put(vnd[i]);
+
+	return res->calls == bench.tx_packets ? 0 : -ENOMEM;
+}
+
+static int rmnet_bench_run(bool rx)
+{
+	struct rmnet_bench_result *res = &bench.result;
+	struct net_device *real_dev;
+	u32 calls = rx ? bench.frames : bench.tx_packets;
+	u64 *samples;
+	int i;
+
+	if (!calls || calls > RMNET_BENCH_MAX_RUN ||
+	    (rx && !bench.pkts_per_frame))
+		return -EINVAL;
+
+	for (i = 0; i < bench.sizes.cnt; i++)
+		if (bench.sizes.val[i] < sizeof(struct iphdr) +
+		    sizeof(struct udphdr) ||
+		    bench.sizes.val[i] > RMNET_MAX_PACKET_SIZE)
+			return -EINVAL;
+
+	real_dev = dev_get_by_name(&init_net, bench.real_dev);
+	if (!real_dev)
+		return -ENODEV;
+
+	samples = vmalloc(array_size(calls, sizeof(*samples)));
+	if (!samples) {
+		dev_put(real_dev);
+		return -ENOMEM;
+	}
+
+	memset(res, 0, sizeof(*res));
+	res->stage = rx ? "rmnet_rx_handler" : "rmnet_egress_handler";
+	res->err = rx ? rmnet_bench_run_rx(real_dev, samples) :
+			rmnet_bench_run_tx(real_dev, samples);
+	rmnet_bench_finish(res, samples);
+
+	vfree(samples);
+	dev_put(real_dev);
+
+	return res->err;
+}
+
+static ssize_t rmnet_bench_run_write(struct file *file,
+				     const char __user *ubuf, size_t count,
+				     loff_t *ppos)
+{
+	char buf[8];
+	int rc;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	mutex_lock(&bench.lock);
+	if (sysfs_streq(buf, "rx"))
+		rc = rmnet_bench_run(true);
+	else if (sysfs_streq(buf, "tx"))
+		rc = rmnet_bench_run(false);
+	else
+		rc = -EINVAL;
+	mutex_unlock(&bench.lock);
+
+	return rc ? rc : count;
+}
+
+static const struct file_operations rmnet_bench_run_fops = {
+	.write = rmnet_bench_run_write,
+	.llseek = no_llseek,
+};
+
+static int rmnet_bench_results_show(struct seq_file *s, void *unused)
+{
+	struct rmnet_bench_result *res = &bench.result;
+
+	mutex_lock(&bench.lock);
+	if (!res->stage) {
+		mutex_unlock(&bench.lock);
+		return 0;
+	}
+
+	seq_printf(s, "stage: %s err: %d\n", res->stage, res->err);
+	seq_printf(s, "calls: %u packets: %llu bytes: %llu\n", res->calls,
+		   res->pkts, res->bytes);
+	if (res->total_ns) {
+		seq_printf(s, "pps: %llu mbps: %llu\n",
+			   div64_u64(res->pkts * NSEC_PER_SEC, res->total_ns),
+			   div64_u64(res->bytes * 8 * 1000, res->total_ns));
+		seq_printf(s, "ns/packet: %llu\n",
+			   div64_u64(res->total_ns, res->pkts));
+	}
+	seq_printf(s, "ns/call p50: %llu p90: %llu p99: %llu max: %llu\n",
+		   res->p50_ns, res->p90_ns, res->p99_ns, res->max_ns);
+	mutex_unlock(&bench.lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rmnet_bench_results);
+
+static ssize_t rmnet_bench_mix_write(struct file *file,
+				     const char __user *ubuf, size_t count,
+				     loff_t *ppos)
+{
+	struct rmnet_bench_mix *mix = file->private_data;
+	struct rmnet_bench_mix tmp = {0};
+	char buf[128], *cur, *tok;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	cur = strim(buf);
+	while ((tok = strsep(&cur, " ,")) != NULL) {
+		if (!*tok)
+			continue;
+		if (tmp.cnt == RMNET_BENCH_MAX_MIX ||
+		    kstrtou32(tok, 0, &tmp.val[tmp.cnt]))
+			return -EINVAL;
+		tmp.cnt++;
+	}
+
+	if (!tmp.cnt)
+		return -EINVAL;
+
+	mutex_lock(&bench.lock);
+	*mix = tmp;
+	mutex_unlock(&bench.lock);
+
+	return count;
+}
+
+static ssize_t rmnet_bench_mix_read(struct file *file, char __user *ubuf,
+				    size_t count, loff_t *ppos)
+{
+	struct rmnet_bench_mix *mix = file->private_data;
+	char buf[128];
+	int len = 0;
+	u32 i;
+
+	mutex_lock(&bench.lock);
+	for (i = 0; i < mix->cnt; i++)
+		len += scnprintf(buf + len, sizeof(buf) - len, "%u ",
+				 mix->val[i]);
+	mutex_unlock(&bench.lock);
+	len += scnprintf(buf + len, sizeof(buf) - len, "\n");
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf, len);
+}
+
+static const struct file_operations rmnet_bench_mix_fops = {
+	.open = simple_open,
+	.read = rmnet_bench_mix_read,
+	.write = rmnet_bench_mix_write,
+	.llseek = default_llseek,
+};
+
+static ssize_t rmnet_bench_dev_write(struct file *file,
+				     const char __user *ubuf, size_t count,
+				     loff_t *ppos)
+{
+	char buf[IFNAMSIZ];
+
+	if (!count || count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	mutex_lock(&bench.lock);
+	strlcpy(bench.real_dev, strim(buf), sizeof(bench.real_dev));
+	mutex_unlock(&bench.lock);
+
+	return count;
+}
+
+static ssize_t rmnet_bench_dev_read(struct file *file, char __user *ubuf,
+				    size_t count, loff_t *ppos)
+{
+	char buf[IFNAMSIZ + 1];
+	int len;
+
+	mutex_lock(&bench.lock);
+	len = scnprintf(buf, sizeof(buf), "%s\n", bench.real_dev);
+	mutex_unlock(&bench.lock);
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf, len);
+}
+
+static const struct file_operations rmnet_bench_dev_fops = {
+	.read = rmnet_bench_dev_read,
+	.write = rmnet_bench_dev_write,
+	.llseek = default_llseek,
+};
+
+void rmnet_bench_init(void)
+{
+	mutex_init(&bench.lock);
+
+	bench.dir = debugfs_create_dir("rmnet_bench", NULL);
+	debugfs_create_file("real_dev", 0600, bench.dir, NULL,
+			    &rmnet_bench_dev_fops);
+	debugfs_create_file("sizes", 0600, bench.dir, &bench.sizes,
+			    &rmnet_bench_mix_fops);
+	debugfs_create_file("mux_ids", 0600, bench.dir, &bench.mux_ids,
+			    &rmnet_bench_mix_fops);
+	debugfs_create_u32("frames", 0600, bench.dir, &bench.frames);
+	debugfs_create_u32("pkts_per_frame", 0600, bench.dir,
+			   &bench.pkts_per_frame);
+	debugfs_create_u32("tx_packets", 0600, bench.dir, &bench.tx_packets);
+	debugfs_create_bool("csum_trailer", 0600, bench.dir,
+			    &bench.csum_trailer);
+	debugfs_create_file("run", 0200, bench.dir, NULL,
+			    &rmnet_bench_run_fops);
+	debugfs_create_file("results", 0400, bench.dir, NULL,
+			    &rmnet_bench_results_fops);
+}
+
+void rmnet_bench_exit(void)
+{
+	debugfs_remove_recursive(bench.dir);
+	bench.dir = NULL;
+}
@@ -12,12 +12,16 @@
 #include "rmnet_handlers.h"
 #include "rmnet_vnd.h"
 #include "rmnet_private.h"
+#include "rmnet_map.h"
 
 /* Local Definitions and Declarations */
 
 static const struct nla_policy rmnet_policy[IFLA_RMNET_MAX + 1] = {
 	[IFLA_RMNET_MUX_ID]	= { .type = NLA_U16 },
 	[IFLA_RMNET_FLAGS]	= { .len = sizeof(struct ifla_rmnet_flags) },
+	[IFLA_RMNET_UL_AGG_PARAMS] = {
+		.len = sizeof(struct ifla_rmnet_ul_agg_params)
+	},
 };
 
 static int rmnet_is_real_dev_registered(const struct net_device *real_dev)
@@ -41,6 +45,7 @@ static int rmnet_unregister_real_device(struct net_device *real_dev)
 
 	netdev_rx_handler_unregister(real_dev);
 
+	rmnet_map_tx_aggregate_exit(port);
 	kfree(port);
 
 	netdev_dbg(real_dev, "Removed from rmnet\n");
@@ -51,7 +56,7 @@ static int rmnet_register_real_device(struct net_device *real_dev,
 				      struct netlink_ext_ack *extack)
 {
 	struct rmnet_port *port;
-	int rc, entry;
+	int rc;
 
 	ASSERT_RTNL();
 
@@ -70,15 +75,14 @@ static int rmnet_register_real_device(struct net_device *real_dev,
 		return -ENOMEM;
 
 	port->dev = real_dev;
+	rmnet_map_tx_aggregate_init(port);
+
 	rc = netdev_rx_handler_register(real_dev, rmnet_rx_handler, port);
 	if (rc) {
 		kfree(port);
 		return -EBUSY;
 	}
 
-	for (entry = 0; entry < RMNET_MAX_LOGICAL_EP; entry++)
-		INIT_HLIST_HEAD(&port->muxed_ep[entry]);
-
 	netdev_dbg(real_dev, "registered with rmnet\n");
 	return 0;
 }
@@ -112,6 +116,17 @@ static void rmnet_unregister_bridge(struct rmnet_port *port)
 	rmnet_unregister_real_device(bridge_dev);
 }
 
+static void rmnet_set_ul_agg_params(struct rmnet_port *port,
+				    struct nlattr *attr)
+{
+	struct ifla_rmnet_ul_agg_params *agg_params;
+
+	agg_params = nla_data(attr);
+	rmnet_map_update_ul_agg_config(port, agg_params->agg_size,
+				       agg_params->agg_count,
+				       agg_params->agg_time_ns);
+}
+
 static int rmnet_newlink(struct net *src_net, struct net_device *dev,
 			 struct nlattr *tb[], struct nlattr *data[],
 			 struct netlink_ext_ack *extack)
@@ -158,7 +173,7 @@ static int rmnet_newlink(struct net *src_net, struct net_device *dev,
 	port->rmnet_mode = mode;
 	port->rmnet_dev = dev;
 
-	hlist_add_head_rcu(&ep->hlnode, &port->muxed_ep[mux_id]);
+	rcu_assign_pointer(port->muxed_ep[mux_id], ep);
 
 	if (data[IFLA_RMNET_FLAGS]) {
 		struct ifla_rmnet_flags *flags;
@@ -167,6 +182,9 @@ static int rmnet_newlink(struct net *src_net, struct net_device *dev,
 		data_format = flags->flags & flags->mask;
 	}
 
+	if (data[IFLA_RMNET_UL_AGG_PARAMS])
+		rmnet_set_ul_agg_params(port, data[IFLA_RMNET_UL_AGG_PARAMS]);
+
 	netdev_dbg(dev, "data format [0x%08X]\n", data_format);
 	port->data_format = data_format;
 
@@ -204,9 +222,9 @@ static void rmnet_dellink(struct net_device *dev, struct list_head *head)
 
 	ep = rmnet_get_endpoint(real_port, mux_id);
 	if (ep) {
-		hlist_del_init_rcu(&ep->hlnode);
+		RCU_INIT_POINTER(real_port->muxed_ep[mux_id], NULL);
 		rmnet_vnd_dellink(mux_id, real_port, ep);
-		kfree(ep);
+		kfree_rcu(ep, rcu);
 	}
 
 	netdev_upper_dev_unlink(real_dev, dev);
@@ -216,23 +234,26 @@ static void rmnet_dellink(struct net_device *dev, struct list_head *head)
 
 static void rmnet_force_unassociate_device(struct net_device *real_dev)
 {
-	struct hlist_node *tmp_ep;
 	struct rmnet_endpoint *ep;
 	struct rmnet_port *port;
-	unsigned long bkt_ep;
 	LIST_HEAD(list);
+	int mux_id;
 
 	port = rmnet_get_port_rtnl(real_dev);
 
 	if (port->nr_rmnet_devs) {
 		/* real device */
 		rmnet_unregister_bridge(port);
-		hash_for_each_safe(port->muxed_ep, bkt_ep, tmp_ep, ep, hlnode) {
+		for (mux_id = 0; mux_id < RMNET_MAX_LOGICAL_EP; mux_id++) {
+			ep = rtnl_dereference(port->muxed_ep[mux_id]);
+			if (!ep)
+				continue;
+
 			unregister_netdevice_queue(ep->egress_dev, &list);
 			netdev_upper_dev_unlink(real_dev, ep->egress_dev);
 			rmnet_vnd_dellink(ep->mux_id, port, ep);
-			hlist_del_init_rcu(&ep->hlnode);
-			kfree(ep);
+			RCU_INIT_POINTER(port->muxed_ep[mux_id], NULL);
+			kfree_rcu(ep, rcu);
 		}
 		rmnet_unregister_real_device(real_dev);
 		unregister_netdevice_many(&list);
@@ -315,11 +336,9 @@ static int rmnet_changelink(struct net_device *dev, struct nlattr *tb[],
 				return -EINVAL;
 			}
 
-			hlist_del_init_rcu(&ep->hlnode);
-			hlist_add_head_rcu(&ep->hlnode,
-					   &port->muxed_ep[mux_id]);
-
 			ep->mux_id = mux_id;
+			rcu_assign_pointer(port->muxed_ep[mux_id], ep);
+			RCU_INIT_POINTER(port->muxed_ep[priv->mux_id], NULL);
 			priv->mux_id = mux_id;
 		}
 	}
@@ -331,6 +350,9 @@ static int rmnet_changelink(struct net_device *dev, struct nlattr *tb[],
 		port->data_format = flags->flags & flags->mask;
 	}
 
+	if (data[IFLA_RMNET_UL_AGG_PARAMS])
+		rmnet_set_ul_agg_params(port, data[IFLA_RMNET_UL_AGG_PARAMS]);
+
 	return 0;
 }
 
@@ -340,7 +362,9 @@ static size_t rmnet_get_size(const struct net_device *dev)
 		/* IFLA_RMNET_MUX_ID */
 		nla_total_size(2) +
 		/* IFLA_RMNET_FLAGS */
-		nla_total_size(sizeof(struct ifla_rmnet_flags));
+		nla_total_size(sizeof(struct ifla_rmnet_flags)) +
+		/* IFLA_RMNET_UL_AGG_PARAMS */
+		nla_total_size(sizeof(struct ifla_rmnet_ul_agg_params));
 }
 
 static int rmnet_fill_info(struct sk_buff *skb, const struct net_device *dev)
@@ -359,6 +383,7 @@ static int rmnet_fill_info(struct sk_buff *skb, const struct net_device *dev)
 		port = rmnet_get_port_rtnl(real_dev);
 		f.flags = port->data_format;
 	} else {
+		port = NULL;
 		f.flags = 0;
 	}
 
@@ -367,6 +392,18 @@ static int rmnet_fill_info(struct sk_buff *skb, const struct net_device *dev)
 	if (nla_put(skb, IFLA_RMNET_FLAGS, sizeof(f), &f))
 		goto nla_put_failure;
 
+	if (port) {
+		struct ifla_rmnet_ul_agg_params agg_params;
+
+		agg_params.agg_size = port->egress_agg_params.agg_size;
+		agg_params.agg_count = port->egress_agg_params.agg_count;
+		agg_params.agg_time_ns = port->egress_agg_params.agg_time_ns;
+
+		if (nla_put(skb, IFLA_RMNET_UL_AGG_PARAMS, sizeof(agg_params),
+			    &agg_params))
+			goto nla_put_failure;
+	}
+
 	return 0;
 
 nla_put_failure:
@@ -395,16 +432,13 @@ struct rmnet_port *rmnet_get_port_rcu(struct net_device *real_dev)
 		return NULL;
 }
 
+/* Lockless lookup, valid under either RCU or RTNL */
 struct rmnet_endpoint *rmnet_get_endpoint(struct rmnet_port *port, u8 mux_id)
 {
-	struct rmnet_endpoint *ep;
-
-	hlist_for_each_entry_rcu(ep, &port->muxed_ep[mux_id], hlnode) {
-		if (ep->mux_id == mux_id)
-			return ep;
-	}
+	if (mux_id >= RMNET_MAX_LOGICAL_EP)
+		return NULL;
 
-	return NULL;
+	return rcu_dereference_rtnl(port->muxed_ep[mux_id]);
 }
 
 int rmnet_add_bridge(struct net_device *rmnet_dev,
@@ -476,11 +510,14 @@ static int __init rmnet_init(void)
 		unregister_netdevice_notifier(&rmnet_dev_notifier);
 		return rc;
 	}
+
+	rmnet_bench_init();
 	return rc;
 }
 
 static void __exit rmnet_exit(void)
 {
+	rmnet_bench_exit();
 	rtnl_link_unregister(&rmnet_link_ops);
 	unregister_netdevice_notifier(&rmnet_dev_notifier);
 }
@@ -5,6 +5,7 @@
  */
 
 #include <linux/skbuff.h>
+#include <linux/hrtimer.h>
 #include <net/gro_cells.h>
 
 #ifndef _RMNET_CONFIG_H_
@@ -15,7 +16,13 @@
 struct rmnet_endpoint {
 	u8 mux_id;
 	struct net_device *egress_dev;
-	struct hlist_node hlnode;
+	struct rcu_head rcu;
+};
+
+struct rmnet_egress_agg_params {
+	u16 agg_size;
+	u16 agg_count;
+	u32 agg_time_ns;
 };
 
 /* One instance of this structure is instantiated for each real_dev associated
@@ -26,9 +33,17 @@ struct rmnet_port {
 	u32 data_format;
 	u8 nr_rmnet_devs;
 	u8 rmnet_mode;
-	struct hlist_head muxed_ep[RMNET_MAX_LOGICAL_EP];
+	struct rmnet_endpoint __rcu *muxed_ep[RMNET_MAX_LOGICAL_EP];
 	struct net_device *bridge_ep;
 	struct net_device *rmnet_dev;
+
+	/* Egress aggregation */
+	struct rmnet_egress_agg_params egress_agg_params;
+	spinlock_t agg_lock;
+	struct sk_buff *skbagg_head;
+	u16 agg_count;
+	ktime_t agg_last;
+	struct hrtimer agg_timer;
 };
 
 extern struct rtnl_link_ops rmnet_link_ops;
@@ -38,12 +53,8 @@ struct rmnet_vnd_stats {
 	u64 rx_bytes;
 	u64 tx_pkts;
 	u64 tx_bytes;
-	u32 tx_drops;
-};
-
-struct rmnet_pcpu_stats {
-	struct rmnet_vnd_stats stats;
-	struct u64_stats_sync syncp;
+	u64 tx_drops;
+	u64 rx_drops;
 };
 
 struct rmnet_priv_stats {
@@ -56,6 +67,17 @@ struct rmnet_priv_stats {
 	u64 csum_fragmented_pkt;
 	u64 csum_skipped;
 	u64 csum_sw;
+	u64 deagg_copy;
+	u64 deagg_frag;
+};
+
+/* All counters are kept per CPU so that flows spread across cores never
+ * share a cacheline. Readers fold them under the syncp seqcount.
+ */
+struct rmnet_pcpu_stats {
+	struct rmnet_vnd_stats stats;
+	struct rmnet_priv_stats priv_stats;
+	struct u64_stats_sync syncp;
 };
 
 struct rmnet_priv {
@@ -63,9 +85,20 @@ struct rmnet_priv {
 	struct net_device *real_dev;
 	struct rmnet_pcpu_stats __percpu *pcpu_stats;
 	struct gro_cells gro_cells;
-	struct rmnet_priv_stats stats;
 };
 
+#define rmnet_pcpu_stats_inc(priv, member)				\
+do {									\
+	struct rmnet_pcpu_stats *__pcpu = this_cpu_ptr((priv)->pcpu_stats); \
+									\
+	u64_stats_update_begin(&__pcpu->syncp);				\
+	__pcpu->member++;						\
+	u64_stats_update_end(&__pcpu->syncp);				\
+} while (0)
+
+#define rmnet_priv_stats_inc(priv, field) \
+	rmnet_pcpu_stats_inc(priv, priv_stats.field)
+
 struct rmnet_port *rmnet_get_port_rcu(struct net_device *real_dev);
 struct rmnet_endpoint *rmnet_get_endpoint(struct rmnet_port *port, u8 mux_id);
 int rmnet_add_bridge(struct net_device *rmnet_dev,
@@ -7,6 +7,7 @@
 #include <linux/netdevice.h>
 #include <linux/netdev_features.h>
 #include <linux/if_arp.h>
+#include <linux/list_sort.h>
 #include <net/sock.h>
 #include "rmnet_private.h"
 #include "rmnet_config.h"
@@ -37,26 +38,64 @@ static void rmnet_set_skb_proto(struct sk_buff *skb)
 /* Generic handler */
 
 static void
-rmnet_deliver_skb(struct sk_buff *skb)
+rmnet_prepare_skb(struct sk_buff *skb)
 {
-	struct rmnet_priv *priv = netdev_priv(skb->dev);
-
 	skb_reset_transport_header(skb);
 	skb_reset_network_header(skb);
 	rmnet_vnd_rx_fixup(skb, skb->dev);
 
 	skb->pkt_type = PACKET_HOST;
 	skb_set_mac_header(skb, 0);
+}
+
+static void
+rmnet_deliver_skb(struct sk_buff *skb)
+{
+	struct rmnet_priv *priv = netdev_priv(skb->dev);
+
+	rmnet_prepare_skb(skb);
 	gro_cells_receive(&priv->gro_cells, skb);
 }
 
+static int rmnet_skb_mux_cmp(void *priv, struct list_head *a,
+			     struct list_head *b)
+{
+	struct rmnet_priv *priv_a, *priv_b;
+
+	priv_a = netdev_priv(list_entry(a, struct sk_buff, list)->dev);
+	priv_b = netdev_priv(list_entry(b, struct sk_buff, list)->dev);
+
+	return priv_a->mux_id - priv_b->mux_id;
+}
+
+/* Delivers a batch of deaggregated packets. Packets are grouped by mux_id
+ * so the stack sees runs of a single device. The sort is stable, which keeps
+ * per-device ordering intact.
+ */
+static void
+rmnet_deliver_skb_list(struct list_head *head, bool mixed_mux)
+{
+	if (list_empty(head))
+		return;
+
+	if (mixed_mux)
+		list_sort(NULL, head, rmnet_skb_mux_cmp);
+
+	netif_receive_skb_list(head);
+}
+
 /* MAP handler */
 
+/* When a list is passed, data packets are queued on it instead of being
+ * handed to GRO individually.
+ */
 static void
 __rmnet_map_ingress_handler(struct sk_buff *skb,
-			    struct rmnet_port *port)
+			    struct rmnet_port *port,
+			    struct list_head *list)
 {
 	struct rmnet_endpoint *ep;
+	struct rmnet_priv *priv;
 	u16 len, pad;
 	u8 mux_id;
 
@@ -78,7 +117,18 @@ __rmnet_map_ingress_handler(struct sk_buff *skb,
 	if (!ep)
 		goto free_skb;
 
-	skb->dev = ep->egress_dev;
+	/* Cleared by dellink before the endpoint is freed after a grace period */
+	skb->dev = READ_ONCE(ep->egress_dev);
+	if (!skb->dev)
+		goto free_skb;
+	priv = netdev_priv(skb->dev);
+
+	if (port->data_format & RMNET_FLAGS_INGRESS_DEAGGREGATION) {
+		if (skb_is_nonlinear(skb))
+			rmnet_priv_stats_inc(priv, deagg_frag);
+		else
+			rmnet_priv_stats_inc(priv, deagg_copy);
+	}
 
 	/* Subtract MAP header */
 	skb_pull(skb, sizeof(struct rmnet_map_header));
@@ -89,7 +139,17 @@ __rmnet_map_ingress_handler(struct sk_buff *skb,
 			skb->ip_summed = CHECKSUM_UNNECESSARY;
 	}
 
-	skb_trim(skb, len);
+	if (pskb_trim(skb, len)) {
+		rmnet_pcpu_stats_inc(priv, stats.rx_drops);
+		goto free_skb;
+	}
+
+	if (list) {
+		rmnet_prepare_skb(skb);
+		list_add_tail(&skb->list, list);
+		return;
+	}
+
 	rmnet_deliver_skb(skb);
 	return;
 
@@ -101,7 +161,10 @@ static void
 rmnet_map_ingress_handler(struct sk_buff *skb,
 			  struct rmnet_port *port)
 {
+	struct net_device *last_dev = NULL;
+	bool mixed_mux = false;
 	struct sk_buff *skbn;
+	LIST_HEAD(list);
 
 	if (skb->dev->type == ARPHRD_ETHER) {
 		if (pskb_expand_head(skb, ETH_HLEN, 0, GFP_ATOMIC)) {
@@ -112,14 +175,33 @@ rmnet_map_ingress_handler(struct sk_buff *skb,
 		skb_push(skb, ETH_HLEN);
 	}
 
-	if (port->data_format & RMNET_FLAGS_INGRESS_DEAGGREGATION) {
+	if (!(port->data_format & RMNET_FLAGS_INGRESS_DEAGGREGATION)) {
+		__rmnet_map_ingress_handler(skb, port, NULL);
+		return;
+	}
+
+	if (!(port->data_format & RMNET_FLAGS_INGRESS_DEAGG_BATCH)) {
 		while ((skbn = rmnet_map_deaggregate(skb, port)) != NULL)
-			__rmnet_map_ingress_handler(skbn, port);
+			__rmnet_map_ingress_handler(skbn, port, NULL);
 
 		consume_skb(skb);
-	} else {
-		__rmnet_map_ingress_handler(skb, port);
+		return;
+	}
+
+	while ((skbn = rmnet_map_deaggregate(skb, port)) != NULL) {
+		__rmnet_map_ingress_handler(skbn, port, &list);
+
+		if (list_empty(&list))
+			continue;
+
+		skbn = list_last_entry(&list, struct sk_buff, list);
+		if (last_dev && skbn->dev != last_dev)
+			mixed_mux = true;
+		last_dev = skbn->dev;
 	}
+
+	consume_skb(skb);
+	rmnet_deliver_skb_list(&list, mixed_mux);
 }
 
 static int rmnet_map_egress_handler(struct sk_buff *skb,
@@ -234,10 +316,15 @@ void rmnet_egress_handler(struct sk_buff *skb)
 
 	rmnet_vnd_tx_fixup(skb, orig_dev);
 
+	if (port->data_format & RMNET_FLAGS_EGRESS_AGGREGATION) {
+		rmnet_map_tx_aggregate(skb, port);
+		return;
+	}
+
 	dev_queue_xmit(skb);
 	return;
 
 drop:
-	this_cpu_inc(priv->pcpu_stats->stats.tx_drops);
+	rmnet_pcpu_stats_inc(priv, stats.tx_drops);
 	kfree_skb(skb);
 }
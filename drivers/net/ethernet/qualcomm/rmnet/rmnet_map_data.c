@@ -15,6 +15,22 @@
 #define RMNET_MAP_DEAGGR_SPACING  64
 #define RMNET_MAP_DEAGGR_HEADROOM (RMNET_MAP_DEAGGR_SPACING / 2)
 
+/* Bytes copied into the linear area of a zero-copy deaggregated skb. Covers
+ * the MAP header plus the largest IPv4/IPv6 and TCP headers the checksum
+ * offload code needs to touch. Packets no larger than this are copied.
+ */
+#define RMNET_MAP_DEAGGR_COPYBREAK 128
+
+/* Default uplink aggregation limits */
+#define RMNET_AGG_DEFAULT_SIZE     8192
+#define RMNET_AGG_DEFAULT_COUNT    20
+#define RMNET_AGG_DEFAULT_TIME_NS  300000
+
+/* Packets arriving after this much idle time are sent without waiting for
+ * more traffic to aggregate with.
+ */
+#define RMNET_AGG_BYPASS_TIME_NS   10000000
+
 static __sum16 *rmnet_map_get_csum_field(unsigned char protocol,
 					 const void *txporthdr)
 {
@@ -51,7 +67,7 @@ rmnet_map_ipv4_dl_csum_trailer(struct sk_buff *skb,
 	ip4h = (struct iphdr *)(skb->data);
 	if ((ntohs(ip4h->frag_off) & IP_MF) ||
 	    ((ntohs(ip4h->frag_off) & IP_OFFSET) > 0)) {
-		priv->stats.csum_fragmented_pkt++;
+		rmnet_priv_stats_inc(priv, csum_fragmented_pkt);
 		return -EOPNOTSUPP;
 	}
 
@@ -60,13 +76,13 @@ rmnet_map_ipv4_dl_csum_trailer(struct sk_buff *skb,
 	csum_field = rmnet_map_get_csum_field(ip4h->protocol, txporthdr);
 
 	if (!csum_field) {
-		priv->stats.csum_err_invalid_transport++;
+		rmnet_priv_stats_inc(priv, csum_err_invalid_transport);
 		return -EPROTONOSUPPORT;
 	}
 
 	/* RFC 768 - Skip IPv4 UDP packets where sender checksum field is 0 */
 	if (*csum_field == 0 && ip4h->protocol == IPPROTO_UDP) {
-		priv->stats.csum_skipped++;
+		rmnet_priv_stats_inc(priv, csum_skipped);
 		return 0;
 	}
 
@@ -101,10 +117,10 @@ rmnet_map_ipv4_dl_csum_trailer(struct sk_buff *skb,
 	}
 
 	if (csum_value_final == ntohs((__force __be16)*csum_field)) {
-		priv->stats.csum_ok++;
+		rmnet_priv_stats_inc(priv, csum_ok);
 		return 0;
 	} else {
-		priv->stats.csum_validation_failed++;
+		rmnet_priv_stats_inc(priv, csum_validation_failed);
 		return -EINVAL;
 	}
 }
@@ -128,7 +144,7 @@ rmnet_map_ipv6_dl_csum_trailer(struct sk_buff *skb,
 	csum_field = rmnet_map_get_csum_field(ip6h->nexthdr, txporthdr);
 
 	if (!csum_field) {
-		priv->stats.csum_err_invalid_transport++;
+		rmnet_priv_stats_inc(priv, csum_err_invalid_transport);
 		return -EPROTONOSUPPORT;
 	}
 
@@ -169,10 +185,10 @@ rmnet_map_ipv6_dl_csum_trailer(struct sk_buff *skb,
 	}
 
 	if (csum_value_final == ntohs((__force __be16)*csum_field)) {
-		priv->stats.csum_ok++;
+		rmnet_priv_stats_inc(priv, csum_ok);
 		return 0;
 	} else {
-		priv->stats.csum_validation_failed++;
+		rmnet_priv_stats_inc(priv, csum_validation_failed);
 		return -EINVAL;
 	}
 }
@@ -302,8 +318,69 @@ struct rmnet_map_header *rmnet_map_add_map_header(struct sk_buff *skb,
 	return map_header;
 }
 
+/* Builds a deaggregated skb which references the payload of the aggregated
+ * frame as a page fragment instead of copying it. Only the leading headers
+ * are copied into the linear area. The aggregated skb must have a page
+ * backed head and the packet must lie entirely within the linear area.
+ */
+static struct sk_buff *rmnet_map_deaggregate_frag(struct sk_buff *skb,
+						  u32 packet_len)
+{
+	struct sk_buff *skbn;
+	struct page *page;
+	u32 offset;
+
+	skbn = alloc_skb(RMNET_MAP_DEAGGR_COPYBREAK + RMNET_MAP_DEAGGR_SPACING,
+			 GFP_ATOMIC);
+	if (!skbn)
+		return NULL;
+
+	skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
+	skb_put_data(skbn, skb->data, RMNET_MAP_DEAGGR_COPYBREAK);
+
+	page = virt_to_head_page(skb->data);
+	offset = skb->data - (unsigned char *)page_address(page) +
+		 RMNET_MAP_DEAGGR_COPYBREAK;
+
+	get_page(page);
+	skb_add_rx_frag(skbn, 0, page, offset,
+			packet_len - RMNET_MAP_DEAGGR_COPYBREAK,
+			packet_len - RMNET_MAP_DEAGGR_COPYBREAK);
+
+	return skbn;
+}
+
+/* Copies a deaggregated packet while computing the checksum of its IP
+ * portion in the same pass, so the stack can validate it as
+ * CHECKSUM_COMPLETE instead of walking the payload again.
+ */
+static void rmnet_map_copy_and_csum(struct sk_buff *skbn,
+				    const unsigned char *src, u32 packet_len)
+{
+	const struct rmnet_map_header *maph = (void *)src;
+	u32 hdr_len = sizeof(struct rmnet_map_header);
+	unsigned char *dst = skbn->data;
+	u32 ip_len;
+
+	if (maph->pad_len > ntohs(maph->pkt_len)) {
+		memcpy(dst, src, packet_len);
+		return;
+	}
+
+	ip_len = ntohs(maph->pkt_len) - maph->pad_len;
+
+	memcpy(dst, src, hdr_len);
+	skbn->csum = csum_partial_copy_nocheck(src + hdr_len, dst + hdr_len,
+					       ip_len, 0);
+	memcpy(dst + hdr_len + ip_len, src + hdr_len + ip_len,
+	       packet_len - hdr_len - ip_len);
+	skbn->ip_summed = CHECKSUM_COMPLETE;
+}
+
 /* Deaggregates a single packet
  * A whole new buffer is allocated for each portion of an aggregated frame.
+ * If zero-copy deaggregation is enabled on the port, packets larger than
+ * the copybreak instead reference the aggregated buffer as a page fragment.
  * Caller should keep calling deaggregate() on the source skb until 0 is
  * returned, indicating that there are no more packets to deaggregate. Caller
  * is responsible for freeing the original skb.
@@ -331,13 +408,32 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 	if (ntohs(maph->pkt_len) == 0)
 		return NULL;
 
+	if ((port->data_format & RMNET_FLAGS_INGRESS_DEAGG_ZERO_COPY) &&
+	    skb->head_frag && !maph->cd_bit &&
+	    packet_len > RMNET_MAP_DEAGGR_COPYBREAK &&
+	    skb_headlen(skb) >= packet_len) {
+		skbn = rmnet_map_deaggregate_frag(skb, packet_len);
+		if (!skbn)
+			return NULL;
+
+		skb_pull(skb, packet_len);
+		return skbn;
+	}
+
 	skbn = alloc_skb(packet_len + RMNET_MAP_DEAGGR_SPACING, GFP_ATOMIC);
 	if (!skbn)
 		return NULL;
 
 	skb_reserve(skbn, RMNET_MAP_DEAGGR_HEADROOM);
 	skb_put(skbn, packet_len);
-	memcpy(skbn->data, skb->data, packet_len);
+
+	/* Without the MAPv4 trailer nothing has validated the payload yet */
+	if (!(port->data_format & RMNET_FLAGS_INGRESS_MAP_CKSUMV4) &&
+	    !maph->cd_bit)
+		rmnet_map_copy_and_csum(skbn, skb->data, packet_len);
+	else
+		memcpy(skbn->data, skb->data, packet_len);
+
 	skb_pull(skb, packet_len);
 
 	return skbn;
@@ -352,17 +448,23 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 int rmnet_map_checksum_downlink_packet(struct sk_buff *skb, u16 len)
 {
 	struct rmnet_priv *priv = netdev_priv(skb->dev);
-	struct rmnet_map_dl_csum_trailer *csum_trailer;
+	struct rmnet_map_dl_csum_trailer *csum_trailer, trailer_buf;
 
 	if (unlikely(!(skb->dev->features & NETIF_F_RXCSUM))) {
-		priv->stats.csum_sw++;
+		rmnet_priv_stats_inc(priv, csum_sw);
 		return -EOPNOTSUPP;
 	}
 
-	csum_trailer = (struct rmnet_map_dl_csum_trailer *)(skb->data + len);
+	/* The trailer may live in a page fragment for zero-copy packets */
+	csum_trailer = skb_header_pointer(skb, len, sizeof(*csum_trailer),
+					  &trailer_buf);
+	if (!csum_trailer) {
+		rmnet_priv_stats_inc(priv, csum_err_bad_buffer);
+		return -EINVAL;
+	}
 
 	if (!csum_trailer->valid) {
-		priv->stats.csum_valid_unset++;
+		rmnet_priv_stats_inc(priv, csum_valid_unset);
 		return -EINVAL;
 	}
 
@@ -372,11 +474,11 @@ int rmnet_map_checksum_downlink_packet(struct sk_buff *skb, u16 len)
 #if IS_ENABLED(CONFIG_IPV6)
 		return rmnet_map_ipv6_dl_csum_trailer(skb, csum_trailer, priv);
 #else
-		priv->stats.csum_err_invalid_ip_version++;
+		rmnet_priv_stats_inc(priv, csum_err_invalid_ip_version);
 		return -EPROTONOSUPPORT;
 #endif
 	} else {
-		priv->stats.csum_err_invalid_ip_version++;
+		rmnet_priv_stats_inc(priv, csum_err_invalid_ip_version);
 		return -EPROTONOSUPPORT;
 	}
 
@@ -412,11 +514,11 @@ void rmnet_map_checksum_uplink_packet(struct sk_buff *skb,
 			rmnet_map_ipv6_ul_csum_header(iphdr, ul_header, skb);
 			return;
 #else
-			priv->stats.csum_err_invalid_ip_version++;
+			rmnet_priv_stats_inc(priv, csum_err_invalid_ip_version);
 			goto sw_csum;
 #endif
 		} else {
-			priv->stats.csum_err_invalid_ip_version++;
+			rmnet_priv_stats_inc(priv, csum_err_invalid_ip_version);
 		}
 	}
 
@@ -426,5 +528,152 @@ void rmnet_map_checksum_uplink_packet(struct sk_buff *skb,
 	ul_header->csum_enabled = 0;
 	ul_header->udp_ind = 0;
 
-	priv->stats.csum_sw++;
+	rmnet_priv_stats_inc(priv, csum_sw);
+}
+
+/* Detaches the pending aggregated frame. Called with agg_lock held */
+static struct sk_buff *rmnet_map_tx_agg_take(struct rmnet_port *port)
+{
+	struct sk_buff *skb = port->skbagg_head;
+
+	port->skbagg_head = NULL;
+	port->agg_count = 0;
+
+	return skb;
+}
+
+/* Starts a new aggregated frame with skb as its first packet. Called with
+ * agg_lock held.
+ */
+static int rmnet_map_tx_agg_start(struct rmnet_port *port,
+				  struct sk_buff *skb)
+{
+	unsigned int headroom = LL_RESERVED_SPACE(port->dev);
+	struct sk_buff *agg_skb;
+
+	agg_skb = alloc_skb(port->egress_agg_params.agg_size + headroom,
+			    GFP_ATOMIC);
+	if (!agg_skb)
+		return -ENOMEM;
+
+	skb_reserve(agg_skb, headroom);
+	if (skb_copy_bits(skb, 0, skb_put(agg_skb, skb->len), skb->len)) {
+		kfree_skb(agg_skb);
+		return -EINVAL;
+	}
+
+	agg_skb->dev = skb->dev;
+	agg_skb->protocol = htons(ETH_P_MAP);
+	agg_skb->priority = skb->priority;
+
+	port->skbagg_head = agg_skb;
+	port->agg_count = 1;
+
+	hrtimer_start(&port->agg_timer,
+		      ns_to_ktime(port->egress_agg_params.agg_time_ns),
+		      HRTIMER_MODE_REL_SOFT);
+
+	return 0;
+}
+
+static enum hrtimer_restart rmnet_map_tx_agg_timer(struct hrtimer *t)
+{
+	struct rmnet_port *port = container_of(t, struct rmnet_port,
+					       agg_timer);
+	struct sk_buff *skb;
+
+	spin_lock_bh(&port->agg_lock);
+	skb = rmnet_map_tx_agg_take(port);
+	spin_unlock_bh(&port->agg_lock);
+
+	if (skb)
+		dev_queue_xmit(skb);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Coalesces MAP packets into a single aggregated frame. The frame is sent
+ * once it reaches the configured byte or packet count, or when the
+ * aggregation timer expires. Packets which do not fit and packets arriving
+ * after an idle period are sent as is, after any pending frame so ordering
+ * is preserved.
+ */
+void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port)
+{
+	struct rmnet_egress_agg_params *params = &port->egress_agg_params;
+	struct sk_buff *flush_skb = NULL;
+	bool queued = false;
+	ktime_t now, last;
+
+	now = ktime_get();
+
+	spin_lock_bh(&port->agg_lock);
+	last = port->agg_last;
+	port->agg_last = now;
+
+	if (port->skbagg_head &&
+	    port->skbagg_head->len + skb->len > params->agg_size)
+		flush_skb = rmnet_map_tx_agg_take(port);
+
+	if (!port->skbagg_head) {
+		if (skb->len < params->agg_size &&
+		    ktime_to_ns(ktime_sub(now, last)) < RMNET_AGG_BYPASS_TIME_NS)
+			queued = !rmnet_map_tx_agg_start(port, skb);
+	} else if (!skb_copy_bits(skb, 0,
+				  skb_put(port->skbagg_head, skb->len),
+				  skb->len)) {
+		port->agg_count++;
+		queued = true;
+
+		if (port->agg_count >= params->agg_count ||
+		    port->skbagg_head->len >= params->agg_size)
+			flush_skb = rmnet_map_tx_agg_take(port);
+	} else {
+		skb_trim(port->skbagg_head, port->skbagg_head->len - skb->len);
+		flush_skb = rmnet_map_tx_agg_take(port);
+	}
+	spin_unlock_bh(&port->agg_lock);
+
+	if (flush_skb)
+		dev_queue_xmit(flush_skb);
+
+	if (queued)
+		consume_skb(skb);
+	else
+		dev_queue_xmit(skb);
+}
+
+void rmnet_map_update_ul_agg_config(struct rmnet_port *port, u16 size,
+				    u16 count, u32 time)
+{
+	spin_lock_bh(&port->agg_lock);
+	port->egress_agg_params.agg_size = max_t(u16, size,
+						 RMNET_DFLT_PACKET_SIZE);
+	port->egress_agg_params.agg_count = max_t(u16, count, 2);
+	port->egress_agg_params.agg_time_ns = time;
+	spin_unlock_bh(&port->agg_lock);
+}
+
+void rmnet_map_tx_aggregate_init(struct rmnet_port *port)
+{
+	hrtimer_init(&port->agg_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
+	port->agg_timer.function = rmnet_map_tx_agg_timer;
+	spin_lock_init(&port->agg_lock);
+
+	port->egress_agg_params.agg_size = RMNET_AGG_DEFAULT_SIZE;
+	port->egress_agg_params.agg_count = RMNET_AGG_DEFAULT_COUNT;
+	port->egress_agg_params.agg_time_ns = RMNET_AGG_DEFAULT_TIME_NS;
+}
+
+void rmnet_map_tx_aggregate_exit(struct rmnet_port *port)
+{
+	struct sk_buff *skb;
+
+	hrtimer_cancel(&port->agg_timer);
+
+	spin_lock_bh(&port->agg_lock);
+	skb = rmnet_map_tx_agg_take(port);
+	spin_unlock_bh(&port->agg_lock);
+
+	kfree_skb(skb);
 }
@@ -15,4 +15,12 @@
 /* Pass the frame directly to another device with dev_queue_xmit() */
 #define RMNET_EPMODE_BRIDGE (2)
 
+#if IS_ENABLED(CONFIG_RMNET_BENCH)
+void rmnet_bench_init(void);
+void rmnet_bench_exit(void);
+#else
+static inline void rmnet_bench_init(void) {}
+static inline void rmnet_bench_exit(void) {}
+#endif
+
 #endif /* _RMNET_PRIVATE_H_ */
@@ -52,7 +52,7 @@ static netdev_tx_t rmnet_vnd_start_xmit(struct sk_buff *skb,
 	if (priv->real_dev) {
 		rmnet_egress_handler(skb);
 	} else {
-		this_cpu_inc(priv->pcpu_stats->stats.tx_drops);
+		rmnet_pcpu_stats_inc(priv, stats.tx_drops);
 		kfree_skb(skb);
 	}
 	return NETDEV_TX_OK;
@@ -79,7 +79,7 @@ static int rmnet_vnd_init(struct net_device *dev)
 	struct rmnet_priv *priv = netdev_priv(dev);
 	int err;
 
-	priv->pcpu_stats = alloc_percpu(struct rmnet_pcpu_stats);
+	priv->pcpu_stats = netdev_alloc_pcpu_stats(struct rmnet_pcpu_stats);
 	if (!priv->pcpu_stats)
 		return -ENOMEM;
 
@@ -119,9 +119,9 @@ static void rmnet_get_stats64(struct net_device *dev,
 			total_stats.rx_bytes += pcpu_ptr->stats.rx_bytes;
 			total_stats.tx_pkts += pcpu_ptr->stats.tx_pkts;
 			total_stats.tx_bytes += pcpu_ptr->stats.tx_bytes;
+			total_stats.tx_drops += pcpu_ptr->stats.tx_drops;
+			total_stats.rx_drops += pcpu_ptr->stats.rx_drops;
 		} while (u64_stats_fetch_retry_irq(&pcpu_ptr->syncp, start));
-
-		total_stats.tx_drops += pcpu_ptr->stats.tx_drops;
 	}
 
 	s->rx_packets = total_stats.rx_pkts;
@@ -129,6 +129,7 @@ static void rmnet_get_stats64(struct net_device *dev,
 	s->tx_packets = total_stats.tx_pkts;
 	s->tx_bytes = total_stats.tx_bytes;
 	s->tx_dropped = total_stats.tx_drops;
+	s->rx_dropped = total_stats.rx_drops;
 }
 
 static const struct net_device_ops rmnet_vnd_ops = {
@@ -152,6 +153,8 @@ static const char rmnet_gstrings_stats[][ETH_GSTRING_LEN] = {
 	"Checksum skipped on ip fragment",
 	"Checksum skipped",
 	"Checksum computed in software",
+	"Deaggregated packets copied",
+	"Deaggregated packets as page frags",
 };
 
 static void rmnet_get_strings(struct net_device *dev, u32 stringset, u8 *buf)
@@ -178,12 +181,29 @@ static void rmnet_get_ethtool_stats(struct net_device *dev,
 				    struct ethtool_stats *stats, u64 *data)
 {
 	struct rmnet_priv *priv = netdev_priv(dev);
-	struct rmnet_priv_stats *st = &priv->stats;
+	struct rmnet_pcpu_stats *pcpu_ptr;
+	unsigned int cpu, start, i;
+	const u64 *st;
 
 	if (!data)
 		return;
 
-	memcpy(data, st, ARRAY_SIZE(rmnet_gstrings_stats) * sizeof(u64));
+	memset(data, 0, ARRAY_SIZE(rmnet_gstrings_stats) * sizeof(u64));
+
+	for_each_possible_cpu(cpu) {
+		u64 snap[ARRAY_SIZE(rmnet_gstrings_stats)];
+
+		pcpu_ptr = per_cpu_ptr(priv->pcpu_stats, cpu);
+		st = (const u64 *)&pcpu_ptr->priv_stats;
+
+		do {
+			start = u64_stats_fetch_begin_irq(&pcpu_ptr->syncp);
+			memcpy(snap, st, sizeof(snap));
+		} while (u64_stats_fetch_retry_irq(&pcpu_ptr->syncp, start));
+
+		for (i = 0; i < ARRAY_SIZE(rmnet_gstrings_stats); i++)
+			data[i] += snap[i];
+	}
 }
 
 static const struct ethtool_ops rmnet_ethtool_ops = {
@@ -158,6 +158,36 @@ static int cnss_stats_show_capability(struct seq_file *s,
 	return 0;
 }
 
+static int cnss_stats_show_event_timeline(struct seq_file *s,
+					  struct cnss_plat_data *plat_priv)
+{
+	struct cnss_event_timeline *tl;
+	u32 idx = plat_priv->event_timeline_idx;
+	u64 base = 0;
+	int i;
+
+	seq_puts(s, "\n<---------------- Event Timeline (us) ----------------->\n");
+	seq_printf(s, "%-24s%-12s%-12s%-12s%s\n",
+		   "event", "post", "queued", "handle", "ret");
+
+	for (i = 0; i < CNSS_EVENT_TIMELINE_LEN; i++) {
+		tl = &plat_priv->event_timeline[(idx + i) %
+						CNSS_EVENT_TIMELINE_LEN];
+		if (!tl->start_us)
+			continue;
+		if (!base)
+			base = tl->post_us;
+
+		seq_printf(s, "%-24s%-12llu%-12llu%-12llu%d\n",
+			   cnss_driver_event_to_str(tl->type),
+			   tl->post_us - base, tl->start_us - tl->post_us,
+			   tl->end_us ? tl->end_us - tl->start_us : 0,
+			   tl->ret);
+	}
+
+	return 0;
+}
+
 static int cnss_stats_show(struct seq_file *s, void *data)
 {
 	struct cnss_plat_data *plat_priv = s->private;
@@ -166,6 +196,8 @@ static int cnss_stats_show(struct seq_file *s, void *data)
 
 	cnss_stats_show_capability(s, plat_priv);
 
+	cnss_stats_show_event_timeline(s, plat_priv);
+
 	return 0;
 }
 
@@ -572,7 +604,7 @@ static int cnss_runtime_pm_debug_show(struct seq_file *s, void *data)
 {
 	struct cnss_plat_data *plat_priv = s->private;
 	struct cnss_pci_data *pci_priv;
-	int i;
+	int i, j;
 
 	if (!plat_priv)
 		return -ENODEV;
@@ -613,6 +645,24 @@ static int cnss_runtime_pm_debug_show(struct seq_file *s, void *data)
 			   pci_priv->pm_stats.runtime_put_timestamp_id[i]);
 	}
 
+	seq_puts(s, "\nResume latency (us, log2 buckets):\n");
+	for (i = 0; i < RTPM_ID_MAX; i++) {
+		seq_printf(s, "%d: max %llu\n", i,
+			   pci_priv->pm_stats.resume_lat_max_id[i]);
+		for (j = 0; j < CNSS_RPM_LAT_BUCKETS; j++) {
+			u32 cnt = pci_priv->pm_stats.resume_lat_hist_id[i][j];
+
+			if (cnt)
+				seq_printf(s, "  >=%-8lu%u\n", BIT(j), cnt);
+		}
+	}
+
+	seq_printf(s, "\nAdaptive autosuspend: %s, avg gap %u us, delay %d ms (base %d ms)\n",
+		   pci_priv->rpm_adapt.active ? "on" : "off",
+		   pci_priv->rpm_adapt.avg_gap_us,
+		   pci_priv->pci_dev->dev.power.autosuspend_delay,
+		   pci_priv->rpm_adapt.base_delay_ms);
+
 	return 0;
 }
 
@@ -677,6 +727,8 @@ static ssize_t cnss_control_params_debug_write(struct file *fp,
 		plat_priv->ctrl_params.bdf_type = val;
 	else if (strcmp(cmd, "time_sync_period") == 0)
 		plat_priv->ctrl_params.time_sync_period = val;
+	else if (strcmp(cmd, "rpm_adapt_max_delay") == 0)
+		plat_priv->ctrl_params.rpm_adapt_max_delay = val;
 	else
 		return -EINVAL;
 
@@ -756,6 +808,7 @@ static int cnss_control_params_debug_show(struct seq_file *s, void *data)
 	seq_puts(s, "qmi_timeout: Timeout for QMI message in milliseconds\n");
 	seq_puts(s, "bdf_type: Type of board data file to be downloaded\n");
 	seq_puts(s, "time_sync_period: Time period to do time sync with device in milliseconds\n");
+	seq_puts(s, "rpm_adapt_max_delay: Max traffic-aware runtime PM autosuspend delay in milliseconds, 0 to disable\n");
 
 	seq_puts(s, "\nCurrent value:\n");
 	cnss_show_quirks_state(s, cnss_priv);
@@ -766,6 +819,8 @@ static int cnss_control_params_debug_show(struct seq_file *s, void *data)
 	seq_printf(s, "bdf_type: %u\n", cnss_priv->ctrl_params.bdf_type);
 	seq_printf(s, "time_sync_period: %u\n",
 		   cnss_priv->ctrl_params.time_sync_period);
+	seq_printf(s, "rpm_adapt_max_delay: %u\n",
+		   cnss_priv->ctrl_params.rpm_adapt_max_delay);
 
 	return 0;
 }
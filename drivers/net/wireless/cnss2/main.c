@@ -69,6 +69,7 @@ struct cnss_driver_event {
 	struct completion complete;
 	int ret;
 	void *data;
+	u64 post_us;
 };
 
 static void cnss_set_plat_priv(struct platform_device *plat_dev,
@@ -619,7 +620,7 @@ static int cnss_fw_ready_hdlr(struct cnss_plat_data *plat_priv)
 	return ret;
 }
 
-static char *cnss_driver_event_to_str(enum cnss_driver_event_type type)
+char *cnss_driver_event_to_str(enum cnss_driver_event_type type)
 {
 	switch (type) {
 	case CNSS_DRIVER_EVENT_SERVER_ARRIVE:
@@ -706,6 +707,7 @@ int cnss_driver_event_post(struct cnss_plat_data *plat_priv,
 	init_completion(&event->complete);
 	event->ret = CNSS_EVENT_PENDING;
 	event->sync = !!(flags & CNSS_EVENT_SYNC);
+	event->post_us = cnss_get_host_timestamp(plat_priv);
 
 	spin_lock_irqsave(&plat_priv->event_lock, irq_flags);
 	list_add_tail(&event->list, &plat_priv->event_list);
@@ -1802,11 +1804,29 @@ static int cnss_qdss_trace_req_data_hdlr(struct cnss_plat_data *plat_priv,
 	return ret;
 }
 
+static struct cnss_event_timeline *
+cnss_event_timeline_start(struct cnss_plat_data *plat_priv,
+			  struct cnss_driver_event *event)
+{
+	struct cnss_event_timeline *tl;
+
+	tl = &plat_priv->event_timeline[plat_priv->event_timeline_idx++ %
+					CNSS_EVENT_TIMELINE_LEN];
+	tl->type = event->type;
+	tl->ret = CNSS_EVENT_PENDING;
+	tl->post_us = event->post_us;
+	tl->start_us = cnss_get_host_timestamp(plat_priv);
+	tl->end_us = 0;
+
+	return tl;
+}
+
 static void cnss_driver_event_work(struct work_struct *work)
 {
 	struct cnss_plat_data *plat_priv =
 		container_of(work, struct cnss_plat_data, event_work);
 	struct cnss_driver_event *event;
+	struct cnss_event_timeline *tl;
 	unsigned long flags;
 	int ret = 0;
 
@@ -1830,6 +1850,8 @@ static void cnss_driver_event_work(struct work_struct *work)
 			    event->sync ? "-sync" : "", event->type,
 			    plat_priv->driver_state);
 
+		tl = cnss_event_timeline_start(plat_priv, event);
+
 		switch (event->type) {
 		case CNSS_DRIVER_EVENT_SERVER_ARRIVE:
 			ret = cnss_wlfw_server_arrive(plat_priv, event->data);
@@ -1914,6 +1936,9 @@ static void cnss_driver_event_work(struct work_struct *work)
 			continue;
 		}
 
+		tl->ret = ret;
+		tl->end_us = cnss_get_host_timestamp(plat_priv);
+
 		spin_lock_irqsave(&plat_priv->event_lock, flags);
 		if (event->sync) {
 			event->ret = ret;
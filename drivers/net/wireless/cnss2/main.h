@@ -278,6 +278,17 @@ enum cnss_driver_event_type {
 	CNSS_DRIVER_EVENT_MAX,
 };
 
+#define CNSS_EVENT_TIMELINE_LEN		32
+
+/* When a driver event was posted, picked up and finished, in host us */
+struct cnss_event_timeline {
+	enum cnss_driver_event_type type;
+	int ret;
+	u64 post_us;
+	u64 start_us;
+	u64 end_us;
+};
+
 enum cnss_driver_state {
 	CNSS_QMI_WLFW_CONNECTED = 0,
 	CNSS_FW_MEM_READY,
@@ -365,6 +376,7 @@ struct cnss_control_params {
 	unsigned int qmi_timeout;
 	unsigned int bdf_type;
 	unsigned int time_sync_period;
+	unsigned int rpm_adapt_max_delay;
 };
 
 struct cnss_tcs_info {
@@ -444,6 +456,8 @@ struct cnss_plat_data {
 	spinlock_t event_lock; /* spinlock for driver work event handling */
 	struct work_struct event_work;
 	struct workqueue_struct *event_wq;
+	struct cnss_event_timeline event_timeline[CNSS_EVENT_TIMELINE_LEN];
+	u32 event_timeline_idx;
 	struct work_struct recovery_work;
 	struct qmi_handle qmi_wlfw;
 	struct qmi_handle qmi_dms;
@@ -530,6 +544,7 @@ static inline u64 cnss_get_host_timestamp(struct cnss_plat_data *plat_priv)
 struct cnss_plat_data *cnss_get_plat_priv(struct platform_device *plat_dev);
 void cnss_pm_stay_awake(struct cnss_plat_data *plat_priv);
 void cnss_pm_relax(struct cnss_plat_data *plat_priv);
+char *cnss_driver_event_to_str(enum cnss_driver_event_type type);
 int cnss_driver_event_post(struct cnss_plat_data *plat_priv,
 			   enum cnss_driver_event_type type,
 			   u32 flags, void *data);
@@ -3506,6 +3506,32 @@ static int cnss_pci_runtime_suspend(struct device *dev)
 	return ret;
 }
 
+/*
+ * Charge the time since each caller first asked for the device while it
+ * was suspended to that caller's resume latency histogram.
+ */
+static void cnss_pci_pm_runtime_resume_record(struct cnss_pci_data *pci_priv)
+{
+	struct cnss_pm_stats *stats = &pci_priv->pm_stats;
+	u64 now = cnss_get_host_timestamp(pci_priv->plat_priv);
+	u64 req, lat;
+	int id, bucket;
+
+	for (id = 0; id < RTPM_ID_MAX; id++) {
+		req = stats->resume_req_timestamp_id[id];
+		if (!req)
+			continue;
+
+		stats->resume_req_timestamp_id[id] = 0;
+		lat = now > req ? now - req : 0;
+		bucket = lat ? min_t(int, ilog2(lat),
+				     CNSS_RPM_LAT_BUCKETS - 1) : 0;
+		stats->resume_lat_hist_id[id][bucket]++;
+		if (lat > stats->resume_lat_max_id[id])
+			stats->resume_lat_max_id[id] = lat;
+	}
+}
+
 static int cnss_pci_runtime_resume(struct device *dev)
 {
 	int ret = 0;
@@ -3533,8 +3559,10 @@ static int cnss_pci_runtime_resume(struct device *dev)
 	else
 		ret = cnss_auto_resume(dev);
 
-	if (!ret)
+	if (!ret) {
 		pci_priv->drv_connected_last = 0;
+		cnss_pci_pm_runtime_resume_record(pci_priv);
+	}
 
 	cnss_pr_vdbg("Runtime resume status: %d\n", ret);
 
@@ -3570,16 +3598,107 @@ int cnss_wlan_pm_control(struct device *dev, bool vote)
 }
 EXPORT_SYMBOL(cnss_wlan_pm_control);
 
+static void cnss_pci_pm_runtime_adapt_work(struct work_struct *work)
+{
+	struct cnss_rpm_adapt *adapt =
+		container_of(work, struct cnss_rpm_adapt, work);
+	struct cnss_pci_data *pci_priv =
+		container_of(adapt, struct cnss_pci_data, rpm_adapt);
+	struct device *dev = &pci_priv->pci_dev->dev;
+	int delay_ms = READ_ONCE(adapt->target_delay_ms);
+
+	if (dev->power.autosuspend_delay == delay_ms)
+		return;
+
+	cnss_pr_vdbg("Runtime PM autosuspend delay %d -> %d ms, avg gap %u us\n",
+		     dev->power.autosuspend_delay, delay_ms,
+		     adapt->avg_gap_us);
+	pm_runtime_set_autosuspend_delay(dev, delay_ms);
+}
+
+/*
+ * Called when a runtime PM get starts a new active period. Track the gap
+ * since the previous one and pick the autosuspend delay to use for it.
+ */
+static void cnss_pci_pm_runtime_adapt(struct cnss_pci_data *pci_priv,
+				      u64 now_us)
+{
+	struct cnss_rpm_adapt *adapt = &pci_priv->rpm_adapt;
+	struct device *dev = &pci_priv->pci_dev->dev;
+	unsigned int max_ms =
+		pci_priv->plat_priv->ctrl_params.rpm_adapt_max_delay;
+	u64 gap_us = now_us - adapt->last_burst_us;
+	int delay_ms;
+	u32 gap_ms;
+
+	if (!max_ms) {
+		if (adapt->active) {
+			adapt->active = false;
+			adapt->avg_gap_us = 0;
+			WRITE_ONCE(adapt->target_delay_ms, adapt->base_delay_ms);
+			schedule_work(&adapt->work);
+		}
+		return;
+	}
+
+	if (!adapt->active) {
+		adapt->base_delay_ms = dev->power.autosuspend_delay;
+		adapt->active = true;
+		adapt->avg_gap_us = 0;
+		adapt->last_burst_us = now_us;
+		return;
+	}
+	adapt->last_burst_us = now_us;
+
+	/* A gap far beyond the window ends the pattern, start over */
+	if (gap_us > (u64)max_ms * USEC_PER_MSEC * 4) {
+		adapt->avg_gap_us = 0;
+		return;
+	}
+
+	if (!adapt->avg_gap_us)
+		adapt->avg_gap_us = gap_us;
+	else
+		adapt->avg_gap_us = (adapt->avg_gap_us * 7 + (u32)gap_us) / 8;
+
+	/* Cover the expected gap plus 25% jitter if it fits the window */
+	gap_ms = DIV_ROUND_UP(adapt->avg_gap_us, USEC_PER_MSEC);
+	gap_ms += gap_ms / 4;
+	if (gap_ms <= max_ms)
+		delay_ms = max_t(int, adapt->base_delay_ms, gap_ms);
+	else
+		delay_ms = adapt->base_delay_ms;
+
+	if (delay_ms != READ_ONCE(adapt->target_delay_ms)) {
+		WRITE_ONCE(adapt->target_delay_ms, delay_ms);
+		schedule_work(&adapt->work);
+	}
+}
+
 static void cnss_pci_pm_runtime_get_record(struct cnss_pci_data *pci_priv,
 					   enum cnss_rtpm_id id)
 {
+	struct device *dev;
+	enum rpm_status status;
+	u64 now;
+
 	if (id >= RTPM_ID_MAX)
 		return;
 
+	dev = &pci_priv->pci_dev->dev;
+	now = cnss_get_host_timestamp(pci_priv->plat_priv);
+
 	atomic_inc(&pci_priv->pm_stats.runtime_get);
 	atomic_inc(&pci_priv->pm_stats.runtime_get_id[id]);
-	pci_priv->pm_stats.runtime_get_timestamp_id[id] =
-		cnss_get_host_timestamp(pci_priv->plat_priv);
+	pci_priv->pm_stats.runtime_get_timestamp_id[id] = now;
+
+	if (atomic_read(&dev->power.usage_count) == 0)
+		cnss_pci_pm_runtime_adapt(pci_priv, now);
+
+	status = dev->power.runtime_status;
+	if ((status == RPM_SUSPENDING || status == RPM_SUSPENDED) &&
+	    !pci_priv->pm_stats.resume_req_timestamp_id[id])
+		pci_priv->pm_stats.resume_req_timestamp_id[id] = now;
 }
 
 static void cnss_pci_pm_runtime_put_record(struct cnss_pci_data *pci_priv,
@@ -6011,6 +6130,7 @@ static int cnss_pci_probe(struct pci_dev *pci_dev,
 	plat_priv->device_id = pci_dev->device;
 	plat_priv->bus_priv = pci_priv;
 	mutex_init(&pci_priv->bus_lock);
+	INIT_WORK(&pci_priv->rpm_adapt.work, cnss_pci_pm_runtime_adapt_work);
 	if (plat_priv->use_pm_domain)
 		dev->pm_domain = &cnss_pm_domain;
 
@@ -6125,6 +6245,7 @@ static void cnss_pci_remove(struct pci_dev *pci_dev)
 		cnss_bus_dev_to_plat_priv(&pci_dev->dev);
 
 	cnss_pci_unregister_driver_hdlr(pci_priv);
+	cancel_work_sync(&pci_priv->rpm_adapt.work);
 	cnss_pci_free_m3_mem(pci_priv);
 	cnss_pci_free_fw_mem(pci_priv);
 	cnss_pci_free_qdss_mem(pci_priv);
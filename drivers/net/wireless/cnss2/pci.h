@@ -74,6 +74,9 @@ struct cnss_misc_reg {
 	u32 val;
 };
 
+/* Resume latency buckets, bucket i counts [2^i, 2^(i+1)) us */
+#define CNSS_RPM_LAT_BUCKETS		16
+
 struct cnss_pm_stats {
 	atomic_t runtime_get;
 	atomic_t runtime_put;
@@ -81,6 +84,25 @@ struct cnss_pm_stats {
 	atomic_t runtime_put_id[RTPM_ID_MAX];
 	u64 runtime_get_timestamp_id[RTPM_ID_MAX];
 	u64 runtime_put_timestamp_id[RTPM_ID_MAX];
+	u64 resume_req_timestamp_id[RTPM_ID_MAX];
+	u32 resume_lat_hist_id[RTPM_ID_MAX][CNSS_RPM_LAT_BUCKETS];
+	u64 resume_lat_max_id[RTPM_ID_MAX];
+};
+
+/*
+ * Traffic-aware autosuspend. The gap between the starts of consecutive
+ * runtime PM active periods is averaged; when bursts recur faster than
+ * ctrl_params.rpm_adapt_max_delay, the autosuspend delay is stretched to
+ * cover the gap so that periodic traffic (e.g. 20ms VoIP) does not pay a
+ * link resume per packet.
+ */
+struct cnss_rpm_adapt {
+	struct work_struct work;
+	u64 last_burst_us;
+	u32 avg_gap_us;
+	int base_delay_ms;
+	int target_delay_ms;
+	bool active;
 };
 
 struct cnss_pci_data {
@@ -99,6 +121,7 @@ struct cnss_pci_data {
 	struct msm_pcie_register_event msm_pci_event;
 #endif
 	struct cnss_pm_stats pm_stats;
+	struct cnss_rpm_adapt rpm_adapt;
 	atomic_t auto_suspended;
 	atomic_t drv_connected;
 	u8 drv_connected_last;
@@ -4,7 +4,9 @@
 #define pr_fmt(fmt) "%s: " fmt, __func__
 
 #include <linux/bitops.h>
+#include <linux/debugfs.h>
 #include <linux/err.h>
+#include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -12,6 +14,7 @@
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
 #include <linux/regulator/driver.h>
 #include <linux/regulator/machine.h>
 #include <linux/regulator/of_regulator.h>
@@ -207,6 +210,13 @@ struct rpmh_vreg;
  *				request
  * @aggr_req_sleep:		Aggregated sleep set RPMh accelerator register
  *				request
+ * @coalesce_work:		Work which sends a deferred active set request
+ * @coalesce_pending:		Boolean flag indicating that an active set
+ *				request which lowers the power state has been
+ *				deferred to coalesce_work
+ * @coalesce_flush:		Boolean flag indicating that coalesce_work is
+ *				sending the deferred request
+ * @stats:			Vote and RPMh request counts for debugfs
  */
 struct rpmh_aggr_vreg {
 	struct device			*dev;
@@ -226,6 +236,16 @@ struct rpmh_aggr_vreg {
 	int				mode_count;
 	struct rpmh_regulator_request	aggr_req_active;
 	struct rpmh_regulator_request	aggr_req_sleep;
+	struct delayed_work		coalesce_work;
+	bool				coalesce_pending;
+	bool				coalesce_flush;
+	struct {
+		u64			votes;
+		u64			writes;
+		u64			acked;
+		u64			coalesced;
+		unsigned long		since;
+	} stats;
 };
 
 /**
@@ -464,6 +484,19 @@ rpmh_regulator_mode_map[RPMH_REGULATOR_HW_TYPE_MAX] = {
 	pr_debug("%s: " message, (aggr_vreg)->resource_name, ##__VA_ARGS__)
 
 #define DEBUG_PRINT_BUFFER_SIZE 256
+/*
+ * Time in microseconds for which an active set request that only lowers the
+ * power state of a resource is held back, so that a burst of consumer votes
+ * (e.g. a camera sensor power sequence) results in a single RPMh request per
+ * resource.  Requests which raise the power state are always sent right away
+ * and carry any held back changes with them.  0 disables coalescing.
+ */
+static unsigned int coalesce_us;
+module_param(coalesce_us, uint, 0644);
+MODULE_PARM_DESC(coalesce_us, "Delay in us to coalesce power-lowering votes");
+
+static struct dentry *rpmh_regulator_debugfs;
+
 static const char *const rpmh_regulator_state_names[] = {
 	[RPMH_SLEEP_STATE]		= "sleep ",
 	[RPMH_WAKE_ONLY_STATE]		= "wake  ",
@@ -703,6 +736,9 @@ rpmh_regulator_send_aggregate_requests(struct rpmh_vreg *vreg)
 
 	max_reg_index = rpmh_regulator_get_max_reg_index(aggr_vreg);
 
+	if (!aggr_vreg->coalesce_flush)
+		aggr_vreg->stats.votes++;
+
 	rpmh_regulator_aggregate_requests(aggr_vreg, &req_active, &req_sleep);
 
 	/*
@@ -748,6 +784,7 @@ rpmh_regulator_send_aggregate_requests(struct rpmh_vreg *vreg)
 		if (j > 0) {
 			rc = rpmh_write_async(aggr_vreg->dev,
 					RPMH_SLEEP_STATE, cmd, j);
+			aggr_vreg->stats.writes++;
 			if (rc) {
 				aggr_vreg_err(aggr_vreg, "sleep state rpmh_write_async() failed, rc=%d\n",
 					rc);
@@ -789,11 +826,28 @@ rpmh_regulator_send_aggregate_requests(struct rpmh_vreg *vreg)
 		}
 	}
 
+	/*
+	 * Hold back a request which only lowers the power state so that it can
+	 * be merged with the votes that follow it.
+	 */
+	if (j > 0 && coalesce_us && !sleep_set_differs && !wait_for_ack
+	    && !aggr_vreg->coalesce_flush) {
+		if (aggr_vreg->coalesce_pending) {
+			aggr_vreg->stats.coalesced++;
+		} else {
+			aggr_vreg->coalesce_pending = true;
+			schedule_delayed_work(&aggr_vreg->coalesce_work,
+					      usecs_to_jiffies(coalesce_us));
+		}
+		return 0;
+	}
+
 	/* Send the rpmh command if any register values differ. */
 	if (j > 0) {
 		if (sleep_set_differs) {
 			state = RPMH_WAKE_ONLY_STATE;
 			rc = rpmh_write_async(aggr_vreg->dev, state, cmd, j);
+			aggr_vreg->stats.writes++;
 			if (rc) {
 				aggr_vreg_err(aggr_vreg, "%s state rpmh_write_async() failed, rc=%d\n",
 					rpmh_regulator_state_names[state], rc);
@@ -811,6 +865,9 @@ rpmh_regulator_send_aggregate_requests(struct rpmh_vreg *vreg)
 		else
 			rc = rpmh_write_async(aggr_vreg->dev, state,
 						cmd, j);
+		aggr_vreg->stats.writes++;
+		if (wait_for_ack)
+			aggr_vreg->stats.acked++;
 		if (rc) {
 			aggr_vreg_err(aggr_vreg, "%s state rpmh_write() failed, rc=%d\n",
 				rpmh_regulator_state_names[state], rc);
@@ -826,6 +883,52 @@ rpmh_regulator_send_aggregate_requests(struct rpmh_vreg *vreg)
 	return 0;
 }
 
+static void rpmh_regulator_coalesce_work(struct work_struct *work)
+{
+	struct rpmh_aggr_vreg *aggr_vreg = container_of(to_delayed_work(work),
+					struct rpmh_aggr_vreg, coalesce_work);
+	int rc;
+
+	mutex_lock(&aggr_vreg->lock);
+	if (aggr_vreg->coalesce_pending) {
+		aggr_vreg->coalesce_pending = false;
+		aggr_vreg->coalesce_flush = true;
+		rc = rpmh_regulator_send_aggregate_requests(&aggr_vreg->vreg[0]);
+		aggr_vreg->coalesce_flush = false;
+		if (rc)
+			aggr_vreg_err(aggr_vreg, "deferred request failed, rc=%d\n",
+				rc);
+	}
+	mutex_unlock(&aggr_vreg->lock);
+}
+
+static int rpmh_regulator_stats_show(struct seq_file *s, void *unused)
+{
+	struct rpmh_aggr_vreg *aggr_vreg = s->private;
+	unsigned long secs;
+	u64 votes;
+	int i;
+
+	mutex_lock(&aggr_vreg->lock);
+	votes = aggr_vreg->stats.votes;
+	secs = max_t(unsigned long, 1,
+		     jiffies_to_msecs(jiffies - aggr_vreg->stats.since)
+			/ MSEC_PER_SEC);
+
+	seq_puts(s, "regulators:");
+	for (i = 0; i < aggr_vreg->vreg_count; i++)
+		seq_printf(s, " %s", aggr_vreg->vreg[i].rdesc.name);
+	seq_printf(s, "\nvotes: %llu\nvotes_per_sec: %llu\n", votes,
+		   div64_u64(votes, secs));
+	seq_printf(s, "rpmh_writes: %llu\nacked: %llu\ncoalesced: %llu\n",
+		   aggr_vreg->stats.writes, aggr_vreg->stats.acked,
+		   aggr_vreg->stats.coalesced);
+	mutex_unlock(&aggr_vreg->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rpmh_regulator_stats);
+
 /**
  * rpmh_regulator_set_reg() - set a register value within the request for an
  *		RPMh regulator and return the previous value
@@ -1869,6 +1972,9 @@ static int rpmh_regulator_probe(struct platform_device *pdev)
 
 	aggr_vreg->dev = dev;
 	mutex_init(&aggr_vreg->lock);
+	INIT_DELAYED_WORK(&aggr_vreg->coalesce_work,
+			  rpmh_regulator_coalesce_work);
+	aggr_vreg->stats.since = jiffies;
 
 	match = of_match_node(rpmh_regulator_match_table, node);
 	if (match) {
@@ -1967,6 +2073,10 @@ static int rpmh_regulator_probe(struct platform_device *pdev)
 	of_platform_populate(pdev->dev.of_node, NULL, NULL, &pdev->dev);
 	platform_set_drvdata(pdev, aggr_vreg);
 
+	debugfs_create_file(aggr_vreg->resource_name, 0400,
+			    rpmh_regulator_debugfs, aggr_vreg,
+			    &rpmh_regulator_stats_fops);
+
 	aggr_vreg_debug(aggr_vreg, "successfully probed; addr=0x%05X, type=%s\n",
 			aggr_vreg->addr,
 			aggr_vreg->regulator_type == RPMH_REGULATOR_TYPE_ARC
@@ -1989,12 +2099,15 @@ static struct platform_driver rpmh_regulator_driver = {
 
 static int rpmh_regulator_init(void)
 {
+	rpmh_regulator_debugfs = debugfs_create_dir("rpmh-regulator", NULL);
+
 	return platform_driver_register(&rpmh_regulator_driver);
 }
 
 static void rpmh_regulator_exit(void)
 {
 	platform_driver_unregister(&rpmh_regulator_driver);
+	debugfs_remove_recursive(rpmh_regulator_debugfs);
 }
 
 MODULE_DESCRIPTION("RPMh regulator driver");
@@ -4,6 +4,7 @@
  * Copyright (c) 2018-2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/hrtimer.h>
 #include <linux/idr.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
@@ -55,6 +56,24 @@ do {									     \
 #define RPM_GLINK_CID_MIN	1
 #define RPM_GLINK_CID_MAX	65536
 
+/*
+ * Intent requests are counted per power of two size. Once a size has been
+ * requested GLINK_INTENT_LEARN_THRESH times the intent serving it is made
+ * reusable, up to GLINK_INTENT_LEARN_MAX such intents per channel.
+ */
+#define GLINK_INTENT_HIST_ORDERS	17
+#define GLINK_INTENT_LEARN_THRESH	2
+#define GLINK_INTENT_LEARN_MAX		4
+
+/*
+ * rx_done commands of coalescing channels are written to the fifo without
+ * an interrupt, the remote is signalled once GLINK_RX_DONE_BATCH of them
+ * are pending or after GLINK_RX_DONE_DELAY_NS, whichever comes first. Any
+ * other command sent in between signals the remote for them as well.
+ */
+#define GLINK_RX_DONE_BATCH		4
+#define GLINK_RX_DONE_DELAY_NS		(500 * NSEC_PER_USEC)
+
 static int should_wake;
 int glink_resume_pkt;
 EXPORT_SYMBOL(glink_resume_pkt);
@@ -128,6 +147,8 @@ struct glink_core_rx_intent {
  * @intentless:	flag to indicate that there is no intent
  * @tx_avail_notify: Waitqueue for pending tx tasks
  * @sent_read_notify: flag to check cmd sent or not
+ * @kick_deferred: commands written to the tx fifo without signalling remote
+ * @kick_timer:	bounds the delay of @kick_deferred commands
  * @ilc:	ipc logging context reference
  */
 struct qcom_glink {
@@ -165,6 +186,9 @@ struct qcom_glink {
 	wait_queue_head_t tx_avail_notify;
 	bool sent_read_notify;
 
+	unsigned int kick_deferred;
+	struct hrtimer kick_timer;
+
 	void *ilc;
 	struct cpumask cpu_mask;
 };
@@ -204,6 +228,10 @@ enum {
  * @intent_req_comp: Waitqueue for @intent_req_completed
  * @lsigs:	local side signals
  * @rsigs:	remote side signals
+ * @intent_req_hist: remote intent requests seen per power of two size
+ * @learned_intents: reusable intents allocated from @intent_req_hist
+ * @coalesce_rx_done: batch rx_done of reusable intents, see
+ *		GLINK_RX_DONE_BATCH
  */
 struct glink_channel {
 	struct rpmsg_endpoint ept;
@@ -242,6 +270,11 @@ struct glink_channel {
 
 	unsigned int lsigs;
 	unsigned int rsigs;
+
+	u8 intent_req_hist[GLINK_INTENT_HIST_ORDERS];
+	unsigned int learned_intents;
+
+	bool coalesce_rx_done;
 };
 
 #define to_glink_channel(_ept) container_of(_ept, struct glink_channel, ept)
@@ -387,6 +420,14 @@ static void qcom_glink_pipe_reset(struct qcom_glink *glink)
 		glink->rx_pipe->reset(glink->rx_pipe);
 }
 
+/* signal the remote, called with tx_lock held */
+static void qcom_glink_kick(struct qcom_glink *glink)
+{
+	glink->kick_deferred = 0;
+	mbox_send_message(glink->mbox_chan, NULL);
+	mbox_client_txdone(glink->mbox_chan, 0);
+}
+
 static void qcom_glink_send_read_notify(struct qcom_glink *glink)
 {
 	struct glink_msg msg;
@@ -399,13 +440,27 @@ static void qcom_glink_send_read_notify(struct qcom_glink *glink)
 
 	qcom_glink_tx_write(glink, &msg, sizeof(msg), NULL, 0);
 
-	mbox_send_message(glink->mbox_chan, NULL);
-	mbox_client_txdone(glink->mbox_chan, 0);
+	qcom_glink_kick(glink);
 }
 
-static int qcom_glink_tx(struct qcom_glink *glink,
-			 const void *hdr, size_t hlen,
-			 const void *data, size_t dlen, bool wait)
+static enum hrtimer_restart qcom_glink_kick_timer(struct hrtimer *timer)
+{
+	struct qcom_glink *glink = container_of(timer, struct qcom_glink,
+						kick_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&glink->tx_lock, flags);
+	if (glink->kick_deferred)
+		qcom_glink_kick(glink);
+	spin_unlock_irqrestore(&glink->tx_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+static int __qcom_glink_tx(struct qcom_glink *glink,
+			   const void *hdr, size_t hlen,
+			   const void *data, size_t dlen, bool wait,
+			   bool defer_kick)
 {
 	unsigned int tlen = hlen + dlen;
 	unsigned long flags;
@@ -451,8 +506,12 @@ static int qcom_glink_tx(struct qcom_glink *glink,
 
 	qcom_glink_tx_write(glink, hdr, hlen, data, dlen);
 
-	mbox_send_message(glink->mbox_chan, NULL);
-	mbox_client_txdone(glink->mbox_chan, 0);
+	if (!defer_kick || ++glink->kick_deferred >= GLINK_RX_DONE_BATCH)
+		qcom_glink_kick(glink);
+	else if (glink->kick_deferred == 1)
+		hrtimer_start(&glink->kick_timer,
+			      ns_to_ktime(GLINK_RX_DONE_DELAY_NS),
+			      HRTIMER_MODE_REL);
 
 out:
 	spin_unlock_irqrestore(&glink->tx_lock, flags);
@@ -460,6 +519,13 @@ static int qcom_glink_tx(struct qcom_glink *glink,
 	return ret;
 }
 
+static int qcom_glink_tx(struct qcom_glink *glink,
+			 const void *hdr, size_t hlen,
+			 const void *data, size_t dlen, bool wait)
+{
+	return __qcom_glink_tx(glink, hdr, hlen, data, dlen, wait, false);
+}
+
 static int qcom_glink_send_version(struct qcom_glink *glink)
 {
 	struct glink_msg msg;
@@ -620,7 +686,12 @@ static int __qcom_glink_rx_done(struct qcom_glink *glink,
 	cmd.lcid = cid;
 	cmd.liid = iid;
 
-	ret = qcom_glink_tx(glink, &cmd, sizeof(cmd), NULL, 0, wait);
+	/*
+	 * only a reused intent is worth delaying, the remote gets it back
+	 * with the batch. A freed intent never comes back either way.
+	 */
+	ret = __qcom_glink_tx(glink, &cmd, sizeof(cmd), NULL, 0, wait,
+			      reuse && channel->coalesce_rx_done);
 	if (ret)
 		return ret;
 
@@ -890,6 +961,38 @@ static void qcom_glink_handle_rx_done(struct qcom_glink *glink,
 	spin_unlock_irqrestore(&channel->intent_lock, flags);
 }
 
+/**
+ * qcom_glink_intent_learn() - Decide if a requested intent should be kept
+ * @channel:	channel the remote requested an intent on
+ * @size:	requested size, rounded up to a power of two when kept
+ *
+ * A remote that keeps requesting intents of a similar size pays an intent
+ * request round trip for every message. Keep such an intent reusable so
+ * it is recycled on rx_done and already advertised for the next message.
+ *
+ * Return: true if the intent should be allocated reusable.
+ */
+static bool qcom_glink_intent_learn(struct glink_channel *channel,
+				    size_t *size)
+{
+	unsigned int order = order_base_2(*size);
+
+	if (order >= GLINK_INTENT_HIST_ORDERS ||
+	    channel->learned_intents >= GLINK_INTENT_LEARN_MAX)
+		return false;
+
+	if (++channel->intent_req_hist[order] < GLINK_INTENT_LEARN_THRESH)
+		return false;
+
+	channel->intent_req_hist[order] = 0;
+	channel->learned_intents++;
+	*size = 1UL << order;
+	CH_INFO(channel, "learned intent size:%zd count:%u\n", *size,
+		channel->learned_intents);
+
+	return true;
+}
+
 /**
  * qcom_glink_handle_intent_req() - Receive a request for rx_intent
  *					    from remote side
@@ -908,6 +1011,7 @@ static void qcom_glink_handle_intent_req(struct qcom_glink *glink,
 	struct glink_channel *channel;
 	struct rpmsg_endpoint *ept;
 	unsigned long flags;
+	bool reuse;
 	int iid;
 
 	spin_lock_irqsave(&glink->idr_lock, flags);
@@ -933,7 +1037,8 @@ static void qcom_glink_handle_intent_req(struct qcom_glink *glink,
 	}
 
 	ept = &channel->ept;
-	intent = qcom_glink_alloc_intent(glink, channel, size, false);
+	reuse = qcom_glink_intent_learn(channel, &size);
+	intent = qcom_glink_alloc_intent(glink, channel, size, reuse);
 	if (intent && channel->channel_ready)
 		qcom_glink_advertise_intent(glink, channel, intent);
 
@@ -1486,7 +1591,7 @@ static int qcom_glink_announce_create(struct rpmsg_device *rpdev)
 	/*Serve any pending intent request*/
 	spin_lock_irqsave(&channel->intent_lock, flags);
 	idr_for_each_entry(&channel->liids, tmp, iid) {
-		if (!tmp->reuse && !tmp->advertised) {
+		if (!tmp->advertised) {
 			intent = tmp;
 			spin_unlock_irqrestore(&channel->intent_lock, flags);
 			qcom_glink_advertise_intent(glink, channel, intent);
@@ -1495,6 +1600,9 @@ static int qcom_glink_announce_create(struct rpmsg_device *rpdev)
 	}
 	spin_unlock_irqrestore(&channel->intent_lock, flags);
 
+	channel->coalesce_rx_done = of_property_read_bool(np,
+						"qcom,coalesce-rx-done");
+
 	prop = of_find_property(np, "qcom,intents", NULL);
 	if (prop) {
 		val = prop->value;
@@ -2121,6 +2229,8 @@ struct qcom_glink *qcom_glink_native_probe(struct device *dev,
 	INIT_LIST_HEAD(&glink->rx_queue);
 	INIT_WORK(&glink->rx_work, qcom_glink_work);
 	init_waitqueue_head(&glink->tx_avail_notify);
+	hrtimer_init(&glink->kick_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	glink->kick_timer.function = qcom_glink_kick_timer;
 
 	spin_lock_init(&glink->idr_lock);
 	idr_init(&glink->lcids);
@@ -2245,6 +2355,7 @@ void qcom_glink_native_remove(struct qcom_glink *glink)
 
 	kthread_flush_worker(&glink->kworker);
 	kthread_stop(glink->task);
+	hrtimer_cancel(&glink->kick_timer);
 	qcom_glink_pipe_reset(glink);
 	mbox_free_channel(glink->mbox_chan);
 }
@@ -34,6 +34,8 @@
 #define MAX_PROP_SIZE		   32
 #define VDDP_REF_CLK_MIN_UV        1200000
 #define VDDP_REF_CLK_MAX_UV        1200000
+/* Minimum time the controller IRQ stays on a group before moving again */
+#define UFS_QCOM_STEER_HOLD_MS	   10
 
 #define UFS_QCOM_DEFAULT_DBG_PRINT_EN	\
 	(UFS_QCOM_DBG_PRINT_REGS_EN | UFS_QCOM_DBG_PRINT_TEST_BUS_EN)
@@ -2524,6 +2526,112 @@ static int ufs_qcom_update_qos_constraints(struct qos_cpu_group *qcg,
 	return 0;
 }
 
+/*
+ * Move the controller IRQ to the group that submits most of the in-flight
+ * requests, so the completion runs on the submitter's cluster instead of
+ * bouncing the request and its cache lines across clusters. The block layer
+ * then only has to hop within the cluster to reach the submitting CPU.
+ * Called with the host lock held.
+ */
+static void ufs_qcom_steer_compl(struct ufs_hba *hba,
+				 struct ufs_qcom_qos_req *r,
+				 struct qos_cpu_group *qcg)
+{
+	int grp = qcg - r->qcg;
+
+	if (!r->steer_en || r->steer_grp == grp)
+		return;
+	if (r->steer_grp >= 0 &&
+	    qcg->inflight <= r->qcg[r->steer_grp].inflight)
+		return;
+	if (r->steer_grp >= 0 &&
+	    time_before(jiffies, r->steer_ts +
+			msecs_to_jiffies(UFS_QCOM_STEER_HOLD_MS)))
+		return;
+
+	r->steer_target = grp;
+	queue_work(r->workq, &r->steer_work);
+}
+
+static void ufs_qcom_steer_work(struct work_struct *work)
+{
+	struct ufs_qcom_qos_req *r = container_of(work, struct ufs_qcom_qos_req,
+						  steer_work);
+	struct ufs_qcom_host *host = r->qcg->host;
+	struct ufs_hba *hba = host->hba;
+	struct qos_cpu_group *qcg;
+	unsigned long flags;
+	int grp, err;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	grp = r->steer_target;
+	if (!r->steer_en || grp == r->steer_grp) {
+		spin_unlock_irqrestore(hba->host->host_lock, flags);
+		return;
+	}
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	qcg = &r->qcg[grp];
+	err = irq_set_affinity_hint(hba->irq, &qcg->mask);
+	if (err) {
+		dev_dbg(hba->dev, "%s: steer to grp %d failed: %d\n",
+			__func__, grp, err);
+		return;
+	}
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	r->steer_grp = grp;
+	r->steer_ts = jiffies;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	/* The group taking the IRQ must not sit in a deep idle state */
+	err = ufs_qcom_update_qos_constraints(qcg, QOS_PERF);
+	if (err)
+		dev_err(hba->dev, "%s: update qos - failed: %d\n",
+			__func__, err);
+}
+
+static void ufs_qcom_steer_stop(struct ufs_hba *hba)
+{
+	struct ufs_qcom_host *host = ufshcd_get_variant(hba);
+	struct ufs_qcom_qos_req *r = host->ufs_qos;
+	unsigned long flags;
+
+	if (!r)
+		return;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	r->steer_en = false;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	cancel_work_sync(&r->steer_work);
+	if (r->steer_grp >= 0)
+		irq_set_affinity_hint(hba->irq, NULL);
+	r->steer_grp = -1;
+}
+
+static void ufs_qcom_compl_xfer(struct ufs_hba *hba, int tag, bool is_scsi)
+{
+	struct ufs_qcom_host *host = ufshcd_get_variant(hba);
+	struct qos_cpu_group *qcg;
+	int cpu;
+
+	if (!host->ufs_qos || !is_scsi)
+		return;
+	cpu = tag_to_cpu(hba, tag);
+	if (cpu < 0)
+		return;
+	qcg = cpu_to_group(host->ufs_qos, cpu);
+	if (!qcg)
+		return;
+
+	if (qcg->inflight)
+		qcg->inflight--;
+	qcg->completed++;
+	if (!cpumask_test_cpu(smp_processor_id(), &qcg->mask))
+		qcg->cross_compl++;
+}
+
 static void ufs_qcom_qos(struct ufs_hba *hba, int tag, bool is_scsi_cmd)
 {
 	struct ufs_qcom_host *host = ufshcd_get_variant(hba);
@@ -2539,6 +2647,10 @@ static void ufs_qcom_qos(struct ufs_hba *hba, int tag, bool is_scsi_cmd)
 	if (!qcg)
 		return;
 
+	qcg->inflight++;
+	qcg->submitted++;
+	ufs_qcom_steer_compl(hba, host->ufs_qos, qcg);
+
 	if (qcg->voted) {
 		dev_dbg(qcg->host->hba->dev, "%s: qcg: 0x%08x | Mask: 0x%08x - Already voted - return\n",
 			__func__, qcg, qcg->mask);
@@ -2594,8 +2706,12 @@ static int ufs_qcom_setup_qos(struct ufs_hba *hba)
 		INIT_WORK(&qcg->vwork, ufs_qcom_vote_work);
 	}
 	qr->workq = create_singlethread_workqueue("qc_ufs_qos_swq");
-	if (qr->workq)
+	if (qr->workq) {
+		INIT_WORK(&qr->steer_work, ufs_qcom_steer_work);
+		qr->steer_grp = -1;
+		qr->steer_en = true;
 		return 0;
+	}
 	err = -1;
 free_mem:
 	while (i--) {
@@ -3546,6 +3662,7 @@ static const struct ufs_hba_variant_ops ufs_hba_qcom_vops = {
 	.device_reset		= ufs_qcom_device_reset,
 	.config_scaling_param = ufs_qcom_config_scaling_param,
 	.setup_xfer_req         = ufs_qcom_qos,
+	.compl_xfer_req         = ufs_qcom_compl_xfer,
 #if defined(CONFIG_SCSI_UFSHCD_QTI)
 	.fixup_dev_quirks       = ufs_qcom_fixup_dev_quirks,
 #endif
@@ -3673,6 +3790,74 @@ static ssize_t dbg_state_show(struct device *dev,
 
 static DEVICE_ATTR_RO(dbg_state);
 
+static ssize_t irq_steer_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_qcom_host *host = ufshcd_get_variant(hba);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n",
+			 host->ufs_qos ? host->ufs_qos->steer_en : 0);
+}
+
+static ssize_t irq_steer_store(struct device *dev,
+			struct device_attribute *attr, const char *buf,
+			size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_qcom_host *host = ufshcd_get_variant(hba);
+	unsigned long flags;
+	bool enable;
+
+	if (!host->ufs_qos)
+		return -ENODEV;
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	if (!enable) {
+		ufs_qcom_steer_stop(hba);
+		return count;
+	}
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	host->ufs_qos->steer_en = true;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(irq_steer);
+
+static ssize_t compl_stats_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_qcom_host *host = ufshcd_get_variant(hba);
+	struct ufs_qcom_qos_req *r = host->ufs_qos;
+	struct qos_cpu_group *qcg;
+	unsigned long flags;
+	ssize_t len = 0;
+	int i;
+
+	if (!r)
+		return -ENODEV;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "steer_grp: %d\n",
+			 r->steer_grp);
+	for (i = 0, qcg = r->qcg; i < r->num_groups; i++, qcg++)
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "grp%d: mask 0x%lx inflight %u submitted %llu completed %llu cross %llu\n",
+				 i, cpumask_bits(&qcg->mask)[0], qcg->inflight,
+				 qcg->submitted, qcg->completed,
+				 qcg->cross_compl);
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return len;
+}
+
+static DEVICE_ATTR_RO(compl_stats);
+
 static struct attribute *ufs_qcom_sysfs_attrs[] = {
 	&dev_attr_err_state.attr,
 	&dev_attr_power_mode.attr,
@@ -3680,6 +3865,8 @@ static struct attribute *ufs_qcom_sysfs_attrs[] = {
 	&dev_attr_clk_status.attr,
 	&dev_attr_err_count.attr,
 	&dev_attr_dbg_state.attr,
+	&dev_attr_irq_steer.attr,
+	&dev_attr_compl_stats.attr,
 	NULL
 };
 
@@ -3752,6 +3939,7 @@ static int ufs_qcom_remove(struct platform_device *pdev)
 	int i;
 
 	pm_runtime_get_sync(&(pdev)->dev);
+	ufs_qcom_steer_stop(hba);
 	for (i = 0; i < r->num_groups; i++, qcg++)
 		remove_group_qos(qcg);
 	ufshcd_remove(hba);
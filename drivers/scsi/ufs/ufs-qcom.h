@@ -287,12 +287,23 @@ struct qos_cpu_group {
 	struct work_struct vwork;
 	struct ufs_qcom_host *host;
 	unsigned int curr_vote;
+	/* Completion steering, protected by the host lock */
+	unsigned int inflight;
+	u64 submitted;
+	u64 completed;
+	u64 cross_compl;
 };
 
 struct ufs_qcom_qos_req {
 	struct qos_cpu_group *qcg;
 	unsigned int num_groups;
 	struct workqueue_struct *workq;
+	/* Group the controller IRQ is steered to, -1 if left alone */
+	int steer_grp;
+	int steer_target;
+	bool steer_en;
+	unsigned long steer_ts;
+	struct work_struct steer_work;
 };
 
 /* Check for QOS_POWER when added to DT */
@@ -119,30 +119,6 @@ static ssize_t spm_target_link_state_show(struct device *dev,
 				ufs_pm_lvl_states[hba->spm_lvl].link_state));
 }
 
-/* Convert Auto-Hibernate Idle Timer register value to microseconds */
-static int ufshcd_ahit_to_us(u32 ahit)
-{
-	int timer = FIELD_GET(UFSHCI_AHIBERN8_TIMER_MASK, ahit);
-	int scale = FIELD_GET(UFSHCI_AHIBERN8_SCALE_MASK, ahit);
-
-	for (; scale > 0; --scale)
-		timer *= UFSHCI_AHIBERN8_SCALE_FACTOR;
-
-	return timer;
-}
-
-/* Convert microseconds to Auto-Hibernate Idle Timer register value */
-static u32 ufshcd_us_to_ahit(unsigned int timer)
-{
-	unsigned int scale;
-
-	for (scale = 0; timer > UFSHCI_AHIBERN8_TIMER_MASK; ++scale)
-		timer /= UFSHCI_AHIBERN8_SCALE_FACTOR;
-
-	return FIELD_PREP(UFSHCI_AHIBERN8_TIMER_MASK, timer) |
-	       FIELD_PREP(UFSHCI_AHIBERN8_SCALE_MASK, scale);
-}
-
 static ssize_t auto_hibern8_show(struct device *dev,
 				 struct device_attribute *attr, char *buf)
 {
@@ -182,6 +158,138 @@ static ssize_t auto_hibern8_store(struct device *dev,
 	return count;
 }
 
+static ssize_t auto_hibern8_tune_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", hba->ahit_tuner.budget_pct);
+}
+
+/*
+ * Share of the idle time, in percent, the link may stay awake before
+ * auto-hibern8 kicks in. 0 stops tuning and keeps the current timer.
+ */
+static ssize_t auto_hibern8_tune_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	unsigned int budget_pct;
+
+	if (!ufshcd_is_auto_hibern8_supported(hba))
+		return -EOPNOTSUPP;
+
+	if (kstrtouint(buf, 0, &budget_pct) || budget_pct > 100)
+		return -EINVAL;
+
+	hba->ahit_tuner.budget_pct = budget_pct;
+
+	return count;
+}
+
+static ssize_t auto_hibern8_stats_show(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_ahit_tuner *tuner = &hba->ahit_tuner;
+	ssize_t len;
+	int i;
+
+	if (!ufshcd_is_auto_hibern8_supported(hba))
+		return -EOPNOTSUPP;
+
+	len = scnprintf(buf, PAGE_SIZE,
+			"timer_us: %d\nidle_wakes: %llu\nh8_delayed: %llu\ngaps:",
+			ufshcd_ahit_to_us(hba->ahit), tuner->idle_wakes,
+			tuner->h8_delayed);
+	for (i = 0; i < UFS_AHIT_HIST_BUCKETS; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " %u",
+				 tuner->hist[i]);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	return len;
+}
+
+static ssize_t wb_idle_hint_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", hba->wb_policy.screen_off);
+}
+
+/* Written by userspace when a long idle period (screen off) starts/ends */
+static ssize_t wb_idle_hint_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	bool idle;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return -EOPNOTSUPP;
+
+	if (kstrtobool(buf, &idle))
+		return -EINVAL;
+
+	hba->wb_policy.screen_off = idle;
+
+	return count;
+}
+
+static ssize_t wb_flush_policy_show(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u %u\n",
+			 hba->wb_policy.min_idle_ms,
+			 hba->wb_policy.flush_min_pct);
+}
+
+/* Takes "<predicted idle ms> <min fill percent>" */
+static ssize_t wb_flush_policy_store(struct device *dev,
+				     struct device_attribute *attr,
+				     const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	unsigned int min_idle_ms, flush_min_pct;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return -EOPNOTSUPP;
+
+	if (sscanf(buf, "%u %u", &min_idle_ms, &flush_min_pct) != 2)
+		return -EINVAL;
+
+	if (flush_min_pct > 100)
+		return -EINVAL;
+
+	hba->wb_policy.min_idle_ms = min_idle_ms;
+	hba->wb_policy.flush_min_pct = flush_min_pct;
+
+	return count;
+}
+
+static ssize_t wb_stats_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct ufs_wb_policy *wbp = &hba->wb_policy;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return -EOPNOTSUPP;
+
+	return scnprintf(buf, PAGE_SIZE,
+			 "fill_pct: %u\nidle_ewma_ms: %u\nflushing: %d\n"
+			 "last_flush_ms: %u\nflushed_pct: %llu\n"
+			 "absorbed_pct: %llu\nhost_write_kb: %llu\n",
+			 wbp->fill_pct, wbp->idle_ewma_ms, !!wbp->flush_start,
+			 wbp->last_flush_ms, wbp->flushed_pct,
+			 wbp->absorbed_pct, wbp->host_write_bytes >> 10);
+}
+
 static DEVICE_ATTR_RW(rpm_lvl);
 static DEVICE_ATTR_RO(rpm_target_dev_state);
 static DEVICE_ATTR_RO(rpm_target_link_state);
@@ -189,6 +297,11 @@ static DEVICE_ATTR_RW(spm_lvl);
 static DEVICE_ATTR_RO(spm_target_dev_state);
 static DEVICE_ATTR_RO(spm_target_link_state);
 static DEVICE_ATTR_RW(auto_hibern8);
+static DEVICE_ATTR_RW(auto_hibern8_tune);
+static DEVICE_ATTR_RO(auto_hibern8_stats);
+static DEVICE_ATTR_RW(wb_idle_hint);
+static DEVICE_ATTR_RW(wb_flush_policy);
+static DEVICE_ATTR_RO(wb_stats);
 
 static struct attribute *ufs_sysfs_ufshcd_attrs[] = {
 	&dev_attr_rpm_lvl.attr,
@@ -198,6 +311,11 @@ static struct attribute *ufs_sysfs_ufshcd_attrs[] = {
 	&dev_attr_spm_target_dev_state.attr,
 	&dev_attr_spm_target_link_state.attr,
 	&dev_attr_auto_hibern8.attr,
+	&dev_attr_auto_hibern8_tune.attr,
+	&dev_attr_auto_hibern8_stats.attr,
+	&dev_attr_wb_idle_hint.attr,
+	&dev_attr_wb_flush_policy.attr,
+	&dev_attr_wb_stats.attr,
 	NULL
 };
 
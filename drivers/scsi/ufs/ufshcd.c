@@ -45,6 +45,7 @@
 #include <linux/blk-pm.h>
 #include <asm/unaligned.h>
 #include <linux/blkdev.h>
+#include <linux/sizes.h>
 #include "ufshcd.h"
 #include "ufs_quirks.h"
 #include "unipro.h"
@@ -109,6 +110,21 @@
 /* Polling time to wait for fDeviceInit  */
 #define FDEVICEINIT_COMPL_TIMEOUT 5000 /* millisecs */
 
+/* WriteBooster flush policy defaults */
+#define UFS_WB_MIN_IDLE_MS 2000
+#define UFS_WB_FLUSH_MIN_PCT 30
+
+/* Auto-hibern8 tuner: gaps per recompute, timer bounds, default budget */
+#define UFS_AHIT_TUNE_SAMPLES 512
+#define UFS_AHIT_TUNE_MIN_US 1000
+#define UFS_AHIT_TUNE_MAX_US 64000
+#define UFS_AHIT_TUNE_BUDGET_PCT 10
+
+/* Clock scaling predictor defaults, readahead of an app launch trips these */
+#define UFSHCD_CLK_SCALING_BOOST_QDEPTH 4
+#define UFSHCD_CLK_SCALING_BOOST_MIN_BYTES SZ_128K
+#define UFSHCD_CLK_SCALING_BOOST_SEQ_READS 2
+
 #define ufshcd_toggle_vreg(_dev, _vreg, _on)				\
 	({                                                              \
 		int _ret;                                               \
@@ -1346,6 +1362,32 @@ static void ufshcd_clk_scaling_resume_work(struct work_struct *work)
 	devfreq_resume_device(hba->devfreq);
 }
 
+static void ufshcd_clk_scaling_boost_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   clk_scaling.boost_work);
+	struct devfreq *devfreq = hba->devfreq;
+	unsigned long irq_flags;
+	bool suspended;
+
+	spin_lock_irqsave(hba->host->host_lock, irq_flags);
+	suspended = hba->clk_scaling.is_suspended;
+	if (suspended)
+		hba->clk_scaling.boost_pending = false;
+	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+
+	if (!devfreq || suspended)
+		return;
+
+	/*
+	 * Don't wait for the next polling interval, the governor picks up
+	 * the pending boost through ufshcd_devfreq_get_dev_status().
+	 */
+	mutex_lock(&devfreq->lock);
+	update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+}
+
 static int ufshcd_devfreq_target(struct device *dev,
 				unsigned long *freq, u32 flags)
 {
@@ -1415,6 +1457,37 @@ static int ufshcd_devfreq_target(struct device *dev,
 	return ret;
 }
 
+/*
+ * Busy time alone lags a burst by a full polling interval. Report the
+ * window as fully busy when the issued requests predict that the high
+ * gear is needed: a pending burst, a deep queue of large reads, or a
+ * queue deep enough that the mix no longer matters. Must be called with
+ * host lock acquired.
+ */
+static bool ufshcd_clk_scaling_predict_up(struct ufs_hba *hba)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	unsigned int nr_reqs = scaling->win_reads + scaling->win_writes;
+	unsigned int avg_qdepth;
+
+	if (!scaling->boost_qdepth)
+		return false;
+
+	if (scaling->boost_pending)
+		return true;
+
+	if (!nr_reqs)
+		return false;
+
+	avg_qdepth = div_u64(scaling->win_qdepth_sum, nr_reqs);
+	if (avg_qdepth >= 2 * scaling->boost_qdepth)
+		return true;
+
+	return avg_qdepth >= scaling->boost_qdepth &&
+	       scaling->win_read_bytes >= scaling->win_write_bytes &&
+	       div_u64(scaling->win_read_bytes, scaling->win_reads) >=
+			scaling->boost_min_bytes;
+}
 
 static int ufshcd_devfreq_get_dev_status(struct device *dev,
 		struct devfreq_dev_status *stat)
@@ -1449,9 +1522,17 @@ static int ufshcd_devfreq_get_dev_status(struct device *dev,
 
 	stat->total_time = ktime_us_delta(curr_t, scaling->window_start_t);
 	stat->busy_time = scaling->tot_busy_t;
+	if (ufshcd_clk_scaling_predict_up(hba))
+		stat->busy_time = stat->total_time;
 start_window:
 	scaling->window_start_t = curr_t;
 	scaling->tot_busy_t = 0;
+	scaling->win_reads = 0;
+	scaling->win_writes = 0;
+	scaling->win_read_bytes = 0;
+	scaling->win_write_bytes = 0;
+	scaling->win_qdepth_sum = 0;
+	scaling->boost_pending = false;
 
 	if (hba->outstanding_reqs) {
 		scaling->busy_start_t = curr_t;
@@ -1609,6 +1690,39 @@ static ssize_t ufshcd_clkscale_enable_store(struct device *dev,
 	return count;
 }
 
+static ssize_t ufshcd_clkscale_predict_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%u %u\n",
+			hba->clk_scaling.boost_qdepth,
+			hba->clk_scaling.boost_min_bytes / SZ_1K);
+}
+
+/* Takes "<qdepth> <min read KB>", a queue depth of 0 disables prediction */
+static ssize_t ufshcd_clkscale_predict_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	unsigned int qdepth, min_kb;
+	unsigned long flags;
+
+	if (sscanf(buf, "%u %u", &qdepth, &min_kb) != 2)
+		return -EINVAL;
+
+	if (qdepth > hba->nutrs || !min_kb || min_kb > SZ_4K)
+		return -EINVAL;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	hba->clk_scaling.boost_qdepth = qdepth;
+	hba->clk_scaling.boost_min_bytes = min_kb * SZ_1K;
+	hba->clk_scaling.seq_reads = 0;
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
 static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 {
 	hba->clk_scaling.enable_attr.show = ufshcd_clkscale_enable_show;
@@ -1618,6 +1732,14 @@ static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 	hba->clk_scaling.enable_attr.attr.mode = 0644;
 	if (device_create_file(hba->dev, &hba->clk_scaling.enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for clkscale_enable\n");
+
+	hba->clk_scaling.predict_attr.show = ufshcd_clkscale_predict_show;
+	hba->clk_scaling.predict_attr.store = ufshcd_clkscale_predict_store;
+	sysfs_attr_init(&hba->clk_scaling.predict_attr.attr);
+	hba->clk_scaling.predict_attr.attr.name = "clkscale_predict";
+	hba->clk_scaling.predict_attr.attr.mode = 0644;
+	if (device_create_file(hba->dev, &hba->clk_scaling.predict_attr))
+		dev_err(hba->dev, "Failed to create sysfs for clkscale_predict\n");
 }
 
 static void ufshcd_ungate_work(struct work_struct *work)
@@ -1929,6 +2051,11 @@ static void ufshcd_init_clk_scaling(struct ufs_hba *hba)
 		  ufshcd_clk_scaling_suspend_work);
 	INIT_WORK(&hba->clk_scaling.resume_work,
 		  ufshcd_clk_scaling_resume_work);
+	INIT_WORK(&hba->clk_scaling.boost_work,
+		  ufshcd_clk_scaling_boost_work);
+
+	hba->clk_scaling.boost_qdepth = UFSHCD_CLK_SCALING_BOOST_QDEPTH;
+	hba->clk_scaling.boost_min_bytes = UFSHCD_CLK_SCALING_BOOST_MIN_BYTES;
 
 	snprintf(wq_name, sizeof(wq_name), "ufs_clkscaling_%d",
 		 hba->host->host_no);
@@ -2025,6 +2152,138 @@ static void ufshcd_clk_scaling_start_busy(struct ufs_hba *hba)
 	}
 }
 
+/*
+ * Feed the workload predictor with an issued request and kick an immediate
+ * re-evaluation when a deep queue of large sequential reads builds up while
+ * the clocks are still scaled down. Must be called with host lock acquired.
+ */
+static void ufshcd_clk_scaling_account(struct ufs_hba *hba,
+				       struct ufshcd_lrb *lrbp)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	struct scsi_cmnd *cmd = lrbp->cmd;
+	struct ufs_clk_info *clki;
+	unsigned int qdepth, bytes;
+	sector_t pos;
+
+	if (!ufshcd_is_clkscaling_supported(hba) || !scaling->boost_qdepth)
+		return;
+
+	if (!cmd || !cmd->request || !scaling->window_start_t)
+		return;
+
+	bytes = blk_rq_bytes(cmd->request);
+	if (!bytes)
+		return;
+
+	qdepth = hweight_long(hba->outstanding_reqs) + 1;
+	scaling->win_qdepth_sum += qdepth;
+
+	if (cmd->sc_data_direction != DMA_FROM_DEVICE) {
+		scaling->win_writes++;
+		scaling->win_write_bytes += bytes;
+		return;
+	}
+
+	scaling->win_reads++;
+	scaling->win_read_bytes += bytes;
+
+	if (bytes < scaling->boost_min_bytes)
+		return;
+
+	pos = blk_rq_pos(cmd->request);
+	if (pos == scaling->next_read_pos)
+		scaling->seq_reads++;
+	else
+		scaling->seq_reads = 1;
+	scaling->next_read_pos = pos + (bytes >> SECTOR_SHIFT);
+
+	if (scaling->seq_reads < UFSHCD_CLK_SCALING_BOOST_SEQ_READS ||
+	    qdepth < scaling->boost_qdepth || scaling->boost_pending ||
+	    !scaling->is_allowed || list_empty(&hba->clk_list_head))
+		return;
+
+	clki = list_first_entry(&hba->clk_list_head, struct ufs_clk_info, list);
+	if (clki->curr_freq == clki->max_freq)
+		return;
+
+	scaling->boost_pending = true;
+	queue_work(scaling->workq, &scaling->boost_work);
+}
+
+static inline bool ufshcd_ahit_tune_enabled(struct ufs_hba *hba)
+{
+	return ufshcd_is_auto_hibern8_supported(hba) &&
+	       !(hba->quirks & UFSHCD_QUIRK_BROKEN_AUTO_HIBERN8) &&
+	       hba->ahit_tuner.budget_pct;
+}
+
+static void ufshcd_ahit_note_idle(struct ufs_hba *hba, u64 gap_us)
+{
+	struct ufs_ahit_tuner *tuner = &hba->ahit_tuner;
+	int bucket = 0;
+
+	if (!ufshcd_ahit_tune_enabled(hba))
+		return;
+
+	if (gap_us >= UFS_AHIT_HIST_BASE_US)
+		bucket = min_t(int, ilog2(gap_us / UFS_AHIT_HIST_BASE_US) + 1,
+			       UFS_AHIT_HIST_BUCKETS - 1);
+	tuner->hist[bucket]++;
+
+	tuner->idle_wakes++;
+	if (ufshcd_is_auto_hibern8_enabled(hba) &&
+	    gap_us > ufshcd_ahit_to_us(hba->ahit))
+		tuner->h8_delayed++;
+
+	if (++tuner->nr_samples >= UFS_AHIT_TUNE_SAMPLES) {
+		tuner->nr_samples = 0;
+		queue_work(system_unbound_wq, &tuner->work);
+	}
+}
+
+/*
+ * Learn the idle gaps between bursts for the WriteBooster flush policy and
+ * the auto-hibern8 tuner. Must be called with host lock acquired.
+ */
+static void ufshcd_note_idle_gap(struct ufs_hba *hba)
+{
+	u64 gap_us;
+
+	if (hba->outstanding_reqs || !hba->idle_start)
+		return;
+
+	gap_us = ktime_us_delta(ktime_get(), hba->idle_start);
+	hba->idle_start = 0;
+
+	if (ufshcd_is_wb_allowed(hba))
+		hba->wb_policy.idle_ewma_ms =
+			(hba->wb_policy.idle_ewma_ms * 7 +
+			 div_u64(gap_us, USEC_PER_MSEC)) / 8;
+	ufshcd_ahit_note_idle(hba, gap_us);
+}
+
+static void ufshcd_update_idle_start(struct ufs_hba *hba)
+{
+	if (hba->outstanding_reqs)
+		return;
+
+	if (ufshcd_is_wb_allowed(hba) || ufshcd_ahit_tune_enabled(hba))
+		hba->idle_start = ktime_get();
+}
+
+/* Count host writes for the WriteBooster stats */
+static void ufshcd_wb_account(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
+{
+	struct scsi_cmnd *cmd = lrbp->cmd;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return;
+
+	if (cmd && cmd->request && cmd->sc_data_direction == DMA_TO_DEVICE)
+		hba->wb_policy.host_write_bytes += blk_rq_bytes(cmd->request);
+}
+
 static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
 {
 	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
@@ -2054,6 +2313,9 @@ void ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 	ufshcd_vops_setup_xfer_req(hba, task_tag, (lrbp->cmd ? true : false));
 	ufshcd_add_command_trace(hba, task_tag, "send");
 	ufshcd_clk_scaling_start_busy(hba);
+	ufshcd_clk_scaling_account(hba, lrbp);
+	ufshcd_note_idle_gap(hba);
+	ufshcd_wb_account(hba, lrbp);
 	__set_bit(task_tag, &hba->outstanding_reqs);
 	ufshcd_writel(hba, 1 << task_tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
 	/* Make sure that doorbell is committed immediately */
@@ -4223,6 +4485,61 @@ void ufshcd_auto_hibern8_update(struct ufs_hba *hba, u32 ahit)
 }
 EXPORT_SYMBOL_GPL(ufshcd_auto_hibern8_update);
 
+/*
+ * Every idle gap longer than the timer costs a hibern8 exit on the next
+ * request, every gap shorter than it is spent with the link awake. Pick
+ * the longest timer, i.e. the fewest delayed requests, that keeps the link
+ * awake for at most budget_pct of the observed idle time.
+ */
+static void ufshcd_ahit_tune_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   ahit_tuner.work);
+	struct ufs_ahit_tuner *tuner = &hba->ahit_tuner;
+	u32 hist[UFS_AHIT_HIST_BUCKETS];
+	u64 mid[UFS_AHIT_HIST_BUCKETS];
+	u64 idle_us = 0, awake_us, timer_us = UFS_AHIT_TUNE_MIN_US;
+	unsigned long flags;
+	int i, k;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	if (!hba->ahit || !ufshcd_ahit_tune_enabled(hba)) {
+		spin_unlock_irqrestore(hba->host->host_lock, flags);
+		return;
+	}
+	for (i = 0; i < UFS_AHIT_HIST_BUCKETS; i++) {
+		hist[i] = tuner->hist[i];
+		/* Age the history so the timer follows workload changes */
+		tuner->hist[i] >>= 1;
+	}
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	mid[0] = UFS_AHIT_HIST_BASE_US / 2;
+	for (i = 1; i < UFS_AHIT_HIST_BUCKETS; i++)
+		mid[i] = (UFS_AHIT_HIST_BASE_US << (i - 1)) * 3 / 2;
+
+	for (i = 0; i < UFS_AHIT_HIST_BUCKETS; i++)
+		idle_us += hist[i] * mid[i];
+	if (!idle_us)
+		return;
+
+	for (k = UFS_AHIT_HIST_BUCKETS - 1; k >= 0; k--) {
+		u64 t = (u64)UFS_AHIT_HIST_BASE_US << k;
+
+		awake_us = 0;
+		for (i = 0; i < UFS_AHIT_HIST_BUCKETS; i++)
+			awake_us += hist[i] * min(mid[i], t);
+		if (awake_us * 100 <= idle_us * tuner->budget_pct) {
+			timer_us = t;
+			break;
+		}
+	}
+
+	timer_us = clamp_t(u64, timer_us, UFS_AHIT_TUNE_MIN_US,
+			   UFS_AHIT_TUNE_MAX_US);
+	ufshcd_auto_hibern8_update(hba, ufshcd_us_to_ahit(timer_us));
+}
+
 void ufshcd_auto_hibern8_enable(struct ufs_hba *hba)
 {
 	unsigned long flags;
@@ -5217,6 +5534,7 @@ static void __ufshcd_transfer_req_compl(struct ufs_hba *hba,
 	hba->outstanding_reqs ^= completed_reqs;
 
 	ufshcd_clk_scaling_update_busy(hba);
+	ufshcd_update_idle_start(hba);
 
 	/* we might have free'd some tags above */
 	wake_up(&hba->dev_cmd.tag_wq);
@@ -5526,6 +5844,16 @@ static void ufshcd_bkops_exception_event_handler(struct ufs_hba *hba)
 				__func__, err);
 }
 
+/* Let the I/O schedulers of all LUs know how writes are absorbed */
+static void ufshcd_wb_notify_queues(struct ufs_hba *hba)
+{
+	struct scsi_device *sdev;
+
+	shost_for_each_device(sdev, hba->host)
+		blk_queue_write_buffer(sdev->request_queue, hba->wb_enabled,
+				       hba->wb_policy.fill_pct);
+}
+
 int ufshcd_wb_ctrl(struct ufs_hba *hba, bool enable)
 {
 	int ret;
@@ -5552,6 +5880,7 @@ int ufshcd_wb_ctrl(struct ufs_hba *hba, bool enable)
 	}
 
 	hba->wb_enabled = enable;
+	ufshcd_wb_notify_queues(hba);
 	dev_dbg(hba->dev, "%s write booster %s %d\n",
 			__func__, enable ? "enable" : "disable", ret);
 
@@ -5661,6 +5990,53 @@ static bool ufshcd_wb_presrv_usrspc_keep_vcc_on(struct ufs_hba *hba,
 	return false;
 }
 
+/*
+ * The device drains the buffer only while VCC stays on, so a burst that
+ * follows a short idle window hits a full buffer. When the I/O history or
+ * userspace predict a long idle window, keep VCC on at a much lower fill
+ * level so the buffer is empty by the time the next burst arrives.
+ */
+static bool ufshcd_wb_idle_flush(struct ufs_hba *hba, u32 avail_buf)
+{
+	struct ufs_wb_policy *wbp = &hba->wb_policy;
+	u32 fill_pct = 100 - min_t(u32, avail_buf, 10) * 10;
+	bool idle_predicted;
+
+	if (fill_pct > wbp->fill_pct)
+		wbp->absorbed_pct += fill_pct - wbp->fill_pct;
+
+	if (wbp->flush_start && fill_pct < wbp->flush_start_pct) {
+		wbp->flushed_pct += wbp->flush_start_pct - fill_pct;
+		wbp->flush_start_pct = fill_pct;
+	}
+	if (fill_pct != wbp->fill_pct) {
+		wbp->fill_pct = fill_pct;
+		ufshcd_wb_notify_queues(hba);
+	}
+
+	idle_predicted = wbp->screen_off ||
+			 wbp->idle_ewma_ms >= wbp->min_idle_ms;
+	if (!idle_predicted || !fill_pct || fill_pct < wbp->flush_min_pct)
+		return false;
+
+	if (!wbp->flush_start) {
+		wbp->flush_start = ktime_get();
+		wbp->flush_start_pct = fill_pct;
+	}
+	return true;
+}
+
+static void ufshcd_wb_idle_flush_done(struct ufs_hba *hba)
+{
+	struct ufs_wb_policy *wbp = &hba->wb_policy;
+
+	if (!wbp->flush_start)
+		return;
+
+	wbp->last_flush_ms = ktime_ms_delta(ktime_get(), wbp->flush_start);
+	wbp->flush_start = 0;
+}
+
 static bool ufshcd_wb_need_flush(struct ufs_hba *hba)
 {
 	int ret;
@@ -5690,6 +6066,10 @@ static bool ufshcd_wb_need_flush(struct ufs_hba *hba)
 		return false;
 	}
 
+	if (ufshcd_wb_idle_flush(hba, avail_buf))
+		return true;
+	ufshcd_wb_idle_flush_done(hba);
+
 	if (!hba->dev_info.b_presrv_uspc_en) {
 		if (avail_buf <= UFS_WB_BUF_REMAIN_PERCENT(10))
 			return true;
@@ -9316,6 +9696,7 @@ void ufshcd_remove(struct ufs_hba *hba)
 	ufs_bsg_remove(hba);
 	ufs_sysfs_remove_nodes(hba->dev);
 	scsi_remove_host(hba->host);
+	cancel_work_sync(&hba->ahit_tuner.work);
 	destroy_workqueue(hba->eh_wq);
 	/* disable interrupts */
 	ufshcd_disable_intr(hba, hba->intr_mask);
@@ -9323,8 +9704,10 @@ void ufshcd_remove(struct ufs_hba *hba)
 
 	ufshcd_exit_clk_scaling(hba);
 	ufshcd_exit_clk_gating(hba);
-	if (ufshcd_is_clkscaling_supported(hba))
+	if (ufshcd_is_clkscaling_supported(hba)) {
 		device_remove_file(hba->dev, &hba->clk_scaling.enable_attr);
+		device_remove_file(hba->dev, &hba->clk_scaling.predict_attr);
+	}
 	ufshcd_hba_exit(hba);
 }
 EXPORT_SYMBOL_GPL(ufshcd_remove);
@@ -9568,6 +9951,10 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 
 	INIT_DELAYED_WORK(&hba->rpm_dev_flush_recheck_work,
 			  ufshcd_rpm_dev_flush_recheck_work);
+	hba->wb_policy.min_idle_ms = UFS_WB_MIN_IDLE_MS;
+	INIT_WORK(&hba->ahit_tuner.work, ufshcd_ahit_tune_work);
+	hba->ahit_tuner.budget_pct = UFS_AHIT_TUNE_BUDGET_PCT;
+	hba->wb_policy.flush_min_pct = UFS_WB_FLUSH_MIN_PCT;
 
 	/* Set the default auto-hiberate idle timer value to 150 ms */
 	if (ufshcd_is_auto_hibern8_supported(hba) && !hba->ahit) {
@@ -488,9 +488,21 @@ struct ufs_saved_pwr_info {
  * @workq: workqueue to schedule devfreq suspend/resume work
  * @suspend_work: worker to suspend devfreq
  * @resume_work: worker to resume devfreq
+ * @boost_work: worker to re-evaluate devfreq right away on a predicted burst
+ * @predict_attr: sysfs attribute to tune the workload predictor
+ * @boost_qdepth: queue depth at which the predictor votes up, 0 disables it
+ * @boost_min_bytes: smallest read counted as a large sequential read
+ * @win_reads: reads issued in the current window
+ * @win_writes: writes issued in the current window
+ * @win_read_bytes: bytes read in the current window
+ * @win_write_bytes: bytes written in the current window
+ * @win_qdepth_sum: sum of the queue depth seen by each issued request
+ * @next_read_pos: sector following the last large read
+ * @seq_reads: length of the current run of large sequential reads
  * @is_allowed: tracks if scaling is currently allowed or not
  * @is_busy_started: tracks if busy period has started or not
  * @is_suspended: tracks if devfreq is suspended or not
+ * @boost_pending: a burst was detected and not yet reported to devfreq
  */
 struct ufs_clk_scaling {
 	int active_reqs;
@@ -502,9 +514,21 @@ struct ufs_clk_scaling {
 	struct workqueue_struct *workq;
 	struct work_struct suspend_work;
 	struct work_struct resume_work;
+	struct work_struct boost_work;
+	struct device_attribute predict_attr;
+	unsigned int boost_qdepth;
+	unsigned int boost_min_bytes;
+	unsigned int win_reads;
+	unsigned int win_writes;
+	u64 win_read_bytes;
+	u64 win_write_bytes;
+	u64 win_qdepth_sum;
+	sector_t next_read_pos;
+	unsigned int seq_reads;
 	bool is_allowed;
 	bool is_busy_started;
 	bool is_suspended;
+	bool boost_pending;
 };
 
 #ifdef CONFIG_SCSI_UFSHCD_QTI
@@ -611,6 +635,55 @@ struct ufs_err_reg_hist {
 	ktime_t tstamp[UFS_ERR_REG_HIST_LENGTH];
 };
 
+/**
+ * struct ufs_wb_policy - WriteBooster flush policy driven by idle prediction
+ * @idle_ewma_ms: smoothed length of the idle gaps between I/O bursts
+ * @min_idle_ms: predicted idle gap long enough to flush ahead of time
+ * @flush_min_pct: fill level from which a predicted idle window is used
+ * @screen_off: userspace hint that a long idle period is starting
+ * @fill_pct: buffer fill level seen at the last runtime suspend
+ * @flush_start: start of the idle flush in progress, 0 if none
+ * @flush_start_pct: fill level when the idle flush in progress started
+ * @last_flush_ms: duration of the last completed idle flush
+ * @flushed_pct: buffer drained by idle flushes, in percent of the buffer
+ * @absorbed_pct: buffer filled by host writes, in percent of the buffer
+ * @host_write_bytes: bytes written by the host
+ */
+struct ufs_wb_policy {
+	u32 idle_ewma_ms;
+	u32 min_idle_ms;
+	u32 flush_min_pct;
+	bool screen_off;
+	u32 fill_pct;
+	ktime_t flush_start;
+	u32 flush_start_pct;
+	u32 last_flush_ms;
+	u64 flushed_pct;
+	u64 absorbed_pct;
+	u64 host_write_bytes;
+};
+
+#define UFS_AHIT_HIST_BUCKETS	16
+#define UFS_AHIT_HIST_BASE_US	64
+
+/**
+ * struct ufs_ahit_tuner - auto-hibern8 timer tuned from the idle gaps
+ * @work: recomputes the timer once enough gaps were sampled
+ * @hist: log2 histogram of idle gaps, bucket 0 is below 64us
+ * @nr_samples: gaps sampled since the last recompute
+ * @budget_pct: share of the idle time the link may stay awake, 0 disables
+ * @idle_wakes: requests issued on an idle queue
+ * @h8_delayed: of those, requests that had to wait for a hibern8 exit
+ */
+struct ufs_ahit_tuner {
+	struct work_struct work;
+	u32 hist[UFS_AHIT_HIST_BUCKETS];
+	u32 nr_samples;
+	u32 budget_pct;
+	u64 idle_wakes;
+	u64 h8_delayed;
+};
+
 /**
  * struct ufs_stats - keeps usage/err statistics
  * @last_intr_status: record the last interrupt status.
@@ -1028,6 +1101,10 @@ struct ufs_hba {
 	bool wb_buf_flush_enabled;
 	bool wb_enabled;
 	struct delayed_work rpm_dev_flush_recheck_work;
+	struct ufs_wb_policy wb_policy;
+	/* time the request queue last drained, 0 while requests are queued */
+	ktime_t idle_start;
+	struct ufs_ahit_tuner ahit_tuner;
 	ANDROID_KABI_RESERVE(1);
 	ANDROID_KABI_RESERVE(2);
 	ANDROID_KABI_RESERVE(3);
@@ -1121,6 +1198,30 @@ static inline bool ufshcd_is_auto_hibern8_enabled(struct ufs_hba *hba)
 }
 #endif
 
+/* Convert Auto-Hibernate Idle Timer register value to microseconds */
+static inline int ufshcd_ahit_to_us(u32 ahit)
+{
+	int timer = FIELD_GET(UFSHCI_AHIBERN8_TIMER_MASK, ahit);
+	int scale = FIELD_GET(UFSHCI_AHIBERN8_SCALE_MASK, ahit);
+
+	for (; scale > 0; --scale)
+		timer *= UFSHCI_AHIBERN8_SCALE_FACTOR;
+
+	return timer;
+}
+
+/* Convert microseconds to Auto-Hibernate Idle Timer register value */
+static inline u32 ufshcd_us_to_ahit(unsigned int timer)
+{
+	unsigned int scale;
+
+	for (scale = 0; timer > UFSHCI_AHIBERN8_TIMER_MASK; ++scale)
+		timer /= UFSHCI_AHIBERN8_SCALE_FACTOR;
+
+	return FIELD_PREP(UFSHCI_AHIBERN8_TIMER_MASK, timer) |
+	       FIELD_PREP(UFSHCI_AHIBERN8_SCALE_MASK, scale);
+}
+
 static inline bool ufshcd_is_wb_allowed(struct ufs_hba *hba)
 {
 	return hba->caps & UFSHCD_CAP_WB_EN;
@@ -13,6 +13,36 @@
 #include <linux/soc/qcom/apr.h>
 #include <linux/rpmsg.h>
 #include <linux/of.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+
+#define CREATE_TRACE_POINTS
+#include "trace-apr.h"
+
+/* commands waiting for a response, the oldest one is dropped when full */
+#define APR_LAT_PENDING		32
+#define APR_LAT_OPCODES		64
+/* log2 buckets of the response time in us, the last one holds the rest */
+#define APR_LAT_BUCKETS		16
+
+struct apr_lat_cmd {
+	ktime_t ts;
+	uint32_t opcode;
+	uint32_t token;
+	uint16_t svc;
+	bool busy;
+};
+
+struct apr_lat_stats {
+	uint32_t opcode;
+	uint16_t svc;
+	uint32_t count;
+	uint64_t total_us;
+	uint32_t max_us;
+	uint32_t hist[APR_LAT_BUCKETS];
+};
 
 struct apr {
 	struct rpmsg_endpoint *ch;
@@ -22,13 +52,144 @@ struct apr {
 	struct idr svcs_idr;
 	int dest_domain_id;
 	struct workqueue_struct *rxwq;
-	struct work_struct rx_work;
-	struct list_head rx_list;
+
+	/* command response times, protected by lat_lock */
+	spinlock_t lat_lock;
+	struct apr_lat_cmd lat_cmds[APR_LAT_PENDING];
+	struct apr_lat_stats lat_stats[APR_LAT_OPCODES];
+	int lat_nr_stats;
+	uint32_t lat_dropped;
+	struct dentry *debugfs;
 };
 
+static struct dentry *apr_debugfs_root;
+
+static void apr_lat_cmd_start(struct apr *apr, struct apr_hdr *hdr)
+{
+	struct apr_lat_cmd *cmd, *oldest = NULL;
+	unsigned long flags;
+	int i;
+
+	if (APR_HDR_FIELD_MT(hdr->hdr_field) != APR_MSG_TYPE_SEQ_CMD)
+		return;
+
+	spin_lock_irqsave(&apr->lat_lock, flags);
+	for (i = 0; i < APR_LAT_PENDING; i++) {
+		cmd = &apr->lat_cmds[i];
+		if (!cmd->busy)
+			break;
+		if (!oldest || ktime_before(cmd->ts, oldest->ts))
+			oldest = cmd;
+	}
+
+	if (i == APR_LAT_PENDING) {
+		cmd = oldest;
+		apr->lat_dropped++;
+	}
+
+	cmd->ts = ktime_get();
+	cmd->opcode = hdr->opcode;
+	cmd->token = hdr->token;
+	cmd->svc = hdr->dest_svc;
+	cmd->busy = true;
+	spin_unlock_irqrestore(&apr->lat_lock, flags);
+}
+
+/* The command was not sent, forget about it */
+static void apr_lat_cmd_cancel(struct apr *apr, struct apr_hdr *hdr)
+{
+	struct apr_lat_cmd *cmd;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&apr->lat_lock, flags);
+	for (i = 0; i < APR_LAT_PENDING; i++) {
+		cmd = &apr->lat_cmds[i];
+		if (cmd->busy && cmd->svc == hdr->dest_svc &&
+		    cmd->opcode == hdr->opcode && cmd->token == hdr->token) {
+			cmd->busy = false;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&apr->lat_lock, flags);
+}
+
+/* Must be called with lat_lock held */
+static void apr_lat_stats_add(struct apr *apr, struct apr_lat_cmd *cmd,
+			      s64 us)
+{
+	struct apr_lat_stats *stats = NULL;
+	int i, bucket;
+
+	for (i = 0; i < apr->lat_nr_stats; i++) {
+		if (apr->lat_stats[i].opcode == cmd->opcode &&
+		    apr->lat_stats[i].svc == cmd->svc) {
+			stats = &apr->lat_stats[i];
+			break;
+		}
+	}
+
+	if (!stats) {
+		if (apr->lat_nr_stats == APR_LAT_OPCODES)
+			return;
+		stats = &apr->lat_stats[apr->lat_nr_stats++];
+		stats->opcode = cmd->opcode;
+		stats->svc = cmd->svc;
+	}
+
+	bucket = us > 0 ? min_t(int, ilog2(us) + 1, APR_LAT_BUCKETS - 1) : 0;
+	stats->hist[bucket]++;
+	stats->count++;
+	stats->total_us += us;
+	stats->max_us = max_t(uint32_t, stats->max_us, us);
+}
+
+/*
+ * Match a response to the command it answers: a basic response carries the
+ * opcode of the command, other responses are matched on the token alone.
+ */
+static void apr_lat_cmd_done(struct apr *apr, void *buf, uint16_t hdr_size)
+{
+	struct apr_hdr *hdr = buf;
+	struct apr_lat_cmd *cmd, *match = NULL;
+	uint32_t *payload = buf + hdr_size;
+	bool basic = false;
+	unsigned long flags;
+	s64 us = 0;
+	int i;
+
+	if (hdr->opcode == APR_BASIC_RSP_RESULT &&
+	    hdr->pkt_size - hdr_size >= sizeof(uint32_t))
+		basic = true;
+
+	spin_lock_irqsave(&apr->lat_lock, flags);
+	for (i = 0; i < APR_LAT_PENDING; i++) {
+		cmd = &apr->lat_cmds[i];
+		if (!cmd->busy || cmd->svc != hdr->src_svc ||
+		    cmd->token != hdr->token)
+			continue;
+		if (basic && cmd->opcode != payload[0])
+			continue;
+		if (!match || ktime_before(cmd->ts, match->ts))
+			match = cmd;
+	}
+
+	if (match) {
+		us = ktime_us_delta(ktime_get(), match->ts);
+		match->busy = false;
+		apr_lat_stats_add(apr, match, us);
+	}
+	spin_unlock_irqrestore(&apr->lat_lock, flags);
+
+	if (match)
+		trace_apr_rsp(hdr->src_domain, match->svc, match->opcode,
+			      hdr->opcode, hdr->token, us);
+}
+
 struct apr_rx_buf {
 	struct list_head node;
 	int len;
+	uint16_t hdr_size;
 	uint8_t buf[];
 };
 
@@ -55,7 +216,13 @@ int apr_send_pkt(struct apr_device *adev, struct apr_pkt *pkt)
 	hdr->dest_domain = adev->domain_id;
 	hdr->dest_svc = adev->svc_id;
 
+	/* the response may arrive before rpmsg_trysend() returns */
+	apr_lat_cmd_start(apr, hdr);
 	ret = rpmsg_trysend(apr->ch, pkt, hdr->pkt_size);
+	if (ret)
+		apr_lat_cmd_cancel(apr, hdr);
+	trace_apr_send_pkt(hdr->dest_domain, hdr->dest_svc, hdr->opcode,
+			   hdr->token, ret);
 	spin_unlock_irqrestore(&adev->lock, flags);
 
 	return ret ? ret : hdr->pkt_size;
@@ -69,48 +236,12 @@ static void apr_dev_release(struct device *dev)
 	kfree(adev);
 }
 
-static int apr_callback(struct rpmsg_device *rpdev, void *buf,
-				  int len, void *priv, u32 addr)
+/* Returns the header size of a valid packet, negative otherwise */
+static int apr_check_pkt(struct apr *apr, void *buf, int len)
 {
-	struct apr *apr = dev_get_drvdata(&rpdev->dev);
-	struct apr_rx_buf *abuf;
-	unsigned long flags;
+	uint16_t hdr_size, msg_type, ver;
+	struct apr_hdr *hdr = buf;
 
-	if (len <= APR_HDR_SIZE) {
-		dev_err(apr->dev, "APR: Improper apr pkt received:%p %d\n",
-			buf, len);
-		return -EINVAL;
-	}
-
-	abuf = kzalloc(sizeof(*abuf) + len, GFP_ATOMIC);
-	if (!abuf)
-		return -ENOMEM;
-
-	abuf->len = len;
-	memcpy(abuf->buf, buf, len);
-
-	spin_lock_irqsave(&apr->rx_lock, flags);
-	list_add_tail(&abuf->node, &apr->rx_list);
-	spin_unlock_irqrestore(&apr->rx_lock, flags);
-
-	queue_work(apr->rxwq, &apr->rx_work);
-
-	return 0;
-}
-
-
-static int apr_do_rx_callback(struct apr *apr, struct apr_rx_buf *abuf)
-{
-	uint16_t hdr_size, msg_type, ver, svc_id;
-	struct apr_device *svc = NULL;
-	struct apr_driver *adrv = NULL;
-	struct apr_resp_pkt resp;
-	struct apr_hdr *hdr;
-	unsigned long flags;
-	void *buf = abuf->buf;
-	int len = abuf->len;
-
-	hdr = buf;
 	ver = APR_HDR_FIELD_VER(hdr->hdr_field);
 	if (ver > APR_PKT_VER + 1)
 		return -EINVAL;
@@ -140,10 +271,114 @@ static int apr_do_rx_callback(struct apr *apr, struct apr_rx_buf *abuf)
 		return -EINVAL;
 	}
 
-	svc_id = hdr->dest_svc;
+	return hdr_size;
+}
+
+static void apr_fill_resp(struct apr_resp_pkt *resp, void *buf,
+			  uint16_t hdr_size)
+{
+	struct apr_hdr *hdr = buf;
+
+	resp->hdr = *hdr;
+	resp->payload_size = hdr->pkt_size - hdr_size;
+	resp->payload = NULL;
+
+	/*
+	 * NOTE: hdr_size is not same as APR_HDR_SIZE as remote can include
+	 * optional headers in to apr_hdr which should be ignored
+	 */
+	if (resp->payload_size > 0)
+		resp->payload = buf + hdr_size;
+}
+
+/* Must be called with svcs_lock held */
+static int apr_do_atomic_callback(struct apr_device *svc, void *buf,
+				  uint16_t hdr_size)
+{
+	struct apr_driver *adrv;
+	struct apr_resp_pkt resp;
+
+	/* anything still queued for the service has to be delivered first */
+	if (svc->rx_pending || !svc->dev.driver)
+		return -EAGAIN;
+
+	adrv = to_apr_driver(svc->dev.driver);
+	if (!adrv->atomic_callback)
+		return -EAGAIN;
+
+	apr_fill_resp(&resp, buf, hdr_size);
+
+	return adrv->atomic_callback(svc, &resp);
+}
+
+static int apr_callback(struct rpmsg_device *rpdev, void *buf,
+				  int len, void *priv, u32 addr)
+{
+	struct apr *apr = dev_get_drvdata(&rpdev->dev);
+	struct apr_device *svc;
+	struct apr_rx_buf *abuf;
+	unsigned long flags;
+	int hdr_size, ret = 0;
+
+	if (len <= APR_HDR_SIZE) {
+		dev_err(apr->dev, "APR: Improper apr pkt received:%p %d\n",
+			buf, len);
+		return -EINVAL;
+	}
+
+	hdr_size = apr_check_pkt(apr, buf, len);
+	if (hdr_size < 0)
+		return hdr_size;
+
+	apr_lat_cmd_done(apr, buf, hdr_size);
+
+	/*
+	 * svcs_lock keeps the service from being removed until the packet
+	 * is delivered or queued to it
+	 */
+	spin_lock_irqsave(&apr->svcs_lock, flags);
+	svc = idr_find(&apr->svcs_idr, ((struct apr_hdr *)buf)->dest_svc);
+	if (!svc) {
+		dev_err(apr->dev, "APR: service is not registered\n");
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	if (apr_do_atomic_callback(svc, buf, hdr_size) != -EAGAIN)
+		goto unlock;
+
+	abuf = kzalloc(sizeof(*abuf) + len, GFP_ATOMIC);
+	if (!abuf) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	abuf->len = len;
+	abuf->hdr_size = hdr_size;
+	memcpy(abuf->buf, buf, len);
+
+	spin_lock(&apr->rx_lock);
+	list_add_tail(&abuf->node, &svc->rx_list);
+	svc->rx_pending++;
+	spin_unlock(&apr->rx_lock);
+
+	queue_work(apr->rxwq, &svc->rx_work);
+
+unlock:
+	spin_unlock_irqrestore(&apr->svcs_lock, flags);
+
+	return ret;
+}
+
+static int apr_do_rx_callback(struct apr *apr, struct apr_device *svc,
+			      struct apr_rx_buf *abuf)
+{
+	struct apr_driver *adrv = NULL;
+	struct apr_resp_pkt resp;
+	unsigned long flags;
+
 	spin_lock_irqsave(&apr->svcs_lock, flags);
-	svc = idr_find(&apr->svcs_idr, svc_id);
-	if (svc && svc->dev.driver)
+	if (svc->dev.driver)
 		adrv = to_apr_driver(svc->dev.driver);
 	spin_unlock_irqrestore(&apr->svcs_lock, flags);
 
@@ -152,35 +387,39 @@ static int apr_do_rx_callback(struct apr *apr, struct apr_rx_buf *abuf)
 		return -EINVAL;
 	}
 
-	resp.hdr = *hdr;
-	resp.payload_size = hdr->pkt_size - hdr_size;
-
-	/*
-	 * NOTE: hdr_size is not same as APR_HDR_SIZE as remote can include
-	 * optional headers in to apr_hdr which should be ignored
-	 */
-	if (resp.payload_size > 0)
-		resp.payload = buf + hdr_size;
-
+	apr_fill_resp(&resp, abuf->buf, abuf->hdr_size);
 	adrv->callback(svc, &resp);
 
 	return 0;
 }
 
+/* Each service has its own work, a slow service doesn't delay the others */
 static void apr_rxwq(struct work_struct *work)
 {
-	struct apr *apr = container_of(work, struct apr, rx_work);
-	struct apr_rx_buf *abuf, *b;
+	struct apr_device *svc = container_of(work, struct apr_device,
+					      rx_work);
+	struct apr *apr = dev_get_drvdata(svc->dev.parent);
+	struct apr_rx_buf *abuf;
 	unsigned long flags;
 
-	if (!list_empty(&apr->rx_list)) {
-		list_for_each_entry_safe(abuf, b, &apr->rx_list, node) {
-			apr_do_rx_callback(apr, abuf);
-			spin_lock_irqsave(&apr->rx_lock, flags);
+	for (;;) {
+		spin_lock_irqsave(&apr->rx_lock, flags);
+		abuf = list_first_entry_or_null(&svc->rx_list,
+						struct apr_rx_buf, node);
+		if (abuf)
 			list_del(&abuf->node);
-			spin_unlock_irqrestore(&apr->rx_lock, flags);
-			kfree(abuf);
-		}
+		spin_unlock_irqrestore(&apr->rx_lock, flags);
+
+		if (!abuf)
+			break;
+
+		apr_do_rx_callback(apr, svc, abuf);
+		kfree(abuf);
+
+		/* the atomic path stays off until the packet is handled */
+		spin_lock_irqsave(&apr->rx_lock, flags);
+		svc->rx_pending--;
+		spin_unlock_irqrestore(&apr->rx_lock, flags);
 	}
 }
 
@@ -220,14 +459,15 @@ static int apr_device_remove(struct device *dev)
 	struct apr_device *adev = to_apr_device(dev);
 	struct apr_driver *adrv;
 	struct apr *apr = dev_get_drvdata(adev->dev.parent);
+	unsigned long flags;
 
 	if (dev->driver) {
 		adrv = to_apr_driver(dev->driver);
 		if (adrv->remove)
 			adrv->remove(adev);
-		spin_lock(&apr->svcs_lock);
+		spin_lock_irqsave(&apr->svcs_lock, flags);
 		idr_remove(&apr->svcs_idr, adev->svc_id);
-		spin_unlock(&apr->svcs_lock);
+		spin_unlock_irqrestore(&apr->svcs_lock, flags);
 	}
 
 	return 0;
@@ -259,6 +499,7 @@ static int apr_add_device(struct device *dev, struct device_node *np,
 {
 	struct apr *apr = dev_get_drvdata(dev);
 	struct apr_device *adev = NULL;
+	unsigned long flags;
 	int ret;
 
 	adev = kzalloc(sizeof(*adev), GFP_KERNEL);
@@ -266,6 +507,8 @@ static int apr_add_device(struct device *dev, struct device_node *np,
 		return -ENOMEM;
 
 	spin_lock_init(&adev->lock);
+	INIT_LIST_HEAD(&adev->rx_list);
+	INIT_WORK(&adev->rx_work, apr_rxwq);
 
 	adev->svc_id = id->svc_id;
 	adev->domain_id = id->domain_id;
@@ -284,10 +527,10 @@ static int apr_add_device(struct device *dev, struct device_node *np,
 	adev->dev.release = apr_dev_release;
 	adev->dev.driver = NULL;
 
-	spin_lock(&apr->svcs_lock);
+	spin_lock_irqsave(&apr->svcs_lock, flags);
 	idr_alloc(&apr->svcs_idr, adev, id->svc_id,
 		  id->svc_id + 1, GFP_ATOMIC);
-	spin_unlock(&apr->svcs_lock);
+	spin_unlock_irqrestore(&apr->svcs_lock, flags);
 
 	dev_info(dev, "Adding APR dev: %s\n", dev_name(&adev->dev));
 
@@ -318,6 +561,69 @@ static void of_register_apr_devices(struct device *dev)
 	}
 }
 
+static int apr_latency_show(struct seq_file *s, void *unused)
+{
+	struct apr *apr = s->private;
+	struct apr_lat_stats *stats;
+	unsigned long flags;
+	int i, j, n;
+
+	/* snapshot, seq_printf() must not run under the lock */
+	stats = kcalloc(APR_LAT_OPCODES, sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&apr->lat_lock, flags);
+	n = apr->lat_nr_stats;
+	memcpy(stats, apr->lat_stats, n * sizeof(*stats));
+	seq_printf(s, "dropped: %u\n", apr->lat_dropped);
+	spin_unlock_irqrestore(&apr->lat_lock, flags);
+
+	seq_puts(s, "svc opcode count avg_us max_us hist(<1 <2 <4 ... us)\n");
+	for (i = 0; i < n; i++) {
+		seq_printf(s, "%#x %#x %u %llu %u", stats[i].svc,
+			   stats[i].opcode, stats[i].count,
+			   div_u64(stats[i].total_us, stats[i].count),
+			   stats[i].max_us);
+		for (j = 0; j < APR_LAT_BUCKETS; j++)
+			seq_printf(s, " %u", stats[i].hist[j]);
+		seq_puts(s, "\n");
+	}
+
+	kfree(stats);
+
+	return 0;
+}
+
+static int apr_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, apr_latency_show, inode->i_private);
+}
+
+/* Any write clears the statistics */
+static ssize_t apr_latency_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct apr *apr = ((struct seq_file *)file->private_data)->private;
+	unsigned long flags;
+
+	spin_lock_irqsave(&apr->lat_lock, flags);
+	memset(apr->lat_stats, 0, sizeof(apr->lat_stats));
+	apr->lat_nr_stats = 0;
+	apr->lat_dropped = 0;
+	spin_unlock_irqrestore(&apr->lat_lock, flags);
+
+	return count;
+}
+
+static const struct file_operations apr_latency_fops = {
+	.open = apr_latency_open,
+	.read = seq_read,
+	.write = apr_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int apr_probe(struct rpmsg_device *rpdev)
 {
 	struct device *dev = &rpdev->dev;
@@ -337,24 +643,41 @@ static int apr_probe(struct rpmsg_device *rpdev)
 	dev_set_drvdata(dev, apr);
 	apr->ch = rpdev->ept;
 	apr->dev = dev;
-	apr->rxwq = create_singlethread_workqueue("qcom_apr_rx");
+	apr->rxwq = alloc_workqueue("qcom_apr_rx", WQ_HIGHPRI | WQ_UNBOUND, 0);
 	if (!apr->rxwq) {
 		dev_err(apr->dev, "Failed to start Rx WQ\n");
 		return -ENOMEM;
 	}
-	INIT_WORK(&apr->rx_work, apr_rxwq);
-	INIT_LIST_HEAD(&apr->rx_list);
 	spin_lock_init(&apr->rx_lock);
 	spin_lock_init(&apr->svcs_lock);
+	spin_lock_init(&apr->lat_lock);
 	idr_init(&apr->svcs_idr);
 	of_register_apr_devices(dev);
 
+	apr->debugfs = debugfs_create_dir(dev_name(dev), apr_debugfs_root);
+	debugfs_create_file("latency", 0600, apr->debugfs, apr,
+			    &apr_latency_fops);
+
 	return 0;
 }
 
 static int apr_remove_device(struct device *dev, void *null)
 {
 	struct apr_device *adev = to_apr_device(dev);
+	struct apr *apr = dev_get_drvdata(adev->dev.parent);
+	struct apr_rx_buf *abuf, *b;
+	unsigned long flags;
+
+	/* no more packets get queued once the service is gone from the idr */
+	spin_lock_irqsave(&apr->svcs_lock, flags);
+	idr_remove(&apr->svcs_idr, adev->svc_id);
+	spin_unlock_irqrestore(&apr->svcs_lock, flags);
+
+	cancel_work_sync(&adev->rx_work);
+	list_for_each_entry_safe(abuf, b, &adev->rx_list, node) {
+		list_del(&abuf->node);
+		kfree(abuf);
+	}
 
 	device_unregister(&adev->dev);
 
@@ -365,6 +688,7 @@ static void apr_remove(struct rpmsg_device *rpdev)
 {
 	struct apr *apr = dev_get_drvdata(&rpdev->dev);
 
+	debugfs_remove_recursive(apr->debugfs);
 	device_for_each_child(&rpdev->dev, NULL, apr_remove_device);
 	flush_workqueue(apr->rxwq);
 	destroy_workqueue(apr->rxwq);
@@ -420,12 +744,17 @@ static int __init apr_init(void)
 {
 	int ret;
 
+	apr_debugfs_root = debugfs_create_dir("apr", NULL);
+
 	ret = bus_register(&aprbus);
 	if (!ret)
 		ret = register_rpmsg_driver(&apr_driver);
 	else
 		bus_unregister(&aprbus);
 
+	if (ret)
+		debugfs_remove_recursive(apr_debugfs_root);
+
 	return ret;
 }
 
@@ -433,6 +762,7 @@ static void __exit apr_exit(void)
 {
 	bus_unregister(&aprbus);
 	unregister_rpmsg_driver(&apr_driver);
+	debugfs_remove_recursive(apr_debugfs_root);
 }
 
 subsys_initcall(apr_init);
@@ -17,6 +17,10 @@
 #include <linux/of_address.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/debugfs.h>
+#include <linux/kprobes.h>
+#include <linux/seq_file.h>
+#include <linux/vmalloc.h>
 #include <soc/qcom/boot_stats.h>
 
 #define MAX_STRING_LEN 256
@@ -53,6 +57,12 @@ static struct boot_marker boot_marker_list;
 static struct kobject *bootkpi_obj;
 static struct attribute_group *attr_grp;
 
+#ifdef CONFIG_MSM_BOOT_TIMELINE
+static void boot_timeline_marker(const char *name);
+#else
+static inline void boot_timeline_marker(const char *name) { }
+#endif
+
 unsigned long long msm_timer_get_sclk_ticks(void)
 {
 	unsigned long long t1, t2;
@@ -147,6 +157,7 @@ static void boot_marker_cleanup(void)
 void place_marker(const char *name)
 {
 	_create_boot_marker((char *)name, msm_timer_get_sclk_ticks());
+	boot_timeline_marker(name);
 }
 EXPORT_SYMBOL(place_marker);
 
@@ -279,6 +290,284 @@ static int bootkpi_sysfs_init(void)
 	return ret;
 }
 
+#ifdef CONFIG_MSM_BOOT_TIMELINE
+#define BOOT_TL_MAX_EVENTS	4096
+#define BOOT_TL_NAME_LEN	48
+#define BOOT_TL_KRP_MAXACTIVE	64
+
+enum boot_tl_type {
+	BOOT_TL_MARKER,
+	BOOT_TL_MODULE,
+	BOOT_TL_PROBE,
+	BOOT_TL_DEFER,
+	BOOT_TL_FIRMWARE,
+};
+
+static const char * const boot_tl_type_str[] = {
+	[BOOT_TL_MARKER] = "marker",
+	[BOOT_TL_MODULE] = "module",
+	[BOOT_TL_PROBE] = "probe",
+	[BOOT_TL_DEFER] = "defer",
+	[BOOT_TL_FIRMWARE] = "firmware",
+};
+
+struct boot_tl_event {
+	u8 type;
+	u16 cpu;
+	int ret;
+	pid_t pid;
+	u64 start_ns;
+	u64 end_ns;
+	char name[BOOT_TL_NAME_LEN];
+	char dev[BOOT_TL_NAME_LEN];
+};
+
+/* per-call state carried from kretprobe entry to return */
+struct boot_tl_call {
+	u64 start_ns;
+	const char *name;
+	struct device *dev;
+};
+
+static struct boot_tl_event *boot_tl_events;
+static atomic_t boot_tl_count = ATOMIC_INIT(0);
+static bool boot_tl_enabled;
+static struct dentry *boot_tl_dentry;
+
+static void boot_tl_record(enum boot_tl_type type, const char *name,
+		struct device *dev, u64 start_ns, u64 end_ns, int ret)
+{
+	struct boot_tl_event *ev;
+	int idx;
+
+	if (!READ_ONCE(boot_tl_enabled))
+		return;
+
+	idx = atomic_inc_return(&boot_tl_count) - 1;
+	if (idx >= BOOT_TL_MAX_EVENTS) {
+		atomic_set(&boot_tl_count, BOOT_TL_MAX_EVENTS);
+		return;
+	}
+
+	ev = &boot_tl_events[idx];
+	ev->type = type;
+	ev->cpu = raw_smp_processor_id();
+	ev->pid = current->pid;
+	ev->ret = ret;
+	ev->start_ns = start_ns;
+	ev->end_ns = end_ns;
+	strlcpy(ev->name, name ? name : "", sizeof(ev->name));
+	strlcpy(ev->dev, dev ? dev_name(dev) : "", sizeof(ev->dev));
+}
+
+static void boot_timeline_marker(const char *name)
+{
+	u64 now = local_clock();
+
+	boot_tl_record(BOOT_TL_MARKER, name, NULL, now, now, 0);
+}
+
+static int boot_tl_probe_entry(struct kretprobe_instance *ri,
+		struct pt_regs *regs)
+{
+	struct boot_tl_call *call = (struct boot_tl_call *)ri->data;
+	struct device_driver *drv;
+
+	/* really_probe(struct device *dev, struct device_driver *drv) */
+	call->dev = (struct device *)regs_get_kernel_argument(regs, 0);
+	drv = (struct device_driver *)regs_get_kernel_argument(regs, 1);
+	call->name = drv ? drv->name : NULL;
+	call->start_ns = local_clock();
+	return 0;
+}
+
+static int boot_tl_probe_ret(struct kretprobe_instance *ri,
+		struct pt_regs *regs)
+{
+	struct boot_tl_call *call = (struct boot_tl_call *)ri->data;
+	int ret = (int)regs_return_value(regs);
+
+	boot_tl_record(ret == -EPROBE_DEFER ? BOOT_TL_DEFER : BOOT_TL_PROBE,
+			call->name, call->dev, call->start_ns, local_clock(),
+			ret);
+	return 0;
+}
+
+static int boot_tl_fw_entry(struct kretprobe_instance *ri,
+		struct pt_regs *regs)
+{
+	struct boot_tl_call *call = (struct boot_tl_call *)ri->data;
+
+	/* _request_firmware(firmware_p, name, device, ...) */
+	call->name = (const char *)regs_get_kernel_argument(regs, 1);
+	call->dev = (struct device *)regs_get_kernel_argument(regs, 2);
+	call->start_ns = local_clock();
+	return 0;
+}
+
+static int boot_tl_fw_ret(struct kretprobe_instance *ri,
+		struct pt_regs *regs)
+{
+	struct boot_tl_call *call = (struct boot_tl_call *)ri->data;
+
+	boot_tl_record(BOOT_TL_FIRMWARE, call->name, call->dev,
+			call->start_ns, local_clock(),
+			(int)regs_return_value(regs));
+	return 0;
+}
+
+static struct kretprobe boot_tl_probe_krp = {
+	.kp.symbol_name = "really_probe",
+	.entry_handler = boot_tl_probe_entry,
+	.handler = boot_tl_probe_ret,
+	.data_size = sizeof(struct boot_tl_call),
+	.maxactive = BOOT_TL_KRP_MAXACTIVE,
+};
+
+static struct kretprobe boot_tl_fw_krp = {
+	.kp.symbol_name = "_request_firmware",
+	.entry_handler = boot_tl_fw_entry,
+	.handler = boot_tl_fw_ret,
+	.data_size = sizeof(struct boot_tl_call),
+	.maxactive = BOOT_TL_KRP_MAXACTIVE,
+};
+
+static struct kretprobe *boot_tl_krps[] = {
+	&boot_tl_probe_krp,
+	&boot_tl_fw_krp,
+};
+
+/*
+ * Modules are timed from the point they are linked in until their init
+ * returned, so the order and cost of the vendor module list shows up
+ * directly in the timeline.
+ */
+static u64 boot_tl_module_start[BOOT_TL_MAX_EVENTS / 8];
+static const struct module *boot_tl_module_ptr[BOOT_TL_MAX_EVENTS / 8];
+static DEFINE_SPINLOCK(boot_tl_module_lock);
+
+static int boot_tl_module_notify(struct notifier_block *nb,
+		unsigned long state, void *data)
+{
+	struct module *mod = data;
+	u64 now = local_clock();
+	u64 start = 0;
+	int i, slot = -1;
+
+	spin_lock(&boot_tl_module_lock);
+	for (i = 0; i < ARRAY_SIZE(boot_tl_module_ptr); i++) {
+		if (boot_tl_module_ptr[i] == mod) {
+			slot = i;
+			break;
+		}
+		if (slot < 0 && !boot_tl_module_ptr[i])
+			slot = i;
+	}
+
+	if (slot >= 0) {
+		if (state == MODULE_STATE_COMING) {
+			boot_tl_module_ptr[slot] = mod;
+			boot_tl_module_start[slot] = now;
+		} else if (boot_tl_module_ptr[slot] == mod) {
+			start = boot_tl_module_start[slot];
+			boot_tl_module_ptr[slot] = NULL;
+		}
+	}
+	spin_unlock(&boot_tl_module_lock);
+
+	if (start)
+		boot_tl_record(BOOT_TL_MODULE, mod->name, NULL, start, now,
+				state == MODULE_STATE_LIVE ? 0 : -EINVAL);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block boot_tl_module_nb = {
+	.notifier_call = boot_tl_module_notify,
+};
+
+static int boot_tl_show(struct seq_file *s, void *unused)
+{
+	int i, count = min(atomic_read(&boot_tl_count), BOOT_TL_MAX_EVENTS);
+	struct boot_tl_event *ev;
+
+	seq_puts(s, "type,name,device,start_us,duration_us,ret,cpu,pid\n");
+	for (i = 0; i < count; i++) {
+		ev = &boot_tl_events[i];
+		seq_printf(s, "%s,%s,%s,%llu,%llu,%d,%u,%d\n",
+			boot_tl_type_str[ev->type], ev->name, ev->dev,
+			div_u64(ev->start_ns, NSEC_PER_USEC),
+			div_u64(ev->end_ns - ev->start_ns, NSEC_PER_USEC),
+			ev->ret, ev->cpu, ev->pid);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(boot_tl);
+
+static int boot_tl_init(void)
+{
+	int ret;
+
+	boot_tl_events = vzalloc(BOOT_TL_MAX_EVENTS * sizeof(*boot_tl_events));
+	if (!boot_tl_events)
+		return -ENOMEM;
+
+	WRITE_ONCE(boot_tl_enabled, true);
+
+	ret = register_module_notifier(&boot_tl_module_nb);
+	if (ret)
+		goto err_free;
+
+	/* firmware loading may be compiled out; probe timing is enough */
+	ret = register_kretprobes(boot_tl_krps, ARRAY_SIZE(boot_tl_krps));
+	if (ret) {
+		pr_warn("boot_stats: firmware timing unavailable %d\n", ret);
+		ret = register_kretprobe(&boot_tl_probe_krp);
+		boot_tl_krps[1] = NULL;
+	}
+	if (ret) {
+		pr_err("boot_stats: can't hook driver probe %d\n", ret);
+		goto err_notifier;
+	}
+
+	boot_tl_dentry = debugfs_create_dir("boot_timeline", NULL);
+	debugfs_create_file("events", 0400, boot_tl_dentry, NULL,
+			&boot_tl_fops);
+	debugfs_create_bool("enable", 0600, boot_tl_dentry,
+			&boot_tl_enabled);
+
+	return 0;
+
+err_notifier:
+	unregister_module_notifier(&boot_tl_module_nb);
+err_free:
+	WRITE_ONCE(boot_tl_enabled, false);
+	vfree(boot_tl_events);
+	boot_tl_events = NULL;
+	return ret;
+}
+
+static void boot_tl_exit(void)
+{
+	if (!boot_tl_events)
+		return;
+
+	WRITE_ONCE(boot_tl_enabled, false);
+	debugfs_remove_recursive(boot_tl_dentry);
+	if (boot_tl_krps[1])
+		unregister_kretprobes(boot_tl_krps, ARRAY_SIZE(boot_tl_krps));
+	else
+		unregister_kretprobe(&boot_tl_probe_krp);
+	unregister_module_notifier(&boot_tl_module_nb);
+	vfree(boot_tl_events);
+	boot_tl_events = NULL;
+}
+#else
+static inline int boot_tl_init(void) { return 0; }
+static inline void boot_tl_exit(void) { }
+#endif
+
 static int init_bootkpi(void)
 {
 	int ret = 0;
@@ -289,11 +578,17 @@ static int init_bootkpi(void)
 
 	INIT_LIST_HEAD(&boot_marker_list.list);
 	spin_lock_init(&boot_marker_list.slock);
+
+	ret = boot_tl_init();
+	if (ret)
+		pr_err("boot_stats: boot timeline init failed %d\n", ret);
+
 	return 0;
 }
 
 static void exit_bootkpi(void)
 {
+	boot_tl_exit();
 	boot_marker_cleanup();
 	sysfs_remove_group(bootkpi_obj, attr_grp);
 	kobject_del(bootkpi_obj);
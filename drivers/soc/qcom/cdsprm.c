@@ -30,6 +30,7 @@
 #include <linux/rpmsg.h>
 #include <linux/thermal.h>
 #include <linux/debugfs.h>
+#include <linux/ktime.h>
 #include <asm/arch_timer.h>
 #include <linux/soc/qcom/cdsprm.h>
 #include <linux/soc/qcom/cdsprm_cxlimit.h>
@@ -182,9 +183,28 @@ enum delay_state {
 struct cdsprm_request {
 	struct list_head node;
 	struct sysmon_msg msg;
+	ktime_t queued;
 	bool busy;
 };
 
+enum cdsprm_req_stat {
+	CDSPRM_STAT_L3,
+	CDSPRM_STAT_RM,
+	CDSPRM_STAT_NPU_LIMIT,
+	CDSPRM_STAT_MAX,
+};
+
+static const char * const cdsprm_req_stat_names[CDSPRM_STAT_MAX] = {
+	"l3", "rm", "npu_limit",
+};
+
+/* rpmsg callback to request handled, in us */
+struct cdsprm_req_stats {
+	u64 count;
+	u64 total_us;
+	u64 max_us;
+};
+
 struct cdsprm {
 	unsigned int			cdsp_version;
 	unsigned int			event;
@@ -250,6 +270,16 @@ struct cdsprm {
 	u32 *coreno;
 	u32 corecount;
 	struct dev_pm_qos_request *dev_pm_qos_req;
+	/* session hint pre-vote, see cdsprm_session_hint() */
+	struct mutex			hint_lock;
+	struct delayed_work		hint_work;
+	bool				b_hint_active;
+	unsigned int			hint_l3_khz;
+	unsigned int			l3_dsp_khz;
+	unsigned int			hint_prev_prio_idx;
+	u64				hint_count;
+	u64				hint_throttled;
+	struct cdsprm_req_stats		req_stats[CDSPRM_STAT_MAX];
 };
 
 static struct cdsprm gcdsprm;
@@ -853,6 +883,128 @@ static struct cdsprm_request *get_next_request(void)
 	return req;
 }
 
+static void cdsprm_account_request(struct cdsprm_request *req)
+{
+	struct cdsprm_req_stats *st;
+	u64 us;
+
+	switch (req->msg.feature_id) {
+	case SYSMON_CDSP_FEATURE_L3_RX:
+		st = &gcdsprm.req_stats[CDSPRM_STAT_L3];
+		break;
+	case SYSMON_CDSP_FEATURE_RM_RX:
+		st = &gcdsprm.req_stats[CDSPRM_STAT_RM];
+		break;
+	case SYSMON_CDSP_FEATURE_NPU_LIMIT_RX:
+		st = &gcdsprm.req_stats[CDSPRM_STAT_NPU_LIMIT];
+		break;
+	default:
+		return;
+	}
+
+	us = ktime_us_delta(ktime_get(), req->queued);
+	st->count++;
+	st->total_us += us;
+	st->max_us = max(st->max_us, us);
+}
+
+static void cdsprm_set_l3_locked(unsigned int freq_khz)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&gcdsprm.l3_lock, flags);
+	gcdsprm.set_l3_freq_cached = gcdsprm.set_l3_freq;
+	spin_unlock_irqrestore(&gcdsprm.l3_lock, flags);
+
+	if (gcdsprm.set_l3_freq_cached && freq_khz)
+		gcdsprm.set_l3_freq_cached(freq_khz);
+}
+
+static void cdsprm_hint_release(struct work_struct *work)
+{
+	mutex_lock(&gcdsprm.hint_lock);
+	if (!gcdsprm.b_hint_active) {
+		mutex_unlock(&gcdsprm.hint_lock);
+		return;
+	}
+
+	gcdsprm.b_hint_active = false;
+	cdsprm_set_l3_locked(gcdsprm.l3_dsp_khz);
+	if (gcdsprm.b_cx_limit_en &&
+	    gcdsprm.compute_prio_idx != gcdsprm.hint_prev_prio_idx)
+		cdsprm_compute_core_set_priority(gcdsprm.hint_prev_prio_idx);
+	mutex_unlock(&gcdsprm.hint_lock);
+
+	/* drop the QoS vote unless the DSP is holding it itself */
+	mutex_lock(&gcdsprm.rm_lock);
+	if ((gcdsprm.dt_state == CDSP_DELAY_THREAD_NOT_STARTED ||
+	     gcdsprm.dt_state == CDSP_DELAY_THREAD_EXITING) &&
+	    gcdsprm.latency_request != PM_QOS_RESUME_LATENCY_DEFAULT_VALUE) {
+		set_qos_latency(PM_QOS_RESUME_LATENCY_DEFAULT_VALUE);
+		gcdsprm.latency_request = PM_QOS_RESUME_LATENCY_DEFAULT_VALUE;
+	}
+	mutex_unlock(&gcdsprm.rm_lock);
+}
+
+/**
+ * cdsprm_session_hint() - Pre-vote resources for an upcoming CDSP workload
+ * @duration_ms: expected length of the workload, capped at qos-maxhold-ms
+ * @priority:    compute priority for the workload, 0 to leave unchanged
+ *
+ * Raises the CPU QoS latency vote and the L3 floor from qcom,hint-l3-khz
+ * before the DSP asks for them, so the first inference of a session does
+ * not run while clocks ramp. The votes fall back to whatever the DSP
+ * requested once @duration_ms expires. While the CDSP is thermally
+ * limited the L3 pre-vote is skipped rather than fighting the mitigation.
+ */
+int cdsprm_session_hint(unsigned int duration_ms, unsigned int priority)
+{
+	bool throttled;
+
+	if (!gcdsprm.b_qosinitdone)
+		return -EAGAIN;
+
+	if (priority > CDSPRM_COMPUTE_BALANCED)
+		return -EINVAL;
+
+	duration_ms = min(duration_ms, gcdsprm.qos_max_ms);
+	if (!duration_ms)
+		return 0;
+
+	mutex_lock(&gcdsprm.thermal_lock);
+	throttled = gcdsprm.thermal_cdsp_level != 0;
+	mutex_unlock(&gcdsprm.thermal_lock);
+
+	mutex_lock(&gcdsprm.rm_lock);
+	if (gcdsprm.latency_request != gcdsprm.qos_latency_us) {
+		set_qos_latency(gcdsprm.qos_latency_us);
+		gcdsprm.latency_request = gcdsprm.qos_latency_us;
+	}
+	mutex_unlock(&gcdsprm.rm_lock);
+
+	mutex_lock(&gcdsprm.hint_lock);
+	gcdsprm.hint_count++;
+	if (throttled)
+		gcdsprm.hint_throttled++;
+	else if (gcdsprm.hint_l3_khz > gcdsprm.l3_dsp_khz)
+		cdsprm_set_l3_locked(gcdsprm.hint_l3_khz);
+
+	if (!gcdsprm.b_hint_active)
+		gcdsprm.hint_prev_prio_idx = gcdsprm.compute_prio_idx;
+	if (priority && gcdsprm.b_cx_limit_en &&
+	    priority != gcdsprm.compute_prio_idx)
+		cdsprm_compute_core_set_priority(priority);
+
+	gcdsprm.b_hint_active = true;
+	mutex_unlock(&gcdsprm.hint_lock);
+
+	mod_delayed_work(system_wq, &gcdsprm.hint_work,
+			 msecs_to_jiffies(duration_ms));
+
+	return 0;
+}
+EXPORT_SYMBOL(cdsprm_session_hint);
+
 static int process_cdsp_request_thread(void *data)
 {
 	struct cdsprm_request *req = NULL;
@@ -882,6 +1034,13 @@ static int process_cdsp_request_thread(void *data)
 			SYSMON_CDSP_FEATURE_L3_RX)) {
 			l3_clock_khz = msg->fs.l3_struct.l3_clock_khz;
 
+			mutex_lock(&gcdsprm.hint_lock);
+			gcdsprm.l3_dsp_khz = l3_clock_khz;
+			/* an active session hint keeps its floor */
+			if (gcdsprm.b_hint_active)
+				l3_clock_khz = max(l3_clock_khz,
+						   gcdsprm.hint_l3_khz);
+
 			spin_lock_irqsave(&gcdsprm.l3_lock, flags);
 			gcdsprm.set_l3_freq_cached = gcdsprm.set_l3_freq;
 			spin_unlock_irqrestore(&gcdsprm.l3_lock, flags);
@@ -891,6 +1050,7 @@ static int process_cdsp_request_thread(void *data)
 				pr_debug("Set L3 clock %d done\n",
 					l3_clock_khz);
 			}
+			mutex_unlock(&gcdsprm.hint_lock);
 		} else if (msg && (msg->feature_id ==
 				SYSMON_CDSP_FEATURE_NPU_LIMIT_RX)) {
 			mutex_lock(&gcdsprm.npu_activity_lock);
@@ -942,6 +1102,9 @@ static int process_cdsp_request_thread(void *data)
 			pr_debug("Sent preserved data to DSP\n");
 		}
 
+		if (msg)
+			cdsprm_account_request(req);
+
 		spin_lock_irqsave(&gcdsprm.list_lock, flags);
 		list_del(&req->node);
 		req->busy = false;
@@ -1064,6 +1227,7 @@ static int cdsprm_rpmsg_callback(struct rpmsg_device *dev, void *data,
 			req = &gcdsprm.msg_queue[gcdsprm.msg_queue_idx];
 			req->busy = true;
 			req->msg = *msg;
+			req->queued = ktime_get();
 			if (gcdsprm.msg_queue_idx <
 					(CDSPRM_MSG_QUEUE_DEPTH - 1))
 				gcdsprm.msg_queue_idx++;
@@ -1197,6 +1361,26 @@ static int cdsprm_vtcm_test_state_write(void *data, u64 val)
 }
 #endif
 
+static int cdsprm_request_stats_show(struct seq_file *s, void *unused)
+{
+	struct cdsprm_req_stats *st;
+	int i;
+
+	seq_puts(s, "request count avg_us max_us\n");
+	for (i = 0; i < CDSPRM_STAT_MAX; i++) {
+		st = &gcdsprm.req_stats[i];
+		seq_printf(s, "%s %llu %llu %llu\n", cdsprm_req_stat_names[i],
+			   st->count,
+			   st->count ? div64_u64(st->total_us, st->count) : 0,
+			   st->max_us);
+	}
+	seq_printf(s, "hints %llu throttled %llu\n", gcdsprm.hint_count,
+		   gcdsprm.hint_throttled);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(cdsprm_request_stats);
+
 DEFINE_DEBUGFS_ATTRIBUTE(cdsprm_debugfs_fops,
 			cdsprm_compute_prio_read,
 			cdsprm_compute_prio_write,
@@ -1250,6 +1434,9 @@ static int cdsp_rm_driver_probe(struct platform_device *pdev)
 				"qcom,compute-priority-mode",
 				&gcdsprm.compute_prio_idx);
 
+	of_property_read_u32(dev->of_node, "qcom,hint-l3-khz",
+				&gcdsprm.hint_l3_khz);
+
 	gcdsprm.b_cx_limit_en = of_property_read_bool(dev->of_node,
 				"qcom,compute-cx-limit-en");
 
@@ -1435,6 +1622,11 @@ static int cdsp_rm_driver_probe(struct platform_device *pdev)
 		}
 	}
 
+	if (!gcdsprm.debugfs_dir)
+		gcdsprm.debugfs_dir = debugfs_create_dir("compute", NULL);
+	debugfs_create_file("request_stats", 0444, gcdsprm.debugfs_dir,
+				NULL, &cdsprm_request_stats_fops);
+
 	dev_dbg(dev, "CDSP request manager driver probe called\n");
 
 	return 0;
@@ -1523,6 +1715,8 @@ static int __init cdsprm_init(void)
 	mutex_init(&gcdsprm.rpmsg_lock);
 	mutex_init(&gcdsprm.npu_activity_lock);
 	mutex_init(&gcdsprm.thermal_lock);
+	mutex_init(&gcdsprm.hint_lock);
+	INIT_DELAYED_WORK(&gcdsprm.hint_work, cdsprm_hint_release);
 	spin_lock_init(&gcdsprm.l3_lock);
 	spin_lock_init(&gcdsprm.list_lock);
 	init_completion(&gcdsprm.msg_avail);
@@ -1593,6 +1787,7 @@ static void __exit cdsprm_exit(void)
 	struct sysmon_msg_tx rpmsg_msg_tx;
 
 	pr_info("Exit module called\n");
+	cancel_delayed_work_sync(&gcdsprm.hint_work);
 	if (gcdsprm.qos_request) {
 		set_qos_latency(PM_QOS_RESUME_LATENCY_DEFAULT_VALUE);
 		gcdsprm.latency_request = PM_QOS_RESUME_LATENCY_DEFAULT_VALUE;
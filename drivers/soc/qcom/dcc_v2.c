@@ -10,6 +10,7 @@
 #include <linux/io.h>
 #include <linux/iopoll.h>
 #include <linux/fs.h>
+#include <linux/mm.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
@@ -135,12 +136,33 @@ struct dcc_config_entry {
 	struct list_head		list;
 };
 
+/*
+ * One descriptor of a prebuilt link list image written to config_image.
+ * Fields are little endian; their meaning depends on type:
+ *   DCC_IMG_READ:  addr, arg1 = number of words, arg2 = apb bus
+ *   DCC_IMG_WRITE: addr, arg1 = value, arg2 = apb bus
+ *   DCC_IMG_RMW:   arg1 = mask, arg2 = value
+ *   DCC_IMG_LOOP:  arg1 = loop count
+ */
+struct dcc_img_entry {
+	__le32				type;
+	__le32				addr;
+	__le32				arg1;
+	__le32				arg2;
+};
+
+#define DCC_IMG_READ			0
+#define DCC_IMG_WRITE			1
+#define DCC_IMG_RMW			2
+#define DCC_IMG_LOOP			3
+
 struct dcc_drvdata {
 	void __iomem		*base;
 	uint32_t		reg_size;
 	struct device		*dev;
 	struct mutex		mutex;
 	void __iomem		*ram_base;
+	phys_addr_t		ram_phys;
 	uint32_t		ram_size;
 	uint32_t		ram_offset;
 	enum dcc_data_sink	*data_sink;
@@ -1025,26 +1047,16 @@ static ssize_t config_show(struct device *dev,
 	return count;
 }
 
-static int dcc_config_add(struct dcc_drvdata *drvdata, unsigned int addr,
-			  unsigned int len, int apb_bus)
+static int __dcc_config_add(struct dcc_drvdata *drvdata, unsigned int addr,
+			    unsigned int len, int apb_bus)
 {
-	int ret;
 	struct dcc_config_entry *entry, *pentry;
 	unsigned int base, offset;
 
-	mutex_lock(&drvdata->mutex);
-
-	if (drvdata->curr_list >= drvdata->nr_link_list) {
-		dev_err(drvdata->dev, "Select link list to program using curr_list\n");
-		ret = -EINVAL;
-		goto err;
-	}
-
 	/* Check the len to avoid allocate huge memory */
 	if (!len || len > (drvdata->ram_size / 8)) {
 		dev_err(drvdata->dev, "DCC: Invalid length\n");
-		ret = -EINVAL;
-		goto err;
+		return -EINVAL;
 	}
 
 	base = addr & BM(4, 31);
@@ -1096,10 +1108,8 @@ static int dcc_config_add(struct dcc_drvdata *drvdata, unsigned int addr,
 
 	while (len) {
 		entry = devm_kzalloc(drvdata->dev, sizeof(*entry), GFP_KERNEL);
-		if (!entry) {
-			ret = -ENOMEM;
-			goto err;
-		}
+		if (!entry)
+			return -ENOMEM;
 
 		entry->base = base;
 		entry->offset = offset;
@@ -1115,8 +1125,23 @@ static int dcc_config_add(struct dcc_drvdata *drvdata, unsigned int addr,
 		offset += MAX_DCC_LEN * 4;
 	}
 
-	mutex_unlock(&drvdata->mutex);
 	return 0;
+}
+
+static int dcc_config_add(struct dcc_drvdata *drvdata, unsigned int addr,
+			  unsigned int len, int apb_bus)
+{
+	int ret;
+
+	mutex_lock(&drvdata->mutex);
+
+	if (drvdata->curr_list >= drvdata->nr_link_list) {
+		dev_err(drvdata->dev, "Select link list to program using curr_list\n");
+		ret = -EINVAL;
+		goto err;
+	}
+
+	ret = __dcc_config_add(drvdata, addr, len, apb_bus);
 err:
 	mutex_unlock(&drvdata->mutex);
 	return ret;
@@ -1322,31 +1347,19 @@ static ssize_t loop_store(struct device *dev,
 }
 static DEVICE_ATTR_WO(loop);
 
-static int dcc_rd_mod_wr_add(struct dcc_drvdata *drvdata, unsigned int mask,
-			  unsigned int val)
+static int __dcc_rd_mod_wr_add(struct dcc_drvdata *drvdata,
+			       unsigned int mask, unsigned int val)
 {
-	int ret = 0;
 	struct dcc_config_entry *entry;
 
-	mutex_lock(&drvdata->mutex);
-
-	if (drvdata->curr_list >= drvdata->nr_link_list) {
-		dev_err(drvdata->dev, "Select link list to program using curr_list\n");
-		ret = -EINVAL;
-		goto err;
-	}
-
 	if (list_empty(&drvdata->cfg_head[drvdata->curr_list])) {
 		dev_err(drvdata->dev, "DCC: No read address programmed\n");
-		ret = -EPERM;
-		goto err;
+		return -EPERM;
 	}
 
 	entry = devm_kzalloc(drvdata->dev, sizeof(*entry), GFP_KERNEL);
-	if (!entry) {
-		ret = -ENOMEM;
-		goto err;
-	}
+	if (!entry)
+		return -ENOMEM;
 
 	entry->desc_type = DCC_READ_WRITE_TYPE;
 	entry->mask = mask;
@@ -1354,6 +1367,24 @@ static int dcc_rd_mod_wr_add(struct dcc_drvdata *drvdata, unsigned int mask,
 	entry->index = drvdata->nr_config[drvdata->curr_list]++;
 	INIT_LIST_HEAD(&entry->list);
 	list_add_tail(&entry->list, &drvdata->cfg_head[drvdata->curr_list]);
+
+	return 0;
+}
+
+static int dcc_rd_mod_wr_add(struct dcc_drvdata *drvdata, unsigned int mask,
+			  unsigned int val)
+{
+	int ret = 0;
+
+	mutex_lock(&drvdata->mutex);
+
+	if (drvdata->curr_list >= drvdata->nr_link_list) {
+		dev_err(drvdata->dev, "Select link list to program using curr_list\n");
+		ret = -EINVAL;
+		goto err;
+	}
+
+	ret = __dcc_rd_mod_wr_add(drvdata, mask, val);
 err:
 	mutex_unlock(&drvdata->mutex);
 	return ret;
@@ -1486,6 +1517,67 @@ static ssize_t cti_trig_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(cti_trig);
 
+/*
+ * Bulk load of a prebuilt link list image into curr_list: a packed array
+ * of struct dcc_img_entry, applied under a single lock instead of one
+ * sysfs write per descriptor. Large images may arrive in several writes,
+ * each of which must hold whole entries.
+ */
+static ssize_t config_image_write(struct file *filp, struct kobject *kobj,
+				  struct bin_attribute *attr, char *buf,
+				  loff_t off, size_t count)
+{
+	struct dcc_drvdata *drvdata = dev_get_drvdata(kobj_to_dev(kobj));
+	const struct dcc_img_entry *img = (const struct dcc_img_entry *)buf;
+	size_t i, nr = count / sizeof(*img);
+	uint32_t addr, arg1, arg2;
+	int ret = 0;
+
+	if (!nr || count % sizeof(*img) || off % sizeof(*img))
+		return -EINVAL;
+
+	mutex_lock(&drvdata->mutex);
+
+	if (drvdata->curr_list >= drvdata->nr_link_list) {
+		dev_err(drvdata->dev, "Select link list to program using curr_list\n");
+		ret = -EINVAL;
+		goto err;
+	}
+
+	for (i = 0; i < nr; i++) {
+		addr = le32_to_cpu(img[i].addr);
+		arg1 = le32_to_cpu(img[i].arg1);
+		arg2 = le32_to_cpu(img[i].arg2);
+
+		switch (le32_to_cpu(img[i].type)) {
+		case DCC_IMG_READ:
+			ret = __dcc_config_add(drvdata, addr, arg1, !!arg2);
+			break;
+		case DCC_IMG_WRITE:
+			ret = dcc_add_write(drvdata, addr, arg1, !!arg2);
+			break;
+		case DCC_IMG_RMW:
+			ret = __dcc_rd_mod_wr_add(drvdata, arg1, arg2);
+			break;
+		case DCC_IMG_LOOP:
+			ret = dcc_add_loop(drvdata, arg1);
+			break;
+		default:
+			ret = -EINVAL;
+			break;
+		}
+		if (ret) {
+			dev_err(drvdata->dev, "DCC: Bad image entry %zu\n",
+				(size_t)(off / sizeof(*img)) + i);
+			goto err;
+		}
+	}
+err:
+	mutex_unlock(&drvdata->mutex);
+	return ret ? ret : count;
+}
+static BIN_ATTR_WO(config_image, 0);
+
 static const struct device_attribute *dcc_attrs[] = {
 	&dev_attr_func_type,
 	&dev_attr_data_sink,
@@ -1517,6 +1609,8 @@ static int dcc_create_files(struct device *dev,
 			break;
 		}
 	}
+	if (!ret)
+		ret = device_create_bin_file(dev, &bin_attr_config_image);
 	return ret;
 }
 
@@ -1564,10 +1658,34 @@ static ssize_t dcc_sram_read(struct file *file, char __user *data,
 	return len;
 }
 
+/*
+ * Read-only mapping of the capture SRAM, so a dump can be collected
+ * without bouncing every word through read().
+ */
+static int dcc_sram_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct dcc_drvdata *drvdata = file->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (!PAGE_ALIGNED(drvdata->ram_phys) || vma->vm_pgoff ||
+	    size > PAGE_ALIGN(drvdata->ram_size))
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	return io_remap_pfn_range(vma, vma->vm_start,
+				  drvdata->ram_phys >> PAGE_SHIFT, size,
+				  vma->vm_page_prot);
+}
+
 static const struct file_operations dcc_sram_fops = {
 	.owner		= THIS_MODULE,
 	.open		= dcc_sram_open,
 	.read		= dcc_sram_read,
+	.mmap		= dcc_sram_mmap,
 	.llseek		= no_llseek,
 };
 
@@ -1775,6 +1893,7 @@ static int dcc_probe(struct platform_device *pdev)
 	if (!res)
 		return -EINVAL;
 
+	drvdata->ram_phys = res->start;
 	drvdata->ram_size = resource_size(res);
 	drvdata->ram_base = devm_ioremap(dev, res->start, resource_size(res));
 	if (!drvdata->ram_base)
@@ -1880,6 +1999,7 @@ static struct platform_driver dcc_driver = {
 	.driver         = {
 		.name   = "msm-dcc",
 		.of_match_table	= msm_dcc_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
@@ -422,6 +422,7 @@ static struct platform_driver ddr_stats_driver = {
 	.driver = {
 		.name = "ddr_stats",
 		.of_match_table = ddr_stats_table,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_platform_driver(ddr_stats_driver);
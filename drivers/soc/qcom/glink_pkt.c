@@ -38,6 +38,23 @@ do {									     \
 #define GLINK_PKT_IOCTL_QUEUE_RX_INTENT \
 	_IOW(GLINK_PKT_IOCTL_MAGIC, 0, unsigned int)
 
+/**
+ * struct glink_pkt_rx_batch - argument of GLINK_PKT_IOCTL_READ_BATCH
+ * @buf:	user buffer the packets are copied into, back to back
+ * @buf_len:	size of @buf
+ * @nr_pkts:	in: number of entries in @pkt_lens, out: packets copied
+ * @pkt_lens:	user array of __u32 receiving the length of each packet
+ */
+struct glink_pkt_rx_batch {
+	__u64 buf;
+	__u32 buf_len;
+	__u32 nr_pkts;
+	__u64 pkt_lens;
+};
+
+#define GLINK_PKT_IOCTL_READ_BATCH \
+	_IOWR(GLINK_PKT_IOCTL_MAGIC, 1, struct glink_pkt_rx_batch)
+
 #define MODULE_NAME "glink_pkt"
 static dev_t glink_pkt_major;
 static struct class *glink_pkt_class;
@@ -363,6 +380,82 @@ static ssize_t glink_pkt_read(struct file *file,
 	return use;
 }
 
+/**
+ * glink_pkt_read_batch() - drain several packets in one call
+ * gpdev:	Pointer to the glink pkt device.
+ * file:	Pointer to the file structure.
+ * arg:		Userspace pointer to a struct glink_pkt_rx_batch.
+ *
+ * Waits for the first packet like read() does, then keeps dequeuing
+ * without blocking while packets fit in the user buffer, so a busy
+ * client drains its queue with one syscall instead of one per packet.
+ * A first packet larger than the buffer is truncated, as with read().
+ */
+static long glink_pkt_read_batch(struct glink_pkt_device *gpdev,
+				 struct file *file, unsigned long arg)
+{
+	struct glink_pkt_rx_batch __user *ubatch = (void __user *)arg;
+	struct glink_pkt_rx_batch batch;
+	u32 __user *ulens;
+	char __user *ubuf;
+	unsigned long flags;
+	struct sk_buff *skb;
+	u32 off = 0, nr = 0, use;
+	int ret = 0;
+
+	if (copy_from_user(&batch, ubatch, sizeof(batch)))
+		return -EFAULT;
+	if (!batch.nr_pkts || !batch.buf_len)
+		return -EINVAL;
+
+	ubuf = u64_to_user_ptr(batch.buf);
+	ulens = u64_to_user_ptr(batch.pkt_lens);
+
+	if (skb_queue_empty(&gpdev->queue)) {
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		if (wait_event_interruptible(gpdev->readq,
+					     !skb_queue_empty(&gpdev->queue) ||
+					     !completion_done(&gpdev->ch_open)))
+			return -ERESTARTSYS;
+
+		if (!completion_done(&gpdev->ch_open))
+			return -ENETRESET;
+	}
+
+	while (nr < batch.nr_pkts) {
+		spin_lock_irqsave(&gpdev->queue_lock, flags);
+		skb = skb_peek(&gpdev->queue);
+		if (!skb || (nr && skb->len > batch.buf_len - off)) {
+			spin_unlock_irqrestore(&gpdev->queue_lock, flags);
+			break;
+		}
+		__skb_unlink(skb, &gpdev->queue);
+		spin_unlock_irqrestore(&gpdev->queue_lock, flags);
+
+		use = min_t(u32, skb->len, batch.buf_len - off);
+		if (copy_to_user(ubuf + off, skb->data, use) ||
+		    put_user(use, ulens + nr))
+			ret = -EFAULT;
+		kfree_skb(skb);
+		if (ret)
+			break;
+
+		off += use;
+		nr++;
+	}
+
+	if (put_user(nr, &ubatch->nr_pkts))
+		ret = -EFAULT;
+
+	GLINK_PKT_INFO("%s by %s:%d pkts[%u] bytes[%u] ret[%d]\n",
+		       gpdev->ch_name, current->comm, task_pid_nr(current),
+		       nr, off, ret);
+
+	return ret ? ret : nr;
+}
+
 /**
  * glink_pkt_write() - write() syscall for the glink_pkt device
  * file:	Pointer to the file structure.
@@ -528,6 +621,16 @@ static long glink_pkt_ioctl(struct file *file, unsigned int cmd,
 		GLINK_PKT_ERR("invalid device handle\n");
 		return -EINVAL;
 	}
+
+	/* may block waiting for data, so don't hold the device lock */
+	if (cmd == GLINK_PKT_IOCTL_READ_BATCH) {
+		if (!completion_done(&gpdev->ch_open)) {
+			GLINK_PKT_ERR("%s channel in reset\n", gpdev->ch_name);
+			return -ENETRESET;
+		}
+		return glink_pkt_read_batch(gpdev, file, arg);
+	}
+
 	if (mutex_lock_interruptible(&gpdev->lock))
 		return -ERESTARTSYS;
 
@@ -433,20 +433,20 @@ static bool hgsl_ctx_dbq_ready(struct hgsl_priv  *priv)
 	return false;
 }
 
-static uint32_t db_queue_freedwords(struct doorbell_queue *dbq)
+/*
+ * The producer index is only ever written by this driver under dbq->lock,
+ * so callers pass in the one they are building on instead of re-reading it
+ * from the shared queue header for every message.
+ */
+static uint32_t db_queue_freedwords(struct doorbell_queue *dbq, uint32_t wptr)
 {
 	uint32_t queue_size;
 	uint32_t queue_used;
-	uint32_t wptr;
 	uint32_t rptr;
 
 	if (dbq == NULL)
 		return 0;
 
-	wptr = hgsl_dbq_get_state_info((uint32_t *)dbq->vbase,
-			HGSL_DBQ_METADATA_QUEUE_INDEX, HGSL_DBQ_CONTEXT_ANY,
-				HGSL_DBQ_WRITE_INDEX_OFFSET_IN_DWORD);
-
 	rptr = hgsl_dbq_get_state_info((uint32_t *)dbq->vbase,
 			HGSL_DBQ_METADATA_QUEUE_INDEX, HGSL_DBQ_CONTEXT_ANY,
 			HGSL_DBQ_READ_INDEX_OFFSET_IN_DWORD);
@@ -456,7 +456,8 @@ static uint32_t db_queue_freedwords(struct doorbell_queue *dbq)
 	return (queue_size - queue_used - 1);
 }
 
-static int db_queue_wait_freewords(struct doorbell_queue *dbq, uint32_t size)
+static int db_queue_wait_freewords(struct doorbell_queue *dbq, uint32_t wptr,
+				uint32_t size)
 {
 	unsigned int retry_count = 0;
 	unsigned int hard_reset_req = false;
@@ -480,7 +481,7 @@ static int db_queue_wait_freewords(struct doorbell_queue *dbq, uint32_t size)
 			if (db_get_busy_state(dbq->vbase) == true)
 				db_set_busy_state(dbq->vbase, false);
 		} else {
-			if (db_queue_freedwords(dbq) >= size) {
+			if (db_queue_freedwords(dbq, wptr) >= size) {
 				db_set_busy_state(dbq->vbase, true);
 				return 0;
 			}
@@ -519,29 +520,77 @@ static void db_set_busy_state(void *dbq_base, int in_busy)
 	wmb();
 }
 
-static int db_send_msg(struct hgsl_priv  *priv,
-			struct db_msg_id *db_msg_id,
-			struct db_msg_request *msg_req,
-			struct db_msg_response *msg_resp)
+/*
+ * Copy one message into the doorbell queue at *wptr and advance *wptr.
+ * The new producer index is not published here, see db_send_msgs().
+ */
+static int db_queue_write_msg(struct doorbell_queue *dbq,
+			struct db_msg_request *msg_req, uint32_t *wptr)
 {
-	uint32_t msg_size_align;
-	int ret;
-	uint8_t *src, *dst;
+	uint32_t queue_size_dword = dbq->data.dwords;
+	uint32_t msg_size_align = ALIGN(msg_req->msg_dwords, 4);
 	uint32_t move_dwords, resid_move_dwords;
-	uint32_t queue_size_dword;
+	struct hgsl_db_cmds *cmds = msg_req->ptr_data;
+	uint8_t *src, *dst;
+	int ret;
+
+	ret = db_queue_wait_freewords(dbq, *wptr, msg_size_align);
+	if (ret < 0)
+		return ret;
+
+	move_dwords = msg_req->msg_dwords;
+	if ((msg_req->msg_dwords + *wptr) >= queue_size_dword) {
+		move_dwords = queue_size_dword - *wptr;
+		resid_move_dwords = msg_req->msg_dwords - move_dwords;
+		dst = (uint8_t *)dbq->data.vaddr;
+		src = msg_req->ptr_data + (move_dwords << 2);
+		memcpy(dst, src, (resid_move_dwords << 2));
+	}
+
+	dst = dbq->data.vaddr + (*wptr << 2);
+	src = msg_req->ptr_data;
+	memcpy(dst, src, (move_dwords << 2));
+
+	*wptr = (*wptr + msg_size_align) % queue_size_dword;
+
+	hgsl_dbq_set_state_info((uint32_t *)dbq->vbase,
+				HGSL_DBQ_METADATA_CONTEXT_INFO,
+				cmds->ctx_id,
+				HGSL_DBQ_CONTEXT_CONTEXT_ID_OFFSET_IN_DWORD,
+				cmds->ctx_id);
+
+	hgsl_dbq_set_state_info((uint32_t *)dbq->vbase,
+				HGSL_DBQ_METADATA_CONTEXT_INFO,
+				cmds->ctx_id,
+				HGSL_DBQ_CONTEXT_TIMESTAMP_OFFSET_IN_DWORD,
+				cmds->timestamp);
+
+	return 0;
+}
+
+/*
+ * Write up to count messages into the doorbell queue and ring the doorbell
+ * once for all of them. Requests without data are skipped. On return *sent
+ * holds the number of requests that were consumed, which is less than
+ * count only if the queue did not drain in time.
+ */
+static int db_send_msgs(struct hgsl_priv  *priv,
+			struct db_msg_request *msg_reqs, uint32_t count,
+			uint32_t *sent)
+{
+	int ret = 0;
 	struct qcom_hgsl *hgsl;
 	struct doorbell_queue *dbq;
-	uint32_t wptr;
-	struct hgsl_db_cmds *cmds;
+	uint32_t wptr, i, written = 0;
 	int retry_count = 0;
 	uint32_t hard_reset_req = false;
 
 	hgsl = priv->dev;
 	dbq = &hgsl->dbq[priv->dbq_idx];
+	*sent = 0;
 
 	mutex_lock(&dbq->lock);
 
-	cmds = (struct hgsl_db_cmds *)msg_req->ptr_data;
 	do {
 		hard_reset_req = hgsl_dbq_get_state_info((uint32_t *)dbq->vbase,
 		HGSL_DBQ_METADATA_COOPERATIVE_RESET,
@@ -562,52 +611,36 @@ static int db_send_msg(struct hgsl_priv  *priv,
 
 	db_set_busy_state(dbq->vbase, true);
 
-	queue_size_dword = dbq->data.dwords;
-	msg_size_align = ALIGN(msg_req->msg_dwords, 4);
-
-	ret = db_queue_wait_freewords(dbq, msg_size_align);
-	if (ret < 0) {
-		dev_err(hgsl->dev,
-			"Timed out waiting for queue to free up\n");
-		goto quit;
-	}
-
 	wptr = hgsl_dbq_get_state_info((uint32_t *)dbq->vbase,
 			HGSL_DBQ_METADATA_QUEUE_INDEX, HGSL_DBQ_CONTEXT_ANY,
 			HGSL_DBQ_WRITE_INDEX_OFFSET_IN_DWORD);
 
-	move_dwords = msg_req->msg_dwords;
-	if ((msg_req->msg_dwords + wptr) >= queue_size_dword) {
-		move_dwords = queue_size_dword - wptr;
-		resid_move_dwords = msg_req->msg_dwords - move_dwords;
-		dst = (uint8_t *)dbq->data.vaddr;
-		src = msg_req->ptr_data + (move_dwords << 2);
-		memcpy(dst, src, (resid_move_dwords << 2));
+	for (i = 0; i < count; i++) {
+		if (msg_reqs[i].ptr_data == NULL)
+			continue;
+
+		ret = db_queue_write_msg(dbq, &msg_reqs[i], &wptr);
+		if (ret < 0) {
+			dev_err(hgsl->dev,
+				"Timed out waiting for queue to free up\n");
+			break;
+		}
+		written++;
 	}
+	*sent = i;
 
-	dst = dbq->data.vaddr + (wptr << 2);
-	src = msg_req->ptr_data;
-	memcpy(dst, src, (move_dwords << 2));
+	if (!written)
+		goto quit;
+
+	/* messages must be in memory before the host can see the new wptr */
+	wmb();
 
-	wptr = (wptr + msg_size_align) % queue_size_dword;
 	hgsl_dbq_set_state_info((uint32_t *)dbq->vbase,
 				HGSL_DBQ_METADATA_QUEUE_INDEX,
 				HGSL_DBQ_CONTEXT_ANY,
 				HGSL_DBQ_WRITE_INDEX_OFFSET_IN_DWORD,
 							wptr);
 
-	hgsl_dbq_set_state_info((uint32_t *)dbq->vbase,
-				HGSL_DBQ_METADATA_CONTEXT_INFO,
-				cmds->ctx_id,
-				HGSL_DBQ_CONTEXT_CONTEXT_ID_OFFSET_IN_DWORD,
-				cmds->ctx_id);
-
-	hgsl_dbq_set_state_info((uint32_t *)dbq->vbase,
-				HGSL_DBQ_METADATA_CONTEXT_INFO,
-				((struct hgsl_db_cmds *)src)->ctx_id,
-				HGSL_DBQ_CONTEXT_TIMESTAMP_OFFSET_IN_DWORD,
-				((struct hgsl_db_cmds *)src)->timestamp);
-
 	/* confirm write to memory done before ring door bell. */
 	wmb();
 
@@ -625,29 +658,33 @@ static int db_send_msg(struct hgsl_priv  *priv,
 	return ret;
 }
 
-static int hgsl_db_issue_cmd(struct hgsl_priv  *priv,
+static int db_send_msg(struct hgsl_priv  *priv,
+			struct db_msg_id *db_msg_id,
+			struct db_msg_request *msg_req,
+			struct db_msg_response *msg_resp)
+{
+	uint32_t sent;
+
+	return db_send_msgs(priv, msg_req, 1, &sent);
+}
+
+/*
+ * Allocate an issue command message for num_ibs IBs and describe it in req.
+ * The caller fills in cmds->ib_descs and frees req->ptr_data.
+ */
+static struct hgsl_db_cmds *hgsl_db_alloc_cmd(struct hgsl_priv  *priv,
 			uint32_t ctx_id, uint32_t num_ibs,
 			uint32_t gmu_cmd_flags,
 			uint32_t timestamp,
-			struct hgsl_fw_ib_desc ib_descs[])
+			struct db_msg_request *req)
 {
-	int ret;
 	uint32_t msg_dwords;
 	uint32_t msg_buf_sz;
 	struct hgsl_db_cmds *cmds;
-	struct db_msg_request req;
-	struct db_msg_response resp;
-	struct db_msg_id db_msg_id;
 	struct doorbell_queue *dbq;
 	struct qcom_hgsl  *hgsl = priv->dev;
-	struct hgsl_context *ctxt;
 	uint32_t seq_num;
 
-	db_msg_id.msg_id = HTOF_MSG_ISSUE_CMD;
-	seq_num = atomic_inc_return(&hgsl->seq_num);
-	db_msg_id.seq_no = seq_num;
-
-	ctxt = hgsl->contexts[ctx_id];
 	dbq = &hgsl->dbq[priv->dbq_idx];
 
 	msg_dwords = MSG_ISSUE_INF_SZ() + MSG_ISSUE_IBS_SZ(num_ibs);
@@ -655,27 +692,57 @@ static int hgsl_db_issue_cmd(struct hgsl_priv  *priv,
 
 	if (msg_buf_sz > dbq->data.dwords) {
 		dev_err(hgsl->dev, "number of IBs exceed\n");
-		return -EINVAL;
+		return ERR_PTR(-EINVAL);
 	}
 
 	cmds = kmalloc(msg_buf_sz, GFP_KERNEL);
 	if (cmds == NULL)
-		return -ENOMEM;
+		return ERR_PTR(-ENOMEM);
+
+	seq_num = atomic_inc_return(&hgsl->seq_num);
 
 	cmds->header = (union hfi_msg_header)HFI_ISSUE_IB_HEADER(num_ibs,
 					msg_dwords,
-					db_msg_id.seq_no);
+					seq_num);
 	cmds->ctx_id = ctx_id;
 	cmds->num_ibs = num_ibs;
 	cmds->cmd_flags = gmu_cmd_flags;
 	cmds->timestamp = timestamp;
-	memcpy(cmds->ib_descs, ib_descs, sizeof(ib_descs[0]) * num_ibs);
 
-	req.msg_has_response = 0;
-	req.msg_has_ret_packet = 0;
-	req.ignore_ret_packet = 1;
-	req.msg_dwords = msg_dwords;
-	req.ptr_data = cmds;
+	req->msg_has_response = 0;
+	req->msg_has_ret_packet = 0;
+	req->ignore_ret_packet = 1;
+	req->msg_dwords = msg_dwords;
+	req->ptr_data = cmds;
+
+	return cmds;
+}
+
+static int hgsl_db_issue_cmd(struct hgsl_priv  *priv,
+			uint32_t ctx_id, uint32_t num_ibs,
+			uint32_t gmu_cmd_flags,
+			uint32_t timestamp,
+			struct hgsl_fw_ib_desc ib_descs[])
+{
+	int ret;
+	struct hgsl_db_cmds *cmds;
+	struct db_msg_request req;
+	struct db_msg_response resp;
+	struct db_msg_id db_msg_id;
+	struct qcom_hgsl  *hgsl = priv->dev;
+	struct hgsl_context *ctxt;
+
+	ctxt = hgsl->contexts[ctx_id];
+
+	cmds = hgsl_db_alloc_cmd(priv, ctx_id, num_ibs, gmu_cmd_flags,
+				timestamp, &req);
+	if (IS_ERR(cmds))
+		return PTR_ERR(cmds);
+
+	db_msg_id.msg_id = HTOF_MSG_ISSUE_CMD;
+	db_msg_id.seq_no = MSG_SEQ_NO_GET(cmds->header.u32_all);
+
+	memcpy(cmds->ib_descs, ib_descs, sizeof(ib_descs[0]) * num_ibs);
 
 	if (!ctxt->is_killed) {
 		ret = db_send_msg(priv, &db_msg_id, &req, &resp);
@@ -793,6 +860,146 @@ static int hgsl_cmdstream_db_issueib(struct file *filep,
 	return ret;
 }
 
+/*
+ * Issue several submissions with one pass over the doorbell queue: the
+ * queue lock, the cooperative reset handshake and the doorbell itself are
+ * paid for once per batch instead of once per submission.
+ */
+static int hgsl_cmdstream_db_issueib_batch(struct file *filep,
+				       unsigned long arg)
+{
+	struct hgsl_priv *priv = filep->private_data;
+	struct qcom_hgsl *hgsl = priv->dev;
+	struct hgsl_fhi_issue_cmds_batch batch;
+	struct hgsl_fhi_issud_cmds *submits = NULL;
+	struct hgsl_fhi_issud_cmds *submit;
+	struct db_msg_request *reqs = NULL;
+	struct hgsl_context **ctxts = NULL;
+	struct hgsl_ibdesc *ibs = NULL;
+	struct hgsl_db_cmds *cmds;
+	bool signal = false;
+	uint32_t i, idx, sent = 0;
+	int ret = 0;
+
+	if (hgsl->db_off) {
+		dev_err(hgsl->dev, "Doorbell not open\n");
+		return -EPERM;
+	}
+
+	if (copy_from_user(&batch, USRPTR(arg), sizeof(batch)))
+		return -EFAULT;
+
+	if (!hgsl_ctx_dbq_ready(priv)) {
+		dev_err(hgsl->dev, "Doorbell invalid\n");
+		return -EINVAL;
+	}
+
+	if (batch.num_cmds == 0 || batch.num_cmds > HGSL_ISSUE_CMDS_BATCH_MAX)
+		return -EINVAL;
+
+	submits = kcalloc(batch.num_cmds, sizeof(*submits), GFP_KERNEL);
+	reqs = kcalloc(batch.num_cmds, sizeof(*reqs), GFP_KERNEL);
+	ctxts = kcalloc(batch.num_cmds, sizeof(*ctxts), GFP_KERNEL);
+	if (!submits || !reqs || !ctxts) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	if (copy_from_user(submits, USRPTR(batch.cmds),
+			sizeof(*submits) * batch.num_cmds)) {
+		ret = -EFAULT;
+		goto exit;
+	}
+
+	for (i = 0; i < batch.num_cmds; i++) {
+		submit = &submits[i];
+
+		if (submit->num_ibs == 0)
+			continue;
+
+		if (submit->context_id >= HGSL_CONTEXT_NUM) {
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		read_lock(&hgsl->ctxt_lock);
+		ctxts[i] = hgsl->contexts[submit->context_id];
+		read_unlock(&hgsl->ctxt_lock);
+		if (ctxts[i] == NULL) {
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		ibs = kmalloc_array(submit->num_ibs, sizeof(*ibs), GFP_KERNEL);
+		if (ibs == NULL) {
+			ret = -ENOMEM;
+			goto exit;
+		}
+
+		if (copy_from_user(ibs, USRPTR(submit->ibs),
+				sizeof(ibs[0]) * submit->num_ibs)) {
+			ret = -EFAULT;
+			goto exit;
+		}
+
+		cmds = hgsl_db_alloc_cmd(priv, submit->context_id,
+					submit->num_ibs, CMDBATCH_NOTIFY,
+					submit->timestamp, &reqs[i]);
+		if (IS_ERR(cmds)) {
+			ret = PTR_ERR(cmds);
+			goto exit;
+		}
+
+		for (idx = 0; idx < submit->num_ibs; ++idx) {
+			cmds->ib_descs[idx].addr = ibs[idx].gpuaddr;
+			cmds->ib_descs[idx].sz = ibs[idx].sizedwords << 2;
+		}
+
+		kfree(ibs);
+		ibs = NULL;
+
+		if (ctxts[i]->is_killed) {
+			/* Retire ts immediately*/
+			set_context_timestamp(ctxts[i], submit->timestamp);
+			kfree(reqs[i].ptr_data);
+			reqs[i].ptr_data = NULL;
+			signal = true;
+		}
+	}
+
+	ret = db_send_msgs(priv, reqs, batch.num_cmds, &sent);
+
+	for (i = 0; i < sent; i++) {
+		if (ctxts[i])
+			ctxts[i]->queued_ts = submits[i].timestamp;
+	}
+
+	batch.num_submitted = sent;
+	if (copy_to_user(USRPTR(arg), &batch, sizeof(batch)) && !ret)
+		ret = -EFAULT;
+
+exit:
+	/* Trigger event to waitfor ts thread */
+	if (signal)
+		_signal_contexts(hgsl);
+
+	if (ret)
+		dev_err(hgsl->dev, "batch issueib failed after %u of %u\n",
+			sent, batch.num_cmds);
+
+	if (reqs) {
+		for (i = 0; i < batch.num_cmds; i++)
+			kfree(reqs[i].ptr_data);
+	}
+
+	kfree(ibs);
+	kfree(ctxts);
+	kfree(reqs);
+	kfree(submits);
+
+	return ret;
+}
+
 static int hgsl_dbq_get_state(struct file *filep,
 				 unsigned long arg)
 {
@@ -1622,6 +1829,9 @@ static long hgsl_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 	case HGSL_IOCTL_ISSUE_CMDS:
 		ret = hgsl_cmdstream_db_issueib(filep, arg);
 		break;
+	case HGSL_IOCTL_ISSUE_CMDS_BATCH:
+		ret = hgsl_cmdstream_db_issueib_batch(filep, arg);
+		break;
 	case HGSL_IOCTL_DBQ_GETSTATE:
 		ret = hgsl_dbq_get_state(filep, arg);
 		break;
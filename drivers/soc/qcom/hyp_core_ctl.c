@@ -22,6 +22,8 @@
 #include <linux/pm_qos.h>
 #include <linux/cpufreq.h>
 #include <linux/sched/sysctl.h>
+#include <linux/sched/core_ctl.h>
+#include <linux/sched/clock.h>
 
 #include <linux/haven/hcall.h>
 #include <linux/haven/hh_errno.h>
@@ -31,6 +33,8 @@
 #define SVM_STATE_RUNNING 1
 #define SVM_STATE_CPUS_SUSPENDED 2
 #define SVM_STATE_SYSTEM_SUSPENDED 3
+#define DEMAND_UP_PCT_DEFAULT 60
+#define DEMAND_DOWN_PCT_DEFAULT 20
 
 static DEFINE_PER_CPU(struct freq_qos_request, qos_min_req);
 static DEFINE_PER_CPU(unsigned int, qos_min_freq);
@@ -43,12 +47,23 @@ unsigned int sysctl_hh_suspend_timeout_ms = 1000;
  * @curr_pcpu: The current physical CPU number corresponding to this vcpu.
  *             The curr_pcu is set to another CPU when the original assigned
  *             CPU i.e pcpu can't be used due to thermal condition.
+ * @busy: The vcpu load is high enough to need a dedicated physical CPU
+ *        in the demand mode.
+ * @load_pct: The last load of this vcpu reported by the hypervisor.
+ * @steal_ns: The cumulative steal time of this vcpu.
+ * @steal_pct: The steal time over the last report interval in percent.
+ * @report_ns: The time of the last report.
  *
  */
 struct hyp_core_ctl_cpu_map {
 	hh_capid_t cap_id;
 	hh_label_t pcpu;
 	hh_label_t curr_pcpu;
+	bool busy;
+	u32 load_pct;
+	u64 steal_ns;
+	u32 steal_pct;
+	u64 report_ns;
 };
 
 /**
@@ -64,6 +79,12 @@ struct hyp_core_ctl_cpu_map {
  * @reserve_cpus: The CPUs to be reserved. input.
  * @our_isolated_cpus: The CPUs isolated by hyp_core_ctl driver. output.
  * @final_reserved_cpus: The CPUs reserved for the Hypervisor. output.
+ * @demand_mode: Reserve only the physical CPUs of the busy vcpus
+ *               instead of reserve_cpus. input.
+ * @demand_active: The demand mode as applied by the state machine.
+ * @demand_up_pct: The vcpu load at or above which a vcpu becomes busy.
+ * @demand_down_pct: The vcpu load at or below which a vcpu is not busy.
+ * @demand_cpus: The CPUs to be reserved in the demand mode.
  * @cpumap: The vcpu to pcpu mapping table
  */
 struct hyp_core_ctl_data {
@@ -75,6 +96,11 @@ struct hyp_core_ctl_data {
 	cpumask_t reserve_cpus;
 	cpumask_t our_isolated_cpus;
 	cpumask_t final_reserved_cpus;
+	bool demand_mode;
+	bool demand_active;
+	unsigned int demand_up_pct;
+	unsigned int demand_down_pct;
+	cpumask_t demand_cpus;
 	struct hyp_core_ctl_cpu_map cpumap[NR_CPUS];
 };
 
@@ -104,6 +130,12 @@ static inline void hyp_core_ctl_print_status(char *msg)
 		cpumask_pr_args(cpu_cooling_get_max_level_cpumask()));
 }
 
+static inline const cpumask_t *
+hyp_core_ctl_reserve_mask(struct hyp_core_ctl_data *hcd)
+{
+	return hcd->demand_active ? &hcd->demand_cpus : &hcd->reserve_cpus;
+}
+
 static void hyp_core_ctl_undo_reservation(struct hyp_core_ctl_data *hcd)
 {
 	int cpu, ret;
@@ -153,7 +185,8 @@ static void finalize_reservation(struct hyp_core_ctl_data *hcd, cpumask_t *temp)
 	 *
 	 * This may only happen when thermal isolate more CPUs.
 	 */
-	if (cpumask_weight(temp) < cpumask_weight(&hcd->reserve_cpus)) {
+	if (cpumask_weight(temp) <
+			cpumask_weight(hyp_core_ctl_reserve_mask(hcd))) {
 		pr_debug("Fail to reserve some CPUs\n");
 		return;
 	}
@@ -179,6 +212,15 @@ static void finalize_reservation(struct hyp_core_ctl_data *hcd, cpumask_t *temp)
 		orig_cpu = hcd->cpumap[i].pcpu;
 		curr_cpu = hcd->cpumap[i].curr_pcpu;
 
+		/*
+		 * In the demand mode, an idle vcpu has no physical CPU
+		 * reserved. It stays on its current physical CPU and
+		 * shares it with the host.
+		 */
+		if (hcd->demand_active &&
+		    !cpumask_test_cpu(orig_cpu, &hcd->demand_cpus))
+			continue;
+
 		if (cpumask_test_cpu(orig_cpu, &hcd->final_reserved_cpus)) {
 			cpumask_clear_cpu(orig_cpu, temp);
 
@@ -256,9 +298,10 @@ static void finalize_reservation(struct hyp_core_ctl_data *hcd, cpumask_t *temp)
 
 static void hyp_core_ctl_do_reservation(struct hyp_core_ctl_data *hcd)
 {
-	cpumask_t offline_cpus, iter_cpus, temp_reserved_cpus;
-	int i, ret, iso_required, iso_done;
+	cpumask_t offline_cpus, iter_cpus, temp_reserved_cpus, host_isolated;
+	int i, ret, iso_required, iso_done, pass;
 	const cpumask_t *thermal_cpus = cpu_cooling_get_max_level_cpumask();
+	const cpumask_t *reserve_cpus = hyp_core_ctl_reserve_mask(hcd);
 	struct freq_qos_request *qos_req;
 	unsigned int min_freq;
 
@@ -273,7 +316,7 @@ static void hyp_core_ctl_do_reservation(struct hyp_core_ctl_data *hcd)
 	 * reserved. When an offline and reserved CPU comes online, it
 	 * will be isolated to honor the reservation.
 	 */
-	cpumask_andnot(&iter_cpus, &hcd->reserve_cpus, &hcd->our_isolated_cpus);
+	cpumask_andnot(&iter_cpus, reserve_cpus, &hcd->our_isolated_cpus);
 	cpumask_andnot(&iter_cpus, &iter_cpus, thermal_cpus);
 
 	for_each_cpu(i, &iter_cpus) {
@@ -300,7 +343,7 @@ static void hyp_core_ctl_do_reservation(struct hyp_core_ctl_data *hcd)
 		}
 	}
 
-	cpumask_andnot(&iter_cpus, &hcd->reserve_cpus, &offline_cpus);
+	cpumask_andnot(&iter_cpus, reserve_cpus, &offline_cpus);
 	iso_required = cpumask_weight(&iter_cpus);
 	iso_done = cpumask_weight(&hcd->our_isolated_cpus);
 
@@ -340,28 +383,38 @@ static void hyp_core_ctl_do_reservation(struct hyp_core_ctl_data *hcd)
 
 		cpumask_andnot(&iter_cpus, &iter_cpus, &offline_cpus);
 
-		for_each_cpu(i, &iter_cpus) {
-			ret = sched_isolate_cpu(i);
-			if (ret < 0) {
-				pr_debug("fail to isolate CPU%d. ret=%d\n",
-						i, ret);
-				continue;
-			}
-
-			cpumask_set_cpu(i, &hcd->our_isolated_cpus);
-
-			min_freq = per_cpu(qos_min_freq, i);
-			if (min_freq && freq_qos_init_done) {
-				qos_req = &per_cpu(qos_min_req, i);
-				ret = freq_qos_update_request(qos_req,
+		/*
+		 * The CPUs isolated by core_ctl are not used by the host
+		 * either. Pick them before taking an active CPU away.
+		 */
+		core_ctl_get_isolated_cpus(&host_isolated);
+		cpumask_and(&host_isolated, &host_isolated, &iter_cpus);
+		cpumask_andnot(&iter_cpus, &iter_cpus, &host_isolated);
+
+		for (pass = 0; pass < 2; pass++) {
+			for_each_cpu(i, pass ? &iter_cpus : &host_isolated) {
+				ret = sched_isolate_cpu(i);
+				if (ret < 0) {
+					pr_debug("fail to isolate CPU%d. ret=%d\n",
+							i, ret);
+					continue;
+				}
+
+				cpumask_set_cpu(i, &hcd->our_isolated_cpus);
+
+				min_freq = per_cpu(qos_min_freq, i);
+				if (min_freq && freq_qos_init_done) {
+					qos_req = &per_cpu(qos_min_req, i);
+					ret = freq_qos_update_request(qos_req,
 								min_freq);
-				if (ret < 0)
-					pr_err("fail to update min freq for CPU%d ret=%d\n",
+					if (ret < 0)
+						pr_err("fail to update min freq for CPU%d ret=%d\n",
 								i, ret);
-			}
+				}
 
-			if (--isolate_need == 0)
-				break;
+				if (--isolate_need == 0)
+					goto done;
+			}
 		}
 	} else if (iso_done > iso_required) {
 		int unisolate_need;
@@ -386,7 +439,7 @@ static void hyp_core_ctl_do_reservation(struct hyp_core_ctl_data *hcd)
 		 */
 		unisolate_need = iso_done - iso_required;
 		cpumask_andnot(&iter_cpus, &hcd->our_isolated_cpus,
-			       &hcd->reserve_cpus);
+			       reserve_cpus);
 		for_each_cpu(i, &iter_cpus) {
 			ret = sched_unisolate_cpu(i);
 			if (ret < 0) {
@@ -418,6 +471,30 @@ static void hyp_core_ctl_do_reservation(struct hyp_core_ctl_data *hcd)
 	hyp_core_ctl_print_status("reservation_end");
 }
 
+/*
+ * Build the demand mode reserve mask from the busy vcpus. The busy state
+ * is updated from hh_vcpu_report_load() under the lock, so take a
+ * snapshot here for the rest of this reservation pass.
+ */
+static void hyp_core_ctl_update_demand(struct hyp_core_ctl_data *hcd)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&hcd->lock, flags);
+	hcd->demand_active = hcd->demand_mode;
+	cpumask_clear(&hcd->demand_cpus);
+
+	for (i = 0; i < MAX_RESERVE_CPUS; i++) {
+		if (hcd->cpumap[i].cap_id == 0)
+			break;
+
+		if (hcd->cpumap[i].busy)
+			cpumask_set_cpu(hcd->cpumap[i].pcpu, &hcd->demand_cpus);
+	}
+	spin_unlock_irqrestore(&hcd->lock, flags);
+}
+
 static int hyp_core_ctl_thread(void *data)
 {
 	struct hyp_core_ctl_data *hcd = data;
@@ -448,10 +525,14 @@ static int hyp_core_ctl_thread(void *data)
 		 * not enabled, since there is no need for isolating.
 		 */
 		mutex_lock(&hcd->reservation_mutex);
-		if (hcd->reservation_enabled)
+		if (hcd->reservation_enabled) {
+			hyp_core_ctl_update_demand(hcd);
 			hyp_core_ctl_do_reservation(hcd);
-		else
+		} else {
+			hcd->demand_active = false;
 			hyp_core_ctl_undo_reservation(hcd);
+		}
+		core_ctl_set_reserved_cpus(&hcd->our_isolated_cpus);
 		mutex_unlock(&hcd->reservation_mutex);
 	}
 
@@ -568,7 +649,7 @@ static int hyp_core_ctl_cpu_cooling_cb(struct notifier_block *nb,
 		 *     thermal unblocked a CPU, swap this with one of the
 		 *     thermal mitigated CPU that is currently reserved.
 		 */
-		if (!cpumask_test_cpu(cpu, &the_hcd->reserve_cpus) &&
+		if (!cpumask_test_cpu(cpu, hyp_core_ctl_reserve_mask(the_hcd)) &&
 		    !cpumask_intersects(&the_hcd->final_reserved_cpus,
 		    thermal_cpus))
 			goto out;
@@ -696,6 +777,64 @@ int hh_vcpu_populate_affinity_info(u32 cpu_idx, u64 cap_id)
 	return 0;
 }
 
+/*
+ * Called with the load and the cumulative steal time of a guest vcpu as
+ * reported by the hypervisor. In the demand mode, the state machine is
+ * kicked when a vcpu crosses the busy thresholds so that its physical
+ * CPU is reserved or released.
+ */
+int hh_vcpu_report_load(u64 cap_id, u32 load_pct, u64 steal_ns)
+{
+	struct hyp_core_ctl_data *hcd = the_hcd;
+	struct hyp_core_ctl_cpu_map *map;
+	unsigned long flags;
+	u64 now = sched_clock();
+	bool busy;
+	int i;
+
+	if (!init_done || !is_vcpu_info_populated)
+		return -EAGAIN;
+
+	spin_lock_irqsave(&hcd->lock, flags);
+	for (i = 0; i < MAX_RESERVE_CPUS; i++) {
+		if (hcd->cpumap[i].cap_id == 0 ||
+		    hcd->cpumap[i].cap_id == cap_id)
+			break;
+	}
+
+	if (i == MAX_RESERVE_CPUS || hcd->cpumap[i].cap_id == 0) {
+		spin_unlock_irqrestore(&hcd->lock, flags);
+		return -EINVAL;
+	}
+
+	map = &hcd->cpumap[i];
+	if (map->report_ns && now > map->report_ns &&
+	    steal_ns >= map->steal_ns)
+		map->steal_pct = min_t(u64, 100,
+			div64_u64((steal_ns - map->steal_ns) * 100,
+				  now - map->report_ns));
+	map->steal_ns = steal_ns;
+	map->report_ns = now;
+	map->load_pct = load_pct;
+
+	busy = map->busy;
+	if (load_pct >= hcd->demand_up_pct)
+		busy = true;
+	else if (load_pct <= hcd->demand_down_pct)
+		busy = false;
+
+	if (busy != map->busy) {
+		map->busy = busy;
+		if (hcd->demand_mode && hcd->reservation_enabled) {
+			hcd->pending = true;
+			wake_up_process(hcd->task);
+		}
+	}
+	spin_unlock_irqrestore(&hcd->lock, flags);
+
+	return 0;
+}
+
 static int hh_vcpu_done_populate_affinity_info(struct notifier_block *nb,
 						unsigned long cmd, void *data)
 {
@@ -858,6 +997,11 @@ static ssize_t status_show(struct device *dev, struct device_attribute *attr,
 	count = scnprintf(buf, PAGE_SIZE, "enabled=%d\n",
 			  hcd->reservation_enabled);
 
+	count += scnprintf(buf + count, PAGE_SIZE - count,
+			   "demand_mode=%d demand_cpus=%*pbl\n",
+			   hcd->demand_active,
+			   cpumask_pr_args(&hcd->demand_cpus));
+
 	count += scnprintf(buf + count, PAGE_SIZE - count,
 			   "reserve_cpus=%*pbl\n",
 			   cpumask_pr_args(&hcd->reserve_cpus));
@@ -890,8 +1034,11 @@ static ssize_t status_show(struct device *dev, struct device_attribute *attr,
 			break;
 
 		count += scnprintf(buf + count, PAGE_SIZE - count,
-			 "vcpu=%d pcpu=%u curr_pcpu=%u\n",
-			 i, hcd->cpumap[i].pcpu, hcd->cpumap[i].curr_pcpu);
+			 "vcpu=%d pcpu=%u curr_pcpu=%u busy=%d load=%u steal_ms=%llu steal_pct=%u\n",
+			 i, hcd->cpumap[i].pcpu, hcd->cpumap[i].curr_pcpu,
+			 hcd->cpumap[i].busy, hcd->cpumap[i].load_pct,
+			 div_u64(hcd->cpumap[i].steal_ns, NSEC_PER_MSEC),
+			 hcd->cpumap[i].steal_pct);
 
 	}
 
@@ -902,6 +1049,69 @@ static ssize_t status_show(struct device *dev, struct device_attribute *attr,
 
 static DEVICE_ATTR_RO(status);
 
+static ssize_t demand_mode_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	unsigned long flags;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool(buf, &enable);
+	if (ret < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&the_hcd->lock, flags);
+	if (enable != the_hcd->demand_mode) {
+		the_hcd->demand_mode = enable;
+		if (the_hcd->reservation_enabled) {
+			the_hcd->pending = true;
+			wake_up_process(the_hcd->task);
+		}
+	}
+	spin_unlock_irqrestore(&the_hcd->lock, flags);
+
+	return count;
+}
+
+static ssize_t demand_mode_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", the_hcd->demand_mode);
+}
+
+static DEVICE_ATTR_RW(demand_mode);
+
+static ssize_t demand_thres_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	unsigned int up, down;
+	unsigned long flags;
+
+	if (sscanf(buf, "%u %u", &up, &down) != 2)
+		return -EINVAL;
+
+	if (up > 100 || down >= up)
+		return -EINVAL;
+
+	spin_lock_irqsave(&the_hcd->lock, flags);
+	the_hcd->demand_up_pct = up;
+	the_hcd->demand_down_pct = down;
+	spin_unlock_irqrestore(&the_hcd->lock, flags);
+
+	return count;
+}
+
+static ssize_t demand_thres_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u %u\n", the_hcd->demand_up_pct,
+			 the_hcd->demand_down_pct);
+}
+
+static DEVICE_ATTR_RW(demand_thres);
+
 static int init_freq_qos_req(void)
 {
 	int cpu, ret;
@@ -1008,6 +1218,8 @@ static struct attribute *hyp_core_ctl_attrs[] = {
 	&dev_attr_enable.attr,
 	&dev_attr_status.attr,
 	&dev_attr_hcc_min_freq.attr,
+	&dev_attr_demand_mode.attr,
+	&dev_attr_demand_thres.attr,
 	NULL
 };
 
@@ -1114,6 +1326,8 @@ static int hyp_core_ctl_probe(struct platform_device *pdev)
 
 	spin_lock_init(&hcd->lock);
 	mutex_init(&hcd->reservation_mutex);
+	hcd->demand_up_pct = DEMAND_UP_PCT_DEFAULT;
+	hcd->demand_down_pct = DEMAND_DOWN_PCT_DEFAULT;
 	hcd->task = kthread_run(hyp_core_ctl_thread, (void *) hcd,
 				"hyp_core_ctl");
 
@@ -424,6 +424,30 @@ static int icnss_stats_show_state(struct seq_file *s, struct icnss_priv *priv)
 	return 0;
 }
 
+static int icnss_stats_show_rx_pools(struct seq_file *s,
+				     struct icnss_priv *priv)
+{
+	struct icnss_rx_pool *pool;
+	int i;
+
+	seq_puts(s, "\n<------------------ RX pool stats ------------------->\n");
+	seq_printf(s, "%4s %6s %6s %10s %10s %10s %10s %8s\n", "Ring",
+		   "Bufs", "Free", "Map", "Unmap", "Get", "Put", "Empty");
+
+	mutex_lock(&priv->rx_pool_lock);
+	for (i = 0; i < ICNSS_MAX_RX_POOLS; i++) {
+		pool = priv->rx_pool[i];
+		if (!pool)
+			continue;
+		seq_printf(s, "%4d %6u %6u %10u %10u %10u %10u %8u\n", i,
+			   pool->nr_bufs, pool->nr_free, pool->map,
+			   pool->unmap, pool->get, pool->put, pool->empty);
+	}
+	mutex_unlock(&priv->rx_pool_lock);
+
+	return 0;
+}
+
 #define ICNSS_STATS_DUMP(_s, _priv, _x) \
 	seq_printf(_s, "%24s: %u\n", #_x, _priv->stats._x)
 
@@ -486,6 +510,8 @@ static int icnss_stats_show(struct seq_file *s, void *data)
 
 	icnss_stats_show_irqs(s, priv);
 
+	icnss_stats_show_rx_pools(s, priv);
+
 	icnss_stats_show_capability(s, priv);
 
 	icnss_stats_show_events(s, priv);
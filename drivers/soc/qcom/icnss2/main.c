@@ -3166,6 +3166,183 @@ int icnss_smmu_unmap(struct device *dev,
 }
 EXPORT_SYMBOL(icnss_smmu_unmap);
 
+static void icnss_rx_pool_free(struct device *dev, struct icnss_rx_pool *pool)
+{
+	unsigned int i;
+
+	for (i = 0; i < pool->nr_bufs; i++) {
+		if (!pool->vaddr[i])
+			continue;
+		if (pool->iova[i]) {
+			dma_unmap_single_attrs(dev, pool->iova[i],
+					       pool->buf_size, DMA_FROM_DEVICE,
+					       DMA_ATTR_SKIP_CPU_SYNC);
+			pool->unmap++;
+		}
+		kfree(pool->vaddr[i]);
+	}
+	kfree(pool->free_idx);
+	kfree(pool->vaddr);
+	kfree(pool->iova);
+	kfree(pool);
+}
+
+/*
+ * Allocate and SMMU-map @nr_bufs RX buffers of @buf_size for @ring_id
+ * once, so the host driver can recycle them with icnss_rx_buf_get/put()
+ * instead of mapping and unmapping every received packet.
+ */
+int icnss_rx_pool_create(struct device *dev, unsigned int ring_id,
+			 unsigned int nr_bufs, size_t buf_size)
+{
+	struct icnss_priv *priv = dev_get_drvdata(dev);
+	struct icnss_rx_pool *pool;
+	unsigned int i;
+	int ret = 0;
+
+	if (!priv || ring_id >= ICNSS_MAX_RX_POOLS || !nr_bufs || !buf_size)
+		return -EINVAL;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return -ENOMEM;
+
+	spin_lock_init(&pool->lock);
+	pool->nr_bufs = nr_bufs;
+	pool->buf_size = buf_size;
+	pool->free_idx = kcalloc(nr_bufs, sizeof(*pool->free_idx), GFP_KERNEL);
+	pool->vaddr = kcalloc(nr_bufs, sizeof(*pool->vaddr), GFP_KERNEL);
+	pool->iova = kcalloc(nr_bufs, sizeof(*pool->iova), GFP_KERNEL);
+	if (!pool->free_idx || !pool->vaddr || !pool->iova) {
+		ret = -ENOMEM;
+		goto out_free;
+	}
+
+	for (i = 0; i < nr_bufs; i++) {
+		pool->vaddr[i] = kmalloc(buf_size, GFP_KERNEL);
+		if (!pool->vaddr[i]) {
+			ret = -ENOMEM;
+			goto out_free;
+		}
+		pool->iova[i] = dma_map_single(dev, pool->vaddr[i], buf_size,
+					       DMA_FROM_DEVICE);
+		if (dma_mapping_error(dev, pool->iova[i])) {
+			pool->iova[i] = 0;
+			ret = -ENOMEM;
+			goto out_free;
+		}
+		pool->map++;
+		pool->free_idx[pool->nr_free++] = i;
+	}
+
+	mutex_lock(&priv->rx_pool_lock);
+	if (priv->rx_pool[ring_id]) {
+		mutex_unlock(&priv->rx_pool_lock);
+		ret = -EEXIST;
+		goto out_free;
+	}
+	priv->rx_pool[ring_id] = pool;
+	mutex_unlock(&priv->rx_pool_lock);
+
+	icnss_pr_dbg("RX pool %u: %u buffers of %zu bytes mapped\n",
+		     ring_id, nr_bufs, buf_size);
+	return 0;
+
+out_free:
+	icnss_pr_err("Failed to create RX pool %u, err %d\n", ring_id, ret);
+	icnss_rx_pool_free(dev, pool);
+	return ret;
+}
+EXPORT_SYMBOL(icnss_rx_pool_create);
+
+/* All buffers must have been returned and the ring quiesced */
+void icnss_rx_pool_destroy(struct device *dev, unsigned int ring_id)
+{
+	struct icnss_priv *priv = dev_get_drvdata(dev);
+	struct icnss_rx_pool *pool;
+
+	if (!priv || ring_id >= ICNSS_MAX_RX_POOLS)
+		return;
+
+	mutex_lock(&priv->rx_pool_lock);
+	pool = priv->rx_pool[ring_id];
+	priv->rx_pool[ring_id] = NULL;
+	mutex_unlock(&priv->rx_pool_lock);
+
+	if (!pool)
+		return;
+
+	if (pool->nr_free != pool->nr_bufs)
+		icnss_pr_err("RX pool %u destroyed with %u buffers in use\n",
+			     ring_id, pool->nr_bufs - pool->nr_free);
+	icnss_rx_pool_free(dev, pool);
+}
+EXPORT_SYMBOL(icnss_rx_pool_destroy);
+
+/*
+ * Take a free pre-mapped buffer to post on the ring. It is handed over
+ * in device ownership; sync it for the CPU once the hardware filled it.
+ */
+int icnss_rx_buf_get(struct device *dev, unsigned int ring_id,
+		     struct icnss_rx_buf *buf)
+{
+	struct icnss_priv *priv = dev_get_drvdata(dev);
+	struct icnss_rx_pool *pool;
+	unsigned long flags;
+	unsigned int idx;
+
+	if (!priv || ring_id >= ICNSS_MAX_RX_POOLS || !buf)
+		return -EINVAL;
+
+	pool = priv->rx_pool[ring_id];
+	if (!pool)
+		return -ENOENT;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (!pool->nr_free) {
+		pool->empty++;
+		spin_unlock_irqrestore(&pool->lock, flags);
+		return -ENOMEM;
+	}
+	idx = pool->free_idx[--pool->nr_free];
+	pool->get++;
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	dma_sync_single_for_device(dev, pool->iova[idx], pool->buf_size,
+				   DMA_FROM_DEVICE);
+
+	buf->vaddr = pool->vaddr[idx];
+	buf->iova = pool->iova[idx];
+	buf->idx = idx;
+	return 0;
+}
+EXPORT_SYMBOL(icnss_rx_buf_get);
+
+void icnss_rx_buf_put(struct device *dev, unsigned int ring_id,
+		      unsigned int idx)
+{
+	struct icnss_priv *priv = dev_get_drvdata(dev);
+	struct icnss_rx_pool *pool;
+	unsigned long flags;
+
+	if (!priv || ring_id >= ICNSS_MAX_RX_POOLS)
+		return;
+
+	pool = priv->rx_pool[ring_id];
+	if (!pool || idx >= pool->nr_bufs)
+		return;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (WARN_ON(pool->nr_free >= pool->nr_bufs)) {
+		spin_unlock_irqrestore(&pool->lock, flags);
+		return;
+	}
+	pool->free_idx[pool->nr_free++] = idx;
+	pool->put++;
+	spin_unlock_irqrestore(&pool->lock, flags);
+}
+EXPORT_SYMBOL(icnss_rx_buf_put);
+
 unsigned int icnss_socinfo_get_serial_number(struct device *dev)
 {
 	return socinfo_get_serial_number();
@@ -4072,6 +4249,7 @@ static int icnss_probe(struct platform_device *pdev)
 	spin_lock_init(&priv->soc_wake_msg_lock);
 	mutex_init(&priv->dev_lock);
 	mutex_init(&priv->tcdev_lock);
+	mutex_init(&priv->rx_pool_lock);
 
 	priv->event_wq = alloc_workqueue("icnss_driver_event", WQ_UNBOUND, 1);
 	if (!priv->event_wq) {
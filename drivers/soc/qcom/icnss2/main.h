@@ -354,6 +354,24 @@ struct icnss_dms_data {
 	u8 mac[QMI_WLFW_MAC_ADDR_SIZE_V01];
 };
 
+#define ICNSS_MAX_RX_POOLS 8
+
+/* Pre-mapped RX buffers of one ring, recycled through a free index stack */
+struct icnss_rx_pool {
+	spinlock_t lock;
+	unsigned int nr_bufs;
+	size_t buf_size;
+	unsigned int nr_free;
+	unsigned int *free_idx;
+	void **vaddr;
+	dma_addr_t *iova;
+	uint32_t map;
+	uint32_t unmap;
+	uint32_t get;
+	uint32_t put;
+	uint32_t empty;
+};
+
 struct icnss_priv {
 	uint32_t magic;
 	struct platform_device *pdev;
@@ -466,6 +484,8 @@ struct icnss_priv {
 	void *hang_event_data;
 	struct list_head icnss_tcdev_list;
 	struct mutex tcdev_lock;
+	struct mutex rx_pool_lock;
+	struct icnss_rx_pool *rx_pool[ICNSS_MAX_RX_POOLS];
 	bool is_chain1_supported;
 	bool chain_reg_info_updated;
 	u32 hw_trc_override;
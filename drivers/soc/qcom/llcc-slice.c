@@ -27,6 +27,7 @@
 #define ATTR1_FIXED_SIZE_SHIFT        0x03
 #define ATTR1_PRIORITY_SHIFT          0x04
 #define ATTR1_MAX_CAP_SHIFT           0x10
+#define ATTR1_MAX_CAP_MASK            GENMASK(31, 16)
 #define ATTR0_RES_WAYS_MASK           GENMASK(11, 0)
 #define ATTR0_BONUS_WAYS_MASK         GENMASK(27, 16)
 #define ATTR0_BONUS_WAYS_SHIFT        0x10
@@ -252,6 +253,41 @@ size_t llcc_get_slice_size(struct llcc_slice_desc *desc)
 }
 EXPORT_SYMBOL_GPL(llcc_get_slice_size);
 
+/**
+ * llcc_slice_set_max_cap - change the capacity limit of a slice
+ * @slice_id: llcc slice id
+ * @max_cap: new capacity limit in KB
+ *
+ * Reprograms only the max capacity of the slice, the way reservation and
+ * the other attributes from the SoC table are left untouched. A value of
+ * zero will be returned on success and a negative errno will be returned
+ * in error cases
+ */
+int llcc_slice_set_max_cap(u32 slice_id, u32 max_cap)
+{
+	u32 max_cap_cacheline;
+	int ret;
+
+	if (IS_ERR(drv_data))
+		return PTR_ERR(drv_data);
+
+	if (slice_id > drv_data->max_slices || !max_cap)
+		return -EINVAL;
+
+	max_cap_cacheline = MAX_CAP_TO_BYTES(max_cap) / drv_data->num_banks;
+	max_cap_cacheline >>= CACHE_LINE_SIZE_SHIFT;
+
+	mutex_lock(&drv_data->lock);
+	ret = regmap_update_bits(drv_data->bcast_regmap,
+				 LLCC_TRP_ATTR1_CFGn(slice_id),
+				 ATTR1_MAX_CAP_MASK,
+				 max_cap_cacheline << ATTR1_MAX_CAP_SHIFT);
+	mutex_unlock(&drv_data->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(llcc_slice_set_max_cap);
+
 static int qcom_llcc_cfg_program(struct platform_device *pdev)
 {
 	int i;
@@ -3,14 +3,21 @@
  * Copyright (c) 2021, The Linux Foundation. All rights reserved.
  */
 #include <linux/platform_device.h>
+#include <linux/debugfs.h>
+#include <linux/genalloc.h>
 #include <linux/io.h>
 #include <linux/of_address.h>
 #include <linux/mutex.h>
+#include <linux/seq_file.h>
 #include <linux/sizes.h>
+#include <linux/slab.h>
 
 #include <linux/soc/qcom/llcc-qcom.h>
 #include <linux/soc/qcom/llcc-tcm.h>
 
+/* sub-allocations are cache line granular */
+#define LLCC_TCM_MIN_ALLOC_ORDER	6
+
 struct llcc_tcm_drv_data {
 	struct device *dev;
 	struct llcc_slice_desc *tcm_slice;
@@ -18,10 +25,44 @@ struct llcc_tcm_drv_data {
 	bool is_active;
 	bool activate_on_init;
 	struct mutex lock;
+	struct gen_pool *pool;
+	struct list_head regions;
+	size_t used;
+	size_t peak_used;
+	u32 alloc_fail;
+	struct dentry *debugfs;
 };
 
 static struct llcc_tcm_drv_data *drv_data = (void *) -EPROBE_DEFER;
 
+static int llcc_tcm_stats_show(struct seq_file *s, void *unused)
+{
+	struct llcc_tcm_region *region;
+
+	mutex_lock(&drv_data->lock);
+	seq_printf(s, "size: %zu used: %zu peak: %zu alloc_fail: %u\n",
+		drv_data->tcm_data->mem_size, drv_data->used,
+		drv_data->peak_used, drv_data->alloc_fail);
+	seq_printf(s, "exclusive: %s\n", drv_data->is_active ? "yes" : "no");
+	list_for_each_entry(region, &drv_data->regions, list)
+		seq_printf(s, "%-16s offset: 0x%08llx size: %8zu mapped: %s\n",
+			region->name,
+			(u64)(region->phys_addr - drv_data->tcm_data->phys_addr),
+			region->size,
+			region->map_dev ? dev_name(region->map_dev) : "-");
+	mutex_unlock(&drv_data->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(llcc_tcm_stats);
+
+static void llcc_tcm_debugfs_init(void)
+{
+	drv_data->debugfs = debugfs_create_dir("llcc_tcm", NULL);
+	debugfs_create_file("stats", 0400, drv_data->debugfs, NULL,
+			&llcc_tcm_stats_fops);
+}
+
 /**
  * qcom_llcc_tcm_probe - Probes the tcm manager
  * @pdev: the platform device for the llcc driver
@@ -87,6 +128,20 @@ int qcom_llcc_tcm_probe(struct platform_device *pdev,
 
 
 	mutex_init(&drv_data->lock);
+	INIT_LIST_HEAD(&drv_data->regions);
+
+	drv_data->pool = devm_gen_pool_create(&pdev->dev,
+			LLCC_TCM_MIN_ALLOC_ORDER, -1, "llcc_tcm");
+	if (IS_ERR(drv_data->pool) ||
+			gen_pool_add_virt(drv_data->pool,
+				(unsigned long)drv_data->tcm_data->virt_addr,
+				drv_data->tcm_data->phys_addr,
+				drv_data->tcm_data->mem_size, -1)) {
+		pr_err("Failed to create tcm sub-allocator\n");
+		drv_data->pool = NULL;
+	}
+
+	llcc_tcm_debugfs_init();
 
 	return 0;
 
@@ -114,7 +169,8 @@ struct llcc_tcm_data *llcc_tcm_activate(void)
 	mutex_lock(&drv_data->lock);
 	if (IS_ERR_OR_NULL(drv_data->tcm_slice) ||
 			IS_ERR_OR_NULL(drv_data->tcm_data) ||
-			drv_data->is_active) {
+			drv_data->is_active ||
+			!list_empty(&drv_data->regions)) {
 		ret = -EBUSY;
 		goto act_err;
 	}
@@ -212,3 +268,162 @@ size_t llcc_tcm_get_slice_size(struct llcc_tcm_data *tcm_data)
 	return tcm_data->mem_size;
 }
 EXPORT_SYMBOL(llcc_tcm_get_slice_size);
+
+/**
+ * llcc_tcm_region_alloc - Reserve part of the tcm slice
+ * @name: name of the reservation, shown in the usage stats
+ * @size: size in bytes, rounded up to a cache line
+ *
+ * Several clients may hold regions at the same time; the slice stays
+ * activated while any region is allocated. Regions can't be allocated
+ * while a client holds the whole slice through llcc_tcm_activate().
+ *
+ * Returns a region descriptor on success and an error pointer on failure
+ */
+struct llcc_tcm_region *llcc_tcm_region_alloc(const char *name, size_t size)
+{
+	struct llcc_tcm_region *region;
+	unsigned long vaddr;
+	int ret;
+
+	if (IS_ERR(drv_data))
+		return ERR_PTR(-EPROBE_DEFER);
+
+	if (!name || !size)
+		return ERR_PTR(-EINVAL);
+
+	region = kzalloc(sizeof(*region), GFP_KERNEL);
+	if (!region)
+		return ERR_PTR(-ENOMEM);
+
+	region->name = kstrdup_const(name, GFP_KERNEL);
+	if (!region->name) {
+		ret = -ENOMEM;
+		goto free_region;
+	}
+	region->size = ALIGN(size, BIT(LLCC_TCM_MIN_ALLOC_ORDER));
+
+	mutex_lock(&drv_data->lock);
+	if (!drv_data->pool || drv_data->is_active) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	vaddr = gen_pool_alloc(drv_data->pool, region->size);
+	if (!vaddr) {
+		drv_data->alloc_fail++;
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	if (list_empty(&drv_data->regions)) {
+		ret = llcc_slice_activate(drv_data->tcm_slice);
+		if (ret) {
+			gen_pool_free(drv_data->pool, vaddr, region->size);
+			goto unlock;
+		}
+	}
+
+	region->virt_addr = (void __iomem *)vaddr;
+	region->phys_addr = gen_pool_virt_to_phys(drv_data->pool, vaddr);
+	list_add_tail(&region->list, &drv_data->regions);
+	drv_data->used += region->size;
+	drv_data->peak_used = max(drv_data->peak_used, drv_data->used);
+	mutex_unlock(&drv_data->lock);
+
+	return region;
+
+unlock:
+	mutex_unlock(&drv_data->lock);
+	kfree_const(region->name);
+free_region:
+	kfree(region);
+	return ERR_PTR(ret);
+}
+EXPORT_SYMBOL(llcc_tcm_region_alloc);
+
+/**
+ * llcc_tcm_region_free - Release a tcm region
+ * @region: region returned by llcc_tcm_region_alloc()
+ *
+ * The region must be unmapped first.
+ */
+void llcc_tcm_region_free(struct llcc_tcm_region *region)
+{
+	if (IS_ERR(drv_data) || IS_ERR_OR_NULL(region))
+		return;
+
+	WARN_ON(region->map_dev);
+
+	mutex_lock(&drv_data->lock);
+	list_del(&region->list);
+	gen_pool_free(drv_data->pool, (unsigned long)region->virt_addr,
+			region->size);
+	drv_data->used -= region->size;
+	if (list_empty(&drv_data->regions) && !drv_data->activate_on_init)
+		llcc_slice_deactivate(drv_data->tcm_slice);
+	mutex_unlock(&drv_data->lock);
+
+	kfree_const(region->name);
+	kfree(region);
+}
+EXPORT_SYMBOL(llcc_tcm_region_free);
+
+/**
+ * llcc_tcm_region_map - Map a tcm region for DMA by a device
+ * @dev: the device accessing the region
+ * @region: region returned by llcc_tcm_region_alloc()
+ * @dir: DMA direction
+ *
+ * Returns the device address on success and DMA_MAPPING_ERROR on failure
+ */
+dma_addr_t llcc_tcm_region_map(struct device *dev,
+		struct llcc_tcm_region *region, enum dma_data_direction dir)
+{
+	dma_addr_t iova;
+
+	if (IS_ERR(drv_data) || IS_ERR_OR_NULL(region) || !dev)
+		return DMA_MAPPING_ERROR;
+
+	mutex_lock(&drv_data->lock);
+	if (region->map_dev) {
+		iova = region->map_dev == dev ? region->iova :
+			DMA_MAPPING_ERROR;
+		goto unlock;
+	}
+
+	iova = dma_map_resource(dev, region->phys_addr, region->size, dir, 0);
+	if (dma_mapping_error(dev, iova)) {
+		iova = DMA_MAPPING_ERROR;
+		goto unlock;
+	}
+
+	region->map_dev = dev;
+	region->iova = iova;
+	region->dir = dir;
+
+unlock:
+	mutex_unlock(&drv_data->lock);
+	return iova;
+}
+EXPORT_SYMBOL(llcc_tcm_region_map);
+
+/**
+ * llcc_tcm_region_unmap - Undo llcc_tcm_region_map()
+ * @region: the mapped region
+ */
+void llcc_tcm_region_unmap(struct llcc_tcm_region *region)
+{
+	if (IS_ERR(drv_data) || IS_ERR_OR_NULL(region))
+		return;
+
+	mutex_lock(&drv_data->lock);
+	if (region->map_dev) {
+		dma_unmap_resource(region->map_dev, region->iova,
+				region->size, region->dir, 0);
+		region->map_dev = NULL;
+		region->iova = 0;
+	}
+	mutex_unlock(&drv_data->lock);
+}
+EXPORT_SYMBOL(llcc_tcm_region_unmap);
@@ -15,6 +15,12 @@
 #include <linux/soc/qcom/llcc-qcom.h>
 #include <linux/module.h>
 #include <linux/clk.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include "llcc_events.h"
 #include "llcc_perfmon.h"
 
@@ -23,6 +29,30 @@
 #define MAX_NUMBER_OF_PORTS		8
 #define NUM_CHANNELS			16
 #define DELIM_CHAR			" "
+#define POLICY_MAX_SLICES		8
+#define POLICY_SCID_MASK		0x1F
+#define POLICY_MIN_ACCESSES		1024
+#define POLICY_LO_HIT_PCT		70
+#define POLICY_HI_HIT_PCT		90
+#define POLICY_STEP_KB			256
+
+/**
+ * struct llcc_policy_slice	- slice managed by the resize policy
+ * @sid:		Slice id
+ * @def_cap:		Capacity limit from the SoC table, in KB
+ * @cap:		Capacity limit currently programmed, in KB
+ * @hit_pct:		Decayed hit rate of the slice
+ * @sampled:		Whether @hit_pct holds at least one valid sample
+ * @active:		Slice was active at the last rebalance
+ */
+struct llcc_policy_slice {
+	unsigned int sid;
+	unsigned int def_cap;
+	unsigned int cap;
+	unsigned int hit_pct;
+	bool sampled;
+	bool active;
+};
 
 /**
  * struct llcc_perfmon_counter_map	- llcc perfmon counter map info
@@ -70,6 +100,20 @@ struct event_port_ops {
  * @num_mc:		number of MCS
  * @version:		Version information of llcc block
  * @clk:		clock node to enable qdss
+ * @cfg:		SoC slice configuration table
+ * @cfg_size:		Number of entries in @cfg
+ * @policy_work:	Periodic work of the slice resize policy
+ * @policy_ms:		Sampling period of the policy, 0 when stopped
+ * @policy_min_pct:	Lower capacity bound, percent of the table value
+ * @policy_max_pct:	Upper capacity bound, percent of the table value
+ * @policy:		Slices managed by the policy
+ * @policy_nr:		Number of entries in @policy
+ * @policy_cur:		Index in @policy of the slice being sampled
+ * @ring_dev:		Misc device streaming samples to user space
+ * @ring:		Control page of the sample ring, NULL when not open
+ * @ring_lock:		Protects @ring against the sampling timer
+ * @ring_wq:		Readers waiting for new records
+ * @ring_pages:		Number of record pages allocated on open
  */
 struct llcc_perfmon_private {
 	struct regmap *llcc_map;
@@ -88,6 +132,20 @@ struct llcc_perfmon_private {
 	unsigned int num_mc;
 	unsigned int version;
 	struct clk *clock;
+	const struct llcc_slice_config *cfg;
+	u32 cfg_size;
+	struct delayed_work policy_work;
+	unsigned int policy_ms;
+	unsigned int policy_min_pct;
+	unsigned int policy_max_pct;
+	struct llcc_policy_slice policy[POLICY_MAX_SLICES];
+	unsigned int policy_nr;
+	unsigned int policy_cur;
+	struct miscdevice ring_dev;
+	struct llcc_perfmon_ring_ctrl *ring;
+	spinlock_t ring_lock;
+	wait_queue_head_t ring_wq;
+	unsigned int ring_pages;
 };
 
 static inline void llcc_bcast_write(struct llcc_perfmon_private *llcc_priv,
@@ -612,6 +670,397 @@ static ssize_t perfmon_scid_status_show(struct device *dev,
 	return cnt;
 }
 
+/*
+ * Slice resize policy.
+ *
+ * Two TRP counters, any access and any hit, are filtered on one managed
+ * SCID at a time and the filter rotates to the next SCID every period, so
+ * each slice gets a hit rate sample once per round. After every round the
+ * capacity limit of the active slice with the worst hit rate below
+ * POLICY_LO_HIT_PCT grows by POLICY_STEP_KB, taken from unused budget or
+ * from the active slice with the best hit rate above POLICY_HI_HIT_PCT.
+ * The budget is the sum of the table capacities of all managed slices, so
+ * capacity set aside for an idle client is lent to the busy ones. Each
+ * slice stays within the configured percentage bounds of its table value.
+ */
+static bool policy_slice_active(struct llcc_perfmon_private *llcc_priv,
+		unsigned int sid)
+{
+	uint32_t val;
+
+	llcc_bcast_read(llcc_priv, TRP_SCID_n_STATUS(sid), &val);
+	return val & TRP_SCID_STATUS_ACTIVE_MASK;
+}
+
+static void policy_set_cap(struct llcc_policy_slice *slice, unsigned int cap)
+{
+	if (slice->cap == cap)
+		return;
+
+	if (!llcc_slice_set_max_cap(slice->sid, cap))
+		slice->cap = cap;
+}
+
+static void policy_rebalance(struct llcc_perfmon_private *llcc_priv)
+{
+	struct llcc_policy_slice *slice, *grow = NULL, *shrink = NULL;
+	unsigned int budget = 0, used = 0, i, min_cap, max_cap;
+
+	for (i = 0; i < llcc_priv->policy_nr; i++) {
+		slice = &llcc_priv->policy[i];
+		budget += slice->def_cap;
+		slice->active = policy_slice_active(llcc_priv, slice->sid);
+		if (!slice->active) {
+			/* Idle slices give their budget back */
+			policy_set_cap(slice, slice->def_cap);
+			slice->sampled = false;
+			continue;
+		}
+		used += slice->cap;
+	}
+
+	for (i = 0; i < llcc_priv->policy_nr; i++) {
+		slice = &llcc_priv->policy[i];
+		if (!slice->active)
+			continue;
+
+		/* A client that came back may have pushed us over budget */
+		if (used > budget && slice->cap > slice->def_cap &&
+		    (!shrink || slice->cap - slice->def_cap >
+				shrink->cap - shrink->def_cap))
+			shrink = slice;
+
+		if (!slice->sampled)
+			continue;
+
+		max_cap = slice->def_cap * llcc_priv->policy_max_pct / 100;
+		min_cap = slice->def_cap * llcc_priv->policy_min_pct / 100;
+
+		if (slice->hit_pct < POLICY_LO_HIT_PCT &&
+		    slice->cap + POLICY_STEP_KB <= max_cap &&
+		    (!grow || slice->hit_pct < grow->hit_pct))
+			grow = slice;
+
+		if (used <= budget && slice->hit_pct >= POLICY_HI_HIT_PCT &&
+		    slice->cap >= min_cap + POLICY_STEP_KB &&
+		    (!shrink || slice->hit_pct > shrink->hit_pct))
+			shrink = slice;
+	}
+
+	if (used > budget) {
+		if (shrink)
+			policy_set_cap(shrink, shrink->cap - POLICY_STEP_KB);
+		return;
+	}
+
+	if (!grow)
+		return;
+
+	if (used + POLICY_STEP_KB <= budget) {
+		policy_set_cap(grow, grow->cap + POLICY_STEP_KB);
+	} else if (shrink && shrink != grow) {
+		policy_set_cap(shrink, shrink->cap - POLICY_STEP_KB);
+		policy_set_cap(grow, grow->cap + POLICY_STEP_KB);
+	}
+}
+
+static void policy_filter_scid(struct llcc_perfmon_private *llcc_priv,
+		unsigned int sid, bool enable)
+{
+	struct event_port_ops *port_ops = llcc_priv->port_ops[EVENT_PORT_TRP];
+
+	port_ops->event_filter_config(llcc_priv, SCID, sid, POLICY_SCID_MASK,
+			enable);
+}
+
+static void policy_work_fn(struct work_struct *work)
+{
+	struct llcc_perfmon_private *llcc_priv = container_of(work,
+			struct llcc_perfmon_private, policy_work.work);
+	struct llcc_policy_slice *slice;
+	unsigned long long access = 0, hit = 0;
+	unsigned int j, hit_pct;
+
+	mutex_lock(&llcc_priv->mutex);
+	if (!llcc_priv->policy_ms) {
+		mutex_unlock(&llcc_priv->mutex);
+		return;
+	}
+
+	perfmon_counter_dump(llcc_priv);
+	for (j = 0; j < llcc_priv->num_banks; j++) {
+		access += llcc_priv->configured[0].counter_dump[j];
+		hit += llcc_priv->configured[1].counter_dump[j];
+		llcc_priv->configured[0].counter_dump[j] = 0;
+		llcc_priv->configured[1].counter_dump[j] = 0;
+		llcc_priv->configured[2].counter_dump[j] = 0;
+	}
+
+	slice = &llcc_priv->policy[llcc_priv->policy_cur];
+	if (access >= POLICY_MIN_ACCESSES) {
+		hit_pct = div64_u64(min(hit, access) * 100, access);
+		if (slice->sampled)
+			hit_pct = (slice->hit_pct * 3 + hit_pct) / 4;
+		slice->hit_pct = hit_pct;
+		slice->sampled = true;
+	}
+
+	if (++llcc_priv->policy_cur == llcc_priv->policy_nr) {
+		llcc_priv->policy_cur = 0;
+		policy_rebalance(llcc_priv);
+	}
+
+	policy_filter_scid(llcc_priv,
+			llcc_priv->policy[llcc_priv->policy_cur].sid, true);
+	/* Drop what was counted while the filter was being switched */
+	llcc_bcast_write(llcc_priv, PERFMON_DUMP, MONITOR_DUMP);
+
+	schedule_delayed_work(&llcc_priv->policy_work,
+			msecs_to_jiffies(llcc_priv->policy_ms));
+	mutex_unlock(&llcc_priv->mutex);
+}
+
+/* Called with llcc_priv->mutex held */
+static int policy_start(struct llcc_perfmon_private *llcc_priv)
+{
+	struct event_port_ops *port_ops = llcc_priv->port_ops[EVENT_PORT_TRP];
+	struct llcc_perfmon_counter_map *counter_map;
+	unsigned int j = 0, k;
+	uint32_t val;
+	int ret;
+
+	if (llcc_priv->configured_cntrs || !llcc_priv->policy_nr)
+		return -EBUSY;
+
+	ret = clk_prepare_enable(llcc_priv->clock);
+	if (ret)
+		return ret;
+
+	llcc_priv->policy_cur = 0;
+	llcc_priv->filtered_ports |= 1 << EVENT_PORT_TRP;
+	policy_filter_scid(llcc_priv, llcc_priv->policy[0].sid, true);
+
+	for (k = 0; k < 2; k++) {
+		counter_map = &llcc_priv->configured[j];
+		counter_map->port_sel = EVENT_PORT_TRP;
+		counter_map->event_sel = k ? TRP_ANY_HIT : TRP_ANY_ACCESS;
+		memset(counter_map->counter_dump, 0,
+				sizeof(counter_map->counter_dump));
+		port_ops->event_config(llcc_priv, counter_map->event_sel, &j,
+				true);
+		j++;
+	}
+
+	memset(llcc_priv->configured[j].counter_dump, 0,
+			sizeof(llcc_priv->configured[j].counter_dump));
+	val = COUNT_CLOCK_EVENT | CLEAR_ON_ENABLE | CLEAR_ON_DUMP;
+	llcc_bcast_write(llcc_priv, PERFMON_COUNTER_n_CONFIG(j++), val);
+	llcc_priv->configured_cntrs = j;
+	llcc_priv->enables_port |= 1 << EVENT_PORT_TRP;
+
+	llcc_bcast_modify(llcc_priv, PERFMON_MODE, MANUAL_MODE | MONITOR_EN,
+			PERFMON_MODE_MONITOR_MODE_MASK |
+			PERFMON_MODE_MONITOR_EN_MASK);
+
+	schedule_delayed_work(&llcc_priv->policy_work,
+			msecs_to_jiffies(llcc_priv->policy_ms));
+	return 0;
+}
+
+/* Called with llcc_priv->mutex held */
+static void policy_stop(struct llcc_perfmon_private *llcc_priv)
+{
+	struct event_port_ops *port_ops = llcc_priv->port_ops[EVENT_PORT_TRP];
+	unsigned int j, i;
+
+	llcc_bcast_modify(llcc_priv, PERFMON_MODE, 0,
+			PERFMON_MODE_MONITOR_MODE_MASK |
+			PERFMON_MODE_MONITOR_EN_MASK);
+
+	for (j = 0; j < 2; j++) {
+		port_ops->event_config(llcc_priv,
+				llcc_priv->configured[j].event_sel, &j, false);
+		llcc_priv->configured[j].port_sel = MAX_NUMBER_OF_PORTS;
+		llcc_priv->configured[j].event_sel = 0;
+	}
+	llcc_bcast_write(llcc_priv, PERFMON_COUNTER_n_CONFIG(j), 0);
+	llcc_priv->configured_cntrs = 0;
+	llcc_priv->enables_port &= ~(1 << EVENT_PORT_TRP);
+
+	policy_filter_scid(llcc_priv, 0, false);
+	llcc_priv->filtered_ports &= ~(1 << EVENT_PORT_TRP);
+	clk_disable_unprepare(llcc_priv->clock);
+
+	for (i = 0; i < llcc_priv->policy_nr; i++) {
+		policy_set_cap(&llcc_priv->policy[i],
+				llcc_priv->policy[i].def_cap);
+		llcc_priv->policy[i].sampled = false;
+	}
+}
+
+static ssize_t perfmon_policy_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret = 0;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	mutex_lock(&llcc_priv->mutex);
+	if (val && !llcc_priv->policy_ms) {
+		llcc_priv->policy_ms = val;
+		ret = policy_start(llcc_priv);
+		if (ret)
+			llcc_priv->policy_ms = 0;
+	} else if (!val && llcc_priv->policy_ms) {
+		llcc_priv->policy_ms = 0;
+		policy_stop(llcc_priv);
+	} else {
+		llcc_priv->policy_ms = val;
+	}
+	mutex_unlock(&llcc_priv->mutex);
+
+	if (!val)
+		cancel_delayed_work_sync(&llcc_priv->policy_work);
+
+	return ret ? ret : count;
+}
+
+static ssize_t perfmon_policy_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", llcc_priv->policy_ms);
+}
+
+static ssize_t perfmon_policy_scids_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+	struct llcc_policy_slice policy[POLICY_MAX_SLICES];
+	const struct llcc_slice_config *cfg = NULL;
+	char *token, *delim = DELIM_CHAR;
+	unsigned int nr = 0, i;
+	unsigned long sid;
+
+	token = strsep((char **)&buf, delim);
+	while (token != NULL) {
+		if (kstrtoul(token, 0, &sid) || sid >= SCID_MAX)
+			return -EINVAL;
+
+		for (i = 0; i < llcc_priv->cfg_size; i++) {
+			cfg = &llcc_priv->cfg[i];
+			if (cfg->slice_id == sid && !cfg->fixed_size)
+				break;
+		}
+
+		if (i == llcc_priv->cfg_size || nr == POLICY_MAX_SLICES) {
+			pr_err("SCID %lu can not be managed\n", sid);
+			return -EINVAL;
+		}
+
+		memset(&policy[nr], 0, sizeof(policy[nr]));
+		policy[nr].sid = sid;
+		policy[nr].def_cap = cfg->max_cap;
+		policy[nr].cap = cfg->max_cap;
+		nr++;
+		token = strsep((char **)&buf, delim);
+	}
+
+	mutex_lock(&llcc_priv->mutex);
+	if (llcc_priv->policy_ms) {
+		mutex_unlock(&llcc_priv->mutex);
+		pr_err("stop the policy before changing its slices\n");
+		return -EBUSY;
+	}
+
+	memcpy(llcc_priv->policy, policy, nr * sizeof(policy[0]));
+	llcc_priv->policy_nr = nr;
+	mutex_unlock(&llcc_priv->mutex);
+
+	return count;
+}
+
+static ssize_t perfmon_policy_scids_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+	struct llcc_policy_slice *slice;
+	unsigned int i;
+	ssize_t cnt = 0;
+
+	mutex_lock(&llcc_priv->mutex);
+	for (i = 0; i < llcc_priv->policy_nr; i++) {
+		slice = &llcc_priv->policy[i];
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"SCID %02u %10s,hit %3u%%,cap %6u KB,table %6u KB\n",
+				slice->sid,
+				slice->active ? "ACTIVE" : "DEACTIVE",
+				slice->sampled ? slice->hit_pct : 0,
+				slice->cap, slice->def_cap);
+	}
+	mutex_unlock(&llcc_priv->mutex);
+
+	return cnt;
+}
+
+static ssize_t perfmon_policy_bounds_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+	unsigned int min_pct, max_pct;
+
+	if (sscanf(buf, "%u %u", &min_pct, &max_pct) != 2)
+		return -EINVAL;
+
+	if (min_pct > 100 || max_pct < 100 || max_pct > 400)
+		return -EINVAL;
+
+	mutex_lock(&llcc_priv->mutex);
+	llcc_priv->policy_min_pct = min_pct;
+	llcc_priv->policy_max_pct = max_pct;
+	mutex_unlock(&llcc_priv->mutex);
+
+	return count;
+}
+
+static ssize_t perfmon_policy_bounds_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u %u\n", llcc_priv->policy_min_pct,
+			llcc_priv->policy_max_pct);
+}
+
+static ssize_t perfmon_ring_pages_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val) || !val || val > 1024)
+		return -EINVAL;
+
+	/* Takes effect on the next open of the ring device */
+	mutex_lock(&llcc_priv->mutex);
+	llcc_priv->ring_pages = val;
+	mutex_unlock(&llcc_priv->mutex);
+
+	return count;
+}
+
+static ssize_t perfmon_ring_pages_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", llcc_priv->ring_pages);
+}
+
 static DEVICE_ATTR_RO(perfmon_counter_dump);
 static DEVICE_ATTR_WO(perfmon_configure);
 static DEVICE_ATTR_WO(perfmon_remove);
@@ -620,6 +1069,10 @@ static DEVICE_ATTR_WO(perfmon_filter_remove);
 static DEVICE_ATTR_WO(perfmon_start);
 static DEVICE_ATTR_RO(perfmon_scid_status);
 static DEVICE_ATTR_WO(perfmon_ns_periodic_dump);
+static DEVICE_ATTR_RW(perfmon_policy_ms);
+static DEVICE_ATTR_RW(perfmon_policy_scids);
+static DEVICE_ATTR_RW(perfmon_policy_bounds);
+static DEVICE_ATTR_RW(perfmon_ring_pages);
 
 static struct attribute *llcc_perfmon_attrs[] = {
 	&dev_attr_perfmon_counter_dump.attr,
@@ -630,6 +1083,10 @@ static struct attribute *llcc_perfmon_attrs[] = {
 	&dev_attr_perfmon_start.attr,
 	&dev_attr_perfmon_scid_status.attr,
 	&dev_attr_perfmon_ns_periodic_dump.attr,
+	&dev_attr_perfmon_policy_ms.attr,
+	&dev_attr_perfmon_policy_scids.attr,
+	&dev_attr_perfmon_policy_bounds.attr,
+	&dev_attr_perfmon_ring_pages.attr,
 	NULL,
 };
 
@@ -1235,12 +1692,143 @@ static void llcc_register_event_port(struct llcc_perfmon_private *llcc_priv,
 	llcc_priv->port_ops[event_port_num] = ops;
 }
 
+static void perfmon_ring_push(struct llcc_perfmon_private *llcc_priv)
+{
+	struct llcc_perfmon_ring_ctrl *ctrl;
+	struct llcc_perfmon_record *rec;
+	struct llcc_perfmon_counter_map *counter_map;
+	unsigned int i, j;
+	u32 idx;
+	u64 head;
+
+	/* The resize policy owns the counters while it runs */
+	if (READ_ONCE(llcc_priv->policy_ms))
+		return;
+
+	spin_lock(&llcc_priv->ring_lock);
+	ctrl = llcc_priv->ring;
+	if (!ctrl || !llcc_priv->configured_cntrs)
+		goto out;
+
+	head = ctrl->head;
+	if (head - READ_ONCE(ctrl->tail) >= ctrl->nr_records) {
+		ctrl->lost++;
+		goto out;
+	}
+
+	div_u64_rem(head, ctrl->nr_records, &idx);
+	rec = (void *)ctrl + PAGE_SIZE;
+	rec += idx;
+	rec->timestamp = ktime_get_ns();
+	rec->nr_counters = llcc_priv->configured_cntrs;
+	for (i = 0; i < llcc_priv->configured_cntrs; i++) {
+		counter_map = &llcc_priv->configured[i];
+		rec->count[i] = 0;
+		for (j = 0; j < llcc_priv->num_banks; j++) {
+			rec->count[i] += counter_map->counter_dump[j];
+			counter_map->counter_dump[j] = 0;
+		}
+	}
+
+	/* Publish the record before the new head */
+	smp_wmb();
+	WRITE_ONCE(ctrl->head, head + 1);
+	wake_up_interruptible(&llcc_priv->ring_wq);
+out:
+	spin_unlock(&llcc_priv->ring_lock);
+}
+
+static int perfmon_ring_open(struct inode *inode, struct file *file)
+{
+	struct llcc_perfmon_private *llcc_priv = container_of(
+			file->private_data, struct llcc_perfmon_private,
+			ring_dev);
+	struct llcc_perfmon_ring_ctrl *ctrl;
+	unsigned long flags;
+	size_t size;
+
+	mutex_lock(&llcc_priv->mutex);
+	if (llcc_priv->ring) {
+		mutex_unlock(&llcc_priv->mutex);
+		return -EBUSY;
+	}
+
+	size = (llcc_priv->ring_pages + 1) * PAGE_SIZE;
+	ctrl = vmalloc_user(size);
+	if (!ctrl) {
+		mutex_unlock(&llcc_priv->mutex);
+		return -ENOMEM;
+	}
+
+	ctrl->version = LLCC_PERFMON_RING_VERSION;
+	ctrl->record_size = sizeof(struct llcc_perfmon_record);
+	ctrl->nr_records = (size - PAGE_SIZE) / ctrl->record_size;
+
+	spin_lock_irqsave(&llcc_priv->ring_lock, flags);
+	llcc_priv->ring = ctrl;
+	spin_unlock_irqrestore(&llcc_priv->ring_lock, flags);
+	mutex_unlock(&llcc_priv->mutex);
+
+	file->private_data = llcc_priv;
+	return 0;
+}
+
+static int perfmon_ring_release(struct inode *inode, struct file *file)
+{
+	struct llcc_perfmon_private *llcc_priv = file->private_data;
+	struct llcc_perfmon_ring_ctrl *ctrl;
+	unsigned long flags;
+
+	mutex_lock(&llcc_priv->mutex);
+	spin_lock_irqsave(&llcc_priv->ring_lock, flags);
+	ctrl = llcc_priv->ring;
+	llcc_priv->ring = NULL;
+	spin_unlock_irqrestore(&llcc_priv->ring_lock, flags);
+	mutex_unlock(&llcc_priv->mutex);
+
+	vfree(ctrl);
+	return 0;
+}
+
+static int perfmon_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct llcc_perfmon_private *llcc_priv = file->private_data;
+
+	if (vma->vm_pgoff ||
+	    vma_pages(vma) > llcc_priv->ring_pages + 1)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, llcc_priv->ring, 0);
+}
+
+static __poll_t perfmon_ring_poll(struct file *file, poll_table *wait)
+{
+	struct llcc_perfmon_private *llcc_priv = file->private_data;
+	struct llcc_perfmon_ring_ctrl *ctrl = llcc_priv->ring;
+
+	poll_wait(file, &llcc_priv->ring_wq, wait);
+	if (READ_ONCE(ctrl->head) != READ_ONCE(ctrl->tail))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations perfmon_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = perfmon_ring_open,
+	.release = perfmon_ring_release,
+	.mmap = perfmon_ring_mmap,
+	.poll = perfmon_ring_poll,
+	.llseek = noop_llseek,
+};
+
 static enum hrtimer_restart llcc_perfmon_timer_handler(struct hrtimer *hrtimer)
 {
 	struct llcc_perfmon_private *llcc_priv = container_of(hrtimer,
 			struct llcc_perfmon_private, hrtimer);
 
 	perfmon_counter_dump(llcc_priv);
+	perfmon_ring_push(llcc_priv);
 	hrtimer_forward_now(&llcc_priv->hrtimer, llcc_priv->expires);
 	return HRTIMER_RESTART;
 }
@@ -1265,6 +1853,14 @@ static int llcc_perfmon_probe(struct platform_device *pdev)
 
 	llcc_priv->llcc_map = llcc_driv_data->regmap;
 	llcc_priv->llcc_bcast_map = llcc_driv_data->bcast_regmap;
+	llcc_priv->cfg = llcc_driv_data->cfg;
+	llcc_priv->cfg_size = llcc_driv_data->cfg_size;
+	llcc_priv->policy_min_pct = 50;
+	llcc_priv->policy_max_pct = 200;
+	INIT_DELAYED_WORK(&llcc_priv->policy_work, policy_work_fn);
+	spin_lock_init(&llcc_priv->ring_lock);
+	init_waitqueue_head(&llcc_priv->ring_wq);
+	llcc_priv->ring_pages = 16;
 	llcc_bcast_read(llcc_priv, LLCC_COMMON_STATUS0, &val);
 	llcc_priv->num_mc = (val & NUM_MC_MASK) >> NUM_MC_SHIFT;
 	/* Setting to 1, as some platforms it read as 0 */
@@ -1307,6 +1903,14 @@ static int llcc_perfmon_probe(struct platform_device *pdev)
 	hrtimer_init(&llcc_priv->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	llcc_priv->hrtimer.function = llcc_perfmon_timer_handler;
 	llcc_priv->expires = 0;
+
+	llcc_priv->ring_dev.minor = MISC_DYNAMIC_MINOR;
+	llcc_priv->ring_dev.name = "llcc_perfmon";
+	llcc_priv->ring_dev.fops = &perfmon_ring_fops;
+	result = misc_register(&llcc_priv->ring_dev);
+	if (result)
+		pr_err("Unable to register ring device, streaming disabled\n");
+
 	pr_info("Revision %d, has %d memory controllers connected with LLCC\n",
 			llcc_priv->version, llcc_priv->num_mc);
 	return 0;
@@ -1319,6 +1923,16 @@ static int llcc_perfmon_remove(struct platform_device *pdev)
 	while (hrtimer_active(&llcc_priv->hrtimer))
 		hrtimer_cancel(&llcc_priv->hrtimer);
 
+	mutex_lock(&llcc_priv->mutex);
+	if (llcc_priv->policy_ms) {
+		llcc_priv->policy_ms = 0;
+		policy_stop(llcc_priv);
+	}
+	mutex_unlock(&llcc_priv->mutex);
+	cancel_delayed_work_sync(&llcc_priv->policy_work);
+
+	if (!IS_ERR_OR_NULL(llcc_priv->ring_dev.this_device))
+		misc_deregister(&llcc_priv->ring_dev);
 	mutex_destroy(&llcc_priv->mutex);
 	sysfs_remove_group(&pdev->dev.kobj, &llcc_perfmon_group);
 	platform_set_drvdata(pdev, NULL);
@@ -1330,6 +1944,7 @@ static struct platform_driver llcc_perfmon_driver = {
 	.remove	= llcc_perfmon_remove,
 	.driver	= {
 		.name = LLCC_PERFMON_NAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	}
 };
 module_platform_driver(llcc_perfmon_driver);
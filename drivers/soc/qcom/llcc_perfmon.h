@@ -272,4 +272,38 @@
 #define REV_1				(0x1)
 #define REV_2				(0x2)
 #define BANK_OFFSET			(0x80000)
+
+/*
+ * Layout of the streaming ring exposed through /dev/llcc_perfmon. The
+ * first page of the mapping holds struct llcc_perfmon_ring_ctrl, records
+ * follow from the second page on. The driver advances @head after a
+ * record is complete, the reader advances @tail once it has consumed
+ * records. Records are dropped, and @lost incremented, while the ring is
+ * full.
+ */
+#define LLCC_PERFMON_RING_VERSION	1
+#define LLCC_PERFMON_RING_MAX_CNTR	16
+
+struct llcc_perfmon_ring_ctrl {
+	__u32 version;
+	__u32 record_size;
+	__u32 nr_records;
+	__u32 reserved;
+	__u64 head;
+	__u64 tail;
+	__u64 lost;
+};
+
+/*
+ * One sample of all configured counters, summed over the banks. @count
+ * holds the increments since the previous record, in configuration order,
+ * with the cycle counter last. @timestamp is CLOCK_MONOTONIC in ns, so
+ * records line up with perf samples taken with -k CLOCK_MONOTONIC.
+ */
+struct llcc_perfmon_record {
+	__u64 timestamp;
+	__u32 nr_counters;
+	__u32 reserved;
+	__u64 count[LLCC_PERFMON_RING_MAX_CNTR];
+};
 #endif /* _SOC_QCOM_LLCC_PERFMON_H_ */
@@ -50,6 +50,23 @@ static struct cdev mem_buf_char_dev;
 static DEFINE_MUTEX(mem_buf_list_lock);
 static LIST_HEAD(mem_buf_list);
 
+/*
+ * Memory lent to this VM that has been accepted and mapped, but that is not
+ * backing a membuf right now. Handing it out again saves the round trip to
+ * the lending VM, along with the stage 2 and stage 1 mapping work.
+ */
+static DEFINE_MUTEX(mem_buf_pool_lock);
+static LIST_HEAD(mem_buf_pool);
+static size_t mem_buf_pool_size;
+static void mem_buf_pool_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(mem_buf_pool_work, mem_buf_pool_work_fn);
+
+static unsigned int pool_max_mb = 64;
+module_param(pool_max_mb, uint, 0644);
+
+static unsigned int pool_idle_ms = 2000;
+module_param(pool_idle_ms, uint, 0644);
+
 /*
  * Data structures for tracking request/reply transactions, as well as message
  * queue usage
@@ -145,7 +162,9 @@ struct mem_buf_xfer_mem {
  * memory to the system.
  * @filp: Pointer to the file structure for the membuf
  * @entry: List head for maintaing a list of memory buffers that have been
- * provided by remote VMs.
+ * provided by remote VMs, or for the pool when the memory is not in use.
+ * @pool_expires: When the memory is in the pool, the time after which it is
+ * returned to the remote VM if it has not been reused.
  */
 struct mem_buf_desc {
 	size_t size;
@@ -158,6 +177,7 @@ struct mem_buf_desc {
 	void *dst_data;
 	struct file *filp;
 	struct list_head entry;
+	unsigned long pool_expires;
 };
 
 /**
@@ -1351,35 +1371,192 @@ static void mem_buf_free_mem_type_data(enum mem_buf_mem_type mem_type,
 		mem_buf_free_ion_mem_type_data(mem_type_data);
 }
 
-static int mem_buf_buffer_release(struct inode *inode, struct file *filp)
+static int mem_buf_map_desc(struct mem_buf_desc *membuf)
 {
-	struct mem_buf_desc *membuf = filp->private_data;
+	struct hh_sgl_desc *sgl_desc;
 	int ret;
 
-	mutex_lock(&mem_buf_list_lock);
-	list_del(&membuf->entry);
-	mutex_unlock(&mem_buf_list_lock);
+	ret = mem_buf_request_mem(membuf);
+	if (ret)
+		return ret;
 
-	ret = mem_buf_remove_mem(membuf);
-	if (ret < 0)
-		goto out_free_mem;
+	sgl_desc = mem_buf_map_mem_s2(membuf->memparcel_hdl, membuf->acl_desc);
+	if (IS_ERR(sgl_desc)) {
+		ret = PTR_ERR(sgl_desc);
+		goto err_map_mem_s2;
+	}
+	membuf->sgl_desc = sgl_desc;
+
+	ret = mem_buf_map_mem_s1(membuf->sgl_desc);
+	if (ret)
+		goto err_map_mem_s1;
+
+	return 0;
+
+err_map_mem_s1:
+	kfree(membuf->sgl_desc);
+	membuf->sgl_desc = NULL;
+	if (mem_buf_unmap_mem_s2(membuf->memparcel_hdl) < 0)
+		return ret;
+err_map_mem_s2:
+	mem_buf_relinquish_mem(membuf->memparcel_hdl);
+	return ret;
+}
+
+static int mem_buf_unmap_desc(struct mem_buf_desc *membuf)
+{
+	int ret;
 
 	ret = mem_buf_unmap_mem_s1(membuf->sgl_desc);
 	if (ret < 0)
-		goto out_free_mem;
+		return ret;
 
 	ret = mem_buf_unmap_mem_s2(membuf->memparcel_hdl);
 	if (ret < 0)
-		goto out_free_mem;
+		return ret;
 
 	mem_buf_relinquish_mem(membuf->memparcel_hdl);
+	return 0;
+}
 
-out_free_mem:
-	mem_buf_free_mem_type_data(membuf->dst_mem_type, membuf->dst_data);
+static void mem_buf_free_desc(struct mem_buf_desc *membuf)
+{
 	mem_buf_free_mem_type_data(membuf->src_mem_type, membuf->src_data);
 	kfree(membuf->sgl_desc);
 	kfree(membuf->acl_desc);
 	kfree(membuf);
+}
+
+static bool mem_buf_src_data_match(enum mem_buf_mem_type type, void *a,
+				   void *b)
+{
+	struct mem_buf_ion_data *ion_a = a, *ion_b = b;
+
+	if (type == MEM_BUF_ION_MEM_TYPE)
+		return ion_a->heap_id == ion_b->heap_id;
+
+	return false;
+}
+
+static bool mem_buf_pool_match(struct mem_buf_desc *pooled,
+			       struct mem_buf_desc *membuf)
+{
+	u32 nr_acl_entries = membuf->acl_desc->n_acl_entries;
+
+	if (pooled->size != membuf->size ||
+	    pooled->src_mem_type != membuf->src_mem_type ||
+	    pooled->acl_desc->n_acl_entries != nr_acl_entries)
+		return false;
+
+	if (memcmp(pooled->acl_desc, membuf->acl_desc,
+		   offsetof(struct hh_acl_desc, acl_entries[nr_acl_entries])))
+		return false;
+
+	return mem_buf_src_data_match(membuf->src_mem_type, pooled->src_data,
+				      membuf->src_data);
+}
+
+/*
+ * Take memory out of the pool that was lent with the same size, source and
+ * ACL as @membuf asks for.
+ */
+static struct mem_buf_desc *mem_buf_pool_get(struct mem_buf_desc *membuf)
+{
+	struct mem_buf_desc *pooled, *found = NULL;
+
+	mutex_lock(&mem_buf_pool_lock);
+	list_for_each_entry(pooled, &mem_buf_pool, entry)
+		if (mem_buf_pool_match(pooled, membuf)) {
+			found = pooled;
+			list_del(&found->entry);
+			mem_buf_pool_size -= found->size;
+			break;
+		}
+	mutex_unlock(&mem_buf_pool_lock);
+
+	return found;
+}
+
+/*
+ * Park memory that no longer backs a membuf in the pool, keeping it mapped
+ * in stage 2 and stage 1. Returns false if the pool is full, in which case
+ * the caller gives the memory back to the lending VM.
+ */
+static bool mem_buf_pool_put(struct mem_buf_desc *membuf)
+{
+	size_t max_size = (size_t)pool_max_mb * SZ_1M;
+
+	mutex_lock(&mem_buf_pool_lock);
+	if (mem_buf_pool_size + membuf->size > max_size) {
+		mutex_unlock(&mem_buf_pool_lock);
+		return false;
+	}
+
+	membuf->filp = NULL;
+	membuf->dst_data = NULL;
+	membuf->pool_expires = jiffies + msecs_to_jiffies(pool_idle_ms);
+	list_add(&membuf->entry, &mem_buf_pool);
+	mem_buf_pool_size += membuf->size;
+	mutex_unlock(&mem_buf_pool_lock);
+
+	schedule_delayed_work(&mem_buf_pool_work,
+			      msecs_to_jiffies(pool_idle_ms));
+	return true;
+}
+
+/* Give memory that sat unused in the pool for too long back to its owner */
+static void mem_buf_pool_shrink(bool all)
+{
+	struct mem_buf_desc *membuf, *tmp;
+	LIST_HEAD(reclaim);
+	bool empty;
+
+	mutex_lock(&mem_buf_pool_lock);
+	list_for_each_entry_safe(membuf, tmp, &mem_buf_pool, entry)
+		if (all || time_after_eq(jiffies, membuf->pool_expires)) {
+			list_move(&membuf->entry, &reclaim);
+			mem_buf_pool_size -= membuf->size;
+		}
+	empty = list_empty(&mem_buf_pool);
+	mutex_unlock(&mem_buf_pool_lock);
+
+	list_for_each_entry_safe(membuf, tmp, &reclaim, entry) {
+		list_del(&membuf->entry);
+		mem_buf_unmap_desc(membuf);
+		mem_buf_free_desc(membuf);
+	}
+
+	if (!all && !empty)
+		schedule_delayed_work(&mem_buf_pool_work,
+				      msecs_to_jiffies(pool_idle_ms));
+}
+
+static void mem_buf_pool_work_fn(struct work_struct *work)
+{
+	mem_buf_pool_shrink(false);
+}
+
+static int mem_buf_buffer_release(struct inode *inode, struct file *filp)
+{
+	struct mem_buf_desc *membuf = filp->private_data;
+	int ret;
+
+	mutex_lock(&mem_buf_list_lock);
+	list_del(&membuf->entry);
+	mutex_unlock(&mem_buf_list_lock);
+
+	ret = mem_buf_remove_mem(membuf);
+	mem_buf_free_mem_type_data(membuf->dst_mem_type, membuf->dst_data);
+	if (ret < 0)
+		goto out_free_mem;
+
+	if (mem_buf_pool_put(membuf))
+		return 0;
+
+	ret = mem_buf_unmap_desc(membuf);
+
+out_free_mem:
+	mem_buf_free_desc(membuf);
 	return ret;
 }
 
@@ -1393,28 +1570,26 @@ static bool is_valid_mem_type(enum mem_buf_mem_type mem_type)
 		mem_type < MEM_BUF_MAX_MEM_TYPE;
 }
 
-void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
+static bool is_valid_alloc_data(struct mem_buf_allocation_data *alloc_data)
 {
-	int ret;
-	struct file *filp;
-	struct mem_buf_desc *membuf;
-	struct hh_sgl_desc *sgl_desc;
-
-	if (!(mem_buf_capability & MEM_BUF_CAP_CONSUMER))
-		return ERR_PTR(-ENOTSUPP);
+	return alloc_data && alloc_data->size && alloc_data->nr_acl_entries &&
+	       alloc_data->acl_list &&
+	       alloc_data->nr_acl_entries <= MEM_BUF_MAX_NR_ACL_ENTS &&
+	       is_valid_mem_type(alloc_data->src_mem_type) &&
+	       is_valid_mem_type(alloc_data->dst_mem_type);
+}
 
-	if (!alloc_data || !alloc_data->size || !alloc_data->nr_acl_entries ||
-	    !alloc_data->acl_list ||
-	    (alloc_data->nr_acl_entries > MEM_BUF_MAX_NR_ACL_ENTS) ||
-	    !is_valid_mem_type(alloc_data->src_mem_type) ||
-	    !is_valid_mem_type(alloc_data->dst_mem_type))
-		return ERR_PTR(-EINVAL);
+/* Sets up the parts of a membuf that describe the memory on the remote VM */
+static struct mem_buf_desc *mem_buf_create_desc(
+				struct mem_buf_allocation_data *alloc_data)
+{
+	struct mem_buf_desc *membuf;
+	int ret;
 
 	membuf = kzalloc(sizeof(*membuf), GFP_KERNEL);
 	if (!membuf)
 		return ERR_PTR(-ENOMEM);
 
-	pr_debug("%s: mem buf alloc begin\n", __func__);
 	membuf->size = ALIGN(alloc_data->size, MEM_BUF_MHP_ALIGNMENT);
 	membuf->acl_desc = mem_buf_acl_to_hh_acl(alloc_data->nr_acl_entries,
 						 alloc_data->acl_list);
@@ -1423,7 +1598,6 @@ void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
 		goto err_alloc_acl_list;
 	}
 	membuf->src_mem_type = alloc_data->src_mem_type;
-	membuf->dst_mem_type = alloc_data->dst_mem_type;
 
 	membuf->src_data =
 		mem_buf_retrieve_mem_type_data(alloc_data->src_mem_type,
@@ -1433,6 +1607,33 @@ void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
 		goto err_alloc_src_data;
 	}
 
+	return membuf;
+
+err_alloc_src_data:
+	kfree(membuf->acl_desc);
+err_alloc_acl_list:
+	kfree(membuf);
+	return ERR_PTR(ret);
+}
+
+void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
+{
+	int ret;
+	struct file *filp;
+	struct mem_buf_desc *membuf, *pooled;
+
+	if (!(mem_buf_capability & MEM_BUF_CAP_CONSUMER))
+		return ERR_PTR(-ENOTSUPP);
+
+	if (!is_valid_alloc_data(alloc_data))
+		return ERR_PTR(-EINVAL);
+
+	pr_debug("%s: mem buf alloc begin\n", __func__);
+	membuf = mem_buf_create_desc(alloc_data);
+	if (IS_ERR(membuf))
+		return membuf;
+
+	membuf->dst_mem_type = alloc_data->dst_mem_type;
 	membuf->dst_data =
 		mem_buf_retrieve_mem_type_data(alloc_data->dst_mem_type,
 					       alloc_data->dst_data);
@@ -1443,18 +1644,19 @@ void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
 
 	trace_mem_buf_alloc_info(membuf->size, membuf->src_mem_type,
 				 membuf->dst_mem_type, membuf->acl_desc);
-	ret = mem_buf_request_mem(membuf);
-	if (ret)
-		goto err_mem_req;
-
-	sgl_desc = mem_buf_map_mem_s2(membuf->memparcel_hdl, membuf->acl_desc);
-	if (IS_ERR(sgl_desc))
-		goto err_map_mem_s2;
-	membuf->sgl_desc = sgl_desc;
-
-	ret = mem_buf_map_mem_s1(membuf->sgl_desc);
-	if (ret)
-		goto err_map_mem_s1;
+	pooled = mem_buf_pool_get(membuf);
+	if (pooled) {
+		pr_debug("%s: reusing pooled memparcel hdl: 0x%x\n", __func__,
+			 pooled->memparcel_hdl);
+		membuf->memparcel_hdl = pooled->memparcel_hdl;
+		membuf->sgl_desc = pooled->sgl_desc;
+		pooled->sgl_desc = NULL;
+		mem_buf_free_desc(pooled);
+	} else {
+		ret = mem_buf_map_desc(membuf);
+		if (ret)
+			goto err_map_desc;
+	}
 
 	ret = mem_buf_add_mem(membuf);
 	if (ret)
@@ -1475,33 +1677,53 @@ void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
 	return membuf;
 
 err_get_file:
-	if (mem_buf_remove_mem(membuf) < 0) {
-		kfree(membuf->sgl_desc);
-		goto err_mem_req;
-	}
+	if (mem_buf_remove_mem(membuf) < 0)
+		goto err_map_desc;
 err_add_mem:
-	if (mem_buf_unmap_mem_s1(membuf->sgl_desc) < 0) {
-		kfree(membuf->sgl_desc);
-		goto err_mem_req;
-	}
-err_map_mem_s1:
-	kfree(membuf->sgl_desc);
-	if (mem_buf_unmap_mem_s2(membuf->memparcel_hdl) < 0)
-		goto err_mem_req;
-err_map_mem_s2:
-	mem_buf_relinquish_mem(membuf->memparcel_hdl);
-err_mem_req:
+	mem_buf_unmap_desc(membuf);
+err_map_desc:
 	mem_buf_free_mem_type_data(membuf->dst_mem_type, membuf->dst_data);
 err_alloc_dst_data:
-	mem_buf_free_mem_type_data(membuf->src_mem_type, membuf->src_data);
-err_alloc_src_data:
-	kfree(membuf->acl_desc);
-err_alloc_acl_list:
-	kfree(membuf);
+	mem_buf_free_desc(membuf);
 	return ERR_PTR(ret);
 }
 EXPORT_SYMBOL(mem_buf_alloc);
 
+int mem_buf_pool_fill(struct mem_buf_allocation_data *alloc_data,
+		      unsigned int nr)
+{
+	struct mem_buf_desc *membuf;
+	unsigned int i;
+	int ret;
+
+	if (!(mem_buf_capability & MEM_BUF_CAP_CONSUMER))
+		return -ENOTSUPP;
+
+	if (!is_valid_alloc_data(alloc_data))
+		return -EINVAL;
+
+	for (i = 0; i < nr; i++) {
+		membuf = mem_buf_create_desc(alloc_data);
+		if (IS_ERR(membuf))
+			return PTR_ERR(membuf);
+
+		ret = mem_buf_map_desc(membuf);
+		if (ret) {
+			mem_buf_free_desc(membuf);
+			return ret;
+		}
+
+		if (!mem_buf_pool_put(membuf)) {
+			mem_buf_unmap_desc(membuf);
+			mem_buf_free_desc(membuf);
+			return -ENOSPC;
+		}
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(mem_buf_pool_fill);
+
 static int _mem_buf_get_fd(struct file *filp)
 {
 	int fd;
@@ -2221,6 +2443,9 @@ static int mem_buf_probe(struct platform_device *pdev)
 
 static int mem_buf_remove(struct platform_device *pdev)
 {
+	cancel_delayed_work_sync(&mem_buf_pool_work);
+	mem_buf_pool_shrink(true);
+
 	mutex_lock(&mem_buf_list_lock);
 	if (!list_empty(&mem_buf_list))
 		dev_err(mem_buf_dev,
@@ -27,6 +27,9 @@
 #include <asm/cacheflush.h>
 #include <soc/qcom/rpm-smd.h>
 
+#define CREATE_TRACE_POINTS
+#include "trace-mem-offline.h"
+
 #define RPM_DDR_REQ 0x726464
 #define AOP_MSG_ADDR_MASK		0xffffffff
 #define AOP_MSG_ADDR_HIGH_SHIFT		32
@@ -49,6 +52,7 @@ static bool is_rpm_controller;
 static bool has_pend_offline_req;
 static atomic_long_t totalram_pages_with_offline = ATOMIC_INIT(0);
 static struct workqueue_struct *migrate_wq;
+static struct workqueue_struct *premigrate_wq;
 static unsigned long movable_bitmap;
 
 #define MODULE_CLASS_NAME	"mem-offline"
@@ -101,6 +105,13 @@ struct movable_zone_fill_control {
 	struct zone *zone;
 };
 
+struct mem_premigrate_work {
+	struct work_struct work;
+	unsigned long sec_nr;
+	unsigned long start_pfn;
+	unsigned long end_pfn;
+};
+
 static void fill_movable_zone_fn(struct work_struct *work);
 static DECLARE_WORK(fill_movable_zone_work, fill_movable_zone_fn);
 static DEFINE_MUTEX(page_migrate_lock);
@@ -699,6 +710,8 @@ static int mem_event_callback(struct notifier_block *self,
 
 		if (mem_change_refresh_state(mn, MEMORY_ONLINE))
 			return NOTIFY_BAD;
+		trace_mem_offline_step(sec_nr, "refresh_on",
+				       ktime_us_delta(ktime_get(), cur));
 
 		if (!debug_pagealloc_enabled()) {
 			/* Create kernel page-tables */
@@ -708,6 +721,8 @@ static int mem_event_callback(struct notifier_block *self,
 		break;
 	case MEM_ONLINE:
 		update_totalram_snapshot();
+		trace_mem_offline_step(sec_nr, "online",
+				       ktime_us_delta(ktime_get(), cur));
 		delay = ktime_ms_delta(ktime_get(), cur);
 		record_stat(sec_nr, delay, MEMORY_ONLINE);
 		cur = 0;
@@ -723,17 +738,22 @@ static int mem_event_callback(struct notifier_block *self,
 		has_pend_offline_req = true;
 		cancel_work_sync(&fill_movable_zone_work);
 		cur = ktime_get();
+		trace_mem_offline_step(sec_nr, "going_offline", 0);
 		break;
 	case MEM_OFFLINE:
 		if (!debug_pagealloc_enabled()) {
 			/* Clear kernel page-tables */
 			clear_pgtable_mapping(start_addr, end_addr);
 		}
+		trace_mem_offline_step(sec_nr, "isolated",
+				       ktime_us_delta(ktime_get(), cur));
 		mem_change_refresh_state(mn, MEMORY_OFFLINE);
 		/*
 		 * Notifying that something went bad at this stage won't
 		 * help since this is the last stage of memory hotplug.
 		 */
+		trace_mem_offline_step(sec_nr, "offline",
+				       ktime_us_delta(ktime_get(), cur));
 
 		delay = ktime_ms_delta(ktime_get(), cur);
 		record_stat(sec_nr, delay, MEMORY_OFFLINE);
@@ -1040,6 +1060,204 @@ static ssize_t show_mem_stats(struct kobject *kobj,
 static struct kobj_attribute stats_attr =
 		__ATTR(stats, 0444, show_mem_stats, NULL);
 
+static struct page *mem_premigrate_alloc(struct page *page,
+					 unsigned long data)
+{
+	return alloc_page(GFP_HIGHUSER_MOVABLE | __GFP_NOWARN);
+}
+
+/*
+ * Move the LRU pages out of one isolated block ahead of offline_pages(),
+ * which would otherwise migrate each block in turn under the hotplug lock.
+ */
+static void mem_premigrate_fn(struct work_struct *work)
+{
+	struct mem_premigrate_work *pw =
+		container_of(work, struct mem_premigrate_work, work);
+	unsigned long pfn = pw->start_pfn, end;
+	unsigned long expire = jiffies + MIGRATE_TIMEOUT_SEC * HZ;
+	ktime_t start = ktime_get();
+	LIST_HEAD(source);
+
+	while (pfn < pw->end_pfn && !time_after(jiffies, expire)) {
+		end = min(pfn + pageblock_nr_pages, pw->end_pfn);
+		for (; pfn < end; pfn++) {
+			struct page *page;
+
+			if (!pfn_valid(pfn))
+				continue;
+
+			page = pfn_to_page(pfn);
+			/* huge pages are left to offline_pages() */
+			if (PageBuddy(page) || PageCompound(page) ||
+			    !PageLRU(page))
+				continue;
+
+			if (!get_page_unless_zero(page))
+				continue;
+
+			if (!isolate_lru_page(page)) {
+				list_add_tail(&page->lru, &source);
+				inc_node_page_state(page, NR_ISOLATED_ANON +
+						page_is_file_cache(page));
+			}
+			put_page(page);
+		}
+
+		if (!list_empty(&source) &&
+		    migrate_pages(&source, mem_premigrate_alloc, NULL, 0,
+				  MIGRATE_SYNC, MR_MEMORY_HOTPLUG))
+			putback_movable_pages(&source);
+		cond_resched();
+	}
+
+	trace_mem_offline_step(pw->sec_nr, "premigrated",
+			       ktime_us_delta(ktime_get(), start));
+}
+
+static void mem_premigrate_blocks(struct memory_block **mems,
+				  unsigned int nr)
+{
+	unsigned long nr_pages = PAGES_PER_SECTION * sections_per_block;
+	struct mem_premigrate_work *works;
+	unsigned int i;
+
+	works = kcalloc(nr, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return;
+
+	/* isolate every block first so migration never lands in the batch */
+	for (i = 0; i < nr; i++) {
+		works[i].sec_nr = mems[i]->start_section_nr;
+		works[i].start_pfn = section_nr_to_pfn(works[i].sec_nr);
+		works[i].end_pfn = works[i].start_pfn + nr_pages;
+		if (start_isolate_page_range(works[i].start_pfn,
+					     works[i].end_pfn,
+					     MIGRATE_MOVABLE, 0))
+			works[i].end_pfn = works[i].start_pfn;
+	}
+
+	lru_add_drain_all();
+	for (i = 0; i < nr; i++) {
+		if (works[i].end_pfn == works[i].start_pfn)
+			continue;
+		INIT_WORK(&works[i].work, mem_premigrate_fn);
+		queue_work(premigrate_wq, &works[i].work);
+	}
+
+	for (i = 0; i < nr; i++) {
+		if (works[i].end_pfn == works[i].start_pfn)
+			continue;
+		flush_work(&works[i].work);
+		/* offline_pages() isolates the range again itself */
+		undo_isolate_page_range(works[i].start_pfn, works[i].end_pfn,
+					MIGRATE_MOVABLE);
+	}
+
+	kfree(works);
+}
+
+/*
+ * Change the state of up to @nr blocks with a single hold of the hotplug
+ * lock. Offlining starts from the top block so that whole segments are
+ * emptied first and each one's refresh-off request goes out as soon as its
+ * last block is offline, while the pages of all blocks are migrated in
+ * parallel beforehand. Onlining starts from the bottom block.
+ */
+static int mem_change_state_batch(unsigned int nr, bool online)
+{
+	unsigned int total_blks = (end_section_nr - start_section_nr + 1) /
+				  sections_per_block;
+	enum memory_states state = online ? MEMORY_ONLINE : MEMORY_OFFLINE;
+	struct memory_block **mems;
+	unsigned int i, found = 0;
+	ktime_t start = ktime_get();
+	int ret;
+
+	nr = min(nr, total_blks);
+	if (!nr)
+		return 0;
+
+	mems = kcalloc(nr, sizeof(*mems), GFP_KERNEL);
+	if (!mems)
+		return -ENOMEM;
+
+	ret = lock_device_hotplug_sysfs();
+	if (ret)
+		goto out_free;
+
+	for (i = 0; i < total_blks && found < nr; i++) {
+		unsigned int blk = online ? i : total_blks - 1 - i;
+		unsigned long sec_nr = start_section_nr +
+				       blk * sections_per_block;
+		struct memory_block *mem;
+
+		if (mem_sec_state[blk] == state)
+			continue;
+
+		mem = find_memory_block(__nr_to_section(sec_nr));
+		if (mem)
+			mems[found++] = mem;
+	}
+
+	if (!online)
+		mem_premigrate_blocks(mems, found);
+
+	for (i = 0; i < found; i++) {
+		int err = online ? device_online(&mems[i]->dev) :
+				   device_offline(&mems[i]->dev);
+
+		if (err < 0) {
+			pr_err("mem-offline: batch %s of mem%lu failed: %d\n",
+			       online ? "online" : "offline",
+			       mems[i]->start_section_nr, err);
+			if (!ret)
+				ret = err;
+		}
+		/* drop the ref. we got via find_memory_block() */
+		put_device(&mems[i]->dev);
+	}
+
+	unlock_device_hotplug();
+	if (found)
+		trace_mem_offline_step(mems[0]->start_section_nr,
+				       online ? "batch_online" : "batch_offline",
+				       ktime_us_delta(ktime_get(), start));
+out_free:
+	kfree(mems);
+	return ret;
+}
+
+static ssize_t store_batch_online(struct kobject *kobj,
+				struct kobj_attribute *attr, const char *buf,
+				size_t size)
+{
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+
+	ret = mem_change_state_batch(val, true);
+	return ret ? ret : size;
+}
+
+static ssize_t store_batch_offline(struct kobject *kobj,
+				struct kobj_attribute *attr, const char *buf,
+				size_t size)
+{
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+
+	ret = mem_change_state_batch(val, false);
+	return ret ? ret : size;
+}
+
 static ssize_t show_anon_migrate(struct kobject *kobj,
 					struct kobj_attribute *attr, char *buf)
 {
@@ -1071,10 +1289,18 @@ static struct kobj_attribute offline_granule_attr =
 static struct kobj_attribute anon_migration_size_attr =
 		__ATTR(anon_migrate, 0644, show_anon_migrate, store_anon_migrate);
 
+static struct kobj_attribute batch_online_attr =
+		__ATTR(batch_online, 0200, NULL, store_batch_online);
+
+static struct kobj_attribute batch_offline_attr =
+		__ATTR(batch_offline, 0200, NULL, store_batch_offline);
+
 static struct attribute *mem_root_attrs[] = {
 		&stats_attr.attr,
 		&offline_granule_attr.attr,
 		&anon_migration_size_attr.attr,
+		&batch_online_attr.attr,
+		&batch_offline_attr.attr,
 		NULL,
 };
 
@@ -1208,6 +1434,14 @@ static int mem_offline_driver_probe(struct platform_device *pdev)
 		goto err_sysfs_remove_group;
 	}
 
+	premigrate_wq = alloc_workqueue("mem_premigrate_wq", WQ_UNBOUND, 0);
+	if (!premigrate_wq) {
+		pr_err("Failed to create the workers for batch offline\n");
+		destroy_workqueue(migrate_wq);
+		ret = -ENOMEM;
+		goto err_sysfs_remove_group;
+	}
+
 	return 0;
 
 err_sysfs_remove_group:
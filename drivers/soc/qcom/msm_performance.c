@@ -26,6 +26,10 @@
 #include <linux/errno.h>
 #include <linux/topology.h>
 #include <linux/scmi_protocol.h>
+#include <linux/kfifo.h>
+#include <linux/miscdevice.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
 
 #define POLL_INT 25
 #define NODE_NAME_MAX_CHARS 16
@@ -109,6 +113,18 @@ static unsigned int top_load[CLUSTER_MAX];
 static unsigned int curr_cap[CLUSTER_MAX];
 static bool max_cap_cpus[NR_CPUS];
 static atomic_t game_status_pid;
+
+/*
+ * Timestamped event channel: everything that is otherwise signalled by
+ * sysfs_notify() on separate nodes is also queued here, so a single
+ * reader can epoll one fd instead of polling each node.
+ */
+#define PERF_EVT_RING_SIZE 256
+static DEFINE_KFIFO(perf_evt_ring, struct msm_perf_evt_rec,
+		    PERF_EVT_RING_SIZE);
+static DEFINE_SPINLOCK(perf_evt_lock);
+static DECLARE_WAIT_QUEUE_HEAD(perf_evt_wq);
+static unsigned int perf_evt_dropped;
 #endif
 static bool ready_for_freq_updates;
 
@@ -469,6 +485,91 @@ static struct kobject *notify_kobj;
 
 /*******************************sysfs ends************************************/
 
+static void msm_perf_evt_push(u32 type, u32 d0, u32 d1, u32 d2, u32 d3,
+			      u32 d4)
+{
+	struct msm_perf_evt_rec rec = {
+		.ts_ns = ktime_get_ns(),
+		.type = type,
+		.data = { d0, d1, d2, d3, d4 },
+	};
+	unsigned long flags;
+
+	spin_lock_irqsave(&perf_evt_lock, flags);
+	/* keep the newest events, the reader learns how many it missed */
+	if (kfifo_is_full(&perf_evt_ring)) {
+		kfifo_skip(&perf_evt_ring);
+		perf_evt_dropped++;
+	}
+	kfifo_put(&perf_evt_ring, rec);
+	spin_unlock_irqrestore(&perf_evt_lock, flags);
+
+	wake_up_interruptible(&perf_evt_wq);
+}
+
+static ssize_t msm_perf_evt_read(struct file *file, char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct msm_perf_evt_rec recs[16];
+	unsigned int n, max = min_t(size_t, count / sizeof(recs[0]),
+				    ARRAY_SIZE(recs));
+	unsigned long flags;
+	int ret;
+
+	if (!max)
+		return -EINVAL;
+
+	do {
+		spin_lock_irqsave(&perf_evt_lock, flags);
+		n = 0;
+		if (perf_evt_dropped) {
+			recs[n].ts_ns = ktime_get_ns();
+			recs[n].type = MSM_PERF_EVT_OVERFLOW;
+			memset(recs[n].data, 0, sizeof(recs[n].data));
+			recs[n++].data[0] = perf_evt_dropped;
+			perf_evt_dropped = 0;
+		}
+		n += kfifo_out(&perf_evt_ring, recs + n, max - n);
+		spin_unlock_irqrestore(&perf_evt_lock, flags);
+
+		if (n)
+			break;
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(perf_evt_wq,
+					       !kfifo_is_empty(&perf_evt_ring));
+		if (ret)
+			return ret;
+	} while (1);
+
+	if (copy_to_user(buf, recs, n * sizeof(recs[0])))
+		return -EFAULT;
+
+	return n * sizeof(recs[0]);
+}
+
+static __poll_t msm_perf_evt_poll(struct file *file, poll_table *wait)
+{
+	poll_wait(file, &perf_evt_wq, wait);
+
+	return kfifo_is_empty(&perf_evt_ring) ? 0 : EPOLLIN | EPOLLRDNORM;
+}
+
+static const struct file_operations msm_perf_evt_fops = {
+	.owner = THIS_MODULE,
+	.read = msm_perf_evt_read,
+	.poll = msm_perf_evt_poll,
+	.llseek = noop_llseek,
+};
+
+static struct miscdevice msm_perf_evt_dev = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name = "msm_perf_events",
+	.fops = &msm_perf_evt_fops,
+	.mode = 0444,
+};
+
+
 /*****************PMU Data Collection*****************/
 static struct perf_event_attr attr;
 static void msm_perf_init_attr(void)
@@ -656,6 +757,8 @@ static int hotplug_notify_down(unsigned int cpu)
 	restart_events(cpu, false);
 	mutex_unlock(&perfevent_lock);
 
+	msm_perf_evt_push(MSM_PERF_EVT_HOTPLUG, cpu, 0, 0, 0, 0);
+
 	return 0;
 }
 
@@ -668,6 +771,8 @@ static int hotplug_notify_up(unsigned int cpu)
 	per_cpu(cpu_is_hp, cpu) = false;
 	mutex_unlock(&perfevent_lock);
 
+	msm_perf_evt_push(MSM_PERF_EVT_HOTPLUG, cpu, 1, 0, 0, 0);
+
 	if (events_group.init_success) {
 		spin_lock_irqsave(&(events_group.cpu_hotplug_lock), flags);
 		events_group.cpu_hotplug = true;
@@ -809,6 +914,12 @@ static int init_events_group(void)
 
 static void nr_notify_userspace(struct work_struct *work)
 {
+	msm_perf_evt_push(MSM_PERF_EVT_CLUSTER_LOAD, aggr_big_nr,
+			  aggr_top_load, top_load[MIN], top_load[MID],
+			  top_load[MAX]);
+	msm_perf_evt_push(MSM_PERF_EVT_CLUSTER_CAP, curr_cap[MIN],
+			  curr_cap[MID], curr_cap[MAX], 0, 0);
+
 	sysfs_notify(notify_kobj, NULL, "aggr_top_load");
 	sysfs_notify(notify_kobj, NULL, "aggr_big_nr");
 	sysfs_notify(notify_kobj, NULL, "top_load_cluster");
@@ -905,8 +1016,11 @@ void  msm_perf_events_update(enum evt_update_t update_typ,
 	gpu_circ_buff[idx].evt_typ = evt_typ;
 	gpu_circ_buff[idx].arrive_ts = ktime_get();
 
-	if (evt_typ == MSM_PERF_QUEUE || evt_typ == MSM_PERF_RETIRED)
+	if (evt_typ == MSM_PERF_QUEUE || evt_typ == MSM_PERF_RETIRED) {
+		msm_perf_evt_push(MSM_PERF_EVT_GFX, pid, ctx_id, timestamp,
+				  evt_typ, 0);
 		complete(&gfx_evt_arrival);
+	}
 }
 
 
@@ -917,6 +1031,7 @@ static int set_game_start_pid(const char *buf, const struct kernel_param *kp)
 
 	kstrtol(buf, 0, &usr_val);
 	atomic_set(&game_status_pid, usr_val);
+	msm_perf_evt_push(MSM_PERF_EVT_GAME_START, usr_val, 0, 0, 0, 0);
 	return ret;
 }
 
@@ -1170,6 +1285,8 @@ static int __init msm_performance_init(void)
 	init_events_group();
 	init_notify_group();
 	init_pmu_counter();
+	if (misc_register(&msm_perf_evt_dev))
+		pr_err("msm_perf: Failed to register event channel\n");
 
 	idle_notifier_register(&msm_perf_event_idle_nb);
 #endif
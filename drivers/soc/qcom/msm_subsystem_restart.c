@@ -1629,6 +1629,8 @@ static int __init subsys_restart_init(void)
 	if (ret)
 		goto err_soc;
 
+	subsys_notif_debugfs_init();
+
 	return 0;
 
 err_soc:
@@ -1643,6 +1645,7 @@ arch_initcall(subsys_restart_init);
 
 static void __exit subsys_restart_exit(void)
 {
+	subsys_notif_debugfs_exit();
 	atomic_notifier_chain_unregister(&panic_notifier_list, &panic_nb);
 	class_destroy(char_class);
 	bus_unregister(&subsys_bus_type);
@@ -30,6 +30,8 @@
 #include <soc/qcom/secure_buffer.h>
 #include <linux/soc/qcom/smem.h>
 #include <linux/kthread.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
 
 #include <linux/uaccess.h>
 #include <asm/setup.h>
@@ -69,6 +71,7 @@ module_param(proxy_timeout_ms, int, 0644);
 static bool disable_timeouts;
 
 static struct workqueue_struct *pil_wq;
+static struct dentry *pil_debugfs_dir;
 
 /**
  * struct pil_mdt - Representation of <name>.mdt file in memory
@@ -88,6 +91,7 @@ struct pil_mdt {
  * @filesz: size of segment on disk
  * @num: segment number
  * @relocated: true if segment is relocated, false otherwise
+ * @load_ns: time taken to load and verify the segment on the last boot
  *
  * Loosely based on an elf program header. Contains all necessary information
  * to load and initialize a segment of the image in memory.
@@ -99,6 +103,7 @@ struct pil_seg {
 	int num;
 	struct list_head list;
 	bool relocated;
+	u64 load_ns;
 };
 
 /**
@@ -973,6 +978,7 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 		.dev = desc->dev,
 	};
 	void *map_data = desc->map_data ? desc->map_data : &map_fw_info;
+	ktime_t start = ktime_get();
 
 	if (seg->filesz) {
 		snprintf(fw_name, ARRAY_SIZE(fw_name), "%s.b%02d",
@@ -984,6 +990,10 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 			return -ENOMEM;
 		}
 
+		/*
+		 * With CONFIG_FW_LOADER_COMPRESS a "<name>.bXX.xz" blob is
+		 * decompressed in one shot straight into the mapped region.
+		 */
 		ret = request_firmware_into_buf(&fw, fw_name, desc->dev,
 						firmware_buf, seg->filesz);
 		desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
@@ -1032,6 +1042,8 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 								num, ret);
 	}
 
+	seg->load_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
 	return ret;
 }
 
@@ -1170,6 +1182,28 @@ static int pil_load_segs(struct pil_desc *desc)
 	return ret;
 }
 
+static void pil_account_segs(struct pil_desc *desc)
+{
+	struct pil_boot_stats *stats = &desc->priv->stats;
+	struct pil_seg *seg;
+
+	stats->seg_max_ns = 0;
+	stats->bytes = 0;
+	list_for_each_entry(seg, &desc->priv->segs, list) {
+		stats->seg_max_ns = max(stats->seg_max_ns, seg->load_ns);
+		stats->bytes += seg->filesz;
+	}
+}
+
+static u64 pil_elapsed_ns(ktime_t *stamp)
+{
+	ktime_t now = ktime_get();
+	u64 delta = ktime_to_ns(ktime_sub(now, *stamp));
+
+	*stamp = now;
+	return delta;
+}
+
 /**
  * pil_boot() - Load a peripheral image into memory and boot it
  * @desc: descriptor from pil_desc_init()
@@ -1185,8 +1219,11 @@ int pil_boot(struct pil_desc *desc)
 	const struct elf32_hdr *ehdr;
 	const struct firmware *fw;
 	struct pil_priv *priv = desc->priv;
+	struct pil_boot_stats *stats = &priv->stats;
 	bool mem_protect = false;
 	bool hyp_assign = false;
+	ktime_t boot_start = ktime_get();
+	ktime_t stamp = boot_start;
 
 	ret = pil_notify_aop(desc, "on");
 	if (ret < 0) {
@@ -1256,6 +1293,7 @@ int pil_boot(struct pil_desc *desc)
 		pil_err(desc, "Initializing image failed(rc:%d)\n", ret);
 		goto err_boot;
 	}
+	stats->image_ns = pil_elapsed_ns(&stamp);
 
 	trace_pil_event("before_mem_setup", desc);
 	if (desc->ops->mem_setup)
@@ -1294,6 +1332,7 @@ int pil_boot(struct pil_desc *desc)
 		hyp_assign = true;
 	}
 
+	stats->mem_ns = pil_elapsed_ns(&stamp);
 	trace_pil_event("before_load_seg", desc);
 
 	/**
@@ -1324,6 +1363,8 @@ int pil_boot(struct pil_desc *desc)
 		}
 		hyp_assign = false;
 	}
+	stats->load_ns = pil_elapsed_ns(&stamp);
+	pil_account_segs(desc);
 
 	trace_pil_event("before_auth_reset", desc);
 	notify_before_auth_and_reset(desc->dev);
@@ -1333,13 +1374,18 @@ int pil_boot(struct pil_desc *desc)
 		goto err_auth_and_reset;
 	}
 	trace_pil_event("reset_done", desc);
+	stats->auth_ns = pil_elapsed_ns(&stamp);
+	stats->total_ns = ktime_to_ns(ktime_sub(stamp, boot_start));
+	stats->boots++;
 
 #ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
 	if (!strcmp(desc->name, "modem"))
 		place_marker("M - Modem out of reset");
 #endif
 
-	pil_info(desc, "Brought out of reset\n");
+	pil_info(desc, "Brought out of reset in %llu ms (load %llu ms, %zu bytes)\n",
+		 div_u64(stats->total_ns, NSEC_PER_MSEC),
+		 div_u64(stats->load_ns, NSEC_PER_MSEC), stats->bytes);
 	desc->modem_ssr = false;
 err_auth_and_reset:
 	if (ret && desc->subsys_vmid > 0) {
@@ -1477,6 +1523,31 @@ static int collect_aux_minidump_ids(struct pil_desc *desc)
 	return 0;
 }
 
+static int pil_stats_show(struct seq_file *s, void *unused)
+{
+	struct pil_desc *desc = s->private;
+	struct pil_boot_stats *stats = &desc->priv->stats;
+
+	seq_printf(s, "boots:       %u\n", stats->boots);
+	seq_printf(s, "segments:    %d\n", desc->priv->num_segs);
+	seq_printf(s, "bytes:       %zu\n", stats->bytes);
+	seq_printf(s, "image_us:    %llu\n",
+		   div_u64(stats->image_ns, NSEC_PER_USEC));
+	seq_printf(s, "mem_us:      %llu\n",
+		   div_u64(stats->mem_ns, NSEC_PER_USEC));
+	seq_printf(s, "load_us:     %llu\n",
+		   div_u64(stats->load_ns, NSEC_PER_USEC));
+	seq_printf(s, "seg_max_us:  %llu\n",
+		   div_u64(stats->seg_max_ns, NSEC_PER_USEC));
+	seq_printf(s, "auth_us:     %llu\n",
+		   div_u64(stats->auth_ns, NSEC_PER_USEC));
+	seq_printf(s, "total_us:    %llu\n",
+		   div_u64(stats->total_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(pil_stats);
+
 /**
  * pil_desc_init() - Initialize a pil descriptor
  * @desc: descriptor to initialize
@@ -1588,6 +1659,11 @@ int pil_desc_init(struct pil_desc *desc)
 	desc->minidump_as_elf32 = of_property_read_bool(
 					ofnode, "qcom,minidump-as-elf32");
 
+	if (pil_debugfs_dir)
+		priv->debugfs = debugfs_create_file(desc->name, 0400,
+						    pil_debugfs_dir, desc,
+						    &pil_stats_fops);
+
 	return 0;
 err_parse_dt:
 	ida_simple_remove(&pil_ida, priv->id);
@@ -1608,6 +1684,7 @@ void pil_desc_release(struct pil_desc *desc)
 	struct pil_priv *priv = desc->priv;
 
 	if (priv) {
+		debugfs_remove(priv->debugfs);
 		ida_simple_remove(&pil_ida, priv->id);
 		flush_delayed_work(&priv->proxy);
 		wakeup_source_unregister(priv->ws);
@@ -1688,12 +1765,17 @@ static int __init msm_pil_init(void)
 	if (!pil_wq)
 		pr_warn("pil: Defaulting to sequential firmware loading.\n");
 
+	pil_debugfs_dir = debugfs_create_dir("pil", NULL);
+	if (IS_ERR(pil_debugfs_dir))
+		pil_debugfs_dir = NULL;
+
 	return register_pm_notifier(&pil_pm_notifier);
 }
 subsys_initcall(msm_pil_init);
 
 static void __exit msm_pil_exit(void)
 {
+	debugfs_remove_recursive(pil_debugfs_dir);
 	if (pil_wq)
 		destroy_workqueue(pil_wq);
 	unregister_pm_notifier(&pil_pm_notifier);
@@ -14,6 +14,30 @@
 #define SECURE_PAGE_MAGIC 0xEEEEEEEE
 struct device;
 struct module;
+struct dentry;
+
+/**
+ * struct pil_boot_stats - Timing of the last pil_boot() of a descriptor
+ * @boots: number of successful boots
+ * @image_ns: time to fetch the mdt and authenticate its metadata
+ * @mem_ns: time spent in mem_setup and stage 2 assignment
+ * @load_ns: wall time to load and verify all segments
+ * @seg_max_ns: time of the slowest single segment
+ * @auth_ns: time spent in auth_and_reset
+ * @total_ns: wall time of the whole pil_boot()
+ * @bytes: number of bytes read from the file system into the region
+ */
+struct pil_boot_stats {
+	unsigned int boots;
+	u64 image_ns;
+	u64 mem_ns;
+	u64 load_ns;
+	u64 seg_max_ns;
+	u64 auth_ns;
+	u64 total_ns;
+	size_t bytes;
+};
+
 /**
  * struct pil_priv - Private state for a pil_desc
  * @proxy: work item used to run the proxy unvoting routine
@@ -29,6 +53,8 @@ struct module;
  * non-relocatable images
  * @region: region allocated for relocatable images
  * @unvoted_flag: flag to keep track if we have unvoted or not.
+ * @stats: timing of the last boot
+ * @debugfs: debugfs file exposing @stats
  *
  * This struct contains data for a pil_desc that should not be exposed outside
  * of this file. This structure points to the descriptor and the descriptor
@@ -51,6 +77,8 @@ struct pil_priv {
 	int id;
 	int unvoted_flag;
 	size_t region_size;
+	struct pil_boot_stats stats;
+	struct dentry *debugfs;
 };
 
 /**
@@ -537,6 +537,7 @@ static struct platform_driver pmic_pon_log_driver = {
 	.driver = {
 		.name = "qti-pmic-pon-log",
 		.of_match_table	= of_match_ptr(pmic_pon_log_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = pmic_pon_log_probe,
 	.remove = pmic_pon_log_remove,
@@ -773,6 +773,7 @@ static struct platform_driver battery_dbg_driver = {
 	.driver	= {
 		.name = "qti_battery_debug",
 		.of_match_table = battery_dbg_match_table,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe	= battery_dbg_probe,
 	.remove	= battery_dbg_remove,
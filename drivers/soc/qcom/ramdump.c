@@ -39,6 +39,7 @@ struct consumer_entry {
 	bool data_ready;
 	struct ramdump_device *rd_dev;
 	struct list_head list;
+	void *bounce;
 };
 
 struct ramdump_device {
@@ -89,6 +90,8 @@ static void reset_ramdump_entry(struct consumer_entry *entry)
 	struct ramdump_device *rd_dev = entry->rd_dev;
 
 	entry->data_ready = false;
+	kvfree(entry->bounce);
+	entry->bounce = NULL;
 	if (atomic_dec_return(&rd_dev->readers_left) == 0)
 		complete(&rd_dev->ramdump_complete);
 }
@@ -112,6 +115,7 @@ static int ramdump_release(struct inode *inode, struct file *filep)
 	list_del(&entry->list);
 	mutex_unlock(&rd_dev->consumer_lock);
 	entry->rd_dev = NULL;
+	kvfree(entry->bounce);
 	kfree(entry);
 	return 0;
 }
@@ -159,7 +163,7 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 	unsigned long data_left = 0, bytes_before, bytes_after;
 	unsigned long addr = 0;
 	size_t copy_size = 0, alignsize;
-	unsigned char *alignbuf = NULL, *finalbuf = NULL;
+	unsigned char *alignbuf = NULL;
 	int ret = 0;
 	int srcu_idx;
 	loff_t orig_pos = *pos;
@@ -224,14 +228,20 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 
 	origdevice_mem = device_mem;
 
-	alignbuf = kzalloc(copy_size, GFP_KERNEL);
-	if (!alignbuf) {
-		rd_dev->ramdump_status = -1;
-		ret = -ENOMEM;
-		goto ramdump_done;
+	/*
+	 * The bounce buffer lives for the whole dump session, so a linear
+	 * reader doesn't pay for a fresh 1M allocation on every read().
+	 */
+	if (!entry->bounce) {
+		entry->bounce = kvmalloc(MAX_IOREMAP_SIZE, GFP_KERNEL);
+		if (!entry->bounce) {
+			rd_dev->ramdump_status = -1;
+			ret = -ENOMEM;
+			goto ramdump_done;
+		}
 	}
 
-	finalbuf = alignbuf;
+	alignbuf = entry->bounce;
 	alignsize = copy_size;
 
 	if ((unsigned long)device_mem & 0x7) {
@@ -255,7 +265,7 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		memcpy_fromio(alignbuf, device_mem, alignsize);
 	}
 
-	if (copy_to_user(buf, finalbuf, copy_size)) {
+	if (copy_to_user(buf, entry->bounce, copy_size)) {
 		pr_err("Ramdump(%s): Couldn't copy all data to user.\n",
 			rd_dev->name);
 		rd_dev->ramdump_status = -1;
@@ -263,7 +273,6 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 		goto ramdump_done;
 	}
 
-	kfree(finalbuf);
 	if (!vaddr && origdevice_mem)
 		iounmap(origdevice_mem);
 
@@ -278,7 +287,6 @@ static ssize_t ramdump_read(struct file *filep, char __user *buf, size_t count,
 
 ramdump_done:
 	srcu_read_unlock(&rd_dev->rd_srcu, srcu_idx);
-	kfree(finalbuf);
 	if (!vaddr && origdevice_mem)
 		iounmap(origdevice_mem);
 	*pos = 0;
@@ -5,6 +5,8 @@
 #define __RPM_INTERNAL_H__
 
 #include <linux/bitmap.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 #include <soc/qcom/tcs.h>
 
 #define TCS_TYPE_NR			4
@@ -13,6 +15,10 @@
 #define MAX_TCS_NR			(MAX_TCS_PER_TYPE * TCS_TYPE_NR)
 #define MAX_TCS_SLOTS			(MAX_CMDS_PER_TCS * MAX_TCS_PER_TYPE)
 
+#define RSC_LAT_BUCKETS			10
+#define RSC_STATS_ADDRS			64
+#define RSC_STATS_CLIENTS		32
+
 struct rsc_drv;
 
 /**
@@ -62,6 +68,27 @@ struct rpmh_request {
 	bool needs_free;
 };
 
+/**
+ * struct rpmh_agg: coalescing of async active-only votes across clients
+ *
+ * @lock: synchronize access to the pending commands
+ * @send_lock: order sends of the pending commands against direct sends
+ * @cmds: pending commands, at most one per resource address
+ * @num_cmds: number of valid entries in @cmds
+ * @dev: device of the first request in the pending commands
+ * @timer: ends the coalescing window
+ * @work: sends the pending commands once the window ends
+ */
+struct rpmh_agg {
+	spinlock_t lock;
+	spinlock_t send_lock;
+	struct tcs_cmd cmds[MAX_RPMH_PAYLOAD];
+	u32 num_cmds;
+	const struct device *dev;
+	struct hrtimer timer;
+	struct work_struct work;
+};
+
 /**
  * struct rpmh_ctrlr: our representation of the controller
  *
@@ -70,6 +97,7 @@ struct rpmh_request {
  * @dirty: was the cache updated since flush
  * @batch_cache: Cache sleep and wake requests sent as batch
  * @in_solver_mode: Controller is busy in solver mode
+ * @agg: coalescing state for async active-only votes
  */
 struct rpmh_ctrlr {
 	struct list_head cache;
@@ -77,6 +105,62 @@ struct rpmh_ctrlr {
 	bool dirty;
 	struct list_head batch_cache;
 	bool in_solver_mode;
+	struct rpmh_agg agg;
+};
+
+/**
+ * struct rsc_addr_stats: active votes sent to one resource address
+ *
+ * @addr:      the resource address
+ * @last_data: the most recent value voted
+ * @count:     number of active votes sent
+ */
+struct rsc_addr_stats {
+	u32 addr;
+	u32 last_data;
+	u64 count;
+};
+
+/**
+ * struct rsc_client_stats: requests made by one client device
+ *
+ * @dev:  the client device
+ * @reqs: number of requests, of any state
+ * @cmds: number of commands in those requests
+ */
+struct rsc_client_stats {
+	const struct device *dev;
+	u64 reqs;
+	u64 cmds;
+};
+
+/**
+ * struct rsc_stats: transaction statistics of a DRV, exported in debugfs
+ *
+ * @lock:            synchronize updates to the counters
+ * @send_ts:         time each active TCS was triggered, 0 when not in use
+ * @nr_sent:         number of active requests sent
+ * @nr_busy:         number of tcs_write() retries because no TCS was free
+ * @busy_wait_us:    total time spent waiting for a free TCS
+ * @max_lat_us:      longest send to completion latency seen
+ * @lat_hist:        send to completion latency, log2 buckets from 8us
+ * @addrs:           per resource address vote counts
+ * @addr_overflow:   votes to addresses that did not fit in @addrs
+ * @clients:         per client request counts
+ * @client_overflow: requests from clients that did not fit in @clients
+ */
+struct rsc_stats {
+	spinlock_t lock;
+	ktime_t send_ts[MAX_TCS_NR];
+	u64 nr_sent;
+	u64 nr_busy;
+	u64 busy_wait_us;
+	u64 max_lat_us;
+	u64 lat_hist[RSC_LAT_BUCKETS];
+	struct rsc_addr_stats addrs[RSC_STATS_ADDRS];
+	u64 addr_overflow;
+	struct rsc_client_stats clients[RSC_STATS_CLIENTS];
+	u64 client_overflow;
 };
 
 /**
@@ -95,6 +179,7 @@ struct rpmh_ctrlr {
  * @client:     handle to the DRV's client.
  * @irq:        IRQ at gic
  * @ipc_log_ctx IPC logger handle
+ * @stats:      transaction statistics
  */
 struct rsc_drv {
 	const char *name;
@@ -109,6 +194,7 @@ struct rsc_drv {
 	struct rpmh_ctrlr client;
 	int irq;
 	void *ipc_log_ctx;
+	struct rsc_stats stats;
 };
 
 extern bool rpmh_standalone;
@@ -122,6 +208,9 @@ bool rpmh_rsc_ctrlr_is_idle(struct rsc_drv *drv);
 int rpmh_rsc_write_pdc_data(struct rsc_drv *drv, const struct tcs_request *msg);
 
 void rpmh_tx_done(const struct tcs_request *msg, int r);
+void rpmh_ctrlr_agg_init(struct rpmh_ctrlr *ctrlr);
 
 void rpmh_rsc_debug(struct rsc_drv *drv, struct completion *compl);
+void rpmh_rsc_note_client(struct rsc_drv *drv, const struct device *dev,
+			  u32 num_cmds);
 #endif /* __RPM_INTERNAL_H__ */
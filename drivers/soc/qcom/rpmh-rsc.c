@@ -4,6 +4,7 @@
 #define pr_fmt(fmt) "%s " fmt, KBUILD_MODNAME
 
 #include <linux/atomic.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
@@ -14,6 +15,7 @@
 #include <linux/of_irq.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 
@@ -77,6 +79,7 @@ static const char * const accl_str[] = {
 
 static struct rsc_drv *__rsc_drv[2];
 static int __rsc_count;
+static struct dentry *rsc_debugfs_root;
 
 bool rpmh_standalone;
 
@@ -256,6 +259,87 @@ static inline void enable_tcs_irq(struct rsc_drv *drv, int tcs_id, bool enable)
 	write_tcs_reg(drv, RSC_DRV_IRQ_ENABLE, 0, data);
 }
 
+static void rsc_stats_tx_done(struct rsc_drv *drv, int tcs_id)
+{
+	struct rsc_stats *stats = &drv->stats;
+	u64 lat;
+	int idx;
+
+	if (!stats->send_ts[tcs_id])
+		return;
+
+	lat = ktime_us_delta(ktime_get(), stats->send_ts[tcs_id]);
+	stats->send_ts[tcs_id] = 0;
+	idx = lat < 8 ? 0 : min(ilog2(lat) - 2, RSC_LAT_BUCKETS - 1);
+
+	spin_lock(&stats->lock);
+	stats->lat_hist[idx]++;
+	stats->max_lat_us = max(stats->max_lat_us, lat);
+	spin_unlock(&stats->lock);
+}
+
+static void rsc_stats_sent(struct rsc_drv *drv, const struct tcs_request *msg,
+			   u64 busy_us, u32 nr_busy)
+{
+	struct rsc_stats *stats = &drv->stats;
+	unsigned long flags;
+	int i, j;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->nr_sent++;
+	stats->nr_busy += nr_busy;
+	stats->busy_wait_us += busy_us;
+
+	for (i = 0; i < msg->num_cmds; i++) {
+		u32 addr = msg->cmds[i].addr;
+
+		for (j = 0; j < RSC_STATS_ADDRS; j++) {
+			if (!stats->addrs[j].count || stats->addrs[j].addr == addr)
+				break;
+		}
+
+		if (j == RSC_STATS_ADDRS) {
+			stats->addr_overflow++;
+			continue;
+		}
+
+		stats->addrs[j].addr = addr;
+		stats->addrs[j].last_data = msg->cmds[i].data;
+		stats->addrs[j].count++;
+	}
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+/**
+ * rpmh_rsc_note_client: Account a request made by a client of the DRV
+ *
+ * @drv: the controller
+ * @dev: the client device
+ * @num_cmds: number of commands in the request
+ */
+void rpmh_rsc_note_client(struct rsc_drv *drv, const struct device *dev,
+			  u32 num_cmds)
+{
+	struct rsc_stats *stats = &drv->stats;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	for (i = 0; i < RSC_STATS_CLIENTS; i++) {
+		if (!stats->clients[i].dev || stats->clients[i].dev == dev)
+			break;
+	}
+
+	if (i == RSC_STATS_CLIENTS) {
+		stats->client_overflow++;
+	} else {
+		stats->clients[i].dev = dev;
+		stats->clients[i].reqs++;
+		stats->clients[i].cmds += num_cmds;
+	}
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
 /**
  * tcs_tx_done: TX Done interrupt handler
  */
@@ -291,6 +375,7 @@ static irqreturn_t tcs_tx_done(int irq, void *p)
 		}
 
 		trace_rpmh_tx_done(drv, i, req, err);
+		rsc_stats_tx_done(drv, i);
 		ipc_log_string(drv->ipc_log_ctx,
 			       "IRQ response: m=%d err=%d", i, err);
 
@@ -438,6 +523,9 @@ static int tcs_write(struct rsc_drv *drv, const struct tcs_request *msg)
 		enable_tcs_irq(drv, tcs_id, true);
 	spin_unlock(&drv->lock);
 
+	if (msg->state == RPMH_ACTIVE_ONLY_STATE)
+		drv->stats.send_ts[tcs_id] = ktime_get();
+
 	__tcs_buffer_write(drv, tcs_id, 0, msg);
 	__tcs_trigger(drv, tcs_id, true);
 
@@ -458,6 +546,8 @@ static int tcs_write(struct rsc_drv *drv, const struct tcs_request *msg)
  */
 int rpmh_rsc_send_data(struct rsc_drv *drv, const struct tcs_request *msg)
 {
+	ktime_t busy_start = 0;
+	u32 nr_busy = 0;
 	int ret;
 
 	if (!msg || !msg->cmds || !msg->num_cmds ||
@@ -479,10 +569,17 @@ int rpmh_rsc_send_data(struct rsc_drv *drv, const struct tcs_request *msg)
 					    irq_sts ?
 					    "PENDING" : "NOT PENDING");
 #endif /* QCOM_RPMH_QGKI_DEBUG */
+			if (!nr_busy++)
+				busy_start = ktime_get();
 			udelay(10);
 		}
 	} while (ret == -EBUSY);
 
+	if (!ret)
+		rsc_stats_sent(drv, msg, nr_busy ?
+			       ktime_us_delta(ktime_get(), busy_start) : 0,
+			       nr_busy);
+
 	return ret;
 }
 
@@ -922,6 +1019,9 @@ static int rpmh_rsc_probe(struct platform_device *pdev)
 	spin_lock_init(&drv->client.cache_lock);
 	INIT_LIST_HEAD(&drv->client.cache);
 	INIT_LIST_HEAD(&drv->client.batch_cache);
+	rpmh_ctrlr_agg_init(&drv->client);
+	spin_lock_init(&drv->stats.lock);
+	rsc_debugfs_init(drv);
 
 	drv->ipc_log_ctx = ipc_log_context_create(RSC_DRV_IPC_LOG_SIZE,
 						  drv->name, 0);
@@ -932,6 +1032,100 @@ static int rpmh_rsc_probe(struct platform_device *pdev)
 	return devm_of_platform_populate(&pdev->dev);
 }
 
+static int rsc_stats_show(struct seq_file *m, void *unused)
+{
+	struct rsc_drv *drv = m->private;
+	struct rsc_stats *stats;
+	unsigned long flags;
+	int i;
+
+	stats = kmalloc(sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&drv->stats.lock, flags);
+	memcpy(stats, &drv->stats, sizeof(*stats));
+	spin_unlock_irqrestore(&drv->stats.lock, flags);
+
+	seq_printf(m, "sent: %llu\n", stats->nr_sent);
+	seq_printf(m, "tcs_busy_retries: %llu\n", stats->nr_busy);
+	seq_printf(m, "tcs_busy_wait_us: %llu\n", stats->busy_wait_us);
+	seq_printf(m, "max_latency_us: %llu\n", stats->max_lat_us);
+
+	seq_puts(m, "\nlatency (us)\tcount\n");
+	for (i = 0; i < RSC_LAT_BUCKETS - 1; i++)
+		seq_printf(m, "<%u\t\t%llu\n", 8U << i, stats->lat_hist[i]);
+	seq_printf(m, ">=%u\t\t%llu\n", 8U << (i - 1), stats->lat_hist[i]);
+
+	seq_puts(m, "\naddr\t\tlast_data\tvotes\n");
+	for (i = 0; i < RSC_STATS_ADDRS && stats->addrs[i].count; i++)
+		seq_printf(m, "%#-10x\t%#-10x\t%llu\n", stats->addrs[i].addr,
+			   stats->addrs[i].last_data, stats->addrs[i].count);
+	if (stats->addr_overflow)
+		seq_printf(m, "other\t\t\t\t%llu\n", stats->addr_overflow);
+
+	seq_puts(m, "\nclient\t\t\t\treqs\tcmds\n");
+	for (i = 0; i < RSC_STATS_CLIENTS && stats->clients[i].dev; i++)
+		seq_printf(m, "%-32s\t%llu\t%llu\n",
+			   dev_name(stats->clients[i].dev),
+			   stats->clients[i].reqs, stats->clients[i].cmds);
+	if (stats->client_overflow)
+		seq_printf(m, "%-32s\t%llu\n", "other",
+			   stats->client_overflow);
+
+	kfree(stats);
+
+	return 0;
+}
+
+static int rsc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rsc_stats_show, inode->i_private);
+}
+
+/* Any write clears the counters, e.g. before a suspend/resume cycle. */
+static ssize_t rsc_stats_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct rsc_drv *drv = m->private;
+	struct rsc_stats *stats = &drv->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->nr_sent = 0;
+	stats->nr_busy = 0;
+	stats->busy_wait_us = 0;
+	stats->max_lat_us = 0;
+	memset(stats->lat_hist, 0, sizeof(stats->lat_hist));
+	memset(stats->addrs, 0, sizeof(stats->addrs));
+	stats->addr_overflow = 0;
+	memset(stats->clients, 0, sizeof(stats->clients));
+	stats->client_overflow = 0;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	return count;
+}
+
+static const struct file_operations rsc_stats_fops = {
+	.open = rsc_stats_open,
+	.read = seq_read,
+	.write = rsc_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void rsc_debugfs_init(struct rsc_drv *drv)
+{
+	struct dentry *dir;
+
+	if (!rsc_debugfs_root)
+		rsc_debugfs_root = debugfs_create_dir("rpmh", NULL);
+
+	dir = debugfs_create_dir(drv->name, rsc_debugfs_root);
+	debugfs_create_file("stats", 0600, dir, drv, &rsc_stats_fops);
+}
+
 static const struct of_device_id rpmh_drv_match[] = {
 	{ .compatible = "qcom,rpmh-rsc", },
 	{ }
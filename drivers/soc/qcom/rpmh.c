@@ -37,6 +37,14 @@
 
 #define ctrlr_to_drv(ctrlr) container_of(ctrlr, struct rsc_drv, client)
 
+/*
+ * Window in microseconds over which rpmh_write_async() active-only votes
+ * from all clients are coalesced into a single TCS transaction, keeping only
+ * the latest value per resource address. 0 sends every request on its own.
+ */
+static unsigned int coalesce_us;
+module_param(coalesce_us, uint, 0644);
+
 /**
  * struct cache_req: the request object for caching
  *
@@ -102,6 +110,10 @@ int rpmh_mode_solver_set(const struct device *dev, bool enable)
 	struct rpmh_ctrlr *ctrlr = get_rpmh_ctrlr(dev);
 	unsigned long flags;
 
+	/* Active votes can not be sent once in solver mode */
+	if (enable)
+		agg_flush(ctrlr);
+
 	spin_lock_irqsave(&ctrlr->cache_lock, flags);
 	rpmh_rsc_mode_solver_set(ctrlr_to_drv(ctrlr), enable);
 	ctrlr->in_solver_mode = enable;
@@ -135,6 +147,150 @@ void rpmh_tx_done(const struct tcs_request *msg, int r)
 		kfree(rpm_msg);
 }
 
+/*
+ * Send the pending coalesced commands, if any. Must be called with
+ * agg->send_lock held so that a later direct send cannot overtake an
+ * older value for the same address.
+ */
+static int __agg_send_pending(struct rpmh_ctrlr *ctrlr)
+{
+	struct rpmh_agg *agg = &ctrlr->agg;
+	struct rpmh_request *rpm_msg;
+	unsigned long flags;
+	int ret;
+
+	if (!READ_ONCE(agg->num_cmds))
+		return 0;
+
+	rpm_msg = kzalloc(sizeof(*rpm_msg), GFP_ATOMIC);
+	if (!rpm_msg)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&agg->lock, flags);
+	memcpy(rpm_msg->cmd, agg->cmds, agg->num_cmds * sizeof(*agg->cmds));
+	rpm_msg->msg.state = RPMH_ACTIVE_ONLY_STATE;
+	rpm_msg->msg.cmds = rpm_msg->cmd;
+	rpm_msg->msg.num_cmds = agg->num_cmds;
+	rpm_msg->dev = agg->dev;
+	rpm_msg->needs_free = true;
+	agg->num_cmds = 0;
+	agg->dev = NULL;
+	spin_unlock_irqrestore(&agg->lock, flags);
+
+	if (!rpm_msg->msg.num_cmds) {
+		kfree(rpm_msg);
+		return 0;
+	}
+
+	ret = rpmh_rsc_send_data(ctrlr_to_drv(ctrlr), &rpm_msg->msg);
+	if (ret)
+		kfree(rpm_msg);
+
+	return ret;
+}
+
+static int agg_flush(struct rpmh_ctrlr *ctrlr)
+{
+	int ret;
+
+	spin_lock(&ctrlr->agg.send_lock);
+	ret = __agg_send_pending(ctrlr);
+	spin_unlock(&ctrlr->agg.send_lock);
+
+	return ret;
+}
+
+static int agg_find(struct rpmh_agg *agg, u32 addr)
+{
+	int i;
+
+	for (i = 0; i < agg->num_cmds; i++)
+		if (agg->cmds[i].addr == addr)
+			return i;
+
+	return -ENODATA;
+}
+
+/*
+ * Add the commands of an async active-only request to the pending set.
+ * A command for an address that is already pending replaces its value.
+ * If the new commands do not fit, the pending set is sent first.
+ */
+static int agg_queue(struct rpmh_ctrlr *ctrlr, const struct device *dev,
+		     const struct tcs_request *msg)
+{
+	struct rpmh_agg *agg = &ctrlr->agg;
+	unsigned long flags;
+	int i, idx, need, ret;
+
+retry:
+	spin_lock_irqsave(&agg->lock, flags);
+	need = agg->num_cmds;
+	for (i = 0; i < msg->num_cmds; i++)
+		if (agg_find(agg, msg->cmds[i].addr) < 0)
+			need++;
+
+	if (need > MAX_RPMH_PAYLOAD) {
+		spin_unlock_irqrestore(&agg->lock, flags);
+		ret = agg_flush(ctrlr);
+		if (ret)
+			return ret;
+		goto retry;
+	}
+
+	for (i = 0; i < msg->num_cmds; i++) {
+		idx = agg_find(agg, msg->cmds[i].addr);
+		if (idx < 0) {
+			agg->cmds[agg->num_cmds++] = msg->cmds[i];
+			continue;
+		}
+		agg->cmds[idx].data = msg->cmds[i].data;
+		agg->cmds[idx].wait |= msg->cmds[i].wait;
+	}
+
+	if (!agg->dev)
+		agg->dev = dev;
+
+	if (!hrtimer_is_queued(&agg->timer))
+		hrtimer_start(&agg->timer,
+			      ns_to_ktime((u64)coalesce_us * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	spin_unlock_irqrestore(&agg->lock, flags);
+
+	return 0;
+}
+
+static enum hrtimer_restart agg_timer_fn(struct hrtimer *timer)
+{
+	struct rpmh_agg *agg = container_of(timer, struct rpmh_agg, timer);
+
+	queue_work(system_highpri_wq, &agg->work);
+
+	return HRTIMER_NORESTART;
+}
+
+static void agg_work_fn(struct work_struct *work)
+{
+	struct rpmh_agg *agg = container_of(work, struct rpmh_agg, work);
+	struct rpmh_ctrlr *ctrlr = container_of(agg, struct rpmh_ctrlr, agg);
+	int ret;
+
+	ret = agg_flush(ctrlr);
+	if (ret)
+		pr_err("Error(%d) sending coalesced RPMH votes\n", ret);
+}
+
+void rpmh_ctrlr_agg_init(struct rpmh_ctrlr *ctrlr)
+{
+	struct rpmh_agg *agg = &ctrlr->agg;
+
+	spin_lock_init(&agg->lock);
+	spin_lock_init(&agg->send_lock);
+	hrtimer_init(&agg->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	agg->timer.function = agg_timer_fn;
+	INIT_WORK(&agg->work, agg_work_fn);
+}
+
 static struct cache_req *__find_req(struct rpmh_ctrlr *ctrlr, u32 addr)
 {
 	struct cache_req *p, *req = NULL;
@@ -222,6 +378,7 @@ static int __rpmh_write(const struct device *dev, enum rpmh_state state,
 	int i;
 
 	rpm_msg->msg.state = state;
+	rpmh_rsc_note_client(ctrlr_to_drv(ctrlr), dev, rpm_msg->msg.num_cmds);
 
 	/* Cache the request in our store and link the payload */
 	for (i = 0; i < rpm_msg->msg.num_cmds; i++) {
@@ -234,7 +391,19 @@ static int __rpmh_write(const struct device *dev, enum rpmh_state state,
 
 	if (state == RPMH_ACTIVE_ONLY_STATE) {
 		WARN_ON(irqs_disabled());
-		ret = rpmh_rsc_send_data(ctrlr_to_drv(ctrlr), &rpm_msg->msg);
+		if (READ_ONCE(coalesce_us) && rpm_msg->needs_free &&
+		    !rpm_msg->completion) {
+			ret = agg_queue(ctrlr, dev, &rpm_msg->msg);
+			kfree(rpm_msg);
+			return ret;
+		}
+
+		spin_lock(&ctrlr->agg.send_lock);
+		ret = __agg_send_pending(ctrlr);
+		if (!ret)
+			ret = rpmh_rsc_send_data(ctrlr_to_drv(ctrlr),
+						 &rpm_msg->msg);
+		spin_unlock(&ctrlr->agg.send_lock);
 	} else {
 		/* Clean up our call by spoofing tx_done */
 		ret = 0;
@@ -454,6 +623,7 @@ int rpmh_write_batch(const struct device *dev, enum rpmh_state state,
 		if (ret)
 			goto exit;
 
+		rpmh_rsc_note_client(ctrlr_to_drv(ctrlr), dev, n[i]);
 		cmd += n[i];
 	}
 
@@ -462,7 +632,9 @@ int rpmh_write_batch(const struct device *dev, enum rpmh_state state,
 		return 0;
 	}
 
-	for (i = 0; i < count; i++) {
+	spin_lock(&ctrlr->agg.send_lock);
+	ret = __agg_send_pending(ctrlr);
+	for (i = 0; !ret && i < count; i++) {
 		struct completion *compl = &compls[i];
 
 		init_completion(compl);
@@ -474,6 +646,7 @@ int rpmh_write_batch(const struct device *dev, enum rpmh_state state,
 			break;
 		}
 	}
+	spin_unlock(&ctrlr->agg.send_lock);
 
 	time_left = RPMH_TIMEOUT_MS;
 	while (i--) {
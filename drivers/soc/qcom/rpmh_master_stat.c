@@ -278,6 +278,7 @@ static struct platform_driver msm_rpmh_master_stats_driver = {
 	.driver = {
 		.name = "msm_rpmh_master_stats",
 		.of_match_table = rpmh_master_table,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
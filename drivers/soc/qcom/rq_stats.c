@@ -7,15 +7,181 @@
 #include <linux/cpu.h>
 #include <linux/kobject.h>
 #include <linux/sysfs.h>
+#include <linux/topology.h>
+#include <linux/math64.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/stat.h>
 #include <linux/rq_stats.h>
 
 #define MAX_LONG_SIZE 24
 #define DEFAULT_DEF_TIMER_JIFFIES 5
+#define DEFAULT_SAMPLE_MS 20
+#define DEFAULT_WAIT_THRESH 100
 
 struct rq_data rq_info;
 struct workqueue_struct *rq_wq;
 spinlock_t rq_lock;
 
+/*
+ * Per-cluster runnable and wait averages (tasks * 100) over the last
+ * sample period. Crossing wait_thresh in either direction notifies
+ * pollers of cluster_stats, so userspace need not poll on a timer.
+ */
+struct rq_cluster {
+	cpumask_t cpus;
+	u64 prev_run;
+	u64 prev_wait;
+	unsigned int run_avg;
+	unsigned int wait_avg;
+	bool over_thresh;
+};
+
+static struct rq_cluster rq_clusters[NR_CPUS];
+static int nr_rq_clusters;
+static u64 rq_sample_last;
+static unsigned int rq_sample_ms = DEFAULT_SAMPLE_MS;
+static unsigned int rq_wait_thresh = DEFAULT_WAIT_THRESH;
+static struct delayed_work rq_sample_work;
+
+static void rq_cluster_read(struct rq_cluster *cl, u64 *run, u64 *wait)
+{
+	u64 r, w;
+	int cpu;
+
+	*run = *wait = 0;
+	for_each_cpu(cpu, &cl->cpus) {
+		sched_get_nr_prod_total(cpu, &r, &w);
+		*run += r;
+		*wait += w;
+	}
+}
+
+static void rq_sample_fn(struct work_struct *work)
+{
+	u64 now = sched_clock(), period, run, wait;
+	bool notify = false, over;
+	unsigned long flags;
+	int i;
+
+	period = now - rq_sample_last;
+	if (!period)
+		goto out;
+
+	spin_lock_irqsave(&rq_lock, flags);
+	for (i = 0; i < nr_rq_clusters; i++) {
+		struct rq_cluster *cl = &rq_clusters[i];
+
+		rq_cluster_read(cl, &run, &wait);
+		cl->run_avg = div64_u64((run - cl->prev_run) * 100, period);
+		cl->wait_avg = div64_u64((wait - cl->prev_wait) * 100, period);
+		cl->prev_run = run;
+		cl->prev_wait = wait;
+
+		over = cl->wait_avg >= rq_wait_thresh;
+		if (over != cl->over_thresh) {
+			cl->over_thresh = over;
+			notify = true;
+		}
+	}
+	rq_sample_last = now;
+	spin_unlock_irqrestore(&rq_lock, flags);
+
+	if (notify)
+		sysfs_notify(rq_info.kobj, NULL, "cluster_stats");
+out:
+	if (rq_sample_ms)
+		queue_delayed_work(rq_wq, &rq_sample_work,
+				   msecs_to_jiffies(rq_sample_ms));
+}
+
+static void init_rq_clusters(void)
+{
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		for (i = 0; i < nr_rq_clusters; i++)
+			if (cpumask_test_cpu(cpu, &rq_clusters[i].cpus))
+				break;
+		if (i < nr_rq_clusters)
+			continue;
+		cpumask_and(&rq_clusters[nr_rq_clusters++].cpus,
+			    topology_core_cpumask(cpu), cpu_possible_mask);
+	}
+
+	rq_sample_last = sched_clock();
+	for (i = 0; i < nr_rq_clusters; i++)
+		rq_cluster_read(&rq_clusters[i], &rq_clusters[i].prev_run,
+				&rq_clusters[i].prev_wait);
+}
+
+static ssize_t show_cluster_stats(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	unsigned long flags;
+	ssize_t len = 0;
+	int i;
+
+	spin_lock_irqsave(&rq_lock, flags);
+	for (i = 0; i < nr_rq_clusters; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%*pbl run %u wait %u%s\n",
+				 cpumask_pr_args(&rq_clusters[i].cpus),
+				 rq_clusters[i].run_avg,
+				 rq_clusters[i].wait_avg,
+				 rq_clusters[i].over_thresh ? " over" : "");
+	spin_unlock_irqrestore(&rq_lock, flags);
+
+	return len;
+}
+
+static struct kobj_attribute cluster_stats_attr =
+	__ATTR(cluster_stats, 0444, show_cluster_stats, NULL);
+
+static ssize_t show_sample_ms(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return snprintf(buf, MAX_LONG_SIZE, "%u\n", rq_sample_ms);
+}
+
+static ssize_t store_sample_ms(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	rq_sample_ms = val;
+	if (val)
+		mod_delayed_work(rq_wq, &rq_sample_work,
+				 msecs_to_jiffies(val));
+	return count;
+}
+
+static struct kobj_attribute sample_ms_attr =
+	__ATTR(sample_ms, 0600, show_sample_ms, store_sample_ms);
+
+static ssize_t show_wait_thresh(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return snprintf(buf, MAX_LONG_SIZE, "%u\n", rq_wait_thresh);
+}
+
+static ssize_t store_wait_thresh(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	rq_wait_thresh = val;
+	return count;
+}
+
+static struct kobj_attribute wait_thresh_attr =
+	__ATTR(wait_thresh, 0600, show_wait_thresh, store_wait_thresh);
+
 static void def_work_fn(struct work_struct *work)
 {
 	/* Notify polling threads on change of value */
@@ -55,6 +221,9 @@ static struct kobj_attribute def_timer_ms_attr =
 
 static struct attribute *rq_attrs[] = {
 	&def_timer_ms_attr.attr,
+	&cluster_stats_attr.attr,
+	&sample_ms_attr.attr,
+	&wait_thresh_attr.attr,
 	NULL,
 };
 
@@ -101,6 +270,13 @@ static int __init msm_rq_stats_init(void)
 	rq_info.def_timer_last_jiffy = 0;
 	ret = init_rq_attribs();
 
+	init_rq_clusters();
+	/* deferrable: an idle system is not woken just to sample it */
+	INIT_DEFERRABLE_WORK(&rq_sample_work, rq_sample_fn);
+	if (rq_wq && rq_sample_ms)
+		queue_delayed_work(rq_wq, &rq_sample_work,
+				   msecs_to_jiffies(rq_sample_ms));
+
 	rq_info.init = 1;
 
 	return ret;
@@ -50,40 +50,54 @@ populate_dest_info(int *dest_vmids, int nelements, int *dest_perms,
 	return dest_info;
 }
 
+/* Walks the entries of several sg_tables as if they were one list */
+struct assign_cursor {
+	struct sg_table **tables;
+	int nr_tables;
+	int idx;
+	struct scatterlist *sgl;
+};
+
+static void assign_cursor_next(struct assign_cursor *cur)
+{
+	cur->sgl = sg_next(cur->sgl);
+	while (!cur->sgl && ++cur->idx < cur->nr_tables)
+		cur->sgl = cur->tables[cur->idx]->sgl;
+}
+
 static unsigned int get_batches_from_sgl(struct qcom_scm_mem_map_info *sgt_copy,
-					 struct scatterlist *sgl,
-					 struct scatterlist **next_sgl)
+					 struct assign_cursor *cur)
 {
 	u64 batch_size = 0;
 	unsigned int i = 0;
-	struct scatterlist *curr_sgl = sgl;
 
 	/* Ensure no zero size batches */
 	do {
 		qcom_scm_populate_mem_map_info(&sgt_copy[i],
-					       page_to_phys(sg_page(curr_sgl)),
-					       curr_sgl->length);
-		batch_size += curr_sgl->length;
-		curr_sgl = sg_next(curr_sgl);
+					       page_to_phys(sg_page(cur->sgl)),
+					       cur->sgl->length);
+		batch_size += cur->sgl->length;
+		assign_cursor_next(cur);
 		i++;
-	} while (curr_sgl && i < BATCH_MAX_SECTIONS &&
-		 curr_sgl->length + batch_size < BATCH_MAX_SIZE);
+	} while (cur->sgl && i < BATCH_MAX_SECTIONS &&
+		 cur->sgl->length + batch_size < BATCH_MAX_SIZE);
 
-	*next_sgl = curr_sgl;
 	return i;
 }
 
-static int batched_hyp_assign(struct sg_table *table, u32 *source_vmids,
-			      size_t source_size,
+static int batched_hyp_assign(struct sg_table **tables, int nr_tables,
+			      u32 *source_vmids, size_t source_size,
 			      struct qcom_scm_current_perm_info *destvms,
 			      size_t destvms_size)
 {
-	unsigned int batch_start = 0;
 	unsigned int batches_processed;
 	unsigned int i = 0;
 	u64 total_delta;
-	struct scatterlist *curr_sgl = table->sgl;
-	struct scatterlist *next_sgl;
+	struct assign_cursor cur = {
+		.tables = tables,
+		.nr_tables = nr_tables,
+		.sgl = tables[0]->sgl,
+	};
 	int ret = 0;
 	ktime_t batch_assign_start_ts;
 	ktime_t first_assign_ts;
@@ -97,10 +111,8 @@ static int batched_hyp_assign(struct sg_table *table, u32 *source_vmids,
 		return -ENOMEM;
 
 	first_assign_ts = ktime_get();
-	while (batch_start < table->nents) {
-		batches_processed = get_batches_from_sgl(mem_regions_buf,
-							 curr_sgl, &next_sgl);
-		curr_sgl = next_sgl;
+	while (cur.sgl) {
+		batches_processed = get_batches_from_sgl(mem_regions_buf, &cur);
 		mem_regions_buf_size = batches_processed *
 				       sizeof(*mem_regions_buf);
 		entries_dma_addr = dma_map_single(qcom_secure_buffer_dev,
@@ -137,8 +149,6 @@ static int batched_hyp_assign(struct sg_table *table, u32 *source_vmids,
 			ret = -EADDRNOTAVAIL;
 			break;
 		}
-
-		batch_start += batches_processed;
 	}
 	total_delta = ktime_us_delta(ktime_get(), first_assign_ts);
 	trace_hyp_assign_end(total_delta, div64_u64(total_delta, i));
@@ -173,13 +183,18 @@ int page_accessible(unsigned long pfn)
 }
 
 /*
+ * Assign the memory of several sg_tables to the same set of VMs. The
+ * entries of all tables are packed into shared batches, so the number
+ * of hypervisor calls depends on the total size rather than on the
+ * number of tables.
+ *
  *  When -EADDRNOTAVAIL is returned the memory may no longer be in
  *  a usable state and should no longer be accessed by the HLOS.
  */
-int hyp_assign_table(struct sg_table *table,
-			u32 *source_vm_list, int source_nelems,
-			int *dest_vmids, int *dest_perms,
-			int dest_nelems)
+int hyp_assign_table_batch(struct sg_table **tables, int nr_tables,
+			   u32 *source_vm_list, int source_nelems,
+			   int *dest_vmids, int *dest_perms,
+			   int dest_nelems)
 {
 	int ret = 0;
 	u32 *source_vm_copy;
@@ -187,14 +202,20 @@ int hyp_assign_table(struct sg_table *table,
 	struct qcom_scm_current_perm_info *dest_vm_copy;
 	size_t dest_vm_copy_size;
 	dma_addr_t source_dma_addr, dest_dma_addr;
+	u64 flag;
+	int i;
 
 	if (!qcom_secure_buffer_dev)
 		return -EPROBE_DEFER;
 
-	if (!table || !table->sgl || !source_vm_list || !source_nelems ||
-	    !dest_vmids || !dest_perms || !dest_nelems || !table->nents)
+	if (!tables || nr_tables <= 0 || !source_vm_list || !source_nelems ||
+	    !dest_vmids || !dest_perms || !dest_nelems)
 		return -EINVAL;
 
+	for (i = 0; i < nr_tables; i++)
+		if (!tables[i] || !tables[i]->sgl || !tables[i]->nents)
+			return -EINVAL;
+
 	/*
 	 * We can only pass cache-aligned sizes to hypervisor, so we need
 	 * to kmalloc and memcpy the source_vm_list here.
@@ -230,8 +251,9 @@ int hyp_assign_table(struct sg_table *table,
 			      dest_perms, dest_nelems);
 
 
-	ret = batched_hyp_assign(table, source_vm_copy, source_vm_copy_size,
-				 dest_vm_copy, dest_vm_copy_size);
+	ret = batched_hyp_assign(tables, nr_tables, source_vm_copy,
+				 source_vm_copy_size, dest_vm_copy,
+				 dest_vm_copy_size);
 
 	if (!ret) {
 		while (dest_nelems--) {
@@ -239,10 +261,9 @@ int hyp_assign_table(struct sg_table *table,
 				break;
 		}
 
-		if (dest_nelems == -1)
-			set_each_page_of_sg(table, SECURE_PAGE_MAGIC);
-		else
-			set_each_page_of_sg(table, 0);
+		flag = dest_nelems == -1 ? SECURE_PAGE_MAGIC : 0;
+		for (i = 0; i < nr_tables; i++)
+			set_each_page_of_sg(tables[i], flag);
 	}
 
 
@@ -257,6 +278,17 @@ int hyp_assign_table(struct sg_table *table,
 	kfree(source_vm_copy);
 	return ret;
 }
+EXPORT_SYMBOL(hyp_assign_table_batch);
+
+int hyp_assign_table(struct sg_table *table,
+			u32 *source_vm_list, int source_nelems,
+			int *dest_vmids, int *dest_perms,
+			int dest_nelems)
+{
+	return hyp_assign_table_batch(&table, 1, source_vm_list,
+				      source_nelems, dest_vmids, dest_perms,
+				      dest_nelems);
+}
 EXPORT_SYMBOL(hyp_assign_table);
 
 int hyp_assign_phys(phys_addr_t addr, u64 size, u32 *source_vm_list,
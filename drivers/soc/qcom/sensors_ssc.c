@@ -12,6 +12,12 @@
 #include <linux/cdev.h>
 #include <linux/fs.h>
 #include <linux/of_device.h>
+#include <linux/of_address.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
 #include <asm/arch_timer.h>
 #include <linux/uaccess.h>
 
@@ -40,6 +46,14 @@ struct sns_ssc_control_s {
 	dev_t dev_num;
 	struct device *dev;
 	struct cdev *cdev;
+
+	/* optional shared-memory sample ring, see struct sns_ring_hdr */
+	phys_addr_t ring_phys;
+	size_t ring_size;
+	struct sns_ring_hdr __iomem *ring;
+	int ring_irq;
+	wait_queue_head_t ring_wq;
+	atomic_t doorbells;
 };
 static struct sns_ssc_control_s sns_ctl;
 
@@ -302,6 +316,139 @@ static u32 sns_read_qtimer(void)
 	return (u32)val;
 }
 
+static irqreturn_t sns_ring_doorbell_irq(int irq, void *data)
+{
+	atomic_inc(&sns_ctl.doorbells);
+	wake_up_interruptible(&sns_ctl.ring_wq);
+
+	return IRQ_HANDLED;
+}
+
+/*
+ * The ring is a carveout shared with SLPI; its layout is agreed through
+ * the QMI control channel, so only map it and hook up the doorbell here.
+ */
+static int sns_ring_init(struct platform_device *pdev)
+{
+	struct device_node *mem_node;
+	struct resource res;
+	int ret;
+
+	init_waitqueue_head(&sns_ctl.ring_wq);
+
+	mem_node = of_parse_phandle(pdev->dev.of_node, "memory-region", 0);
+	if (!mem_node)
+		return 0;
+
+	ret = of_address_to_resource(mem_node, 0, &res);
+	of_node_put(mem_node);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "%s: Failed to get ring resource\n",
+			__func__);
+		return ret;
+	}
+
+	if (!PAGE_ALIGNED(res.start) ||
+	    resource_size(&res) < sizeof(struct sns_ring_hdr)) {
+		dev_err(&pdev->dev, "%s: Invalid ring region %pR\n",
+			__func__, &res);
+		return -EINVAL;
+	}
+
+	sns_ctl.ring = devm_ioremap_wc(&pdev->dev, res.start,
+				       resource_size(&res));
+	if (!sns_ctl.ring)
+		return -ENOMEM;
+
+	sns_ctl.ring_irq = platform_get_irq_byname(pdev, "sns-ring-doorbell");
+	if (sns_ctl.ring_irq < 0) {
+		dev_err(&pdev->dev, "%s: No ring doorbell interrupt\n",
+			__func__);
+		return sns_ctl.ring_irq;
+	}
+
+	ret = devm_request_irq(&pdev->dev, sns_ctl.ring_irq,
+			       sns_ring_doorbell_irq, 0, "sns-ring", &sns_ctl);
+	if (ret) {
+		dev_err(&pdev->dev, "%s: Failed to request doorbell irq %d\n",
+			__func__, ret);
+		return ret;
+	}
+
+	sns_ctl.ring_phys = res.start;
+	sns_ctl.ring_size = resource_size(&res);
+	dev_dbg(&pdev->dev, "%s: sensor ring at %pR\n", __func__, &res);
+
+	return 0;
+}
+
+static bool sns_ring_readable(void)
+{
+	return readl_relaxed(&sns_ctl.ring->wr_idx) !=
+		readl_relaxed(&sns_ctl.ring->rd_idx);
+}
+
+static __poll_t sensors_ssc_poll(struct file *file, poll_table *wait)
+{
+	if (!sns_ctl.ring)
+		return EPOLLERR;
+
+	poll_wait(file, &sns_ctl.ring_wq, wait);
+
+	return sns_ring_readable() ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+static int sensors_ssc_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (!sns_ctl.ring)
+		return -ENODEV;
+
+	if (vma->vm_pgoff || size > PAGE_ALIGN(sns_ctl.ring_size))
+		return -EINVAL;
+
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+	vma->vm_flags |= VM_IO | VM_DONTEXPAND | VM_DONTDUMP;
+
+	return io_remap_pfn_range(vma, vma->vm_start,
+				  sns_ctl.ring_phys >> PAGE_SHIFT, size,
+				  vma->vm_page_prot);
+}
+
+static int sns_ring_get_info(void __user *argp)
+{
+	struct sns_ring_info info;
+
+	if (!sns_ctl.ring)
+		return -ENODEV;
+
+	info.size = sns_ctl.ring_size;
+	info.rec_size = readl_relaxed(&sns_ctl.ring->rec_size);
+	info.nr_recs = readl_relaxed(&sns_ctl.ring->nr_recs);
+	info.doorbells = atomic_read(&sns_ctl.doorbells);
+
+	return copy_to_user(argp, &info, sizeof(info)) ? -EFAULT : 0;
+}
+
+static int sns_ring_set_watermark(u32 __user *argp)
+{
+	u32 wm;
+
+	if (!sns_ctl.ring)
+		return -ENODEV;
+
+	if (get_user(wm, argp))
+		return -EFAULT;
+
+	if (!wm || wm > readl_relaxed(&sns_ctl.ring->nr_recs))
+		return -EINVAL;
+
+	writel(wm, &sns_ctl.ring->watermark);
+
+	return 0;
+}
+
 static int sensors_ssc_open(struct inode *ip, struct file *fp)
 {
 	return 0;
@@ -327,6 +474,14 @@ static long sensors_ssc_ioctl(struct file *file,
 		ret = put_user(val, (u32 __user *) arg);
 		break;
 
+	case DSPS_IOCTL_RING_INFO:
+		ret = sns_ring_get_info((void __user *)arg);
+		break;
+
+	case DSPS_IOCTL_RING_WATERMARK:
+		ret = sns_ring_set_watermark((u32 __user *)arg);
+		break;
+
 	default:
 		ret = -EINVAL;
 		break;
@@ -339,6 +494,8 @@ const struct file_operations sensors_ssc_fops = {
 	.owner = THIS_MODULE,
 	.open = sensors_ssc_open,
 	.release = sensors_ssc_release,
+	.poll = sensors_ssc_poll,
+	.mmap = sensors_ssc_mmap,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = sensors_ssc_ioctl,
 #endif
@@ -354,6 +511,14 @@ static int sensors_ssc_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	ret = sns_ring_init(pdev);
+	if (ret) {
+		dev_err(&pdev->dev, "%s: Error in initing sensor ring\n",
+			__func__);
+		slpi_loader_remove(pdev);
+		return ret;
+	}
+
 	sns_ctl.dev_class = class_create(THIS_MODULE, CLASS_NAME);
 	if (sns_ctl.dev_class == NULL) {
 		pr_err("%s: class_create fail.\n", __func__);
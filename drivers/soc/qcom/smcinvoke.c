@@ -53,6 +53,8 @@
 #define SMCINVOKE_MEM_PERM_RW           6
 #define SMCINVOKE_SCM_EBUSY_WAIT_MS 30
 #define SMCINVOKE_SCM_EBUSY_MAX_RETRY 67
+/* largest in/out msg buffer kept mapped per client between invokes */
+#define SMCINVOKE_SHM_CACHE_MAX_SIZE    (16 * PAGE_SIZE)
 
 
 /* TZ defined values - Start */
@@ -204,6 +206,10 @@ struct smcinvoke_file_data {
 		uint32_t tzhandle;
 		uint16_t server_id;
 	};
+	/* msg buffers reused across invokes on this object */
+	struct mutex shm_lock;
+	struct qtee_shm in_shm;
+	struct qtee_shm out_shm;
 };
 
 struct smcinvoke_piggyback_msg {
@@ -734,6 +740,7 @@ static int get_fd_for_obj(uint32_t obj_type, uint32_t obj, int32_t *fd)
 		ret = -ENOMEM;
 		goto out;
 	}
+	mutex_init(&cxt->shm_lock);
 	if (obj_type == SMCINVOKE_OBJ_TYPE_TZ_OBJ) {
 		cxt->context_type = SMCINVOKE_OBJ_TYPE_TZ_OBJ;
 		cxt->tzhandle = obj;
@@ -1875,6 +1882,41 @@ static long process_accept_req(struct file *filp, unsigned int cmd,
 	return ret;
 }
 
+/*
+ * Hand out a msg buffer of at least @size bytes. With @cached the buffer
+ * comes from (and stays in) the client's @cache, so back-to-back invokes
+ * skip the shmbridge sub-allocation; otherwise it is a one-off allocation
+ * the caller frees.
+ */
+static int smcinvoke_get_shm(struct qtee_shm *cache, bool cached,
+				size_t size, struct qtee_shm *shm)
+{
+	int ret;
+
+	if (!cached || size > SMCINVOKE_SHM_CACHE_MAX_SIZE)
+		return qtee_shmbridge_allocate_shm(size, shm);
+
+	if (cache->vaddr && cache->size >= size) {
+		memset(cache->vaddr, 0, size);
+	} else {
+		qtee_shmbridge_free_shm(cache);
+		memset(cache, 0, sizeof(*cache));
+		ret = qtee_shmbridge_allocate_shm(size, cache);
+		if (ret)
+			return ret;
+	}
+	*shm = *cache;
+	/* only maintain the part of the buffer this invoke uses */
+	shm->size = size;
+	return 0;
+}
+
+static void smcinvoke_put_shm(struct qtee_shm *cache, struct qtee_shm *shm)
+{
+	if (shm->vaddr != cache->vaddr)
+		qtee_shmbridge_free_shm(shm);
+}
+
 static long process_invoke_req(struct file *filp, unsigned int cmd,
 						unsigned long arg)
 {
@@ -1897,6 +1939,8 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 	 */
 	int32_t tzhandles_to_release[OBJECT_COUNTS_MAX_OO] = {0};
 	bool tz_acked = false;
+	/* concurrent invokes on the same object fall back to one-off buffers */
+	bool shm_cached = false;
 
 	if (_IOC_SIZE(cmd) != sizeof(req)) {
 		pr_err("command size for invoke req is invalid\n");
@@ -1936,8 +1980,11 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 		}
 	}
 
+	shm_cached = mutex_trylock(&tzobj->shm_lock);
+
 	inmsg_size = compute_in_msg_size(&req, args_buf);
-	ret = qtee_shmbridge_allocate_shm(inmsg_size, &in_shm);
+	ret = smcinvoke_get_shm(&tzobj->in_shm, shm_cached, inmsg_size,
+				&in_shm);
 	if (ret) {
 		ret = -ENOMEM;
 		pr_err("shmbridge alloc failed for in msg in invoke req\n");
@@ -1948,7 +1995,8 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 	mutex_lock(&g_smcinvoke_lock);
 	outmsg_size = PAGE_ALIGN(g_max_cb_buf_size);
 	mutex_unlock(&g_smcinvoke_lock);
-	ret = qtee_shmbridge_allocate_shm(outmsg_size, &out_shm);
+	ret = smcinvoke_get_shm(&tzobj->out_shm, shm_cached, outmsg_size,
+				&out_shm);
 	if (ret) {
 		ret = -ENOMEM;
 		pr_err("shmbridge alloc failed for out msg in invoke req\n");
@@ -2009,8 +2057,14 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 	release_filp(filp_to_release, OBJECT_COUNTS_MAX_OO);
 	if (ret)
 		release_tzhandles(tzhandles_to_release, OBJECT_COUNTS_MAX_OO);
-	qtee_shmbridge_free_shm(&in_shm);
-	qtee_shmbridge_free_shm(&out_shm);
+	if (shm_cached) {
+		smcinvoke_put_shm(&tzobj->in_shm, &in_shm);
+		smcinvoke_put_shm(&tzobj->out_shm, &out_shm);
+		mutex_unlock(&tzobj->shm_lock);
+	} else {
+		qtee_shmbridge_free_shm(&in_shm);
+		qtee_shmbridge_free_shm(&out_shm);
+	}
 	kfree(args_buf);
 
 	if (ret)
@@ -2085,6 +2139,7 @@ static int smcinvoke_open(struct inode *nodp, struct file *filp)
 	if (!tzcxt)
 		return -ENOMEM;
 
+	mutex_init(&tzcxt->shm_lock);
 	tzcxt->tzhandle = SMCINVOKE_TZ_ROOT_OBJ;
 	tzcxt->context_type = SMCINVOKE_OBJ_TYPE_TZ_OBJ;
 	filp->private_data = tzcxt;
@@ -2154,6 +2209,10 @@ static int smcinvoke_release(struct inode *nodp, struct file *filp)
 
 	process_piggyback_data(out_buf, SMCINVOKE_TZ_MIN_BUF_SIZE);
 out:
+	if (file_data->context_type == SMCINVOKE_OBJ_TYPE_TZ_OBJ) {
+		qtee_shmbridge_free_shm(&file_data->in_shm);
+		qtee_shmbridge_free_shm(&file_data->out_shm);
+	}
 	kfree(filp->private_data);
 	qtee_shmbridge_free_shm(&in_shm);
 	qtee_shmbridge_free_shm(&out_shm);
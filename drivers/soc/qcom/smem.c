@@ -245,6 +245,16 @@ struct smem_region {
 	size_t size;
 };
 
+/**
+ * struct smem_item_cache - cached result of an item lookup
+ * @ptr:	virtual address of the item, NULL when not cached
+ * @size:	size of the item, valid once @ptr is published
+ */
+struct smem_item_cache {
+	void *ptr;
+	size_t size;
+};
+
 /**
  * struct qcom_smem - device data for the smem device
  * @dev:	device pointer
@@ -253,6 +263,8 @@ struct smem_region {
  * @ptable_entries: list of pointers to partitions table entry of current
  *		processor/host
  * @item_count: max accepted item number
+ * @item_cache: per partition lookup cache indexed by item, the last slot
+ *		covers the global partition or global heap
  * @num_regions: number of @regions
  * @regions:	list of the memory regions defining the shared memory
  */
@@ -264,6 +276,7 @@ struct qcom_smem {
 	struct smem_ptable_entry *global_partition_entry;
 	struct smem_ptable_entry *ptable_entries[SMEM_HOST_COUNT];
 	u32 item_count;
+	struct smem_item_cache *item_cache[SMEM_HOST_COUNT + 1];
 	struct platform_device *socinfo;
 
 	unsigned num_regions;
@@ -441,6 +454,43 @@ static int qcom_smem_alloc_global(struct qcom_smem *smem,
 	return 0;
 }
 
+/*
+ * Items are never freed once allocated, so a successful lookup stays valid
+ * for the lifetime of the smem device. Entries are only written with the
+ * hwspinlock held and are published with release semantics, letting
+ * qcom_smem_get() serve cached hits without taking the lock.
+ */
+static struct smem_item_cache *qcom_smem_cache_entry(struct qcom_smem *smem,
+						     unsigned host,
+						     unsigned item)
+{
+	unsigned idx = SMEM_HOST_COUNT;
+
+	if (host < SMEM_HOST_COUNT && smem->ptable_entries[host])
+		idx = host;
+
+	if (!smem->item_cache[idx])
+		return NULL;
+
+	return &smem->item_cache[idx][item];
+}
+
+static void qcom_smem_cache_store(struct smem_item_cache *cache, void *ptr,
+				  size_t size)
+{
+	if (!cache)
+		return;
+
+	cache->size = size;
+	smp_store_release(&cache->ptr, ptr);
+}
+
+static void qcom_smem_cache_invalidate(struct smem_item_cache *cache)
+{
+	if (cache)
+		WRITE_ONCE(cache->ptr, NULL);
+}
+
 /**
  * qcom_smem_alloc() - allocate space for a smem item
  * @host:	remote processor id, or -1
@@ -474,6 +524,8 @@ int qcom_smem_alloc(unsigned host, unsigned item, size_t size)
 	if (ret)
 		return ret;
 
+	qcom_smem_cache_invalidate(qcom_smem_cache_entry(__smem, host, item));
+
 	if (host < SMEM_HOST_COUNT && __smem->ptable_entries[host]) {
 		entry = __smem->ptable_entries[host];
 		ret = qcom_smem_alloc_private(__smem, entry, item, size);
@@ -638,7 +690,9 @@ static void *qcom_smem_get_private(struct qcom_smem *smem,
 void *qcom_smem_get(unsigned host, unsigned item, size_t *size)
 {
 	struct smem_ptable_entry *entry;
+	struct smem_item_cache *cache;
 	unsigned long flags;
+	size_t item_size;
 	int ret;
 	void *ptr = ERR_PTR(-EPROBE_DEFER);
 
@@ -648,6 +702,16 @@ void *qcom_smem_get(unsigned host, unsigned item, size_t *size)
 	if (WARN_ON(item >= __smem->item_count))
 		return ERR_PTR(-EINVAL);
 
+	cache = qcom_smem_cache_entry(__smem, host, item);
+	if (cache) {
+		ptr = smp_load_acquire(&cache->ptr);
+		if (ptr) {
+			if (size != NULL)
+				*size = cache->size;
+			return ptr;
+		}
+	}
+
 	ret = hwspin_lock_timeout_irqsave(__smem->hwlock,
 					  HWSPINLOCK_TIMEOUT,
 					  &flags);
@@ -656,12 +720,18 @@ void *qcom_smem_get(unsigned host, unsigned item, size_t *size)
 
 	if (host < SMEM_HOST_COUNT && __smem->ptable_entries[host]) {
 		entry = __smem->ptable_entries[host];
-		ptr = qcom_smem_get_private(__smem, entry, item, size);
+		ptr = qcom_smem_get_private(__smem, entry, item, &item_size);
 	} else if (__smem->global_partition_entry) {
 		entry = __smem->global_partition_entry;
-		ptr = qcom_smem_get_private(__smem, entry, item, size);
+		ptr = qcom_smem_get_private(__smem, entry, item, &item_size);
 	} else {
-		ptr = qcom_smem_get_global(__smem, item, size);
+		ptr = qcom_smem_get_global(__smem, item, &item_size);
+	}
+
+	if (!IS_ERR(ptr)) {
+		qcom_smem_cache_store(cache, ptr, item_size);
+		if (size != NULL)
+			*size = item_size;
 	}
 
 	hwspin_unlock_irqrestore(__smem->hwlock, &flags);
@@ -965,6 +1035,36 @@ static int qcom_smem_map_memory(struct qcom_smem *smem, struct device *dev,
 	return 0;
 }
 
+static void qcom_smem_free_item_cache(struct qcom_smem *smem)
+{
+	unsigned i;
+
+	for (i = 0; i <= SMEM_HOST_COUNT; i++) {
+		kfree(smem->item_cache[i]);
+		smem->item_cache[i] = NULL;
+	}
+}
+
+static int qcom_smem_init_item_cache(struct qcom_smem *smem)
+{
+	unsigned i;
+
+	for (i = 0; i <= SMEM_HOST_COUNT; i++) {
+		if (i < SMEM_HOST_COUNT && !smem->ptable_entries[i])
+			continue;
+
+		smem->item_cache[i] = kcalloc(smem->item_count,
+					      sizeof(struct smem_item_cache),
+					      GFP_KERNEL);
+		if (!smem->item_cache[i]) {
+			qcom_smem_free_item_cache(smem);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
 static int qcom_smem_probe(struct platform_device *pdev)
 {
 	struct smem_header *header;
@@ -1025,6 +1125,10 @@ static int qcom_smem_probe(struct platform_device *pdev)
 	if (ret < 0 && ret != -ENOENT)
 		goto release;
 
+	ret = qcom_smem_init_item_cache(smem);
+	if (ret)
+		goto release;
+
 	hwlock_id = of_hwspin_lock_get_id(pdev->dev.of_node, 0);
 	if (hwlock_id < 0) {
 		if (hwlock_id != -EPROBE_DEFER)
@@ -1050,6 +1154,7 @@ static int qcom_smem_probe(struct platform_device *pdev)
 	return 0;
 
 release:
+	qcom_smem_free_item_cache(smem);
 	kfree(smem);
 	return ret;
 }
@@ -1059,6 +1164,7 @@ static int qcom_smem_remove(struct platform_device *pdev)
 	platform_device_unregister(__smem->socinfo);
 
 	hwspin_lock_free(__smem->hwlock);
+	qcom_smem_free_item_cache(__smem);
 	/*
 	 * In case of Hibernation Restore __smem object is still valid
 	 * and we call probe again so same object get allocated again
@@ -56,6 +56,46 @@ int qcom_smem_state_update_bits(struct qcom_smem_state *state,
 }
 EXPORT_SYMBOL_GPL(qcom_smem_state_update_bits);
 
+/**
+ * qcom_smem_state_batch_begin() - start collecting state updates
+ * @state:	state handle acquired by calling qcom_smem_state_get()
+ *
+ * Updates made until the matching qcom_smem_state_batch_end() are
+ * signalled to the remote together, where the provider supports it.
+ * Batches nest and may span every state of the same provider edge.
+ *
+ * Returns 0 on success, otherwise negative errno.
+ */
+int qcom_smem_state_batch_begin(struct qcom_smem_state *state)
+{
+	if (state->orphan)
+		return -ENXIO;
+
+	if (!state->ops.batch)
+		return 0;
+
+	return state->ops.batch(state->priv, true);
+}
+EXPORT_SYMBOL_GPL(qcom_smem_state_batch_begin);
+
+/**
+ * qcom_smem_state_batch_end() - signal the updates collected in a batch
+ * @state:	state handle passed to qcom_smem_state_batch_begin()
+ *
+ * Returns 0 on success, otherwise negative errno.
+ */
+int qcom_smem_state_batch_end(struct qcom_smem_state *state)
+{
+	if (state->orphan)
+		return -ENXIO;
+
+	if (!state->ops.batch)
+		return 0;
+
+	return state->ops.batch(state->priv, false);
+}
+EXPORT_SYMBOL_GPL(qcom_smem_state_batch_end);
+
 static struct qcom_smem_state *of_node_to_state(struct device_node *np)
 {
 	struct qcom_smem_state *state;
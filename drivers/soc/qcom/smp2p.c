@@ -18,6 +18,7 @@
 #include <linux/soc/qcom/smem.h>
 #include <linux/soc/qcom/smem_state.h>
 #include <linux/spinlock.h>
+#include <linux/mutex.h>
 #include <linux/pm_wakeup.h>
 
 #include <linux/ipc_logging.h>
@@ -93,6 +94,8 @@ struct smp2p_smem_item {
  * @irq_falling:bitmap to mark irq bits for falling detection
  * @state:	smem state handle
  * @lock:	spinlock to protect read-modify-write of the value
+ * @notifiers:	bitmask notifiers of inbound entries
+ * @notifier_lock: mutex protecting @notifiers
  */
 struct smp2p_entry {
 	struct list_head node;
@@ -111,6 +114,9 @@ struct smp2p_entry {
 	struct qcom_smem_state *state;
 
 	spinlock_t lock;
+
+	struct list_head notifiers;
+	struct mutex notifier_lock;
 };
 
 #define SMP2P_INBOUND	0
@@ -129,6 +135,9 @@ struct smp2p_entry {
  * @ipc_bit:	bit in regmap@offset to kick to signal remote processor
  * @mbox_client: mailbox client handle
  * @mbox_chan:	apcs ipc mailbox channel handle
+ * @batch_lock:	spinlock protecting @batch_depth and @kick_pending
+ * @batch_depth: nesting of outbound batches, kicks are held while non-zero
+ * @kick_pending: an outbound change is waiting for the batch to end
  * @inbound:	list of inbound entries
  * @outbound:	list of outbound entries
  */
@@ -158,6 +167,10 @@ struct qcom_smp2p {
 	struct mbox_client mbox_client;
 	struct mbox_chan *mbox_chan;
 
+	spinlock_t batch_lock;
+	unsigned int batch_depth;
+	bool kick_pending;
+
 	struct list_head inbound;
 	struct list_head outbound;
 };
@@ -180,6 +193,26 @@ static void qcom_smp2p_kick(struct qcom_smp2p *smp2p)
 	}
 }
 
+/*
+ * Outbound changes made inside a qcom_smem_state_batch_begin/end section
+ * are signalled to the remote with a single interrupt when the outermost
+ * batch on the edge ends.
+ */
+static void qcom_smp2p_batch_kick(struct qcom_smp2p *smp2p)
+{
+	unsigned long flags;
+	bool defer;
+
+	spin_lock_irqsave(&smp2p->batch_lock, flags);
+	defer = smp2p->batch_depth;
+	if (defer)
+		smp2p->kick_pending = true;
+	spin_unlock_irqrestore(&smp2p->batch_lock, flags);
+
+	if (!defer)
+		qcom_smp2p_kick(smp2p);
+}
+
 static bool qcom_smp2p_check_ssr(struct qcom_smp2p *smp2p)
 {
 	struct smp2p_smem_item *in = smp2p->in;
@@ -232,6 +265,19 @@ static void qcom_smp2p_negotiate(struct qcom_smp2p *smp2p)
 	}
 }
 
+static void qcom_smp2p_notify_mask(struct smp2p_entry *entry, u32 changed,
+				   u32 val)
+{
+	struct qcom_smp2p_notifier *nb;
+
+	mutex_lock(&entry->notifier_lock);
+	list_for_each_entry(nb, &entry->notifiers, node) {
+		if (changed & nb->mask)
+			nb->notify(nb, changed & nb->mask, val);
+	}
+	mutex_unlock(&entry->notifier_lock);
+}
+
 static void qcom_smp2p_notify_in(struct qcom_smp2p *smp2p)
 {
 	struct smp2p_smem_item *in = smp2p->in;
@@ -282,6 +328,10 @@ static void qcom_smp2p_notify_in(struct qcom_smp2p *smp2p)
 		if (!status)
 			continue;
 
+		/* Deliver the whole burst to bitmask consumers at once */
+		if (!list_empty(&entry->notifiers))
+			qcom_smp2p_notify_mask(entry, status, val);
+
 		for_each_set_bit(i, &status, 32) {
 			if ((val & BIT(i) && test_bit(i, entry->irq_rising)) ||
 			    (!(val & BIT(i)) && test_bit(i, entry->irq_falling))) {
@@ -431,6 +481,66 @@ static const struct irq_domain_ops smp2p_irq_ops = {
 	.xlate = irq_domain_xlate_twocell,
 };
 
+static struct smp2p_entry *qcom_smp2p_find_inbound(struct device_node *np)
+{
+	struct irq_domain *domain = irq_find_host(np);
+
+	if (!domain || domain->ops != &smp2p_irq_ops)
+		return NULL;
+
+	return domain->host_data;
+}
+
+/**
+ * qcom_smp2p_notifier_register() - get bitmask notifications of an entry
+ * @np:	node of the inbound smp2p entry
+ * @nb:	notifier, with @mask and @notify filled in
+ *
+ * @nb->notify is called from the smp2p irq thread once per remote kick in
+ * which any bit in @nb->mask changed, with the changed bits and the new
+ * value of the entry. This is in addition to the per bit interrupts.
+ *
+ * Return: 0 on success, -EPROBE_DEFER if the entry isn't there yet.
+ */
+int qcom_smp2p_notifier_register(struct device_node *np,
+				 struct qcom_smp2p_notifier *nb)
+{
+	struct smp2p_entry *entry;
+
+	if (!nb || !nb->mask || !nb->notify)
+		return -EINVAL;
+
+	entry = qcom_smp2p_find_inbound(np);
+	if (!entry)
+		return -EPROBE_DEFER;
+
+	mutex_lock(&entry->notifier_lock);
+	list_add_tail(&nb->node, &entry->notifiers);
+	mutex_unlock(&entry->notifier_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(qcom_smp2p_notifier_register);
+
+/**
+ * qcom_smp2p_notifier_unregister() - remove a bitmask notifier
+ * @np:	node of the inbound smp2p entry
+ * @nb:	notifier passed to qcom_smp2p_notifier_register()
+ */
+void qcom_smp2p_notifier_unregister(struct device_node *np,
+				    struct qcom_smp2p_notifier *nb)
+{
+	struct smp2p_entry *entry = qcom_smp2p_find_inbound(np);
+
+	if (!entry)
+		return;
+
+	mutex_lock(&entry->notifier_lock);
+	list_del(&nb->node);
+	mutex_unlock(&entry->notifier_lock);
+}
+EXPORT_SYMBOL(qcom_smp2p_notifier_unregister);
+
 static int qcom_smp2p_inbound_entry(struct qcom_smp2p *smp2p,
 				    struct smp2p_entry *entry,
 				    struct device_node *node)
@@ -461,13 +571,36 @@ static int smp2p_update_bits(void *data, u32 mask, u32 value)
 		   entry->smp2p->remote_pid, entry->name, orig, val);
 
 	if (val != orig)
-		qcom_smp2p_kick(entry->smp2p);
+		qcom_smp2p_batch_kick(entry->smp2p);
+
+	return 0;
+}
+
+static int smp2p_batch(void *data, bool begin)
+{
+	struct smp2p_entry *entry = data;
+	struct qcom_smp2p *smp2p = entry->smp2p;
+	unsigned long flags;
+	bool kick = false;
+
+	spin_lock_irqsave(&smp2p->batch_lock, flags);
+	if (begin) {
+		smp2p->batch_depth++;
+	} else if (!WARN_ON(!smp2p->batch_depth) && !--smp2p->batch_depth) {
+		kick = smp2p->kick_pending;
+		smp2p->kick_pending = false;
+	}
+	spin_unlock_irqrestore(&smp2p->batch_lock, flags);
+
+	if (kick)
+		qcom_smp2p_kick(smp2p);
 
 	return 0;
 }
 
 static const struct qcom_smem_state_ops smp2p_state_ops = {
 	.update_bits = smp2p_update_bits,
+	.batch = smp2p_batch,
 };
 
 static int qcom_smp2p_outbound_entry(struct qcom_smp2p *smp2p,
@@ -591,6 +724,7 @@ static int qcom_smp2p_probe(struct platform_device *pdev)
 	smp2p->dev = &pdev->dev;
 	INIT_LIST_HEAD(&smp2p->inbound);
 	INIT_LIST_HEAD(&smp2p->outbound);
+	spin_lock_init(&smp2p->batch_lock);
 
 	platform_set_drvdata(pdev, smp2p);
 
@@ -643,6 +777,8 @@ static int qcom_smp2p_probe(struct platform_device *pdev)
 
 		entry->smp2p = smp2p;
 		spin_lock_init(&entry->lock);
+		INIT_LIST_HEAD(&entry->notifiers);
+		mutex_init(&entry->notifier_lock);
 
 		ret = of_property_read_string(node, "qcom,entry-name", &entry->name);
 		if (ret < 0)
@@ -758,6 +894,8 @@ static int qcom_smp2p_restore(struct device *dev)
 
 		entry->smp2p = smp2p;
 		spin_lock_init(&entry->lock);
+		INIT_LIST_HEAD(&entry->notifiers);
+		mutex_init(&entry->notifier_lock);
 		ret = of_property_read_string(node, "qcom,entry-name",
 								&entry->name);
 		if (ret < 0)
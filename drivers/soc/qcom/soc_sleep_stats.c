@@ -248,6 +248,7 @@ static struct platform_driver soc_sleep_stats_driver = {
 	.driver = {
 		.name = "soc_sleep_stats",
 		.of_match_table = soc_sleep_stats_table,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_platform_driver(soc_sleep_stats_driver);
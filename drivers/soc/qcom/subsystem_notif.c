@@ -19,8 +19,14 @@
 #include <linux/stringify.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/srcu.h>
 #include <soc/qcom/subsystem_notif.h>
 
+/* Notifier callbacks slower than this are reported in the kernel log */
+static unsigned int slow_notif_ms = 200;
+module_param(slow_notif_ms, uint, 0644);
+
 /**
  * The callbacks that are registered in this data structure as early
  * notification callbacks will be called as soon as the SSR framework is
@@ -36,11 +42,28 @@ struct subsys_early_notif_info {
 	void *data[NUM_EARLY_NOTIFS];
 };
 
+/**
+ * struct subsys_notif_stats - Latency of one notification type
+ * @count: number of times the chain was run
+ * @last_ns: duration of the last run of the whole chain
+ * @max_ns: longest run of the whole chain
+ * @slowest_cb: callback that took the longest on any run
+ * @slowest_ns: duration of @slowest_cb
+ */
+struct subsys_notif_stats {
+	unsigned long count;
+	u64 last_ns;
+	u64 max_ns;
+	notifier_fn_t slowest_cb;
+	u64 slowest_ns;
+};
+
 struct subsys_notif_info {
 	char name[50];
 	struct srcu_notifier_head subsys_notif_rcvr_list;
 	struct subsys_early_notif_info early_notif_info;
 	struct list_head list;
+	struct subsys_notif_stats stats[SUBSYS_NOTIF_TYPE_COUNT];
 };
 
 static LIST_HEAD(subsystem_list);
@@ -224,7 +247,7 @@ void *subsys_notif_add_subsys(const char *subsys_name)
 		goto done;
 	}
 
-	subsys = kmalloc(sizeof(struct subsys_notif_info), GFP_KERNEL);
+	subsys = kzalloc(sizeof(struct subsys_notif_info), GFP_KERNEL);
 
 	if (!subsys) {
 		mutex_unlock(&notif_add_lock);
@@ -255,6 +278,55 @@ void *subsys_notif_add_subsys(const char *subsys_name)
 }
 EXPORT_SYMBOL(subsys_notif_add_subsys);
 
+/*
+ * Equivalent of srcu_notifier_call_chain() that times every callback, so the
+ * clients that stretch a restart can be identified from the field.
+ */
+static int subsys_notif_call_chain(struct subsys_notif_info *subsys,
+				   enum subsys_notif_type notif_type,
+				   void *data)
+{
+	struct srcu_notifier_head *nh = &subsys->subsys_notif_rcvr_list;
+	struct subsys_notif_stats *st = &subsys->stats[notif_type];
+	struct notifier_block *nb, *next_nb;
+	ktime_t chain_start, start;
+	int ret = NOTIFY_DONE;
+	u64 delta;
+	int idx;
+
+	idx = srcu_read_lock(&nh->srcu);
+	chain_start = ktime_get();
+	nb = srcu_dereference(nh->head, &nh->srcu);
+	while (nb) {
+		next_nb = srcu_dereference(nb->next, &nh->srcu);
+
+		start = ktime_get();
+		ret = nb->notifier_call(nb, notif_type, data);
+		delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		if (delta > st->slowest_ns) {
+			st->slowest_ns = delta;
+			st->slowest_cb = nb->notifier_call;
+		}
+		if (delta > (u64)slow_notif_ms * NSEC_PER_MSEC)
+			pr_warn("%s: notifier %ps took %llu ms for type %d\n",
+				subsys->name, nb->notifier_call,
+				div_u64(delta, NSEC_PER_MSEC), notif_type);
+
+		if (ret & NOTIFY_STOP_MASK)
+			break;
+		nb = next_nb;
+	}
+	delta = ktime_to_ns(ktime_sub(ktime_get(), chain_start));
+	srcu_read_unlock(&nh->srcu, idx);
+
+	st->count++;
+	st->last_ns = delta;
+	st->max_ns = max(st->max_ns, delta);
+
+	return ret;
+}
+
 int subsys_notif_queue_notification(void *subsys_handle,
 					enum subsys_notif_type notif_type,
 					void *data)
@@ -267,11 +339,51 @@ int subsys_notif_queue_notification(void *subsys_handle,
 	if (notif_type < 0 || notif_type >= SUBSYS_NOTIF_TYPE_COUNT)
 		return -EINVAL;
 
-	return srcu_notifier_call_chain(&subsys->subsys_notif_rcvr_list,
-				       notif_type, data);
+	return subsys_notif_call_chain(subsys, notif_type, data);
 }
 EXPORT_SYMBOL(subsys_notif_queue_notification);
 
+static int subsys_notif_stats_show(struct seq_file *s, void *unused)
+{
+	struct subsys_notif_info *subsys;
+	struct subsys_notif_stats *st;
+	int i;
+
+	seq_puts(s, "subsys type count last_us max_us slowest_us callback\n");
+	mutex_lock(&notif_lock);
+	list_for_each_entry(subsys, &subsystem_list, list) {
+		for (i = 0; i < SUBSYS_NOTIF_TYPE_COUNT; i++) {
+			st = &subsys->stats[i];
+			if (!st->count)
+				continue;
+			seq_printf(s, "%s %d %lu %llu %llu %llu %ps\n",
+				   subsys->name, i, st->count,
+				   div_u64(st->last_ns, NSEC_PER_USEC),
+				   div_u64(st->max_ns, NSEC_PER_USEC),
+				   div_u64(st->slowest_ns, NSEC_PER_USEC),
+				   st->slowest_cb);
+		}
+	}
+	mutex_unlock(&notif_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(subsys_notif_stats);
+
+static struct dentry *subsys_notif_stats_file;
+
+void subsys_notif_debugfs_init(void)
+{
+	subsys_notif_stats_file = debugfs_create_file("subsys_notif_stats",
+						      0400, NULL, NULL,
+						      &subsys_notif_stats_fops);
+}
+
+void subsys_notif_debugfs_exit(void)
+{
+	debugfs_remove(subsys_notif_stats_file);
+}
+
 #if defined(SUBSYS_RESTART_DEBUG)
 static const char *notif_to_string(enum subsys_notif_type notif_type)
 {
@@ -465,6 +465,7 @@ static struct platform_driver subsystem_sleep_stats_driver = {
 	.driver	= {
 		.name	= "subsystem_sleep_stats",
 		.of_match_table	= subsystem_stats_table,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#if !defined(_TRACE_APR_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_APR_H
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM apr
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(apr_send_pkt,
+
+	TP_PROTO(u32 domain, u32 svc, u32 opcode, u32 token, int ret),
+
+	TP_ARGS(domain, svc, opcode, token, ret),
+
+	TP_STRUCT__entry(
+			 __field(u32, domain)
+			 __field(u32, svc)
+			 __field(u32, opcode)
+			 __field(u32, token)
+			 __field(int, ret)
+	),
+
+	TP_fast_assign(
+		       __entry->domain = domain;
+		       __entry->svc = svc;
+		       __entry->opcode = opcode;
+		       __entry->token = token;
+		       __entry->ret = ret;
+	),
+
+	TP_printk("domain: %u svc: %#x opcode: %#x token: %#x ret: %d",
+		  __entry->domain, __entry->svc, __entry->opcode,
+		  __entry->token, __entry->ret)
+);
+
+TRACE_EVENT(apr_rsp,
+
+	TP_PROTO(u32 domain, u32 svc, u32 opcode, u32 rsp_opcode, u32 token,
+		 s64 latency_us),
+
+	TP_ARGS(domain, svc, opcode, rsp_opcode, token, latency_us),
+
+	TP_STRUCT__entry(
+			 __field(u32, domain)
+			 __field(u32, svc)
+			 __field(u32, opcode)
+			 __field(u32, rsp_opcode)
+			 __field(u32, token)
+			 __field(s64, latency_us)
+	),
+
+	TP_fast_assign(
+		       __entry->domain = domain;
+		       __entry->svc = svc;
+		       __entry->opcode = opcode;
+		       __entry->rsp_opcode = rsp_opcode;
+		       __entry->token = token;
+		       __entry->latency_us = latency_us;
+	),
+
+	TP_printk("domain: %u svc: %#x opcode: %#x rsp: %#x token: %#x latency: %lld us",
+		  __entry->domain, __entry->svc, __entry->opcode,
+		  __entry->rsp_opcode, __entry->token, __entry->latency_us)
+);
+
+#endif /* _TRACE_APR_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace-apr
+
+#include <trace/define_trace.h>
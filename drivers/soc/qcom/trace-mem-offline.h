@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM mem_offline
+
+#if !defined(_TRACE_MEM_OFFLINE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_MEM_OFFLINE_H
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+/*
+ * One step of a memory block transition. @elapsed_us is measured from the
+ * start of the transition, so the events of a block form its timeline.
+ */
+TRACE_EVENT(mem_offline_step,
+
+	TP_PROTO(unsigned long sec_nr, const char *step, s64 elapsed_us),
+
+	TP_ARGS(sec_nr, step, elapsed_us),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, sec_nr)
+		__string(step, step)
+		__field(s64, elapsed_us)
+	),
+
+	TP_fast_assign(
+		__entry->sec_nr = sec_nr;
+		__assign_str(step, step);
+		__entry->elapsed_us = elapsed_us;
+	),
+
+	TP_printk("mem%lu %s +%lldus",
+		  __entry->sec_nr, __get_str(step), __entry->elapsed_us)
+);
+
+#endif /* _TRACE_MEM_OFFLINE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH ../../drivers/soc/qcom/
+
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace-mem-offline
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
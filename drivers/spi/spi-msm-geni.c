@@ -131,6 +131,14 @@ struct spi_geni_gsi {
 	struct gsi_desc_cb desc_cb;
 };
 
+/* Per transfer mode message latency, shown in the xfer_stats attribute */
+struct spi_geni_xfer_stats {
+	u64 msgs;
+	u64 bytes;
+	u64 total_us;
+	u64 max_us;
+};
+
 struct spi_geni_master {
 	struct se_geni_rsc spi_rsc;
 	resource_size_t phys_addr;
@@ -181,6 +189,8 @@ struct spi_geni_master {
 	bool slave_state;
 	bool slave_cross_connected;
 	bool use_fixed_timeout;
+	ktime_t msg_start;
+	struct spi_geni_xfer_stats xfer_stats[SE_DMA + 1];
 };
 
 static void spi_slv_setup(struct spi_geni_master *mas);
@@ -212,6 +222,33 @@ static ssize_t spi_slave_state_store(struct device *dev,
 
 static DEVICE_ATTR_RW(spi_slave_state);
 
+static ssize_t xfer_stats_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct spi_master *spi = dev_get_drvdata(dev);
+	struct spi_geni_master *mas = spi_master_get_devdata(spi);
+	static const char * const names[] = {
+		[FIFO_MODE] = "fifo",
+		[GSI_DMA] = "gsi",
+		[SE_DMA] = "se_dma",
+	};
+	ssize_t len = 0;
+	int i;
+
+	for (i = FIFO_MODE; i <= SE_DMA; i++) {
+		struct spi_geni_xfer_stats *st = &mas->xfer_stats[i];
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%s: msgs %llu bytes %llu avg_us %llu max_us %llu\n",
+				 names[i], st->msgs, st->bytes,
+				 st->msgs ? div64_u64(st->total_us, st->msgs) : 0,
+				 st->max_us);
+	}
+	return len;
+}
+
+static DEVICE_ATTR_RO(xfer_stats);
+
 static void spi_slv_setup(struct spi_geni_master *mas)
 {
 	geni_write_reg(SPI_SLAVE_EN, mas->base, SE_SPI_SLAVE_EN);
@@ -1078,12 +1115,14 @@ static int spi_geni_prepare_message(struct spi_master *spi,
 	} else if (mas->cur_xfer_mode == GSI_DMA) {
 		memset(mas->gsi, 0,
 				(sizeof(struct spi_geni_gsi) * NUM_SPI_XFER));
+		mas->num_xfers = 0;
 		geni_se_select_mode(mas->base, GSI_DMA);
 		ret = spi_geni_map_buf(mas, spi_msg);
 	} else {
 		geni_se_select_mode(mas->base, mas->cur_xfer_mode);
 		ret = setup_fifo_params(spi_msg->spi, spi);
 	}
+	mas->msg_start = ktime_get();
 
 exit_prepare_message:
 	return ret;
@@ -1095,6 +1134,18 @@ static int spi_geni_unprepare_message(struct spi_master *spi_mas,
 	struct spi_geni_master *mas = spi_master_get_devdata(spi_mas);
 	int count = 0;
 
+	if (mas->cur_xfer_mode >= FIFO_MODE && mas->cur_xfer_mode <= SE_DMA) {
+		struct spi_geni_xfer_stats *st =
+					&mas->xfer_stats[mas->cur_xfer_mode];
+		u64 us = ktime_us_delta(ktime_get(), mas->msg_start);
+
+		st->msgs++;
+		st->bytes += spi_msg->actual_length;
+		st->total_us += us;
+		if (us > st->max_us)
+			st->max_us = us;
+	}
+
 	mas->cur_speed_hz = 0;
 	mas->cur_word_len = 0;
 	if (mas->cur_xfer_mode == GSI_DMA)
@@ -1719,11 +1770,17 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 					xfer->rx_dma, xfer->len);
 		}
 	} else {
-		mas->num_tx_eot = 0;
-		mas->num_rx_eot = 0;
-		mas->num_xfers = 0;
-		reinit_completion(&mas->tx_cb);
-		reinit_completion(&mas->rx_cb);
+		/*
+		 * Queue up to NUM_SPI_XFER transfers of a message back to back
+		 * on the GPI channels, each in its own slot, and wait for all
+		 * of their completions once at the end of the batch.
+		 */
+		if (!mas->num_xfers) {
+			mas->num_tx_eot = 0;
+			mas->num_rx_eot = 0;
+			reinit_completion(&mas->tx_cb);
+			reinit_completion(&mas->rx_cb);
+		}
 
 		ret = setup_gsi_xfer(xfer, mas, slv, spi);
 		if (ret) {
@@ -1759,6 +1816,7 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 					goto err_gsi_geni_transfer_one;
 				}
 			}
+			mas->num_xfers = 0;
 			if (mas->qn_err) {
 				ret = -EIO;
 				mas->qn_err = false;
@@ -1768,6 +1826,7 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 	}
 	return ret;
 err_gsi_geni_transfer_one:
+	mas->num_xfers = 0;
 	geni_se_dump_dbg_regs(&mas->spi_rsc, mas->base, mas->ipc);
 	if (!mas->is_le_vm) {
 		dmaengine_terminate_all(mas->tx);
@@ -2211,6 +2270,8 @@ static int spi_geni_probe(struct platform_device *pdev)
 	}
 	ret = sysfs_create_file(&(geni_mas->dev->kobj),
 			&dev_attr_spi_slave_state.attr);
+	ret = sysfs_create_file(&(geni_mas->dev->kobj),
+			&dev_attr_xfer_stats.attr);
 
 	snprintf(boot_marker, sizeof(boot_marker),
 			"M - DRIVER GENI_SPI_%d Ready", spi->bus_num);
@@ -2232,6 +2293,7 @@ static int spi_geni_remove(struct platform_device *pdev)
 	struct spi_geni_master *geni_mas = spi_master_get_devdata(master);
 
 	sysfs_remove_file(&pdev->dev.kobj, &dev_attr_spi_slave_state.attr);
+	sysfs_remove_file(&pdev->dev.kobj, &dev_attr_xfer_stats.attr);
 	se_geni_resources_off(&geni_mas->spi_rsc);
 	spi_unregister_master(master);
 	pm_runtime_put_noidle(&pdev->dev);
@@ -11,10 +11,12 @@
 #include <linux/irqdomain.h>
 #include <linux/irq.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spmi.h>
 #include <linux/string.h>
@@ -96,6 +98,8 @@ enum pmic_arb_channel {
 #define PMIC_ARB_MAX_PERIPHS		512
 #define PMIC_ARB_TIMEOUT_US		1000
 #define PMIC_ARB_MAX_TRANS_BYTES	(8)
+/* Accesses of a batch issued per acquisition of pmic_arb->lock */
+#define PMIC_ARB_MAX_BATCH		16
 
 #define PMIC_ARB_APID_MASK		0xFF
 #define PMIC_ARB_PPID_MASK		0xFFF
@@ -122,6 +126,14 @@ struct apid_data {
 	u8		irq_ee;
 };
 
+struct pmic_arb_periph_stats {
+	u64		reads;
+	u64		writes;
+	u64		errors;
+	u64		total_ns;
+	u32		max_ns;
+};
+
 /**
  * spmi_pmic_arb - SPMI PMIC Arbiter object
  *
@@ -144,6 +156,7 @@ struct apid_data {
  * @ppid_to_apid	in-memory copy of PPID -> APID mapping table.
  * @debugfs:		debugfs directory pointer
  * @debug_spmi_addr:	SPMI address used for debugfs operations
+ * @periph_stats:	per APID access counts and latency.
  */
 struct spmi_pmic_arb {
 	void __iomem		*rd_base;
@@ -170,6 +183,7 @@ struct spmi_pmic_arb {
 	struct apid_data	apid_data[PMIC_ARB_MAX_PERIPHS];
 	struct dentry		*debugfs;
 	u32			debug_spmi_addr;
+	struct pmic_arb_periph_stats *periph_stats;
 };
 
 /**
@@ -304,6 +318,34 @@ static int pmic_arb_wait_for_done(struct spmi_controller *ctrl,
 	return -ETIMEDOUT;
 }
 
+/* pmic_arb->lock must be held by the caller. */
+static void pmic_arb_account(struct spmi_pmic_arb *pmic_arb, u8 sid, u16 addr,
+			     bool write, ktime_t start, int rc)
+{
+	struct pmic_arb_periph_stats *st;
+	u16 ppid = sid << 8 | ((addr >> 8) & 0xFF);
+	u16 apid = pmic_arb->ppid_to_apid[ppid];
+	u64 ns;
+
+	if (!pmic_arb->periph_stats || !(apid & PMIC_ARB_APID_VALID))
+		return;
+	apid &= ~PMIC_ARB_APID_VALID;
+	if (apid >= PMIC_ARB_MAX_PERIPHS)
+		return;
+
+	st = &pmic_arb->periph_stats[apid];
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (write)
+		st->writes++;
+	else
+		st->reads++;
+	if (rc)
+		st->errors++;
+	st->total_ns += ns;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+}
+
 static int
 pmic_arb_non_data_cmd_v1(struct spmi_controller *ctrl, u8 opc, u8 sid)
 {
@@ -349,15 +391,16 @@ static int pmic_arb_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid)
 	return pmic_arb->ver_ops->non_data_cmd(ctrl, opc, sid);
 }
 
-static int pmic_arb_read_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
-			     u16 addr, u8 *buf, size_t len)
+/* pmic_arb->lock must be held by the caller. */
+static int __pmic_arb_read_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
+			       u16 addr, u8 *buf, size_t len)
 {
 	struct spmi_pmic_arb *pmic_arb = spmi_controller_get_drvdata(ctrl);
-	unsigned long flags;
 	u8 bc = len - 1;
 	u32 cmd;
 	int rc;
 	u32 offset;
+	ktime_t start;
 
 	rc = pmic_arb->ver_ops->offset(pmic_arb, sid, addr,
 				       PMIC_ARB_CHANNEL_OBS);
@@ -383,7 +426,7 @@ static int pmic_arb_read_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
 
 	cmd = pmic_arb->ver_ops->fmt_cmd(opc, sid, addr, bc);
 
-	raw_spin_lock_irqsave(&pmic_arb->lock, flags);
+	start = ktime_get();
 	pmic_arb_set_rd_cmd(pmic_arb, offset + PMIC_ARB_CMD, cmd);
 	rc = pmic_arb_wait_for_done(ctrl, pmic_arb->rd_base, sid, addr,
 				    PMIC_ARB_CHANNEL_OBS);
@@ -398,19 +441,34 @@ static int pmic_arb_read_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
 					bc - 4);
 
 done:
-	raw_spin_unlock_irqrestore(&pmic_arb->lock, flags);
+	pmic_arb_account(pmic_arb, sid, addr, false, start, rc);
 	return rc;
 }
 
-static int pmic_arb_write_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
-			u16 addr, const u8 *buf, size_t len)
+static int pmic_arb_read_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
+			     u16 addr, u8 *buf, size_t len)
 {
 	struct spmi_pmic_arb *pmic_arb = spmi_controller_get_drvdata(ctrl);
 	unsigned long flags;
+	int rc;
+
+	raw_spin_lock_irqsave(&pmic_arb->lock, flags);
+	rc = __pmic_arb_read_cmd(ctrl, opc, sid, addr, buf, len);
+	raw_spin_unlock_irqrestore(&pmic_arb->lock, flags);
+
+	return rc;
+}
+
+/* pmic_arb->lock must be held by the caller. */
+static int __pmic_arb_write_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
+				u16 addr, const u8 *buf, size_t len)
+{
+	struct spmi_pmic_arb *pmic_arb = spmi_controller_get_drvdata(ctrl);
 	u8 bc = len - 1;
 	u32 cmd;
 	int rc;
 	u32 offset;
+	ktime_t start;
 
 	rc = pmic_arb->ver_ops->offset(pmic_arb, sid, addr,
 					PMIC_ARB_CHANNEL_RW);
@@ -439,7 +497,7 @@ static int pmic_arb_write_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
 	cmd = pmic_arb->ver_ops->fmt_cmd(opc, sid, addr, bc);
 
 	/* Write data to FIFOs */
-	raw_spin_lock_irqsave(&pmic_arb->lock, flags);
+	start = ktime_get();
 	pmic_arb_write_data(pmic_arb, buf, offset + PMIC_ARB_WDATA0,
 				min_t(u8, bc, 3));
 	if (bc > 3)
@@ -450,11 +508,61 @@ static int pmic_arb_write_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
 	pmic_arb_base_write(pmic_arb, offset + PMIC_ARB_CMD, cmd);
 	rc = pmic_arb_wait_for_done(ctrl, pmic_arb->wr_base, sid, addr,
 				    PMIC_ARB_CHANNEL_RW);
+	pmic_arb_account(pmic_arb, sid, addr, true, start, rc);
+
+	return rc;
+}
+
+static int pmic_arb_write_cmd(struct spmi_controller *ctrl, u8 opc, u8 sid,
+			u16 addr, const u8 *buf, size_t len)
+{
+	struct spmi_pmic_arb *pmic_arb = spmi_controller_get_drvdata(ctrl);
+	unsigned long flags;
+	int rc;
+
+	raw_spin_lock_irqsave(&pmic_arb->lock, flags);
+	rc = __pmic_arb_write_cmd(ctrl, opc, sid, addr, buf, len);
 	raw_spin_unlock_irqrestore(&pmic_arb->lock, flags);
 
 	return rc;
 }
 
+/*
+ * Issue a batch of accesses back to back, taking the lock (and masking
+ * interrupts) once per PMIC_ARB_MAX_BATCH accesses instead of once per
+ * access. Each command still has to complete on its channel before the
+ * next one is issued.
+ */
+static int pmic_arb_xfer_cmd(struct spmi_controller *ctrl, u8 sid,
+			     struct spmi_xfer *xfers, unsigned int num)
+{
+	struct spmi_pmic_arb *pmic_arb = spmi_controller_get_drvdata(ctrl);
+	unsigned long flags;
+	unsigned int i, end;
+	int rc = 0;
+
+	for (i = 0; i < num && !rc; ) {
+		end = min(num, i + PMIC_ARB_MAX_BATCH);
+
+		raw_spin_lock_irqsave(&pmic_arb->lock, flags);
+		for (; i < end && !rc; i++) {
+			if (xfers[i].write)
+				rc = __pmic_arb_write_cmd(ctrl,
+						SPMI_CMD_EXT_WRITEL, sid,
+						xfers[i].addr, xfers[i].buf,
+						xfers[i].len);
+			else
+				rc = __pmic_arb_read_cmd(ctrl,
+						SPMI_CMD_EXT_READL, sid,
+						xfers[i].addr, xfers[i].buf,
+						xfers[i].len);
+		}
+		raw_spin_unlock_irqrestore(&pmic_arb->lock, flags);
+	}
+
+	return rc;
+}
+
 enum qpnpint_regs {
 	QPNPINT_REG_RT_STS		= 0x10,
 	QPNPINT_REG_SET_TYPE		= 0x11,
@@ -1389,6 +1497,40 @@ static int debug_soc_end_addr_get(void *data, u64 *val)
 DEFINE_DEBUGFS_ATTRIBUTE(debug_soc_end_addr_fops, debug_soc_end_addr_get,
 			 NULL, "0x%llX\n");
 
+static int periph_stats_show(struct seq_file *s, void *unused)
+{
+	struct spmi_pmic_arb *pmic_arb = s->private;
+	struct pmic_arb_periph_stats *st;
+	u16 ppid, apid;
+	u64 count;
+
+	if (!pmic_arb->periph_stats)
+		return 0;
+
+	seq_puts(s, "sid periph apid      reads     writes errors avg_ns max_ns\n");
+	for (ppid = 0; ppid < PMIC_ARB_MAX_PPID; ppid++) {
+		apid = pmic_arb->ppid_to_apid[ppid];
+		if (!(apid & PMIC_ARB_APID_VALID))
+			continue;
+		apid &= ~PMIC_ARB_APID_VALID;
+		if (apid >= PMIC_ARB_MAX_PERIPHS)
+			continue;
+
+		st = &pmic_arb->periph_stats[apid];
+		count = st->reads + st->writes;
+		if (!count)
+			continue;
+
+		seq_printf(s, "%3u 0x%02x %4u %10llu %10llu %6llu %6llu %6u\n",
+			   ppid >> 8, ppid & 0xFF, apid, st->reads, st->writes,
+			   st->errors, div64_u64(st->total_ns, count),
+			   st->max_ns);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(periph_stats);
+
 static void spmi_pmic_arb_debugfs_init(struct spmi_pmic_arb *pmic_arb)
 {
 	struct dentry *dir, *file;
@@ -1404,6 +1546,14 @@ static void spmi_pmic_arb_debugfs_init(struct spmi_pmic_arb *pmic_arb)
 	}
 	pmic_arb->debugfs = dir;
 
+	file = debugfs_create_file("periph_stats", 0400, pmic_arb->debugfs,
+				   pmic_arb, &periph_stats_fops);
+	if (IS_ERR(file)) {
+		dev_err(&pmic_arb->spmic->dev, "Could not create periph_stats debugfs file, rc=%ld\n",
+			PTR_ERR(file));
+		goto error;
+	}
+
 	dir = debugfs_create_dir("address_map", pmic_arb->debugfs);
 	if (IS_ERR(dir)) {
 		dev_err(&pmic_arb->spmic->dev, "Could not create address_map debugfs directory, rc=%ld\n",
@@ -1595,6 +1745,11 @@ static int spmi_pmic_arb_probe(struct platform_device *pdev)
 	ctrl->cmd = pmic_arb_cmd;
 	ctrl->read_cmd = pmic_arb_read_cmd;
 	ctrl->write_cmd = pmic_arb_write_cmd;
+	ctrl->xfer_cmd = pmic_arb_xfer_cmd;
+
+	pmic_arb->periph_stats = devm_kcalloc(&ctrl->dev, PMIC_ARB_MAX_PERIPHS,
+					sizeof(*pmic_arb->periph_stats),
+					GFP_KERNEL);
 
 	if (hw_ver >= PMIC_ARB_VERSION_V5_MIN) {
 		err = pmic_arb_read_apid_map_v5(pmic_arb);
@@ -269,6 +269,48 @@ int spmi_ext_register_writel(struct spmi_device *sdev, u16 addr, const u8 *buf,
 }
 EXPORT_SYMBOL_GPL(spmi_ext_register_writel);
 
+/**
+ * spmi_ext_register_xfer() - batch of extended register long accesses
+ * @sdev:	SPMI device.
+ * @xfers:	reads and writes to perform, in order.
+ * @num:	number of entries in @xfers.
+ *
+ * Performs a sequence of up to 8 byte reads and writes on a Slave device
+ * using 16-bit addresses. Controllers that implement xfer_cmd issue the
+ * whole batch under one bus lock acquisition, others fall back to one
+ * read_cmd/write_cmd per entry. Stops at the first failing access.
+ */
+int spmi_ext_register_xfer(struct spmi_device *sdev, struct spmi_xfer *xfers,
+			   unsigned int num)
+{
+	struct spmi_controller *ctrl = sdev->ctrl;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < num; i++)
+		if (xfers[i].len == 0 || xfers[i].len > 8)
+			return -EINVAL;
+
+	if (ctrl && ctrl->xfer_cmd && ctrl->dev.type == &spmi_ctrl_type)
+		return ctrl->xfer_cmd(ctrl, sdev->usid, xfers, num);
+
+	for (i = 0; i < num; i++) {
+		if (xfers[i].write)
+			ret = spmi_write_cmd(ctrl, SPMI_CMD_EXT_WRITEL,
+					     sdev->usid, xfers[i].addr,
+					     xfers[i].buf, xfers[i].len);
+		else
+			ret = spmi_read_cmd(ctrl, SPMI_CMD_EXT_READL,
+					    sdev->usid, xfers[i].addr,
+					    xfers[i].buf, xfers[i].len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(spmi_ext_register_xfer);
+
 /**
  * spmi_command_reset() - sends RESET command to the specified slave
  * @sdev:	SPMI device.
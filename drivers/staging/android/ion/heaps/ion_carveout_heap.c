@@ -9,8 +9,10 @@
 #include <linux/err.h>
 #include <linux/genalloc.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
 #include <linux/mm.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
 #include <soc/qcom/secure_buffer.h>
@@ -24,26 +26,88 @@
 #define to_carveout_heap(_heap) \
 	container_of(to_msm_ion_heap(_heap), struct ion_carveout_heap, heap)
 
+struct ion_carveout_stats {
+	atomic_long_t allocs;
+	atomic_long_t failed;
+	atomic_long_t failed_fragmented;
+	atomic64_t total_ns;
+	atomic64_t max_ns;
+};
+
 struct ion_carveout_heap {
 	struct msm_ion_heap heap;
 	struct rw_semaphore mem_sem;
 	struct gen_pool *pool;
 	phys_addr_t base;
+	struct ion_carveout_stats stats;
+};
+
+/* free space layout of a pool, gathered for the debug file */
+struct ion_carveout_frag {
+	unsigned long free;
+	unsigned long largest;
+	unsigned long extents;
+	unsigned long order_extents[MAX_ORDER + 1];
 };
 
+static void ion_carveout_frag_chunk(struct gen_pool *pool,
+				    struct gen_pool_chunk *chunk, void *data)
+{
+	struct ion_carveout_frag *frag = data;
+	int order = pool->min_alloc_order;
+	unsigned long nbits = (chunk->end_addr - chunk->start_addr + 1) >> order;
+	unsigned long start = 0, end, len;
+
+	for (;;) {
+		start = find_next_zero_bit(chunk->bits, nbits, start);
+		if (start >= nbits)
+			break;
+		end = find_next_bit(chunk->bits, nbits, start);
+		len = (end - start) << order;
+		frag->free += len;
+		frag->largest = max(frag->largest, len);
+		frag->extents++;
+		frag->order_extents[min_t(int, get_order(len), MAX_ORDER)]++;
+		start = end;
+	}
+}
+
+static void ion_carveout_stat_time(struct ion_carveout_stats *stats,
+				   ktime_t start)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	s64 max = atomic64_read(&stats->max_ns);
+
+	atomic64_add(ns, &stats->total_ns);
+	while (ns > max) {
+		s64 old = atomic64_cmpxchg(&stats->max_ns, max, ns);
+
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+
 static phys_addr_t ion_carveout_allocate(struct ion_heap *heap,
 					 unsigned long size)
 {
 	struct ion_carveout_heap *carveout_heap = to_carveout_heap(heap);
+	struct ion_carveout_stats *stats = &carveout_heap->stats;
 	unsigned long offset = ION_CARVEOUT_ALLOCATE_FAIL;
+	ktime_t start = ktime_get();
 
 	down_read(&carveout_heap->mem_sem);
 	if (carveout_heap->pool) {
 		offset = gen_pool_alloc(carveout_heap->pool, size);
 		if (!offset) {
 			offset = ION_CARVEOUT_ALLOCATE_FAIL;
+			atomic_long_inc(&stats->failed);
+			if (gen_pool_avail(carveout_heap->pool) >= size)
+				atomic_long_inc(&stats->failed_fragmented);
 			goto unlock;
 		}
+		atomic_long_inc(&stats->allocs);
+		ion_carveout_stat_time(stats, start);
 	}
 
 unlock:
@@ -217,6 +281,12 @@ static int ion_carveout_init_heap_memory(struct ion_carveout_heap *co_heap,
 	if (!co_heap->pool)
 		return -ENOMEM;
 
+	/*
+	 * Best fit keeps large holes intact for as long as possible, which
+	 * first fit erodes over a long run of mixed size allocations.
+	 */
+	gen_pool_set_algo(co_heap->pool, gen_pool_best_fit, NULL);
+
 	co_heap->base = base;
 	gen_pool_add(co_heap->pool, co_heap->base, size, -1);
 	return ret;
@@ -283,9 +353,50 @@ static int ion_carveout_heap_remove_memory(struct ion_heap *ion_heap,
 	return ret;
 }
 
+static int ion_carveout_heap_debug_show(struct ion_heap *heap,
+					struct seq_file *s, void *unused)
+{
+	struct ion_carveout_heap *carveout_heap = to_carveout_heap(heap);
+	struct ion_carveout_stats *stats = &carveout_heap->stats;
+	struct ion_carveout_frag frag = {0};
+	unsigned long allocs, size = 0;
+	int order;
+
+	if (!s)
+		return 0;
+
+	down_read(&carveout_heap->mem_sem);
+	if (carveout_heap->pool) {
+		size = gen_pool_size(carveout_heap->pool);
+		gen_pool_for_each_chunk(carveout_heap->pool,
+					ion_carveout_frag_chunk, &frag);
+	}
+	up_read(&carveout_heap->mem_sem);
+
+	allocs = atomic_long_read(&stats->allocs);
+	seq_printf(s, "base %pa size %lu free %lu largest free %lu\n",
+		   &carveout_heap->base, size, frag.free, frag.largest);
+	/* 0 when all free space is contiguous, approaching 100 when shattered */
+	seq_printf(s, "free extents %lu fragmentation %lu%%\n", frag.extents,
+		   frag.free ? 100 - frag.largest * 100 / frag.free : 0);
+	seq_puts(s, "free extents by order:");
+	for (order = 0; order <= MAX_ORDER; order++)
+		seq_printf(s, " %lu", frag.order_extents[order]);
+	seq_puts(s, "\n");
+	seq_printf(s, "allocs %lu failed %lu failed with enough free %lu\n",
+		   allocs, atomic_long_read(&stats->failed),
+		   atomic_long_read(&stats->failed_fragmented));
+	seq_printf(s, "alloc latency avg %llu ns max %lld ns\n",
+		   allocs ? div64_u64(atomic64_read(&stats->total_ns), allocs) : 0,
+		   atomic64_read(&stats->max_ns));
+
+	return 0;
+}
+
 static struct msm_ion_heap_ops msm_carveout_heap_ops = {
 	.add_memory = ion_carveout_heap_add_memory,
 	.remove_memory = ion_carveout_heap_remove_memory,
+	.debug_show = ion_carveout_heap_debug_show,
 };
 
 static struct ion_heap *
@@ -417,6 +528,28 @@ static struct ion_heap_ops ion_sc_heap_ops = {
 	.free = ion_sc_heap_free,
 };
 
+static int ion_sc_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
+				  void *unused)
+{
+	struct ion_sc_heap *manager;
+	struct ion_sc_entry *entry;
+
+	if (!s)
+		return 0;
+
+	manager = container_of(to_msm_ion_heap(heap), struct ion_sc_heap, heap);
+	list_for_each_entry(entry, &manager->children, list) {
+		seq_printf(s, "token 0x%x:\n", entry->token);
+		ion_carveout_heap_debug_show(entry->heap, s, unused);
+	}
+
+	return 0;
+}
+
+static struct msm_ion_heap_ops msm_sc_heap_ops = {
+	.debug_show = ion_sc_heap_debug_show,
+};
+
 static int ion_sc_get_dt_token(struct ion_sc_entry *entry,
 			       struct device_node *np, u64 base, u64 size)
 {
@@ -524,6 +657,7 @@ ion_secure_carveout_heap_create(struct ion_platform_heap *heap_data)
 	}
 
 	manager->heap.ion_heap.ops = &ion_sc_heap_ops;
+	manager->heap.msm_heap_ops = &msm_sc_heap_ops;
 	manager->heap.ion_heap.buf_ops = msm_ion_dma_buf_ops;
 	manager->heap.ion_heap.type =
 		(enum ion_heap_type)ION_HEAP_TYPE_SECURE_CARVEOUT;
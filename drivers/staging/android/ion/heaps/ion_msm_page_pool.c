@@ -45,6 +45,147 @@ static void ion_msm_page_pool_add(struct ion_msm_page_pool *pool,
 	mutex_unlock(&pool->mutex);
 }
 
+/* Hand lowmem pages already accounted to the pool back to its shared list */
+static void ion_msm_page_pool_splice(struct ion_msm_page_pool *pool,
+				     struct list_head *pages, int nr)
+{
+	mutex_lock(&pool->mutex);
+	list_splice_tail(pages, &pool->low_items);
+	pool->low_count += nr;
+	mutex_unlock(&pool->mutex);
+}
+
+/*
+ * The per-CPU caches keep the common alloc/free path off the pool mutex.
+ * Pages in a cache still count as pool pages, they only move between the
+ * cache and the shared lists in batches.
+ */
+static struct page *ion_msm_pcp_pop(struct ion_msm_page_pool *pool)
+{
+	struct ion_msm_pcp *pcp = raw_cpu_ptr(pool->pcp);
+	struct page *page = NULL;
+
+	spin_lock(&pcp->lock);
+	if (pcp->count) {
+		page = list_first_entry(&pcp->items, struct page, lru);
+		list_del(&page->lru);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+
+	if (page) {
+		atomic_dec(&pool->pcp_count);
+		atomic_dec(&pool->count);
+		mod_node_page_state(page_pgdat(page),
+				    NR_KERNEL_MISC_RECLAIMABLE,
+				    -(1 << pool->order));
+	}
+	return page;
+}
+
+static bool ion_msm_pcp_refill(struct ion_msm_page_pool *pool)
+{
+	struct ion_msm_pcp *pcp;
+	struct page *page;
+	LIST_HEAD(batch);
+	int nr = 0;
+
+	if (!mutex_trylock(&pool->mutex))
+		return false;
+	while (nr < pool->pcp_batch && pool->low_count) {
+		page = list_first_entry(&pool->low_items, struct page, lru);
+		list_move_tail(&page->lru, &batch);
+		pool->low_count--;
+		nr++;
+	}
+	mutex_unlock(&pool->mutex);
+
+	if (!nr)
+		return false;
+
+	pcp = raw_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	list_splice(&batch, &pcp->items);
+	pcp->count += nr;
+	spin_unlock(&pcp->lock);
+	atomic_add(nr, &pool->pcp_count);
+
+	return true;
+}
+
+static struct page *ion_msm_pcp_alloc(struct ion_msm_page_pool *pool)
+{
+	struct page *page;
+
+	if (!pool->pcp)
+		return NULL;
+
+	page = ion_msm_pcp_pop(pool);
+	if (!page && ion_msm_pcp_refill(pool))
+		page = ion_msm_pcp_pop(pool);
+
+	return page;
+}
+
+static bool ion_msm_pcp_free(struct ion_msm_page_pool *pool, struct page *page)
+{
+	struct ion_msm_pcp *pcp;
+	struct page *cold;
+	LIST_HEAD(spill);
+	int nr = 0;
+
+	if (!pool->pcp || PageHighMem(page))
+		return false;
+
+	atomic_inc(&pool->count);
+	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+			    (1 << pool->order));
+
+	pcp = raw_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	list_add(&page->lru, &pcp->items);
+	pcp->count++;
+	if (pcp->count > pool->pcp_high) {
+		/* Spill the coldest pages back to the shared list */
+		while (nr < pool->pcp_batch) {
+			cold = list_last_entry(&pcp->items, struct page, lru);
+			list_move(&cold->lru, &spill);
+			nr++;
+		}
+		pcp->count -= nr;
+	}
+	spin_unlock(&pcp->lock);
+	atomic_add(1 - nr, &pool->pcp_count);
+
+	if (nr)
+		ion_msm_page_pool_splice(pool, &spill, nr);
+	return true;
+}
+
+static void ion_msm_pcp_drain(struct ion_msm_page_pool *pool)
+{
+	struct ion_msm_pcp *pcp;
+	LIST_HEAD(pages);
+	int cpu, nr = 0;
+
+	if (!pool->pcp || !atomic_read(&pool->pcp_count))
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock(&pcp->lock);
+		list_splice_init(&pcp->items, &pages);
+		nr += pcp->count;
+		pcp->count = 0;
+		spin_unlock(&pcp->lock);
+	}
+
+	if (nr) {
+		atomic_sub(nr, &pool->pcp_count);
+		ion_msm_page_pool_splice(pool, &pages, nr);
+	}
+}
+
 #ifdef CONFIG_ION_POOL_AUTO_REFILL
 /* do a simple check to see if we are in any low memory situation */
 static bool pool_refill_ok(struct ion_msm_page_pool *pool)
@@ -81,25 +222,60 @@ static bool pool_refill_ok(struct ion_msm_page_pool *pool)
 	return true;
 }
 
+/* Add freshly allocated pages to the pool in a single lock hold */
+static void ion_msm_page_pool_add_batch(struct ion_msm_page_pool *pool,
+					struct list_head *pages)
+{
+	struct page *page, *tmp;
+
+	mutex_lock(&pool->mutex);
+	list_for_each_entry_safe(page, tmp, pages, lru) {
+		if (PageHighMem(page)) {
+			list_move_tail(&page->lru, &pool->high_items);
+			pool->high_count++;
+		} else {
+			list_move_tail(&page->lru, &pool->low_items);
+			pool->low_count++;
+		}
+		atomic_inc(&pool->count);
+		mod_node_page_state(page_pgdat(page),
+				    NR_KERNEL_MISC_RECLAIMABLE,
+				    (1 << pool->order));
+	}
+	mutex_unlock(&pool->mutex);
+}
+
 void ion_msm_page_pool_refill(struct ion_msm_page_pool *pool)
 {
 	struct page *page;
 	gfp_t gfp_refill = (pool->gfp_mask | __GFP_RECLAIM) & ~__GFP_NORETRY;
 	struct device *dev = pool->heap_dev;
+	LIST_HEAD(batch);
+	int nr;
 
 	/* skip refilling order 0 pools */
 	if (!pool->order)
 		return;
 
 	while (!pool_fillmark_reached(pool) && pool_refill_ok(pool)) {
-		page = alloc_pages(gfp_refill, pool->order);
+		for (nr = 0; nr < ION_POOL_REFILL_BATCH; nr++) {
+			page = alloc_pages(gfp_refill, pool->order);
+			if (!page)
+				break;
+			if (!pool->cached)
+				ion_pages_sync_for_device(dev, page,
+						PAGE_SIZE << pool->order,
+						DMA_BIDIRECTIONAL);
+			list_add_tail(&page->lru, &batch);
+			if (atomic_read(&pool->count) + nr + 1 >=
+			    get_pool_fillmark(pool))
+				break;
+		}
+		if (list_empty(&batch))
+			break;
+		ion_msm_page_pool_add_batch(pool, &batch);
 		if (!page)
 			break;
-		if (!pool->cached)
-			ion_pages_sync_for_device(dev, page,
-						  PAGE_SIZE << pool->order,
-						  DMA_BIDIRECTIONAL);
-		ion_msm_page_pool_add(pool, page);
 	}
 }
 #endif /* CONFIG_ION_PAGE_POOL_REFILL */
@@ -136,6 +312,12 @@ struct page *ion_msm_page_pool_alloc(struct ion_msm_page_pool *pool,
 	if (fatal_signal_pending(current))
 		return ERR_PTR(-EINTR);
 
+	if (*from_pool) {
+		page = ion_msm_pcp_alloc(pool);
+		if (page)
+			return page;
+	}
+
 	if (*from_pool && mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_msm_page_pool_remove(pool, true);
@@ -163,6 +345,10 @@ struct page *ion_msm_page_pool_alloc_pool_only(struct ion_msm_page_pool *pool)
 	if (!pool)
 		return ERR_PTR(-EINVAL);
 
+	page = ion_msm_pcp_alloc(pool);
+	if (page)
+		return page;
+
 	if (mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_msm_page_pool_remove(pool, true);
@@ -178,6 +364,8 @@ struct page *ion_msm_page_pool_alloc_pool_only(struct ion_msm_page_pool *pool)
 
 void ion_msm_page_pool_free(struct ion_msm_page_pool *pool, struct page *page)
 {
+	if (ion_msm_pcp_free(pool, page))
+		return;
 	ion_msm_page_pool_add(pool, page);
 }
 
@@ -189,7 +377,7 @@ void ion_msm_page_pool_free_immediate(struct ion_msm_page_pool *pool,
 
 int ion_msm_page_pool_total(struct ion_msm_page_pool *pool, bool high)
 {
-	int count = pool->low_count;
+	int count = pool->low_count + atomic_read(&pool->pcp_count);
 
 	if (high)
 		count += pool->high_count;
@@ -211,6 +399,8 @@ int ion_msm_page_pool_shrink(struct ion_msm_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_msm_page_pool_total(pool, high);
 
+	ion_msm_pcp_drain(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -236,9 +426,26 @@ struct ion_msm_page_pool *ion_msm_page_pool_create(gfp_t gfp_mask,
 						   bool cached)
 {
 	struct ion_msm_page_pool *pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	struct ion_msm_pcp *pcp;
+	int cpu;
 
 	if (!pool)
 		return NULL;
+
+	pool->pcp_high = ION_POOL_PCP_BYTES >> (PAGE_SHIFT + order);
+	if (pool->pcp_high) {
+		pool->pcp = alloc_percpu(struct ion_msm_pcp);
+		if (!pool->pcp) {
+			kfree(pool);
+			return NULL;
+		}
+		for_each_possible_cpu(cpu) {
+			pcp = per_cpu_ptr(pool->pcp, cpu);
+			spin_lock_init(&pcp->lock);
+			INIT_LIST_HEAD(&pcp->items);
+		}
+		pool->pcp_batch = max(pool->pcp_high / 2, 1);
+	}
 	INIT_LIST_HEAD(&pool->low_items);
 	INIT_LIST_HEAD(&pool->high_items);
 	pool->gfp_mask = gfp_mask;
@@ -253,5 +460,6 @@ struct ion_msm_page_pool *ion_msm_page_pool_create(gfp_t gfp_mask,
 
 void ion_msm_page_pool_destroy(struct ion_msm_page_pool *pool)
 {
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
@@ -10,7 +10,10 @@
 
 #include <linux/mm_types.h>
 #include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/shrinker.h>
+#include <linux/sizes.h>
+#include <linux/spinlock.h>
 #include <linux/types.h>
 
 /* ION page pool marks in bytes */
@@ -26,6 +29,27 @@
 /* if low watermark of zones have reached, defer the refill in this window */
 #define ION_POOL_REFILL_DEFER_WINDOW_MS	10
 
+/* pages allocated by the refill worker before taking the pool lock */
+#define ION_POOL_REFILL_BATCH	16
+
+/*
+ * bytes each CPU may cache in front of a pool; orders whose pages don't fit
+ * go straight to the shared lists
+ */
+#define ION_POOL_PCP_BYTES	SZ_512K
+
+/**
+ * struct ion_msm_pcp - per-CPU cache in front of a page pool
+ * @lock:		protects the cache, only contended while it's drained
+ * @items:		cached lowmem pages, most recently freed first
+ * @count:		number of pages in @items
+ */
+struct ion_msm_pcp {
+	spinlock_t lock;
+	struct list_head items;
+	int count;
+};
+
 /**
  * functions for creating and destroying a heap pool -- allows you
  * to keep a pool of pre allocated memory to use from your heap.  Keeping
@@ -50,6 +74,10 @@
  * @list:		plist node for list of pools
  * @cached:		it's cached pool or not
  * @heap_dev:		device for the ion heap associated with this pool
+ * @pcp:		per-CPU caches, NULL if the order is too large to cache
+ * @pcp_high:		pages a per-CPU cache holds before spilling a batch
+ * @pcp_batch:		pages moved at once between a cache and the pool
+ * @pcp_count:		pages held in all the per-CPU caches
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
@@ -69,6 +97,10 @@ struct ion_msm_page_pool {
 	struct plist_node list;
 	bool cached;
 	struct device *heap_dev;
+	struct ion_msm_pcp __percpu *pcp;
+	int pcp_high;
+	int pcp_batch;
+	atomic_t pcp_count;
 };
 
 struct ion_msm_page_pool *ion_msm_page_pool_create(gfp_t gfp_mask,
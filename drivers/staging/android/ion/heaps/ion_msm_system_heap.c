@@ -11,6 +11,8 @@
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
 #include <linux/highmem.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
 #include <linux/ion.h>
 #include <linux/mm.h>
 #include <linux/module.h>
@@ -170,6 +172,35 @@ void free_buffer_page(struct ion_msm_system_heap *heap,
 	}
 }
 
+static void ion_alloc_lat_account(struct ion_alloc_lat_hist *hist,
+				  ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int b = 0;
+
+	if (us > 0)
+		b = min_t(int, ilog2(us) + 1, ION_ALLOC_LAT_BUCKETS - 1);
+	atomic_long_inc(&hist->buckets[b]);
+	atomic_long_add(max_t(s64, us, 0), &hist->total_us);
+}
+
+static void ion_alloc_lat_show(struct seq_file *s, const char *name,
+			       struct ion_alloc_lat_hist *hist)
+{
+	long cnt, nr = 0;
+	int b;
+
+	seq_printf(s, "%s alloc latency:", name);
+	for (b = 0; b < ION_ALLOC_LAT_BUCKETS; b++) {
+		cnt = atomic_long_read(&hist->buckets[b]);
+		nr += cnt;
+		if (cnt)
+			seq_printf(s, " <%luus:%ld", 1UL << b, cnt);
+	}
+	seq_printf(s, " avg:%ldus\n",
+		   nr ? atomic_long_read(&hist->total_us) / nr : 0);
+}
+
 static struct
 page_info *alloc_largest_available(struct ion_msm_system_heap *heap,
 				   struct ion_buffer *buffer,
@@ -180,6 +211,7 @@ page_info *alloc_largest_available(struct ion_msm_system_heap *heap,
 	struct page_info *info;
 	int i;
 	bool from_pool;
+	ktime_t start;
 
 	info = kmalloc(sizeof(*info), GFP_KERNEL);
 	if (!info)
@@ -191,9 +223,11 @@ page_info *alloc_largest_available(struct ion_msm_system_heap *heap,
 		if (max_order < orders[i])
 			continue;
 		from_pool = !(buffer->flags & ION_FLAG_POOL_FORCE_ALLOC);
+		start = ktime_get();
 		page = alloc_buffer_page(heap, buffer, orders[i], &from_pool);
 		if (IS_ERR(page))
 			continue;
+		ion_alloc_lat_account(&heap->page_lat[i], start);
 
 		info->page = page;
 		info->order = orders[i];
@@ -334,6 +368,7 @@ static int ion_msm_system_heap_allocate(struct ion_heap *heap,
 	unsigned int max_order = orders[0];
 	unsigned int sz;
 	int vmid = get_secure_vmid(buffer->flags);
+	ktime_t start = ktime_get();
 
 	if (size / PAGE_SIZE > totalram_pages() / 2)
 		return -ENOMEM;
@@ -463,6 +498,7 @@ static int ion_msm_system_heap_allocate(struct ion_heap *heap,
 	buffer->priv_virt = lock_state;
 
 	ion_prepare_sgl_for_force_dma_sync(buffer->sg_table);
+	ion_alloc_lat_account(&sys_heap->buf_lat, start);
 	return 0;
 
 err_free_sg2:
@@ -592,6 +628,8 @@ static long ion_msm_system_heap_get_pool_size(struct ion_heap *heap)
 				pool->high_count;
 		total_size += (1 << pool->order) *
 				pool->low_count;
+		total_size += (1 << pool->order) *
+				atomic_read(&pool->pcp_count);
 	}
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -600,6 +638,8 @@ static long ion_msm_system_heap_get_pool_size(struct ion_heap *heap)
 				pool->high_count;
 		total_size += (1 << pool->order) *
 				pool->low_count;
+		total_size += (1 << pool->order) *
+				atomic_read(&pool->pcp_count);
 	}
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -611,6 +651,8 @@ static long ion_msm_system_heap_get_pool_size(struct ion_heap *heap)
 				pool->high_count;
 		total_size += (1 << pool->order) *
 				pool->low_count;
+		total_size += (1 << pool->order) *
+				atomic_read(&pool->pcp_count);
 		}
 	}
 
@@ -649,12 +691,19 @@ static int ion_msm_system_heap_debug_show(struct ion_heap *heap,
 				   pool->low_count, pool->order,
 				   (1 << pool->order) * PAGE_SIZE *
 					pool->low_count);
+			seq_printf(s,
+				   "%d order %u pages in uncached per-cpu caches = %lu total\n",
+				   atomic_read(&pool->pcp_count), pool->order,
+				   (1 << pool->order) * PAGE_SIZE *
+					atomic_read(&pool->pcp_count));
 		}
 
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->high_count;
 		uncached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		uncached_total += (1 << pool->order) * PAGE_SIZE *
+			atomic_read(&pool->pcp_count);
 	}
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -670,12 +719,19 @@ static int ion_msm_system_heap_debug_show(struct ion_heap *heap,
 				   pool->low_count, pool->order,
 				   (1 << pool->order) * PAGE_SIZE *
 					pool->low_count);
+			seq_printf(s,
+				   "%d order %u pages in cached per-cpu caches = %lu total\n",
+				   atomic_read(&pool->pcp_count), pool->order,
+				   (1 << pool->order) * PAGE_SIZE *
+					atomic_read(&pool->pcp_count));
 		}
 
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->high_count;
 		cached_total += (1 << pool->order) * PAGE_SIZE *
 			pool->low_count;
+		cached_total += (1 << pool->order) * PAGE_SIZE *
+			atomic_read(&pool->pcp_count);
 	}
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -701,6 +757,8 @@ static int ion_msm_system_heap_debug_show(struct ion_heap *heap,
 					 pool->high_count;
 			secure_total += (1 << pool->order) * PAGE_SIZE *
 					 pool->low_count;
+			secure_total += (1 << pool->order) * PAGE_SIZE *
+					 atomic_read(&pool->pcp_count);
 		}
 	}
 
@@ -711,6 +769,14 @@ static int ion_msm_system_heap_debug_show(struct ion_heap *heap,
 		seq_printf(s, "pool total (uncached + cached + secure) = %lu\n",
 			   uncached_total + cached_total + secure_total);
 		seq_puts(s, "--------------------------------------------\n");
+		for (i = 0; i < NUM_ORDERS; i++) {
+			char name[16];
+
+			snprintf(name, sizeof(name), "order %u", orders[i]);
+			ion_alloc_lat_show(s, name, &sys_heap->page_lat[i]);
+		}
+		ion_alloc_lat_show(s, "buffer", &sys_heap->buf_lat);
+		seq_puts(s, "--------------------------------------------\n");
 	} else {
 		pr_info("-------------------------------------------------\n");
 		pr_info("uncached pool = %lu cached pool = %lu secure pool = %lu\n",
@@ -25,6 +25,14 @@ static const unsigned int orders[] = {0};
 #define to_msm_system_heap(_heap) \
 	container_of(to_msm_ion_heap(_heap), struct ion_msm_system_heap, heap)
 
+/* log2 latency buckets starting at 1us, the last one is open ended */
+#define ION_ALLOC_LAT_BUCKETS 16
+
+struct ion_alloc_lat_hist {
+	atomic_long_t buckets[ION_ALLOC_LAT_BUCKETS];
+	atomic_long_t total_us;
+};
+
 enum ion_kthread_type {
 	ION_KTHREAD_UNCACHED,
 	ION_KTHREAD_CACHED,
@@ -40,6 +48,9 @@ struct ion_msm_system_heap {
 	struct ion_msm_page_pool *secure_pools[VMID_LAST][MAX_ORDER];
 	/* Prevents unnecessary page splitting */
 	struct mutex split_page_mutex;
+	/* per-order page and whole buffer allocation latency */
+	struct ion_alloc_lat_hist page_lat[NUM_ORDERS];
+	struct ion_alloc_lat_hist buf_lat;
 };
 
 struct page_info {
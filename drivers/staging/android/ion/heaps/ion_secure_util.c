@@ -179,13 +179,14 @@ int ion_hyp_unassign_sg(struct sg_table *sgt, int *source_vm_list,
 	return ret;
 }
 
-int ion_hyp_assign_sg(struct sg_table *sgt, int *dest_vm_list,
-		      int dest_nelems, bool set_page_private)
+int ion_hyp_assign_sgs(struct sg_table **sgts, int nr_sgts,
+		       int *dest_vm_list, int dest_nelems,
+		       bool set_page_private)
 {
 	u32 source_vmid = VMID_HLOS;
 	struct scatterlist *sg;
 	int *dest_perms;
-	int i;
+	int i, j;
 	int ret = 0;
 
 	if (dest_nelems <= 0) {
@@ -204,8 +205,8 @@ int ion_hyp_assign_sg(struct sg_table *sgt, int *dest_vm_list,
 	for (i = 0; i < dest_nelems; i++)
 		dest_perms[i] = msm_secure_get_vmid_perms(dest_vm_list[i]);
 
-	ret = hyp_assign_table(sgt, &source_vmid, 1,
-			       dest_vm_list, dest_perms, dest_nelems);
+	ret = hyp_assign_table_batch(sgts, nr_sgts, &source_vmid, 1,
+				     dest_vm_list, dest_perms, dest_nelems);
 
 	if (ret) {
 		pr_err("%s: Assign call failed\n",
@@ -213,8 +214,9 @@ int ion_hyp_assign_sg(struct sg_table *sgt, int *dest_vm_list,
 		goto out_free_dest;
 	}
 	if (set_page_private)
-		for_each_sg(sgt->sgl, sg, sgt->nents, i)
-			SetPagePrivate(sg_page(sg));
+		for (j = 0; j < nr_sgts; j++)
+			for_each_sg(sgts[j]->sgl, sg, sgts[j]->nents, i)
+				SetPagePrivate(sg_page(sg));
 
 out_free_dest:
 	kfree(dest_perms);
@@ -222,6 +224,13 @@ int ion_hyp_assign_sg(struct sg_table *sgt, int *dest_vm_list,
 	return ret;
 }
 
+int ion_hyp_assign_sg(struct sg_table *sgt, int *dest_vm_list,
+		      int dest_nelems, bool set_page_private)
+{
+	return ion_hyp_assign_sgs(&sgt, 1, dest_vm_list, dest_nelems,
+				  set_page_private);
+}
+
 int ion_hyp_unassign_sg_from_flags(struct sg_table *sgt, unsigned long flags,
 				   bool set_page_private)
 {
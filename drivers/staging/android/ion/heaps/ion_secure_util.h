@@ -12,6 +12,9 @@ int get_secure_vmid(unsigned long flags);
 bool is_secure_vmid_valid(int vmid);
 int ion_hyp_assign_sg(struct sg_table *sgt, int *dest_vm_list,
 		      int dest_nelems, bool set_page_private);
+int ion_hyp_assign_sgs(struct sg_table **sgts, int nr_sgts,
+		       int *dest_vm_list, int dest_nelems,
+		       bool set_page_private);
 int ion_hyp_unassign_sg(struct sg_table *sgt, int *source_vm_list,
 			int source_nelems, bool clear_page_private);
 int ion_hyp_unassign_sg_from_flags(struct sg_table *sgt, unsigned long flags,
@@ -4,6 +4,10 @@
  */
 
 #include <linux/slab.h>
+#include <linux/sizes.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
 #include <soc/qcom/secure_buffer.h>
 #include <linux/workqueue.h>
 #include <linux/uaccess.h>
@@ -16,6 +20,23 @@
 #include "ion_secure_util.h"
 
 #define MAX_NR_PREFETCH_REGIONS 32
+
+/*
+ * Autonomous refill: every SECURE_REFILL_INTERVAL_MS the bytes allocated
+ * per VMID are sampled, and the secure pool of that VMID is topped up to
+ * the decayed peak of those samples, capped at SECURE_REFILL_MAX. Refill
+ * is held off for SECURE_REFILL_DEFER_MS after the pools were shrunk.
+ */
+#define SECURE_REFILL_INTERVAL_MS 500
+#define SECURE_REFILL_DEFER_MS 5000
+#define SECURE_REFILL_MAX SZ_64M
+#define SECURE_REFILL_DECAY_SHIFT 3
+
+struct secure_refill_state {
+	atomic_long_t demand;
+	unsigned long target;
+	unsigned long refills;
+};
 #define to_system_secure_heap(_heap) \
 	container_of(to_msm_ion_heap(_heap), struct ion_system_secure_heap, \
 		     heap)
@@ -30,8 +51,17 @@ struct ion_system_secure_heap {
 	struct list_head prefetch_list;
 	struct delayed_work prefetch_work;
 	struct workqueue_struct *prefetch_wq;
+
+	struct secure_refill_state refill[VMID_LAST];
+	struct delayed_work refill_work;
 };
 
+static bool secure_auto_refill = true;
+module_param(secure_auto_refill, bool, 0644);
+
+/* Last time the shrinker took pages out of a secure pool */
+static ktime_t secure_pool_shrink_ktime;
+
 struct prefetch_info {
 	struct list_head list;
 	int vmid;
@@ -87,6 +117,7 @@ static int ion_system_secure_heap_allocate(struct ion_heap *heap,
 		to_system_secure_heap(heap);
 	enum ion_heap_type type = secure_heap->heap.ion_heap.type;
 	unsigned long cp_flags = buffer->flags & ION_FLAGS_CP_MASK;
+	int vmid;
 
 	if (!ion_heap_is_system_secure_heap_type(type) ||
 	    !is_cp_flag_present(flags) || (hweight_long(cp_flags) != 1)) {
@@ -102,49 +133,79 @@ static int ion_system_secure_heap_allocate(struct ion_heap *heap,
 			__func__, heap->name, ret);
 		return ret;
 	}
+
+	vmid = get_secure_vmid(buffer->flags);
+	if (secure_auto_refill && is_secure_vmid_valid(vmid)) {
+		atomic_long_add(size, &secure_heap->refill[vmid].demand);
+		queue_delayed_work(secure_heap->prefetch_wq,
+				   &secure_heap->refill_work,
+				   msecs_to_jiffies(SECURE_REFILL_INTERVAL_MS));
+	}
 	return ret;
 }
 
-static void process_one_prefetch(struct ion_heap *sys_heap,
-				 struct prefetch_info *info)
+/*
+ * Allocate the buffers for a run of prefetch requests to the same VMID and
+ * assign them all with a single batched hypervisor call, rather than paying
+ * for one call per region.
+ */
+static void process_prefetch_batch(struct ion_heap *sys_heap,
+				   struct list_head *infos, int nr)
 {
-	struct ion_buffer buffer;
-	int ret;
+	struct ion_buffer *buffers;
+	struct sg_table **tables;
+	struct prefetch_info *info;
+	int i, n = 0;
+	int ret = -EINVAL;
 	int vmid;
 
-	memset(&buffer, 0, sizeof(struct ion_buffer));
-	buffer.heap = sys_heap;
+	buffers = kcalloc(nr, sizeof(*buffers), GFP_KERNEL);
+	tables = kcalloc(nr, sizeof(*tables), GFP_KERNEL);
+	if (!buffers || !tables)
+		goto out_free;
 
-	ret = sys_heap->ops->allocate(sys_heap, &buffer, info->size,
-					buffer.flags);
-	if (ret) {
-		pr_debug("%s: Failed to prefetch 0x%llx, ret = %d\n",
-			 __func__, info->size, ret);
-		return;
+	list_for_each_entry(info, infos, list) {
+		memset(&buffers[n], 0, sizeof(*buffers));
+		buffers[n].heap = sys_heap;
+		ret = sys_heap->ops->allocate(sys_heap, &buffers[n],
+					      info->size, buffers[n].flags);
+		if (ret) {
+			pr_debug("%s: Failed to prefetch 0x%llx, ret = %d\n",
+				 __func__, info->size, ret);
+			continue;
+		}
+		tables[n] = buffers[n].sg_table;
+		n++;
 	}
+	if (!n)
+		goto out_free;
 
+	info = list_first_entry(infos, struct prefetch_info, list);
 	vmid = get_secure_vmid(info->vmid);
 	if (vmid < 0)
 		goto out;
 
-	ret = ion_hyp_assign_sg(buffer.sg_table, &vmid, 1, true);
+	ret = ion_hyp_assign_sgs(tables, n, &vmid, 1, true);
 	if (ret == -EADDRNOTAVAIL)
-		goto out1;
+		/*
+		 * The security state of the pages is unknown after a
+		 * failure; They can neither be added back to the secure
+		 * pool nor buddy system.
+		 */
+		goto out_free;
 	else if (ret < 0)
 		goto out;
 
-	/* Now free it to the secure heap */
-	buffer.heap = sys_heap;
-	buffer.flags = info->vmid;
+	/* Now free them to the secure heap */
+	for (i = 0; i < n; i++)
+		buffers[i].flags = info->vmid;
 
 out:
-	sys_heap->ops->free(&buffer);
-out1:
-	/*
-	 * The security state of the pages is unknown after a failure;
-	 * They can neither be added back to the secure pool nor buddy system.
-	 */
-	return;
+	for (i = 0; i < n; i++)
+		sys_heap->ops->free(&buffers[i]);
+out_free:
+	kfree(tables);
+	kfree(buffers);
 }
 
 /*
@@ -206,19 +267,37 @@ static void ion_system_secure_heap_prefetch_work(struct work_struct *work)
 	struct ion_heap *sys_heap = secure_heap->sys_heap;
 	struct prefetch_info *info, *tmp;
 	unsigned long flags;
+	LIST_HEAD(batch);
+	int nr;
 
 	spin_lock_irqsave(&secure_heap->work_lock, flags);
-	list_for_each_entry_safe(info, tmp,
-				 &secure_heap->prefetch_list, list) {
-		list_del(&info->list);
+	while (!list_empty(&secure_heap->prefetch_list)) {
+		info = list_first_entry(&secure_heap->prefetch_list,
+					struct prefetch_info, list);
+		list_move_tail(&info->list, &batch);
+		nr = 1;
+
+		/* Gather the following prefetches to the same VMID */
+		while (!info->shrink && nr < MAX_NR_PREFETCH_REGIONS &&
+		       !list_empty(&secure_heap->prefetch_list)) {
+			tmp = list_first_entry(&secure_heap->prefetch_list,
+					       struct prefetch_info, list);
+			if (tmp->shrink || tmp->vmid != info->vmid)
+				break;
+			list_move_tail(&tmp->list, &batch);
+			nr++;
+		}
 		spin_unlock_irqrestore(&secure_heap->work_lock, flags);
 
 		if (info->shrink)
 			process_one_shrink(secure_heap, sys_heap, info);
 		else
-			process_one_prefetch(sys_heap, info);
+			process_prefetch_batch(sys_heap, &batch, nr);
 
-		kfree(info);
+		list_for_each_entry_safe(info, tmp, &batch, list) {
+			list_del(&info->list);
+			kfree(info);
+		}
 		spin_lock_irqsave(&secure_heap->work_lock, flags);
 	}
 	spin_unlock_irqrestore(&secure_heap->work_lock, flags);
@@ -286,6 +365,112 @@ static int __ion_system_secure_heap_resize(struct ion_heap *heap,
 	return ret;
 }
 
+static void ion_system_secure_heap_refill_work(struct work_struct *work)
+{
+	struct ion_system_secure_heap *secure_heap = container_of(work,
+						struct ion_system_secure_heap,
+						refill_work.work);
+	struct secure_refill_state *r;
+	struct ion_prefetch_region region;
+	struct prefetch_info *info, *tmp;
+	unsigned long demand, flags;
+	size_t pooled;
+	bool pressure, active = false;
+	int vmid, ion_flags;
+	LIST_HEAD(items);
+
+	pressure = ktime_ms_delta(ktime_get(), secure_pool_shrink_ktime) <
+		   SECURE_REFILL_DEFER_MS;
+
+	for (vmid = 0; vmid < VMID_LAST; vmid++) {
+		if (!is_secure_vmid_valid(vmid))
+			continue;
+		r = &secure_heap->refill[vmid];
+		demand = atomic_long_xchg(&r->demand, 0);
+
+		/* Follow demand spikes at once, decay slowly when idle */
+		if (demand >= r->target)
+			r->target = min_t(unsigned long, demand,
+					  SECURE_REFILL_MAX);
+		else
+			r->target -= (r->target - demand) >>
+				     SECURE_REFILL_DECAY_SHIFT;
+		if (pressure)
+			r->target >>= 1;
+		if (r->target < PAGE_SIZE)
+			r->target = 0;
+		if (!r->target)
+			continue;
+
+		active = true;
+		if (pressure)
+			continue;
+
+		ion_flags = get_ion_flags(vmid);
+		if (ion_flags < 0)
+			continue;
+		pooled = ion_system_secure_heap_page_pool_total(
+					secure_heap->sys_heap, ion_flags);
+		/* Don't bother for less than a quarter of the target */
+		if (pooled + (r->target >> 2) > r->target)
+			continue;
+
+		region.vmid = ion_flags;
+		region.size = PAGE_ALIGN(r->target - pooled);
+		if (!alloc_prefetch_info(&region, false, &items))
+			r->refills++;
+	}
+
+	spin_lock_irqsave(&secure_heap->work_lock, flags);
+	if (secure_heap->destroy_heap) {
+		spin_unlock_irqrestore(&secure_heap->work_lock, flags);
+		list_for_each_entry_safe(info, tmp, &items, list) {
+			list_del(&info->list);
+			kfree(info);
+		}
+		return;
+	}
+	if (!list_empty(&items)) {
+		list_splice_tail_init(&items, &secure_heap->prefetch_list);
+		queue_delayed_work(secure_heap->prefetch_wq,
+				   &secure_heap->prefetch_work, 0);
+	}
+	if (active && secure_auto_refill)
+		queue_delayed_work(secure_heap->prefetch_wq,
+				   &secure_heap->refill_work,
+				   msecs_to_jiffies(SECURE_REFILL_INTERVAL_MS));
+	spin_unlock_irqrestore(&secure_heap->work_lock, flags);
+}
+
+static int ion_system_secure_heap_debug_show(struct ion_heap *heap,
+					     struct seq_file *s, void *unused)
+{
+	struct ion_system_secure_heap *secure_heap =
+		to_system_secure_heap(heap);
+	struct secure_refill_state *r;
+	int vmid, ion_flags;
+
+	if (!s)
+		return 0;
+
+	seq_printf(s, "auto refill: %s\n",
+		   secure_auto_refill ? "enabled" : "disabled");
+	for (vmid = 0; vmid < VMID_LAST; vmid++) {
+		if (!is_secure_vmid_valid(vmid))
+			continue;
+		ion_flags = get_ion_flags(vmid);
+		if (ion_flags < 0)
+			continue;
+		r = &secure_heap->refill[vmid];
+		seq_printf(s, "VMID %d: target %lu pooled %zu refills %lu\n",
+			   vmid, r->target,
+			   ion_system_secure_heap_page_pool_total(
+					secure_heap->sys_heap, ion_flags),
+			   r->refills);
+	}
+	return 0;
+}
+
 static int ion_system_secure_heap_prefetch(struct ion_heap *heap,
 					   struct ion_prefetch_region *regions,
 					   int nr_regions)
@@ -320,6 +505,7 @@ static struct ion_heap_ops system_secure_heap_ops = {
 static struct msm_ion_heap_ops msm_system_secure_heap_ops = {
 	.heap_prefetch = ion_system_secure_heap_prefetch,
 	.heap_drain = ion_system_secure_heap_drain,
+	.debug_show = ion_system_secure_heap_debug_show,
 };
 
 struct ion_heap *ion_system_secure_heap_create(struct ion_platform_heap *unused)
@@ -347,6 +533,8 @@ struct ion_heap *ion_system_secure_heap_create(struct ion_platform_heap *unused)
 	INIT_LIST_HEAD(&heap->prefetch_list);
 	INIT_DELAYED_WORK(&heap->prefetch_work,
 			  ion_system_secure_heap_prefetch_work);
+	INIT_DELAYED_WORK(&heap->refill_work,
+			  ion_system_secure_heap_refill_work);
 
 	heap->prefetch_wq = alloc_workqueue("system_secure_prefetch_wq",
 					    WQ_UNBOUND | WQ_FREEZABLE, 0);
@@ -443,6 +631,9 @@ int ion_secure_page_pool_shrink(struct ion_msm_system_heap *sys_heap,
 	if (!freed)
 		return freed;
 
+	/* Hold off the autonomous refill while memory is tight */
+	secure_pool_shrink_ktime = ktime_get();
+
 	ret = sg_alloc_table(&sgt, (freed >> order), GFP_KERNEL);
 	if (ret)
 		goto out1;
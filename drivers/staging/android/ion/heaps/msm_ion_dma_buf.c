@@ -31,6 +31,7 @@ static void *msm_ion_buffer_kmap_get(struct ion_buffer *buffer)
 		buffer->kmap_cnt++;
 		return buffer->vaddr;
 	}
+	buffer->cpu_clean = false;
 	vaddr = ion_heap_map_kernel(buffer->heap, buffer);
 	if (WARN_ONCE(!vaddr,
 		      "ion_heap_map_kernel should return ERR_PTR on error"))
@@ -90,6 +91,33 @@ static void free_duped_table(struct sg_table *table)
 	kfree(table);
 }
 
+static void reset_duped_table(struct sg_table *table)
+{
+	struct scatterlist *sg;
+	int i;
+
+	for_each_sg(table->sgl, sg, table->nents, i) {
+		sg_dma_address(sg) = 0;
+		sg_dma_len(sg) = 0;
+	}
+}
+
+/*
+ * Whether the CPU caches can hold dirty lines for the buffer that a DMA map
+ * would have to clean or invalidate. The buffer is clean once a map has done
+ * cache maintenance, and stays clean for as long as the CPU has no way to
+ * write to it.
+ */
+static bool msm_ion_buffer_cpu_clean(struct ion_buffer *buffer)
+{
+	struct msm_ion_buf_lock_state *lock_state = buffer->priv_virt;
+
+	if (!buffer->cpu_clean || buffer->kmap_cnt || buffer->user_mapped)
+		return false;
+
+	return !lock_state || !lock_state->vma_count;
+}
+
 struct msm_ion_dma_buf_attachment {
 	struct device *dev;
 	struct sg_table *table;
@@ -108,7 +136,17 @@ static int msm_ion_dma_buf_attach(struct dma_buf *dmabuf,
 	if (!a)
 		return -ENOMEM;
 
-	table = dup_sg_table(buffer->sg_table);
+	/*
+	 * Importers tend to attach and detach the same buffer every frame, so
+	 * reuse the table copy left behind by the last detach if there is one.
+	 */
+	mutex_lock(&buffer->lock);
+	table = buffer->spare_table;
+	buffer->spare_table = NULL;
+	mutex_unlock(&buffer->lock);
+
+	if (!table)
+		table = dup_sg_table(buffer->sg_table);
 	if (IS_ERR(table)) {
 		kfree(a);
 		return -ENOMEM;
@@ -136,8 +174,14 @@ static void msm_ion_dma_buf_detatch(struct dma_buf *dmabuf,
 
 	mutex_lock(&buffer->lock);
 	list_del(&a->list);
+	if (!buffer->spare_table) {
+		reset_duped_table(a->table);
+		buffer->spare_table = a->table;
+		a->table = NULL;
+	}
 	mutex_unlock(&buffer->lock);
-	free_duped_table(a->table);
+	if (a->table)
+		free_duped_table(a->table);
 
 	kfree(a);
 }
@@ -156,6 +200,7 @@ static struct sg_table
 	int count, map_attrs;
 	struct ion_buffer *buffer = attachment->dmabuf->priv;
 	unsigned long ino = file_inode(attachment->dmabuf->file)->i_ino;
+	bool coherent;
 
 	table = a->table;
 
@@ -170,16 +215,21 @@ static struct sg_table
 	    dev_is_dma_coherent_hint_cached(attachment->dev))
 		map_attrs |= DMA_ATTR_FORCE_COHERENT;
 
-	if (((dev_is_dma_coherent(attachment->dev) &&
-	      !(map_attrs & DMA_ATTR_FORCE_NON_COHERENT)) ||
-	     (map_attrs & DMA_ATTR_FORCE_COHERENT)) &&
-	    !(buffer->flags & ION_FLAG_CACHED)) {
+	coherent = (dev_is_dma_coherent(attachment->dev) &&
+		    !(map_attrs & DMA_ATTR_FORCE_NON_COHERENT)) ||
+		   (map_attrs & DMA_ATTR_FORCE_COHERENT);
+
+	if (coherent && !(buffer->flags & ION_FLAG_CACHED)) {
 		pr_warn_ratelimited("dev:%s Cannot DMA map uncached buffer as IO-coherent attrs:0x%lx\n",
 				    dev_name(attachment->dev), map_attrs);
 		mutex_unlock(&buffer->lock);
 		return ERR_PTR(-EINVAL);
 	}
 
+	/* Nothing for the map to clean if the CPU cannot have dirtied it */
+	if (!coherent && msm_ion_buffer_cpu_clean(buffer))
+		map_attrs |= DMA_ATTR_SKIP_CPU_SYNC;
+
 	if (map_attrs & DMA_ATTR_SKIP_CPU_SYNC)
 		trace_ion_dma_map_cmo_skip(attachment->dev,
 					   ino,
@@ -210,6 +260,15 @@ static struct sg_table
 		return ERR_PTR(-ENOMEM);
 	}
 
+	/*
+	 * A non-coherent map has just cleaned or invalidated the buffer. A
+	 * coherent device writing to it may leave lines dirty in the caches.
+	 */
+	if (!coherent && !(map_attrs & DMA_ATTR_SKIP_CPU_SYNC))
+		buffer->cpu_clean = true;
+	else if (coherent && direction != DMA_TO_DEVICE)
+		buffer->cpu_clean = false;
+
 	a->dma_mapped = true;
 	mutex_unlock(&buffer->lock);
 	return table;
@@ -346,6 +405,10 @@ static int msm_ion_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 	if (!(buffer->flags & ION_FLAG_CACHED))
 		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 
+	buffer->cpu_clean = false;
+	if (!lock_state)
+		buffer->user_mapped = true;
+
 	/* now map it to userspace */
 	ret = ion_heap_map_user(buffer->heap, buffer, vma);
 
@@ -432,6 +495,8 @@ static void msm_ion_dma_buf_release(struct dma_buf *dmabuf)
 	struct ion_buffer *buffer = dmabuf->priv;
 
 	msm_dma_buf_freed(buffer);
+	if (buffer->spare_table)
+		free_duped_table(buffer->spare_table);
 	ion_free(buffer);
 }
 
@@ -552,6 +617,7 @@ static int msm_ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 	int ret = 0;
 
 	mutex_lock(&buffer->lock);
+	buffer->cpu_clean = false;
 	if (!hlos_accessible_buffer(buffer)) {
 		trace_ion_begin_cpu_access_cmo_skip(NULL, ino,
 						    ion_buffer_cached(buffer),
@@ -665,6 +731,7 @@ static int msm_ion_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 	int ret = 0;
 
 	mutex_lock(&buffer->lock);
+	buffer->cpu_clean = false;
 	if (!hlos_accessible_buffer(buffer)) {
 		trace_ion_begin_cpu_access_cmo_skip(NULL, ino,
 						    ion_buffer_cached(buffer),
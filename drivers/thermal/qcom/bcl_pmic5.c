@@ -884,6 +884,7 @@ static struct platform_driver bcl_driver = {
 	.driver = {
 		.name           = BCL_DRIVER_NAME,
 		.of_match_table = bcl_match,
+		.probe_type     = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_platform_driver(bcl_driver);
@@ -247,6 +247,7 @@ static struct platform_driver cxip_lm_cdev_driver = {
 	.driver = {
 		.name = CXIP_LM_CDEV_DRIVER,
 		.of_match_table = cxip_lm_cdev_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = cxip_lm_cdev_probe,
 	.remove = cxip_lm_cdev_remove,
@@ -202,6 +202,7 @@ static struct platform_driver ddr_cdev_driver = {
 	.driver		= {
 		.name = KBUILD_MODNAME,
 		.of_match_table = ddr_cdev_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 module_platform_driver(ddr_cdev_driver);
@@ -215,6 +215,7 @@ static struct platform_driver devfreq_vdd_cdev_driver = {
 	.driver		= {
 		.name = DEVFREQ_VDD_CDEV_DRIVER,
 		.of_match_table = devfreq_vdd_cdev_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
@@ -174,6 +174,7 @@ static struct platform_driver lmh_cpu_vdd_driver = {
 	.driver		= {
 		.name = KBUILD_MODNAME,
 		.of_match_table = lmh_cpu_vdd_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 builtin_platform_driver(lmh_cpu_vdd_driver);
@@ -359,6 +359,7 @@ static struct i2c_driver max31760_i2c_driver = {
 		.name = "max31760",
 		.of_match_table = max31760_id_table,
 		.pm = &max31760_pm_ops,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.id_table = max31760_i2c_table,
 };
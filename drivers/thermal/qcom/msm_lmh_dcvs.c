@@ -85,6 +85,37 @@ struct limits_dcvs_hw {
 LIST_HEAD(lmh_dcvs_hw_list);
 DEFINE_MUTEX(lmh_dcvs_list_access);
 
+/*
+ * When LMh lifts its clamp, restore the frequency ceiling one OPP per
+ * polling interval instead of jumping straight back to the hardware
+ * limit. Jumping back to fmax after a clamp tends to retrigger LMh
+ * within a few polls, and the clamp/release oscillation is what shows
+ * up as frame-rate cliffs. New clamps are always applied immediately.
+ */
+static bool release_ramp;
+module_param(release_ramp, bool, 0644);
+MODULE_PARM_DESC(release_ramp, "Ramp the frequency ceiling up one OPP per poll on LMh release");
+
+static unsigned long limits_release_step(struct limits_dcvs_hw *hw,
+					 struct device *cpu_dev,
+					 unsigned long max_limit)
+{
+	unsigned long freq_val;
+	struct dev_pm_opp *opp_entry;
+
+	if (!release_ramp || !hw->hw_freq_limit ||
+	    hw->hw_freq_limit == U32_MAX || max_limit <= hw->hw_freq_limit)
+		return max_limit;
+
+	freq_val = FREQ_KHZ_TO_HZ(hw->hw_freq_limit) + 1;
+	opp_entry = dev_pm_opp_find_freq_ceil(cpu_dev, &freq_val);
+	if (IS_ERR(opp_entry))
+		return max_limit;
+	dev_pm_opp_put(opp_entry);
+
+	return min(max_limit, FREQ_HZ_TO_KHZ(freq_val));
+}
+
 static void limits_dcvs_get_freq_limits(struct limits_dcvs_hw *hw)
 {
 	unsigned long freq_ceil = UINT_MAX, freq_floor = 0;
@@ -158,6 +189,7 @@ static unsigned long limits_mitigation_notify(struct limits_dcvs_hw *hw)
 
 	if (max_cpu_ct == cpumask_weight(&hw->core_map))
 		max_limit = max_cpu_limit;
+	max_limit = limits_release_step(hw, cpu_dev, max_limit);
 	sched_update_cpu_freq_min_max(&hw->core_map, 0, max_limit);
 	pr_debug("CPU:%d max limit:%lu\n", cpumask_first(&hw->core_map),
 			max_limit);
@@ -155,6 +155,7 @@ static struct platform_driver reg_cdev_driver = {
 	.driver = {
 		.name = REG_CDEV_DRIVER,
 		.of_match_table = reg_cdev_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = reg_cdev_probe,
 };
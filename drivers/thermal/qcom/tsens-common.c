@@ -5,6 +5,7 @@
 
 #include <linux/err.h>
 #include <linux/io.h>
+#include <linux/module.h>
 #include <linux/nvmem-consumer.h>
 #include <linux/of_address.h>
 #include <linux/of_platform.h>
@@ -12,6 +13,15 @@
 #include <linux/regmap.h>
 #include "tsens.h"
 
+/*
+ * Zones polled within batch_ms of each other are served from a single bulk
+ * read of all Sn_STATUS registers instead of one MMIO read per sensor.
+ * 0 disables batching.
+ */
+static unsigned int batch_ms;
+module_param(batch_ms, uint, 0644);
+MODULE_PARM_DESC(batch_ms, "Max age in ms of a batched sensor status read");
+
 char *qfprom_read(struct device *dev, const char *cname)
 {
 	struct nvmem_cell *cell;
@@ -123,6 +133,60 @@ int get_temp_tsens_valid(struct tsens_priv *priv, int i, int *temp)
 	return 0;
 }
 
+static inline u32 tsens_field_get(u32 val, const struct reg_field *f)
+{
+	return (val & GENMASK(f->msb, f->lsb)) >> f->lsb;
+}
+
+/*
+ * Like get_temp_tsens_valid(), but for IPs whose Sn_STATUS registers are
+ * laid out back to back: refresh all of them at once when the cache is
+ * older than batch_ms and decode the sensor from the cached word.
+ */
+int get_temp_tsens_batched(struct tsens_priv *priv, int i, int *temp)
+{
+	struct tsens_sensor *s = &priv->sensor[i];
+	const struct reg_field *tf = &priv->fields[LAST_TEMP_0 + s->hw_id];
+	const struct reg_field *vf = &priv->fields[VALID_0 + s->hw_id];
+	unsigned int base = priv->fields[LAST_TEMP_0].reg;
+	unsigned int nr = priv->feat->max_sensors;
+	unsigned int ms = READ_ONCE(batch_ms);
+	u32 status, last_temp, mask;
+	int ret;
+
+	if (!ms || nr > ARRAY_SIZE(priv->status_cache))
+		return get_temp_tsens_valid(priv, i, temp);
+
+	mutex_lock(&priv->status_lock);
+	if (!priv->status_stamp ||
+	    time_after(jiffies, priv->status_stamp + msecs_to_jiffies(ms))) {
+		ret = regmap_bulk_read(priv->tm_map, base, priv->status_cache,
+				       nr);
+		if (ret) {
+			priv->status_stamp = 0;
+			mutex_unlock(&priv->status_lock);
+			return ret;
+		}
+		priv->status_stamp = jiffies;
+	}
+	status = priv->status_cache[(tf->reg - base) / 4];
+	mutex_unlock(&priv->status_lock);
+
+	/* Caught mid-update, let the unbatched path wait for it */
+	if (!tsens_field_get(status, vf))
+		return get_temp_tsens_valid(priv, i, temp);
+
+	last_temp = tsens_field_get(status, tf);
+	if (priv->feat->adc) {
+		*temp = code_to_degc(last_temp, s) * 1000;
+	} else {
+		mask = GENMASK(tf->msb, tf->lsb) >> tf->lsb;
+		*temp = sign_extend32(last_temp, fls(mask) - 1) * 100;
+	}
+
+	return 0;
+}
+
 int get_temp_common(struct tsens_priv *priv, int i, int *temp)
 {
 	struct tsens_sensor *s = &priv->sensor[i];
@@ -163,6 +227,8 @@ int __init init_common(struct tsens_priv *priv)
 	if (!op)
 		return -EINVAL;
 
+	mutex_init(&priv->status_lock);
+
 	if (op->num_resources > 1) {
 		/* DT with separate SROT and TM address space */
 		priv->tm_offset = 0;
@@ -65,7 +65,7 @@ static const struct reg_field tsens_v2_regfields[MAX_REGFIELDS] = {
 
 static const struct tsens_ops ops_generic_v2 = {
 	.init		= init_common,
-	.get_temp	= get_temp_tsens_valid,
+	.get_temp	= get_temp_tsens_batched,
 };
 
 const struct tsens_plat_data data_tsens_v2 = {
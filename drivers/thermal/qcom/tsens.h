@@ -295,6 +295,9 @@ struct tsens_context {
  * @feat: features of the IP
  * @fields: bitfield locations
  * @ops: pointer to list of callbacks supported by this device
+ * @status_lock: protects the status cache
+ * @status_stamp: jiffies when @status_cache was read
+ * @status_cache: Sn_STATUS of all sensors from the last batched read
  * @sensor: list of sensors attached to this device
  */
 struct tsens_priv {
@@ -308,6 +311,9 @@ struct tsens_priv {
 	const struct tsens_features	*feat;
 	const struct reg_field		*fields;
 	const struct tsens_ops		*ops;
+	struct mutex			status_lock;
+	unsigned long			status_stamp;
+	u32				status_cache[16];
 	struct tsens_sensor		sensor[0];
 };
 
@@ -315,6 +321,7 @@ char *qfprom_read(struct device *dev, const char *cname);
 void compute_intercept_slope(struct tsens_priv *priv, u32 *pt1, u32 *pt2, u32 mode);
 int init_common(struct tsens_priv *priv);
 int get_temp_tsens_valid(struct tsens_priv *priv, int i, int *temp);
+int get_temp_tsens_batched(struct tsens_priv *priv, int i, int *temp);
 int get_temp_common(struct tsens_priv *priv, int i, int *temp);
 
 /* TSENS target */
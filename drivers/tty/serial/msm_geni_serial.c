@@ -20,6 +20,7 @@
 #include <linux/msm-geni-se.h>
 #include <linux/serial.h>
 #include <linux/serial_core.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/tty.h>
 #include <linux/tty_flip.h>
@@ -149,7 +150,24 @@
 
 #define IPC_LOG_MSG(ctx, x...) ipc_log_string(ctx, x)
 #define DMA_RX_BUF_SIZE		(2048)
+#define DMA_RX_BUF_SIZE_MAX	(SZ_16K)
 #define UART_CONSOLE_RX_WM	(2)
+#define RX_DMA_HIST_BUCKETS	(16)
+
+/*
+ * Size of the RX DMA buffer and the RX stale window (in characters) used by
+ * the high speed ports. A larger buffer together with a longer stale window
+ * lets a burst at 3-4 Mbps land in one DMA completion instead of several,
+ * trading a little latency on the tail of the burst for fewer interrupts.
+ * Both take effect on the next port setup.
+ */
+static unsigned int rx_dma_buf_size = DMA_RX_BUF_SIZE;
+module_param(rx_dma_buf_size, uint, 0644);
+MODULE_PARM_DESC(rx_dma_buf_size, "RX DMA buffer size in bytes (max 16K)");
+
+static unsigned int rx_stale_chars = STALE_TIMEOUT;
+module_param(rx_stale_chars, uint, 0644);
+MODULE_PARM_DESC(rx_stale_chars, "RX stale timeout in characters");
 
 enum uart_error_code {
 	UART_ERROR_DEFAULT,
@@ -183,6 +201,14 @@ struct msm_geni_serial_ver_info {
 	int s_fw_ver;
 };
 
+struct msm_geni_serial_rx_stats {
+	u64 irqs;
+	u64 bytes;
+	u64 full;
+	u32 max_bytes;
+	u64 hist[RX_DMA_HIST_BUCKETS];
+};
+
 struct msm_geni_serial_port {
 	struct uart_port uport;
 	const char *name;
@@ -207,6 +233,8 @@ struct msm_geni_serial_port {
 	unsigned int xmit_size;
 	void *rx_buf;
 	dma_addr_t rx_dma;
+	unsigned int rx_buf_size;
+	struct msm_geni_serial_rx_stats rx_stats;
 	int loopback;
 	int wakeup_irq;
 	unsigned char wakeup_byte;
@@ -1482,8 +1510,8 @@ static void start_rx_sequencer(struct uart_port *uport)
 			IPC_LOG_MSG(port->ipc_log_misc,
 				"%s: mapping rx dma GENI: 0x%x\n",
 				__func__, geni_status);
-			geni_se_rx_dma_start(uport->membase, DMA_RX_BUF_SIZE,
-								&port->rx_dma);
+			geni_se_rx_dma_start(uport->membase,
+					port->rx_buf_size, &port->rx_dma);
 		}
 		msm_geni_serial_stop_rx(uport);
 	}
@@ -1491,7 +1519,7 @@ static void start_rx_sequencer(struct uart_port *uport)
 	if (port->xfer_mode == SE_DMA) {
 		IPC_LOG_MSG(port->ipc_log_misc,
 			"%s. mapping rx dma\n", __func__);
-		geni_se_rx_dma_start(uport->membase, DMA_RX_BUF_SIZE,
+		geni_se_rx_dma_start(uport->membase, port->rx_buf_size,
 							&port->rx_dma);
 	}
 
@@ -2096,6 +2124,23 @@ static bool handle_tx_dma_xfer(u32 m_irq_status, struct uart_port *uport)
 	return ret;
 }
 
+static void msm_geni_serial_rx_account(struct msm_geni_serial_port *port,
+				       int rx_bytes)
+{
+	struct msm_geni_serial_rx_stats *st = &port->rx_stats;
+
+	if (rx_bytes <= 0)
+		return;
+
+	st->irqs++;
+	st->bytes += rx_bytes;
+	if (rx_bytes >= port->rx_buf_size)
+		st->full++;
+	if (rx_bytes > st->max_bytes)
+		st->max_bytes = rx_bytes;
+	st->hist[min_t(int, ilog2(rx_bytes), RX_DMA_HIST_BUCKETS - 1)]++;
+}
+
 static bool handle_rx_dma_xfer(u32 s_irq_status, struct uart_port *uport)
 {
 	bool ret = false;
@@ -2103,6 +2148,7 @@ static bool handle_rx_dma_xfer(u32 s_irq_status, struct uart_port *uport)
 	struct msm_geni_serial_port *msm_port = GET_DEV_PORT(uport);
 	u32 dma_rx_status;
 	unsigned long lock_flags;
+	int rx_bytes;
 
 	spin_lock_irqsave(&msm_port->rx_lock, lock_flags);
 	dma_rx_status = geni_read_reg_nolog(uport->membase,
@@ -2140,13 +2186,14 @@ static bool handle_rx_dma_xfer(u32 s_irq_status, struct uart_port *uport)
 
 		if (dma_rx_status & RX_EOT ||
 				dma_rx_status & RX_DMA_DONE) {
-			msm_geni_serial_handle_dma_rx(uport,
+			rx_bytes = msm_geni_serial_handle_dma_rx(uport,
 						drop_rx);
+			msm_geni_serial_rx_account(msm_port, rx_bytes);
 			if (!(dma_rx_status & RX_GENI_CANCEL_IRQ)) {
 				IPC_LOG_MSG(msm_port->ipc_log_misc,
 				"%s. mapping rx dma\n", __func__);
 				geni_se_rx_dma_start(uport->membase,
-				DMA_RX_BUF_SIZE, &msm_port->rx_dma);
+				msm_port->rx_buf_size, &msm_port->rx_dma);
 			} else {
 				IPC_LOG_MSG(msm_port->ipc_log_misc,
 				"%s. not mapping rx dma\n",
@@ -2420,6 +2467,8 @@ static int msm_geni_serial_port_setup(struct uart_port *uport)
 	dma_addr_t dma_address;
 	unsigned int rxstale = STALE_COUNT;
 
+	if (!uart_console(uport) && rx_stale_chars)
+		rxstale = DEFAULT_BITS_PER_CHAR * rx_stale_chars;
 	set_rfr_wm(msm_port);
 	geni_write_reg_nolog(rxstale, uport->membase, SE_UART_RX_STALE_CNT);
 	if (!uart_console(uport)) {
@@ -2441,9 +2490,11 @@ static int msm_geni_serial_port_setup(struct uart_port *uport)
 			goto exit_portsetup;
 		}
 
+		msm_port->rx_buf_size = clamp_t(unsigned int, rx_dma_buf_size,
+						DMA_RX_BUF_SIZE, DMA_RX_BUF_SIZE_MAX);
 		msm_port->rx_buf =
 			geni_se_iommu_alloc_buf(msm_port->wrapper_dev,
-				&dma_address, DMA_RX_BUF_SIZE);
+				&dma_address, msm_port->rx_buf_size);
 		if (!msm_port->rx_buf) {
 			devm_kfree(uport->dev, msm_port->rx_fifo);
 			msm_port->rx_fifo = NULL;
@@ -2493,7 +2544,8 @@ static int msm_geni_serial_port_setup(struct uart_port *uport)
 free_dma:
 	if (msm_port->rx_dma) {
 		geni_se_iommu_free_buf(msm_port->wrapper_dev,
-			&msm_port->rx_dma, msm_port->rx_buf, DMA_RX_BUF_SIZE);
+			&msm_port->rx_dma, msm_port->rx_buf,
+			msm_port->rx_buf_size);
 		msm_port->rx_dma = (dma_addr_t)NULL;
 	}
 exit_portsetup:
@@ -2964,6 +3016,25 @@ static void console_unregister(struct uart_driver *drv)
 }
 #endif /* (CONFIG_SERIAL_MSM_GENI_CONSOLE) || defined(CONFIG_CONSOLE_POLL) */
 
+static int msm_geni_serial_rx_stats_show(struct seq_file *s, void *unused)
+{
+	struct msm_geni_serial_port *port = s->private;
+	struct msm_geni_serial_rx_stats *st = &port->rx_stats;
+	int i;
+
+	seq_printf(s, "buf_size: %u\n", port->rx_buf_size);
+	seq_printf(s, "irqs: %llu\nbytes: %llu\nfull: %llu\nmax_bytes: %u\n",
+		   st->irqs, st->bytes, st->full, st->max_bytes);
+	seq_printf(s, "avg_bytes: %llu\n",
+		   st->irqs ? div64_u64(st->bytes, st->irqs) : 0);
+	seq_puts(s, "bytes_per_irq:\n");
+	for (i = 0; i < RX_DMA_HIST_BUCKETS; i++)
+		if (st->hist[i])
+			seq_printf(s, "  >=%u: %llu\n", 1U << i, st->hist[i]);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(msm_geni_serial_rx_stats);
+
 static void msm_geni_serial_debug_init(struct uart_port *uport, bool console)
 {
 	struct msm_geni_serial_port *msm_port = GET_DEV_PORT(uport);
@@ -2974,6 +3045,10 @@ static void msm_geni_serial_debug_init(struct uart_port *uport, bool console)
 		dev_err(uport->dev, "Failed to create dbg dir\n");
 
 	if (!console) {
+		if (!IS_ERR_OR_NULL(msm_port->dbg))
+			debugfs_create_file("rx_stats", 0400, msm_port->dbg,
+					    msm_port,
+					    &msm_geni_serial_rx_stats_fops);
 		memset(name, 0, sizeof(name));
 		if (!msm_port->ipc_log_rx) {
 			scnprintf(name, sizeof(name), "%s%s",
@@ -3578,7 +3653,7 @@ static int msm_geni_serial_remove(struct platform_device *pdev)
 	uart_remove_one_port(drv, &port->uport);
 	if (port->rx_dma) {
 		geni_se_iommu_free_buf(port->wrapper_dev, &port->rx_dma,
-					port->rx_buf, DMA_RX_BUF_SIZE);
+					port->rx_buf, port->rx_buf_size);
 		port->rx_dma = (dma_addr_t)NULL;
 	}
 	return 0;
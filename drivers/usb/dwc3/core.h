@@ -712,6 +712,8 @@ struct dwc3_ep_events {
 	unsigned int	epcmdcomplete;
 	unsigned int	unknown_event;
 	unsigned int	total;
+	unsigned int	giveback;
+	unsigned int	max_giveback;
 };
 
 #define DWC3_EP_FLAG_STALLED	BIT(0)
@@ -1151,6 +1151,11 @@ static int dwc3_gadget_int_events_show(struct seq_file *s, void *unused)
 			dep->dbg_ep_events.total,
 			ep_event_rate(total, dep->dbg_ep_events,
 				dep->dbg_ep_events_diff, delta_ms));
+		seq_printf(s, "giveback:%u @ %lldHz (max %u per event)\n",
+			dep->dbg_ep_events.giveback,
+			ep_event_rate(giveback, dep->dbg_ep_events,
+				dep->dbg_ep_events_diff, delta_ms),
+			dep->dbg_ep_events.max_giveback);
 
 		dep->dbg_ep_events_kt = now;
 		dep->dbg_ep_events_diff = dep->dbg_ep_events;
@@ -1258,6 +1263,57 @@ static const struct file_operations dwc3_l1_enable_ops = {
 	.release	= single_release,
 };
 
+static ssize_t dwc3_imod_interval_store(struct file *file,
+	const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct dwc3	*dwc = s->private;
+	u16		 interval;
+	int		 ret;
+
+	ret = kstrtou16_from_user(ubuf, count, 0, &interval);
+	if (ret < 0) {
+		dev_err(dwc->dev, "%s: can't get entered value: %d\n",
+							__func__, ret);
+		return ret;
+	}
+
+	if (interval && !dwc3_has_imod(dwc))
+		return -EINVAL;
+
+	/* STAR 9000961433: 3.00a needs IMOD to keep the IRQ masked */
+	if (!interval && dwc->revision == DWC3_REVISION_300A)
+		return -EINVAL;
+
+	dwc->imod_interval = interval;
+
+	pr_info("dwc3 gadget imod interval: %u x 250ns. Perform a plugout/plugin\n",
+				interval);
+
+	return count;
+}
+
+static int dwc3_imod_interval_show(struct seq_file *s, void *unused)
+{
+	struct dwc3 *dwc = s->private;
+
+	seq_printf(s, "%u\n", dwc->imod_interval);
+	return 0;
+}
+
+static int dwc3_imod_interval_open(struct inode *inode, struct file *f)
+{
+	return single_open(f, dwc3_imod_interval_show, inode->i_private);
+}
+
+static const struct file_operations dwc3_imod_interval_ops = {
+	.open		= dwc3_imod_interval_open,
+	.write		= dwc3_imod_interval_store,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 void dwc3_debugfs_init(struct dwc3 *dwc)
 {
 	struct dentry		*root;
@@ -1305,6 +1361,9 @@ void dwc3_debugfs_init(struct dwc3 *dwc)
 				&dwc3_gadget_int_events_fops);
 		if (!file)
 			dev_dbg(dwc->dev, "Can't create debugfs int_events\n");
+
+		debugfs_create_file("imod_interval", 0644, root, dwc,
+				    &dwc3_imod_interval_ops);
 	}
 }
 
@@ -3371,6 +3371,7 @@ static void dwc3_gadget_ep_cleanup_completed_requests(struct dwc3_ep *dep,
 		const struct dwc3_event_depevt *event, int status)
 {
 	struct dwc3_request	*req;
+	unsigned int		count = 0;
 
 	while (!list_empty(&dep->started_list)) {
 		int ret;
@@ -3380,7 +3381,13 @@ static void dwc3_gadget_ep_cleanup_completed_requests(struct dwc3_ep *dep,
 				req, status);
 		if (ret)
 			break;
+		count++;
 	}
+
+	/* How many requests a single event retired, to tune IMOD against */
+	dep->dbg_ep_events.giveback += count;
+	if (count > dep->dbg_ep_events.max_giveback)
+		dep->dbg_ep_events.max_giveback = count;
 }
 
 static bool dwc3_gadget_ep_should_continue(struct dwc3_ep *dep)
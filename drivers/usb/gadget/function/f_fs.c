@@ -229,6 +229,16 @@ struct ffs_epfile {
 	struct ffs_buffer		*read_buffer;
 #define READ_BUFFER_DROP ((struct ffs_buffer *)ERR_PTR(-ESHUTDOWN))
 
+	/*
+	 * vmalloc()ed buffer reused by synchronous scatter-gather transfers
+	 * so that back to back reads and writes (adb, MTP) don't allocate and
+	 * map a fresh buffer each time.  Only the scatterlist describing it is
+	 * rebuilt per transfer.  Released on last close.  P: mutex
+	 */
+	void				*sg_buf;
+	size_t				sg_buf_len;
+#define FFS_SG_BUF_MAX	SZ_1M
+
 	char				name[5];
 
 	unsigned char			in;	/* P: ffs->eps_lock */
@@ -261,6 +271,7 @@ struct ffs_io_data {
 	struct usb_request *req;
 	struct sg_table sgt;
 	bool use_sg;
+	bool cached_buf;
 
 	struct ffs_data *ffs;
 };
@@ -837,38 +848,75 @@ static ssize_t ffs_copy_to_iter(void *data, int data_len, struct iov_iter *iter)
  * @sg_table	- pointer to a place to be filled with sg_table contents
  * @size	- required buffer size
  */
-static void *ffs_build_sg_list(struct sg_table *sgt, size_t sz)
+static int ffs_vmalloc_to_sg(struct sg_table *sgt, void *vaddr, size_t sz)
 {
 	struct page **pages;
-	void *vaddr, *ptr;
 	unsigned int n_pages;
-	int i;
-
-	vaddr = vmalloc(sz);
-	if (!vaddr)
-		return NULL;
+	void *ptr;
+	int i, ret;
 
 	n_pages = PAGE_ALIGN(sz) >> PAGE_SHIFT;
 	pages = kvmalloc_array(n_pages, sizeof(struct page *), GFP_KERNEL);
-	if (!pages) {
-		vfree(vaddr);
+	if (!pages)
+		return -ENOMEM;
 
-		return NULL;
-	}
 	for (i = 0, ptr = vaddr; i < n_pages; ++i, ptr += PAGE_SIZE)
 		pages[i] = vmalloc_to_page(ptr);
 
-	if (sg_alloc_table_from_pages(sgt, pages, n_pages, 0, sz, GFP_KERNEL)) {
-		kvfree(pages);
+	ret = sg_alloc_table_from_pages(sgt, pages, n_pages, 0, sz, GFP_KERNEL);
+	kvfree(pages);
+
+	return ret;
+}
+
+static void *ffs_build_sg_list(struct sg_table *sgt, size_t sz)
+{
+	void *vaddr;
+
+	vaddr = vmalloc(sz);
+	if (!vaddr)
+		return NULL;
+
+	if (ffs_vmalloc_to_sg(sgt, vaddr, sz)) {
 		vfree(vaddr);
 
 		return NULL;
 	}
-	kvfree(pages);
 
 	return vaddr;
 }
 
+/*
+ * Same as ffs_build_sg_list() but backed by the epfile's cached buffer,
+ * which is grown when needed.  Caller must hold epfile->mutex.
+ */
+static void *ffs_epfile_get_sg_buf(struct ffs_epfile *epfile,
+				   struct ffs_io_data *io_data, size_t sz)
+{
+	if (epfile->sg_buf_len < sz) {
+		vfree(epfile->sg_buf);
+		epfile->sg_buf_len = 0;
+		epfile->sg_buf = vmalloc(PAGE_ALIGN(sz));
+		if (!epfile->sg_buf)
+			return NULL;
+		epfile->sg_buf_len = PAGE_ALIGN(sz);
+	}
+
+	if (ffs_vmalloc_to_sg(&io_data->sgt, epfile->sg_buf, sz))
+		return NULL;
+
+	io_data->cached_buf = true;
+
+	return epfile->sg_buf;
+}
+
+static void ffs_epfile_put_sg_buf(struct ffs_epfile *epfile)
+{
+	vfree(epfile->sg_buf);
+	epfile->sg_buf = NULL;
+	epfile->sg_buf_len = 0;
+}
+
 static inline void *ffs_alloc_buffer(struct ffs_io_data *io_data,
 	size_t data_len)
 {
@@ -885,7 +933,8 @@ static inline void ffs_free_buffer(struct ffs_io_data *io_data)
 
 	if (io_data->use_sg) {
 		sg_free_table(&io_data->sgt);
-		vfree(io_data->buf);
+		if (!io_data->cached_buf)
+			vfree(io_data->buf);
 	} else {
 		kfree(io_data->buf);
 	}
@@ -1112,7 +1161,11 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 		io_data->use_sg = gadget->sg_supported && data_len > PAGE_SIZE;
 		spin_unlock_irq(&epfile->ffs->eps_lock);
 
-		data = ffs_alloc_buffer(io_data, data_len);
+		if (io_data->use_sg && !io_data->aio &&
+		    data_len <= FFS_SG_BUF_MAX)
+			data = ffs_epfile_get_sg_buf(epfile, io_data, data_len);
+		else
+			data = ffs_alloc_buffer(io_data, data_len);
 		if (unlikely(!data)) {
 			ret = -ENOMEM;
 			goto error_mutex;
@@ -1435,8 +1488,12 @@ ffs_epfile_release(struct inode *inode, struct file *file)
 		epfile->name, epfile->ffs->state, epfile->ffs->setup_state,
 		epfile->ffs->flags, atomic_read(&epfile->opened));
 
-	if (atomic_dec_and_test(&epfile->opened))
+	if (atomic_dec_and_test(&epfile->opened)) {
 		epfile->invalid = false;
+		mutex_lock(&epfile->mutex);
+		ffs_epfile_put_sg_buf(epfile);
+		mutex_unlock(&epfile->mutex);
+	}
 
 	ffs_data_closed(epfile->ffs);
 
@@ -2183,6 +2240,7 @@ static void ffs_epfiles_destroy(struct ffs_epfile *epfiles, unsigned count)
 
 	for (; count; --count, ++epfile) {
 		BUG_ON(mutex_is_locked(&epfile->mutex));
+		ffs_epfile_put_sg_buf(epfile);
 		if (epfile->dentry) {
 			d_delete(epfile->dentry);
 			dput(epfile->dentry);
@@ -17,6 +17,7 @@
 #include <linux/etherdevice.h>
 #include <linux/ethtool.h>
 #include <linux/if_vlan.h>
+#include <linux/scatterlist.h>
 
 #include "u_ether.h"
 
@@ -90,6 +91,9 @@ struct eth_dev {
 
 #define DEFAULT_QLEN	2	/* double buffering by default */
 
+/* linear head plus every page fragment of an skb */
+#define TX_SG_ENTRIES	(MAX_SKB_FRAGS + 1)
+
 /* for dual-speed hardware, use deeper queues at high/super speed */
 static inline int qlen(struct usb_gadget *gadget, unsigned qmult)
 {
@@ -343,6 +347,13 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 		rx_submit(dev, req, GFP_ATOMIC);
 }
 
+static void free_request(struct usb_ep *ep, struct usb_request *req)
+{
+	kfree(req->sg);
+	req->sg = NULL;
+	usb_ep_free_request(ep, req);
+}
+
 static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
 {
 	unsigned		i;
@@ -372,7 +383,7 @@ static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
 
 		next = req->list.next;
 		list_del(&req->list);
-		usb_ep_free_request(ep, req);
+		free_request(ep, req);
 
 		if (next == list)
 			break;
@@ -382,6 +393,23 @@ static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
 	return 0;
 }
 
+/*
+ * Give each TX request its own scatterlist so that paged skbs can be queued
+ * to the controller as they are. A request without one falls back to a
+ * linear copy, so an allocation failure here is not fatal.
+ */
+static void alloc_tx_sg(struct eth_dev *dev)
+{
+	struct usb_request	*req;
+
+	list_for_each_entry(req, &dev->tx_reqs, list) {
+		if (req->sg)
+			continue;
+		req->sg = kmalloc_array(TX_SG_ENTRIES, sizeof(*req->sg),
+					GFP_ATOMIC);
+	}
+}
+
 static int alloc_requests(struct eth_dev *dev, struct gether *link, unsigned n)
 {
 	int	status;
@@ -390,6 +418,8 @@ static int alloc_requests(struct eth_dev *dev, struct gether *link, unsigned n)
 	status = prealloc(&dev->tx_reqs, link->in_ep, n);
 	if (status < 0)
 		goto fail;
+	if (dev->gadget->sg_supported)
+		alloc_tx_sg(dev);
 	status = prealloc(&dev->rx_reqs, link->out_ep, n);
 	if (status < 0)
 		goto fail;
@@ -470,6 +500,16 @@ static inline int is_promisc(u16 cdc_filter)
 	return cdc_filter & USB_CDC_PACKET_TYPE_PROMISCUOUS;
 }
 
+/*
+ * A scatterlist can't carry the extra pad byte used in place of a ZLP, so
+ * such transfers still take the linear path.
+ */
+static inline bool tx_sg_ok(struct eth_dev *dev, struct usb_ep *in,
+			    struct sk_buff *skb)
+{
+	return dev->zlp || (skb->len % in->maxpacket) != 0;
+}
+
 static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 					struct net_device *net)
 {
@@ -538,6 +578,17 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		netif_stop_queue(net);
 	spin_unlock_irqrestore(&dev->req_lock, flags);
 
+	/* Paged skbs go out as a scatterlist when the request has one and
+	 * no framing wrapper needs to touch the payload; otherwise flatten.
+	 */
+	if (skb && skb_is_nonlinear(skb) &&
+	    (dev->wrap || !req->sg || !tx_sg_ok(dev, in, skb))) {
+		if (skb_linearize(skb)) {
+			dev_kfree_skb_any(skb);
+			goto drop;
+		}
+	}
+
 	/* no buffer copies needed, unless the network stack did it
 	 * or the hardware can't use skb buffers.
 	 * or there's not enough space for extra headers we need
@@ -564,6 +615,19 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 	req->buf = skb->data;
 	req->context = skb;
 	req->complete = tx_complete;
+	req->num_sgs = 0;
+
+	if (skb_is_nonlinear(skb)) {
+		int	nents;
+
+		sg_init_table(req->sg, skb_shinfo(skb)->nr_frags + 1);
+		nents = skb_to_sgvec(skb, req->sg, 0, skb->len);
+		if (nents < 0) {
+			dev_kfree_skb_any(skb);
+			goto drop;
+		}
+		req->num_sgs = nents;
+	}
 
 	/* NCM requires no zlp if transfer is dwNtbInMaxSize */
 	if (dev->port_usb &&
@@ -801,6 +865,11 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	SET_NETDEV_DEV(net, &g->dev);
 	SET_NETDEV_DEVTYPE(net, &gadget_type);
 
+	if (g->sg_supported) {
+		net->hw_features |= NETIF_F_SG;
+		net->features |= NETIF_F_SG;
+	}
+
 	status = register_netdev(net);
 	if (status < 0) {
 		dev_dbg(&g->dev, "register_netdev failed, %d\n", status);
@@ -879,6 +948,11 @@ int gether_register_netdev(struct net_device *net)
 
 	memcpy(net->dev_addr, dev->dev_mac, ETH_ALEN);
 
+	if (g->sg_supported) {
+		net->hw_features |= NETIF_F_SG;
+		net->features |= NETIF_F_SG;
+	}
+
 	status = register_netdev(net);
 	if (status < 0) {
 		dev_dbg(&g->dev, "register_netdev failed, %d\n", status);
@@ -1155,7 +1229,7 @@ void gether_disconnect(struct gether *link)
 		list_del(&req->list);
 
 		spin_unlock(&dev->req_lock);
-		usb_ep_free_request(link->in_ep, req);
+		free_request(link->in_ep, req);
 		spin_lock(&dev->req_lock);
 	}
 	spin_unlock(&dev->req_lock);
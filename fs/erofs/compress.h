@@ -56,5 +56,35 @@ static inline bool z_erofs_put_stagingpage(struct list_head *pagepool,
 int z_erofs_decompress(struct z_erofs_decompress_req *rq,
 		       struct list_head *pagepool);
 
+/* decompression accounting, exported through debugfs erofs/zip_stats */
+struct z_erofs_zip_stats {
+	atomic64_t pclusters;		/* pclusters decompressed */
+	atomic64_t inplace;		/* ... with in-place I/O pages */
+	atomic64_t inplace_copied;	/* in-place I/O needing an input copy */
+	atomic64_t pcpubuf;		/* decompressed via the per-CPU buffer */
+	atomic64_t bounce_pages;	/* bounce pages allocated for output */
+	atomic64_t decomp_ns;
+	atomic64_t decomp_max_ns;
+	atomic64_t async_jobs;		/* jobqueues handed to a worker */
+	atomic64_t pcpu_jobs;		/* ... of which on the completing CPU */
+	atomic64_t queue_ns;		/* bio completion to worker start */
+	atomic64_t queue_max_ns;
+};
+
+extern struct z_erofs_zip_stats z_erofs_stats;
+
+static inline void z_erofs_stats_max(atomic64_t *v, s64 val)
+{
+	s64 old = atomic64_read(v);
+
+	while (val > old) {
+		s64 cur = atomic64_cmpxchg(v, old, val);
+
+		if (cur == old)
+			break;
+		old = cur;
+	}
+}
+
 #endif
 
@@ -81,6 +81,7 @@ static int z_erofs_lz4_prepare_destpages(struct z_erofs_decompress_req *rq,
 			if (!victim)
 				return -ENOMEM;
 			victim->mapping = Z_EROFS_MAPPING_STAGING;
+			atomic64_inc(&z_erofs_stats.bounce_pages);
 		}
 		rq->out[i] = victim;
 	}
@@ -158,6 +159,7 @@ static int z_erofs_lz4_decompress(struct z_erofs_decompress_req *rq, u8 *out)
 			src = generic_copy_inplace_data(rq, src, inputmargin);
 			inputmargin = 0;
 			copied = true;
+			atomic64_inc(&z_erofs_stats.inplace_copied);
 		}
 	}
 
@@ -248,6 +250,7 @@ static int z_erofs_decompress_generic(struct z_erofs_decompress_req *rq,
 			return PTR_ERR(dst);
 
 		rq->inplace_io = false;
+		atomic64_inc(&z_erofs_stats.pcpubuf);
 		ret = alg->decompress(rq, dst);
 		if (!ret)
 			copy_from_pcpubuf(rq->out, dst, rq->pageofs_out,
@@ -7,6 +7,9 @@
 #include "zdata.h"
 #include "compress.h"
 #include <linux/prefetch.h>
+#include <linux/debugfs.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/erofs.h>
 
@@ -32,10 +35,54 @@ typedef tagptr1_t compressed_page_t;
 	tagptr_fold(compressed_page_t, page, 1)
 
 static struct workqueue_struct *z_erofs_workqueue __read_mostly;
+static struct workqueue_struct *z_erofs_pcpu_workqueue __read_mostly;
 static struct kmem_cache *pcluster_cachep __read_mostly;
+static struct dentry *z_erofs_debugfs;
+
+struct z_erofs_zip_stats z_erofs_stats;
+
+/*
+ * Decompress asynchronous jobqueues on a high priority worker bound to the
+ * CPU that completed the last bio instead of the unbound pool, so that the
+ * pclusters are decompressed while the compressed data is still cache hot
+ * and without waiting for an unbound worker to be scheduled.
+ */
+static bool pcpu_decompress;
+module_param(pcpu_decompress, bool, 0644);
+MODULE_PARM_DESC(pcpu_decompress,
+		 "Decompress on a per-CPU high priority worker of the completing CPU");
+
+static int z_erofs_stats_show(struct seq_file *m, void *unused)
+{
+	struct z_erofs_zip_stats *st = &z_erofs_stats;
+	s64 pclusters = atomic64_read(&st->pclusters);
+	s64 jobs = atomic64_read(&st->async_jobs);
+
+	seq_printf(m, "pclusters: %lld\n", pclusters);
+	seq_printf(m, "inplace: %lld\n", atomic64_read(&st->inplace));
+	seq_printf(m, "inplace_copied: %lld\n",
+		   atomic64_read(&st->inplace_copied));
+	seq_printf(m, "pcpubuf: %lld\n", atomic64_read(&st->pcpubuf));
+	seq_printf(m, "bounce_pages: %lld\n",
+		   atomic64_read(&st->bounce_pages));
+	seq_printf(m, "decomp_avg_ns: %lld\n", pclusters ?
+		   div64_s64(atomic64_read(&st->decomp_ns), pclusters) : 0);
+	seq_printf(m, "decomp_max_ns: %lld\n",
+		   atomic64_read(&st->decomp_max_ns));
+	seq_printf(m, "async_jobs: %lld\n", jobs);
+	seq_printf(m, "pcpu_jobs: %lld\n", atomic64_read(&st->pcpu_jobs));
+	seq_printf(m, "queue_avg_ns: %lld\n", jobs ?
+		   div64_s64(atomic64_read(&st->queue_ns), jobs) : 0);
+	seq_printf(m, "queue_max_ns: %lld\n",
+		   atomic64_read(&st->queue_max_ns));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(z_erofs_stats);
 
 void z_erofs_exit_zip_subsystem(void)
 {
+	debugfs_remove_recursive(z_erofs_debugfs);
+	destroy_workqueue(z_erofs_pcpu_workqueue);
 	destroy_workqueue(z_erofs_workqueue);
 	kmem_cache_destroy(pcluster_cachep);
 }
@@ -51,7 +98,17 @@ static inline int z_erofs_init_workqueue(void)
 	 */
 	z_erofs_workqueue = alloc_workqueue("erofs_unzipd", flags,
 					    onlinecpus + onlinecpus / 4);
-	return z_erofs_workqueue ? 0 : -ENOMEM;
+	if (!z_erofs_workqueue)
+		return -ENOMEM;
+
+	z_erofs_pcpu_workqueue = alloc_workqueue("erofs_unzipd_pcpu",
+						 WQ_HIGHPRI | WQ_CPU_INTENSIVE,
+						 0);
+	if (!z_erofs_pcpu_workqueue) {
+		destroy_workqueue(z_erofs_workqueue);
+		return -ENOMEM;
+	}
+	return 0;
 }
 
 static void z_erofs_pcluster_init_once(void *ptr)
@@ -84,8 +141,12 @@ int __init z_erofs_init_zip_subsystem(void)
 					    SLAB_RECLAIM_ACCOUNT,
 					    z_erofs_pcluster_init_once);
 	if (pcluster_cachep) {
-		if (!z_erofs_init_workqueue())
+		if (!z_erofs_init_workqueue()) {
+			z_erofs_debugfs = debugfs_create_dir("erofs", NULL);
+			debugfs_create_file("zip_stats", 0444, z_erofs_debugfs,
+					    NULL, &z_erofs_stats_fops);
 			return 0;
+		}
 
 		kmem_cache_destroy(pcluster_cachep);
 	}
@@ -697,6 +758,23 @@ static int z_erofs_do_read_page(struct z_erofs_decompress_frontend *fe,
 	goto out;
 }
 
+static void z_erofs_queue_unzip(struct z_erofs_unzip_io *io)
+{
+	struct z_erofs_unzip_io_sb *iosb =
+		container_of(io, struct z_erofs_unzip_io_sb, io);
+
+	iosb->queued_ns = ktime_get_ns();
+	atomic64_inc(&z_erofs_stats.async_jobs);
+
+	if (READ_ONCE(pcpu_decompress)) {
+		atomic64_inc(&z_erofs_stats.pcpu_jobs);
+		queue_work_on(raw_smp_processor_id(), z_erofs_pcpu_workqueue,
+			      &io->u.work);
+		return;
+	}
+	queue_work(z_erofs_workqueue, &io->u.work);
+}
+
 static void z_erofs_vle_unzip_kickoff(void *ptr, int bios)
 {
 	tagptr1_t t = tagptr_init(tagptr1_t, ptr);
@@ -714,7 +792,7 @@ static void z_erofs_vle_unzip_kickoff(void *ptr, int bios)
 	}
 
 	if (!atomic_add_return(bios, &io->pending_bios))
-		queue_work(z_erofs_workqueue, &io->u.work);
+		z_erofs_queue_unzip(io);
 }
 
 static inline void z_erofs_vle_read_endio(struct bio *bio)
@@ -765,6 +843,7 @@ static int z_erofs_decompress_pcluster(struct super_block *sb,
 	enum z_erofs_page_type page_type;
 	bool overlapped, partial;
 	struct z_erofs_collection *cl;
+	u64 start, delta;
 	int err;
 
 	might_sleep();
@@ -891,6 +970,7 @@ static int z_erofs_decompress_pcluster(struct super_block *sb,
 		partial = true;
 	}
 
+	start = ktime_get_ns();
 	err = z_erofs_decompress(&(struct z_erofs_decompress_req) {
 					.sb = sb,
 					.in = compressed_pages,
@@ -903,6 +983,13 @@ static int z_erofs_decompress_pcluster(struct super_block *sb,
 					.partial_decoding = partial
 				 }, pagepool);
 
+	delta = ktime_get_ns() - start;
+	atomic64_inc(&z_erofs_stats.pclusters);
+	if (overlapped)
+		atomic64_inc(&z_erofs_stats.inplace);
+	atomic64_add(delta, &z_erofs_stats.decomp_ns);
+	z_erofs_stats_max(&z_erofs_stats.decomp_max_ns, delta);
+
 out:
 	/* must handle all compressed pages before endding pages */
 	for (i = 0; i < clusterpages; ++i) {
@@ -978,8 +1065,12 @@ static void z_erofs_vle_unzip_wq(struct work_struct *work)
 {
 	struct z_erofs_unzip_io_sb *iosb =
 		container_of(work, struct z_erofs_unzip_io_sb, io.u.work);
+	u64 delay = ktime_get_ns() - iosb->queued_ns;
 	LIST_HEAD(pagepool);
 
+	atomic64_add(delay, &z_erofs_stats.queue_ns);
+	z_erofs_stats_max(&z_erofs_stats.queue_max_ns, delay);
+
 	DBG_BUGON(iosb->io.head == Z_EROFS_PCLUSTER_TAIL_CLOSED);
 	z_erofs_vle_unzip_all(iosb->sb, &iosb->io, &pagepool);
 
@@ -97,6 +97,7 @@ struct z_erofs_unzip_io {
 struct z_erofs_unzip_io_sb {
 	struct z_erofs_unzip_io io;
 	struct super_block *sb;
+	u64 queued_ns;
 };
 
 #define MNGD_MAPPING(sbi)	((sbi)->managed_cache->i_mapping)
@@ -655,24 +655,15 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	return ret;
 }
 
-void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity)
+static void f2fs_decompress_cluster(struct decompress_io_ctx *dic, bool verity)
 {
-	struct decompress_io_ctx *dic =
-			(struct decompress_io_ctx *)page_private(page);
 	struct f2fs_sb_info *sbi = F2FS_I_SB(dic->inode);
 	struct f2fs_inode_info *fi= F2FS_I(dic->inode);
 	const struct f2fs_compress_ops *cops =
 			f2fs_cops[fi->i_compress_algorithm];
+	ktime_t start = ktime_get();
 	int ret;
 
-	dec_page_count(sbi, F2FS_RD_DATA);
-
-	if (bio->bi_status || PageError(page))
-		dic->failed = true;
-
-	if (refcount_dec_not_one(&dic->ref))
-		return;
-
 	trace_f2fs_decompress_pages_start(dic->inode, dic->cluster_idx,
 				dic->cluster_size, fi->i_compress_algorithm);
 
@@ -726,10 +717,87 @@ void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity)
 
 	trace_f2fs_decompress_pages_end(dic->inode, dic->cluster_idx,
 							dic->clen, ret);
+	atomic64_inc(&sbi->decomp_clusters);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), start)),
+						&sbi->decomp_time_ns);
 	if (!verity)
 		f2fs_free_dic(dic);
 }
 
+/*
+ * Drop one compressed page of a cluster. Once the last one has arrived the
+ * cluster is either decompressed right away or, if @ready is given, queued
+ * on it so the caller can batch all clusters completed by the same bio.
+ */
+void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity,
+						struct list_head *ready)
+{
+	struct decompress_io_ctx *dic =
+			(struct decompress_io_ctx *)page_private(page);
+
+	dec_page_count(F2FS_I_SB(dic->inode), F2FS_RD_DATA);
+
+	if (bio->bi_status || PageError(page))
+		dic->failed = true;
+
+	if (refcount_dec_not_one(&dic->ref))
+		return;
+
+	if (ready) {
+		list_add_tail(&dic->list, ready);
+		return;
+	}
+	f2fs_decompress_cluster(dic, verity);
+}
+
+static void f2fs_decompress_cluster_work(struct work_struct *work)
+{
+	struct decompress_io_ctx *dic =
+		container_of(work, struct decompress_io_ctx, work);
+
+	f2fs_decompress_cluster(dic, false);
+}
+
+/*
+ * A small read only completes a cluster or two, so decompress it here and
+ * avoid another worker hop. Readahead completes many clusters at once: keep
+ * the first decompress_batch of them on this CPU and spread the rest over
+ * the other online CPUs in batches of the same size, so a large compressed
+ * read is not bound by a single core.
+ */
+void f2fs_decompress_clusters(struct list_head *ready)
+{
+	struct decompress_io_ctx *dic, *tmp;
+	struct f2fs_sb_info *sbi;
+	unsigned int batch, nr = 0;
+	int cpu = raw_smp_processor_id();
+
+	dic = list_first_entry(ready, struct decompress_io_ctx, list);
+	sbi = F2FS_I_SB(dic->inode);
+	batch = READ_ONCE(sbi->decompress_batch);
+
+	if (sbi->decompress_wq && batch) {
+		list_for_each_entry_safe(dic, tmp, ready, list) {
+			if (nr++ < batch)
+				continue;
+			if ((nr - 1) % batch == 0) {
+				cpu = cpumask_next(cpu, cpu_online_mask);
+				if (cpu >= nr_cpu_ids)
+					cpu = cpumask_first(cpu_online_mask);
+			}
+			list_del(&dic->list);
+			INIT_WORK(&dic->work, f2fs_decompress_cluster_work);
+			queue_work_on(cpu, sbi->decompress_wq, &dic->work);
+			atomic64_inc(&sbi->decomp_offloaded);
+		}
+	}
+
+	list_for_each_entry_safe(dic, tmp, ready, list) {
+		list_del(&dic->list);
+		f2fs_decompress_cluster(dic, false);
+	}
+}
+
 static bool is_page_in_cluster(struct compress_ctx *cc, pgoff_t index)
 {
 	if (cc->cluster_idx == NULL_CLUSTER)
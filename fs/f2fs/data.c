@@ -132,13 +132,18 @@ static void __read_end_io(struct bio *bio, bool compr, bool verity)
 	struct page *page;
 	struct bio_vec *bv;
 	struct bvec_iter_all iter_all;
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	LIST_HEAD(ready);
+#endif
 
 	bio_for_each_segment_all(bv, bio, iter_all) {
 		page = bv->bv_page;
 
 #ifdef CONFIG_F2FS_FS_COMPRESSION
 		if (compr && f2fs_is_compressed_page(page)) {
-			f2fs_decompress_pages(bio, page, verity);
+			/* verity needs every cluster decompressed in place */
+			f2fs_decompress_pages(bio, page, verity,
+						verity ? NULL : &ready);
 			continue;
 		}
 		if (verity)
@@ -156,6 +161,10 @@ static void __read_end_io(struct bio *bio, bool compr, bool verity)
 		dec_page_count(F2FS_P_SB(page), __read_io_type(page));
 		unlock_page(page);
 	}
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	if (!list_empty(&ready))
+		f2fs_decompress_clusters(&ready);
+#endif
 }
 
 static void f2fs_release_read_bio(struct bio *bio);
@@ -2217,6 +2226,8 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 				SetPageUptodate(page);
 		} else if (!PageUptodate(page)) {
 			continue;
+		} else {
+			atomic64_inc(&sbi->decomp_cache_hits);
 		}
 		unlock_page(page);
 		cc->rpages[i] = NULL;
@@ -4126,11 +4137,29 @@ int f2fs_init_post_read_wq(struct f2fs_sb_info *sbi)
 						 num_online_cpus());
 	if (!sbi->post_read_wq)
 		return -ENOMEM;
+
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	sbi->decompress_batch = DEF_DECOMPRESS_BATCH;
+	if (f2fs_sb_has_compression(sbi)) {
+		/* per-cpu, so readahead clusters can be spread over cores */
+		sbi->decompress_wq = alloc_workqueue("f2fs_decompress_wq",
+							WQ_HIGHPRI, 0);
+		if (!sbi->decompress_wq) {
+			destroy_workqueue(sbi->post_read_wq);
+			sbi->post_read_wq = NULL;
+			return -ENOMEM;
+		}
+	}
+#endif
 	return 0;
 }
 
 void f2fs_destroy_post_read_wq(struct f2fs_sb_info *sbi)
 {
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	if (sbi->decompress_wq)
+		destroy_workqueue(sbi->decompress_wq);
+#endif
 	if (sbi->post_read_wq)
 		destroy_workqueue(sbi->post_read_wq);
 }
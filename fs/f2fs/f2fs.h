@@ -1406,12 +1406,15 @@ struct decompress_io_ctx {
 	bool failed;			/* indicate IO error during decompression */
 	void *private;			/* payload buffer for specified decompression algorithm */
 	void *private2;			/* extra payload buffer */
+	struct list_head list;		/* clusters ready in one read bio */
+	struct work_struct work;	/* offloaded decompression */
 };
 
 #define NULL_CLUSTER			((unsigned int)(~0))
 #define MIN_COMPRESS_LOG_SIZE		2
 #define MAX_COMPRESS_LOG_SIZE		8
 #define MAX_COMPRESS_WINDOW_SIZE	((PAGE_SIZE) << MAX_COMPRESS_LOG_SIZE)
+#define DEF_DECOMPRESS_BATCH		4	/* clusters per decompress worker */
 
 struct f2fs_sb_info {
 	struct super_block *sb;			/* pointer to VFS super block */
@@ -1535,6 +1538,11 @@ struct f2fs_sb_info {
 	unsigned int atomic_files;              /* # of opened atomic file */
 	unsigned long long skipped_atomic_files[2];	/* FG_GC and BG_GC */
 	unsigned long long skipped_gc_rwsem;		/* FG_GC only */
+	/* cost of victim migration, FG_GC and BG_GC */
+	unsigned long long gc_segs[2];		/* # of segments freed */
+	unsigned long long gc_blks[2];		/* # of valid blocks moved */
+	unsigned long long gc_time_ns[2];	/* time spent migrating */
+	unsigned long long gc_wb_skipped;	/* BG_GC held off by write buffer */
 
 	/* threshold for gc trials on pinned files */
 	u64 gc_pin_file_threshold;
@@ -1609,6 +1617,14 @@ struct f2fs_sb_info {
 	__u32 s_chksum_seed;
 
 	struct workqueue_struct *post_read_wq;	/* post read workqueue */
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	struct workqueue_struct *decompress_wq;	/* per-cpu decompress workqueue */
+	unsigned int decompress_batch;		/* clusters per worker, 0: inline */
+	atomic64_t decomp_clusters;		/* # of decompressed clusters */
+	atomic64_t decomp_offloaded;		/* # of clusters moved to other CPUs */
+	atomic64_t decomp_time_ns;		/* time spent decompressing */
+	atomic64_t decomp_cache_hits;		/* # of cluster pages already uptodate */
+#endif
 
 	struct kmem_cache *inline_xattr_slab;	/* inline xattr entry */
 	unsigned int inline_xattr_slab_size;	/* default inline xattr slab size */
@@ -3905,7 +3921,9 @@ void f2fs_compress_write_end_io(struct bio *bio, struct page *page);
 bool f2fs_is_compress_backend_ready(struct inode *inode);
 int f2fs_init_compress_mempool(void);
 void f2fs_destroy_compress_mempool(void);
-void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity);
+void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity,
+						struct list_head *ready);
+void f2fs_decompress_clusters(struct list_head *ready);
 bool f2fs_cluster_is_empty(struct compress_ctx *cc);
 bool f2fs_cluster_can_merge_page(struct compress_ctx *cc, pgoff_t index);
 void f2fs_compress_ctx_add_page(struct compress_ctx *cc, struct page *page);
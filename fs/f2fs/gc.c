@@ -14,6 +14,7 @@
 #include <linux/delay.h>
 #include <linux/freezer.h>
 #include <linux/sched/signal.h>
+#include <linux/blk-mq.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -21,6 +22,34 @@
 #include "gc.h"
 #include <trace/events/f2fs.h>
 
+/*
+ * Background GC should only use the device when nothing else is queued on
+ * it, and should stay off a nearly full write buffer: migrated blocks would
+ * otherwise push foreground writes out to the slower native cells.
+ */
+static bool f2fs_gc_device_idle(struct f2fs_sb_info *sbi)
+{
+	struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
+	int ndevs = f2fs_is_multi_device(sbi) ? sbi->s_ndevs : 1;
+	int i;
+
+	for (i = 0; i < ndevs; i++) {
+		struct block_device *bdev = f2fs_is_multi_device(sbi) ?
+						FDEV(i).bdev : sbi->sb->s_bdev;
+		struct request_queue *q = bdev_get_queue(bdev);
+
+		if (queue_is_mq(q) && blk_mq_queue_inflight(q))
+			return false;
+
+		if (gc_th->wb_full_pct && READ_ONCE(q->wbuf_enabled) &&
+		    READ_ONCE(q->wbuf_fill_pct) >= gc_th->wb_full_pct) {
+			sbi->gc_wb_skipped++;
+			return false;
+		}
+	}
+	return true;
+}
+
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -90,7 +119,7 @@ static int gc_thread_func(void *data)
 			goto next;
 		}
 
-		if (!is_idle(sbi, GC_TIME)) {
+		if (!is_idle(sbi, GC_TIME) || !f2fs_gc_device_idle(sbi)) {
 			increase_sleep_time(gc_th, &wait_ms);
 			up_write(&sbi->gc_lock);
 			stat_io_skip_bggc_count(sbi);
@@ -138,6 +167,7 @@ int f2fs_start_gc_thread(struct f2fs_sb_info *sbi)
 	gc_th->min_sleep_time = DEF_GC_THREAD_MIN_SLEEP_TIME;
 	gc_th->max_sleep_time = DEF_GC_THREAD_MAX_SLEEP_TIME;
 	gc_th->no_gc_sleep_time = DEF_GC_THREAD_NOGC_SLEEP_TIME;
+	gc_th->wb_full_pct = DEF_GC_THREAD_WB_FULL_PCT;
 
 	gc_th->gc_wake= 0;
 
@@ -1304,6 +1334,8 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync,
 	unsigned long long last_skipped = sbi->skipped_atomic_files[FG_GC];
 	unsigned long long first_skipped;
 	unsigned int skipped_round = 0, round = 0;
+	unsigned int gc_blks;
+	ktime_t gc_start;
 
 	trace_f2fs_gc_begin(sbi->sb, sync, background,
 				get_pages(sbi, F2FS_DIRTY_NODES),
@@ -1353,7 +1385,12 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync,
 		goto stop;
 	}
 
+	gc_start = ktime_get();
+	gc_blks = get_valid_blocks(sbi, segno, true);
 	seg_freed = do_garbage_collect(sbi, segno, &gc_list, gc_type);
+	sbi->gc_segs[gc_type] += seg_freed;
+	sbi->gc_blks[gc_type] += gc_blks;
+	sbi->gc_time_ns[gc_type] += ktime_to_ns(ktime_sub(ktime_get(), gc_start));
 	if (gc_type == FG_GC && seg_freed == sbi->segs_per_sec)
 		sec_freed++;
 	total_freed += seg_freed;
@@ -197,6 +197,38 @@ static ssize_t mounted_time_sec_show(struct f2fs_attr *a,
 	return sprintf(buf, "%llu", SIT_I(sbi)->mounted_time);
 }
 
+static ssize_t gc_cost_show(struct f2fs_attr *a,
+		struct f2fs_sb_info *sbi, char *buf)
+{
+	int len = 0, type;
+
+	for (type = BG_GC; type <= FG_GC; type++) {
+		unsigned long long segs = sbi->gc_segs[type];
+
+		len += sprintf(buf + len, "%s: segs %llu blocks %llu us_per_seg %llu\n",
+			type == FG_GC ? "fg" : "bg", segs, sbi->gc_blks[type],
+			segs ? div64_u64(sbi->gc_time_ns[type],
+					segs * NSEC_PER_USEC) : 0);
+	}
+	len += sprintf(buf + len, "wb_skipped: %llu\n", sbi->gc_wb_skipped);
+	return len;
+}
+
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+static ssize_t decompress_stats_show(struct f2fs_attr *a,
+		struct f2fs_sb_info *sbi, char *buf)
+{
+	u64 clusters = atomic64_read(&sbi->decomp_clusters);
+
+	return sprintf(buf, "clusters %llu offloaded %llu us_per_cluster %llu "
+			"cache_hits %llu\n", clusters,
+			atomic64_read(&sbi->decomp_offloaded),
+			clusters ? div64_u64(atomic64_read(&sbi->decomp_time_ns),
+					clusters * NSEC_PER_USEC) : 0,
+			atomic64_read(&sbi->decomp_cache_hits));
+}
+#endif
+
 #ifdef CONFIG_F2FS_STAT_FS
 static ssize_t moved_blocks_foreground_show(struct f2fs_attr *a,
 				struct f2fs_sb_info *sbi, char *buf)
@@ -356,6 +388,9 @@ static ssize_t __sbi_store(struct f2fs_attr *a,
 	if (!strcmp(a->attr.name, "trim_sections"))
 		return -EINVAL;
 
+	if (!strcmp(a->attr.name, "gc_wb_full_pct") && t > 100)
+		return -EINVAL;
+
 	if (!strcmp(a->attr.name, "gc_urgent")) {
 		if (t >= 1) {
 			sbi->gc_mode = GC_URGENT;
@@ -528,6 +563,7 @@ static struct f2fs_attr f2fs_attr_##_name = {			\
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_urgent_sleep_time,
 							urgent_sleep_time);
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_min_sleep_time, min_sleep_time);
+F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_wb_full_pct, wb_full_pct);
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_max_sleep_time, max_sleep_time);
 F2FS_RW_ATTR(GC_THREAD, f2fs_gc_kthread, gc_no_gc_sleep_time, no_gc_sleep_time);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, gc_idle, gc_mode);
@@ -576,6 +612,11 @@ F2FS_GENERAL_RO_ATTR(current_reserved_blocks);
 F2FS_GENERAL_RO_ATTR(unusable);
 F2FS_GENERAL_RO_ATTR(encoding);
 F2FS_GENERAL_RO_ATTR(mounted_time_sec);
+F2FS_GENERAL_RO_ATTR(gc_cost);
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, decompress_batch, decompress_batch);
+F2FS_GENERAL_RO_ATTR(decompress_stats);
+#endif
 #ifdef CONFIG_F2FS_STAT_FS
 F2FS_STAT_ATTR(STAT_INFO, f2fs_stat_info, cp_foreground_calls, cp_count);
 F2FS_STAT_ATTR(STAT_INFO, f2fs_stat_info, cp_background_calls, bg_cp_count);
@@ -622,6 +663,7 @@ static struct attribute *f2fs_attrs[] = {
 	ATTR_LIST(gc_min_sleep_time),
 	ATTR_LIST(gc_max_sleep_time),
 	ATTR_LIST(gc_no_gc_sleep_time),
+	ATTR_LIST(gc_wb_full_pct),
 	ATTR_LIST(gc_idle),
 	ATTR_LIST(gc_urgent),
 	ATTR_LIST(reclaim_segments),
@@ -666,6 +708,11 @@ static struct attribute *f2fs_attrs[] = {
 	ATTR_LIST(current_reserved_blocks),
 	ATTR_LIST(encoding),
 	ATTR_LIST(mounted_time_sec),
+	ATTR_LIST(gc_cost),
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	ATTR_LIST(decompress_batch),
+	ATTR_LIST(decompress_stats),
+#endif
 #ifdef CONFIG_F2FS_STAT_FS
 	ATTR_LIST(cp_foreground_calls),
 	ATTR_LIST(cp_background_calls),
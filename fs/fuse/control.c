@@ -191,6 +191,34 @@ static ssize_t fuse_conn_congestion_threshold_write(struct file *file,
 	return ret;
 }
 
+static ssize_t fuse_conn_passthrough_read(struct file *file, char __user *buf,
+					  size_t len, loff_t *ppos)
+{
+	struct fuse_passthrough_stats *st;
+	struct fuse_conn *fc;
+	char tmp[256];
+	size_t size;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	st = &fc->passthrough_stats;
+	size = scnprintf(tmp, sizeof(tmp),
+			 "read_bytes %lld\nwrite_bytes %lld\nmmaps %lld\n"
+			 "fadvise %lld\ndaemon_read_bytes %lld\n"
+			 "daemon_write_bytes %lld\n",
+			 atomic64_read(&st->read_bytes),
+			 atomic64_read(&st->write_bytes),
+			 atomic64_read(&st->mmaps),
+			 atomic64_read(&st->fadvise),
+			 atomic64_read(&st->daemon_read_bytes),
+			 atomic64_read(&st->daemon_write_bytes));
+	fuse_conn_put(fc);
+
+	return simple_read_from_buffer(buf, len, ppos, tmp, size);
+}
+
 static const struct file_operations fuse_ctl_abort_ops = {
 	.open = nonseekable_open,
 	.write = fuse_conn_abort_write,
@@ -203,6 +231,12 @@ static const struct file_operations fuse_ctl_waiting_ops = {
 	.llseek = no_llseek,
 };
 
+static const struct file_operations fuse_ctl_passthrough_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_passthrough_read,
+	.llseek = no_llseek,
+};
+
 static const struct file_operations fuse_conn_max_background_ops = {
 	.open = nonseekable_open,
 	.read = fuse_conn_max_background_read,
@@ -285,7 +319,9 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 1, NULL, &fuse_conn_max_background_ops) ||
 	    !fuse_ctl_add_dentry(parent, fc, "congestion_threshold",
 				 S_IFREG | 0600, 1, NULL,
-				 &fuse_conn_congestion_threshold_ops))
+				 &fuse_conn_congestion_threshold_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "passthrough", S_IFREG | 0400, 1,
+				 NULL, &fuse_ctl_passthrough_ops))
 		goto err;
 
 	return 0;
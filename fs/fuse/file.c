@@ -1594,6 +1594,7 @@ static ssize_t fuse_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
 	struct file *file = iocb->ki_filp;
 	struct fuse_file *ff = file->private_data;
+	ssize_t ret;
 
 	if (fuse_is_bad(file_inode(file)))
 		return -EIO;
@@ -1601,15 +1602,21 @@ static ssize_t fuse_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	if (ff->passthrough.filp)
 		return fuse_passthrough_read_iter(iocb, to);
 	else if (!(ff->open_flags & FOPEN_DIRECT_IO))
-		return fuse_cache_read_iter(iocb, to);
+		ret = fuse_cache_read_iter(iocb, to);
 	else
-		return fuse_direct_read_iter(iocb, to);
+		ret = fuse_direct_read_iter(iocb, to);
+
+	if (ret > 0)
+		atomic64_add(ret, &ff->fc->passthrough_stats.daemon_read_bytes);
+
+	return ret;
 }
 
 static ssize_t fuse_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 {
 	struct file *file = iocb->ki_filp;
 	struct fuse_file *ff = file->private_data;
+	ssize_t ret;
 
 	if (fuse_is_bad(file_inode(file)))
 		return -EIO;
@@ -1617,9 +1624,25 @@ static ssize_t fuse_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	if (ff->passthrough.filp)
 		return fuse_passthrough_write_iter(iocb, from);
 	else if (!(ff->open_flags & FOPEN_DIRECT_IO))
-		return fuse_cache_write_iter(iocb, from);
+		ret = fuse_cache_write_iter(iocb, from);
 	else
-		return fuse_direct_write_iter(iocb, from);
+		ret = fuse_direct_write_iter(iocb, from);
+
+	if (ret > 0)
+		atomic64_add(ret, &ff->fc->passthrough_stats.daemon_write_bytes);
+
+	return ret;
+}
+
+static int fuse_file_fadvise(struct file *file, loff_t offset, loff_t len,
+			     int advice)
+{
+	struct fuse_file *ff = file->private_data;
+
+	if (ff->passthrough.filp)
+		return fuse_passthrough_fadvise(file, offset, len, advice);
+
+	return generic_fadvise(file, offset, len, advice);
 }
 
 static void fuse_writepage_free(struct fuse_writepage_args *wpa)
@@ -3426,6 +3449,7 @@ static const struct file_operations fuse_file_operations = {
 	.poll		= fuse_file_poll,
 	.fallocate	= fuse_file_fallocate,
 	.copy_file_range = fuse_copy_file_range,
+	.fadvise	= fuse_file_fadvise,
 };
 
 static const struct address_space_operations fuse_file_aops  = {
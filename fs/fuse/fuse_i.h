@@ -45,7 +45,7 @@
 #define FUSE_NAME_MAX 1024
 
 /** Number of dentries for each connection in the control filesystem */
-#define FUSE_CTL_NUM_DENTRIES 5
+#define FUSE_CTL_NUM_DENTRIES 6
 
 /** List of active connections */
 extern struct list_head fuse_conn_list;
@@ -176,6 +176,19 @@ struct fuse_passthrough {
 	struct cred *cred;
 };
 
+/**
+ * Per-connection accounting of I/O served from the lower filesystem in
+ * passthrough mode versus I/O that went through the daemon.
+ */
+struct fuse_passthrough_stats {
+	atomic64_t read_bytes;
+	atomic64_t write_bytes;
+	atomic64_t mmaps;
+	atomic64_t fadvise;
+	atomic64_t daemon_read_bytes;
+	atomic64_t daemon_write_bytes;
+};
+
 /** FUSE specific file data */
 struct fuse_file {
 	/** Fuse connection for this file */
@@ -784,6 +797,9 @@ struct fuse_conn {
 
 	/** Protects passthrough_req */
 	spinlock_t passthrough_req_lock;
+
+	/** Passthrough vs. daemon I/O counters */
+	struct fuse_passthrough_stats passthrough_stats;
 };
 
 static inline struct fuse_conn *get_fuse_conn_super(struct super_block *sb)
@@ -1142,5 +1158,7 @@ void fuse_passthrough_release(struct fuse_passthrough *passthrough);
 ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to);
 ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from);
 ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma);
+int fuse_passthrough_fadvise(struct file *file, loff_t offset, loff_t len,
+			     int advice);
 
 #endif /* _FS_FUSE_I_H */
@@ -116,6 +116,9 @@ ssize_t fuse_passthrough_read_iter(struct kiocb *iocb_fuse,
 	}
 	revert_creds(old_cred);
 
+	if (ret > 0)
+		atomic64_add(ret, &ff->fc->passthrough_stats.read_bytes);
+
 	fuse_file_accessed(fuse_filp, passthrough_filp);
 
 	return ret;
@@ -146,8 +149,10 @@ ssize_t fuse_passthrough_write_iter(struct kiocb *iocb_fuse,
 				     iocb_to_rw_flags(iocb_fuse->ki_flags,
 						      PASSTHROUGH_IOCB_MASK));
 		file_end_write(passthrough_filp);
-		if (ret > 0)
+		if (ret > 0) {
 			fuse_copyattr(fuse_filp, passthrough_filp);
+			atomic64_add(ret, &ff->fc->passthrough_stats.write_bytes);
+		}
 	} else {
 		struct fuse_aio_req *aio_req;
 
@@ -193,16 +198,41 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	ret = call_mmap(vma->vm_file, vma);
 	revert_creds(old_cred);
 
-	if (ret)
+	if (ret) {
 		fput(passthrough_filp);
-	else
+	} else {
 		fput(file);
+		atomic64_inc(&ff->fc->passthrough_stats.mmaps);
+	}
 
 	fuse_file_accessed(file, passthrough_filp);
 
 	return ret;
 }
 
+/*
+ * Readahead and other page cache hints are applied to the lower file: that
+ * is where passthrough reads and mmap faults are served from, so populating
+ * the FUSE mapping would only round-trip the daemon for pages nobody reads.
+ */
+int fuse_passthrough_fadvise(struct file *file, loff_t offset, loff_t len,
+			     int advice)
+{
+	int ret;
+	const struct cred *old_cred;
+	struct fuse_file *ff = file->private_data;
+	struct file *passthrough_filp = ff->passthrough.filp;
+
+	old_cred = override_creds(ff->passthrough.cred);
+	ret = vfs_fadvise(passthrough_filp, offset, len, advice);
+	revert_creds(old_cred);
+
+	if (!ret)
+		atomic64_inc(&ff->fc->passthrough_stats.fadvise);
+
+	return ret;
+}
+
 int fuse_passthrough_open(struct fuse_dev *fud, u32 lower_fd)
 {
 	int res;
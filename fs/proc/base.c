@@ -1496,6 +1496,21 @@ static const struct file_operations proc_pid_sched_group_id_operations = {
 	.release	= single_release,
 };
 
+static const struct file_operations proc_pid_sched_pred_stats_operations = {
+	.open		= sched_pred_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations proc_pid_sched_wake_lat_operations = {
+	.open		= sched_wake_lat_open,
+	.read		= seq_read,
+	.write		= sched_wake_lat_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int sched_low_latency_show(struct seq_file *m, void *v)
 {
 	struct inode *inode = m->private;
@@ -3289,6 +3304,8 @@ static const struct pid_entry tgid_base_stuff[] = {
 	REG("sched_boost", 0666,  proc_task_boost_enabled_operations),
 	REG("sched_boost_period_ms", 0666, proc_task_boost_period_operations),
 	REG("sched_low_latency", 00666, proc_pid_sched_low_latency_operations),
+	REG("sched_wake_lat_us", 00644, proc_pid_sched_wake_lat_operations),
+	REG("sched_pred_stats", 00444, proc_pid_sched_pred_stats_operations),
 #endif
 #ifdef CONFIG_SCHED_DEBUG
 	REG("sched",      S_IRUGO|S_IWUSR, proc_pid_sched_operations),
@@ -30,6 +30,9 @@ int blk_crypto_start_using_mode(enum blk_crypto_mode_num crypto_mode,
 int blk_crypto_evict_key(struct request_queue *q,
 			 const struct blk_crypto_key *key);
 
+int blk_crypto_preload_key(struct request_queue *q,
+			   const struct blk_crypto_key *key);
+
 #else /* CONFIG_BLK_INLINE_ENCRYPTION */
 
 static inline int blk_crypto_submit_bio(struct bio **bio_ptr)
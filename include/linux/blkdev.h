@@ -479,6 +479,13 @@ struct request_queue {
 	 */
 	unsigned long		nr_requests;	/* Max # of requests */
 
+	/*
+	 * Device side write buffer (e.g. UFS WriteBooster) state as last
+	 * reported by the driver, see blk_queue_write_buffer().
+	 */
+	bool			wbuf_enabled;
+	unsigned char		wbuf_fill_pct;
+
 	unsigned int		dma_drain_size;
 	void			*dma_drain_buffer;
 	unsigned int		dma_pad_mask;
@@ -780,6 +787,17 @@ static inline bool blk_write_same_mergeable(struct bio *a, struct bio *b)
 	return false;
 }
 
+/*
+ * Report the state of a device side write buffer to I/O schedulers: whether
+ * writes are currently absorbed by it and how full it is, in percent.
+ */
+static inline void blk_queue_write_buffer(struct request_queue *q,
+					  bool enabled, unsigned int fill_pct)
+{
+	WRITE_ONCE(q->wbuf_enabled, enabled);
+	WRITE_ONCE(q->wbuf_fill_pct, min(fill_pct, 100U));
+}
+
 static inline unsigned int blk_queue_depth(struct request_queue *q)
 {
 	if (q->queue_depth)
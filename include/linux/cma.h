@@ -35,6 +35,7 @@ extern int cma_init_reserved_mem(phys_addr_t base, phys_addr_t size,
 extern struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 			      bool no_warn);
 extern bool cma_release(struct cma *cma, const struct page *pages, unsigned int count);
+extern int cma_set_hot_reserve(struct cma *cma, size_t chunk, unsigned int nr);
 
 extern int cma_for_each_area(int (*it)(struct cma *cma, void *data), void *data);
 #endif
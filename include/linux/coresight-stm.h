@@ -75,6 +75,9 @@ struct channel_space {
  * @stmheter:		settings for register STMHETER.
  * @stmhebsr:		settings for register STMHEBSR.
  * @ch_alloc_fail_count:	Number of ch allocation failures over time.
+ * @user_nr:		Number of channels at the top of the stimulus port space
+ *			reserved for user space mmap, kept out of the kernel
+ *			OST channel allocator.
  */
 struct stm_drvdata {
 	void __iomem		*base;
@@ -95,6 +98,7 @@ struct stm_drvdata {
 	u32			stmheter;
 	u32			stmhebsr;
 	u32			ch_alloc_fail_count;
+	u32			user_nr;
 };
 
 #if defined(CONFIG_CORESIGHT_STM) && defined(CONFIG_CORESIGHT_QGKI)
@@ -12,6 +12,7 @@
 struct dma_iommu_mapping;
 struct io_pgtable_ops;
 struct iova_domain;
+struct fast_iova_magazine;
 
 struct dma_fast_smmu_mapping {
 	struct device		*dev;
@@ -35,6 +36,9 @@ struct dma_fast_smmu_mapping {
 
 	spinlock_t	lock;
 	struct notifier_block notifier;
+
+	/* per-CPU single page IOVA caches, may be NULL */
+	struct fast_iova_magazine __percpu *mags;
 };
 
 #ifdef CONFIG_IOMMU_IO_PGTABLE_FAST
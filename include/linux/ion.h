@@ -34,6 +34,11 @@
  * @vaddr:		the kernel mapping if kmap_cnt is not zero
  * @sg_table:		the sg table for the buffer
  * @attachments:	list of devices attached to this buffer
+ * @spare_table:	copy of @sg_table left by the last detach, reused by
+ *			the next attach
+ * @cpu_clean:		no dirty CPU cache lines can exist for the buffer
+ * @user_mapped:	the buffer was mapped to userspace by a heap that does
+ *			not track when that mapping goes away
  */
 struct ion_buffer {
 	struct list_head list;
@@ -47,6 +52,9 @@ struct ion_buffer {
 	void *vaddr;
 	struct sg_table *sg_table;
 	struct list_head attachments;
+	struct sg_table *spare_table;
+	bool cpu_clean;
+	bool user_mapped;
 };
 
 /**
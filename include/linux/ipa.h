@@ -705,6 +705,7 @@ struct ipa_sys_connect_params {
  * struct ipa_tx_meta - meta-data for the TX packet
  * @dma_address: dma mapped address of TX packet
  * @dma_address_valid: is above field valid?
+ * @xmit_more: more packets follow, doorbell may be deferred
  */
 struct ipa_tx_meta {
 	u8 pkt_init_dst_ep;
@@ -712,6 +713,7 @@ struct ipa_tx_meta {
 	bool pkt_init_dst_ep_remote;
 	dma_addr_t dma_address;
 	bool dma_address_valid;
+	bool xmit_more;
 };
 
 /**
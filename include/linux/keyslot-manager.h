@@ -64,6 +64,9 @@ void keyslot_manager_set_max_dun_bytes(struct keyslot_manager *ksm,
 int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 				     const struct blk_crypto_key *key);
 
+int keyslot_manager_preload_key(struct keyslot_manager *ksm,
+				const struct blk_crypto_key *key);
+
 void keyslot_manager_get_slot(struct keyslot_manager *ksm, unsigned int slot);
 
 void keyslot_manager_put_slot(struct keyslot_manager *ksm, unsigned int slot);
@@ -141,6 +141,14 @@ void mem_buf_put(void *membuf_desc);
 
 void *mem_buf_get(int fd);
 
+/*
+ * Borrow @nr buffers described by @alloc_data from the remote VM ahead of
+ * time, so that matching mem_buf_alloc() calls can be served without a
+ * round trip. Unused buffers are returned to the remote VM after a while.
+ */
+int mem_buf_pool_fill(struct mem_buf_allocation_data *alloc_data,
+		      unsigned int nr);
+
 #else
 
 static inline void *mem_buf_alloc(struct mem_buf_allocation_data *alloc_data)
@@ -162,5 +170,11 @@ static inline void *mem_buf_get(int fd)
 	return ERR_PTR(-ENODEV);
 }
 
+static inline int mem_buf_pool_fill(struct mem_buf_allocation_data *alloc_data,
+				    unsigned int nr)
+{
+	return -ENODEV;
+}
+
 #endif /* CONFIG_QCOM_MEM_BUF */
 #endif /* _MEM_BUF_H */
@@ -19,6 +19,7 @@ struct image_info;
 struct bhi_vec_entry;
 struct mhi_timesync;
 struct mhi_buf_info;
+struct net_device;
 struct mhi_sfr_info;
 
 #define REG_WRITE_QUEUE_LEN 1024
@@ -65,11 +66,14 @@ enum MHI_DEBUG_LEVEL {
  * @MHI_EOB: End of buffer for bulk transfer
  * @MHI_EOT: End of transfer
  * @MHI_CHAIN: Linked transfer
+ * @MHI_DB_DEFER: More buffers follow, skip the channel doorbell; the
+ * caller must end the batch with mhi_flush_transfer()
  */
 enum MHI_FLAGS {
 	MHI_EOB,
 	MHI_EOT,
 	MHI_CHAIN,
+	MHI_DB_DEFER = 0x4,
 };
 
 /**
@@ -326,6 +330,7 @@ struct mhi_controller {
 	int *irq; /* interrupt table */
 	struct mhi_event *mhi_event;
 	struct list_head sp_ev_rings; /* special purpose event rings */
+	struct net_device *napi_dev; /* dummy netdev for napi event rings */
 
 	/* cmd rings */
 	struct mhi_cmd *mhi_cmd;
@@ -335,6 +340,7 @@ struct mhi_controller {
 
 	u32 timeout_ms;
 	u32 m2_timeout_ms; /* wait time for host to continue suspend after m2 */
+	u32 m3_break_even_ms; /* hold off M3 if a burst is due within this */
 
 	/* caller should grab pm_mutex for suspend/resume operations */
 	struct mutex pm_mutex;
@@ -362,6 +368,7 @@ struct mhi_controller {
 
 	/* debug counters */
 	u32 M0, M2, M3, M3_FAST;
+	u32 M3_HOLD; /* runtime suspends deferred on predicted traffic */
 
 	/* worker for different state transitions */
 	struct work_struct st_worker;
@@ -697,6 +704,33 @@ int mhi_resume_transfer(struct mhi_device *mhi_dev);
 int mhi_get_no_free_descriptors(struct mhi_device *mhi_dev,
 				enum dma_data_direction dir);
 
+/**
+ * mhi_flush_transfer - Ring the channel doorbell for buffers queued with
+ * MHI_DB_DEFER
+ * @mhi_dev: Device associated with the channels
+ * @dir: Direction of the channel
+ */
+int mhi_flush_transfer(struct mhi_device *mhi_dev,
+		       enum dma_data_direction dir);
+
+/**
+ * mhi_queue_transfer_n - Queue a batch of buffers with one doorbell
+ * @mhi_dev: Device associated with the channels
+ * @dir: Data direction
+ * @bufs: Data buffers (skbs for hardware channels)
+ * @lens: Size in bytes of each buffer
+ * @num: Number of buffers
+ * @mflags: Interrupt flags for the device, applied to every buffer
+ *
+ * Returns the number of buffers queued, or a negative error if none was
+ */
+int mhi_queue_transfer_n(struct mhi_device *mhi_dev,
+			 enum dma_data_direction dir,
+			 void **bufs,
+			 size_t *lens,
+			 int num,
+			 enum MHI_FLAGS mflags);
+
 /**
  * mhi_poll - poll for any available data to consume
  * This is only applicable for DL direction
@@ -788,6 +822,16 @@ int mhi_pm_suspend(struct mhi_controller *mhi_cntrl);
  */
 int mhi_pm_fast_suspend(struct mhi_controller *mhi_cntrl, bool notify_client);
 
+/**
+ * mhi_pm_burst_expected - Check if traffic is predicted to resume before
+ * an M3 entry and exit would pay off
+ * @mhi_cntrl: MHI controller
+ *
+ * Controllers can use this to defer a runtime suspend, it is never
+ * meant to block system suspend.
+ */
+bool mhi_pm_burst_expected(struct mhi_controller *mhi_cntrl);
+
 /**
  * mhi_pm_resume - Resume MHI from suspended state
  * Transition to MHI state M0 state from M3 state
@@ -538,6 +538,7 @@ DECLARE_PER_CPU_READ_MOSTLY(int, sched_load_boost);
 #ifdef CONFIG_QCOM_HYP_CORE_CTL
 extern int hh_vcpu_populate_affinity_info(u32 cpu_index, u64 cap_id);
 extern int hh_vpm_grp_populate_info(u64 cap_id, int virq_num);
+extern int hh_vcpu_report_load(u64 cap_id, u32 load_pct, u64 steal_ns);
 #else
 static inline int hh_vcpu_populate_affinity_info(u32 cpu_index, u64 cap_id)
 {
@@ -547,6 +548,10 @@ static inline int  hh_vpm_grp_populate_info(u64 cap_id, int virq_num)
 {
 	return 0;
 }
+static inline int hh_vcpu_report_load(u64 cap_id, u32 load_pct, u64 steal_ns)
+{
+	return 0;
+}
 #endif /* CONFIG_QCOM_HYP_CORE_CTL */
 
 #ifdef CONFIG_SCHED_WALT
@@ -597,6 +602,10 @@ struct walt_task_struct {
 	 * 'busy_buckets' groups historical busy time into different buckets
 	 * used for prediction
 	 *
+	 * 'pred_windows', 'pred_hits' and 'pred_under' count the windows for
+	 * which a prediction was made, was within one bucket of the busy time
+	 * and fell short of the busy time, respectively
+	 *
 	 * 'demand_scaled' represents task's demand scaled to 1024
 	 */
 	u64				mark_start;
@@ -607,6 +616,9 @@ struct walt_task_struct {
 	u32				curr_window, prev_window;
 	u32				pred_demand;
 	u8				busy_buckets[NUM_BUSY_BUCKETS];
+	u32				pred_windows;
+	u32				pred_hits;
+	u32				pred_under;
 	u16				demand_scaled;
 	u16				pred_demand_scaled;
 	u64				active_time;
@@ -615,6 +627,7 @@ struct walt_task_struct {
 	bool				misfit;
 	bool				rtg_high_prio;
 	u8				low_latency;
+	u32				wake_lat_us;
 	u64				boost_period;
 	u64				boost_expires;
 	u64				last_sleep_ts;
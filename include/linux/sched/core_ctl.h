@@ -7,6 +7,7 @@
 #define __CORE_CTL_H
 
 #include <linux/types.h>
+#include <linux/cpumask.h>
 
 #define MAX_CPUS_PER_CLUSTER 6
 #define MAX_CLUSTERS 3
@@ -24,6 +25,8 @@ struct notifier_block;
 extern int core_ctl_set_boost(bool boost);
 extern void core_ctl_notifier_register(struct notifier_block *n);
 extern void core_ctl_notifier_unregister(struct notifier_block *n);
+extern void core_ctl_set_reserved_cpus(const struct cpumask *mask);
+extern void core_ctl_get_isolated_cpus(struct cpumask *mask);
 #else
 static inline int core_ctl_set_boost(bool boost)
 {
@@ -31,5 +34,10 @@ static inline int core_ctl_set_boost(bool boost)
 }
 static inline void core_ctl_notifier_register(struct notifier_block *n) {}
 static inline void core_ctl_notifier_unregister(struct notifier_block *n) {}
+static inline void core_ctl_set_reserved_cpus(const struct cpumask *mask) {}
+static inline void core_ctl_get_isolated_cpus(struct cpumask *mask)
+{
+	cpumask_clear(mask);
+}
 #endif
 #endif
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef __CPU_BOOST_H
+#define __CPU_BOOST_H
+
+#include <linux/cpumask.h>
+#include <linux/list.h>
+#include <linux/types.h>
+
+struct task_struct;
+struct cgroup_subsys_state;
+
+/*
+ * A time-bounded frequency floor on a set of CPUs. Active requests stack:
+ * each CPU runs at or above the highest floor of the requests covering it.
+ * The request is dropped on its own once duration_ms has elapsed.
+ */
+struct cpu_boost_req {
+	const char *name;
+
+	/* private */
+	struct list_head list;
+	cpumask_t cpus;
+	unsigned int freq;
+	unsigned long expires;
+};
+
+#if defined(CONFIG_SCHED_WALT) && defined(CONFIG_CPU_FREQ)
+extern int cpu_boost_update_request(struct cpu_boost_req *req,
+				    const struct cpumask *cpus,
+				    unsigned int freq,
+				    unsigned int duration_ms);
+extern void cpu_boost_remove_request(struct cpu_boost_req *req);
+extern int cpu_boost_task(struct task_struct *p, int boost,
+			  unsigned int duration_ms);
+extern int cpu_boost_css(struct cgroup_subsys_state *css, int boost,
+			 unsigned int duration_ms);
+#else
+static inline int cpu_boost_update_request(struct cpu_boost_req *req,
+					   const struct cpumask *cpus,
+					   unsigned int freq,
+					   unsigned int duration_ms)
+{
+	return 0;
+}
+static inline void cpu_boost_remove_request(struct cpu_boost_req *req) {}
+static inline int cpu_boost_task(struct task_struct *p, int boost,
+				 unsigned int duration_ms)
+{
+	return 0;
+}
+static inline int cpu_boost_css(struct cgroup_subsys_state *css, int boost,
+				unsigned int duration_ms)
+{
+	return 0;
+}
+#endif
+#endif
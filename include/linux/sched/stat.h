@@ -23,9 +23,12 @@ extern unsigned long nr_iowait_cpu(int cpu);
 
 #ifdef CONFIG_SCHED_WALT
 extern void sched_update_nr_prod(int cpu, long delta, bool inc);
+extern void sched_get_nr_prod_total(int cpu, u64 *run, u64 *wait);
 extern unsigned int sched_get_cpu_util(int cpu);
 extern void sched_update_hyst_times(void);
 extern u64 sched_lpm_disallowed_time(int cpu);
+extern u32 sched_cpu_wake_lat_us(int cpu);
+extern int sched_set_wake_lat(struct task_struct *p, u32 lat_us);
 
 extern int sched_wake_up_idle_show(struct seq_file *m, void *v);
 extern ssize_t sched_wake_up_idle_write(struct file *file,
@@ -45,8 +48,18 @@ extern ssize_t
 sched_group_id_write(struct file *file, const char __user *buf,
 					size_t count, loff_t *offset);
 extern int sched_group_id_open(struct inode *inode, struct file *filp);
+
+extern int sched_pred_stats_open(struct inode *inode, struct file *filp);
+
+extern ssize_t sched_wake_lat_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *offset);
+extern int sched_wake_lat_open(struct inode *inode, struct file *filp);
 #else
 static inline void sched_update_nr_prod(int cpu, long delta, bool inc) {}
+static inline void sched_get_nr_prod_total(int cpu, u64 *run, u64 *wait)
+{
+	*run = *wait = 0;
+}
 static inline unsigned int sched_get_cpu_util(int cpu)
 {
 	return 0;
@@ -56,6 +69,10 @@ static inline u64 sched_lpm_disallowed_time(int cpu)
 {
 	return 0;
 }
+static inline u32 sched_cpu_wake_lat_us(int cpu)
+{
+	return U32_MAX;
+}
 #endif
 
 static inline int sched_info_on(void)
@@ -87,15 +87,29 @@ struct apr_device {
 	char name[APR_NAME_SIZE];
 	spinlock_t	lock;
 	struct list_head node;
+
+	/* received packets waiting for the service, protected by apr rx_lock */
+	struct list_head rx_list;
+	struct work_struct rx_work;
+	int rx_pending;
 };
 
 #define to_apr_device(d) container_of(d, struct apr_device, dev)
 
+/*
+ * @atomic_callback is optional and is called straight from the receive
+ * path with interrupts disabled, so that data path events are not held up
+ * behind slow packets of other services. It returns -EAGAIN for packets
+ * it can't handle in atomic context, those are passed to @callback from
+ * process context. Packets of a service are always delivered in order.
+ */
 struct apr_driver {
 	int	(*probe)(struct apr_device *sl);
 	int	(*remove)(struct apr_device *sl);
 	int	(*callback)(struct apr_device *a,
 			    struct apr_resp_pkt *d);
+	int	(*atomic_callback)(struct apr_device *a,
+				   struct apr_resp_pkt *d);
 	struct device_driver		driver;
 	const struct apr_device_id	*id_table;
 };
@@ -10,6 +10,8 @@
 #ifndef __QCOM_CDSPRM_H__
 #define __QCOM_CDSPRM_H__
 
+#include <linux/errno.h>
+
 /**
  * struct cdsprm_l3 - register with set L3 clock frequency method
  * @set_l3_freq:    Sets desired L3 clock frequency in kilo-hertz.
@@ -54,4 +56,22 @@ void cdsprm_unregister_cdspl3gov(void);
 
 int cdsprm_compute_vtcm_set_partition_map(unsigned int b_vtcm_partitioning);
 
+/**
+ * cdsprm_session_hint() - Pre-vote CPU QoS, L3 and compute priority for
+ *                         an upcoming CDSP workload
+ * @duration_ms: expected duration of the workload
+ * @priority:    enum cdsprm_compute_priority value, 0 for no change
+ *
+ * Note: To be called by FastRPC on behalf of CDSP clients.
+ */
+#if IS_REACHABLE(CONFIG_QCOM_CDSP_RM)
+int cdsprm_session_hint(unsigned int duration_ms, unsigned int priority);
+#else
+static inline int cdsprm_session_hint(unsigned int duration_ms,
+				      unsigned int priority)
+{
+	return -ENODEV;
+}
+#endif
+
 #endif
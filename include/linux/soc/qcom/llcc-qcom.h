@@ -171,6 +171,13 @@ int llcc_slice_activate(struct llcc_slice_desc *desc);
  */
 int llcc_slice_deactivate(struct llcc_slice_desc *desc);
 
+/**
+ * llcc_slice_set_max_cap - change the capacity limit of a slice
+ * @slice_id: llcc slice id
+ * @max_cap: new capacity limit in KB
+ */
+int llcc_slice_set_max_cap(u32 slice_id, u32 max_cap);
+
 /**
  * qcom_llcc_probe - program the sct table
  * @pdev: platform device pointer
@@ -214,6 +221,11 @@ static inline int llcc_slice_deactivate(struct llcc_slice_desc *desc)
 {
 	return -EINVAL;
 }
+
+static inline int llcc_slice_set_max_cap(u32 slice_id, u32 max_cap)
+{
+	return -EINVAL;
+}
 static inline int qcom_llcc_probe(struct platform_device *pdev,
 		      const struct llcc_slice_config *table, u32 sz)
 {
@@ -6,6 +6,9 @@
 #ifndef _TCM_QCOM_H_
 #define _TCM_QCOM_H_
 
+#include <linux/dma-mapping.h>
+#include <linux/err.h>
+#include <linux/list.h>
 #include <linux/soc/qcom/llcc-qcom.h>
 
 struct llcc_tcm_data {
@@ -14,6 +17,21 @@ struct llcc_tcm_data {
 	size_t mem_size;
 };
 
+/*
+ * A named sub-allocation of the TCM slice, shared with other clients.
+ * @iova is valid between llcc_tcm_region_map() and llcc_tcm_region_unmap().
+ */
+struct llcc_tcm_region {
+	const char *name;
+	phys_addr_t phys_addr;
+	void __iomem *virt_addr;
+	size_t size;
+	struct device *map_dev;
+	dma_addr_t iova;
+	enum dma_data_direction dir;
+	struct list_head list;
+};
+
 int qcom_llcc_tcm_probe(struct platform_device *pdev,
 		const struct llcc_slice_config *table, size_t size,
 		struct device_node *node);
@@ -29,6 +47,15 @@ void __iomem *llcc_tcm_get_virt_addr(struct llcc_tcm_data *tcm_data);
 size_t llcc_tcm_get_slice_size(struct llcc_tcm_data *tcm_data);
 
 void llcc_tcm_deactivate(struct llcc_tcm_data *tcm_data);
+
+struct llcc_tcm_region *llcc_tcm_region_alloc(const char *name, size_t size);
+
+void llcc_tcm_region_free(struct llcc_tcm_region *region);
+
+dma_addr_t llcc_tcm_region_map(struct device *dev,
+		struct llcc_tcm_region *region, enum dma_data_direction dir);
+
+void llcc_tcm_region_unmap(struct llcc_tcm_region *region);
 #else
 static __maybe_unused struct llcc_tcm_data *llcc_tcm_activate(void)
 { return NULL; }
@@ -44,6 +71,22 @@ static __maybe_unused size_t llcc_tcm_get_slice_size(struct llcc_tcm_data *tcm_d
 
 static __maybe_unused void llcc_tcm_deactivate(struct llcc_tcm_data *tcm_data)
 { }
+
+static __maybe_unused struct llcc_tcm_region *llcc_tcm_region_alloc(
+		const char *name, size_t size)
+{ return ERR_PTR(-ENODEV); }
+
+static __maybe_unused void llcc_tcm_region_free(
+		struct llcc_tcm_region *region)
+{ }
+
+static __maybe_unused dma_addr_t llcc_tcm_region_map(struct device *dev,
+		struct llcc_tcm_region *region, enum dma_data_direction dir)
+{ return DMA_MAPPING_ERROR; }
+
+static __maybe_unused void llcc_tcm_region_unmap(
+		struct llcc_tcm_region *region)
+{ }
 #endif
 
 #endif //_TCM_QCOM_H_
@@ -3,12 +3,26 @@
 #define __QCOM_SMEM_STATE__
 
 #include <linux/err.h>
+#include <linux/list.h>
 
 struct device_node;
 struct qcom_smem_state;
 
 struct qcom_smem_state_ops {
 	int (*update_bits)(void *, u32, u32);
+	int (*batch)(void *, bool);
+};
+
+/**
+ * struct qcom_smp2p_notifier - bitmask notifier of an inbound smp2p entry
+ * @mask:	bits of interest
+ * @notify:	called with the changed bits within @mask and the entry value
+ * @node:	internal list node
+ */
+struct qcom_smp2p_notifier {
+	u32 mask;
+	void (*notify)(struct qcom_smp2p_notifier *nb, u32 changed, u32 value);
+	struct list_head node;
 };
 
 #ifdef CONFIG_QCOM_SMEM_STATE
@@ -17,6 +31,8 @@ struct qcom_smem_state *qcom_smem_state_get(struct device *dev, const char *con_
 void qcom_smem_state_put(struct qcom_smem_state *);
 
 int qcom_smem_state_update_bits(struct qcom_smem_state *state, u32 mask, u32 value);
+int qcom_smem_state_batch_begin(struct qcom_smem_state *state);
+int qcom_smem_state_batch_end(struct qcom_smem_state *state);
 
 struct qcom_smem_state *qcom_smem_state_register(struct device_node *of_node, const struct qcom_smem_state_ops *ops, void *data);
 void qcom_smem_state_unregister(struct qcom_smem_state *state);
@@ -39,6 +55,16 @@ static inline int qcom_smem_state_update_bits(struct qcom_smem_state *state,
 	return -EINVAL;
 }
 
+static inline int qcom_smem_state_batch_begin(struct qcom_smem_state *state)
+{
+	return -EINVAL;
+}
+
+static inline int qcom_smem_state_batch_end(struct qcom_smem_state *state)
+{
+	return -EINVAL;
+}
+
 static inline struct qcom_smem_state *qcom_smem_state_register(struct device_node *of_node,
 	const struct qcom_smem_state_ops *ops, void *data)
 {
@@ -51,4 +77,22 @@ static inline void qcom_smem_state_unregister(struct qcom_smem_state *state)
 
 #endif
 
+#if IS_ENABLED(CONFIG_QCOM_SMP2P)
+int qcom_smp2p_notifier_register(struct device_node *np,
+				 struct qcom_smp2p_notifier *nb);
+void qcom_smp2p_notifier_unregister(struct device_node *np,
+				    struct qcom_smp2p_notifier *nb);
+#else
+static inline int qcom_smp2p_notifier_register(struct device_node *np,
+					       struct qcom_smp2p_notifier *nb)
+{
+	return -ENODEV;
+}
+
+static inline void qcom_smp2p_notifier_unregister(struct device_node *np,
+					struct qcom_smp2p_notifier *nb)
+{
+}
+#endif
+
 #endif
@@ -69,6 +69,20 @@ int spmi_device_add(struct spmi_device *sdev);
 
 void spmi_device_remove(struct spmi_device *sdev);
 
+/**
+ * struct spmi_xfer - one extended register long access of a batch
+ * @addr:	slave register address (16-bit address).
+ * @len:	number of bytes to transfer (up to 8 bytes).
+ * @write:	true to write @buf to the slave, false to read into it.
+ * @buf:	data buffer, at least @len bytes long.
+ */
+struct spmi_xfer {
+	u16	addr;
+	u8	len;
+	bool	write;
+	u8	*buf;
+};
+
 /**
  * struct spmi_controller - interface to the SPMI master controller
  * @dev:	Driver model representation of the device.
@@ -76,6 +90,8 @@ void spmi_device_remove(struct spmi_device *sdev);
  * @cmd:	sends a non-data command sequence on the SPMI bus.
  * @read_cmd:	sends a register read command sequence on the SPMI bus.
  * @write_cmd:	sends a register write command sequence on the SPMI bus.
+ * @xfer_cmd:	optional, sends a batch of extended register long read and
+ *		write command sequences to one slave on the SPMI bus.
  */
 struct spmi_controller {
 	struct device		dev;
@@ -85,6 +101,8 @@ struct spmi_controller {
 			    u8 sid, u16 addr, u8 *buf, size_t len);
 	int	(*write_cmd)(struct spmi_controller *ctrl, u8 opcode,
 			     u8 sid, u16 addr, const u8 *buf, size_t len);
+	int	(*xfer_cmd)(struct spmi_controller *ctrl, u8 sid,
+			    struct spmi_xfer *xfers, unsigned int num);
 };
 
 static inline struct spmi_controller *to_spmi_controller(struct device *d)
@@ -174,6 +192,8 @@ int spmi_ext_register_write(struct spmi_device *sdev, u8 addr,
 			    const u8 *buf, size_t len);
 int spmi_ext_register_writel(struct spmi_device *sdev, u16 addr,
 			     const u8 *buf, size_t len);
+int spmi_ext_register_xfer(struct spmi_device *sdev, struct spmi_xfer *xfers,
+			   unsigned int num);
 int spmi_command_reset(struct spmi_device *sdev);
 int spmi_command_sleep(struct spmi_device *sdev);
 int spmi_command_wakeup(struct spmi_device *sdev);
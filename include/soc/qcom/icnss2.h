@@ -119,6 +119,13 @@ enum icnss_driver_mode {
 	ICNSS_CALIBRATION,
 };
 
+/* A pre-mapped RX buffer, see icnss_rx_pool_create() */
+struct icnss_rx_buf {
+	void *vaddr;
+	dma_addr_t iova;
+	unsigned int idx;
+};
+
 struct icnss_soc_info {
 	void __iomem *v_addr;
 	phys_addr_t p_addr;
@@ -164,6 +171,13 @@ extern struct dma_iommu_mapping *icnss_smmu_get_mapping(struct device *dev);
 extern struct iommu_domain *icnss_smmu_get_domain(struct device *dev);
 extern int icnss_smmu_map(struct device *dev, phys_addr_t paddr,
 			  uint32_t *iova_addr, size_t size);
+extern int icnss_rx_pool_create(struct device *dev, unsigned int ring_id,
+				unsigned int nr_bufs, size_t buf_size);
+extern void icnss_rx_pool_destroy(struct device *dev, unsigned int ring_id);
+extern int icnss_rx_buf_get(struct device *dev, unsigned int ring_id,
+			    struct icnss_rx_buf *buf);
+extern void icnss_rx_buf_put(struct device *dev, unsigned int ring_id,
+			     unsigned int idx);
 extern int icnss_smmu_unmap(struct device *dev,
 			    uint32_t iova_addr, size_t size);
 extern unsigned int icnss_socinfo_get_serial_number(struct device *dev);
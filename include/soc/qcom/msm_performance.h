@@ -6,6 +6,8 @@
 #ifndef __MSM_PERFORMANCE_H
 #define __MSM_PERFORMANCE_H
 
+#include <linux/types.h>
+
 enum gfx_evt_t {
 	MSM_PERF_INVAL,
 	MSM_PERF_QUEUE,
@@ -17,6 +19,22 @@ enum evt_update_t {
 	MSM_PERF_GFX,
 };
 
+/* Record types delivered through /dev/msm_perf_events */
+enum msm_perf_evt_type {
+	MSM_PERF_EVT_CLUSTER_LOAD,	/* big_nr, top_load, top_load[3] */
+	MSM_PERF_EVT_CLUSTER_CAP,	/* curr_cap[3] */
+	MSM_PERF_EVT_HOTPLUG,		/* cpu, online */
+	MSM_PERF_EVT_GAME_START,	/* pid */
+	MSM_PERF_EVT_GFX,		/* pid, ctx_id, timestamp, gfx_evt_t */
+	MSM_PERF_EVT_OVERFLOW,		/* number of records dropped */
+};
+
+struct msm_perf_evt_rec {
+	__u64 ts_ns;
+	__u32 type;
+	__u32 data[5];
+};
+
 #if IS_ENABLED(CONFIG_MSM_PERFORMANCE) && IS_ENABLED(CONFIG_MSM_PERFORMANCE_QGKI)
 void msm_perf_events_update(enum evt_update_t update_typ,
 			enum gfx_evt_t evt_typ, pid_t pid,
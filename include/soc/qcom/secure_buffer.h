@@ -49,6 +49,10 @@ int hyp_assign_table(struct sg_table *table,
 			u32 *source_vm_list, int source_nelems,
 			int *dest_vmids, int *dest_perms,
 			int dest_nelems);
+int hyp_assign_table_batch(struct sg_table **tables, int nr_tables,
+			   u32 *source_vm_list, int source_nelems,
+			   int *dest_vmids, int *dest_perms,
+			   int dest_nelems);
 int hyp_assign_phys(phys_addr_t addr, u64 size,
 			u32 *source_vmlist, int source_nelems,
 			int *dest_vmids, int *dest_perms, int dest_nelems);
@@ -64,6 +68,13 @@ static inline int hyp_assign_table(struct sg_table *table,
 	return -EINVAL;
 }
 
+static inline int hyp_assign_table_batch(struct sg_table **tables,
+			int nr_tables, u32 *source_vm_list, int source_nelems,
+			int *dest_vmids, int *dest_perms, int dest_nelems)
+{
+	return -EINVAL;
+}
+
 static inline int hyp_assign_phys(phys_addr_t addr, u64 size,
 			u32 *source_vmlist, int source_nelems,
 			int *dest_vmids, int *dest_perms, int dest_nelems)
@@ -65,6 +65,10 @@ int subsys_register_early_notifier(const char *subsys_name,
 int subsys_unregister_early_notifier(const char *subsys_name, enum
 				     early_subsys_notif_type notif_type);
 void subsys_send_early_notifications(void *early_notif_handle);
+
+/* Called by the SSR core to expose per-notifier latency in debugfs */
+void subsys_notif_debugfs_init(void);
+void subsys_notif_debugfs_exit(void);
 #else
 
 static inline void *subsys_notif_register_notifier(
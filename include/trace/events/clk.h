@@ -118,6 +118,53 @@ DEFINE_EVENT(clk_rate, clk_set_rate_complete,
 	TP_ARGS(core, rate)
 );
 
+TRACE_EVENT(clk_rcg2_set_rate,
+
+	TP_PROTO(const char *name, unsigned long rate),
+
+	TP_ARGS(name, rate),
+
+	TP_STRUCT__entry(
+		__string(        name,           name                      )
+		__field(unsigned long,           rate                      )
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->rate = rate;
+	),
+
+	TP_printk("%s %lu", __get_str(name), (unsigned long)__entry->rate)
+);
+
+TRACE_EVENT(clk_rcg2_set_rate_complete,
+
+	TP_PROTO(const char *name, unsigned long rate, bool skipped,
+		 u64 latency_ns, int ret),
+
+	TP_ARGS(name, rate, skipped, latency_ns, ret),
+
+	TP_STRUCT__entry(
+		__string(        name,           name                      )
+		__field(unsigned long,           rate                      )
+		__field(bool,                    skipped                   )
+		__field(u64,                     latency_ns                )
+		__field(int,                     ret                       )
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->rate = rate;
+		__entry->skipped = skipped;
+		__entry->latency_ns = latency_ns;
+		__entry->ret = ret;
+	),
+
+	TP_printk("%s %lu skipped=%d latency_ns=%llu ret=%d",
+		  __get_str(name), (unsigned long)__entry->rate,
+		  __entry->skipped, __entry->latency_ns, __entry->ret)
+);
+
 DECLARE_EVENT_CLASS(clk_parent,
 
 	TP_PROTO(struct clk_core *core, struct clk_core *parent),
@@ -813,6 +813,47 @@ TRACE_EVENT(memlat_dev_update,
 		__entry->vote)
 );
 
+TRACE_EVENT(memlat_stall_model,
+
+	TP_PROTO(const char *name, unsigned int dev_id, unsigned long stall,
+		 unsigned long lat, unsigned long mem_pct, unsigned long cur,
+		 unsigned long need, unsigned long vote),
+
+	TP_ARGS(name, dev_id, stall, lat, mem_pct, cur, need, vote),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(unsigned int, dev_id)
+		__field(unsigned long, stall)
+		__field(unsigned long, lat)
+		__field(unsigned long, mem_pct)
+		__field(unsigned long, cur)
+		__field(unsigned long, need)
+		__field(unsigned long, vote)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->dev_id = dev_id;
+		__entry->stall = stall;
+		__entry->lat = lat;
+		__entry->mem_pct = mem_pct;
+		__entry->cur = cur;
+		__entry->need = need;
+		__entry->vote = vote;
+	),
+
+	TP_printk("dev: %s, id=%u, stall=%lu, lat=%lu, mem_pct=%lu, cur=%lu, need=%lu, vote=%lu",
+		__get_str(name),
+		__entry->dev_id,
+		__entry->stall,
+		__entry->lat,
+		__entry->mem_pct,
+		__entry->cur,
+		__entry->need,
+		__entry->vote)
+);
+
 TRACE_EVENT(sugov_util_update,
 	    TP_PROTO(int cpu,
 		     unsigned long util, unsigned long avg_cap,
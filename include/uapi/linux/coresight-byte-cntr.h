@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef __UAPI_CORESIGHT_BYTE_CNTR_H_
+#define __UAPI_CORESIGHT_BYTE_CNTR_H_
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct byte_cntr_block - A block of trace ready in the mmap()ed ETR buffer
+ * @offset: Offset of the block from the start of the mapping
+ * @len: Number of bytes of trace at @offset
+ */
+struct byte_cntr_block {
+	__u64 offset;
+	__u64 len;
+};
+
+#define BYTE_CNTR_IOC_MAGIC		0xBC
+
+/* Size of the ETR buffer, i.e. the length to pass to mmap() */
+#define BYTE_CNTR_IOC_BUF_SIZE		_IOR(BYTE_CNTR_IOC_MAGIC, 0, __u64)
+/*
+ * Wait for the next block of trace and consume it. The data stays valid
+ * until the ETR wraps around to it again.
+ */
+#define BYTE_CNTR_IOC_GET_BLOCK		_IOR(BYTE_CNTR_IOC_MAGIC, 1, \
+					     struct byte_cntr_block)
+
+#endif
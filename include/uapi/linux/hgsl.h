@@ -105,6 +105,24 @@ struct hgsl_fhi_issud_cmds {
 #define HGSL_IOCTL_ISSUE_CMDS	\
 	HGSL_IORW(0x05, struct hgsl_fhi_issud_cmds)
 
+#define HGSL_ISSUE_CMDS_BATCH_MAX	32
+
+/**
+ * struct hgsl_fhi_issue_cmds_batch - submit several cmds to DB queue at once
+ * @cmds: Array of struct hgsl_fhi_issud_cmds
+ * @num_cmds: Number of entries in @cmds, at most HGSL_ISSUE_CMDS_BATCH_MAX
+ * @num_submitted: Returns the number of entries of @cmds that were written
+ * to the DB queue, the rest have to be submitted again
+ */
+struct hgsl_fhi_issue_cmds_batch {
+	__u64 cmds;
+	__u32 num_cmds;
+	__u32 num_submitted;
+};
+
+#define HGSL_IOCTL_ISSUE_CMDS_BATCH	\
+	HGSL_IORW(0x06, struct hgsl_fhi_issue_cmds_batch)
+
 /**
  * struct hgsl_ctxt_create_info - create a DB context
  * @context_id: Current context for these cmds
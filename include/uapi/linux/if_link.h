@@ -1021,11 +1021,15 @@ enum {
 #define RMNET_FLAGS_INGRESS_MAP_COMMANDS          (1U << 1)
 #define RMNET_FLAGS_INGRESS_MAP_CKSUMV4           (1U << 2)
 #define RMNET_FLAGS_EGRESS_MAP_CKSUMV4            (1U << 3)
+#define RMNET_FLAGS_INGRESS_DEAGG_ZERO_COPY       (1U << 4)
+#define RMNET_FLAGS_INGRESS_DEAGG_BATCH           (1U << 5)
+#define RMNET_FLAGS_EGRESS_AGGREGATION            (1U << 6)
 
 enum {
 	IFLA_RMNET_UNSPEC,
 	IFLA_RMNET_MUX_ID,
 	IFLA_RMNET_FLAGS,
+	IFLA_RMNET_UL_AGG_PARAMS,
 	__IFLA_RMNET_MAX,
 };
 
@@ -1036,4 +1040,10 @@ struct ifla_rmnet_flags {
 	__u32	mask;
 };
 
+struct ifla_rmnet_ul_agg_params {
+	__u16	agg_size;
+	__u16	agg_count;
+	__u32	agg_time_ns;
+};
+
 #endif /* _UAPI_LINUX_IF_LINK_H */
@@ -7,6 +7,7 @@
 #define _UAPI_DSPS_H_
 
 #include <linux/ioctl.h>
+#include <linux/types.h>
 
 #define DSPS_IOCTL_MAGIC 'd'
 
@@ -18,4 +19,33 @@
 
 #define DSPS_IOCTL_RESET _IO(DSPS_IOCTL_MAGIC, 5)
 
+/*
+ * Sensor sample ring shared with SLPI. The header sits at offset 0 of
+ * the mmap()ed region and is followed by nr_recs records of rec_size
+ * bytes. SLPI advances wr_idx and rings the doorbell once the fill level
+ * reaches watermark; the reader advances rd_idx. Indexes wrap at nr_recs.
+ */
+#define SNS_RING_MAGIC		0x534e5352	/* "SNSR" */
+
+struct sns_ring_hdr {
+	__u32 magic;
+	__u32 version;
+	__u32 rec_size;
+	__u32 nr_recs;
+	__u32 wr_idx;
+	__u32 rd_idx;
+	__u32 watermark;
+	__u32 overflow;
+};
+
+struct sns_ring_info {
+	__u32 size;
+	__u32 rec_size;
+	__u32 nr_recs;
+	__u32 doorbells;
+};
+
+#define DSPS_IOCTL_RING_INFO _IOR(DSPS_IOCTL_MAGIC, 6, struct sns_ring_info)
+#define DSPS_IOCTL_RING_WATERMARK _IOW(DSPS_IOCTL_MAGIC, 7, __u32)
+
 #endif	/* _UAPI_DSPS_H_ */
@@ -151,6 +151,7 @@
 #define IPA_IOCTL_QUERY_CACHED_DRIVER_MSG       94
 #define IPA_IOCTL_SET_EXT_ROUTER_MODE           95
 #define IPA_IOCTL_ADD_DEL_DSCP_PCP_MAPPING      96
+#define IPA_IOCTL_RULE_TXN                      97
 /**
  * max size of the header to be inserted
  */
@@ -3553,6 +3554,36 @@ struct ipa_odl_modem_config {
 	__u8 config_status;
 };
 
+/**
+ * struct ipa_odl_ring_hdr - control page of the /dev/ipa_adpl mmap ring
+ * @prod: free running byte index written by the driver
+ * @cons: free running byte index written by the reader
+ * @size: size in bytes of the data area, a power of 2
+ * @data_offset: offset of the data area from the start of the mapping
+ * @drops: packets dropped because the ring was full
+ *
+ * mmap() of /dev/ipa_adpl with one page plus a power of 2 data area
+ * switches the device from read() to the ring. Each packet is an 8 byte
+ * aligned struct ipa_odl_ring_rec followed by the payload; a record with
+ * IPA_ODL_RING_REC_PAD set means skip to the start of the data area.
+ * The reader advances @cons after consuming, and may poll() for data.
+ */
+struct ipa_odl_ring_hdr {
+	__u32 prod;
+	__u32 cons;
+	__u32 size;
+	__u32 data_offset;
+	__u32 drops;
+	__u32 reserved[3];
+};
+
+#define IPA_ODL_RING_REC_PAD 0x1
+
+struct ipa_odl_ring_rec {
+	__u32 len;
+	__u32 flags;
+};
+
 struct ipa_ioc_fnr_index_info {
 	uint8_t hw_counter_offset;
 	uint8_t sw_counter_offset;
@@ -3749,6 +3780,25 @@ struct ipa_ioc_dscp_pcp_map_info {
 	uint8_t dscp_pcp_map[IPA_UC_MAX_DSCP_VAL];
 };
 
+/**
+ * struct ipa_ioc_rule_txn - add headers, routing and filtering rules in
+ * one request and commit them together
+ * @add_hdr: user pointer to struct ipa_ioc_add_hdr, 0 if none
+ * @add_rt_rule: user pointer to struct ipa_ioc_add_rt_rule_v2, 0 if none
+ * @add_flt_rule: user pointer to struct ipa_ioc_add_flt_rule_v2, 0 if none
+ * @commit: should the changes be written to IPA HW also?
+ *
+ * The commit flags of the individual requests are ignored; status and
+ * handles are returned through them as for the standalone ioctls.
+ */
+struct ipa_ioc_rule_txn {
+	uint64_t add_hdr;
+	uint64_t add_rt_rule;
+	uint64_t add_flt_rule;
+	uint8_t commit;
+	uint8_t reserved[7];
+};
+
 /**
  *   actual IOCTLs supported by IPA driver
  */
@@ -4074,6 +4124,10 @@ struct ipa_ioc_dscp_pcp_map_info {
 				IPA_IOCTL_ADD_DEL_DSCP_PCP_MAPPING, \
 				struct ipa_ioc_dscp_pcp_map_info)
 
+#define IPA_IOC_RULE_TXN _IOWR(IPA_IOC_MAGIC, \
+				IPA_IOCTL_RULE_TXN, \
+				struct ipa_ioc_rule_txn)
+
 /*
  * unique magic number of the Tethering bridge ioctls
  */
@@ -74,6 +74,8 @@
 #define KGSL_CONTEXT_TYPE_UNKNOWN	0x1E
 
 #define KGSL_CONTEXT_INVALIDATE_ON_FAULT 0x10000000
+/* Spin on the retired timestamp for a short while before sleeping */
+#define KGSL_CONTEXT_BUSY_WAIT          0x20000000
 
 #define KGSL_CONTEXT_INVALID 0xffffffff
 
@@ -151,6 +153,7 @@
 #define KGSL_MEMFLAGS_SPARSE_VIRT (1ULL << 30)
 #define KGSL_MEMFLAGS_IOCOHERENT  (1ULL << 31)
 #define KGSL_MEMFLAGS_GUARD_PAGE  (1ULL << 33)
+#define KGSL_MEMFLAGS_RECLAIMABLE (1ULL << 36)
 
 /* Memory types for which allocations are made */
 #define KGSL_MEMTYPE_MASK		0x0000FF00
@@ -343,6 +346,13 @@ enum kgsl_timestamp_type {
 #define KGSL_PROP_CONTEXT_PROPERTY	0x28
 #define KGSL_PROP_GPU_MODEL		0x29
 #define KGSL_PROP_VK_DEVICE_ID		0x2A
+#define KGSL_PROP_CONTEXT_DEADLINE	0x2B
+/*
+ * Setting KGSL_PROP_GPU_PREWAKE (with no value) hints that a submission is
+ * coming soon, so the GPU starts leaving slumber ahead of it. If nothing is
+ * submitted the GPU goes back to sleep after the wake timeout.
+ */
+#define KGSL_PROP_GPU_PREWAKE		0x2C
 
 /*
  * kgsl_capabilities_properties returns a list of supported properties.
@@ -362,6 +372,20 @@ struct kgsl_capabilities_properties {
  */
 #define KGSL_QUERY_CAPS_PROPERTIES 1
 
+/*
+ * struct kgsl_context_deadline - argument for KGSL_PROP_CONTEXT_DEADLINE
+ * @context_id: Context that owns the deadline
+ * @__pad: Must be zero
+ * @deadline: CLOCK_MONOTONIC time in nanoseconds by which the work the context
+ * queues next should retire. Pass 0 to take the context out of deadline
+ * scheduling.
+ */
+struct kgsl_context_deadline {
+	__u32 context_id;
+	__u32 __pad;
+	__u64 deadline;
+};
+
 /*
  * kgsl_capabilities allows the user to query kernel capabilities. The 'data'
  * type should be set appropriately for the querytype (see above). Pass 0 to
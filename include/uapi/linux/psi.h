@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_LINUX_PSI_H
+#define _UAPI_LINUX_PSI_H
+
+#include <linux/types.h>
+
+/*
+ * Layout of the page mapped from /proc/pressure/memory_fast.
+ *
+ * The kernel makes @seq odd while it updates the page and even again
+ * once it is done; readers retry while @seq is odd or changed across
+ * their read. All times are CLOCK_MONOTONIC nanoseconds, and stall
+ * times are summed over the tasks stalled in direct reclaim or direct
+ * compaction.
+ */
+struct psi_fast_stats {
+	__u32 seq;
+	__u32 nr_stalling;	/* tasks currently in a direct stall */
+	__u64 budget_ns;	/* configured stall budget */
+	__u64 window_ns;	/* configured window */
+	__u64 window_start_ns;	/* start of the current window */
+	__u64 window_stall_ns;	/* stall time in the current window */
+	__u64 total_stall_ns;	/* stall time since the budget was set */
+	__u64 events;		/* number of budget overruns */
+	__u64 last_event_ns;	/* time of the last budget overrun */
+};
+
+#endif /* _UAPI_LINUX_PSI_H */
@@ -2839,6 +2839,7 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags,
 
 	cpu = select_task_rq(p, p->wake_cpu, SD_BALANCE_WAKE, wake_flags,
 			     sibling_count_hint);
+	walt_note_group_wakeup(p, cpu);
 	if (task_cpu(p) != cpu) {
 		wake_flags |= WF_MIGRATED;
 		psi_ttwu_dequeue(p);
@@ -2921,6 +2922,7 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 	p->wts.boost_expires		= 0;
 	p->wts.boost_period		= 0;
 	p->wts.low_latency		= 0;
+	p->wts.wake_lat_us		= 0;
 	p->wts.iowaited			= false;
 #endif
 	INIT_LIST_HEAD(&p->se.group_node);
@@ -3867,6 +3869,8 @@ void scheduler_tick(void)
 	if (early_notif)
 		flag = SCHED_CPUFREQ_WALT | SCHED_CPUFREQ_EARLY_DET;
 
+	core_ctl_tick(rq, wallclock);
+
 	cpufreq_update_util(rq, flag);
 	rq_unlock(rq, &rf);
 
@@ -7413,6 +7417,26 @@ static int sched_colocate_write(struct cgroup_subsys_state *css,
 	tg->wtg.colocate_update_disabled = true;
 	return 0;
 }
+
+static u64 sched_pred_model_read(struct cgroup_subsys_state *css,
+						struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return (u64) tg->wtg.pred_model;
+}
+
+static int sched_pred_model_write(struct cgroup_subsys_state *css,
+				struct cftype *cft, u64 model)
+{
+	struct task_group *tg = css_tg(css);
+
+	if (model >= WALT_PRED_END)
+		return -EINVAL;
+
+	WRITE_ONCE(tg->wtg.pred_model, model);
+	return 0;
+}
 #else
 static void walt_schedgp_attach(struct cgroup_taskset *tset) { }
 #endif /* CONFIG_SCHED_WALT */
@@ -8270,6 +8294,12 @@ static struct cftype cpu_legacy_files[] = {
 		.read_u64 = sched_colocate_read,
 		.write_u64 = sched_colocate_write,
 	},
+	{
+		.name = "uclamp.pred_model",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = sched_pred_model_read,
+		.write_u64 = sched_pred_model_write,
+	},
 #endif /* CONFIG_SCHED_WALT */
 #endif /* CONFIG_UCLAMP_TASK_GROUP */
 	{ }	/* Terminate */
@@ -8471,6 +8501,12 @@ static struct cftype cpu_files[] = {
 		.read_u64 = sched_colocate_read,
 		.write_u64 = sched_colocate_write,
 	},
+	{
+		.name = "uclamp.pred_model",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = sched_pred_model_read,
+		.write_u64 = sched_pred_model_write,
+	},
 #endif /* CONFIG_SCHED_WALT */
 #endif /* CONFIG_UCLAMP_TASK_GROUP */
 	{ }	/* terminate */
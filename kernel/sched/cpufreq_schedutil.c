@@ -25,6 +25,7 @@ struct sugov_tunables {
 	unsigned int		hispeed_freq;
 	unsigned int		rtg_boost_freq;
 	bool			pl;
+	bool			urgent_bypass;
 };
 
 struct sugov_policy {
@@ -58,6 +59,7 @@ struct sugov_policy {
 
 	bool			limits_changed;
 	bool			need_freq_update;
+	bool			urgent;
 };
 
 struct sugov_cpu {
@@ -117,6 +119,10 @@ static bool sugov_should_update_freq(struct sugov_policy *sg_policy, u64 time)
 		return true;
 	}
 
+	/* An urgent WALT update may only ramp up, see sugov_up_down_rate_limit() */
+	if (sg_policy->urgent)
+		return true;
+
 	/* No need to recalculate next freq for min_rate_limit_us
 	 * at least. However we might still decide to further rate
 	 * limit once frequency change direction is decided, according
@@ -134,7 +140,7 @@ static bool sugov_up_down_rate_limit(struct sugov_policy *sg_policy, u64 time,
 
 	delta_ns = time - sg_policy->last_freq_update_time;
 
-	if (next_freq > sg_policy->next_freq &&
+	if (next_freq > sg_policy->next_freq && !sg_policy->urgent &&
 	    delta_ns < sg_policy->up_rate_delay_ns)
 			return true;
 
@@ -163,13 +169,35 @@ static inline bool conservative_pl(void)
 #endif
 }
 
+/*
+ * WALT raises SCHED_CPUFREQ_INTERCLUSTER_MIG when load migrates between
+ * clusters and SCHED_CPUFREQ_EARLY_DET when a task has been runnable for
+ * too long mid-window. Both mean demand on this policy went up sharply,
+ * so let the resulting frequency increase through without waiting for the
+ * up rate limit. Decreases stay subject to down_rate_limit_us.
+ */
+static inline void sugov_mark_urgent(struct sugov_policy *sg_policy,
+				     unsigned int flags)
+{
+	if (sg_policy->tunables->urgent_bypass &&
+	    (flags & (SCHED_CPUFREQ_INTERCLUSTER_MIG |
+		      SCHED_CPUFREQ_EARLY_DET)))
+		sg_policy->urgent = true;
+}
+
 static bool sugov_update_next_freq(struct sugov_policy *sg_policy, u64 time,
 				   unsigned int next_freq)
 {
-	if (sg_policy->next_freq == next_freq)
+	bool limited;
+
+	if (sg_policy->next_freq == next_freq) {
+		sg_policy->urgent = false;
 		return false;
+	}
 
-	if (sugov_up_down_rate_limit(sg_policy, time, next_freq))
+	limited = sugov_up_down_rate_limit(sg_policy, time, next_freq);
+	sg_policy->urgent = false;
+	if (limited)
 		return false;
 
 	sg_policy->next_freq = next_freq;
@@ -650,6 +678,7 @@ static void sugov_update_single(struct update_util_data *hook, u64 time,
 	sg_cpu->last_update = time;
 
 	ignore_dl_rate_limit(sg_cpu, sg_policy);
+	sugov_mark_urgent(sg_policy, flags);
 
 	if (!sugov_should_update_freq(sg_policy, time))
 		return;
@@ -790,6 +819,7 @@ sugov_update_shared(struct update_util_data *hook, u64 time, unsigned int flags)
 	sugov_calc_avg_cap(sg_policy, sg_cpu->walt_load.ws,
 			   sg_policy->policy->cur);
 	ignore_dl_rate_limit(sg_cpu, sg_policy);
+	sugov_mark_urgent(sg_policy, flags);
 
 	trace_sugov_util_update(sg_cpu->cpu, sg_cpu->util, sg_policy->avg_cap,
 				sg_cpu->max, sg_cpu->walt_load.nl,
@@ -1021,12 +1051,31 @@ static ssize_t pl_store(struct gov_attr_set *attr_set, const char *buf,
 	return count;
 }
 
+static ssize_t urgent_bypass_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", tunables->urgent_bypass);
+}
+
+static ssize_t urgent_bypass_store(struct gov_attr_set *attr_set,
+				   const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	if (kstrtobool(buf, &tunables->urgent_bypass))
+		return -EINVAL;
+
+	return count;
+}
+
 static struct governor_attr up_rate_limit_us = __ATTR_RW(up_rate_limit_us);
 static struct governor_attr down_rate_limit_us = __ATTR_RW(down_rate_limit_us);
 static struct governor_attr hispeed_load = __ATTR_RW(hispeed_load);
 static struct governor_attr hispeed_freq = __ATTR_RW(hispeed_freq);
 static struct governor_attr rtg_boost_freq = __ATTR_RW(rtg_boost_freq);
 static struct governor_attr pl = __ATTR_RW(pl);
+static struct governor_attr urgent_bypass = __ATTR_RW(urgent_bypass);
 
 static struct attribute *sugov_attrs[] = {
 	&up_rate_limit_us.attr,
@@ -1035,6 +1084,7 @@ static struct attribute *sugov_attrs[] = {
 	&hispeed_freq.attr,
 	&rtg_boost_freq.attr,
 	&pl.attr,
+	&urgent_bypass.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(sugov);
@@ -1155,6 +1205,7 @@ static void sugov_tunables_save(struct cpufreq_policy *policy,
 	}
 
 	cached->pl = tunables->pl;
+	cached->urgent_bypass = tunables->urgent_bypass;
 	cached->hispeed_load = tunables->hispeed_load;
 	cached->rtg_boost_freq = tunables->rtg_boost_freq;
 	cached->hispeed_freq = tunables->hispeed_freq;
@@ -1178,6 +1229,7 @@ static void sugov_tunables_restore(struct cpufreq_policy *policy)
 		return;
 
 	tunables->pl = cached->pl;
+	tunables->urgent_bypass = cached->urgent_bypass;
 	tunables->hispeed_load = cached->hispeed_load;
 	tunables->rtg_boost_freq = cached->rtg_boost_freq;
 	tunables->hispeed_freq = cached->hispeed_freq;
@@ -1235,6 +1287,7 @@ static int sugov_init(struct cpufreq_policy *policy)
 	tunables->down_rate_limit_us = cpufreq_policy_transition_delay_us(policy);
 	tunables->hispeed_load = DEFAULT_HISPEED_LOAD;
 	tunables->hispeed_freq = 0;
+	tunables->urgent_bypass = true;
 
 	switch (policy->cpu) {
 	default:
@@ -1325,6 +1378,7 @@ static int sugov_start(struct cpufreq_policy *policy)
 	sg_policy->work_in_progress		= false;
 	sg_policy->limits_changed		= false;
 	sg_policy->need_freq_update		= false;
+	sg_policy->urgent			= false;
 	sg_policy->cached_raw_freq		= 0;
 
 	for_each_cpu(cpu, policy->cpus) {
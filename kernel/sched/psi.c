@@ -131,6 +131,7 @@
 #include <linux/sched/loadavg.h>
 #include <linux/seq_file.h>
 #include <linux/proc_fs.h>
+#include <linux/mm.h>
 #include <linux/seqlock.h>
 #include <linux/uaccess.h>
 #include <linux/cgroup.h>
@@ -140,6 +141,7 @@
 #include <linux/file.h>
 #include <linux/poll.h>
 #include <linux/psi.h>
+#include <uapi/linux/psi.h>
 #include "sched.h"
 
 #define CREATE_TRACE_POINTS
@@ -1318,12 +1320,263 @@ static const struct file_operations psi_cpu_fops = {
 	.release        = psi_fop_release,
 };
 
+/*
+ * Fast memory stall signaling
+ *
+ * The averages and triggers above only look at the aggregated state
+ * every 2s or every window / UPDATES_PER_WINDOW, which is too coarse for
+ * a userspace killer racing a sudden allocation spike. A listener on
+ * /proc/pressure/memory_fast instead sets a stall budget and a short
+ * window ("<budget_us> <window_us>"). The time tasks spend in direct
+ * reclaim and direct compaction is accounted synchronously on every
+ * stall entry and exit, and the listener is woken with EPOLLPRI as soon
+ * as the summed stall time within the current window exceeds the budget.
+ * Allocators that keep failing re-enter the stall from the slowpath retry
+ * loop, so an overrun is noticed on the next entry without waiting for a
+ * stall to finish.
+ *
+ * The counters are published in a read-only page (struct psi_fast_stats)
+ * that the listener can mmap, so it does not need a read syscall to look
+ * at them after a wakeup.
+ */
+#define FAST_WINDOW_MIN_US 10000	/* Min window size is 10ms */
+#define FAST_WINDOW_MAX_US WINDOW_MIN_US
+
+struct psi_fast_listener {
+	struct list_head node;
+	struct page *page;
+	struct psi_fast_stats *stats;
+	bool fired;
+	int event;
+	wait_queue_head_t event_wait;
+};
+
+static DEFINE_STATIC_KEY_FALSE(psi_fast_armed);
+static DEFINE_SPINLOCK(psi_fast_lock);
+static LIST_HEAD(psi_fast_listeners);
+static unsigned int psi_fast_nr_stalling;
+static u64 psi_fast_last;
+
+static void psi_fast_update(u64 now, int change)
+{
+	struct psi_fast_listener *l;
+	u64 stalled;
+
+	lockdep_assert_held(&psi_fast_lock);
+
+	stalled = psi_fast_nr_stalling * (now - psi_fast_last);
+	psi_fast_last = now;
+	psi_fast_nr_stalling += change;
+
+	list_for_each_entry(l, &psi_fast_listeners, node) {
+		struct psi_fast_stats *st = l->stats;
+
+		WRITE_ONCE(st->seq, st->seq + 1);
+		smp_wmb();
+
+		if (now - st->window_start_ns >= st->window_ns) {
+			st->window_start_ns = now;
+			st->window_stall_ns = 0;
+			l->fired = false;
+		}
+		st->window_stall_ns += stalled;
+		st->total_stall_ns += stalled;
+		st->nr_stalling = psi_fast_nr_stalling;
+
+		/* Fire once per window, like the regular triggers */
+		if (!l->fired && st->window_stall_ns >= st->budget_ns) {
+			l->fired = true;
+			st->events++;
+			st->last_event_ns = now;
+			l->event = 1;
+			wake_up_interruptible(&l->event_wait);
+		}
+
+		smp_wmb();
+		WRITE_ONCE(st->seq, st->seq + 1);
+	}
+}
+
+/**
+ * psi_direct_stall_enter - mark the start of a direct reclaim/compaction stall
+ *
+ * Returns whether the stall is accounted, to be passed to
+ * psi_direct_stall_leave(). Nothing is done while there are no listeners.
+ */
+bool psi_direct_stall_enter(void)
+{
+	if (static_branch_likely(&psi_disabled))
+		return false;
+
+	if (!static_branch_unlikely(&psi_fast_armed))
+		return false;
+
+	spin_lock(&psi_fast_lock);
+	psi_fast_update(ktime_get_ns(), 1);
+	spin_unlock(&psi_fast_lock);
+
+	return true;
+}
+
+/**
+ * psi_direct_stall_leave - mark the end of a direct reclaim/compaction stall
+ * @counted: return value of the matching psi_direct_stall_enter()
+ */
+void psi_direct_stall_leave(bool counted)
+{
+	if (!counted)
+		return;
+
+	spin_lock(&psi_fast_lock);
+	psi_fast_update(ktime_get_ns(), -1);
+	spin_unlock(&psi_fast_lock);
+}
+
+static int psi_fast_open(struct inode *inode, struct file *file)
+{
+	file->private_data = NULL;
+	return 0;
+}
+
+static ssize_t psi_fast_write(struct file *file, const char __user *user_buf,
+			      size_t nbytes, loff_t *ppos)
+{
+	struct psi_fast_listener *l;
+	u32 budget_us, window_us;
+	char buf[32];
+	size_t buf_size;
+	u64 now;
+
+	if (static_branch_likely(&psi_disabled))
+		return -EOPNOTSUPP;
+
+	if (!nbytes)
+		return -EINVAL;
+
+	buf_size = min(nbytes, sizeof(buf));
+	if (copy_from_user(buf, user_buf, buf_size))
+		return -EFAULT;
+
+	buf[buf_size - 1] = '\0';
+
+	if (sscanf(buf, "%u %u", &budget_us, &window_us) != 2)
+		return -EINVAL;
+
+	if (window_us < FAST_WINDOW_MIN_US ||
+		window_us > FAST_WINDOW_MAX_US)
+		return -EINVAL;
+
+	if (!budget_us)
+		return -EINVAL;
+
+	l = kzalloc(sizeof(*l), GFP_KERNEL);
+	if (!l)
+		return -ENOMEM;
+
+	l->page = alloc_page(GFP_KERNEL | __GFP_ZERO);
+	if (!l->page) {
+		kfree(l);
+		return -ENOMEM;
+	}
+
+	l->stats = page_address(l->page);
+	l->stats->budget_ns = (u64)budget_us * NSEC_PER_USEC;
+	l->stats->window_ns = (u64)window_us * NSEC_PER_USEC;
+	init_waitqueue_head(&l->event_wait);
+
+	/* Allow only one listener per file descriptor */
+	if (cmpxchg(&file->private_data, NULL, l)) {
+		__free_page(l->page);
+		kfree(l);
+		return -EBUSY;
+	}
+
+	static_branch_inc(&psi_fast_armed);
+
+	spin_lock(&psi_fast_lock);
+	now = ktime_get_ns();
+	/* Flush the stall accrued so far to the existing listeners */
+	psi_fast_update(now, 0);
+	l->stats->window_start_ns = now;
+	l->stats->nr_stalling = psi_fast_nr_stalling;
+	list_add(&l->node, &psi_fast_listeners);
+	spin_unlock(&psi_fast_lock);
+
+	return nbytes;
+}
+
+static __poll_t psi_fast_poll(struct file *file, poll_table *wait)
+{
+	__poll_t ret = DEFAULT_POLLMASK;
+	struct psi_fast_listener *l;
+
+	if (static_branch_likely(&psi_disabled))
+		return DEFAULT_POLLMASK | EPOLLERR | EPOLLPRI;
+
+	l = smp_load_acquire(&file->private_data);
+	if (!l)
+		return DEFAULT_POLLMASK | EPOLLERR | EPOLLPRI;
+
+	poll_wait(file, &l->event_wait, wait);
+
+	if (cmpxchg(&l->event, 1, 0) == 1)
+		ret |= EPOLLPRI;
+
+	return ret;
+}
+
+static int psi_fast_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct psi_fast_listener *l = smp_load_acquire(&file->private_data);
+
+	if (!l)
+		return -EINVAL;
+
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	/* The mapping holds its own page reference past release */
+	return vm_insert_page(vma, vma->vm_start, l->page);
+}
+
+static int psi_fast_release(struct inode *inode, struct file *file)
+{
+	struct psi_fast_listener *l = file->private_data;
+
+	if (!l)
+		return 0;
+
+	spin_lock(&psi_fast_lock);
+	list_del(&l->node);
+	spin_unlock(&psi_fast_lock);
+
+	static_branch_dec(&psi_fast_armed);
+
+	__free_page(l->page);
+	kfree(l);
+	return 0;
+}
+
+static const struct file_operations psi_fast_fops = {
+	.open           = psi_fast_open,
+	.write          = psi_fast_write,
+	.poll           = psi_fast_poll,
+	.mmap           = psi_fast_mmap,
+	.release        = psi_fast_release,
+};
+
 static int __init psi_proc_init(void)
 {
 	proc_mkdir("pressure", NULL);
 	proc_create("pressure/io", 0, NULL, &psi_io_fops);
 	proc_create("pressure/memory", 0, NULL, &psi_memory_fops);
 	proc_create("pressure/cpu", 0, NULL, &psi_cpu_fops);
+	proc_create("pressure/memory_fast", 0, NULL, &psi_fast_fops);
 	return 0;
 }
 module_init(psi_proc_init);
@@ -124,6 +124,21 @@ struct walt_task_group {
 	bool colocate;
 	/* Controls whether further updates are allowed to the colocate flag */
 	bool colocate_update_disabled;
+	/* Demand prediction model used for the tasks of this cgroup */
+	unsigned int pred_model;
+};
+
+/*
+ * Models used to predict the busy time of a task in the next window:
+ * WALT_PRED_BUCKETS: most recent history entry of the busiest bucket seen
+ * WALT_PRED_EWMA: exponentially weighted average of the busy time
+ * WALT_PRED_MAX: maximum busy time seen over the history windows
+ */
+enum walt_pred_model {
+	WALT_PRED_BUCKETS,
+	WALT_PRED_EWMA,
+	WALT_PRED_MAX,
+	WALT_PRED_END,
 };
 
 struct walt_root_domain {
@@ -176,6 +191,7 @@ struct walt_rq {
 	struct load_subtractions load_subs[NUM_TRACKED_WINDOWS];
 	DECLARE_BITMAP_ARRAY(top_tasks_bitmap,
 			NUM_TRACKED_WINDOWS, NUM_LOAD_INDICES);
+	unsigned long		top_tasks_summary[NUM_TRACKED_WINDOWS];
 	u8			*top_tasks[NUM_TRACKED_WINDOWS];
 	u8			curr_table;
 	int			prev_top;
@@ -2939,6 +2955,13 @@ struct walt_related_thread_group {
 	u64 last_update;
 	u64 downmigrate_ts;
 	u64 start_ts;
+	/* wakeups between members of the group */
+	u64 nr_wakeups;
+	u64 nr_cross_wakeups;
+	u32 win_wakeups;
+	u32 prev_win_wakeups;
+	u64 wakeup_win_start;
+	bool affine;
 };
 
 extern struct walt_sched_cluster *sched_cluster[NR_CPUS];
@@ -28,6 +28,7 @@ void walt_init_sched_boost(struct task_group *tg)
 	tg->wtg.sched_boost_enabled = true;
 	tg->wtg.colocate = false;
 	tg->wtg.colocate_update_disabled = false;
+	tg->wtg.pred_model = WALT_PRED_BUCKETS;
 }
 
 static void update_cgroup_boost_settings(void)
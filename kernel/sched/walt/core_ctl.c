@@ -8,6 +8,7 @@
 #include <linux/cpu.h>
 #include <linux/cpumask.h>
 #include <linux/cpufreq.h>
+#include <linux/irq_work.h>
 #include <linux/kthread.h>
 #include <linux/sched.h>
 #include <linux/sched/rt.h>
@@ -49,6 +50,14 @@ struct cluster_data {
 	unsigned int boost;
 	struct kobject kobj;
 	unsigned int strict_nrrun;
+	bool predict;
+	int nrrun_growth;
+	unsigned int nrrun_ramp_thres;
+	unsigned int sched_lat_thres_us;
+	atomic_t fast_pending;
+	struct irq_work fast_work;
+	unsigned int nr_pred_unisolate;
+	unsigned int nr_fast_unisolate;
 };
 
 struct cpu_data {
@@ -71,6 +80,8 @@ static unsigned int num_clusters;
 
 
 static DEFINE_SPINLOCK(state_lock);
+/* CPUs isolated on behalf of the hypervisor, see core_ctl_set_reserved_cpus */
+static cpumask_t hyp_reserved_cpus;
 static void apply_need(struct cluster_data *state);
 static void wake_up_core_ctl_thread(struct cluster_data *state);
 static bool initialized;
@@ -176,6 +187,67 @@ static ssize_t store_nr_prev_assist_thresh(struct cluster_data *state,
 	return count;
 }
 
+static ssize_t store_predict(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	state->predict = !!val;
+	apply_need(state);
+
+	return count;
+}
+
+static ssize_t show_predict(const struct cluster_data *state, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->predict);
+}
+
+static ssize_t store_nrrun_ramp_thres(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	if (!val)
+		return -EINVAL;
+
+	state->nrrun_ramp_thres = val;
+	apply_need(state);
+
+	return count;
+}
+
+static ssize_t show_nrrun_ramp_thres(const struct cluster_data *state,
+				     char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->nrrun_ramp_thres);
+}
+
+static ssize_t store_sched_lat_thres_us(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	state->sched_lat_thres_us = val;
+
+	return count;
+}
+
+static ssize_t show_sched_lat_thres_us(const struct cluster_data *state,
+				       char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->sched_lat_thres_us);
+}
+
 static ssize_t show_offline_delay_ms(const struct cluster_data *state,
 				     char *buf)
 {
@@ -330,6 +402,15 @@ static ssize_t show_global_state(const struct cluster_data *state, char *buf)
 						cluster->nr_isolated_cpus);
 		count += snprintf(buf + count, PAGE_SIZE - count,
 				"\tBoost: %u\n", (unsigned int) cluster->boost);
+		count += snprintf(buf + count, PAGE_SIZE - count,
+				"\tNr running growth: %d\n",
+						cluster->nrrun_growth);
+		count += snprintf(buf + count, PAGE_SIZE - count,
+				"\tPredicted unisolations: %u\n",
+						cluster->nr_pred_unisolate);
+		count += snprintf(buf + count, PAGE_SIZE - count,
+				"\tLatency unisolations: %u\n",
+						cluster->nr_fast_unisolate);
 	}
 	spin_unlock_irq(&state_lock);
 
@@ -421,6 +502,9 @@ core_ctl_attr_ro(active_cpus);
 core_ctl_attr_ro(global_state);
 core_ctl_attr_rw(not_preferred);
 core_ctl_attr_rw(enable);
+core_ctl_attr_rw(predict);
+core_ctl_attr_rw(nrrun_ramp_thres);
+core_ctl_attr_rw(sched_lat_thres_us);
 
 static struct attribute *default_attrs[] = {
 	&min_cpus.attr,
@@ -435,6 +519,9 @@ static struct attribute *default_attrs[] = {
 	&active_cpus.attr,
 	&global_state.attr,
 	&not_preferred.attr,
+	&predict.attr,
+	&nrrun_ramp_thres.attr,
+	&sched_lat_thres_us.attr,
 	NULL
 };
 
@@ -702,7 +789,7 @@ static void update_running_avg(void)
 
 	spin_lock_irqsave(&state_lock, flags);
 	for_each_cluster(cluster, index) {
-		int nr_need, prev_misfit_need;
+		int nr_need, prev_misfit_need, nrrun;
 
 		if (!cluster->inited)
 			continue;
@@ -710,8 +797,9 @@ static void update_running_avg(void)
 		nr_need = compute_cluster_nr_need(index);
 		prev_misfit_need = compute_prev_cluster_misfit_need(index);
 
-
-		cluster->nrrun = nr_need + prev_misfit_need;
+		nrrun = nr_need + prev_misfit_need;
+		cluster->nrrun_growth = nrrun - cluster->nrrun;
+		cluster->nrrun = nrrun;
 		cluster->max_nr = compute_cluster_max_nr(index);
 		cluster->max_nr_avg = compute_cluster_average_max_nr(index, cluster->max_nr);
 		cluster->nr_prev_assist = prev_cluster_nr_need_assist(index);
@@ -733,7 +821,7 @@ static void update_running_avg(void)
 
 #define MAX_NR_THRESHOLD	4
 /* adjust needed CPUs based on current runqueue information */
-static unsigned int apply_task_need(const struct cluster_data *cluster,
+static unsigned int apply_task_need(struct cluster_data *cluster,
 				    unsigned int new_need)
 {
 	/* unisolate all cores if there are enough tasks */
@@ -768,6 +856,18 @@ static unsigned int apply_task_need(const struct cluster_data *cluster,
 	if (new_need < cluster->strict_nrrun)
 		new_need = cluster->strict_nrrun;
 
+	/*
+	 * In predict mode, a runqueue that grew by nrrun_ramp_thres or
+	 * more over the last window is expected to keep growing at the
+	 * same rate, so bring in the CPUs for the next window now
+	 * instead of one window late.
+	 */
+	if (cluster->predict &&
+	    cluster->nrrun_growth >= (int)cluster->nrrun_ramp_thres) {
+		new_need = new_need + cluster->nrrun_growth;
+		cluster->nr_pred_unisolate++;
+	}
+
 	return new_need;
 }
 
@@ -948,6 +1048,40 @@ void core_ctl_notifier_unregister(struct notifier_block *n)
 	atomic_notifier_chain_unregister(&core_ctl_notifier, n);
 }
 
+/*
+ * hyp_core_ctl reports the CPUs it isolated for the guest VM here. We
+ * neither isolate them ourselves (e.g. a reserved CPU coming online
+ * before hyp_core_ctl gets to it) nor try to unisolate them to meet the
+ * host need, since they would not become available to the host anyway.
+ */
+void core_ctl_set_reserved_cpus(const struct cpumask *mask)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&state_lock, flags);
+	cpumask_copy(&hyp_reserved_cpus, mask);
+	spin_unlock_irqrestore(&state_lock, flags);
+}
+
+/*
+ * The CPUs isolated by core_ctl are not used by the host, so they are the
+ * cheapest ones for hyp_core_ctl to hand to the guest VM.
+ */
+void core_ctl_get_isolated_cpus(struct cpumask *mask)
+{
+	unsigned long flags;
+	unsigned int cpu;
+
+	cpumask_clear(mask);
+
+	spin_lock_irqsave(&state_lock, flags);
+	for_each_possible_cpu(cpu) {
+		if (per_cpu(cpu_state, cpu).isolated_by_us)
+			cpumask_set_cpu(cpu, mask);
+	}
+	spin_unlock_irqrestore(&state_lock, flags);
+}
+
 static void core_ctl_call_notifier(void)
 {
 	struct core_ctl_notif_data ndata = {0};
@@ -1011,6 +1145,77 @@ void core_ctl_check(u64 window_start)
 	core_ctl_call_notifier();
 }
 
+/*
+ * Fast path of the predict mode. The tick checks how long the first task
+ * in the CFS runqueue has been waiting; when that is over
+ * sched_lat_thres_us and the cluster has isolated CPUs, one more CPU is
+ * asked for right away instead of at the next window rollover. The tick
+ * holds the rq lock, so the core_ctl thread is woken from an irq work.
+ */
+static void core_ctl_fast_unisolate(struct irq_work *work)
+{
+	struct cluster_data *cluster = container_of(work, struct cluster_data,
+						    fast_work);
+	unsigned long flags;
+	bool wake = false;
+
+	spin_lock_irqsave(&state_lock, flags);
+	if (cluster->enable && cluster->nr_isolated_cpus &&
+	    cluster->need_cpus < cluster->max_cpus) {
+		cluster->need_cpus = min(max(cluster->need_cpus,
+					     cluster->active_cpus + 1),
+					 cluster->max_cpus);
+		cluster->need_ts = ktime_to_ms(ktime_get());
+		cluster->nr_fast_unisolate++;
+		wake = true;
+	}
+	spin_unlock_irqrestore(&state_lock, flags);
+
+	atomic_set(&cluster->fast_pending, 0);
+
+	if (wake)
+		wake_up_core_ctl_thread(cluster);
+}
+
+void core_ctl_tick(struct rq *rq, u64 wallclock)
+{
+	struct cluster_data *cluster = per_cpu(cpu_state, cpu_of(rq)).cluster;
+	struct sched_entity *se;
+	struct task_struct *p;
+	u64 waiting_since;
+
+	if (unlikely(!initialized))
+		return;
+
+	if (!cluster || !cluster->inited || !cluster->predict ||
+	    !cluster->sched_lat_thres_us || !cluster->nr_isolated_cpus)
+		return;
+
+	if (rq->cfs.h_nr_running < 2)
+		return;
+
+	se = __pick_first_entity(&rq->cfs);
+	if (!se || !entity_is_task(se))
+		return;
+
+	p = container_of(se, struct task_struct, se);
+	if (p == rq->curr)
+		return;
+
+	/*
+	 * A preempted task keeps its wakeup enqueue time, but its
+	 * mark_start is updated when it is put back.
+	 */
+	waiting_since = max(p->wts.last_enqueued_ts, p->wts.mark_start);
+	if (wallclock < waiting_since ||
+	    wallclock - waiting_since <
+			(u64)cluster->sched_lat_thres_us * NSEC_PER_USEC)
+		return;
+
+	if (!atomic_cmpxchg(&cluster->fast_pending, 0, 1))
+		irq_work_queue(&cluster->fast_work);
+}
+
 static void move_cpu_lru(struct cpu_data *cpu_data)
 {
 	unsigned long flags;
@@ -1045,6 +1250,8 @@ static void try_to_isolate(struct cluster_data *cluster, unsigned int need)
 
 		if (!is_active(c))
 			continue;
+		if (cpumask_test_cpu(c->cpu, &hyp_reserved_cpus))
+			continue;
 		if (cluster->active_cpus == need)
 			break;
 		/* Don't isolate busy CPUs. */
@@ -1095,6 +1302,8 @@ static void try_to_isolate(struct cluster_data *cluster, unsigned int need)
 
 		if (!is_active(c))
 			continue;
+		if (cpumask_test_cpu(c->cpu, &hyp_reserved_cpus))
+			continue;
 		if (cluster->active_cpus <= cluster->max_cpus)
 			break;
 
@@ -1142,6 +1351,8 @@ static void __try_to_unisolate(struct cluster_data *cluster,
 
 		if (!c->isolated_by_us)
 			continue;
+		if (!force && cpumask_test_cpu(c->cpu, &hyp_reserved_cpus))
+			continue;
 		if ((cpu_online(c->cpu) && !cpu_isolated(c->cpu)) ||
 			(!force && c->not_preferred))
 			continue;
@@ -1338,6 +1549,9 @@ static int cluster_init(const struct cpumask *mask)
 	cluster->enable = true;
 	cluster->nr_not_preferred_cpus = 0;
 	cluster->strict_nrrun = 0;
+	cluster->nrrun_ramp_thres = 2;
+	cluster->sched_lat_thres_us = 4000;
+	init_irq_work(&cluster->fast_work, core_ctl_fast_unisolate);
 	INIT_LIST_HEAD(&cluster->lru);
 	spin_lock_init(&cluster->pending_lock);
 
@@ -8,7 +8,9 @@
 #include <linux/init.h>
 #include <linux/cpufreq.h>
 #include <linux/cpu.h>
+#include <linux/cgroup.h>
 #include <linux/sched.h>
+#include <linux/sched/cpu_boost.h>
 #include <linux/slab.h>
 #include <linux/input.h>
 #include <linux/time.h>
@@ -42,6 +44,7 @@ struct cpu_sync {
 	int cpu;
 	unsigned int input_boost_min;
 	unsigned int input_boost_freq;
+	unsigned int req_boost_min;
 };
 
 static DEFINE_PER_CPU(struct cpu_sync, sync_info);
@@ -69,6 +72,11 @@ static u64 last_input_time;
 
 static DEFINE_PER_CPU(struct freq_qos_request, qos_req);
 
+static LIST_HEAD(boost_reqs);
+static DEFINE_SPINLOCK(boost_req_lock);
+static struct delayed_work boost_req_work;
+static struct cpu_boost_req user_boost_req = { .name = "user" };
+
 static ssize_t store_input_boost_freq(struct kobject *kobj,
 				      struct kobj_attribute *attr,
 				      const char *buf, size_t count)
@@ -139,7 +147,7 @@ static void boost_adjust_notify(struct cpufreq_policy *policy)
 {
 	unsigned int cpu = policy->cpu;
 	struct cpu_sync *s = &per_cpu(sync_info, cpu);
-	unsigned int ib_min = s->input_boost_min;
+	unsigned int ib_min = max(s->input_boost_min, s->req_boost_min);
 	struct freq_qos_request *req = &per_cpu(qos_req, cpu);
 	int ret;
 
@@ -239,6 +247,215 @@ static void do_input_boost(struct work_struct *work)
 					msecs_to_jiffies(input_boost_ms));
 }
 
+static inline bool boost_req_active(struct cpu_boost_req *req)
+{
+	return req->list.next && !list_empty(&req->list);
+}
+
+/*
+ * Fold the active requests into req_boost_min of each CPU, drop the
+ * expired ones and come back when the next one expires.
+ */
+static void do_boost_req_update(struct work_struct *work)
+{
+	struct cpu_boost_req *req, *tmp;
+	unsigned long now = jiffies, next = 0;
+	unsigned long flags;
+	bool pending = false;
+	unsigned int cpu;
+
+	spin_lock_irqsave(&boost_req_lock, flags);
+	for_each_possible_cpu(cpu)
+		per_cpu(sync_info, cpu).req_boost_min = 0;
+
+	list_for_each_entry_safe(req, tmp, &boost_reqs, list) {
+		if (time_after_eq(now, req->expires)) {
+			list_del_init(&req->list);
+			continue;
+		}
+
+		for_each_cpu(cpu, &req->cpus) {
+			struct cpu_sync *s = &per_cpu(sync_info, cpu);
+
+			s->req_boost_min = max(s->req_boost_min, req->freq);
+		}
+
+		if (!pending || time_before(req->expires, next))
+			next = req->expires;
+		pending = true;
+	}
+	spin_unlock_irqrestore(&boost_req_lock, flags);
+
+	update_policy_online();
+
+	if (pending)
+		mod_delayed_work(cpu_boost_wq, &boost_req_work, next - now);
+}
+
+/**
+ * cpu_boost_update_request() - add or refresh a frequency floor request
+ * @req: request, zero initialized by the caller before the first use
+ * @cpus: CPUs to boost, NULL for all of them
+ * @freq: minimum frequency in kHz, 0 removes the request
+ * @duration_ms: lifetime of the request, 0 removes the request
+ *
+ * Can be called from atomic context. Updating an active request replaces
+ * its CPUs, floor and expiry.
+ */
+int cpu_boost_update_request(struct cpu_boost_req *req,
+			     const struct cpumask *cpus, unsigned int freq,
+			     unsigned int duration_ms)
+{
+	unsigned long flags;
+
+	if (!cpu_boost_wq)
+		return -ENODEV;
+
+	if (!freq || !duration_ms) {
+		cpu_boost_remove_request(req);
+		return 0;
+	}
+
+	spin_lock_irqsave(&boost_req_lock, flags);
+	cpumask_and(&req->cpus, cpus ? cpus : cpu_possible_mask,
+		    cpu_possible_mask);
+	req->freq = freq;
+	req->expires = jiffies + msecs_to_jiffies(duration_ms);
+	if (!boost_req_active(req))
+		list_add_tail(&req->list, &boost_reqs);
+	spin_unlock_irqrestore(&boost_req_lock, flags);
+
+	mod_delayed_work(cpu_boost_wq, &boost_req_work, 0);
+
+	return 0;
+}
+EXPORT_SYMBOL(cpu_boost_update_request);
+
+void cpu_boost_remove_request(struct cpu_boost_req *req)
+{
+	unsigned long flags;
+	bool removed = false;
+
+	spin_lock_irqsave(&boost_req_lock, flags);
+	if (boost_req_active(req)) {
+		list_del_init(&req->list);
+		removed = true;
+	}
+	spin_unlock_irqrestore(&boost_req_lock, flags);
+
+	if (removed)
+		mod_delayed_work(cpu_boost_wq, &boost_req_work, 0);
+}
+EXPORT_SYMBOL(cpu_boost_remove_request);
+
+/*
+ * Placement boosts use the per-task boost of WALT, which already expires
+ * on its own. A stronger boost wins and the later expiry is kept. A boost
+ * the task set on itself without a period is left alone if it is at
+ * least as strong.
+ */
+static void __cpu_boost_task(struct task_struct *p, int boost, u64 expires)
+{
+	u64 now = sched_clock();
+	int cur = per_task_boost(p);
+
+	if (cur) {
+		if (!p->wts.boost_period && cur >= boost)
+			return;
+		if (p->wts.boost_period)
+			expires = max(expires, p->wts.boost_expires);
+		boost = max(boost, cur);
+	}
+
+	p->wts.boost = boost;
+	p->wts.boost_expires = expires;
+	p->wts.boost_period = expires - now;
+}
+
+int cpu_boost_task(struct task_struct *p, int boost, unsigned int duration_ms)
+{
+	if (boost <= TASK_BOOST_NONE || boost >= TASK_BOOST_END ||
+	    !duration_ms)
+		return -EINVAL;
+
+	__cpu_boost_task(p, boost,
+			 sched_clock() + (u64)duration_ms * NSEC_PER_MSEC);
+
+	return 0;
+}
+EXPORT_SYMBOL(cpu_boost_task);
+
+/*
+ * Boost the tasks that are in @css now. Tasks that join the group later
+ * are not boosted. Must be called with interrupts enabled.
+ */
+int cpu_boost_css(struct cgroup_subsys_state *css, int boost,
+		  unsigned int duration_ms)
+{
+	struct css_task_iter it;
+	struct task_struct *p;
+	u64 expires;
+
+	if (boost <= TASK_BOOST_NONE || boost >= TASK_BOOST_END ||
+	    !duration_ms)
+		return -EINVAL;
+
+	expires = sched_clock() + (u64)duration_ms * NSEC_PER_MSEC;
+
+	css_task_iter_start(css, 0, &it);
+	while ((p = css_task_iter_next(&it)))
+		__cpu_boost_task(p, boost, expires);
+	css_task_iter_end(&it);
+
+	return 0;
+}
+EXPORT_SYMBOL(cpu_boost_css);
+
+/* <cpulist> <freq kHz> <duration ms>, e.g. "4-7 1804800 200" */
+static ssize_t store_boost_request(struct kobject *kobj,
+				   struct kobj_attribute *attr,
+				   const char *buf, size_t count)
+{
+	char list[64];
+	cpumask_t cpus;
+	unsigned int freq, duration_ms;
+	int ret;
+
+	if (sscanf(buf, "%63s %u %u", list, &freq, &duration_ms) != 3)
+		return -EINVAL;
+
+	if (cpulist_parse(list, &cpus))
+		return -EINVAL;
+
+	ret = cpu_boost_update_request(&user_boost_req, &cpus, freq,
+				       duration_ms);
+
+	return ret ? ret : count;
+}
+
+static ssize_t show_boost_request(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	struct cpu_boost_req *req;
+	unsigned long now = jiffies;
+	int cnt = 0;
+
+	spin_lock_irq(&boost_req_lock);
+	list_for_each_entry(req, &boost_reqs, list) {
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"%s cpus=%*pbl freq=%u remaining_ms=%u\n",
+				req->name ? req->name : "?",
+				cpumask_pr_args(&req->cpus), req->freq,
+				time_after(req->expires, now) ?
+				jiffies_to_msecs(req->expires - now) : 0);
+	}
+	spin_unlock_irq(&boost_req_lock);
+
+	return cnt;
+}
+
+cpu_boost_attr_rw(boost_request);
+
 static void cpuboost_input_event(struct input_handle *handle,
 		unsigned int type, unsigned int code, int value)
 {
@@ -343,6 +560,7 @@ int cpu_boost_init(void)
 
 	INIT_WORK(&input_boost_work, do_input_boost);
 	INIT_DELAYED_WORK(&input_boost_rem, do_input_boost_rem);
+	INIT_DELAYED_WORK(&boost_req_work, do_boost_req_update);
 
 	for_each_possible_cpu(cpu) {
 		s = &per_cpu(sync_info, cpu);
@@ -383,6 +601,10 @@ int cpu_boost_init(void)
 	if (ret)
 		pr_err("Failed to create sched_boost_on_input node: %d\n", ret);
 
+	ret = sysfs_create_file(cpu_boost_kobj, &boost_request_attr.attr);
+	if (ret)
+		pr_err("Failed to create boost_request node: %d\n", ret);
+
 	ret = input_register_handler(&cpuboost_input_handler);
 	return 0;
 }
@@ -327,6 +327,39 @@ int sched_group_id_open(struct inode *inode, struct file *filp)
 	return single_open(filp, sched_group_id_show, inode);
 }
 
+static int sched_pred_stats_show(struct seq_file *m, void *v)
+{
+	struct inode *inode = m->private;
+	struct task_struct *p;
+	int i;
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	seq_printf(m, "model: %u\n", walt_task_pred_model(p));
+	seq_printf(m, "demand: %u\n", p->wts.demand);
+	seq_printf(m, "pred_demand: %u\n", p->wts.pred_demand);
+	seq_puts(m, "history:");
+	for (i = 0; i < RAVG_HIST_SIZE_MAX; i++)
+		seq_printf(m, " %u", p->wts.sum_history[i]);
+	seq_puts(m, "\nbuckets:");
+	for (i = 0; i < NUM_BUSY_BUCKETS; i++)
+		seq_printf(m, " %u", p->wts.busy_buckets[i]);
+	seq_printf(m, "\nwindows: %u\nhits: %u\nunder: %u\n",
+		   p->wts.pred_windows, p->wts.pred_hits,
+		   p->wts.pred_under);
+
+	put_task_struct(p);
+
+	return 0;
+}
+
+int sched_pred_stats_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, sched_pred_stats_show, inode);
+}
+
 #ifdef CONFIG_SMP
 /*
  * Print out various scheduling related per-task fields:
@@ -385,6 +418,61 @@ int sched_wake_up_idle_open(struct inode *inode, struct file *filp)
 	return single_open(filp, sched_wake_up_idle_show, inode);
 }
 
+static int sched_wake_lat_show(struct seq_file *m, void *v)
+{
+	struct inode *inode = m->private;
+	struct task_struct *p;
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	seq_printf(m, "%u\n", p->wts.wake_lat_us);
+
+	put_task_struct(p);
+
+	return 0;
+}
+
+ssize_t
+sched_wake_lat_write(struct file *file, const char __user *buf,
+	    size_t count, loff_t *offset)
+{
+	struct inode *inode = file_inode(file);
+	struct task_struct *p;
+	char buffer[PROC_NUMBUF];
+	unsigned int lat_us;
+	int err;
+
+	memset(buffer, 0, sizeof(buffer));
+	if (count > sizeof(buffer) - 1)
+		count = sizeof(buffer) - 1;
+	if (copy_from_user(buffer, buf, count)) {
+		err = -EFAULT;
+		goto out;
+	}
+
+	err = kstrtouint(strstrip(buffer), 0, &lat_us);
+	if (err)
+		goto out;
+
+	p = get_proc_task(inode);
+	if (!p)
+		return -ESRCH;
+
+	err = sched_set_wake_lat(p, lat_us);
+
+	put_task_struct(p);
+
+out:
+	return err < 0 ? err : count;
+}
+
+int sched_wake_lat_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, sched_wake_lat_show, inode);
+}
+
 int group_balance_cpu_not_isolated(struct sched_group *sg)
 {
 	cpumask_t cpus;
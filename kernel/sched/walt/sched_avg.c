@@ -19,6 +19,9 @@ static DEFINE_PER_CPU(u64, last_time);
 static DEFINE_PER_CPU(u64, nr_big_prod_sum);
 static DEFINE_PER_CPU(u64, nr);
 static DEFINE_PER_CPU(u64, nr_max);
+/* never reset, so independent readers can sample deltas */
+static DEFINE_PER_CPU(u64, nr_run_total);
+static DEFINE_PER_CPU(u64, nr_wait_total);
 
 static DEFINE_PER_CPU(spinlock_t, nr_lock) = __SPIN_LOCK_UNLOCKED(nr_lock);
 static s64 last_get_time;
@@ -220,10 +223,38 @@ void sched_update_nr_prod(int cpu, long delta, bool inc)
 
 	per_cpu(nr_prod_sum, cpu) += nr_running * diff;
 	per_cpu(nr_big_prod_sum, cpu) += walt_big_tasks(cpu) * diff;
+	per_cpu(nr_run_total, cpu) += nr_running * diff;
+	if (nr_running > 1)
+		per_cpu(nr_wait_total, cpu) += (nr_running - 1) * diff;
 	spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
 }
 EXPORT_SYMBOL(sched_update_nr_prod);
 
+/**
+ * sched_get_nr_prod_total
+ * @cpu: The cpu to read
+ * @run: Returns the nr_running time product (task-ns) since boot
+ * @wait: Returns the task-ns spent runnable but not running since boot
+ *
+ * Unlike sched_get_nr_running_avg() this resets nothing, so any number
+ * of readers can sample it and work on the deltas.
+ */
+void sched_get_nr_prod_total(int cpu, u64 *run, u64 *wait)
+{
+	unsigned long flags, nr_running;
+	u64 diff;
+
+	spin_lock_irqsave(&per_cpu(nr_lock, cpu), flags);
+	nr_running = per_cpu(nr, cpu);
+	diff = sched_clock() - per_cpu(last_time, cpu);
+	*run = per_cpu(nr_run_total, cpu) + nr_running * diff;
+	*wait = per_cpu(nr_wait_total, cpu);
+	if (nr_running > 1)
+		*wait += (nr_running - 1) * diff;
+	spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
+}
+EXPORT_SYMBOL(sched_get_nr_prod_total);
+
 /*
  * Returns the CPU utilization % in the last window.
  *
@@ -248,6 +279,79 @@ unsigned int sched_get_cpu_util(int cpu)
 	return busy;
 }
 
+/*
+ * Tasks with a wakeup latency hint. The hint only constrains the idle
+ * state of the CPU the task last ran on, which is also where the prev_cpu
+ * fast path of the wakeup placement puts it back, instead of all CPUs as
+ * a PM QoS request would.
+ */
+#define WAKE_LAT_MAX_TASKS	16
+
+static struct task_struct *wake_lat_tasks[WAKE_LAT_MAX_TASKS];
+static unsigned int nr_wake_lat_tasks;
+static DEFINE_RAW_SPINLOCK(wake_lat_lock);
+
+int sched_set_wake_lat(struct task_struct *p, u32 lat_us)
+{
+	unsigned long flags;
+	int i, free = -1, ret = 0;
+	bool put = false;
+
+	raw_spin_lock_irqsave(&wake_lat_lock, flags);
+	for (i = 0; i < WAKE_LAT_MAX_TASKS; i++) {
+		if (wake_lat_tasks[i] == p)
+			break;
+		if (!wake_lat_tasks[i] && free < 0)
+			free = i;
+	}
+
+	if (!lat_us) {
+		if (i < WAKE_LAT_MAX_TASKS) {
+			wake_lat_tasks[i] = NULL;
+			nr_wake_lat_tasks--;
+			put = true;
+		}
+	} else if (i == WAKE_LAT_MAX_TASKS) {
+		if (free < 0) {
+			ret = -ENOSPC;
+			goto unlock;
+		}
+		get_task_struct(p);
+		wake_lat_tasks[free] = p;
+		nr_wake_lat_tasks++;
+	}
+	p->wts.wake_lat_us = lat_us;
+
+unlock:
+	raw_spin_unlock_irqrestore(&wake_lat_lock, flags);
+	if (put)
+		put_task_struct(p);
+	return ret;
+}
+
+/* Tightest wakeup latency hint of the tasks that last ran on @cpu */
+u32 sched_cpu_wake_lat_us(int cpu)
+{
+	u32 lat = U32_MAX;
+	unsigned long flags;
+	int i;
+
+	if (!READ_ONCE(nr_wake_lat_tasks))
+		return lat;
+
+	raw_spin_lock_irqsave(&wake_lat_lock, flags);
+	for (i = 0; i < WAKE_LAT_MAX_TASKS; i++) {
+		struct task_struct *p = wake_lat_tasks[i];
+
+		if (p && task_cpu(p) == cpu)
+			lat = min(lat, p->wts.wake_lat_us);
+	}
+	raw_spin_unlock_irqrestore(&wake_lat_lock, flags);
+
+	return lat;
+}
+EXPORT_SYMBOL(sched_cpu_wake_lat_us);
+
 u64 sched_lpm_disallowed_time(int cpu)
 {
 	u64 now = sched_clock();
@@ -654,6 +654,28 @@ TRACE_EVENT(sched_ravg_window_change,
 		__entry->change_time)
 );
 
+TRACE_EVENT(walt_irq_work,
+
+	TP_PROTO(bool is_migration, u64 duration, u64 max_hold),
+
+	TP_ARGS(is_migration, duration, max_hold),
+
+	TP_STRUCT__entry(
+		__field(bool, is_migration)
+		__field(u64, duration)
+		__field(u64, max_hold)
+	),
+
+	TP_fast_assign(
+		__entry->is_migration = is_migration;
+		__entry->duration = duration;
+		__entry->max_hold = max_hold;
+	),
+
+	TP_printk("is_migration=%d duration=%llu max_rq_lock_hold=%llu",
+		__entry->is_migration, __entry->duration, __entry->max_hold)
+);
+
 TRACE_EVENT(walt_window_rollover,
 
 	TP_PROTO(u64 window_start),
@@ -5,6 +5,8 @@
 #include <linux/syscore_ops.h>
 #include <linux/cpufreq.h>
 #include <linux/list_sort.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 #include <linux/jiffies.h>
 #include <linux/sched/stat.h>
 #include <trace/events/sched.h>
@@ -736,14 +738,41 @@ static inline void create_subtraction_entry(struct rq *rq, u64 ws, int index)
 	rq->wrq.load_subs[index].new_subs = 0;
 }
 
-static int get_top_index(unsigned long *bitmap, unsigned long old_top)
+/*
+ * The top tasks bitmap is stored in reverse, so the highest index is the
+ * first set bit. Bit i of top_tasks_summary says that word i of the bitmap
+ * is not empty, which makes the lookup two __ffs() instead of a scan of
+ * the whole bitmap. The sentinel bit at NUM_LOAD_INDICES is always set,
+ * so the summary is never empty.
+ */
+static inline void top_tasks_set_bit(struct rq *rq, u8 table, int index)
+{
+	int bit = NUM_LOAD_INDICES - index - 1;
+
+	__set_bit(bit, rq->wrq.top_tasks_bitmap[table]);
+	__set_bit(BIT_WORD(bit), &rq->wrq.top_tasks_summary[table]);
+}
+
+static inline void top_tasks_clear_bit(struct rq *rq, u8 table, int index)
+{
+	int bit = NUM_LOAD_INDICES - index - 1;
+	unsigned long *bitmap = rq->wrq.top_tasks_bitmap[table];
+
+	__clear_bit(bit, bitmap);
+	if (!bitmap[BIT_WORD(bit)])
+		__clear_bit(BIT_WORD(bit), &rq->wrq.top_tasks_summary[table]);
+}
+
+static int get_top_index(struct rq *rq, u8 table)
 {
-	int index = find_next_bit(bitmap, NUM_LOAD_INDICES, old_top);
+	unsigned long *bitmap = rq->wrq.top_tasks_bitmap[table];
+	unsigned long word = __ffs(rq->wrq.top_tasks_summary[table]);
+	unsigned long bit = word * BITS_PER_LONG + __ffs(bitmap[word]);
 
-	if (index == NUM_LOAD_INDICES)
+	if (bit >= NUM_LOAD_INDICES)
 		return 0;
 
-	return NUM_LOAD_INDICES - 1 - index;
+	return NUM_LOAD_INDICES - 1 - bit;
 }
 
 static bool get_subtraction_index(struct rq *rq, u64 ws)
@@ -912,20 +941,17 @@ migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 		dst_table[index] += 1;
 
 		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->wrq.top_tasks_bitmap[src]);
+			top_tasks_clear_bit(src_rq, src, index);
 
 		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->wrq.top_tasks_bitmap[dst]);
+			top_tasks_set_bit(dst_rq, dst, index);
 
 		if (index > dst_rq->wrq.curr_top)
 			dst_rq->wrq.curr_top = index;
 
 		top_index = src_rq->wrq.curr_top;
 		if (index == top_index && !src_table[index])
-			src_rq->wrq.curr_top = get_top_index(
-				src_rq->wrq.top_tasks_bitmap[src], top_index);
+			src_rq->wrq.curr_top = get_top_index(src_rq, src);
 	}
 
 	if (prev_window) {
@@ -938,20 +964,17 @@ migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 		dst_table[index] += 1;
 
 		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->wrq.top_tasks_bitmap[src]);
+			top_tasks_clear_bit(src_rq, src, index);
 
 		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->wrq.top_tasks_bitmap[dst]);
+			top_tasks_set_bit(dst_rq, dst, index);
 
 		if (index > dst_rq->wrq.prev_top)
 			dst_rq->wrq.prev_top = index;
 
 		top_index = src_rq->wrq.prev_top;
 		if (index == top_index && !src_table[index])
-			src_rq->wrq.prev_top = get_top_index(
-				src_rq->wrq.top_tasks_bitmap[src], top_index);
+			src_rq->wrq.prev_top = get_top_index(src_rq, src);
 	}
 }
 
@@ -1244,11 +1267,24 @@ static u32 get_pred_busy(struct task_struct *p,
 	return ret;
 }
 
+unsigned int walt_task_pred_model(struct task_struct *p)
+{
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	return READ_ONCE(task_group(p)->wtg.pred_model);
+#else
+	return WALT_PRED_BUCKETS;
+#endif
+}
+
 static inline u32 calc_pred_demand(struct task_struct *p)
 {
 	if (p->wts.pred_demand >= p->wts.curr_window)
 		return p->wts.pred_demand;
 
+	/* only the bucket model looks ahead of the busy time seen so far */
+	if (walt_task_pred_model(p) != WALT_PRED_BUCKETS)
+		return p->wts.curr_window;
+
 	return get_pred_busy(p, busy_to_bucket(p->wts.curr_window),
 			     p->wts.curr_window);
 }
@@ -1301,15 +1337,33 @@ void update_task_pred_demand(struct rq *rq, struct task_struct *p, int event)
 	p->wts.pred_demand_scaled = new_scaled;
 }
 
-void clear_top_tasks_bitmap(unsigned long *bitmap)
+/*
+ * Only the buckets that have their bit set can be non-zero, so walk the
+ * non-empty bitmap words instead of clearing the whole table. A rq rarely
+ * has more than a handful of tasks in a window, against NUM_LOAD_INDICES
+ * buckets.
+ */
+static void clear_top_tasks(struct rq *rq, u8 table)
 {
-	memset(bitmap, 0, top_tasks_bitmap_size);
-	__set_bit(NUM_LOAD_INDICES, bitmap);
-}
+	unsigned long *bitmap = rq->wrq.top_tasks_bitmap[table];
+	unsigned long summary = rq->wrq.top_tasks_summary[table];
+	u8 *tt = rq->wrq.top_tasks[table];
+	unsigned long word, bit;
 
-static inline void clear_top_tasks_table(u8 *table)
-{
-	memset(table, 0, NUM_LOAD_INDICES * sizeof(u8));
+	for_each_set_bit(word, &summary, BITS_PER_LONG) {
+		for_each_set_bit(bit, &bitmap[word], BITS_PER_LONG) {
+			unsigned long nr = word * BITS_PER_LONG + bit;
+
+			if (nr < NUM_LOAD_INDICES)
+				tt[NUM_LOAD_INDICES - 1 - nr] = 0;
+		}
+		bitmap[word] = 0;
+	}
+
+	rq->wrq.top_tasks_summary[table] = 0;
+	__set_bit(NUM_LOAD_INDICES, bitmap);
+	__set_bit(BIT_WORD(NUM_LOAD_INDICES),
+			&rq->wrq.top_tasks_summary[table]);
 }
 
 static void update_top_tasks(struct task_struct *p, struct rq *rq,
@@ -1342,12 +1396,10 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 		}
 
 		if (!curr_table[old_index])
-			__clear_bit(NUM_LOAD_INDICES - old_index - 1,
-				rq->wrq.top_tasks_bitmap[curr]);
+			top_tasks_clear_bit(rq, curr, old_index);
 
 		if (curr_table[new_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - new_index - 1,
-				rq->wrq.top_tasks_bitmap[curr]);
+			top_tasks_set_bit(rq, curr, new_index);
 
 		return;
 	}
@@ -1374,8 +1426,7 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 		}
 
 		if (prev_table[update_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - update_index - 1,
-				rq->wrq.top_tasks_bitmap[prev]);
+			top_tasks_set_bit(rq, prev, update_index);
 	} else {
 		zero_index_update = !old_curr_window && prev_window;
 		if (old_index != update_index || zero_index_update) {
@@ -1388,12 +1439,10 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 				rq->wrq.prev_top = update_index;
 
 			if (!prev_table[old_index])
-				__clear_bit(NUM_LOAD_INDICES - old_index - 1,
-						rq->wrq.top_tasks_bitmap[prev]);
+				top_tasks_clear_bit(rq, prev, old_index);
 
 			if (prev_table[update_index] == 1)
-				__set_bit(NUM_LOAD_INDICES - update_index - 1,
-						rq->wrq.top_tasks_bitmap[prev]);
+				top_tasks_set_bit(rq, prev, update_index);
 		}
 	}
 
@@ -1404,8 +1453,7 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 			rq->wrq.curr_top = new_index;
 
 		if (curr_table[new_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - new_index - 1,
-				rq->wrq.top_tasks_bitmap[curr]);
+			top_tasks_set_bit(rq, curr, new_index);
 	}
 }
 
@@ -1415,14 +1463,11 @@ static void rollover_top_tasks(struct rq *rq, bool full_window)
 	u8 prev_table = 1 - curr_table;
 	int curr_top = rq->wrq.curr_top;
 
-	clear_top_tasks_table(rq->wrq.top_tasks[prev_table]);
-	clear_top_tasks_bitmap(rq->wrq.top_tasks_bitmap[prev_table]);
+	clear_top_tasks(rq, prev_table);
 
 	if (full_window) {
 		curr_top = 0;
-		clear_top_tasks_table(rq->wrq.top_tasks[curr_table]);
-		clear_top_tasks_bitmap(
-				rq->wrq.top_tasks_bitmap[curr_table]);
+		clear_top_tasks(rq, curr_table);
 	}
 
 	rq->wrq.curr_table = prev_table;
@@ -1801,17 +1846,62 @@ static void update_cpu_busy_time(struct task_struct *p, struct rq *rq,
 }
 
 
+#define WALT_PRED_EWMA_SHIFT	2
+
+/*
+ * Account how well the last prediction matched the busy time of the window
+ * that just completed. A prediction within one bucket counts as a hit.
+ */
+static inline void update_pred_stats(struct task_struct *p, u32 runtime)
+{
+	u32 pred = p->wts.pred_demand;
+	u32 err = pred > runtime ? pred - runtime : runtime - pred;
+
+	if (!pred)
+		return;
+
+	p->wts.pred_windows++;
+	if (err < max_task_load() / NUM_BUSY_BUCKETS)
+		p->wts.pred_hits++;
+	if (pred < runtime)
+		p->wts.pred_under++;
+}
+
 static inline u32 predict_and_update_buckets(
 			struct task_struct *p, u32 runtime) {
 
-	int bidx;
-	u32 pred_demand;
+	int bidx, i;
+	u32 pred_demand = 0;
+	u64 ewma;
 
 	if (!sched_predl)
 		return 0;
 
+	update_pred_stats(p, runtime);
+
 	bidx = busy_to_bucket(runtime);
-	pred_demand = get_pred_busy(p, bidx, runtime);
+
+	switch (walt_task_pred_model(p)) {
+	case WALT_PRED_EWMA:
+		if (!p->wts.pred_demand) {
+			pred_demand = runtime;
+			break;
+		}
+		ewma = ((u64)p->wts.pred_demand << WALT_PRED_EWMA_SHIFT) -
+			p->wts.pred_demand + runtime;
+		pred_demand = ewma >> WALT_PRED_EWMA_SHIFT;
+		break;
+	case WALT_PRED_MAX:
+		/* runtime is already part of the history */
+		for (i = 0; i < sched_ravg_hist_size; i++)
+			pred_demand = max(pred_demand, p->wts.sum_history[i]);
+		break;
+	default:
+		pred_demand = get_pred_busy(p, bidx, runtime);
+		break;
+	}
+
+	/* keep the buckets current so switching models starts warm */
 	bucket_increase(p->wts.busy_buckets, bidx);
 
 	return pred_demand;
@@ -2225,6 +2315,9 @@ void init_new_task_load(struct task_struct *p)
 	p->wts.active_time = 0;
 	for (i = 0; i < NUM_BUSY_BUCKETS; ++i)
 		p->wts.busy_buckets[i] = 0;
+	p->wts.pred_windows = 0;
+	p->wts.pred_hits = 0;
+	p->wts.pred_under = 0;
 
 	p->wts.cpu_cycles = 0;
 
@@ -2271,6 +2364,9 @@ void free_task_load_ptrs(struct task_struct *p)
 
 void walt_task_dead(struct task_struct *p)
 {
+	if (p->wts.wake_lat_us)
+		sched_set_wake_lat(p, 0);
+
 	sched_set_group_id(p, 0);
 	free_task_load_ptrs(p);
 }
@@ -2297,6 +2393,9 @@ void reset_task_stats(struct task_struct *p)
 	p->wts.pred_demand = 0;
 	for (i = 0; i < NUM_BUSY_BUCKETS; ++i)
 		p->wts.busy_buckets[i] = 0;
+	p->wts.pred_windows = 0;
+	p->wts.pred_hits = 0;
+	p->wts.pred_under = 0;
 	p->wts.demand_scaled = 0;
 	p->wts.pred_demand_scaled = 0;
 	p->wts.active_time = 0;
@@ -2750,6 +2849,13 @@ static void transfer_busy_time(struct rq *rq,
  */
 unsigned int __read_mostly sysctl_sched_coloc_downmigrate_ns;
 
+/*
+ * A group whose members woke each other up at least this many times in
+ * the last window is treated as a pipeline and kept on one cluster. 0
+ * disables it.
+ */
+unsigned int __read_mostly sysctl_sched_coloc_affine_wakeups;
+
 struct walt_related_thread_group
 			*related_thread_groups[MAX_NUM_CGROUP_COLOC_ID];
 static LIST_HEAD(active_related_thread_groups);
@@ -2771,12 +2877,23 @@ void update_best_cluster(struct walt_related_thread_group *grp,
 	if (is_suh_max())
 		demand = sched_group_upmigrate;
 
+	/*
+	 * An affine group moves up as soon as it no longer fits under the
+	 * downmigrate threshold and does not move down at all, so that
+	 * its members are not split and do not bounce between clusters
+	 * around the upmigrate threshold.
+	 */
 	if (!grp->skip_min) {
-		if (demand >= sched_group_upmigrate) {
+		if (demand >= sched_group_upmigrate ||
+		    (grp->affine && demand >= sched_group_downmigrate)) {
 			grp->skip_min = true;
 		}
 		return;
 	}
+	if (grp->affine) {
+		grp->downmigrate_ts = 0;
+		return;
+	}
 	if (demand < sched_group_downmigrate) {
 		if (!sysctl_sched_coloc_downmigrate_ns) {
 			grp->skip_min = false;
@@ -2840,6 +2957,14 @@ static void _set_preferred_cluster(struct walt_related_thread_group *grp)
 	if (wallclock - grp->last_update < sched_ravg_window / 10)
 		return;
 
+	if (wallclock - grp->wakeup_win_start >= sched_ravg_window) {
+		grp->prev_win_wakeups = grp->win_wakeups;
+		grp->win_wakeups = 0;
+		grp->wakeup_win_start = wallclock;
+	}
+	grp->affine = sysctl_sched_coloc_affine_wakeups &&
+		grp->prev_win_wakeups >= sysctl_sched_coloc_affine_wakeups;
+
 	list_for_each_entry(p, &grp->tasks, wts.grp_list) {
 		if (task_boost_policy(p) == SCHED_BOOST_ON_BIG) {
 			group_boost = true;
@@ -2877,6 +3002,50 @@ void set_preferred_cluster(struct walt_related_thread_group *grp)
 	raw_spin_unlock(&grp->lock);
 }
 
+/*
+ * Called from try_to_wake_up() with the CPU picked for @p. The counters
+ * are updated without the group lock, they are only a rate estimate.
+ */
+void walt_note_group_wakeup(struct task_struct *p, int cpu)
+{
+	struct walt_related_thread_group *grp;
+
+	rcu_read_lock();
+	grp = task_related_thread_group(p);
+	if (grp && grp == task_related_thread_group(current)) {
+		grp->nr_wakeups++;
+		grp->win_wakeups++;
+		if (!same_cluster(cpu, raw_smp_processor_id()))
+			grp->nr_cross_wakeups++;
+	}
+	rcu_read_unlock();
+}
+
+static int sched_coloc_stats_show(struct seq_file *m, void *v)
+{
+	struct walt_related_thread_group *grp;
+	unsigned long flags;
+
+	read_lock_irqsave(&related_thread_group_lock, flags);
+	list_for_each_entry(grp, &active_related_thread_groups, list) {
+		seq_printf(m, "group %d skip_min %d affine %d wakeups %llu cross_cluster_wakeups %llu last_window_wakeups %u\n",
+			   grp->id, grp->skip_min, grp->affine,
+			   grp->nr_wakeups, grp->nr_cross_wakeups,
+			   grp->prev_win_wakeups);
+	}
+	read_unlock_irqrestore(&related_thread_group_lock, flags);
+
+	return 0;
+}
+
+static int __init sched_coloc_stats_init(void)
+{
+	proc_create_single("sched_coloc_stats", 0444, NULL,
+			   sched_coloc_stats_show);
+	return 0;
+}
+late_initcall(sched_coloc_stats_init);
+
 int update_preferred_cluster(struct walt_related_thread_group *grp,
 		struct task_struct *p, u32 old_load, bool from_tick)
 {
@@ -3442,9 +3611,69 @@ static void walt_update_irqload(struct rq *rq)
 		rq->wrq.high_irqload = 0;
 }
 
+/*
+ * Serializes the window rollover and the migration work, which used to be
+ * done by holding the rq locks of all CPUs for the whole work.
+ */
+static DEFINE_RAW_SPINLOCK(walt_irq_work_lock);
+
+/*
+ * Changing sched_ravg_window needs all CPUs to agree on the window, so all
+ * rq locks are taken, but only when a change is pending.
+ */
+static void walt_irq_work_window_change(void)
+{
+	unsigned long flags;
+	int cpu, level = 0;
+	u64 wc;
+
+	if (sched_ravg_window == READ_ONCE(new_sched_ravg_window))
+		return;
+
+	for_each_cpu(cpu, cpu_possible_mask) {
+		if (level == 0)
+			raw_spin_lock(&cpu_rq(cpu)->lock);
+		else
+			raw_spin_lock_nested(&cpu_rq(cpu)->lock, level);
+		level++;
+	}
+
+	/*
+	 * If the current window roll over is delayed such that the
+	 * mark_start (current wallclock with which roll over is done)
+	 * of the current task went past the window start with the
+	 * updated new window size, delay the update to the next
+	 * window roll over. Otherwise the CPU counters (prs and crs) are
+	 * not rolled over properly as mark_start > window_start.
+	 */
+	wc = sched_ktime_clock();
+	spin_lock_irqsave(&sched_ravg_window_lock, flags);
+
+	if ((sched_ravg_window != new_sched_ravg_window) &&
+	    (wc < this_rq()->wrq.window_start + new_sched_ravg_window)) {
+		sched_ravg_window_change_time = sched_ktime_clock();
+		printk_deferred("ALERT: changing window size from %u to %u at %lu\n",
+				sched_ravg_window,
+				new_sched_ravg_window,
+				sched_ravg_window_change_time);
+		trace_sched_ravg_window_change(sched_ravg_window,
+				new_sched_ravg_window,
+				sched_ravg_window_change_time);
+		sched_ravg_window = new_sched_ravg_window;
+		walt_tunables_fixup();
+	}
+	spin_unlock_irqrestore(&sched_ravg_window_lock, flags);
+
+	for_each_cpu(cpu, cpu_possible_mask)
+		raw_spin_unlock(&cpu_rq(cpu)->lock);
+}
+
 /*
  * Runs in hard-irq context. This should ideally run just after the latest
  * window roll-over.
+ *
+ * Each rq lock is only held while that CPU is updated, so the rest of the
+ * system keeps scheduling while the loads are collected and reported.
  */
 void walt_irq_work(struct irq_work *irq_work)
 {
@@ -3454,9 +3683,8 @@ void walt_irq_work(struct irq_work *irq_work)
 	u64 wc;
 	bool is_migration = false, is_asym_migration = false;
 	u64 total_grp_load = 0, min_cluster_grp_load = 0;
-	int level = 0;
+	u64 start, lock_ts, max_hold = 0;
 	u64 cur_jiffies_ts;
-	unsigned long flags;
 	struct cpumask freq_match_cpus;
 
 	if (sysctl_sched_asym_cap_sibling_freq_match_en &&
@@ -3469,24 +3697,20 @@ void walt_irq_work(struct irq_work *irq_work)
 	if (irq_work == &walt_migration_irq_work)
 		is_migration = true;
 
-	for_each_cpu(cpu, cpu_possible_mask) {
-		if (level == 0)
-			raw_spin_lock(&cpu_rq(cpu)->lock);
-		else
-			raw_spin_lock_nested(&cpu_rq(cpu)->lock, level);
-		level++;
-	}
+	raw_spin_lock(&walt_irq_work_lock);
 
-	wc = sched_ktime_clock();
+	start = sched_ktime_clock();
 	cur_jiffies_ts = get_jiffies_64();
 	walt_load_reported_window = atomic64_read(&walt_irq_work_lastq_ws);
 	for_each_sched_cluster(cluster) {
 		u64 aggr_grp_load = 0;
 
-		raw_spin_lock(&cluster->load_lock);
-
 		for_each_cpu(cpu, &cluster->cpus) {
 			rq = cpu_rq(cpu);
+			raw_spin_lock(&rq->lock);
+			/* the clock only moves forward under the rq lock */
+			wc = lock_ts = sched_ktime_clock();
+			raw_spin_lock(&cluster->load_lock);
 			if (rq->curr) {
 				walt_update_task_ravg(rq->curr, rq,
 						TASK_UPDATE, wc, 0);
@@ -3499,6 +3723,9 @@ void walt_irq_work(struct irq_work *irq_work)
 				is_asym_migration = true;
 				rq->wrq.notif_pending = false;
 			}
+			raw_spin_unlock(&cluster->load_lock);
+			max_hold = max(max_hold, sched_ktime_clock() - lock_ts);
+			raw_spin_unlock(&rq->lock);
 		}
 
 		cluster->aggr_grp_load = aggr_grp_load;
@@ -3506,7 +3733,6 @@ void walt_irq_work(struct irq_work *irq_work)
 
 		if (is_min_capacity_cluster(cluster))
 			min_cluster_grp_load = aggr_grp_load;
-		raw_spin_unlock(&cluster->load_lock);
 	}
 
 	if (total_grp_load) {
@@ -3537,6 +3763,8 @@ void walt_irq_work(struct irq_work *irq_work)
 			int flag = SCHED_CPUFREQ_WALT;
 
 			rq = cpu_rq(cpu);
+			raw_spin_lock(&rq->lock);
+			lock_ts = sched_ktime_clock();
 
 			if (is_migration) {
 				if (rq->wrq.notif_pending) {
@@ -3558,41 +3786,18 @@ void walt_irq_work(struct irq_work *irq_work)
 
 			if (!is_migration)
 				walt_update_irqload(rq);
-		}
-	}
 
-	/*
-	 * If the window change request is in pending, good place to
-	 * change sched_ravg_window since all rq locks are acquired.
-	 *
-	 * If the current window roll over is delayed such that the
-	 * mark_start (current wallclock with which roll over is done)
-	 * of the current task went past the window start with the
-	 * updated new window size, delay the update to the next
-	 * window roll over. Otherwise the CPU counters (prs and crs) are
-	 * not rolled over properly as mark_start > window_start.
-	 */
-	if (!is_migration) {
-		spin_lock_irqsave(&sched_ravg_window_lock, flags);
-
-		if ((sched_ravg_window != new_sched_ravg_window) &&
-		    (wc < this_rq()->wrq.window_start + new_sched_ravg_window)) {
-			sched_ravg_window_change_time = sched_ktime_clock();
-			printk_deferred("ALERT: changing window size from %u to %u at %lu\n",
-					sched_ravg_window,
-					new_sched_ravg_window,
-					sched_ravg_window_change_time);
-			trace_sched_ravg_window_change(sched_ravg_window,
-					new_sched_ravg_window,
-					sched_ravg_window_change_time);
-			sched_ravg_window = new_sched_ravg_window;
-			walt_tunables_fixup();
+			max_hold = max(max_hold, sched_ktime_clock() - lock_ts);
+			raw_spin_unlock(&rq->lock);
 		}
-		spin_unlock_irqrestore(&sched_ravg_window_lock, flags);
 	}
 
-	for_each_cpu(cpu, cpu_possible_mask)
-		raw_spin_unlock(&cpu_rq(cpu)->lock);
+	if (!is_migration)
+		walt_irq_work_window_change();
+
+	trace_walt_irq_work(is_migration, sched_ktime_clock() - start,
+			    max_hold);
+	raw_spin_unlock(&walt_irq_work_lock);
 
 	if (!is_migration)
 		core_ctl_check(this_rq()->wrq.window_start);
@@ -3790,6 +3995,7 @@ void walt_sched_init_rq(struct rq *rq)
 	rq->wrq.curr_top = 0;
 	rq->wrq.last_cc_update = 0;
 	rq->wrq.cycles = 0;
+	BUILD_BUG_ON(BITS_TO_LONGS(NUM_LOAD_INDICES + 1) > BITS_PER_LONG);
 	for (j = 0; j < NUM_TRACKED_WINDOWS; j++) {
 		memset(&rq->wrq.load_subs[j], 0,
 				sizeof(struct load_subtractions));
@@ -3797,7 +4003,9 @@ void walt_sched_init_rq(struct rq *rq)
 				sizeof(u8), GFP_NOWAIT);
 		/* No other choice */
 		BUG_ON(!rq->wrq.top_tasks[j]);
-		clear_top_tasks_bitmap(rq->wrq.top_tasks_bitmap[j]);
+		memset(rq->wrq.top_tasks_bitmap[j], 0, top_tasks_bitmap_size);
+		rq->wrq.top_tasks_summary[j] = 0;
+		clear_top_tasks(rq, j);
 	}
 	rq->wrq.cum_window_demand_scaled = 0;
 	rq->wrq.notif_pending = false;
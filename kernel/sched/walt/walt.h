@@ -204,7 +204,9 @@ static inline unsigned int walt_nr_rtg_high_prio(int cpu)
 	return cpu_rq(cpu)->wrq.walt_stats.nr_rtg_high_prio_tasks;
 }
 
+extern void walt_note_group_wakeup(struct task_struct *p, int cpu);
 extern int core_ctl_init(void);
+extern void core_ctl_tick(struct rq *rq, u64 wallclock);
 
 #ifdef CONFIG_CPU_FREQ
 extern int cpu_boost_init(void);
@@ -279,6 +281,10 @@ static inline u64 get_rtgb_active_time(void)
 
 #define walt_try_to_wake_up(a) {}
 
+static inline void walt_note_group_wakeup(struct task_struct *p, int cpu) { }
+
+static inline void core_ctl_tick(struct rq *rq, u64 wallclock) { }
+
 #endif /* CONFIG_SCHED_WALT */
 
 #endif
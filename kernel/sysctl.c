@@ -507,6 +507,13 @@ static struct ctl_table kern_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_douintvec_minmax,
 	},
+	{
+		.procname	= "sched_coloc_affine_wakeups",
+		.data		= &sysctl_sched_coloc_affine_wakeups,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+	},
 	{
 		.procname	= "sched_task_unfilter_period",
 		.data		= &sysctl_sched_task_unfilter_period,
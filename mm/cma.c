@@ -29,6 +29,8 @@
 #include <linux/io.h>
 #include <linux/kmemleak.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/shrinker.h>
 #include <linux/show_mem_notifier.h>
 #include <trace/events/cma.h>
 
@@ -115,6 +117,8 @@ static struct notifier_block cma_nb = {
 	.notifier_call = cma_showmem_notifier,
 };
 
+static void cma_hot_refill(struct work_struct *work);
+
 static void __init cma_activate_area(struct cma *cma)
 {
 	unsigned long base_pfn = cma->base_pfn, pfn = base_pfn;
@@ -147,6 +151,9 @@ static void __init cma_activate_area(struct cma *cma)
 	} while (--i);
 
 	mutex_init(&cma->lock);
+	spin_lock_init(&cma->hot_lock);
+	INIT_LIST_HEAD(&cma->hot_list);
+	INIT_WORK(&cma->hot_work, cma_hot_refill);
 
 #ifdef CONFIG_CMA_DEBUGFS
 	INIT_HLIST_HEAD(&cma->mem_head);
@@ -163,6 +170,8 @@ static void __init cma_activate_area(struct cma *cma)
 	return;
 }
 
+static struct shrinker cma_hot_shrinker;
+
 static int __init cma_init_reserved_areas(void)
 {
 	int i;
@@ -171,6 +180,8 @@ static int __init cma_init_reserved_areas(void)
 		cma_activate_area(&cma_areas[i]);
 
 	show_mem_notifier_register(&cma_nb);
+	if (register_shrinker(&cma_hot_shrinker))
+		pr_warn("failed to register hot reserve shrinker\n");
 
 	return 0;
 }
@@ -421,18 +432,8 @@ static void cma_debug_show_areas(struct cma *cma)
 static inline void cma_debug_show_areas(struct cma *cma) { }
 #endif
 
-/**
- * cma_alloc() - allocate pages from contiguous area
- * @cma:   Contiguous memory region for which the allocation is performed.
- * @count: Requested number of pages.
- * @align: Requested alignment of pages (in PAGE_SIZE order).
- * @no_warn: Avoid printing message about failed allocation
- *
- * This function allocates part of contiguous memory on specific
- * contiguous memory area.
- */
-struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
-		       bool no_warn)
+static struct page *__cma_alloc(struct cma *cma, size_t count,
+				unsigned int align, bool no_warn)
 {
 	unsigned long mask, offset;
 	unsigned long pfn = -1;
@@ -550,6 +551,223 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 	pr_debug("%s(): returned %p\n", __func__, page);
 	return page;
 }
+
+static struct page *cma_hot_get(struct cma *cma, size_t count,
+				unsigned int align)
+{
+	struct page *page = NULL;
+
+	spin_lock(&cma->hot_lock);
+	if (count == cma->hot_chunk && align <= cma->hot_align) {
+		if (!list_empty(&cma->hot_list)) {
+			page = list_first_entry(&cma->hot_list,
+						struct page, lru);
+			list_del(&page->lru);
+			set_page_private(page, 0);
+			cma->hot_nr--;
+			cma->hot_hits++;
+		} else {
+			cma->hot_misses++;
+		}
+	}
+	if (cma->hot_nr < cma->hot_target)
+		queue_work(system_unbound_wq, &cma->hot_work);
+	spin_unlock(&cma->hot_lock);
+
+	return page;
+}
+
+/* Release held ranges until at most @keep remain or @max pages are freed */
+static unsigned long cma_hot_release(struct cma *cma, unsigned int keep,
+				     unsigned long max)
+{
+	unsigned long count, freed = 0;
+	struct page *page;
+
+	while (freed < max) {
+		spin_lock(&cma->hot_lock);
+		if (cma->hot_nr <= keep) {
+			spin_unlock(&cma->hot_lock);
+			break;
+		}
+		page = list_first_entry(&cma->hot_list, struct page, lru);
+		list_del(&page->lru);
+		cma->hot_nr--;
+		spin_unlock(&cma->hot_lock);
+
+		count = page_private(page);
+		set_page_private(page, 0);
+		cma_release(cma, page, count);
+		freed += count;
+	}
+
+	return freed;
+}
+
+static void cma_hot_refill(struct work_struct *work)
+{
+	struct cma *cma = container_of(work, struct cma, hot_work);
+	unsigned long chunk;
+	unsigned int align;
+	struct page *page;
+
+	for (;;) {
+		spin_lock(&cma->hot_lock);
+		chunk = cma->hot_chunk;
+		align = cma->hot_align;
+		if (cma->hot_nr >= cma->hot_target)
+			chunk = 0;
+		spin_unlock(&cma->hot_lock);
+		if (!chunk)
+			break;
+
+		/* this is where the migration cost is paid, off the hot path */
+		page = __cma_alloc(cma, chunk, align, true);
+		if (!page)
+			break;
+
+		set_page_private(page, chunk);
+		spin_lock(&cma->hot_lock);
+		if (chunk == cma->hot_chunk) {
+			list_add_tail(&page->lru, &cma->hot_list);
+			cma->hot_nr++;
+			page = NULL;
+		}
+		spin_unlock(&cma->hot_lock);
+
+		/* reserve was reconfigured meanwhile */
+		if (page) {
+			set_page_private(page, 0);
+			cma_release(cma, page, chunk);
+		}
+	}
+}
+
+/**
+ * cma_set_hot_reserve() - keep migrated ranges ready for fast allocation
+ * @cma:   Contiguous memory region to configure.
+ * @chunk: Size of each held range in pages, 0 to disable the reserve.
+ * @nr:    Number of ranges to keep.
+ *
+ * Ranges are refilled asynchronously after each allocation that consumes
+ * one, and are given back to the area when the system is under memory
+ * pressure. At most half of the area may be held this way.
+ */
+int cma_set_hot_reserve(struct cma *cma, size_t chunk, unsigned int nr)
+{
+	LIST_HEAD(stale);
+	struct page *page, *tmp;
+
+	if (!cma || !cma->count)
+		return -EINVAL;
+
+	if (!chunk)
+		nr = 0;
+	if ((u64)chunk * nr > cma->count / 2)
+		return -EINVAL;
+
+	spin_lock(&cma->hot_lock);
+	/* ranges of the old size can no longer be handed out */
+	if (chunk != cma->hot_chunk) {
+		list_splice_init(&cma->hot_list, &stale);
+		cma->hot_nr = 0;
+	}
+	cma->hot_chunk = chunk;
+	cma->hot_align = chunk ? get_order(chunk << PAGE_SHIFT) : 0;
+	cma->hot_target = nr;
+	if (cma->hot_nr < cma->hot_target)
+		queue_work(system_unbound_wq, &cma->hot_work);
+	spin_unlock(&cma->hot_lock);
+
+	list_for_each_entry_safe(page, tmp, &stale, lru) {
+		unsigned long count = page_private(page);
+
+		list_del(&page->lru);
+		set_page_private(page, 0);
+		cma_release(cma, page, count);
+	}
+	cma_hot_release(cma, nr, ULONG_MAX);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(cma_set_hot_reserve);
+
+static unsigned long cma_hot_count(struct shrinker *s,
+				   struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	int i;
+
+	for (i = 0; i < cma_area_count; i++)
+		count += (unsigned long)READ_ONCE(cma_areas[i].hot_nr) *
+			 READ_ONCE(cma_areas[i].hot_chunk);
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+static unsigned long cma_hot_scan(struct shrinker *s,
+				  struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	int i;
+
+	for (i = 0; i < cma_area_count && freed < sc->nr_to_scan; i++) {
+		if (!cma_areas[i].count)
+			continue;
+		freed += cma_hot_release(&cma_areas[i], 0,
+					 sc->nr_to_scan - freed);
+	}
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker cma_hot_shrinker = {
+	.count_objects = cma_hot_count,
+	.scan_objects = cma_hot_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+#ifdef CONFIG_CMA_DEBUGFS
+static void cma_account_latency(struct cma *cma, ktime_t start)
+{
+	u64 us = ktime_to_us(ktime_sub(ktime_get(), start));
+	int bucket = us ? min_t(int, ilog2(us) + 1,
+				CMA_ALLOC_LAT_BUCKETS - 1) : 0;
+
+	atomic_long_inc(&cma->alloc_lat[bucket]);
+}
+#else
+static inline void cma_account_latency(struct cma *cma, ktime_t start) { }
+#endif
+
+/**
+ * cma_alloc() - allocate pages from contiguous area
+ * @cma:   Contiguous memory region for which the allocation is performed.
+ * @count: Requested number of pages.
+ * @align: Requested alignment of pages (in PAGE_SIZE order).
+ * @no_warn: Avoid printing message about failed allocation
+ *
+ * This function allocates part of contiguous memory on specific
+ * contiguous memory area. Requests matching the area's hot reserve are
+ * served from already migrated ranges when one is available.
+ */
+struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
+		       bool no_warn)
+{
+	ktime_t start = ktime_get();
+	struct page *page;
+
+	if (!cma || !cma->count || !count)
+		return NULL;
+
+	page = cma_hot_get(cma, count, align);
+	if (!page)
+		page = __cma_alloc(cma, count, align, no_warn);
+	if (page)
+		cma_account_latency(cma, start);
+
+	return page;
+}
 EXPORT_SYMBOL_GPL(cma_alloc);
 
 /**
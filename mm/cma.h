@@ -2,6 +2,10 @@
 #ifndef __MM_CMA_H__
 #define __MM_CMA_H__
 
+#include <linux/workqueue.h>
+
+#define CMA_ALLOC_LAT_BUCKETS	16	/* log2 buckets of microseconds */
+
 struct cma {
 	unsigned long   base_pfn;
 	unsigned long   count;
@@ -11,8 +15,25 @@ struct cma {
 #ifdef CONFIG_CMA_DEBUGFS
 	struct hlist_head mem_head;
 	spinlock_t mem_head_lock;
+	atomic_long_t alloc_lat[CMA_ALLOC_LAT_BUCKETS];
 #endif
 	const char *name;
+
+	/*
+	 * Hot reserve: ranges of hot_chunk pages that were already migrated
+	 * out and are held allocated, so a matching cma_alloc() is served
+	 * without touching the page allocator. Ranges are linked through
+	 * page->lru of their first page.
+	 */
+	spinlock_t hot_lock;
+	struct list_head hot_list;
+	unsigned long hot_chunk;	/* pages per range, 0: disabled */
+	unsigned int hot_align;		/* alignment order of held ranges */
+	unsigned int hot_target;	/* ranges to keep around */
+	unsigned int hot_nr;		/* ranges currently held */
+	unsigned long hot_hits;
+	unsigned long hot_misses;
+	struct work_struct hot_work;
 };
 
 extern struct cma cma_areas[MAX_CMA_AREAS];
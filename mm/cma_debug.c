@@ -12,6 +12,7 @@
 #include <linux/kernel.h>
 #include <linux/slab.h>
 #include <linux/mm_types.h>
+#include <linux/seq_file.h>
 
 #include "cma.h"
 
@@ -176,6 +177,63 @@ static int cma_alloc_write(void *data, u64 val)
 
 DEFINE_SIMPLE_ATTRIBUTE(cma_alloc_fops, NULL, cma_alloc_write, "%llu\n");
 
+static int cma_hot_chunk_get(void *data, u64 *val)
+{
+	struct cma *cma = data;
+
+	*val = cma->hot_chunk;
+	return 0;
+}
+
+static int cma_hot_chunk_set(void *data, u64 val)
+{
+	struct cma *cma = data;
+
+	return cma_set_hot_reserve(cma, val, cma->hot_target);
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_hot_chunk_fops, cma_hot_chunk_get,
+			cma_hot_chunk_set, "%llu\n");
+
+static int cma_hot_target_get(void *data, u64 *val)
+{
+	struct cma *cma = data;
+
+	*val = cma->hot_target;
+	return 0;
+}
+
+static int cma_hot_target_set(void *data, u64 val)
+{
+	struct cma *cma = data;
+
+	return cma_set_hot_reserve(cma, cma->hot_chunk, val);
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_hot_target_fops, cma_hot_target_get,
+			cma_hot_target_set, "%llu\n");
+
+static int cma_alloc_stats_show(struct seq_file *s, void *unused)
+{
+	struct cma *cma = s->private;
+	int i;
+
+	spin_lock(&cma->hot_lock);
+	seq_printf(s, "hot: chunk %lu held %u/%u hits %lu misses %lu\n",
+		   cma->hot_chunk, cma->hot_nr, cma->hot_target,
+		   cma->hot_hits, cma->hot_misses);
+	spin_unlock(&cma->hot_lock);
+
+	seq_puts(s, "latency_us count\n");
+	for (i = 0; i < CMA_ALLOC_LAT_BUCKETS; i++)
+		seq_printf(s, "%s%-9lu %ld\n",
+			   i == CMA_ALLOC_LAT_BUCKETS - 1 ? ">=" : "<",
+			   i ? 1UL << (i == CMA_ALLOC_LAT_BUCKETS - 1 ?
+				       i - 1 : i) : 1UL,
+			   atomic_long_read(&cma->alloc_lat[i]));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(cma_alloc_stats);
+
 static void cma_debugfs_add_one(struct cma *cma, struct dentry *root_dentry)
 {
 	struct dentry *tmp;
@@ -196,6 +254,10 @@ static void cma_debugfs_add_one(struct cma *cma, struct dentry *root_dentry)
 			     (u32 *)&cma->order_per_bit);
 	debugfs_create_file("used", 0444, tmp, cma, &cma_used_fops);
 	debugfs_create_file("maxchunk", 0444, tmp, cma, &cma_maxchunk_fops);
+	debugfs_create_file("hot_chunk", 0644, tmp, cma, &cma_hot_chunk_fops);
+	debugfs_create_file("hot_target", 0644, tmp, cma, &cma_hot_target_fops);
+	debugfs_create_file("alloc_stats", 0444, tmp, cma,
+			    &cma_alloc_stats_fops);
 
 	u32s = DIV_ROUND_UP(cma_bitmap_maxno(cma), BITS_PER_BYTE * sizeof(u32));
 	debugfs_create_u32_array("bitmap", 0444, tmp, (u32 *)cma->bitmap, u32s);
@@ -4045,17 +4045,20 @@ __alloc_pages_direct_compact(gfp_t gfp_mask, unsigned int order,
 	struct page *page = NULL;
 	unsigned long pflags;
 	unsigned int noreclaim_flag;
+	bool direct_stall;
 
 	if (!order)
 		return NULL;
 
 	psi_memstall_enter(&pflags);
+	direct_stall = psi_direct_stall_enter();
 	noreclaim_flag = memalloc_noreclaim_save();
 
 	*compact_result = try_to_compact_pages(gfp_mask, order, alloc_flags, ac,
 								prio, &page);
 
 	memalloc_noreclaim_restore(noreclaim_flag);
+	psi_direct_stall_leave(direct_stall);
 	psi_memstall_leave(&pflags);
 
 	/*
@@ -4290,12 +4293,14 @@ __perform_reclaim(gfp_t gfp_mask, unsigned int order,
 	int progress;
 	unsigned int noreclaim_flag;
 	unsigned long pflags;
+	bool direct_stall;
 
 	cond_resched();
 
 	/* We now go into synchronous reclaim */
 	cpuset_memory_pressure_bump();
 	psi_memstall_enter(&pflags);
+	direct_stall = psi_direct_stall_enter();
 	fs_reclaim_acquire(gfp_mask);
 	noreclaim_flag = memalloc_noreclaim_save();
 
@@ -4304,6 +4309,7 @@ __perform_reclaim(gfp_t gfp_mask, unsigned int order,
 
 	memalloc_noreclaim_restore(noreclaim_flag);
 	fs_reclaim_release(gfp_mask);
+	psi_direct_stall_leave(direct_stall);
 	psi_memstall_leave(&pflags);
 
 	cond_resched();
@@ -26,6 +26,7 @@
 #include <linux/crypto.h>
 #include <linux/mempool.h>
 #include <linux/zpool.h>
+#include <linux/sched/clock.h>
 
 #include <linux/mm_types.h>
 #include <linux/page-flags.h>
@@ -65,6 +66,28 @@ static u64 zswap_reject_kmemcache_fail;
 /* Duplicate store was encountered (rare) */
 static u64 zswap_duplicate_entry;
 
+/*
+ * Latency histograms for the compression step and for a whole successful
+ * store. Bucket 0 counts calls under 1us and bucket n calls in
+ * [2^(n-1), 2^n) us, the last bucket also takes everything slower.
+ */
+#define ZSWAP_LAT_BUCKETS	16
+
+struct zswap_lat_hist {
+	u64 buckets[ZSWAP_LAT_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct zswap_lat_hist, zswap_compress_lat);
+static DEFINE_PER_CPU(struct zswap_lat_hist, zswap_store_lat);
+
+static inline void zswap_lat_record(struct zswap_lat_hist __percpu *hist,
+				    u64 start)
+{
+	u64 us = div_u64(local_clock() - start, NSEC_PER_USEC);
+
+	this_cpu_inc(hist->buckets[min(fls64(us), ZSWAP_LAT_BUCKETS - 1)]);
+}
+
 /*********************************
 * tunables
 **********************************/
@@ -997,6 +1020,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	u8 *src, *dst;
 	struct zswap_header zhdr = { .swpentry = swp_entry(type, offset) };
 	gfp_t gfp;
+	u64 start = local_clock(), cstart;
 
 	/* THP isn't supported */
 	if (PageTransHuge(page)) {
@@ -1060,7 +1084,9 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	dst = get_cpu_var(zswap_dstmem);
 	tfm = *get_cpu_ptr(entry->pool->tfm);
 	src = kmap_atomic(page);
+	cstart = local_clock();
 	ret = crypto_comp_compress(tfm, src, PAGE_SIZE, dst, &dlen);
+	zswap_lat_record(&zswap_compress_lat, cstart);
 	kunmap_atomic(src);
 	put_cpu_ptr(entry->pool->tfm);
 	if (ret) {
@@ -1110,6 +1136,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	/* update stats */
 	atomic_inc(&zswap_stored_pages);
 	zswap_update_total_size();
+	zswap_lat_record(&zswap_store_lat, start);
 
 	return 0;
 
@@ -1245,9 +1272,42 @@ static struct frontswap_ops zswap_frontswap_ops = {
 **********************************/
 #ifdef CONFIG_DEBUG_FS
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 static struct dentry *zswap_debugfs_root;
 
+static void zswap_lat_show(struct seq_file *s,
+			   struct zswap_lat_hist __percpu *hist)
+{
+	u64 count;
+	int cpu, i;
+
+	for (i = 0; i < ZSWAP_LAT_BUCKETS; i++) {
+		count = 0;
+		for_each_possible_cpu(cpu)
+			count += per_cpu_ptr(hist, cpu)->buckets[i];
+
+		if (i == ZSWAP_LAT_BUCKETS - 1)
+			seq_printf(s, ">=%lluus: %llu\n", 1ULL << (i - 1), count);
+		else
+			seq_printf(s, "<%lluus: %llu\n", 1ULL << i, count);
+	}
+}
+
+static int compress_latency_show(struct seq_file *s, void *unused)
+{
+	zswap_lat_show(s, &zswap_compress_lat);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(compress_latency);
+
+static int store_latency_show(struct seq_file *s, void *unused)
+{
+	zswap_lat_show(s, &zswap_store_lat);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(store_latency);
+
 static int __init zswap_debugfs_init(void)
 {
 	if (!debugfs_initialized())
@@ -1275,6 +1335,10 @@ static int __init zswap_debugfs_init(void)
 				zswap_debugfs_root, &zswap_stored_pages);
 	debugfs_create_atomic_t("same_filled_pages", 0444,
 				zswap_debugfs_root, &zswap_same_filled_pages);
+	debugfs_create_file("compress_latency", 0444, zswap_debugfs_root,
+			    NULL, &compress_latency_fops);
+	debugfs_create_file("store_latency", 0444, zswap_debugfs_root,
+			    NULL, &store_latency_fops);
 
 	return 0;
 }
@@ -17,6 +17,8 @@ struct qrtr_mhi_dev {
 	spinlock_t ul_lock;		/* lock to protect ul_pkts */
 	struct list_head ul_pkts;
 	atomic_t in_reset;
+	bool zcopy_rx;			/* dl buffers owned by qrtr */
+	size_t dl_buf_len;
 };
 
 struct qrtr_mhi_pkt {
@@ -38,6 +40,73 @@ static void qrtr_mhi_pkt_release(struct kref *ref)
 	kfree(pkt);
 }
 
+/* size of a zero copy dl buffer, including skb headroom and shared info */
+static size_t qcom_mhi_qrtr_dl_alloc_len(struct qrtr_mhi_dev *qdev)
+{
+	return SKB_DATA_ALIGN(QRTR_EP_RX_HEADROOM + qdev->dl_buf_len) +
+		SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+}
+
+static int qcom_mhi_qrtr_queue_dl(struct qrtr_mhi_dev *qdev, gfp_t gfp)
+{
+	void *buf;
+	int rc;
+
+	buf = kmalloc(qcom_mhi_qrtr_dl_alloc_len(qdev), gfp);
+	if (!buf)
+		return -ENOMEM;
+
+	/* mhi writes the packet after the headroom qrtr needs for forwarding */
+	rc = mhi_queue_transfer(qdev->mhi_dev, DMA_FROM_DEVICE,
+				buf + QRTR_EP_RX_HEADROOM, qdev->dl_buf_len,
+				MHI_EOT);
+	if (rc)
+		kfree(buf);
+
+	return rc;
+}
+
+static void qcom_mhi_qrtr_fill_dl(struct qrtr_mhi_dev *qdev, gfp_t gfp)
+{
+	int nr_desc;
+
+	nr_desc = mhi_get_no_free_descriptors(qdev->mhi_dev, DMA_FROM_DEVICE);
+	while (nr_desc-- > 0) {
+		if (qcom_mhi_qrtr_queue_dl(qdev, gfp))
+			break;
+	}
+}
+
+/* hand the dl buffer to qrtr as the head of an skb, no copy */
+static void qcom_mhi_qrtr_dl_zcopy(struct qrtr_mhi_dev *qdev,
+				   struct mhi_result *mhi_res)
+{
+	void *buf = mhi_res->buf_addr - QRTR_EP_RX_HEADROOM;
+	struct sk_buff *skb;
+	int rc;
+
+	if (mhi_res->transaction_status) {
+		kfree(buf);
+		return;
+	}
+
+	skb = build_skb(buf, 0);
+	if (!skb) {
+		kfree(buf);
+		goto refill;
+	}
+
+	skb_reserve(skb, QRTR_EP_RX_HEADROOM);
+	skb_put(skb, mhi_res->bytes_xferd);
+
+	rc = qrtr_endpoint_post_skb(&qdev->ep, skb);
+	if (rc == -EINVAL)
+		dev_err(qdev->dev, "invalid ipcrouter packet\n");
+
+refill:
+	qcom_mhi_qrtr_fill_dl(qdev, GFP_ATOMIC);
+}
+
 /* from mhi to qrtr */
 static void qcom_mhi_qrtr_dl_callback(struct mhi_device *mhi_dev,
 				      struct mhi_result *mhi_res)
@@ -45,7 +114,15 @@ static void qcom_mhi_qrtr_dl_callback(struct mhi_device *mhi_dev,
 	struct qrtr_mhi_dev *qdev = dev_get_drvdata(&mhi_dev->dev);
 	int rc;
 
-	if (!qdev || mhi_res->transaction_status)
+	if (!qdev)
+		return;
+
+	if (qdev->zcopy_rx) {
+		qcom_mhi_qrtr_dl_zcopy(qdev, mhi_res);
+		return;
+	}
+
+	if (mhi_res->transaction_status)
 		return;
 
 	rc = qrtr_endpoint_post(&qdev->ep, mhi_res->buf_addr,
@@ -171,6 +248,14 @@ static int qcom_mhi_qrtr_probe(struct mhi_device *mhi_dev,
 
 	rt = of_property_read_bool(mhi_dev->dev.of_node, "qcom,low-latency");
 
+	/*
+	 * zero copy rx needs the IPCR channels without mhi,auto-queue and
+	 * mhi,auto-start, qrtr then owns and posts the dl buffers itself.
+	 */
+	qdev->zcopy_rx = of_property_read_bool(mhi_dev->dev.of_node,
+					       "qcom,zero-copy-rx");
+	qdev->dl_buf_len = mhi_dev->mtu;
+
 	INIT_LIST_HEAD(&qdev->ul_pkts);
 	spin_lock_init(&qdev->ul_lock);
 
@@ -180,6 +265,16 @@ static int qcom_mhi_qrtr_probe(struct mhi_device *mhi_dev,
 	if (rc)
 		return rc;
 
+	if (qdev->zcopy_rx) {
+		rc = mhi_prepare_for_transfer(mhi_dev);
+		if (rc) {
+			qrtr_endpoint_unregister(&qdev->ep);
+			return rc;
+		}
+
+		qcom_mhi_qrtr_fill_dl(qdev, GFP_KERNEL);
+	}
+
 	dev_dbg(qdev->dev, "QTI MHI QRTR driver probed\n");
 
 	return 0;
@@ -189,6 +284,10 @@ static void qcom_mhi_qrtr_remove(struct mhi_device *mhi_dev)
 {
 	struct qrtr_mhi_dev *qdev = dev_get_drvdata(&mhi_dev->dev);
 
+	/* unprepare returns the queued dl buffers with an error status */
+	if (qdev->zcopy_rx)
+		mhi_unprepare_from_transfer(mhi_dev);
+
 	qrtr_endpoint_unregister(&qdev->ep);
 	dev_set_drvdata(&mhi_dev->dev, NULL);
 }
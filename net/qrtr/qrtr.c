@@ -3,6 +3,7 @@
  * Copyright (c) 2015, Sony Mobile Communications Inc.
  * Copyright (c) 2013, 2018-2019, 2021, The Linux Foundation. All rights reserved.
  */
+#include <linux/hash.h>
 #include <linux/kthread.h>
 #include <linux/module.h>
 #include <linux/netlink.h>
@@ -133,10 +134,28 @@ static LIST_HEAD(qrtr_all_epts);
 /* lock for qrtr_all_epts */
 static DECLARE_RWSEM(qrtr_epts_lock);
 
-/* local port allocation management */
+/* local port allocation management, lookups are rcu protected */
 static DEFINE_IDR(qrtr_ports);
 static DEFINE_SPINLOCK(qrtr_port_lock);
 
+/* forwarded data is spread over lanes keyed by destination address */
+#define QRTR_RX_LANES_SHIFT	2
+#define QRTR_RX_LANES		BIT(QRTR_RX_LANES_SHIFT)
+
+static struct workqueue_struct *qrtr_rx_wq;
+
+/**
+ * struct qrtr_rx_lane - parallel delivery queue of a node
+ * @node: node the packets were received from
+ * @queue: packets pending forwarding
+ * @work: drains @queue on qrtr_rx_wq, one lane never runs concurrently
+ */
+struct qrtr_rx_lane {
+	struct qrtr_node *node;
+	struct sk_buff_head queue;
+	struct work_struct work;
+};
+
 /* backup buffers */
 #define QRTR_BACKUP_HI_NUM	5
 #define QRTR_BACKUP_HI_SIZE	SZ_16K
@@ -165,6 +184,7 @@ static struct work_struct qrtr_backup_work;
  * @task: task to run the worker thread
  * @read_data: scheduled work for recv work
  * @say_hello: scheduled work for initiating hello
+ * @rx_lanes: per destination queues for forwarded data packets
  * @ws: wakeupsource avoid system suspend
  * @ilc: ipc logging context reference
  */
@@ -189,6 +209,8 @@ struct qrtr_node {
 	struct kthread_work read_data;
 	struct kthread_work say_hello;
 
+	struct qrtr_rx_lane rx_lanes[QRTR_RX_LANES];
+
 	struct wakeup_source *ws;
 	void *ilc;
 
@@ -388,6 +410,7 @@ static void __qrtr_node_release(struct kref *kref)
 	struct qrtr_node *node = container_of(kref, struct qrtr_node, ref);
 	unsigned long flags;
 	void __rcu **slot;
+	int i;
 
 	spin_lock_irqsave(&qrtr_nodes_lock, flags);
 	if (node->nid != QRTR_EP_NID_AUTO) {
@@ -421,6 +444,9 @@ static void __qrtr_node_release(struct kref *kref)
 	kthread_stop(node->task);
 
 	skb_queue_purge(&node->rx_queue);
+	/* lanes hold a node reference while queued, nothing is pending */
+	for (i = 0; i < QRTR_RX_LANES; i++)
+		skb_queue_purge(&node->rx_lanes[i].queue);
 	kfree(node);
 }
 
@@ -821,44 +847,13 @@ static void qrtr_backup_deinit(void)
 	skb_queue_purge(&qrtr_backup_hi);
 }
 
-/**
- * qrtr_endpoint_post() - post incoming data
- * @ep: endpoint handle
- * @data: data pointer
- * @len: size of data in bytes
- *
- * Return: 0 on success; negative error code on failure
- */
-int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
+/* parse the router header in @data into @cb, 0 if it describes @len bytes */
+static int qrtr_parse_hdr(struct qrtr_cb *cb, const void *data, size_t len,
+			  size_t *hdrlen, size_t *size)
 {
-	struct qrtr_node *node = ep->node;
 	const struct qrtr_hdr_v1 *v1;
 	const struct qrtr_hdr_v2 *v2;
-	struct qrtr_ctrl_pkt *pkt;
-	struct qrtr_sock *ipc;
-	struct sk_buff *skb;
-	struct qrtr_cb *cb;
-	size_t size;
 	unsigned int ver;
-	size_t hdrlen;
-	int errcode, i;
-	bool wake = true;
-	int svc_id;
-
-	if (len == 0 || len & 3)
-		return -EINVAL;
-
-	skb = alloc_skb_with_frags(sizeof(*v1), len, 0, &errcode, GFP_ATOMIC);
-	if (!skb) {
-		skb = qrtr_get_backup(len);
-		if (!skb) {
-			pr_err("qrtr: Unable to get skb with len:%lu\n", len);
-			return -ENOMEM;
-		}
-	}
-
-	skb_reserve(skb, sizeof(*v1));
-	cb = (struct qrtr_cb *)skb->cb;
 
 	/* Version field in v1 is little endian, so this works for both cases */
 	ver = *(u8*)data;
@@ -866,9 +861,9 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 	switch (ver) {
 	case QRTR_PROTO_VER_1:
 		if (len < sizeof(*v1))
-			goto err;
+			return -EINVAL;
 		v1 = data;
-		hdrlen = sizeof(*v1);
+		*hdrlen = sizeof(*v1);
 
 		cb->type = le32_to_cpu(v1->type);
 		cb->src_node = le32_to_cpu(v1->src_node_id);
@@ -877,13 +872,13 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 		cb->dst_node = le32_to_cpu(v1->dst_node_id);
 		cb->dst_port = le32_to_cpu(v1->dst_port_id);
 
-		size = le32_to_cpu(v1->size);
+		*size = le32_to_cpu(v1->size);
 		break;
 	case QRTR_PROTO_VER_2:
 		if (len < sizeof(*v2))
-			goto err;
+			return -EINVAL;
 		v2 = data;
-		hdrlen = sizeof(*v2) + v2->optlen;
+		*hdrlen = sizeof(*v2) + v2->optlen;
 
 		cb->type = v2->type;
 		cb->confirm_rx = !!(v2->flags & QRTR_FLAGS_CONFIRM_RX);
@@ -897,30 +892,60 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 		if (cb->dst_port == (u16)QRTR_PORT_CTRL)
 			cb->dst_port = QRTR_PORT_CTRL;
 
-		size = le32_to_cpu(v2->size);
+		*size = le32_to_cpu(v2->size);
 		break;
 	default:
 		pr_err("qrtr: Invalid version %d\n", ver);
-		goto err;
+		return -EINVAL;
 	}
 
 	if (cb->dst_port == QRTR_PORT_CTRL_LEGACY)
 		cb->dst_port = QRTR_PORT_CTRL;
 
-	if (!size || len != ALIGN(size, 4) + hdrlen)
-		goto err;
+	if (!*size || len != ALIGN(*size, 4) + *hdrlen)
+		return -EINVAL;
 
 	if (cb->dst_port != QRTR_PORT_CTRL && cb->type != QRTR_TYPE_DATA &&
 	    cb->type != QRTR_TYPE_RESUME_TX)
-		goto err;
+		return -EINVAL;
 
-	skb->data_len = size;
-	skb->len = size;
-	skb_store_bits(skb, 0, data + hdrlen, size);
+	return 0;
+}
+
+/*
+ * Queue a packet for forwarding on the lane of its destination, so a
+ * destination that blocks in flow control or in the transport does not
+ * hold up packets for other destinations or control packets of the node.
+ * Each queued run of a lane work holds a node reference.
+ */
+static void qrtr_rx_lane_queue(struct qrtr_node *node, struct sk_buff *skb)
+{
+	struct qrtr_cb *cb = (struct qrtr_cb *)skb->cb;
+	struct qrtr_rx_lane *lane;
+	u32 key = (cb->dst_node << 16) ^ cb->dst_port;
+
+	lane = &node->rx_lanes[hash_32(key, QRTR_RX_LANES_SHIFT)];
+	skb_queue_tail(&lane->queue, skb);
+
+	qrtr_node_acquire(node);
+	if (!queue_work(qrtr_rx_wq, &lane->work))
+		qrtr_node_release(node);
+}
+
+/* deliver a parsed packet, @skb holds the payload and is consumed */
+static int qrtr_endpoint_rx(struct qrtr_node *node, struct sk_buff *skb,
+			    const void *payload)
+{
+	struct qrtr_cb *cb = (struct qrtr_cb *)skb->cb;
+	const struct qrtr_ctrl_pkt *pkt;
+	struct qrtr_sock *ipc;
+	bool wake = true;
+	int svc_id;
+	int i;
 
 	qrtr_node_assign(node, cb->src_node);
 	if (cb->type == QRTR_TYPE_NEW_SERVER) {
-		pkt = (void *)data + hdrlen;
+		pkt = payload;
 		qrtr_node_assign(node, le32_to_cpu(pkt->server.node));
 	}
 
@@ -928,7 +953,10 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 	/* All control packets and non-local destined data packets should be
 	 * queued to the worker for forwarding handling.
 	 */
-	if (cb->type != QRTR_TYPE_DATA || cb->dst_node != qrtr_local_nid) {
+	if (cb->type == QRTR_TYPE_DATA && cb->dst_node != qrtr_local_nid) {
+		qrtr_rx_lane_queue(node, skb);
+		pm_wakeup_ws_event(node->ws, qrtr_wakeup_ms, true);
+	} else if (cb->type != QRTR_TYPE_DATA) {
 		skb_queue_tail(&node->rx_queue, skb);
 		kthread_queue_work(&node->kworker, &node->read_data);
 		pm_wakeup_ws_event(node->ws, qrtr_wakeup_ms, true);
@@ -951,8 +979,10 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 			}
 		}
 
-		if (sock_queue_rcv_skb(&ipc->sk, skb))
-			goto err;
+		if (sock_queue_rcv_skb(&ipc->sk, skb)) {
+			kfree_skb(skb);
+			return -EINVAL;
+		}
 
 		/**
 		 * Force wakeup for all packets except for sensors and blacklisted services
@@ -966,6 +996,49 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 	}
 
 	return 0;
+}
+
+/**
+ * qrtr_endpoint_post() - post incoming data
+ * @ep: endpoint handle
+ * @data: data pointer
+ * @len: size of data in bytes
+ *
+ * Return: 0 on success; negative error code on failure
+ */
+int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
+{
+	struct qrtr_node *node = ep->node;
+	struct sk_buff *skb;
+	struct qrtr_cb *cb;
+	size_t size;
+	size_t hdrlen;
+	int errcode;
+
+	if (len == 0 || len & 3)
+		return -EINVAL;
+
+	skb = alloc_skb_with_frags(sizeof(struct qrtr_hdr_v1), len, 0, &errcode,
+				   GFP_ATOMIC);
+	if (!skb) {
+		skb = qrtr_get_backup(len);
+		if (!skb) {
+			pr_err("qrtr: Unable to get skb with len:%lu\n", len);
+			return -ENOMEM;
+		}
+	}
+
+	skb_reserve(skb, sizeof(struct qrtr_hdr_v1));
+	cb = (struct qrtr_cb *)skb->cb;
+
+	if (qrtr_parse_hdr(cb, data, len, &hdrlen, &size))
+		goto err;
+
+	skb->data_len = size;
+	skb->len = size;
+	skb_store_bits(skb, 0, data + hdrlen, size);
+
+	return qrtr_endpoint_rx(node, skb, data + hdrlen);
 
 err:
 	kfree_skb(skb);
@@ -974,6 +1047,57 @@ int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len)
 }
 EXPORT_SYMBOL_GPL(qrtr_endpoint_post);
 
+/**
+ * qrtr_endpoint_post_skb() - post an incoming packet without copying it
+ * @ep: endpoint handle
+ * @skb: complete router packet, header included, owned by qrtr on return
+ *
+ * The router header and control payloads are pulled into the linear area,
+ * data payloads stay wherever the transport placed them, head or frags.
+ * Transports should leave QRTR_EP_RX_HEADROOM bytes of headroom so that
+ * packets forwarded to another node do not need to be reallocated.
+ *
+ * Return: 0 on success; negative error code on failure
+ */
+int qrtr_endpoint_post_skb(struct qrtr_endpoint *ep, struct sk_buff *skb)
+{
+	struct qrtr_node *node = ep->node;
+	struct qrtr_cb *cb = (struct qrtr_cb *)skb->cb;
+	size_t len = skb->len;
+	size_t size;
+	size_t hdrlen;
+
+	if (len == 0 || len & 3)
+		goto err;
+
+	if (!pskb_may_pull(skb, min_t(size_t, len, QRTR_HDR_MAX_SIZE)))
+		goto err;
+
+	if (qrtr_parse_hdr(cb, skb->data, len, &hdrlen, &size) ||
+	    !pskb_may_pull(skb, hdrlen))
+		goto err;
+
+	/* strip the header and the alignment padding */
+	skb_pull(skb, hdrlen);
+	if (pskb_trim(skb, size))
+		goto err;
+
+	if (cb->type != QRTR_TYPE_DATA &&
+	    !pskb_may_pull(skb, min_t(size_t, size,
+				      sizeof(struct qrtr_ctrl_pkt))))
+		goto err;
+
+	if (skb_cow_head(skb, QRTR_EP_RX_HEADROOM))
+		goto err;
+
+	return qrtr_endpoint_rx(node, skb, skb->data);
+
+err:
+	kfree_skb(skb);
+	return -EINVAL;
+}
+EXPORT_SYMBOL_GPL(qrtr_endpoint_post_skb);
+
 /**
  * qrtr_alloc_ctrl_packet() - allocate control packet skb
  * @pkt: reference to qrtr_ctrl_pkt pointer
@@ -1069,6 +1193,20 @@ static void qrtr_fwd_pkt(struct sk_buff *skb, struct qrtr_cb *cb)
 	qrtr_node_release(node);
 }
 
+static void qrtr_rx_lane_work(struct work_struct *work)
+{
+	struct qrtr_rx_lane *lane = container_of(work, struct qrtr_rx_lane,
+						 work);
+	struct qrtr_node *node = lane->node;
+	struct sk_buff *skb;
+
+	while ((skb = skb_dequeue(&lane->queue)) != NULL)
+		qrtr_fwd_pkt(skb, (struct qrtr_cb *)skb->cb);
+
+	/* drop the reference taken when this run was queued, may free node */
+	qrtr_node_release(node);
+}
+
 static void qrtr_sock_queue_skb(struct qrtr_node *node, struct sk_buff *skb,
 				struct qrtr_sock *ipc)
 {
@@ -1174,6 +1312,7 @@ int qrtr_endpoint_register(struct qrtr_endpoint *ep, unsigned int net_id,
 {
 	struct qrtr_node *node;
 	struct sched_param param = {.sched_priority = 1};
+	int i;
 
 	if (!ep || !ep->xmit)
 		return -EINVAL;
@@ -1185,6 +1324,11 @@ int qrtr_endpoint_register(struct qrtr_endpoint *ep, unsigned int net_id,
 	kref_init(&node->ref);
 	mutex_init(&node->ep_lock);
 	skb_queue_head_init(&node->rx_queue);
+	for (i = 0; i < QRTR_RX_LANES; i++) {
+		node->rx_lanes[i].node = node;
+		skb_queue_head_init(&node->rx_lanes[i].queue);
+		INIT_WORK(&node->rx_lanes[i].work, qrtr_rx_lane_work);
+	}
 	node->nid = QRTR_EP_NID_AUTO;
 	node->ep = ep;
 	atomic_set(&node->hello_sent, 0);
@@ -1333,22 +1477,24 @@ void qrtr_endpoint_unregister(struct qrtr_endpoint *ep)
 EXPORT_SYMBOL_GPL(qrtr_endpoint_unregister);
 
 /* Lookup socket by port.
+ *
+ * Sockets are freed after a grace period so the lookup only needs rcu, a
+ * socket whose last reference is already gone is treated as not found.
  *
  * Callers must release with qrtr_port_put()
  */
 static struct qrtr_sock *qrtr_port_lookup(int port)
 {
 	struct qrtr_sock *ipc;
-	unsigned long flags;
 
 	if (port == QRTR_PORT_CTRL)
 		port = 0;
 
-	spin_lock_irqsave(&qrtr_port_lock, flags);
+	rcu_read_lock();
 	ipc = idr_find(&qrtr_ports, port);
-	if (ipc)
-		sock_hold(&ipc->sk);
-	spin_unlock_irqrestore(&qrtr_port_lock, flags);
+	if (ipc && !refcount_inc_not_zero(&ipc->sk.sk_refcnt))
+		ipc = NULL;
+	rcu_read_unlock();
 
 	return ipc;
 }
@@ -2042,6 +2188,8 @@ static int qrtr_create(struct net *net, struct socket *sock,
 		return -ENOMEM;
 
 	sock_set_flag(sk, SOCK_ZAPPED);
+	/* port lookups run under rcu only */
+	sock_set_flag(sk, SOCK_RCU_FREE);
 
 	sock_init_data(sock, sk);
 	sock->ops = &qrtr_proto_ops;
@@ -2069,8 +2217,16 @@ static int __init qrtr_proto_init(void)
 	if (rc)
 		return rc;
 
+	qrtr_rx_wq = alloc_workqueue("qrtr_rx", WQ_UNBOUND | WQ_HIGHPRI |
+				     WQ_MEM_RECLAIM, 0);
+	if (!qrtr_rx_wq) {
+		proto_unregister(&qrtr_proto);
+		return -ENOMEM;
+	}
+
 	rc = sock_register(&qrtr_family);
 	if (rc) {
+		destroy_workqueue(qrtr_rx_wq);
 		proto_unregister(&qrtr_proto);
 		return rc;
 	}
@@ -2088,6 +2244,7 @@ static void __exit qrtr_proto_fini(void)
 	qrtr_ns_remove();
 	sock_unregister(qrtr_family.family);
 	proto_unregister(&qrtr_proto);
+	destroy_workqueue(qrtr_rx_wq);
 
 	qrtr_backup_deinit();
 }
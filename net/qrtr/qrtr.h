@@ -14,6 +14,9 @@ struct sk_buff;
 
 #define MAX_NON_WAKE_SVC_LEN    5
 
+/* headroom for qrtr_endpoint_post_skb() to push a v1 header in place */
+#define QRTR_EP_RX_HEADROOM	32
+
 /**
  * struct qrtr_endpoint - endpoint handle
  * @xmit: Callback for outgoing packets
@@ -35,6 +38,8 @@ void qrtr_endpoint_unregister(struct qrtr_endpoint *ep);
 
 int qrtr_endpoint_post(struct qrtr_endpoint *ep, const void *data, size_t len);
 
+int qrtr_endpoint_post_skb(struct qrtr_endpoint *ep, struct sk_buff *skb);
+
 void qrtr_ns_init(void);
 
 void qrtr_ns_remove(void);
@@ -17,6 +17,7 @@
 #include <linux/of.h>
 #include <linux/wait.h>
 #include <linux/sched.h>
+#include <linux/mm.h>
 #if IS_ENABLED(CONFIG_AVTIMER_LEGACY)
 #include <media/msmb_isp.h>
 #endif
@@ -58,6 +59,10 @@ struct avtimer_t {
 	int timer_handle;
 	void __iomem *p_avtimer_msw;
 	void __iomem *p_avtimer_lsw;
+	phys_addr_t mmap_base;
+	u32 lsw_offset;
+	u32 msw_offset;
+	bool mmap_supported;
 	uint32_t clk_div;
 	uint32_t clk_mult;
 	atomic_t adsp_ready;
@@ -452,13 +457,63 @@ static long avtimer_ioctl(struct file *file, unsigned int ioctl_num,
 	return 0;
 }
 
+/*
+ * mmap exposes the page holding the avtimer counter read-only, so media
+ * clients can sample it without a syscall. The register offsets within
+ * the page and the tick scaling are published in sysfs. Clients must
+ * read msw, lsw, msw and retry if msw changed; the power collapse vote
+ * taken at open stays held for as long as the mapping exists.
+ */
+static int avtimer_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	if (!avtimer.mmap_supported)
+		return -ENODEV;
+
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+
+	if (vma->vm_flags & (VM_WRITE | VM_EXEC))
+		return -EPERM;
+
+	vma->vm_flags &= ~(VM_MAYWRITE | VM_MAYEXEC);
+	vma->vm_flags |= VM_IO | VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	return io_remap_pfn_range(vma, vma->vm_start,
+				  avtimer.mmap_base >> PAGE_SHIFT,
+				  PAGE_SIZE, vma->vm_page_prot);
+}
+
 static const struct file_operations avtimer_fops = {
 	.unlocked_ioctl = avtimer_ioctl,
 	.compat_ioctl = avtimer_ioctl,
+	.mmap = avtimer_mmap,
 	.open = avtimer_open,
 	.release = avtimer_release
 };
 
+#define AVTIMER_ATTR_RO(_name)						\
+static ssize_t _name##_show(struct device *dev,				\
+			    struct device_attribute *attr, char *buf)	\
+{									\
+	return scnprintf(buf, PAGE_SIZE, "%u\n", avtimer._name);	\
+}									\
+static DEVICE_ATTR_RO(_name)
+
+AVTIMER_ATTR_RO(lsw_offset);
+AVTIMER_ATTR_RO(msw_offset);
+AVTIMER_ATTR_RO(clk_mult);
+AVTIMER_ATTR_RO(clk_div);
+
+static struct attribute *avtimer_attrs[] = {
+	&dev_attr_lsw_offset.attr,
+	&dev_attr_msw_offset.attr,
+	&dev_attr_clk_mult.attr,
+	&dev_attr_clk_div.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(avtimer);
+
 static int dev_avtimer_probe(struct platform_device *pdev)
 {
 	int result = 0;
@@ -503,6 +558,15 @@ static int dev_avtimer_probe(struct platform_device *pdev)
 			__func__);
 		goto unmap;
 	}
+	avtimer.mmap_base = reg_lsb->start & PAGE_MASK;
+	avtimer.lsw_offset = offset_in_page(reg_lsb->start);
+	avtimer.msw_offset = offset_in_page(reg_msb->start);
+	avtimer.mmap_supported = (reg_msb->start & PAGE_MASK) ==
+				 avtimer.mmap_base;
+	if (!avtimer.mmap_supported)
+		dev_info(&pdev->dev, "%s: avtimer registers span pages, no mmap\n",
+			 __func__);
+
 	avtimer.num_retries = Q6_READY_MAX_RETRIES;
 	/* get the device number */
 	if (major)
@@ -535,8 +599,8 @@ static int dev_avtimer_probe(struct platform_device *pdev)
 		goto class_destroy;
 	}
 
-	device_handle = device_create(avtimer.avtimer_class,
-			NULL, avtimer.myc.dev, NULL, "avtimer");
+	device_handle = device_create_with_groups(avtimer.avtimer_class,
+			NULL, avtimer.myc.dev, NULL, avtimer_groups, "avtimer");
 	if (IS_ERR(device_handle)) {
 		result = PTR_ERR(device_handle);
 		pr_err("%s: device_create failed: %d\n", __func__, result);
@@ -45,6 +45,7 @@ struct msm_audio_alloc_data {
 	struct dma_buf_attachment *attach;
 	struct sg_table *table;
 	struct list_head list;
+	bool user_mapped;
 };
 
 static struct msm_audio_ion_private msm_audio_ion_data = {0,};
@@ -655,6 +656,7 @@ int msm_audio_ion_mmap(struct audio_buffer *abuff,
 		if (alloc_data->dma_buf == abuff->dma_buf) {
 			found = true;
 			table = alloc_data->table;
+			alloc_data->user_mapped = true;
 			break;
 		}
 	}
@@ -712,6 +714,33 @@ int msm_audio_ion_mmap(struct audio_buffer *abuff,
 }
 EXPORT_SYMBOL(msm_audio_ion_mmap);
 
+/**
+ * msm_audio_ion_is_user_mapped -
+ *       Check if ION memory was mapped to user space
+ *
+ * @dma_buf: dma_buf for the ION memory
+ *
+ * Returns true if msm_audio_ion_mmap was called for the memory
+ */
+bool msm_audio_ion_is_user_mapped(struct dma_buf *dma_buf)
+{
+	struct msm_audio_alloc_data *alloc_data = NULL;
+	bool user_mapped = false;
+
+	mutex_lock(&(msm_audio_ion_data.list_mutex));
+	list_for_each_entry(alloc_data, &(msm_audio_ion_data.alloc_list),
+			    list) {
+		if (alloc_data->dma_buf == dma_buf) {
+			user_mapped = alloc_data->user_mapped;
+			break;
+		}
+	}
+	mutex_unlock(&(msm_audio_ion_data.list_mutex));
+
+	return user_mapped;
+}
+EXPORT_SYMBOL(msm_audio_ion_is_user_mapped);
+
 /**
  * msm_audio_ion_cache_operations-
  *       Cache operations on cached Audio ION buffers
@@ -11,6 +11,7 @@
 #include <linux/jiffies.h>
 #include <linux/sched.h>
 #include <linux/delay.h>
+#include <linux/crc32.h>
 #include <dsp/msm_audio_ion.h>
 #include <dsp/apr_audio-v2.h>
 #include <dsp/audio_cal_utils.h>
@@ -209,6 +210,20 @@ struct afe_sp_v4_max_log_get_param_resp {
 		ch_max_params[SP_V4_NUM_MAX_SPKRS];
 } __packed;
 
+/*
+ * struct afe_cal_cache - common calibration last sent to an AFE port
+ * @cal_index: AFE cal type of the calibration, valid when @size is set
+ * @topology: port topology the calibration was sent for
+ * @size: size of the calibration payload
+ * @crc: crc32 of the calibration payload
+ */
+struct afe_cal_cache {
+	int cal_index;
+	int topology;
+	size_t size;
+	u32 crc;
+};
+
 struct afe_ctl {
 	void *apr;
 	atomic_t state;
@@ -298,6 +313,11 @@ struct afe_ctl {
 	uint32_t cps_ch_mask;
 	struct afe_cps_hw_intf_cfg *cps_config;
 	int lsm_afe_ports[MAX_LSM_SESSIONS];
+	/* port params packed to be sent with a single set param command */
+	u8 *param_batch;
+	u32 param_batch_size;
+	u16 param_batch_port;
+	struct afe_cal_cache cal_cache[AFE_MAX_PORTS];
 #if defined(CONFIG_SND_SOC_AW88263S_M20_TDM)
 	struct rtac_cal_block_data aw_cal;
 	atomic_t aw_state;
@@ -1089,6 +1109,9 @@ static int32_t afe_callback(struct apr_client_data *data, void *priv)
 		cal_utils_clear_cal_block_q6maps(MAX_AFE_CAL_TYPES,
 			this_afe.cal_data);
 
+		/* The DSP lost all port calibration, send it again */
+		memset(this_afe.cal_cache, 0, sizeof(this_afe.cal_cache));
+
 		/* Reset the custom topology mode: to resend again to AFE. */
 		mutex_lock(&this_afe.cal_data[AFE_CUST_TOPOLOGY_CAL]->lock);
 		this_afe.set_custom_topology = 1;
@@ -1834,6 +1857,90 @@ static int q6afe_set_params(u16 port_id, int index,
 					   packed_param_data, packed_data_size);
 }
 
+#define AFE_PARAM_BATCH_MAX_SIZE \
+	(APR_MAX_BUF - max(sizeof(struct afe_port_cmd_set_param_v2), \
+			   sizeof(struct afe_port_cmd_set_param_v3)))
+
+static int q6afe_param_batch_flush(void)
+{
+	u16 port_id = this_afe.param_batch_port;
+	int ret;
+
+	if (!this_afe.param_batch_size)
+		return 0;
+
+	ret = q6afe_set_params(port_id, q6audio_get_port_index(port_id), NULL,
+			       this_afe.param_batch,
+			       this_afe.param_batch_size);
+	if (ret)
+		pr_err("%s: batched params for port 0x%x failed %d\n",
+		       __func__, this_afe.param_batch_port, ret);
+
+	this_afe.param_batch_size = 0;
+	return ret;
+}
+
+/*
+ * Collect the in band params set on @port_id from now on and send them
+ * together, one APR round trip instead of one per param. Errors of the
+ * collected params are only reported by q6afe_param_batch_end(). Must be
+ * called with afe_cmd_lock held, if the buffer can't be allocated the
+ * params are sent one by one as before.
+ */
+static void q6afe_param_batch_begin(u16 port_id)
+{
+	if (this_afe.param_batch)
+		return;
+
+	this_afe.param_batch = kzalloc(AFE_PARAM_BATCH_MAX_SIZE, GFP_KERNEL);
+	this_afe.param_batch_size = 0;
+	this_afe.param_batch_port = port_id;
+}
+
+/* Sends the collected params unless @ret reports a failure already */
+static int q6afe_param_batch_end(int ret)
+{
+	if (!this_afe.param_batch)
+		return ret;
+
+	if (!ret)
+		ret = q6afe_param_batch_flush();
+	this_afe.param_batch_size = 0;
+	kfree(this_afe.param_batch);
+	this_afe.param_batch = NULL;
+
+	return ret;
+}
+
+/* Returns -ENOSPC if the param has to be sent on its own */
+static int q6afe_param_batch_add(struct param_hdr_v3 *param_hdr,
+				 u8 *param_data)
+{
+	u32 packed_size = sizeof(union param_hdrs) + param_hdr->param_size;
+	int ret;
+
+	/* params are packed back to back, which keeps them word aligned */
+	if (!IS_ALIGNED(param_hdr->param_size, 4) ||
+	    packed_size > AFE_PARAM_BATCH_MAX_SIZE)
+		return -ENOSPC;
+
+	if (this_afe.param_batch_size + packed_size >
+	    AFE_PARAM_BATCH_MAX_SIZE) {
+		ret = q6afe_param_batch_flush();
+		if (ret)
+			return ret;
+	}
+
+	ret = q6common_pack_pp_params(this_afe.param_batch +
+				      this_afe.param_batch_size, param_hdr,
+				      param_data, &packed_size);
+	if (ret)
+		return ret;
+
+	this_afe.param_batch_size += packed_size;
+	return 0;
+}
+
 static int q6afe_pack_and_set_param_in_band(u16 port_id, int index,
 					    struct param_hdr_v3 param_hdr,
 					    u8 *param_data)
@@ -1842,6 +1949,17 @@ static int q6afe_pack_and_set_param_in_band(u16 port_id, int index,
 	int packed_data_size = sizeof(union param_hdrs) + param_hdr.param_size;
 	int ret;
 
+	if (this_afe.param_batch && port_id == this_afe.param_batch_port) {
+		ret = q6afe_param_batch_add(&param_hdr, param_data);
+		if (ret != -ENOSPC)
+			return ret;
+
+		/* keep the order of the params sent to the port */
+		ret = q6afe_param_batch_flush();
+		if (ret)
+			return ret;
+	}
+
 	packed_param_data = kzalloc(packed_data_size, GFP_KERNEL);
 	if (packed_param_data == NULL)
 		return -ENOMEM;
@@ -3429,6 +3547,7 @@ static int afe_send_port_topology_id(u16 port_id)
 	if (ret) {
 		pr_err("%s: AFE set topology id enable for port 0x%x failed %d\n",
 			__func__, port_id, ret);
+		this_afe.cal_cache[index].size = 0;
 		goto done;
 	}
 
@@ -3786,6 +3905,40 @@ static struct cal_block_data *afe_find_cal(int cal_index, int port_id)
 	return cal_block;
 }
 
+/*
+ * Check if the DSP already holds @cal_block as the common calibration of
+ * the port, userspace sets the same calibration again on every routing
+ * change. Otherwise remember it as the port calibration and return false.
+ */
+static bool afe_cal_cache_hit(int index, int cal_index,
+			      struct cal_block_data *cal_block)
+{
+	struct afe_cal_cache *cache = &this_afe.cal_cache[index];
+	u32 crc;
+
+	if (cal_index != AFE_COMMON_RX_CAL && cal_index != AFE_COMMON_TX_CAL &&
+	    cal_index != AFE_LSM_TX_CAL)
+		return false;
+
+	if (!cal_block->cal_data.kvaddr || cal_block->cal_data.size <= 0)
+		return false;
+
+	crc = crc32_le(~0, cal_block->cal_data.kvaddr,
+		       cal_block->cal_data.size);
+	if (cache->size == cal_block->cal_data.size &&
+	    cache->cal_index == cal_index &&
+	    cache->topology == this_afe.topology[index] &&
+	    cache->crc == crc)
+		return true;
+
+	cache->cal_index = cal_index;
+	cache->topology = this_afe.topology[index];
+	cache->size = cal_block->cal_data.size;
+	cache->crc = crc;
+
+	return false;
+}
+
 static int send_afe_cal_type(int cal_index, int port_id)
 {
 	struct cal_block_data		*cal_block = NULL;
@@ -3827,19 +3980,31 @@ static int send_afe_cal_type(int cal_index, int port_id)
 		goto unlock;
 	}
 
+	if (afe_cal_cache_hit(afe_port_index, cal_index, cal_block)) {
+		pr_debug("%s: cal_index %d unchanged for port 0x%x\n",
+			 __func__, cal_index, port_id);
+		ret = 0;
+		goto mark_used;
+	}
+
 	pr_debug("%s: Sending cal_index cal %d\n", __func__, cal_index);
 
 	ret = remap_cal_data(cal_block, cal_index);
 	if (ret) {
 		pr_err("%s: Remap_cal_data failed for cal %d!\n",
 			__func__, cal_index);
+		this_afe.cal_cache[afe_port_index].size = 0;
 		ret = -EINVAL;
 		goto unlock;
 	}
 	ret = afe_send_cal_block(port_id, cal_block);
-	if (ret < 0)
+	if (ret < 0) {
 		pr_err("%s: No cal sent for cal_index %d, port_id = 0x%x! ret %d\n",
 			__func__, cal_index, port_id, ret);
+		this_afe.cal_cache[afe_port_index].size = 0;
+	}
+
+mark_used:
 
 	cal_utils_mark_cal_used(cal_block);
 
@@ -6564,11 +6729,13 @@ static int __afe_port_start(u16 port_id, union afe_port_config *afe_config,
 				}
 			}
 
+			q6afe_param_batch_begin(port_id);
 			ret = q6afe_send_enc_config(port_id, enc_cfg,
 						    codec_format, *afe_config,
 						    afe_in_channels,
 						    afe_in_bit_width,
 						    scrambler_mode, mono_mode);
+			ret = q6afe_param_batch_end(ret);
 			if (ret) {
 				pr_err("%s: AFE encoder config for port 0x%x failed %d\n",
 					__func__, port_id, ret);
@@ -6601,10 +6768,12 @@ static int __afe_port_start(u16 port_id, union afe_port_config *afe_config,
 					goto fail_cmd;
 				}
 			}
+			q6afe_param_batch_begin(port_id);
 			ret = q6afe_send_dec_config(port_id, *afe_config,
 						    dec_cfg, codec_format,
 						    afe_in_channels,
 						    afe_in_bit_width);
+			ret = q6afe_param_batch_end(ret);
 			if (ret) {
 				pr_err("%s: AFE decoder config for port 0x%x failed %d\n",
 					 __func__, port_id, ret);
@@ -6612,8 +6781,10 @@ static int __afe_port_start(u16 port_id, union afe_port_config *afe_config,
 			}
 		}
 		if (ttp_cfg != NULL) {
+			q6afe_param_batch_begin(port_id);
 			ret = q6afe_send_ttp_config(port_id, *afe_config,
 						    ttp_cfg);
+			ret = q6afe_param_batch_end(ret);
 			if (ret) {
 				pr_err("%s: AFE TTP config for port 0x%x failed %d\n",
 					 __func__, port_id, ret);
@@ -28,6 +28,7 @@
 #include <linux/time.h>
 #include <linux/atomic.h>
 #include <linux/mm.h>
+#include <linux/workqueue.h>
 
 #include <asm/ioctls.h>
 
@@ -51,6 +52,10 @@
 
 #define ENC_FRAMES_PER_BUFFER 0x01
 
+/* Idle contiguous stream buffers stay mapped to the ADSP for reuse */
+#define ASM_BUF_POOL_MAX_BYTES	SZ_2M
+#define ASM_BUF_POOL_IDLE_MS	5000
+
 enum {
 	ASM_TOPOLOGY_CAL = 0,
 	ASM_CUSTOM_TOP_CAL,
@@ -136,6 +141,35 @@ static int q6asm_get_asm_topology_apptype(struct q6asm_cal_info *cal_info, struc
 static struct cal_type_data *cal_data[ASM_MAX_CAL_TYPES];
 static struct audio_buffer common_buf[2];
 static struct audio_client common_client;
+
+/*
+ * struct asm_buf_pool_entry - idle stream buffer, mapped in SMMU and ADSP
+ * @list: entry in the pool free list
+ * @dma_buf: ION memory of the buffer
+ * @phys: device address of the buffer
+ * @data: kernel address of the buffer
+ * @size: size of the ADSP mapping
+ * @mmap_hdl: ADSP shared memory map handle
+ * @idle_since: jiffies when the buffer was given back
+ */
+struct asm_buf_pool_entry {
+	struct list_head list;
+	struct dma_buf *dma_buf;
+	phys_addr_t phys;
+	void *data;
+	size_t size;
+	uint32_t mmap_hdl;
+	unsigned long idle_since;
+};
+
+struct asm_buf_pool {
+	struct mutex lock;
+	struct list_head free;
+	size_t free_bytes;
+	struct delayed_work shrink_work;
+};
+
+static struct asm_buf_pool asm_buf_pool;
 static int set_custom_topology;
 static int topology_map_handle;
 
@@ -1174,6 +1208,183 @@ int q6asm_unmap_rtac_block(uint32_t *mem_map_handle)
 	return result;
 }
 
+static void q6asm_buf_pool_release(struct asm_buf_pool_entry *entry,
+				   bool unmap)
+{
+	struct asm_buffer_node *buf_node;
+	int rc = 0;
+
+	if (unmap) {
+		if (!common_client.mmap_apr)
+			common_client.mmap_apr = q6asm_mmap_apr_reg();
+		buf_node = kzalloc(sizeof(*buf_node), GFP_KERNEL);
+		if (!common_client.mmap_apr || !buf_node) {
+			kfree(buf_node);
+			rc = -ENOMEM;
+			goto done;
+		}
+
+		buf_node->buf_phys_addr = entry->phys;
+		buf_node->mmap_hdl = entry->mmap_hdl;
+		mutex_lock(&common_client.cmd_lock);
+		list_add_tail(&buf_node->list,
+			      &common_client.port[IN].mem_map_handle);
+		mutex_unlock(&common_client.cmd_lock);
+
+		rc = q6asm_memory_unmap(&common_client, entry->phys, IN);
+		if (rc < 0)
+			pr_err("%s: unmap of handle 0x%x failed %d\n",
+				__func__, entry->mmap_hdl, rc);
+	}
+
+done:
+	/* ADSP may still access memory it failed to unmap, leak it */
+	if (!rc)
+		msm_audio_ion_free(entry->dma_buf);
+	kfree(entry);
+}
+
+static void q6asm_buf_pool_shrink(struct work_struct *work)
+{
+	unsigned long idle = msecs_to_jiffies(ASM_BUF_POOL_IDLE_MS);
+	struct asm_buf_pool_entry *entry, *tmp;
+	LIST_HEAD(release);
+
+	mutex_lock(&asm_buf_pool.lock);
+	list_for_each_entry_safe(entry, tmp, &asm_buf_pool.free, list) {
+		if (time_before(jiffies, entry->idle_since + idle))
+			continue;
+		list_move_tail(&entry->list, &release);
+		asm_buf_pool.free_bytes -= entry->size;
+	}
+	if (!list_empty(&asm_buf_pool.free))
+		schedule_delayed_work(&asm_buf_pool.shrink_work, idle);
+	mutex_unlock(&asm_buf_pool.lock);
+
+	list_for_each_entry_safe(entry, tmp, &release, list)
+		q6asm_buf_pool_release(entry, true);
+}
+
+/* Free all pooled buffers, @unmap is false if the ADSP lost its mappings */
+static void q6asm_buf_pool_drain(bool unmap)
+{
+	struct asm_buf_pool_entry *entry, *tmp;
+	LIST_HEAD(release);
+
+	mutex_lock(&asm_buf_pool.lock);
+	list_splice_init(&asm_buf_pool.free, &release);
+	asm_buf_pool.free_bytes = 0;
+	mutex_unlock(&asm_buf_pool.lock);
+
+	list_for_each_entry_safe(entry, tmp, &release, list)
+		q6asm_buf_pool_release(entry, unmap);
+}
+
+static struct asm_buf_pool_entry *q6asm_buf_pool_get(size_t size)
+{
+	struct asm_buf_pool_entry *entry, *found = NULL;
+
+	mutex_lock(&asm_buf_pool.lock);
+	list_for_each_entry(entry, &asm_buf_pool.free, list) {
+		if (entry->size == size) {
+			list_del(&entry->list);
+			asm_buf_pool.free_bytes -= size;
+			found = entry;
+			break;
+		}
+	}
+	mutex_unlock(&asm_buf_pool.lock);
+
+	return found;
+}
+
+/*
+ * Hand the port buffer of @ac over to the pool with its ADSP mapping. Must
+ * be called with the cmd_lock of @ac held. Returns false if the buffer has
+ * to be unmapped and freed by the caller.
+ */
+static bool q6asm_buf_pool_put(struct audio_client *ac, int dir)
+{
+	struct audio_port_data *port = &ac->port[dir];
+	struct asm_buffer_node *buf_node, *head = NULL, *next;
+	struct asm_buf_pool_entry *entry;
+	size_t size;
+
+	if (atomic_read(&ac->reset) || !port->buf[0].data ||
+	    port->max_buf_cnt <= 0)
+		return false;
+
+	/* User space may still access memory mapped to it */
+	if (msm_audio_ion_is_user_mapped(port->buf[0].dma_buf))
+		return false;
+
+	size = PAGE_ALIGN(port->buf[0].size * port->max_buf_cnt);
+	list_for_each_entry(buf_node, &port->mem_map_handle, list) {
+		if (buf_node->buf_phys_addr == port->buf[0].phys) {
+			head = buf_node;
+			break;
+		}
+	}
+	if (!head)
+		return false;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return false;
+
+	mutex_lock(&asm_buf_pool.lock);
+	if (asm_buf_pool.free_bytes + size > ASM_BUF_POOL_MAX_BYTES) {
+		mutex_unlock(&asm_buf_pool.lock);
+		kfree(entry);
+		return false;
+	}
+
+	entry->dma_buf = port->buf[0].dma_buf;
+	entry->phys = port->buf[0].phys;
+	entry->data = port->buf[0].data;
+	entry->size = size;
+	entry->mmap_hdl = head->mmap_hdl;
+	entry->idle_since = jiffies;
+	list_add(&entry->list, &asm_buf_pool.free);
+	asm_buf_pool.free_bytes += size;
+	schedule_delayed_work(&asm_buf_pool.shrink_work,
+			      msecs_to_jiffies(ASM_BUF_POOL_IDLE_MS));
+	mutex_unlock(&asm_buf_pool.lock);
+
+	/* the nodes of one mapping are a single allocation led by @head */
+	list_for_each_entry_safe(buf_node, next, &port->mem_map_handle, list) {
+		if (buf_node->mmap_hdl == entry->mmap_hdl)
+			list_del(&buf_node->list);
+	}
+	kfree(head);
+
+	return true;
+}
+
+/* Add the ADSP mapping of a pooled buffer to the port of @ac */
+static int q6asm_buf_pool_attach(struct audio_client *ac, int dir,
+				 uint32_t mmap_hdl)
+{
+	struct audio_port_data *port = &ac->port[dir];
+	struct asm_buffer_node *buffer_node;
+	int i;
+
+	buffer_node = kcalloc(port->max_buf_cnt, sizeof(*buffer_node),
+			      GFP_KERNEL);
+	if (!buffer_node)
+		return -ENOMEM;
+
+	mutex_lock(&ac->cmd_lock);
+	for (i = 0; i < port->max_buf_cnt; i++) {
+		buffer_node[i].buf_phys_addr = port->buf[i].phys;
+		buffer_node[i].mmap_hdl = mmap_hdl;
+		list_add_tail(&buffer_node[i].list, &port->mem_map_handle);
+	}
+	mutex_unlock(&ac->cmd_lock);
+
+	return 0;
+}
+
 int q6asm_audio_client_buf_free(unsigned int dir,
 			struct audio_client *ac)
 {
@@ -1244,14 +1455,16 @@ int q6asm_audio_client_buf_free_contiguous(unsigned int dir,
 	}
 	cnt = port->max_buf_cnt - 1;
 
-	if (cnt >= 0) {
+	if (cnt >= 0 && q6asm_buf_pool_put(ac, dir)) {
+		port->buf[0].dma_buf = NULL;
+	} else if (cnt >= 0) {
 		rc = q6asm_memory_unmap(ac, port->buf[0].phys, dir);
 		if (rc < 0)
 			pr_err("%s: Memory_unmap_regions failed %d\n",
 							__func__, rc);
 	}
 
-	if (port->buf[0].data) {
+	if (port->buf[0].data && port->buf[0].dma_buf) {
 		pr_debug("%s: data[%pK], phys[%pK], dma_buf[%pK]\n",
 			__func__,
 			port->buf[0].data,
@@ -1708,6 +1921,7 @@ int q6asm_audio_client_buf_alloc_contiguous(unsigned int dir,
 	int cnt = 0;
 	int rc = 0;
 	struct audio_buffer *buf;
+	struct asm_buf_pool_entry *entry;
 	size_t len;
 	int bytes_to_alloc;
 
@@ -1753,15 +1967,23 @@ int q6asm_audio_client_buf_alloc_contiguous(unsigned int dir,
 	/* The size to allocate should be multiple of 4K bytes */
 	bytes_to_alloc = PAGE_ALIGN(bytes_to_alloc);
 
-	rc = msm_audio_ion_alloc(&buf[0].dma_buf,
-		bytes_to_alloc,
-		&buf[0].phys, &len,
-		&buf[0].data);
-	if (rc) {
-		pr_err("%s: Audio ION alloc is failed, rc = %d\n",
-			__func__, rc);
-		mutex_unlock(&ac->cmd_lock);
-		goto fail;
+	entry = q6asm_buf_pool_get(bytes_to_alloc);
+	if (entry) {
+		buf[0].dma_buf = entry->dma_buf;
+		buf[0].phys = entry->phys;
+		buf[0].data = entry->data;
+		memset(buf[0].data, 0, bytes_to_alloc);
+	} else {
+		rc = msm_audio_ion_alloc(&buf[0].dma_buf,
+			bytes_to_alloc,
+			&buf[0].phys, &len,
+			&buf[0].data);
+		if (rc) {
+			pr_err("%s: Audio ION alloc is failed, rc = %d\n",
+				__func__, rc);
+			mutex_unlock(&ac->cmd_lock);
+			goto fail;
+		}
 	}
 
 	buf[0].used = dir ^ 1;
@@ -1791,7 +2013,17 @@ int q6asm_audio_client_buf_alloc_contiguous(unsigned int dir,
 	}
 	ac->port[dir].max_buf_cnt = cnt;
 	mutex_unlock(&ac->cmd_lock);
-	rc = q6asm_memory_map_regions(ac, dir, bufsz, cnt, 1);
+	if (entry) {
+		rc = q6asm_buf_pool_attach(ac, dir, entry->mmap_hdl);
+		if (rc < 0) {
+			buf[0].dma_buf = NULL;
+			q6asm_buf_pool_release(entry, true);
+		} else {
+			kfree(entry);
+		}
+	} else {
+		rc = q6asm_memory_map_regions(ac, dir, bufsz, cnt, 1);
+	}
 	if (rc < 0) {
 		pr_err("%s: CMD Memory_map_regions failed %d for size %d\n",
 			__func__, rc, bufsz);
@@ -1850,6 +2082,7 @@ static int32_t q6asm_srvc_callback(struct apr_client_data *data, void *priv)
 
 		cal_utils_clear_cal_block_q6maps(ASM_MAX_CAL_TYPES, cal_data);
 		common_client.mmap_apr = NULL;
+		q6asm_buf_pool_drain(false);
 		mutex_lock(&cal_data[ASM_CUSTOM_TOP_CAL]->lock);
 		set_custom_topology = 1;
 		mutex_unlock(&cal_data[ASM_CUSTOM_TOP_CAL]->lock);
@@ -4896,15 +5129,18 @@ int q6asm_get_shared_pos(struct audio_client *ac, uint32_t *read_index,
 	for (i = 0; i < 2; i++) {
 		/* retry until there is an update from DSP */
 		for (j = 0; j < 5; j++) {
-			frame_cnt1 = pos_buf->frame_counter;
+			frame_cnt1 = READ_ONCE(pos_buf->frame_counter);
 			if (frame_cnt1 != 0)
 				break;
 		}
 
-		*wall_clk_msw1 = pos_buf->wall_clock_us_msw;
-		*wall_clk_lsw1 = pos_buf->wall_clock_us_lsw;
-		*read_index = pos_buf->index;
-		frame_cnt2 = pos_buf->frame_counter;
+		/* DSP updates the counter around the index, keep the order */
+		rmb();
+		*wall_clk_msw1 = READ_ONCE(pos_buf->wall_clock_us_msw);
+		*wall_clk_lsw1 = READ_ONCE(pos_buf->wall_clock_us_lsw);
+		*read_index = READ_ONCE(pos_buf->index);
+		rmb();
+		frame_cnt2 = READ_ONCE(pos_buf->frame_counter);
 
 		if (frame_cnt1 != frame_cnt2)
 			continue;
@@ -4916,6 +5152,51 @@ int q6asm_get_shared_pos(struct audio_client *ac, uint32_t *read_index,
 }
 EXPORT_SYMBOL(q6asm_get_shared_pos);
 
+/*
+ * q6asm_shared_io_avail: Returns the number of bytes the client can access
+ * in the shared circular buffer without exchanging any APR message.
+ * For playback this is the room left to write ahead of the DSP read index,
+ * for capture the data the DSP wrote since the client read index.
+ * parameters
+ *   dir - stream direction (IN for playback, OUT for capture)
+ *   host_index - offset of the client in [0, BUF_SIZE - 1]
+ *   avail - (output) bytes available to the client
+ * returns 0 if successful, error code otherwise
+ */
+int q6asm_shared_io_avail(struct audio_client *ac, int dir,
+			  uint32_t host_index, uint32_t *avail)
+{
+	uint32_t dsp_index, wall_clk_msw, wall_clk_lsw, size;
+	int rc;
+
+	if (!ac || !avail || (dir != IN && dir != OUT)) {
+		pr_err("%s: invalid params\n", __func__);
+		return -EINVAL;
+	}
+
+	size = ac->config.bufsz * ac->config.bufcnt;
+	if (!ac->port[dir].buf || !ac->shared_pos_buf.data || !size ||
+	    host_index >= size) {
+		pr_err("%s: no shared io session, index %u size %u\n",
+		       __func__, host_index, size);
+		return -EINVAL;
+	}
+
+	rc = q6asm_get_shared_pos(ac, &dsp_index, &wall_clk_msw,
+				  &wall_clk_lsw);
+	if (rc)
+		return rc;
+
+	dsp_index %= size;
+	if (dir == IN)
+		*avail = size - ((host_index + size - dsp_index) % size);
+	else
+		*avail = (dsp_index + size - host_index) % size;
+
+	return 0;
+}
+EXPORT_SYMBOL(q6asm_shared_io_avail);
+
 /**
  * q6asm_run -
  *       command to set ASM to run state
@@ -11717,6 +11998,10 @@ int __init q6asm_init(void)
 	atomic_set(&common_client.cmd_state, 0);
 	atomic_set(&common_client.mem_state, 0);
 
+	mutex_init(&asm_buf_pool.lock);
+	INIT_LIST_HEAD(&asm_buf_pool.free);
+	INIT_DELAYED_WORK(&asm_buf_pool.shrink_work, q6asm_buf_pool_shrink);
+
 	ret = q6asm_init_cal_data();
 	if (ret)
 		pr_err("%s: could not init cal data! ret %d\n",
@@ -11730,6 +12015,10 @@ int __init q6asm_init(void)
 void q6asm_exit(void)
 {
 	int lcnt;
+
+	cancel_delayed_work_sync(&asm_buf_pool.shrink_work);
+	q6asm_buf_pool_drain(true);
+	mutex_destroy(&asm_buf_pool.lock);
 	q6asm_delete_cal_data();
 	for (lcnt = 0; lcnt <= OUT; lcnt++)
 		mutex_destroy(&common_client.port[lcnt].lock);
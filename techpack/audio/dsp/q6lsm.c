@@ -15,6 +15,8 @@
 #include <linux/debugfs.h>
 #include <linux/time.h>
 #include <linux/atomic.h>
+#include <linux/jhash.h>
+#include <linux/shrinker.h>
 #include <audio/sound/lsm_params.h>
 #include <asm/ioctls.h>
 #include <linux/memory.h>
@@ -31,6 +33,7 @@
 #define LSM_SAMPLE_RATE 16000
 #define QLSM_PARAM_ID_MINOR_VERSION 1
 #define QLSM_PARAM_ID_MINOR_VERSION_2 2
+#define LSM_SM_CACHE_MAX 4
 
 static int lsm_afe_port;
 
@@ -71,6 +74,27 @@ struct lsm_common {
 #endif
 };
 
+/*
+ * Sound model buffers are kept around after a session frees them so the
+ * next session loading the same model skips the ION allocation and copy.
+ * Entries are matched by content hash, idle ones are released under
+ * memory pressure.
+ */
+struct lsm_sm_cache_entry {
+	struct list_head list;
+	struct dma_buf *dma_buf;
+	void *data;
+	dma_addr_t phys;
+	size_t alloc_len;
+	size_t size;
+	u32 hash;
+	bool in_use;
+};
+
+static LIST_HEAD(lsm_sm_cache);
+static DEFINE_MUTEX(lsm_sm_cache_lock);
+static int lsm_sm_cache_cnt;
+
 static struct lsm_common lsm_common;
 static DEFINE_MUTEX(session_lock);
 
@@ -2026,6 +2050,220 @@ static int q6lsm_snd_cal_alloc(struct lsm_client *client,
 	return rc;
 }
 
+static void q6lsm_sm_cache_release(struct lsm_sm_cache_entry *entry)
+{
+	list_del(&entry->list);
+	lsm_sm_cache_cnt--;
+	msm_audio_ion_free(entry->dma_buf);
+	kfree(entry);
+}
+
+/* Returns true if @dma_buf belongs to the cache and is now idle */
+static bool q6lsm_sm_cache_put(struct dma_buf *dma_buf)
+{
+	struct lsm_sm_cache_entry *entry;
+	bool cached = false;
+
+	mutex_lock(&lsm_sm_cache_lock);
+	list_for_each_entry(entry, &lsm_sm_cache, list) {
+		if (entry->dma_buf == dma_buf) {
+			entry->in_use = false;
+			/* most recently used first */
+			list_move(&entry->list, &lsm_sm_cache);
+			cached = true;
+			break;
+		}
+	}
+	mutex_unlock(&lsm_sm_cache_lock);
+
+	return cached;
+}
+
+static unsigned long q6lsm_sm_cache_count(struct shrinker *s,
+					  struct shrink_control *sc)
+{
+	struct lsm_sm_cache_entry *entry;
+	unsigned long pages = 0;
+
+	mutex_lock(&lsm_sm_cache_lock);
+	list_for_each_entry(entry, &lsm_sm_cache, list)
+		if (!entry->in_use)
+			pages += entry->alloc_len >> PAGE_SHIFT;
+	mutex_unlock(&lsm_sm_cache_lock);
+
+	return pages ? pages : SHRINK_EMPTY;
+}
+
+static unsigned long q6lsm_sm_cache_scan(struct shrinker *s,
+					 struct shrink_control *sc)
+{
+	struct lsm_sm_cache_entry *entry, *next;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&lsm_sm_cache_lock))
+		return SHRINK_STOP;
+
+	list_for_each_entry_safe_reverse(entry, next, &lsm_sm_cache, list) {
+		if (entry->in_use)
+			continue;
+		freed += entry->alloc_len >> PAGE_SHIFT;
+		q6lsm_sm_cache_release(entry);
+		if (freed >= sc->nr_to_scan)
+			break;
+	}
+	mutex_unlock(&lsm_sm_cache_lock);
+
+	return freed;
+}
+
+static struct shrinker q6lsm_sm_cache_shrinker = {
+	.count_objects = q6lsm_sm_cache_count,
+	.scan_objects = q6lsm_sm_cache_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static void q6lsm_sm_cache_flush(void)
+{
+	struct lsm_sm_cache_entry *entry, *next;
+
+	mutex_lock(&lsm_sm_cache_lock);
+	list_for_each_entry_safe(entry, next, &lsm_sm_cache, list)
+		if (!entry->in_use)
+			q6lsm_sm_cache_release(entry);
+	mutex_unlock(&lsm_sm_cache_lock);
+}
+
+/*
+ * Find an idle buffer holding @data, or failing that one large enough to
+ * be overwritten, or allocate a new one. Called with lsm_sm_cache_lock.
+ */
+static struct lsm_sm_cache_entry *q6lsm_sm_cache_get(const void *data,
+						     size_t len)
+{
+	struct lsm_sm_cache_entry *entry, *spare = NULL, *lru = NULL;
+	size_t total_mem = PAGE_ALIGN(len);
+	u32 hash = jhash(data, len, 0);
+	size_t alloc_len;
+	int rc;
+
+	list_for_each_entry(entry, &lsm_sm_cache, list) {
+		if (entry->in_use)
+			continue;
+		if (entry->hash == hash && entry->size == len &&
+		    !memcmp(entry->data, data, len)) {
+			pr_debug("%s: sound model cache hit, size %zd\n",
+				 __func__, len);
+			entry->in_use = true;
+			return entry;
+		}
+		if (entry->alloc_len >= total_mem && !spare)
+			spare = entry;
+		lru = entry;
+	}
+
+	if (!spare) {
+		/* keep the cache bounded by dropping the oldest idle model */
+		if (lsm_sm_cache_cnt >= LSM_SM_CACHE_MAX && lru)
+			q6lsm_sm_cache_release(lru);
+
+		spare = kzalloc(sizeof(*spare), GFP_KERNEL);
+		if (!spare)
+			return ERR_PTR(-ENOMEM);
+
+		rc = msm_audio_ion_alloc(&spare->dma_buf, total_mem,
+					 &spare->phys, &alloc_len,
+					 &spare->data);
+		if (rc) {
+			pr_err("%s: Audio ION alloc is failed, rc = %d\n",
+			       __func__, rc);
+			kfree(spare);
+			return ERR_PTR(rc);
+		}
+		spare->alloc_len = alloc_len;
+		list_add(&spare->list, &lsm_sm_cache);
+		lsm_sm_cache_cnt++;
+	}
+
+	memcpy(spare->data, data, len);
+	spare->hash = hash;
+	spare->size = len;
+	spare->in_use = true;
+
+	return spare;
+}
+
+/**
+ * q6lsm_snd_model_buf_alloc_cached -
+ *       Allocate memory for LSM snd model and fill it with the model
+ *
+ * @client: LSM client handle
+ * @data: sound model contents
+ * @len: size of sound model
+ * @p_info: sound model param info, only the register command path
+ *          (param_id == 0) is supported
+ * @sm: pointer to sound model
+ *
+ * Like q6lsm_snd_model_buf_alloc() followed by copying @data, but reuses
+ * the buffer of a previous session that loaded the same model.
+ *
+ * Returns 0 on success or error on failure
+ */
+int q6lsm_snd_model_buf_alloc_cached(struct lsm_client *client,
+				     const void *data, size_t len,
+				     struct lsm_params_info_v2 *p_info,
+				     struct lsm_sound_model *sm)
+{
+	struct lsm_sm_cache_entry *entry;
+	int rc, stage_idx = p_info->stage_idx;
+
+	if (!client || !data || !len || p_info->param_id)
+		return -EINVAL;
+
+	mutex_lock(&client->cmd_lock);
+	if (sm->data) {
+		pr_err("%s: sound model busy, stage_idx %d\n", __func__, stage_idx);
+		mutex_unlock(&client->cmd_lock);
+		return -EBUSY;
+	}
+
+	mutex_lock(&lsm_sm_cache_lock);
+	entry = q6lsm_sm_cache_get(data, len);
+	if (IS_ERR(entry)) {
+		mutex_unlock(&lsm_sm_cache_lock);
+		mutex_unlock(&client->cmd_lock);
+		return PTR_ERR(entry);
+	}
+	sm->dma_buf = entry->dma_buf;
+	sm->data = entry->data;
+	sm->phys = entry->phys;
+	sm->size = len;
+	mutex_unlock(&lsm_sm_cache_lock);
+
+	rc = q6lsm_memory_map_regions(client, sm->phys, entry->alloc_len,
+				      &sm->mem_map_handle);
+	if (rc) {
+		pr_err("%s: CMD Memory_map_regions failed %d, stage_idx %d\n",
+			__func__, rc, stage_idx);
+		sm->mem_map_handle = 0;
+		mutex_unlock(&client->cmd_lock);
+		goto fail;
+	}
+	mutex_unlock(&client->cmd_lock);
+
+	rc = q6lsm_snd_cal_alloc(client, p_info);
+	if (rc) {
+		pr_err("%s: cal alloc failed %d, stage_idx %d\n",
+			__func__, rc, stage_idx);
+		goto fail;
+	}
+	return 0;
+
+fail:
+	q6lsm_snd_model_buf_free(client, p_info, sm);
+	return rc;
+}
+EXPORT_SYMBOL(q6lsm_snd_model_buf_alloc_cached);
+
 /**
  * q6lsm_snd_model_buf_free -
  *       Free memory for LSM snd model
@@ -2060,7 +2298,8 @@ int q6lsm_snd_model_buf_free(struct lsm_client *client,
 				__func__, rc);
 		sm->mem_map_handle = 0;
 	}
-	msm_audio_ion_free(sm->dma_buf);
+	if (!q6lsm_sm_cache_put(sm->dma_buf))
+		msm_audio_ion_free(sm->dma_buf);
 	sm->dma_buf = NULL;
 	sm->data = NULL;
 	sm->phys = 0;
@@ -3084,6 +3323,10 @@ int __init q6lsm_init(void)
 	if (q6lsm_init_cal_data())
 		pr_err("%s: could not init cal data!\n", __func__);
 
+	if (register_shrinker(&q6lsm_sm_cache_shrinker))
+		pr_err("%s: could not register sound model cache shrinker\n",
+		       __func__);
+
 #ifdef CONFIG_DEBUG_FS
 	lsm_common.entry = debugfs_create_dir("q6lsm_apr", NULL);
 	if (!IS_ERR_OR_NULL(lsm_common.entry)) {
@@ -3103,6 +3346,9 @@ void q6lsm_exit(void)
 	int i = 0;
 	lsm_delete_cal_data();
 
+	unregister_shrinker(&q6lsm_sm_cache_shrinker);
+	q6lsm_sm_cache_flush();
+
 	for (; i <= LSM_MAX_SESSION_ID; i++)
 		mutex_destroy(&lsm_common.common_client[i].cmd_lock);
 	mutex_destroy(&lsm_common.apr_lock);
@@ -12,6 +12,28 @@
 #include <soc/soundwire.h>
 #include <soc/internal.h>
 
+/* Write consecutive registers with one FIFO batch on the master */
+static int regmap_swr_bulk_gather_write(struct swr_device *swr, u16 reg_addr,
+					const void *val, size_t count)
+{
+	u16 *reg;
+	int i, ret;
+
+	reg = kcalloc(count, sizeof(u16), GFP_KERNEL);
+	if (!reg)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++)
+		reg[i] = reg_addr + i;
+
+	ret = swr_bulk_write(swr, swr->dev_num, reg, val, count);
+	if (ret)
+		dev_dbg(&swr->dev, "%s: bulk write reg 0x%x failed, err %d\n",
+			__func__, reg_addr, ret);
+
+	kfree(reg);
+	return ret;
+}
 
 static int regmap_swr_gather_write(void *context,
 				const void *reg, size_t reg_size,
@@ -43,6 +65,11 @@ static int regmap_swr_gather_write(void *context,
 	reg_addr = *(u16 *)reg;
 	val_bytes = map->format.val_bytes;
 	/* val_len = val_bytes * val_count */
+	if (val_bytes == 1 && val_len > 1) {
+		/* fall back to single writes if the master can't batch */
+		if (!regmap_swr_bulk_gather_write(swr, reg_addr, val, val_len))
+			return 0;
+	}
 	for (i = 0; i < (val_len / val_bytes); i++) {
 		value = (u8 *)val + (val_bytes * i);
 		ret = swr_write(swr, swr->dev_num, (reg_addr + i), value);
@@ -661,9 +661,23 @@ static void swr_master_write(struct swr_mstr_ctrl *swrm, u16 reg_addr, u32 val)
 		swrm_ahb_write(swrm, reg_addr, &val);
 }
 
+/* Number of commands the write FIFO can take before it overflows */
+static u32 swrm_get_fifo_wr_avail(struct swr_mstr_ctrl *swrm)
+{
+	u32 fifo_outstanding_cmd;
+
+	fifo_outstanding_cmd = ((swr_master_read(swrm, SWRM_CMD_FIFO_STATUS)
+				 & 0x00001F00) >> 8);
+	if (fifo_outstanding_cmd >= swrm->wr_fifo_depth)
+		return 0;
+
+	return swrm->wr_fifo_depth - fifo_outstanding_cmd;
+}
+
 static int swr_master_bulk_write(struct swr_mstr_ctrl *swrm, u32 *reg_addr,
 				u32 *val, unsigned int length)
 {
+	u32 fifo_avail = 0;
 	int i = 0;
 
 	if (swrm->bulk_write)
@@ -671,15 +685,25 @@ static int swr_master_bulk_write(struct swr_mstr_ctrl *swrm, u32 *reg_addr,
 	else {
 		mutex_lock(&swrm->iolock);
 		for (i = 0; i < length; i++) {
-		/* wait for FIFO WR command to complete to avoid overflow */
-		/*
-		 * Reduce sleep from 100us to 50us to meet KPIs
-		 * This still meets the hardware spec
-		 */
-			usleep_range(50, 55);
-			if (reg_addr[i] == SWRM_CMD_FIFO_WR_CMD)
+			if (reg_addr[i] != SWRM_CMD_FIFO_WR_CMD) {
+				/*
+				 * Reduce sleep from 100us to 50us to meet KPIs
+				 * This still meets the hardware spec
+				 */
+				usleep_range(50, 55);
+			} else if (!fifo_avail) {
+				/*
+				 * Queue FIFO WR commands back to back while
+				 * the FIFO has room and only wait for it to
+				 * drain once it is full.
+				 */
 				swrm_wait_for_fifo_avail(swrm,
 							 SWRM_WR_CHECK_AVAIL);
+				fifo_avail = max_t(u32, 1,
+					swrm_get_fifo_wr_avail(swrm));
+			}
+			if (reg_addr[i] == SWRM_CMD_FIFO_WR_CMD)
+				fifo_avail--;
 			swr_master_write(swrm, reg_addr[i], val[i]);
 		}
 		usleep_range(100, 110);
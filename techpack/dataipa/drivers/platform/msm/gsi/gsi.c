@@ -11,6 +11,7 @@
 #include <linux/msm_gsi.h>
 #include <linux/platform_device.h>
 #include <linux/delay.h>
+#include <linux/prefetch.h>
 #include "gsi.h"
 #include "gsi_reg.h"
 #include "gsi_emulation.h"
@@ -623,6 +624,29 @@ static void gsi_process_evt_re(struct gsi_evt_ctx *ctx,
 	ctx->stats.completed++;
 }
 
+/*
+ * gsi_prefetch_evt_re() - warm the cache for the event after the one at
+ * rp_local, and for the TRE user_data the channel completes next, so the
+ * next iteration of a poll batch does not stall on cold lines.
+ */
+static inline void gsi_prefetch_evt_re(struct gsi_evt_ctx *ctx,
+		struct gsi_chan_ctx *ch_ctx)
+{
+	uint64_t next = ctx->ring.rp_local + ctx->ring.elem_sz;
+	uint16_t idx;
+
+	if (next == ctx->ring.end)
+		next = ctx->ring.base;
+	prefetch((void *)(ctx->ring.base_va + next - ctx->ring.base));
+
+	if (!ch_ctx || ch_ctx->props.prot == GSI_CHAN_PROT_GCI)
+		return;
+
+	idx = (uint32_t)(ch_ctx->ring.rp_local - ch_ctx->ring.base) /
+		ch_ctx->ring.elem_sz;
+	prefetch(ch_ctx->user_data[idx].p);
+}
+
 static void gsi_ring_evt_doorbell(struct gsi_evt_ctx *ctx)
 {
 	uint32_t val;
@@ -713,6 +737,7 @@ static void gsi_handle_ieob(int ee)
 					cntr = 0;
 					break;
 				}
+				gsi_prefetch_evt_re(ctx, NULL);
 				gsi_process_evt_re(ctx, &notify, true);
 				empty = false;
 			}
@@ -2240,6 +2265,45 @@ int gsi_set_evt_ring_cfg(unsigned long evt_ring_hdl,
 }
 EXPORT_SYMBOL(gsi_set_evt_ring_cfg);
 
+int gsi_set_evt_ring_int_mod(unsigned long evt_ring_hdl, uint16_t int_modt,
+	uint8_t int_modc)
+{
+	struct gsi_evt_ctx *ctx;
+	uint32_t val;
+
+	if (!gsi_ctx) {
+		pr_err("%s:%d gsi context not allocated\n", __func__, __LINE__);
+		return -GSI_STATUS_NODEV;
+	}
+
+	if (evt_ring_hdl >= gsi_ctx->max_ev) {
+		GSIERR("bad params evt_ring_hdl=%lu\n", evt_ring_hdl);
+		return -GSI_STATUS_INVALID_PARAMS;
+	}
+
+	ctx = &gsi_ctx->evtr[evt_ring_hdl];
+
+	if (ctx->state != GSI_EVT_RING_STATE_ALLOCATED) {
+		GSIERR("bad state %d\n", ctx->state);
+		return -GSI_STATUS_UNSUPPORTED_OP;
+	}
+
+	/* keep props in sync so a later reset restores the new values */
+	ctx->props.int_modt = int_modt;
+	ctx->props.int_modc = int_modc;
+
+	val = (((int_modt << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_SHFT) &
+		GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODT_BMSK) |
+		((int_modc << GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_SHFT) &
+		 GSI_EE_n_EV_CH_k_CNTXT_8_INT_MODC_BMSK));
+	gsi_writel(val, gsi_ctx->base +
+			GSI_EE_n_EV_CH_k_CNTXT_8_OFFS(evt_ring_hdl,
+			gsi_ctx->per.ee));
+
+	return GSI_STATUS_SUCCESS;
+}
+EXPORT_SYMBOL(gsi_set_evt_ring_int_mod);
+
 static void gsi_program_chan_ctx_qos(struct gsi_chan_props *props,
 	unsigned int ee)
 {
@@ -4087,8 +4151,15 @@ int gsi_poll_n_channel(unsigned long chan_hdl,
 	if (*actual_num > expected_num)
 		*actual_num = expected_num;
 
-	for (i = 0; i < *actual_num; i++)
+	/*
+	 * Process the whole batch under one lock hold; the event ring
+	 * doorbell is rung once by the client when it replenishes.
+	 */
+	for (i = 0; i < *actual_num; i++) {
 		gsi_process_evt_re(ctx->evtr, notify + i, false);
+		if (i + 1 < *actual_num)
+			gsi_prefetch_evt_re(ctx->evtr, ctx);
+	}
 
 	spin_unlock_irqrestore(&ctx->evtr->ring.slock, flags);
 	ctx->stats.poll_ok++;
@@ -5148,6 +5219,9 @@ int gsi_get_hw_profiling_stats(struct gsi_hw_profiling_data *stats)
 		return -EINVAL;
 	}
 
+	if (gsi_ctx->per.ver < GSI_VER_2_9)
+		return -EPERM;
+
 	stats->bp_cnt = (u64)gsi_readl(gsi_ctx->base +
 						GSI_GSI_MCS_PROFILING_BP_CNT_LSB_OFFS) +
 						((u64)gsi_readl(gsi_ctx->base +
@@ -5168,6 +5242,28 @@ int gsi_get_hw_profiling_stats(struct gsi_hw_profiling_data *stats)
 
 	return 0;
 }
+EXPORT_SYMBOL(gsi_get_hw_profiling_stats);
+
+/**
+ * gsi_get_chan_stats() - Query the software datapath stats of a channel
+ * @chan_hdl:	Client handle previously obtained from gsi_alloc_channel
+ * @stats:	[out] copy of the channel stats
+ *
+ * Returns:	0 on success, negative on failure
+ *
+ */
+int gsi_get_chan_stats(unsigned long chan_hdl, struct gsi_chan_stats *stats)
+{
+	if (!gsi_ctx || stats == NULL || chan_hdl >= gsi_ctx->max_ch)
+		return -EINVAL;
+
+	if (!gsi_ctx->chan[chan_hdl].allocated)
+		return -EINVAL;
+
+	*stats = gsi_ctx->chan[chan_hdl].stats;
+	return 0;
+}
+EXPORT_SYMBOL(gsi_get_chan_stats);
 
 /**
  * gsi_get_fw_version() - Query GSI FW version
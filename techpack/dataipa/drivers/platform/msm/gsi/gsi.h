@@ -1782,6 +1782,21 @@ int gsi_get_evt_ring_cfg(unsigned long evt_ring_hdl,
 int gsi_set_evt_ring_cfg(unsigned long evt_ring_hdl,
 		struct gsi_evt_ring_props *props, union gsi_evt_scratch *scr);
 
+/**
+ * gsi_set_evt_ring_int_mod - This function updates the interrupt
+ * moderation of the specified event ring in place, without the
+ * reset required by gsi_set_evt_ring_cfg
+ *
+ * @evt_ring_hdl:  Client handle previously obtained from
+ *             gsi_alloc_evt_ring
+ * @int_modt:      cycles base interrupt moderation (32KHz clock)
+ * @int_modc:      interrupt moderation packet counter
+ *
+ * @Return gsi_status
+ */
+int gsi_set_evt_ring_int_mod(unsigned long evt_ring_hdl, uint16_t int_modt,
+	uint8_t int_modc);
+
 /**
  * gsi_write_channel_scratch - Peripheral should call this function to
  * write to the scratch area of the channel context
@@ -2163,6 +2178,16 @@ int gsi_enable_flow_control_ee(unsigned int chan_idx, unsigned int ee,
  */
 int gsi_get_hw_profiling_stats(struct gsi_hw_profiling_data *stats);
 
+/**
+ * gsi_get_chan_stats() - Query the software datapath stats of a channel
+ * @chan_hdl:	Client handle previously obtained from gsi_alloc_channel
+ * @stats:	[out] copy of the channel stats
+ *
+ * Returns:	0 on success, negative on failure
+ *
+ */
+int gsi_get_chan_stats(unsigned long chan_hdl, struct gsi_chan_stats *stats);
+
 /**
  * gsi_get_fw_version() - Query GSI FW version
  * @ver:	[out] ver blob from client populated by driver
@@ -145,16 +145,18 @@ static void ipa_inc_clients_enable_clks_on_wq(struct work_struct *work);
 static DECLARE_WORK(ipa_inc_clients_enable_clks_on_wq_work,
 	ipa_inc_clients_enable_clks_on_wq);
 
-static int ipa3_ioctl_add_rt_rule_v2(unsigned long arg);
+static int ipa3_ioctl_add_hdr(unsigned long arg, bool defer_commit);
+static int ipa3_ioctl_add_rt_rule_v2(unsigned long arg, bool defer_commit);
 static int ipa3_ioctl_add_rt_rule_ext_v2(unsigned long arg);
 static int ipa3_ioctl_add_rt_rule_after_v2(unsigned long arg);
 static int ipa3_ioctl_mdfy_rt_rule_v2(unsigned long arg);
-static int ipa3_ioctl_add_flt_rule_v2(unsigned long arg);
+static int ipa3_ioctl_add_flt_rule_v2(unsigned long arg, bool defer_commit);
 static int ipa3_ioctl_add_flt_rule_after_v2(unsigned long arg);
 static int ipa3_ioctl_mdfy_flt_rule_v2(unsigned long arg);
 static int ipa3_ioctl_fnr_counter_alloc(unsigned long arg);
 static int ipa3_ioctl_fnr_counter_query(unsigned long arg);
 static int ipa3_ioctl_fnr_counter_set(unsigned long arg);
+static int ipa3_ioctl_rule_txn(unsigned long arg);
 
 static struct ipa3_plat_drv_res ipa3_res = {0, };
 
@@ -1036,7 +1038,51 @@ static int ipa3_send_gsb_msg(unsigned long usr_param, uint8_t msg_type)
 	return 0;
 }
 
-static int ipa3_ioctl_add_rt_rule_v2(unsigned long arg)
+static int ipa3_ioctl_add_hdr(unsigned long arg, bool defer_commit)
+{
+	int retval = 0;
+	struct ipa_ioc_add_hdr hdr;
+	int pre_entry;
+	u32 pyld_sz;
+	u8 *param = NULL;
+
+	if (copy_from_user(&hdr, (const void __user *)arg,
+		sizeof(struct ipa_ioc_add_hdr)))
+		return -EFAULT;
+
+	pre_entry = hdr.num_hdrs;
+	pyld_sz =
+	   sizeof(struct ipa_ioc_add_hdr) +
+	   pre_entry * sizeof(struct ipa_hdr_add);
+	param = memdup_user((const void __user *)arg, pyld_sz);
+	if (IS_ERR(param))
+		return PTR_ERR(param);
+
+	/* add check in case user-space module compromised */
+	if (unlikely(((struct ipa_ioc_add_hdr *)param)->num_hdrs
+		!= pre_entry)) {
+		IPAERR_RL("current %d pre %d\n",
+			((struct ipa_ioc_add_hdr *)param)->num_hdrs,
+			pre_entry);
+		retval = -EFAULT;
+		goto free_param;
+	}
+	if (defer_commit)
+		((struct ipa_ioc_add_hdr *)param)->commit = 0;
+	if (ipa3_add_hdr_usr((struct ipa_ioc_add_hdr *)param,
+		true)) {
+		retval = -EFAULT;
+		goto free_param;
+	}
+	if (copy_to_user((void __user *)arg, param, pyld_sz))
+		retval = -EFAULT;
+
+free_param:
+	kfree(param);
+	return retval;
+}
+
+static int ipa3_ioctl_add_rt_rule_v2(unsigned long arg, bool defer_commit)
 {
 	int retval = 0;
 	int i;
@@ -1055,6 +1101,8 @@ static int ipa3_ioctl_add_rt_rule_v2(unsigned long arg)
 		retval = -EFAULT;
 		goto free_param_kptr;
 	}
+	if (defer_commit)
+		((struct ipa_ioc_add_rt_rule_v2 *)header)->commit = 0;
 	pre_entry =
 		((struct ipa_ioc_add_rt_rule_v2 *)header)->num_rules;
 	if (unlikely(((struct ipa_ioc_add_rt_rule_v2 *)
@@ -1495,7 +1543,7 @@ static int ipa3_ioctl_mdfy_rt_rule_v2(unsigned long arg)
 	return retval;
 }
 
-static int ipa3_ioctl_add_flt_rule_v2(unsigned long arg)
+static int ipa3_ioctl_add_flt_rule_v2(unsigned long arg, bool defer_commit)
 {
 	int retval = 0;
 	int i;
@@ -1514,6 +1562,8 @@ static int ipa3_ioctl_add_flt_rule_v2(unsigned long arg)
 		retval = -EFAULT;
 		goto free_param_kptr;
 	}
+	if (defer_commit)
+		((struct ipa_ioc_add_flt_rule_v2 *)header)->commit = 0;
 	pre_entry =
 		((struct ipa_ioc_add_flt_rule_v2 *)header)->num_rules;
 	if (unlikely(((struct ipa_ioc_add_flt_rule_v2 *)
@@ -2031,6 +2081,79 @@ static int proc_sram_info_rqst(
 	return 0;
 }
 
+/**
+ * ipa3_ioctl_rule_txn() - add headers, routing and filtering rules
+ * from one request, then commit them together
+ *
+ * Sub-requests are applied in dependency order (hdr, rt, flt) without
+ * their individual commit flags. If one fails, nothing is committed and
+ * the handles of entries already added are returned to user space for
+ * cleanup. On success, the touched tables are committed bottom-up under
+ * a single hold of the ipa3_ctx lock, so no other commit interleaves.
+ */
+static int ipa3_ioctl_rule_txn(unsigned long arg)
+{
+	struct ipa_ioc_rule_txn txn;
+	struct ipa_ioc_add_rt_rule_v2 rt_hdr;
+	struct ipa_ioc_add_flt_rule_v2 flt_hdr;
+	int retval;
+
+	if (copy_from_user(&txn, (const void __user *)arg, sizeof(txn)))
+		return -EFAULT;
+
+	if (txn.add_hdr) {
+		retval = ipa3_ioctl_add_hdr(txn.add_hdr, true);
+		if (retval)
+			return retval;
+	}
+
+	if (txn.add_rt_rule) {
+		if (copy_from_user(&rt_hdr,
+			(const void __user *)txn.add_rt_rule, sizeof(rt_hdr)))
+			return -EFAULT;
+		if (rt_hdr.ip >= IPA_IP_MAX)
+			return -EINVAL;
+		retval = ipa3_ioctl_add_rt_rule_v2(txn.add_rt_rule, true);
+		if (retval)
+			return retval;
+	}
+
+	if (txn.add_flt_rule) {
+		if (copy_from_user(&flt_hdr,
+			(const void __user *)txn.add_flt_rule, sizeof(flt_hdr)))
+			return -EFAULT;
+		if (flt_hdr.ip >= IPA_IP_MAX)
+			return -EINVAL;
+		retval = ipa3_ioctl_add_flt_rule_v2(txn.add_flt_rule, true);
+		if (retval)
+			return retval;
+	}
+
+	if (!txn.commit)
+		return 0;
+
+	retval = 0;
+	mutex_lock(&ipa3_ctx->lock);
+	if (txn.add_hdr && ipa3_ctx->ctrl->ipa3_commit_hdr()) {
+		IPAERR_RL("fail to commit hdr\n");
+		retval = -EPERM;
+		goto bail;
+	}
+	if (txn.add_rt_rule && ipa3_ctx->ctrl->ipa3_commit_rt(rt_hdr.ip)) {
+		IPAERR_RL("fail to commit rt ip %d\n", rt_hdr.ip);
+		retval = -EPERM;
+		goto bail;
+	}
+	if (txn.add_flt_rule &&
+		ipa3_ctx->ctrl->ipa3_commit_flt(flt_hdr.ip)) {
+		IPAERR_RL("fail to commit flt ip %d\n", flt_hdr.ip);
+		retval = -EPERM;
+	}
+bail:
+	mutex_unlock(&ipa3_ctx->lock);
+	return retval;
+}
+
 static long ipa3_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	int retval = 0;
@@ -2237,39 +2360,7 @@ static long ipa3_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		break;
 
 	case IPA_IOC_ADD_HDR:
-		if (copy_from_user(header, (const void __user *)arg,
-			sizeof(struct ipa_ioc_add_hdr))) {
-			retval = -EFAULT;
-			break;
-		}
-		pre_entry =
-			((struct ipa_ioc_add_hdr *)header)->num_hdrs;
-		pyld_sz =
-		   sizeof(struct ipa_ioc_add_hdr) +
-		   pre_entry * sizeof(struct ipa_hdr_add);
-		param = memdup_user((const void __user *)arg, pyld_sz);
-		if (IS_ERR(param)) {
-			retval = PTR_ERR(param);
-			break;
-		}
-		/* add check in case user-space module compromised */
-		if (unlikely(((struct ipa_ioc_add_hdr *)param)->num_hdrs
-			!= pre_entry)) {
-			IPAERR_RL("current %d pre %d\n",
-				((struct ipa_ioc_add_hdr *)param)->num_hdrs,
-				pre_entry);
-			retval = -EFAULT;
-			break;
-		}
-		if (ipa3_add_hdr_usr((struct ipa_ioc_add_hdr *)param,
-			true)) {
-			retval = -EFAULT;
-			break;
-		}
-		if (copy_to_user((void __user *)arg, param, pyld_sz)) {
-			retval = -EFAULT;
-			break;
-		}
+		retval = ipa3_ioctl_add_hdr(arg, false);
 		break;
 
 	case IPA_IOC_DEL_HDR:
@@ -3166,7 +3257,7 @@ static long ipa3_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		break;
 
 	case IPA_IOC_ADD_RT_RULE_V2:
-		retval = ipa3_ioctl_add_rt_rule_v2(arg);
+		retval = ipa3_ioctl_add_rt_rule_v2(arg, false);
 		break;
 
 	case IPA_IOC_ADD_RT_RULE_EXT_V2:
@@ -3182,13 +3273,17 @@ static long ipa3_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		break;
 
 	case IPA_IOC_ADD_FLT_RULE_V2:
-		retval = ipa3_ioctl_add_flt_rule_v2(arg);
+		retval = ipa3_ioctl_add_flt_rule_v2(arg, false);
 		break;
 
 	case IPA_IOC_ADD_FLT_RULE_AFTER_V2:
 		retval = ipa3_ioctl_add_flt_rule_after_v2(arg);
 		break;
 
+	case IPA_IOC_RULE_TXN:
+		retval = ipa3_ioctl_rule_txn(arg);
+		break;
+
 	case IPA_IOC_MDFY_FLT_RULE_V2:
 		retval = ipa3_ioctl_mdfy_flt_rule_v2(arg);
 		break;
@@ -6722,10 +6817,23 @@ static int ipa3_post_init(const struct ipa3_plat_drv_res *resource_p,
 	else
 		IPADBG(":stats init ok\n");
 
+	result = ipa3_pmu_init();
+	if (result)
+		IPAERR("fail to init perf pmu %d\n", result);
+	else
+		IPADBG(":perf pmu init ok\n");
+
 	ipa3_register_panic_hdlr();
 
 	ipa3_debugfs_init();
 
+	/* after debugfs init, the provider adds its benchmark file there */
+	result = ipa3_dma_engine_init();
+	if (result)
+		IPAERR("fail to init dmaengine provider %d\n", result);
+	else
+		IPADBG(":dmaengine provider init ok\n");
+
 	mutex_lock(&ipa3_ctx->lock);
 	ipa3_ctx->ipa_initialization_complete = true;
 	if (ipa3_ctx->clients_registered)
@@ -7366,6 +7474,9 @@ static int ipa3_pre_init(const struct ipa3_plat_drv_res *resource_p,
 		resource_p->do_ram_collection_on_crash;
 	ipa3_ctx->lan_rx_napi_enable = resource_p->lan_rx_napi_enable;
 	ipa3_ctx->tx_napi_enable = resource_p->tx_napi_enable;
+	ipa3_ctx->ipa_rx_adaptive_intmod = resource_p->ipa_rx_adaptive_intmod;
+	ipa3_ctx->ipa_pm_predictive_scaling =
+		resource_p->ipa_pm_predictive_scaling;
 	ipa3_ctx->ipa_gpi_event_rp_ddr = resource_p->ipa_gpi_event_rp_ddr;
 	ipa3_ctx->rmnet_ctl_enable = resource_p->rmnet_ctl_enable;
 	ipa3_ctx->tx_wrapper_cache_max_size = get_tx_wrapper_cache_size(
@@ -8467,6 +8578,20 @@ static int get_ipa_dts_configuration(struct platform_device *pdev,
 		ipa_drv_res->tx_napi_enable
 		? "True" : "False");
 
+	ipa_drv_res->ipa_rx_adaptive_intmod =
+		of_property_read_bool(pdev->dev.of_node,
+		"qcom,ipa-rx-adaptive-intmod");
+	IPADBG(": Adaptive WAN rx interrupt moderation = %s\n",
+		ipa_drv_res->ipa_rx_adaptive_intmod
+		? "True" : "False");
+
+	ipa_drv_res->ipa_pm_predictive_scaling =
+		of_property_read_bool(pdev->dev.of_node,
+		"qcom,ipa-pm-predictive-scaling");
+	IPADBG(": Predictive IPA clock scaling = %s\n",
+		ipa_drv_res->ipa_pm_predictive_scaling
+		? "True" : "False");
+
 	ipa_drv_res->rmnet_ctl_enable =
 		of_property_read_bool(pdev->dev.of_node,
 		"qcom,rmnet-ctl-enable");
@@ -10133,6 +10258,8 @@ static void __exit ipa_module_exit(void)
 {
 	if (running_emulation)
 		pci_unregister_driver(&ipa_pci_driver);
+	ipa3_pmu_destroy();
+	ipa3_dma_engine_destroy();
 	platform_driver_unregister(&ipa_plat_drv);
 	unregister_pm_notifier(&ipa_pm_notifier);
 	kfree(ipa3_ctx);
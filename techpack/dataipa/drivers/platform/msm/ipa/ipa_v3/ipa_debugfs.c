@@ -1345,6 +1345,7 @@ static ssize_t ipa3_read_stats(struct file *file, char __user *ubuf,
 		"sw_tx=%u\n"
 		"hw_tx=%u\n"
 		"tx_non_linear=%u\n"
+		"tx_db_deferred=%u\n"
 		"tx_compl=%u\n"
 		"wan_rx=%u\n"
 		"stat_compl=%u\n"
@@ -1364,6 +1365,7 @@ static ssize_t ipa3_read_stats(struct file *file, char __user *ubuf,
 		ipa3_ctx->stats.tx_sw_pkts,
 		ipa3_ctx->stats.tx_hw_pkts,
 		ipa3_ctx->stats.tx_non_linear,
+		ipa3_ctx->stats.tx_db_deferred,
 		ipa3_ctx->stats.tx_pkts_compl,
 		ipa3_ctx->stats.rx_pkts,
 		ipa3_ctx->stats.stat_compl,
@@ -1430,12 +1432,16 @@ static ssize_t ipa3_read_page_recycle_stats(struct file *file,
 	nbytes = scnprintf(dbg_buff, IPA_MAX_MSG_LEN,
 			"COAL : Total number of packets replenished =%llu\n"
 			"COAL : Number of tmp alloc packets  =%llu\n"
+			"COAL : Number of lookahead recycled pages  =%llu\n"
 			"DEF  : Total number of packets replenished =%llu\n"
-			"DEF  : Number of tmp alloc packets  =%llu\n",
+			"DEF  : Number of tmp alloc packets  =%llu\n"
+			"DEF  : Number of lookahead recycled pages  =%llu\n",
 			ipa3_ctx->stats.page_recycle_stats[0].total_replenished,
 			ipa3_ctx->stats.page_recycle_stats[0].tmp_alloc,
+			ipa3_ctx->stats.page_recycle_stats[0].lookahead,
 			ipa3_ctx->stats.page_recycle_stats[1].total_replenished,
-			ipa3_ctx->stats.page_recycle_stats[1].tmp_alloc);
+			ipa3_ctx->stats.page_recycle_stats[1].tmp_alloc,
+			ipa3_ctx->stats.page_recycle_stats[1].lookahead);
 
 	cnt += nbytes;
 
@@ -3050,6 +3056,20 @@ void ipa3_debugfs_init(void)
 		goto fail;
 	}
 
+	file = debugfs_create_bool("rx_adaptive_intmod", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->ipa_rx_adaptive_intmod);
+	if (!file) {
+		IPAERR("could not create rx_adaptive_intmod file\n");
+		goto fail;
+	}
+
+	file = debugfs_create_bool("pm_predictive_scaling", IPA_READ_WRITE_MODE,
+		dent, &ipa3_ctx->ipa_pm_predictive_scaling);
+	if (!file) {
+		IPAERR("could not create pm_predictive_scaling file\n");
+		goto fail;
+	}
+
 	file = debugfs_create_u32("clock_scaling_bw_threshold_nominal_mbps",
 		IPA_READ_WRITE_MODE, dent,
 		&ipa3_ctx->ctrl->clock_scaling_bw_threshold_nominal);
@@ -3077,6 +3097,8 @@ void ipa3_debugfs_init(void)
 
 	ipa3_wigig_init_debugfs_i(dent);
 
+	ipa3_rmnet_ctl_init_debugfs(dent);
+
 	return;
 
 fail:
@@ -0,0 +1,472 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include "ipa_i.h"
+
+#define IPA_DMA_ENGINE_NAME "ipa_dma_engine"
+
+/* largest segment handed to ipa3_dma_async_memcpy(), below its 64K limit */
+#define IPA_DMA_ENGINE_SEG_SZ SZ_32K
+
+#define IPA_DMA_BENCH_MAX_SZ SZ_1M
+#define IPA_DMA_BENCH_ITER 64
+
+/*
+ * struct ipa_dma_engine_desc - one memcpy request
+ * @txd: dmaengine descriptor handed to the client
+ * @link: entry in the pending or active list
+ * @dst: IPA visible destination address
+ * @src: IPA visible source address
+ * @len: total length
+ * @queued: bytes already queued to the IPA async pipes
+ * @segs: segments queued and not yet completed
+ * @error: a segment could not be queued
+ */
+struct ipa_dma_engine_desc {
+	struct dma_async_tx_descriptor txd;
+	struct list_head link;
+	dma_addr_t dst;
+	dma_addr_t src;
+	size_t len;
+	size_t queued;
+	atomic_t segs;
+	bool error;
+};
+
+/*
+ * struct ipa_dma_engine_ctx - dmaengine memcpy provider on top of IPA DMA
+ * @ddev: registered dmaengine device
+ * @chan: the only channel, backed by the IPA async memcpy pipes
+ * @lock: protects @pending and @active
+ * @pending: submitted descriptors not yet issued
+ * @active: issued descriptors, completed in order by the IPA
+ * @wq: ordered queue feeding the IPA pipes from process context
+ * @issue_work: moves @pending to the IPA
+ * @idle: woken whenever @active drains
+ * @registered: device was registered with dmaengine
+ */
+struct ipa_dma_engine_ctx {
+	struct dma_device ddev;
+	struct dma_chan chan;
+	spinlock_t lock;
+	struct list_head pending;
+	struct list_head active;
+	struct workqueue_struct *wq;
+	struct work_struct issue_work;
+	wait_queue_head_t idle;
+	bool registered;
+};
+
+static struct ipa_dma_engine_ctx ipa_dma_engine_ctx;
+
+static inline struct ipa_dma_engine_desc *to_ipa_dma_desc(
+	struct dma_async_tx_descriptor *txd)
+{
+	return container_of(txd, struct ipa_dma_engine_desc, txd);
+}
+
+static void ipa_dma_engine_complete(struct ipa_dma_engine_desc *desc)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+	struct dma_async_tx_descriptor *txd = &desc->txd;
+	struct dmaengine_result res;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	list_del(&desc->link);
+	ctx->chan.completed_cookie = txd->cookie;
+	if (list_empty(&ctx->active))
+		wake_up_all(&ctx->idle);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	res.result = desc->error ? DMA_TRANS_ABORTED : DMA_TRANS_NOERROR;
+	res.residue = desc->error ? desc->len - desc->queued : 0;
+	if (txd->callback_result)
+		txd->callback_result(txd->callback_param, &res);
+	else if (txd->callback)
+		txd->callback(txd->callback_param);
+
+	kfree(desc);
+}
+
+static void ipa_dma_engine_seg_done(void *user1)
+{
+	struct ipa_dma_engine_desc *desc = user1;
+
+	if (atomic_dec_and_test(&desc->segs))
+		ipa_dma_engine_complete(desc);
+}
+
+static void ipa_dma_engine_issue(struct ipa_dma_engine_desc *desc)
+{
+	size_t seg;
+	int ret;
+
+	/* hold a reference so early segment completions can't free desc */
+	atomic_set(&desc->segs, 1);
+	while (desc->queued < desc->len) {
+		seg = min_t(size_t, desc->len - desc->queued,
+			IPA_DMA_ENGINE_SEG_SZ);
+		atomic_inc(&desc->segs);
+		ret = ipa3_dma_async_memcpy(desc->dst + desc->queued,
+			desc->src + desc->queued, seg,
+			ipa_dma_engine_seg_done, desc);
+		if (ret) {
+			IPAERR("failed to queue %zu bytes at %zu, ret %d\n",
+				seg, desc->queued, ret);
+			atomic_dec(&desc->segs);
+			desc->error = true;
+			break;
+		}
+		desc->queued += seg;
+	}
+	ipa_dma_engine_seg_done(desc);
+}
+
+static void ipa_dma_engine_issue_work(struct work_struct *work)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+	struct ipa_dma_engine_desc *desc;
+	unsigned long flags;
+
+	for (;;) {
+		spin_lock_irqsave(&ctx->lock, flags);
+		desc = list_first_entry_or_null(&ctx->pending,
+			struct ipa_dma_engine_desc, link);
+		if (desc)
+			list_move_tail(&desc->link, &ctx->active);
+		spin_unlock_irqrestore(&ctx->lock, flags);
+
+		if (!desc)
+			break;
+		ipa_dma_engine_issue(desc);
+	}
+}
+
+static dma_cookie_t ipa_dma_engine_tx_submit(
+	struct dma_async_tx_descriptor *txd)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+	struct dma_chan *chan = txd->chan;
+	dma_cookie_t cookie;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	cookie = chan->cookie + 1;
+	if (cookie < DMA_MIN_COOKIE)
+		cookie = DMA_MIN_COOKIE;
+	chan->cookie = txd->cookie = cookie;
+	list_add_tail(&to_ipa_dma_desc(txd)->link, &ctx->pending);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	return cookie;
+}
+
+static struct dma_async_tx_descriptor *ipa_dma_engine_prep_memcpy(
+	struct dma_chan *chan, dma_addr_t dst, dma_addr_t src,
+	size_t len, unsigned long flags)
+{
+	struct ipa_dma_engine_desc *desc;
+
+	if (!len)
+		return NULL;
+
+	desc = kzalloc(sizeof(*desc), GFP_NOWAIT);
+	if (!desc)
+		return NULL;
+
+	dma_async_tx_descriptor_init(&desc->txd, chan);
+	desc->txd.flags = flags;
+	desc->txd.tx_submit = ipa_dma_engine_tx_submit;
+	desc->dst = dst;
+	desc->src = src;
+	desc->len = len;
+
+	return &desc->txd;
+}
+
+static void ipa_dma_engine_issue_pending(struct dma_chan *chan)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+
+	queue_work(ctx->wq, &ctx->issue_work);
+}
+
+static enum dma_status ipa_dma_engine_tx_status(struct dma_chan *chan,
+	dma_cookie_t cookie, struct dma_tx_state *state)
+{
+	dma_cookie_t last_used = READ_ONCE(chan->cookie);
+	dma_cookie_t last_complete = READ_ONCE(chan->completed_cookie);
+
+	dma_set_tx_state(state, last_complete, last_used, 0);
+
+	return dma_async_is_complete(cookie, last_complete, last_used);
+}
+
+/* Descriptors already issued to the IPA can't be recalled */
+static int ipa_dma_engine_terminate_all(struct dma_chan *chan)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+	struct ipa_dma_engine_desc *desc, *tmp;
+	unsigned long flags;
+	LIST_HEAD(head);
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	list_splice_init(&ctx->pending, &head);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	list_for_each_entry_safe(desc, tmp, &head, link) {
+		list_del(&desc->link);
+		kfree(desc);
+	}
+
+	return 0;
+}
+
+static void ipa_dma_engine_synchronize(struct dma_chan *chan)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+
+	flush_work(&ctx->issue_work);
+	wait_event(ctx->idle, list_empty_careful(&ctx->active));
+}
+
+static int ipa_dma_engine_alloc_chan_resources(struct dma_chan *chan)
+{
+	int ret;
+
+	ret = ipa3_dma_init();
+	if (ret)
+		return ret;
+
+	ret = ipa3_dma_enable();
+	if (ret) {
+		ipa3_dma_destroy();
+		return ret;
+	}
+
+	return 0;
+}
+
+static void ipa_dma_engine_free_chan_resources(struct dma_chan *chan)
+{
+	ipa_dma_engine_terminate_all(chan);
+	ipa_dma_engine_synchronize(chan);
+	ipa3_dma_disable();
+	ipa3_dma_destroy();
+}
+
+#ifdef CONFIG_DEBUG_FS
+static void ipa_dma_bench_cb(void *param)
+{
+	complete(param);
+}
+
+static int ipa_dma_bench_ipa(struct dma_chan *chan, dma_addr_t dst,
+	dma_addr_t src, size_t len, u64 *lat_ns)
+{
+	struct dma_async_tx_descriptor *txd;
+	DECLARE_COMPLETION_ONSTACK(done);
+	ktime_t start;
+
+	start = ktime_get();
+	txd = dmaengine_prep_dma_memcpy(chan, dst, src, len,
+		DMA_PREP_INTERRUPT);
+	if (!txd)
+		return -ENOMEM;
+	txd->callback = ipa_dma_bench_cb;
+	txd->callback_param = &done;
+	if (dma_submit_error(dmaengine_submit(txd)))
+		return -EIO;
+	dma_async_issue_pending(chan);
+	/* issued copies can't be recalled, so @done must outlive them */
+	wait_for_completion(&done);
+	*lat_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	return 0;
+}
+
+static u64 ipa_dma_bench_mbps(size_t len, u64 ns)
+{
+	return ns ? div64_u64((u64)len * IPA_DMA_BENCH_ITER * 1000, ns) : 0;
+}
+
+/*
+ * Copy the same buffers IPA_DMA_BENCH_ITER times by CPU memcpy and by the
+ * IPA for each size, and report throughput and average IPA latency.
+ */
+static int ipa_dma_bench_show(struct seq_file *s, void *unused)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+	struct dma_chan *chan = &ctx->chan;
+	struct device *dev = ctx->ddev.dev;
+	dma_addr_t src_dma, dst_dma;
+	void *src, *dst;
+	u64 cpu_ns, ipa_ns;
+	ktime_t start;
+	size_t len;
+	int i, ret;
+
+	src = kmalloc(IPA_DMA_BENCH_MAX_SZ, GFP_KERNEL);
+	dst = kmalloc(IPA_DMA_BENCH_MAX_SZ, GFP_KERNEL);
+	if (!src || !dst) {
+		ret = -ENOMEM;
+		goto free_buf;
+	}
+	memset(src, 0x5a, IPA_DMA_BENCH_MAX_SZ);
+
+	src_dma = dma_map_single(dev, src, IPA_DMA_BENCH_MAX_SZ,
+		DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, src_dma)) {
+		ret = -ENOMEM;
+		goto free_buf;
+	}
+	dst_dma = dma_map_single(dev, dst, IPA_DMA_BENCH_MAX_SZ,
+		DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, dst_dma)) {
+		ret = -ENOMEM;
+		goto unmap_src;
+	}
+
+	/* take our own IPA DMA reference, the channel may be idle */
+	ret = ipa_dma_engine_alloc_chan_resources(chan);
+	if (ret)
+		goto unmap_dst;
+
+	seq_printf(s, "%8s %12s %12s %14s\n", "size", "cpu MB/s",
+		"ipa MB/s", "ipa lat (us)");
+	for (len = SZ_256; len <= IPA_DMA_BENCH_MAX_SZ; len <<= 1) {
+		start = ktime_get();
+		for (i = 0; i < IPA_DMA_BENCH_ITER; i++)
+			memcpy(dst, src, len);
+		cpu_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		ipa_ns = 0;
+		for (i = 0; i < IPA_DMA_BENCH_ITER; i++) {
+			ret = ipa_dma_bench_ipa(chan, dst_dma, src_dma, len,
+				&ipa_ns);
+			if (ret)
+				break;
+		}
+		if (ret) {
+			seq_printf(s, "%8zu IPA copy failed %d\n", len, ret);
+			break;
+		}
+
+		seq_printf(s, "%8zu %12llu %12llu %14llu\n", len,
+			ipa_dma_bench_mbps(len, cpu_ns),
+			ipa_dma_bench_mbps(len, ipa_ns),
+			div_u64(ipa_ns, IPA_DMA_BENCH_ITER * NSEC_PER_USEC));
+	}
+
+	ipa3_dma_disable();
+	ipa3_dma_destroy();
+	ret = 0;
+unmap_dst:
+	dma_unmap_single(dev, dst_dma, IPA_DMA_BENCH_MAX_SZ, DMA_FROM_DEVICE);
+unmap_src:
+	dma_unmap_single(dev, src_dma, IPA_DMA_BENCH_MAX_SZ, DMA_TO_DEVICE);
+free_buf:
+	kfree(dst);
+	kfree(src);
+	return ret;
+}
+DEFINE_SHOW_ATTRIBUTE(ipa_dma_bench);
+
+static void ipa_dma_engine_debugfs_init(void)
+{
+	struct dentry *root = ipa_debugfs_get_root();
+
+	if (IS_ERR_OR_NULL(root))
+		return;
+
+	debugfs_create_file("dma_bench", 0400, root, NULL,
+		&ipa_dma_bench_fops);
+}
+#else
+static void ipa_dma_engine_debugfs_init(void) {}
+#endif
+
+/**
+ * ipa3_dma_engine_init() - register the IPA async memcpy pipes as a
+ * dmaengine DMA_MEMCPY provider
+ *
+ * Clients get the channel through dma_request_chan_by_mask(); the IPA DMA
+ * pipes are connected and clocked only while the channel is held.
+ *
+ * Return codes: 0: success
+ *		Negative value: failure
+ */
+int ipa3_dma_engine_init(void)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+	struct dma_device *ddev = &ctx->ddev;
+	int ret;
+
+	if (ctx->registered)
+		return 0;
+
+	spin_lock_init(&ctx->lock);
+	INIT_LIST_HEAD(&ctx->pending);
+	INIT_LIST_HEAD(&ctx->active);
+	INIT_WORK(&ctx->issue_work, ipa_dma_engine_issue_work);
+	init_waitqueue_head(&ctx->idle);
+
+	ctx->wq = alloc_ordered_workqueue(IPA_DMA_ENGINE_NAME, WQ_HIGHPRI);
+	if (!ctx->wq)
+		return -ENOMEM;
+
+	dma_cap_zero(ddev->cap_mask);
+	dma_cap_set(DMA_MEMCPY, ddev->cap_mask);
+	ddev->dev = ipa3_ctx->pdev;
+	ddev->src_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_8_BYTES);
+	ddev->dst_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_8_BYTES);
+	ddev->directions = BIT(DMA_MEM_TO_MEM);
+	ddev->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
+	ddev->device_alloc_chan_resources =
+		ipa_dma_engine_alloc_chan_resources;
+	ddev->device_free_chan_resources = ipa_dma_engine_free_chan_resources;
+	ddev->device_prep_dma_memcpy = ipa_dma_engine_prep_memcpy;
+	ddev->device_issue_pending = ipa_dma_engine_issue_pending;
+	ddev->device_tx_status = ipa_dma_engine_tx_status;
+	ddev->device_terminate_all = ipa_dma_engine_terminate_all;
+	ddev->device_synchronize = ipa_dma_engine_synchronize;
+
+	INIT_LIST_HEAD(&ddev->channels);
+	ctx->chan.device = ddev;
+	list_add_tail(&ctx->chan.device_node, &ddev->channels);
+
+	ret = dma_async_device_register(ddev);
+	if (ret) {
+		IPAERR("failed to register dmaengine device %d\n", ret);
+		destroy_workqueue(ctx->wq);
+		return ret;
+	}
+	ctx->registered = true;
+
+	ipa_dma_engine_debugfs_init();
+
+	return 0;
+}
+
+void ipa3_dma_engine_destroy(void)
+{
+	struct ipa_dma_engine_ctx *ctx = &ipa_dma_engine_ctx;
+
+	if (!ctx->registered)
+		return;
+
+	dma_async_device_unregister(&ctx->ddev);
+	destroy_workqueue(ctx->wq);
+	ctx->registered = false;
+}
@@ -10,6 +10,7 @@
 #include <linux/dmapool.h>
 #include <linux/list.h>
 #include <linux/netdevice.h>
+#include <linux/prefetch.h>
 #include <linux/msm_gsi.h>
 #include <net/sock.h>
 #include "gsi.h"
@@ -71,6 +72,8 @@
 #define IPA_GSI_MAX_CH_LOW_WEIGHT 15
 #define IPA_GSI_EVT_RING_INT_MODT (16) /* 0.5ms under 32KHz clock */
 #define IPA_GSI_EVT_RING_INT_MODC (20)
+/* adaptive WAN moderation: poll average kept scaled by 8 */
+#define IPA_RX_INTMOD_AVG_SHIFT 3
 
 #define IPA_GSI_CH_20_WA_NUM_CH_TO_ALLOC 10
 /* The below virtual channel cannot be used by any entity */
@@ -80,6 +83,12 @@
 #define IPA_REPL_XFER_THRESH 20
 #define IPA_REPL_XFER_MAX 36
 
+/*
+ * Number of recycle ring entries scanned past a busy page before falling
+ * back to a temporary page allocation.
+ */
+#define IPA_PAGE_RECYCLE_LOOKAHEAD 16
+
 #define IPA_TX_SEND_COMPL_NOP_DELAY_NS (2 * 1000 * 1000)
 
 #define IPA_APPS_BW_FOR_PM 700
@@ -88,6 +97,9 @@
 
 #define IPA_EOT_THRESH 32
 
+/* upper bound on xmit_more packets queued before the doorbell is rung */
+#define IPA_TX_DB_DEFER_MAX 16
+
 #define IPA_QMAP_ID_BYTE 0
 
 #define IPA_MEM_ALLOC_RETRY 5
@@ -370,7 +382,7 @@ static void ipa3_send_nop_desc(struct work_struct *work)
 
 
 /**
- * ipa3_send() - Send multiple descriptors in one HW transaction
+ * __ipa3_send() - Send multiple descriptors in one HW transaction
  * @sys: system pipe context
  * @num_desc: number of packets
  * @desc: packets to send (may be immediate command or data)
@@ -384,12 +396,17 @@ static void ipa3_send_nop_desc(struct work_struct *work)
  * - Each packet (command or data) that will be sent will also be saved in
  *   ipa3_sys_context for later check that all data was sent
  *
+ * @ring_db: ring the channel doorbell; when false the doorbell is
+ *   deferred to a later send or ipa3_tx_dp_flush(), up to
+ *   IPA_TX_DB_DEFER_MAX sends
+ *
  * Return codes: 0: success, -EFAULT: failure
  */
-int ipa3_send(struct ipa3_sys_context *sys,
+static int __ipa3_send(struct ipa3_sys_context *sys,
 		u32 num_desc,
 		struct ipa3_desc *desc,
-		bool in_atomic)
+		bool in_atomic,
+		bool ring_db)
 {
 	struct ipa3_tx_pkt_wrapper *tx_pkt, *tx_pkt_first = NULL;
 	struct ipahal_imm_cmd_pyld *tag_pyld_ret = NULL;
@@ -560,15 +577,25 @@ int ipa3_send(struct ipa3_sys_context *sys,
 		}
 	}
 
+	if (!ring_db && sys->db_deferred >= IPA_TX_DB_DEFER_MAX)
+		ring_db = true;
+
 	IPADBG_LOW("ch:%lu queue xfer\n", sys->ep->gsi_chan_hdl);
 	result = gsi_queue_xfer(sys->ep->gsi_chan_hdl, num_desc,
-			gsi_xfer, true);
+			gsi_xfer, ring_db);
 	if (result != GSI_STATUS_SUCCESS) {
 		IPAERR_RL("GSI xfer failed.\n");
 		result = -EFAULT;
 		goto failure;
 	}
 
+	if (ring_db) {
+		sys->db_deferred = 0;
+	} else {
+		sys->db_deferred++;
+		IPA_STATS_INC_CNT(ipa3_ctx->stats.tx_db_deferred);
+	}
+
 	if (send_nop && !sys->nop_pending)
 		sys->nop_pending = true;
 	else
@@ -621,6 +648,25 @@ int ipa3_send(struct ipa3_sys_context *sys,
 	return result;
 }
 
+/**
+ * ipa3_send() - Send multiple descriptors in one HW transaction
+ * @sys: system pipe context
+ * @num_desc: number of packets
+ * @desc: packets to send (may be immediate command or data)
+ * @in_atomic:  whether caller is in atomic context
+ *
+ * Same as __ipa3_send() with the doorbell rung immediately.
+ *
+ * Return codes: 0: success, -EFAULT: failure
+ */
+int ipa3_send(struct ipa3_sys_context *sys,
+		u32 num_desc,
+		struct ipa3_desc *desc,
+		bool in_atomic)
+{
+	return __ipa3_send(sys, num_desc, desc, in_atomic, true);
+}
+
 /**
  * ipa3_send_one() - Send a single descriptor
  * @sys:	system pipe context
@@ -1697,6 +1743,43 @@ void ipa3_tx_cmd_comp(void *user1, int user2)
 	ipahal_destroy_imm_cmd(user1);
 }
 
+/**
+ * ipa3_tx_dp_flush() - ring a doorbell deferred by xmit_more
+ * @dst:	[in] the PROD client previously passed to ipa3_tx_dp()
+ *
+ * Must be called when a client stops submitting after a packet sent
+ * with meta->xmit_more set, e.g. when its queue is stopped.
+ *
+ * Returns:	0 on success, negative on failure
+ */
+int ipa3_tx_dp_flush(enum ipa_client_type dst)
+{
+	struct ipa3_sys_context *sys;
+	int ep_idx;
+	int ret = 0;
+
+	ep_idx = ipa3_get_ep_mapping(dst);
+	if (ep_idx == IPA_EP_NOT_ALLOCATED)
+		return -EINVAL;
+
+	sys = ipa3_ctx->ep[ep_idx].sys;
+	if (!sys || !sys->ep->valid)
+		return -EPIPE;
+
+	spin_lock_bh(&sys->spinlock);
+	if (sys->db_deferred) {
+		if (gsi_start_xfer(sys->ep->gsi_chan_hdl) !=
+			GSI_STATUS_SUCCESS) {
+			IPAERR_RL("failed to ring db for client %d\n", dst);
+			ret = -EFAULT;
+		}
+		sys->db_deferred = 0;
+	}
+	spin_unlock_bh(&sys->spinlock);
+
+	return ret;
+}
+
 /**
  * ipa3_tx_dp() - Data-path tx handler
  * @dst:	[in] which IPA destination to route tx packets to
@@ -1734,6 +1817,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 	const struct ipa_gsi_ep_config *gsi_ep;
 	int data_idx;
 	unsigned int max_desc;
+	bool ring_db = !(meta && meta->xmit_more);
 
 	if (unlikely(!ipa3_ctx)) {
 		IPAERR("IPA3 driver was not initialized\n");
@@ -1782,6 +1866,7 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 	}
 
 	trace_ipa3_tx_dp(skb,sys->ep->client);
+	ipa_pm_account_bytes(src_ep_idx, skb->len);
 	num_frags = skb_shinfo(skb)->nr_frags;
 	/*
 	 * make sure TLV FIFO supports the needed frags.
@@ -1874,7 +1959,8 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[skb_idx].callback = NULL;
 		}
 
-		if (ipa3_send(sys, num_frags + data_idx, desc, true)) {
+		if (__ipa3_send(sys, num_frags + data_idx, desc, true,
+			ring_db)) {
 			IPAERR_RL("fail to send skb %pK num_frags %u SWP\n",
 				skb, num_frags);
 			goto fail_send;
@@ -1905,7 +1991,8 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[data_idx].dma_address = meta->dma_address;
 		}
 		if (num_frags == 0) {
-			if (ipa3_send(sys, data_idx + 1, desc, true)) {
+			if (__ipa3_send(sys, data_idx + 1, desc, true,
+				ring_db)) {
 				IPAERR("fail to send skb %pK HWP\n", skb);
 				goto fail_mem;
 			}
@@ -1924,8 +2011,8 @@ int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 			desc[data_idx+f].user2 = desc[data_idx].user2;
 			desc[data_idx].callback = NULL;
 
-			if (ipa3_send(sys, num_frags + data_idx + 1,
-				desc, true)) {
+			if (__ipa3_send(sys, num_frags + data_idx + 1,
+				desc, true, ring_db)) {
 				IPAERR("fail to send skb %pK num_frags %u\n",
 					skb, num_frags);
 				goto fail_mem;
@@ -2195,6 +2282,37 @@ static inline void __trigger_repl_work(struct ipa3_sys_context *sys)
 	}
 }
 
+/*
+ * ipa3_page_recycle_lookahead() - look for an idle page after a busy one
+ *
+ * Scans up to IPA_PAGE_RECYCLE_LOOKAHEAD entries past curr and swaps the
+ * first idle page found into the curr slot. Pages owned by the hardware
+ * carry an extra reference and are never idle, so reordering the slots
+ * does not affect buffers that are in flight.
+ *
+ * Called with sys->spinlock held. Returns true if a page was swapped in.
+ */
+static bool ipa3_page_recycle_lookahead(struct ipa3_sys_context *sys,
+	u32 curr)
+{
+	struct ipa3_repl_ctx *repl = sys->page_recycle_repl;
+	struct ipa3_rx_pkt_wrapper *tmp;
+	u32 i, idx = curr;
+
+	for (i = 0; i < IPA_PAGE_RECYCLE_LOOKAHEAD; i++) {
+		idx = (++idx == repl->capacity) ? 0 : idx;
+		if (idx == curr)
+			break;
+		if (page_ref_count(repl->cache[idx]->page_data.page) == 1) {
+			tmp = repl->cache[curr];
+			repl->cache[curr] = repl->cache[idx];
+			repl->cache[idx] = tmp;
+			return true;
+		}
+	}
+
+	return false;
+}
 
 static void ipa3_replenish_rx_page_recycle(struct ipa3_sys_context *sys)
 {
@@ -2220,6 +2338,14 @@ static void ipa3_replenish_rx_page_recycle(struct ipa3_sys_context *sys)
 
 	while (rx_len_cached < sys->rx_pool_sz) {
 		cur_page = sys->page_recycle_repl->cache[curr]->page_data.page;
+		/*
+		 * A page still held by the stack at curr would otherwise force
+		 * a temporary allocation even though idle pages may follow it.
+		 */
+		if (page_ref_count(cur_page) != 1 &&
+			ipa3_page_recycle_lookahead(sys, curr))
+			ipa3_ctx->stats.page_recycle_stats[stats_i].lookahead++;
+		cur_page = sys->page_recycle_repl->cache[curr]->page_data.page;
 		/* Found an idle page that can be used */
 		if (page_ref_count(cur_page) == 1) {
 			page_ref_inc(cur_page);
@@ -3566,6 +3692,7 @@ static struct sk_buff *handle_skb_completion(struct gsi_chan_xfer_notify
 
 	if (notify->bytes_xfered)
 		rx_pkt->len = notify->bytes_xfered;
+	ipa_pm_account_bytes(sys->ep - ipa3_ctx->ep, rx_pkt->len);
 
 	/*Drop packets when WAN consumer channel receive EOB event*/
 	if ((notify->evt_id == GSI_CHAN_EVT_EOB ||
@@ -3665,6 +3792,7 @@ static struct sk_buff *handle_page_completion(struct gsi_chan_xfer_notify
 		IPAERR_RL("unexpected 0 byte_xfered\n");
 		rx_pkt->data_len = rx_pkt->len;
 	}
+	ipa_pm_account_bytes(sys->ep - ipa3_ctx->ep, rx_pkt->data_len);
 
 	if (notify->veid >= GSI_VEID_MAX) {
 		IPAERR("notify->veid > GSI_VEID_MAX\n");
@@ -3778,6 +3906,8 @@ static void ipa3_rx_napi_chain(struct ipa3_sys_context *sys,
 	/* non-coalescing case (SKB chaining enabled) */
 	if (sys->ep->client != IPA_CLIENT_APPS_WAN_COAL_CONS) {
 		for (i = 0; i < num; i++) {
+			if (i + 1 < num)
+				prefetch(notify[i + 1].xfer_user_data);
 			if (!ipa3_ctx->ipa_wan_skb_page)
 				rx_skb = handle_skb_completion(
 					&notify[i], false);
@@ -3828,6 +3958,8 @@ static void ipa3_rx_napi_chain(struct ipa3_sys_context *sys,
 			}
 		} else {
 			for (i = 0; i < num; i++) {
+				if (i + 1 < num)
+					prefetch(notify[i + 1].xfer_user_data);
 				rx_skb = handle_page_completion(
 					&notify[i], false);
 
@@ -5359,6 +5491,48 @@ int ipa3_lan_rx_poll(u32 clnt_hdl, int weight)
 	return cnt;
 }
 
+/**
+ * ipa3_rx_adapt_int_mod() - track how much of the NAPI budget the WAN
+ * pipe consumes and retune the event ring interrupt moderation before
+ * re-arming the interrupt.
+ *
+ * Under load (average above 3/4 of the budget) the ring is moderated so
+ * that one interrupt covers a full batch; when traffic is sparse
+ * (average below 1/8 of the budget) every event raises the interrupt to
+ * keep latency low. The gap between the two thresholds avoids flapping.
+ */
+static void ipa3_rx_adapt_int_mod(struct ipa3_ep_context *ep, int cnt,
+	int weight)
+{
+	struct ipa3_sys_context *sys = ep->sys;
+	u32 avg = sys->napi_avg_cnt;
+	bool low_lat = sys->int_mod_low_lat;
+	int ret;
+
+	/* avg = 7/8 * avg + 1/8 * cnt, in units of 1/8 packet */
+	avg = avg - (avg >> IPA_RX_INTMOD_AVG_SHIFT) + cnt;
+	sys->napi_avg_cnt = avg;
+	avg >>= IPA_RX_INTMOD_AVG_SHIFT;
+
+	if (low_lat && avg > (weight * 3) / 4)
+		low_lat = false;
+	else if (!low_lat && avg < weight / 8)
+		low_lat = true;
+	else
+		return;
+
+	ret = gsi_set_evt_ring_int_mod(ep->gsi_evt_ring_hdl,
+		IPA_GSI_EVT_RING_INT_MODT,
+		low_lat ? 1 : IPA_GSI_EVT_RING_INT_MODC);
+	if (ret != GSI_STATUS_SUCCESS) {
+		IPAERR("failed to set int mod on client %d ret=%d\n",
+			ep->client, ret);
+		return;
+	}
+	sys->int_mod_low_lat = low_lat;
+	IPA_STATS_INC_CNT(sys->int_mod_switch_cnt);
+}
+
 /**
  * ipa3_rx_poll() - Poll the WAN rx packets from IPA HW. This
  * function is exectued in the softirq context
@@ -5439,6 +5613,8 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 		}
 	}
 	cnt += weight - remain_aggr_weight * ipa3_ctx->ipa_wan_aggr_pkt_cnt;
+	if (ipa3_ctx->ipa_rx_adaptive_intmod)
+		ipa3_rx_adapt_int_mod(ep, cnt, weight);
 	/* call repl_hdlr before napi_reschedule / napi_complete */
 	ep->sys->repl_hdlr(ep->sys);
 	/* When not able to replenish enough descriptors, keep in polling
@@ -5585,11 +5761,35 @@ static u32 ipa_adjust_ra_buff_base_sz(u32 aggr_byte_limit)
 	return aggr_byte_limit >> 1;
 }
 
+/*
+ * Keep polling an empty low latency channel for up to the configured
+ * busy-poll budget before paying for the switch back to interrupt mode.
+ * The budget restarts whenever a packet shows up.
+ */
+static bool ipa3_rx_busy_poll(struct ipa3_sys_context *sys, ktime_t *end)
+{
+	u32 budget_us = ipa3_rmnet_ctl_busy_poll_us();
+	ktime_t now;
+
+	if (!budget_us)
+		return false;
+
+	now = ktime_get();
+	if (!*end)
+		*end = ktime_add_us(now, budget_us);
+	if (!ktime_before(now, *end))
+		return false;
+
+	cpu_relax();
+	return true;
+}
+
 static void ipa3_tasklet_rx_notify(unsigned long data)
 {
 	struct ipa3_sys_context *sys;
 	struct sk_buff *rx_skb;
 	struct gsi_chan_xfer_notify notify;
+	ktime_t busy_end;
 	int ret;
 
 	sys = (struct ipa3_sys_context *)data;
@@ -5600,10 +5800,15 @@ static void ipa3_tasklet_rx_notify(unsigned long data)
 	 * This is mainly for clock scaling.
 	 */
 	ipa_pm_activate(sys->pm_hdl);
+	busy_end = 0;
 	while (1) {
 		ret = ipa_poll_gsi_pkt(sys, &notify);
+		if (ret == GSI_STATUS_POLL_EMPTY &&
+			ipa3_rx_busy_poll(sys, &busy_end))
+			continue;
 		if (ret)
 			break;
+		busy_end = 0;
 		rx_skb = handle_skb_completion(&notify, true);
 		if (rx_skb) {
 			sys->pyld_hdlr(rx_skb, sys);
@@ -223,7 +223,16 @@ static int ipa_translate_flt_tbl_to_hw_fmt(enum ipa_ip_type ip,
 			hdr_idx++;
 			continue;
 		}
-		if (tbl->in_sys[rlt]) {
+		if (tbl->in_sys[rlt] && !tbl->dirty &&
+			tbl->curr_mem[rlt].phys_base) {
+			/* unchanged since last commit, keep current body */
+			if (ipahal_fltrt_write_addr_to_hdr(
+				tbl->curr_mem[rlt].phys_base, hdr, hdr_idx,
+				true)) {
+				IPAERR("fail to wrt sys tbl addr to hdr\n");
+				goto err;
+			}
+		} else if (tbl->in_sys[rlt]) {
 			/* only body (no header) */
 			tbl_mem.size = tbl->sz[rlt] -
 				ipahal_get_hw_tbl_hdr_width();
@@ -471,11 +480,85 @@ static bool ipa_flt_skip_pipe_config(int pipe)
 	return false;
 }
 
+/**
+ * ipa_flt_hdr_changed() - check if a pipe's table header entries differ
+ *  from what the previous commit left in SRAM
+ * @tbl: the flt tbl of the pipe
+ * @alloc_params: the freshly generated images
+ * @hdr_idx: index of the pipe's entry in the header images
+ *
+ * Return: true if the entries must be written again
+ */
+static bool ipa_flt_hdr_changed(struct ipa3_flt_tbl *tbl,
+	struct ipahal_fltrt_alloc_imgs_params *alloc_params, int hdr_idx)
+{
+	u32 width = ipahal_get_hw_tbl_hdr_width();
+
+	if (!tbl->hw_hdr_valid || width > sizeof(tbl->hw_hdr[0]))
+		return true;
+
+	if (memcmp(&tbl->hw_hdr[IPA_RULE_NON_HASHABLE],
+		alloc_params->nhash_hdr.base + hdr_idx * width, width))
+		return true;
+
+	if (!ipa3_ctx->ipa_fltrt_not_hashable &&
+		memcmp(&tbl->hw_hdr[IPA_RULE_HASHABLE],
+		alloc_params->hash_hdr.base + hdr_idx * width, width))
+		return true;
+
+	return false;
+}
+
+/**
+ * ipa_flt_update_hdr_cache() - record the committed header entries
+ *  and mark all tables clean
+ * @ip: the ip address family type
+ * @alloc_params: the images that were written to SRAM, NULL to
+ *  invalidate the cache after a failed commit
+ */
+static void ipa_flt_update_hdr_cache(enum ipa_ip_type ip,
+	struct ipahal_fltrt_alloc_imgs_params *alloc_params)
+{
+	struct ipa3_flt_tbl *tbl;
+	u32 width = ipahal_get_hw_tbl_hdr_width();
+	int hdr_idx = 0;
+	int i;
+
+	for (i = 0; i < ipa3_ctx->ipa_num_pipes; i++) {
+		if (!ipa_is_ep_support_flt(i))
+			continue;
+
+		tbl = &ipa3_ctx->flt_tbl[i][ip];
+		if (!alloc_params || width > sizeof(tbl->hw_hdr[0])) {
+			tbl->hw_hdr_valid = false;
+			hdr_idx++;
+			continue;
+		}
+
+		tbl->dirty = false;
+		if (ipa_flt_skip_pipe_config(i)) {
+			hdr_idx++;
+			continue;
+		}
+
+		memcpy(&tbl->hw_hdr[IPA_RULE_NON_HASHABLE],
+			alloc_params->nhash_hdr.base + hdr_idx * width, width);
+		if (!ipa3_ctx->ipa_fltrt_not_hashable)
+			memcpy(&tbl->hw_hdr[IPA_RULE_HASHABLE],
+				alloc_params->hash_hdr.base + hdr_idx * width,
+				width);
+		tbl->hw_hdr_valid = true;
+		hdr_idx++;
+	}
+}
+
 /**
  * __ipa_commit_flt_v3() - commit flt tables to the hw
  *  commit the headers and the bodies if are local with internal cache flushing.
  *  The headers (and local bodies) will first be created into dma buffers and
- *  then written via IC to the SRAM
+ *  then written via IC to the SRAM. Header entries identical to what the
+ *  previous commit wrote are skipped, and system memory bodies of tables
+ *  without rule changes are reused as is.
  * @ipt: the ip address family type
  *
  * Return: 0 on success, negative on failure
@@ -651,6 +734,14 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 			continue;
 		}
 
+		if (!ipa_flt_hdr_changed(&ipa3_ctx->flt_tbl[i][ip],
+			&alloc_params, hdr_idx)) {
+			IPADBG_LOW("hdr at index %d for pipe %d unchanged\n",
+				hdr_idx, i);
+			hdr_idx++;
+			continue;
+		}
+
 		if (num_cmd + 1 >= entries) {
 			IPAERR("number of commands is out of range: IP = %d\n",
 				ip);
@@ -761,11 +852,14 @@ int __ipa_commit_flt_v3(enum ipa_ip_type ip)
 		++num_cmd;
 	}
 
-	if (ipa3_send_cmd(num_cmd, desc)) {
+	/* with no header changed there may be nothing to write */
+	if (num_cmd && ipa3_send_cmd(num_cmd, desc)) {
 		IPAERR("fail to send immediate command\n");
+		ipa_flt_update_hdr_cache(ip, NULL);
 		rc = -EFAULT;
 		goto fail_imm_cmd_construct;
 	}
+	ipa_flt_update_hdr_cache(ip, &alloc_params);
 
 	IPADBG_LOW("Hashable HEAD\n");
 	IPA_DUMP_BUFF(alloc_params.hash_hdr.base,
@@ -947,6 +1041,7 @@ static int __ipa_finish_flt_rule_add(struct ipa3_flt_tbl *tbl,
 {
 	int id;
 
+	tbl->dirty = true;
 	if (tbl->rule_cnt < IPA_RULE_CNT_MAX)
 		tbl->rule_cnt++;
 	else
@@ -1077,6 +1172,7 @@ static int __ipa_del_flt_rule(u32 rule_hdl)
 	id = entry->id;
 
 	list_del(&entry->link);
+	entry->tbl->dirty = true;
 	entry->tbl->rule_cnt--;
 	if (entry->rt_tbl && !ipa3_check_idr_if_freed(entry->rt_tbl))
 		entry->rt_tbl->ref_cnt--;
@@ -1119,6 +1215,7 @@ static int __ipa_mdfy_flt_rule(struct ipa_flt_rule_mdfy_i *frule,
 	if (entry->rt_tbl)
 		entry->rt_tbl->ref_cnt--;
 
+	entry->tbl->dirty = true;
 	entry->rule = frule->rule;
 	entry->rt_tbl = rt_tbl;
 	if (entry->rt_tbl)
@@ -1856,6 +1953,7 @@ int ipa3_reset_flt(enum ipa_ip_type ip, bool user_only)
 			if (!user_only ||
 					entry->ipacm_installed) {
 				list_del(&entry->link);
+				entry->tbl->dirty = true;
 				entry->tbl->rule_cnt--;
 				if (entry->rt_tbl &&
 					(!ipa3_check_idr_if_freed(
@@ -6,6 +6,8 @@
 #include <linux/debugfs.h>
 #include <linux/kernel.h>
 #include <linux/delay.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
 #include "ipa_i.h"
 #include "ipahal.h"
 #include "ipahal_hw_stats.h"
@@ -15,6 +17,8 @@
 		ipa3_get_ep_mapping(client) < IPA_STATS_MAX_PIPE_BIT) ? \
 		(1 << ipa3_get_ep_mapping(client)) : 0)
 
+static void ipa_hw_stats_snap_work(struct work_struct *work);
+
 int ipa_hw_stats_init(void)
 {
 	int ret = 0, ep_index;
@@ -25,6 +29,9 @@ int ipa_hw_stats_init(void)
 
 	/* initialize stats here */
 	ipa3_ctx->hw_stats.enabled = true;
+	mutex_init(&ipa3_ctx->hw_stats.snap.lock);
+	INIT_DELAYED_WORK(&ipa3_ctx->hw_stats.snap.work,
+		ipa_hw_stats_snap_work);
 
 	teth_stats_init = kzalloc(sizeof(*teth_stats_init), GFP_KERNEL);
 	if (!teth_stats_init) {
@@ -1867,6 +1874,111 @@ int ipa_reset_all_drop_stats(void)
 }
 
 
+static void ipa_hw_stats_snap_record(struct ipa_hw_stats_snap *snap, int status)
+{
+	struct ipa_hw_stats_snap_ring *ring = snap->ring;
+	struct ipa_hw_stats_snap_rec *rec;
+	u32 idx;
+
+	idx = (ring->head + 1) % IPA_HW_STATS_SNAP_RING_LEN;
+	rec = &ring->rec[idx];
+
+	/* odd seq tells mmap readers a record is being rewritten */
+	WRITE_ONCE(ring->seq, ring->seq + 1);
+	smp_wmb();
+	rec->timestamp_ns = ktime_get_boottime_ns();
+	rec->status = status;
+	rec->quota = ipa3_ctx->hw_stats.quota.stats;
+	rec->drop = ipa3_ctx->hw_stats.drop.stats;
+	WRITE_ONCE(ring->head, idx);
+	smp_wmb();
+	WRITE_ONCE(ring->seq, ring->seq + 1);
+}
+
+static void ipa_hw_stats_snap_work(struct work_struct *work)
+{
+	struct ipa_hw_stats_snap *snap = container_of(to_delayed_work(work),
+		struct ipa_hw_stats_snap, work);
+	int ret = 0;
+
+	IPA_ACTIVE_CLIENTS_PREP_SIMPLE(log_info);
+
+	mutex_lock(&snap->lock);
+	if (!snap->interval_ms)
+		goto bail;
+
+	/*
+	 * Counters do not move while IPA is clocked off, so never vote
+	 * just to sample them; the cached totals are still current.
+	 */
+	if (ipa3_inc_client_enable_clks_no_block(&log_info)) {
+		snap->skipped++;
+		goto requeue;
+	}
+
+	ret = ipa_get_quota_stats(NULL);
+	if (!ret)
+		ret = ipa_get_teth_stats();
+	if (!ret)
+		ret = ipa_get_drop_stats(NULL);
+	IPA_ACTIVE_CLIENTS_DEC_SIMPLE();
+	if (ret)
+		IPAERR_RL("stats snapshot failed %d\n", ret);
+
+	ipa_hw_stats_snap_record(snap, ret);
+
+requeue:
+	queue_delayed_work(system_unbound_wq, &snap->work,
+		msecs_to_jiffies(snap->interval_ms));
+bail:
+	mutex_unlock(&snap->lock);
+}
+
+/**
+ * ipa_hw_stats_snap_set_interval() - start, retune or stop the periodic
+ * HW stats snapshot
+ * @interval_ms: sampling period, 0 stops sampling
+ *
+ * While sampling runs, the driver caches for quota, tethering and drop stats
+ * are refreshed in the background and readers are served from the cache.
+ *
+ * Return value: 0 on success, negative otherwise
+ */
+int ipa_hw_stats_snap_set_interval(u32 interval_ms)
+{
+	struct ipa_hw_stats_snap *snap = &ipa3_ctx->hw_stats.snap;
+
+	if (!ipa3_ctx->hw_stats.enabled)
+		return -EPERM;
+
+	mutex_lock(&snap->lock);
+	if (interval_ms && !snap->ring) {
+		snap->ring = vmalloc_user(PAGE_ALIGN(sizeof(*snap->ring)));
+		if (!snap->ring) {
+			mutex_unlock(&snap->lock);
+			return -ENOMEM;
+		}
+		snap->ring->num_recs = IPA_HW_STATS_SNAP_RING_LEN;
+		snap->ring->rec_size = sizeof(struct ipa_hw_stats_snap_rec);
+		snap->ring->head = IPA_HW_STATS_SNAP_RING_LEN - 1;
+	}
+	snap->interval_ms = interval_ms;
+	mutex_unlock(&snap->lock);
+
+	if (interval_ms)
+		mod_delayed_work(system_unbound_wq, &snap->work, 0);
+	else
+		cancel_delayed_work_sync(&snap->work);
+
+	return 0;
+}
+
+bool ipa_hw_stats_snap_active(void)
+{
+	return ipa3_ctx->hw_stats.enabled &&
+		READ_ONCE(ipa3_ctx->hw_stats.snap.interval_ms);
+}
+
 #ifndef CONFIG_DEBUG_FS
 int ipa_debugfs_init_stats(struct dentry *parent) { return 0; }
 #else
@@ -2342,6 +2454,55 @@ static ssize_t ipa_debugfs_enable_disable_drop_stats(struct file *file,
 	return ret;
 }
 
+static ssize_t ipa_debugfs_read_snap_interval(struct file *file,
+	char __user *ubuf, size_t count, loff_t *ppos)
+{
+	struct ipa_hw_stats_snap *snap = &ipa3_ctx->hw_stats.snap;
+	int nbytes;
+
+	nbytes = scnprintf(dbg_buff, IPA_MAX_MSG_LEN,
+		"interval_ms=%u skipped=%u\n",
+		snap->interval_ms, snap->skipped);
+
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, nbytes);
+}
+
+static ssize_t ipa_debugfs_write_snap_interval(struct file *file,
+	const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	u32 interval_ms;
+	int ret;
+
+	ret = kstrtou32_from_user(ubuf, count, 0, &interval_ms);
+	if (ret)
+		return ret;
+
+	ret = ipa_hw_stats_snap_set_interval(interval_ms);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static int ipa_debugfs_mmap_snap_ring(struct file *file,
+	struct vm_area_struct *vma)
+{
+	struct ipa_hw_stats_snap *snap = &ipa3_ctx->hw_stats.snap;
+	int ret;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	mutex_lock(&snap->lock);
+	if (!snap->ring)
+		ret = -ENODEV;
+	else
+		ret = remap_vmalloc_range(vma, snap->ring, vma->vm_pgoff);
+	mutex_unlock(&snap->lock);
+
+	return ret;
+}
+
 static const struct file_operations ipa3_quota_ops = {
 	.read = ipa_debugfs_print_quota_stats,
 	.write = ipa_debugfs_reset_quota_stats,
@@ -2366,6 +2527,15 @@ static const struct file_operations ipa3_enable_drop_ops = {
 	.write = ipa_debugfs_enable_disable_drop_stats,
 };
 
+static const struct file_operations ipa3_snap_interval_ops = {
+	.read = ipa_debugfs_read_snap_interval,
+	.write = ipa_debugfs_write_snap_interval,
+};
+
+static const struct file_operations ipa3_snap_ring_ops = {
+	.mmap = ipa_debugfs_mmap_snap_ring,
+};
+
 int ipa_debugfs_init_stats(struct dentry *parent)
 {
 	const mode_t read_write_mode = 0664;
@@ -2417,6 +2587,20 @@ int ipa_debugfs_init_stats(struct dentry *parent)
 		goto fail;
 	}
 
+	file = debugfs_create_file("snapshot_interval_ms", read_write_mode,
+		dent, NULL, &ipa3_snap_interval_ops);
+	if (IS_ERR_OR_NULL(file)) {
+		IPAERR("fail to create file %s\n", "snapshot_interval_ms");
+		goto fail;
+	}
+
+	file = debugfs_create_file("snapshot_ring", 0440, dent, NULL,
+		&ipa3_snap_ring_ops);
+	if (IS_ERR_OR_NULL(file)) {
+		IPAERR("fail to create file %s\n", "snapshot_ring");
+		goto fail;
+	}
+
 	return 0;
 fail:
 	debugfs_remove_recursive(dent);
@@ -830,6 +830,9 @@ struct ipa3_hdr_proc_ctx_tbl {
  * @curr_mem: current filter tables block in sys memory
  * @prev_mem: previous filter table block in sys memory
  * @rule_ids: common idr structure that holds the rule_id for each rule
+ * @dirty: rules changed since the last successful commit
+ * @hw_hdr: table header entries last written to SRAM
+ * @hw_hdr_valid: flag indicating if hw_hdr mirrors SRAM
  */
 struct ipa3_flt_tbl {
 	struct list_head head_flt_rule_list;
@@ -840,6 +843,9 @@ struct ipa3_flt_tbl {
 	struct ipa_mem_buffer prev_mem[IPA_RULE_TYPE_MAX];
 	bool sticky_rear;
 	struct idr *rule_ids;
+	bool dirty;
+	u64 hw_hdr[IPA_RULE_TYPE_MAX];
+	bool hw_hdr_valid;
 };
 
 /**
@@ -1065,6 +1071,9 @@ struct ipa3_repl_ctx {
  * @napi_tx: napi for eot write done handle (tx_complete) - to replace tasklet
  * @in_napi_context: an atomic variable used for non-blocking locking,
  * preventing from multiple napi_sched to be called.
+ * @napi_avg_cnt: running average of packets per NAPI poll, scaled by 8
+ * @int_mod_low_lat: event ring currently interrupts on every event
+ * @db_deferred: descriptors queued since the doorbell was last rung
  *
  * IPA context specific to the GPI pipes a.k.a LAN IN/OUT and WAN
  */
@@ -1102,6 +1111,9 @@ struct ipa3_sys_context {
 	u32 eob_drop_cnt;
 	struct napi_struct napi_tx;
 	atomic_t in_napi_context;
+	u32 napi_avg_cnt;
+	bool int_mod_low_lat;
+	u32 db_deferred;
 
 	/* ordering is important - mutable fields go above */
 	struct ipa3_ep_context *ep;
@@ -1117,6 +1129,7 @@ struct ipa3_sys_context {
 	u32 pm_hdl;
 	unsigned int napi_sch_cnt;
 	unsigned int napi_comp_cnt;
+	unsigned int int_mod_switch_cnt;
 	/* ordering is important - other immutable fields go below */
 };
 
@@ -1424,6 +1437,7 @@ enum ipa3_config_this_ep {
 struct ipa3_page_recycle_stats {
 	u64 total_replenished;
 	u64 tmp_alloc;
+	u64 lookahead;
 };
 struct ipa3_stats {
 	u32 tx_sw_pkts;
@@ -1447,6 +1461,7 @@ struct ipa3_stats {
 	u32 flow_enable;
 	u32 flow_disable;
 	u32 tx_non_linear;
+	u32 tx_db_deferred;
 	u32 rx_page_drop_cnt;
 	struct ipa3_page_recycle_stats page_recycle_stats[2];
 	u64 lower_order;
@@ -1763,12 +1778,43 @@ struct ipa_hw_stats_drop {
 	struct ipa_drop_stats_all stats;
 };
 
+#define IPA_HW_STATS_SNAP_RING_LEN 8
+
+/* one periodic sample of the cumulative quota and drop counters */
+struct ipa_hw_stats_snap_rec {
+	u64 timestamp_ns;
+	int status;
+	struct ipa_quota_stats_all quota;
+	struct ipa_drop_stats_all drop;
+};
+
+/*
+ * Layout shared with userspace through the hw_stats/snapshot_ring mmap.
+ * seq is odd while rec[head] is being rewritten; readers retry on change.
+ */
+struct ipa_hw_stats_snap_ring {
+	u32 seq;
+	u32 head;
+	u32 num_recs;
+	u32 rec_size;
+	struct ipa_hw_stats_snap_rec rec[IPA_HW_STATS_SNAP_RING_LEN];
+};
+
+struct ipa_hw_stats_snap {
+	struct delayed_work work;
+	struct mutex lock;
+	u32 interval_ms;
+	u32 skipped;
+	struct ipa_hw_stats_snap_ring *ring;
+};
+
 struct ipa_hw_stats {
 	bool enabled;
 	struct ipa_hw_stats_quota quota;
 	struct ipa_hw_stats_teth teth;
 	struct ipa_hw_stats_flt_rt flt_rt;
 	struct ipa_hw_stats_drop drop;
+	struct ipa_hw_stats_snap snap;
 };
 
 struct ipa_cne_evt {
@@ -2139,6 +2185,8 @@ struct ipa3_context {
 	/* dummy netdev for lan RX NAPI */
 	bool lan_rx_napi_enable;
 	bool tx_napi_enable;
+	bool ipa_rx_adaptive_intmod;
+	bool ipa_pm_predictive_scaling;
 	struct net_device generic_ndev;
 	struct napi_struct napi_lan_rx;
 	u32 icc_num_cases;
@@ -2199,6 +2247,8 @@ struct ipa3_plat_drv_res {
 	bool tethered_flow_control;
 	bool lan_rx_napi_enable;
 	bool tx_napi_enable;
+	bool ipa_rx_adaptive_intmod;
+	bool ipa_pm_predictive_scaling;
 	u32 mhi_evid_limits[2]; /* start and end values */
 	bool ipa_mhi_dynamic_config;
 	u32 ipa_tz_unlock_reg_num;
@@ -2676,6 +2726,7 @@ int ipa3_set_single_ndp_per_mbim(bool enable);
 /*
  * Data path
  */
+int ipa3_tx_dp_flush(enum ipa_client_type dst);
 int ipa3_tx_dp(enum ipa_client_type dst, struct sk_buff *skb,
 		struct ipa_tx_meta *metadata);
 
@@ -3019,6 +3070,36 @@ struct ipa_teth_stats_endpoints {
 
 int ipa_hw_stats_init(void);
 
+#ifdef CONFIG_PERF_EVENTS
+int ipa3_pmu_init(void);
+
+void ipa3_pmu_destroy(void);
+#else
+static inline int ipa3_pmu_init(void)
+{
+	return 0;
+}
+
+static inline void ipa3_pmu_destroy(void)
+{
+}
+#endif
+
+#ifdef CONFIG_DMA_ENGINE
+int ipa3_dma_engine_init(void);
+
+void ipa3_dma_engine_destroy(void);
+#else
+static inline int ipa3_dma_engine_init(void)
+{
+	return 0;
+}
+
+static inline void ipa3_dma_engine_destroy(void)
+{
+}
+#endif
+
 int ipa_init_flt_rt_stats(void);
 
 int ipa_debugfs_init_stats(struct dentry *parent);
@@ -3037,6 +3118,10 @@ int ipa_init_drop_stats(u32 pipe_bitmask);
 
 int ipa_get_drop_stats(struct ipa_drop_stats_all *out);
 
+int ipa_hw_stats_snap_set_interval(u32 interval_ms);
+
+bool ipa_hw_stats_snap_active(void);
+
 int ipa_reset_drop_stats(enum ipa_client_type client);
 
 int ipa_reset_all_drop_stats(void);
@@ -3114,6 +3199,9 @@ int ipa3_register_rmnet_ctl_cb(
 	void *user_data3);
 int ipa3_unregister_rmnet_ctl_cb(void);
 int ipa3_rmnet_ctl_xmit(struct sk_buff *skb);
+u32 ipa3_rmnet_ctl_busy_poll_us(void);
+int ipa3_rmnet_ctl_set_lat_session(bool enable);
+int ipa3_rmnet_ctl_init_debugfs(struct dentry *parent);
 int ipa3_setup_apps_low_lat_prod_pipe(void);
 int ipa3_setup_apps_low_lat_cons_pipe(void);
 int ipa3_teardown_apps_low_lat_pipes(void);
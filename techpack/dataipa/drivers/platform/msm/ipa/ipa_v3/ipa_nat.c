@@ -33,6 +33,8 @@
 #define IPA_NAT_MAX_NUM_OF_INIT_CMD_DESC 4
 #define IPA_IPV6CT_MAX_NUM_OF_INIT_CMD_DESC 3
 #define IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC 5
+/* upper bound of one ipa3_send_cmd() chain, same as IPA_SEND_MAX_DESC */
+#define IPA_MAX_NUM_OF_TABLE_DMA_BATCH_DESC 20
 
 /*
  * The base table max entries is limited by index into table 13 bits number.
@@ -1852,12 +1854,39 @@ static int ipa3_table_validate_table_dma_one(
 }
 
 
+/**
+ * ipa3_table_dma_max_desc() - number of descriptors one TABLE_DMA chain
+ * may use on the command pipe
+ */
+static int ipa3_table_dma_max_desc(void)
+{
+	const struct ipa_gsi_ep_config *gsi_ep_cfg;
+	int max_desc;
+
+	gsi_ep_cfg = ipa3_get_gsi_ep_info(IPA_CLIENT_APPS_CMD_PROD);
+	if (!gsi_ep_cfg)
+		return IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC;
+
+	max_desc = gsi_ep_cfg->ipa_if_tlv;
+	if (gsi_ep_cfg->prefetch_mode == GSI_SMART_PRE_FETCH ||
+		gsi_ep_cfg->prefetch_mode == GSI_FREE_PRE_FETCH)
+		max_desc -= gsi_ep_cfg->prefetch_threshold;
+
+	return clamp_t(int, max_desc, IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC,
+		IPA_MAX_NUM_OF_TABLE_DMA_BATCH_DESC);
+}
+
 /**
  * ipa3_table_dma_cmd() - Post TABLE_DMA command to IPA HW
  * @dma:	[in] initialization command attributes
  *
  * Called by NAT/IPv6CT clients to post TABLE_DMA command to IPA HW
  *
+ * All entries are validated before anything is sent. They are then
+ * posted in as few chains as the command pipe allows, each preceded by
+ * the coalescing close and the pipeline clearing NOP, preserving the
+ * order given by the caller.
+ *
  * Returns:	0 on success, negative on failure
  */
 int ipa3_table_dma_cmd(
@@ -1868,16 +1897,19 @@ int ipa3_table_dma_cmd(
 	enum ipahal_imm_cmd_name cmd_name = IPA_IMM_CMD_NAT_DMA;
 
 	struct ipahal_imm_cmd_table_dma cmd;
-	struct ipahal_imm_cmd_pyld *cmd_pyld[IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC];
-	struct ipa3_desc desc[IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC];
+	struct ipahal_imm_cmd_pyld **cmd_pyld;
+	struct ipa3_desc *desc;
 
 	uint8_t cnt, num_cmd = 0;
+	uint8_t start, end;
 
 	int result = 0;
 	int i;
 	struct ipahal_reg_valmask valmask;
 	struct ipahal_imm_cmd_register_write reg_write_coal_close;
-	int max_dma_table_cmds = IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC;
+	int max_desc;
+	int max_dma_table_cmds;
+	int coal_ep;
 
 	IPADBG("In\n");
 
@@ -1899,20 +1931,7 @@ int ipa3_table_dma_cmd(
 
 	IPADBG("nmi(%s)\n", ipa3_nat_mem_in_as_str(dma->mem_type));
 
-	memset(&cmd, 0, sizeof(cmd));
-	memset(cmd_pyld, 0, sizeof(cmd_pyld));
-	memset(desc, 0, sizeof(desc));
-
-	/**
-	 * We use a descriptor for closing coalsceing endpoint
-	 * by immediate command. So, DMA entries should be less than
-	 * IPA_MAX_NUM_OF_TABLE_DMA_CMD_DESC - 1 to overcome
-	 * buffer overflow of ipa3_desc array.
-	 */
-	if (ipa3_get_ep_mapping(IPA_CLIENT_APPS_WAN_COAL_CONS) != -1)
-		max_dma_table_cmds -= 1;
-
-	if (!dma->entries || dma->entries > (max_dma_table_cmds - 1)) {
+	if (!dma->entries) {
 		IPAERR_RL("Invalid number of entries %d\n",
 			dma->entries);
 		result = -EPERM;
@@ -1931,62 +1950,70 @@ int ipa3_table_dma_cmd(
 		}
 	}
 
-	/* IC to close the coal frame before HPS Clear if coal is enabled */
-	if (ipa3_get_ep_mapping(IPA_CLIENT_APPS_WAN_COAL_CONS) != -1) {
-		i = ipa3_get_ep_mapping(IPA_CLIENT_APPS_WAN_COAL_CONS);
-		reg_write_coal_close.skip_pipeline_clear = false;
-		reg_write_coal_close.pipeline_clear_options = IPAHAL_HPS_CLEAR;
-		reg_write_coal_close.offset = ipahal_get_reg_ofst(
-			IPA_AGGR_FORCE_CLOSE);
-		ipahal_get_aggr_force_close_valmask(i, &valmask);
-		reg_write_coal_close.value = valmask.val;
-		reg_write_coal_close.value_mask = valmask.mask;
-		cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
-			IPA_IMM_CMD_REGISTER_WRITE,
-			&reg_write_coal_close, false);
-		if (!cmd_pyld[num_cmd]) {
-			IPAERR("failed to construct coal close IC\n");
-			result = -ENOMEM;
-			goto destroy_imm_cmd;
-		}
-		ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
-		++num_cmd;
-	}
-
-	/*
-	 * NO-OP IC for ensuring that IPA pipeline is empty
+	/**
+	 * Each chain starts with a NOP for ensuring that IPA pipeline is
+	 * empty, and with an immediate command closing the coalescing
+	 * endpoint when there is one.
 	 */
-	cmd_pyld[num_cmd] =
-		ipahal_construct_nop_imm_cmd(false, IPAHAL_HPS_CLEAR, false);
+	max_desc = ipa3_table_dma_max_desc();
+	max_dma_table_cmds = max_desc - 1;
+	coal_ep = ipa3_get_ep_mapping(IPA_CLIENT_APPS_WAN_COAL_CONS);
+	if (coal_ep != -1)
+		max_dma_table_cmds -= 1;
 
-	if (!cmd_pyld[num_cmd]) {
-		IPAERR("Failed to construct NOP imm cmd\n");
+	desc = kcalloc(max_desc, sizeof(*desc), GFP_KERNEL);
+	cmd_pyld = kcalloc(max_desc, sizeof(*cmd_pyld), GFP_KERNEL);
+	if (!desc || !cmd_pyld) {
 		result = -ENOMEM;
-		goto destroy_imm_cmd;
+		goto free_mem;
 	}
 
-	ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
-
-	++num_cmd;
-
 	/*
 	 * NAT_DMA was renamed to TABLE_DMA starting from IPAv4
 	 */
 	if (ipa3_ctx->ipa_hw_type >= IPA_HW_v4_0)
 		cmd_name = IPA_IMM_CMD_TABLE_DMA;
 
-	for (cnt = 0; cnt < dma->entries; ++cnt) {
+	memset(&cmd, 0, sizeof(cmd));
 
-		cmd.table_index = dma->dma[cnt].table_index;
-		cmd.base_addr   = dma->dma[cnt].base_addr;
-		cmd.offset      = dma->dma[cnt].offset;
-		cmd.data        = dma->dma[cnt].data;
+	for (start = 0; start < dma->entries; start = end) {
+		end = min_t(int, dma->entries, start + max_dma_table_cmds);
+		num_cmd = 0;
+		memset(desc, 0, max_desc * sizeof(*desc));
+
+		/* IC to close the coal frame before HPS Clear */
+		if (coal_ep != -1) {
+			i = coal_ep;
+			reg_write_coal_close.skip_pipeline_clear = false;
+			reg_write_coal_close.pipeline_clear_options =
+				IPAHAL_HPS_CLEAR;
+			reg_write_coal_close.offset = ipahal_get_reg_ofst(
+				IPA_AGGR_FORCE_CLOSE);
+			ipahal_get_aggr_force_close_valmask(i, &valmask);
+			reg_write_coal_close.value = valmask.val;
+			reg_write_coal_close.value_mask = valmask.mask;
+			cmd_pyld[num_cmd] = ipahal_construct_imm_cmd(
+				IPA_IMM_CMD_REGISTER_WRITE,
+				&reg_write_coal_close, false);
+			if (!cmd_pyld[num_cmd]) {
+				IPAERR("failed to construct coal close IC\n");
+				result = -ENOMEM;
+				goto destroy_imm_cmd;
+			}
+			ipa3_init_imm_cmd_desc(&desc[num_cmd],
+				cmd_pyld[num_cmd]);
+			++num_cmd;
+		}
 
+		/*
+		 * NO-OP IC for ensuring that IPA pipeline is empty
+		 */
 		cmd_pyld[num_cmd] =
-			ipahal_construct_imm_cmd(cmd_name, &cmd, false);
+			ipahal_construct_nop_imm_cmd(false, IPAHAL_HPS_CLEAR,
+				false);
 
 		if (!cmd_pyld[num_cmd]) {
-			IPAERR_RL("Fail to construct table_dma imm cmd\n");
+			IPAERR("Failed to construct NOP imm cmd\n");
 			result = -ENOMEM;
 			goto destroy_imm_cmd;
 		}
@@ -1994,17 +2021,49 @@ int ipa3_table_dma_cmd(
 		ipa3_init_imm_cmd_desc(&desc[num_cmd], cmd_pyld[num_cmd]);
 
 		++num_cmd;
-	}
 
-	result = ipa3_send_cmd(num_cmd, desc);
+		for (cnt = start; cnt < end; ++cnt) {
 
-	if (result)
-		IPAERR("Fail to send table_dma immediate command\n");
+			cmd.table_index = dma->dma[cnt].table_index;
+			cmd.base_addr   = dma->dma[cnt].base_addr;
+			cmd.offset      = dma->dma[cnt].offset;
+			cmd.data        = dma->dma[cnt].data;
+
+			cmd_pyld[num_cmd] =
+				ipahal_construct_imm_cmd(cmd_name, &cmd, false);
+
+			if (!cmd_pyld[num_cmd]) {
+				IPAERR_RL("Fail to construct table_dma imm cmd\n");
+				result = -ENOMEM;
+				goto destroy_imm_cmd;
+			}
+
+			ipa3_init_imm_cmd_desc(&desc[num_cmd],
+				cmd_pyld[num_cmd]);
+
+			++num_cmd;
+		}
+
+		result = ipa3_send_cmd(num_cmd, desc);
+
+		if (result) {
+			IPAERR("Fail to send table_dma immediate command\n");
+			goto destroy_imm_cmd;
+		}
+
+		for (cnt = 0; cnt < num_cmd; ++cnt)
+			ipahal_destroy_imm_cmd(cmd_pyld[cnt]);
+	}
+	num_cmd = 0;
 
 destroy_imm_cmd:
 	for (cnt = 0; cnt < num_cmd; ++cnt)
 		ipahal_destroy_imm_cmd(cmd_pyld[cnt]);
 
+free_mem:
+	kfree(cmd_pyld);
+	kfree(desc);
+
 bail:
 	IPADBG("Out\n");
 
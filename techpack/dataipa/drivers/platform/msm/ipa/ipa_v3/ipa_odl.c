@@ -9,6 +9,8 @@
 #include <linux/msm_ipa.h>
 #include <linux/sched/signal.h>
 #include <linux/poll.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
 
 struct ipa_odl_context *ipa3_odl_ctx;
 
@@ -223,13 +225,80 @@ static void delete_first_node(void)
 	}
 }
 
+/*
+ * ipa3_odl_ring_push() - copy one packet into the mmap ring
+ *
+ * Only the cons index is taken from the shared page, and it is
+ * validated against the kernel copy of prod before it is used.
+ * Must be called with adpl_msg_lock held.
+ */
+static int ipa3_odl_ring_push(struct ipa3_odl_ring *ring,
+	const void *buff, u32 len)
+{
+	struct ipa_odl_ring_rec *rec;
+	u32 cons, used, off, tail, need, total;
+
+	cons = smp_load_acquire(&ring->hdr->cons);
+	used = ring->prod - cons;
+	need = ALIGN(sizeof(*rec) + len, sizeof(*rec));
+	off = ring->prod & (ring->size - 1);
+	tail = ring->size - off;
+	total = tail < need ? tail + need : need;
+
+	if (used > ring->size || total > ring->size - used) {
+		ring->hdr->drops++;
+		return -ENOSPC;
+	}
+
+	if (tail < need) {
+		rec = ring->data + off;
+		rec->len = 0;
+		rec->flags = IPA_ODL_RING_REC_PAD;
+		ring->prod += tail;
+		off = 0;
+	}
+
+	rec = ring->data + off;
+	rec->len = len;
+	rec->flags = 0;
+	memcpy(rec + 1, buff, len);
+	ring->prod += need;
+
+	/* publish the record only once it is fully written */
+	smp_store_release(&ring->hdr->prod, ring->prod);
+	return 0;
+}
+
+static bool ipa3_odl_ring_empty(void)
+{
+	struct ipa3_odl_ring *ring = &ipa3_odl_ctx->ring;
+
+	return READ_ONCE(ring->hdr->cons) == ring->prod;
+}
+
 int ipa3_send_adpl_msg(unsigned long skb_data)
 {
 	struct ipa3_push_msg_odl *msg;
 	struct sk_buff *skb = (struct sk_buff *)skb_data;
 	void *data;
+	int ret;
 
 	IPADBG_LOW("Processing DPL data\n");
+	mutex_lock(&ipa3_odl_ctx->adpl_msg_lock);
+	if (ipa3_odl_ctx->ring.hdr) {
+		ret = ipa3_odl_ring_push(&ipa3_odl_ctx->ring, skb->data,
+			skb->len);
+		mutex_unlock(&ipa3_odl_ctx->adpl_msg_lock);
+		if (ret) {
+			ipa3_odl_ctx->stats.odl_drop_pkt++;
+			return ret;
+		}
+		wake_up(&ipa3_odl_ctx->adpl_msg_waitq);
+		IPA_STATS_INC_CNT(ipa3_odl_ctx->stats.odl_rx_pkt);
+		return 0;
+	}
+	mutex_unlock(&ipa3_odl_ctx->adpl_msg_lock);
+
 	msg = kzalloc(sizeof(struct ipa3_push_msg_odl), GFP_KERNEL);
 	if (msg == NULL) {
 		IPADBG("Memory allocation failed\n");
@@ -446,6 +515,13 @@ static int ipa_adpl_open(struct inode *inode, struct file *filp)
 static int ipa_adpl_release(struct inode *inode, struct file *filp)
 {
 	int ret = 0;
+
+	/* the file holds no mapping any more, the ring can go away */
+	mutex_lock(&ipa3_odl_ctx->adpl_msg_lock);
+	vfree(ipa3_odl_ctx->ring.hdr);
+	memset(&ipa3_odl_ctx->ring, 0, sizeof(ipa3_odl_ctx->ring));
+	mutex_unlock(&ipa3_odl_ctx->adpl_msg_lock);
+
 	/* Deactivate ipa_pm */
 	mutex_lock(&ipa3_odl_ctx->pipe_lock);
 	ret = ipa_pm_deactivate_sync(ipa3_odl_ctx->odl_pm_hdl);
@@ -608,6 +684,74 @@ static ssize_t ipa_adpl_read(struct file *filp, char __user *buf, size_t count,
 	return ret;
 }
 
+/**
+ * ipa_adpl_mmap() - map the ADPL ring into the reader
+ * @filp:	[in] file pointer
+ * @vma:	[in] one control page followed by a power of 2 data area
+ *
+ * The first mapping allocates the ring and moves packet delivery from
+ * read() to the ring. Later mappings must use the same size.
+ *
+ * Returns:	0 on success, negative on failure
+ */
+static int ipa_adpl_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct ipa3_odl_ring *ring = &ipa3_odl_ctx->ring;
+	unsigned long len = vma->vm_end - vma->vm_start;
+	unsigned long size = len - PAGE_SIZE;
+	void *buf;
+	int ret;
+
+	if (vma->vm_pgoff || len <= PAGE_SIZE || !is_power_of_2(size) ||
+		size > IPA_ODL_RING_MAX_SIZE) {
+		IPAERR("invalid ring mapping size %lu\n", len);
+		return -EINVAL;
+	}
+
+	mutex_lock(&ipa3_odl_ctx->adpl_msg_lock);
+	if (ring->hdr && ring->size != size) {
+		ret = -EBUSY;
+		goto bail;
+	}
+
+	if (!ring->hdr) {
+		buf = vmalloc_user(len);
+		if (!buf) {
+			ret = -ENOMEM;
+			goto bail;
+		}
+		ring->hdr = buf;
+		ring->data = buf + PAGE_SIZE;
+		ring->size = size;
+		ring->prod = 0;
+		ring->hdr->size = size;
+		ring->hdr->data_offset = PAGE_SIZE;
+	}
+
+	ret = remap_vmalloc_range(vma, ring->hdr, 0);
+bail:
+	mutex_unlock(&ipa3_odl_ctx->adpl_msg_lock);
+	return ret;
+}
+
+static unsigned int ipa_adpl_poll(struct file *filp, poll_table *wait)
+{
+	unsigned int mask = 0;
+
+	poll_wait(filp, &ipa3_odl_ctx->adpl_msg_waitq, wait);
+
+	mutex_lock(&ipa3_odl_ctx->adpl_msg_lock);
+	if (ipa3_odl_ctx->ring.hdr) {
+		if (!ipa3_odl_ring_empty())
+			mask |= POLLIN | POLLRDNORM;
+	} else if (!list_empty(&ipa3_odl_ctx->adpl_msg_list)) {
+		mask |= POLLIN | POLLRDNORM;
+	}
+	mutex_unlock(&ipa3_odl_ctx->adpl_msg_lock);
+
+	return mask;
+}
+
 static long ipa_adpl_ioctl(struct file *filp,
 	unsigned int cmd, unsigned long arg)
 {
@@ -660,6 +804,8 @@ static const struct file_operations ipa_adpl_fops = {
 	.release = ipa_adpl_release,
 	.read = ipa_adpl_read,
 	.unlocked_ioctl = ipa_adpl_ioctl,
+	.mmap = ipa_adpl_mmap,
+	.poll = ipa_adpl_poll,
 };
 
 int ipa_odl_init(void)
@@ -12,6 +12,7 @@
 #define CONFIG_SUCCESS 1
 #define ODL_EP_TYPE_HSUSB 2
 #define ODL_EP_PERIPHERAL_IFACE_ID 3
+#define IPA_ODL_RING_MAX_SIZE (4 * 1024 * 1024)
 
 struct ipa3_odlstats {
 	u32 odl_rx_pkt;
@@ -47,6 +48,20 @@ struct ipa3_odl_char_device_context {
 	struct cdev cdev;
 };
 
+/**
+ * struct ipa3_odl_ring - mmap ring used instead of the message list
+ * @hdr: control page shared with the reader
+ * @data: data area shared with the reader
+ * @size: kernel copy of the data area size
+ * @prod: kernel copy of the producer index
+ */
+struct ipa3_odl_ring {
+	struct ipa_odl_ring_hdr *hdr;
+	void *data;
+	u32 size;
+	u32 prod;
+};
+
 struct ipa_odl_context {
 	struct ipa3_odl_char_device_context odl_cdev[2];
 	struct list_head adpl_msg_list;
@@ -59,6 +74,7 @@ struct ipa_odl_context {
 	struct ipa3_odlstats stats;
 	u32 odl_pm_hdl;
 	wait_queue_head_t adpl_msg_waitq;
+	struct ipa3_odl_ring ring;
 };
 
 struct ipa3_push_msg_odl {
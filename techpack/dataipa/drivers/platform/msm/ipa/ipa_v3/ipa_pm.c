@@ -6,6 +6,7 @@
 #include <linux/debugfs.h>
 #include "ipa_pm.h"
 #include "ipa_i.h"
+#include "ipa_trace.h"
 
 
 #define IPA_PM_DRV_NAME "ipa_pm"
@@ -49,6 +50,10 @@
 		client_state_to_str[state])
 
 
+/* measured-load scaling: sample period and EWMA weight (1/4) */
+#define IPA_PM_PRED_SAMPLE_MS 20
+#define IPA_PM_PRED_EWMA_SHIFT 2
+
 #if IPA_PM_MAX_CLIENTS > 32
 #error max client greater than 32 all bitmask types should be changed
 #endif
@@ -91,6 +96,28 @@ struct clk_scaling_db {
 	int *current_threshold;
 };
 
+/*
+ * struct ipa_pm_predictor - measured-load clock scaling state
+ * @work: periodic sample of the per-pipe byte counters
+ * @pipe_bytes: bytes seen on each pipe, updated from the data path
+ * @last_bytes: sum of pipe_bytes at the previous sample
+ * @last_ts: time of the previous sample
+ * @last_tput: throughput measured at the previous sample in Mbps
+ * @avg_tput: EWMA of the measured throughput in Mbps
+ * @pred_tput: throughput the clock is currently dimensioned for
+ * @bursts: number of samples that were treated as a traffic burst
+ */
+struct ipa_pm_predictor {
+	struct delayed_work work;
+	atomic64_t pipe_bytes[IPA3_MAX_NUM_PIPES];
+	u64 last_bytes;
+	ktime_t last_ts;
+	int last_tput;
+	int avg_tput;
+	int pred_tput;
+	u32 bursts;
+};
+
 /*
  * ipa_pm state names
  *
@@ -170,6 +197,7 @@ struct ipa_pm_client {
  * @client_mutex: global mutex to  lock the client arrays
  * @aggragated_tput: aggragated tput value of all valid activated clients
  * @group_tput: combined throughput for the groups
+ * @pred: measured-load predictor used on top of the client votes
  */
 struct ipa_pm_ctx {
 	struct ipa_pm_client *clients[IPA_PM_MAX_CLIENTS];
@@ -179,6 +207,7 @@ struct ipa_pm_ctx {
 	struct mutex client_mutex;
 	int aggregated_tput;
 	int group_tput[IPA_PM_GROUP_MAX];
+	struct ipa_pm_predictor pred;
 };
 
 static struct ipa_pm_ctx *ipa_pm_ctx;
@@ -350,9 +379,12 @@ static void set_current_threshold(void)
  */
 static int do_clk_scaling(void)
 {
-	int i, tput;
-	int new_th_idx = 1;
+	int i, tput, voted_tput;
+	int new_th_idx = 1, old_th_idx;
 	struct clk_scaling_db *clk_scaling;
+	struct ipa_pm_predictor *pred = &ipa_pm_ctx->pred;
+	ktime_t start;
+	s64 latency_us = 0;
 
 	if (atomic_read(&ipa3_ctx->ipa_clk_vote) == 0) {
 		IPA_PM_DBG("IPA clock is gated\n");
@@ -363,30 +395,106 @@ static int do_clk_scaling(void)
 
 	mutex_lock(&ipa_pm_ctx->client_mutex);
 	IPA_PM_DBG_LOW("clock scaling started\n");
-	tput = calculate_throughput();
-	ipa_pm_ctx->aggregated_tput = tput;
+	voted_tput = calculate_throughput();
+	ipa_pm_ctx->aggregated_tput = voted_tput;
 	set_current_threshold();
 
 	mutex_unlock(&ipa_pm_ctx->client_mutex);
 
+	tput = voted_tput;
+	if (ipa3_ctx->ipa_pm_predictive_scaling) {
+		tput = max(tput, pred->pred_tput);
+		queue_delayed_work(ipa_pm_ctx->wq, &pred->work,
+			msecs_to_jiffies(IPA_PM_PRED_SAMPLE_MS));
+	}
+
 	for (i = 0; i < clk_scaling->threshold_size; i++) {
 		if (tput >= clk_scaling->current_threshold[i])
 			new_th_idx++;
 	}
 
-	IPA_PM_DBG_LOW("old idx was at %d\n", ipa_pm_ctx->clk_scaling.cur_vote);
+	old_th_idx = ipa_pm_ctx->clk_scaling.cur_vote;
+	IPA_PM_DBG_LOW("old idx was at %d\n", old_th_idx);
 
 
 	if (ipa_pm_ctx->clk_scaling.cur_vote != new_th_idx) {
+		start = ktime_get();
 		ipa_pm_ctx->clk_scaling.cur_vote = new_th_idx;
 		ipa3_set_clock_plan_from_pm(ipa_pm_ctx->clk_scaling.cur_vote);
+		latency_us = ktime_us_delta(ktime_get(), start);
 	}
 
+	trace_ipa_pm_clk_scaling(voted_tput, pred->last_tput, pred->pred_tput,
+		old_th_idx, new_th_idx, latency_us);
+
 	IPA_PM_DBG_LOW("new idx is at %d\n", ipa_pm_ctx->clk_scaling.cur_vote);
 
 	return 0;
 }
 
+/**
+ * ipa_pm_pred_sample_func() - measure the pipe throughput and rescale
+ *
+ * The predicted throughput follows the EWMA of the measured rate. A sample
+ * that more than doubles the previous one is taken as the start of a burst
+ * and is extrapolated one period ahead, so the clock is raised before the
+ * client votes catch up. Scaling down follows the slower EWMA.
+ */
+static void ipa_pm_pred_sample_func(struct work_struct *work)
+{
+	struct ipa_pm_predictor *pred = &ipa_pm_ctx->pred;
+	ktime_t now = ktime_get();
+	u64 bytes = 0;
+	s64 elapsed_us;
+	int i, tput;
+
+	for (i = 0; i < IPA3_MAX_NUM_PIPES; i++)
+		bytes += atomic64_read(&pred->pipe_bytes[i]);
+
+	elapsed_us = ktime_us_delta(now, pred->last_ts);
+	pred->last_ts = now;
+	if (elapsed_us <= 0 ||
+		elapsed_us > 4 * IPA_PM_PRED_SAMPLE_MS * USEC_PER_MSEC) {
+		/* first sample after clock gating, restart from scratch */
+		pred->last_bytes = bytes;
+		pred->last_tput = 0;
+		pred->avg_tput = 0;
+		pred->pred_tput = 0;
+		goto scale;
+	}
+
+	/* bits per usec is Mbps */
+	tput = div64_s64((bytes - pred->last_bytes) * 8, elapsed_us);
+	pred->last_bytes = bytes;
+
+	pred->avg_tput += (tput - pred->avg_tput) /
+		(1 << IPA_PM_PRED_EWMA_SHIFT);
+	if (tput > 2 * pred->last_tput && tput > pred->avg_tput) {
+		pred->pred_tput = tput + (tput - pred->last_tput);
+		pred->bursts++;
+	} else {
+		pred->pred_tput = max(tput, pred->avg_tput);
+	}
+	pred->last_tput = tput;
+
+scale:
+	do_clk_scaling();
+}
+
+/**
+ * ipa_pm_account_bytes() - feed data path byte counts to the predictor
+ * @ep_idx: pipe the bytes were moved on
+ * @bytes: number of bytes
+ */
+void ipa_pm_account_bytes(int ep_idx, u32 bytes)
+{
+	if (!ipa3_ctx->ipa_pm_predictive_scaling || unlikely(!ipa_pm_ctx) ||
+		ep_idx < 0 || ep_idx >= IPA3_MAX_NUM_PIPES)
+		return;
+
+	atomic64_add(bytes, &ipa_pm_ctx->pred.pipe_bytes[ep_idx]);
+}
+
 /**
  * clock_scaling_func() - set the clock on a work queue
  */
@@ -653,6 +761,7 @@ int ipa_pm_init(struct ipa_pm_init_params *params)
 	clk_scaling->threshold_size = params->threshold_size;
 	clk_scaling->exception_size = params->exception_size;
 	INIT_WORK(&clk_scaling->work, clock_scaling_func);
+	INIT_DELAYED_WORK(&ipa_pm_ctx->pred.work, ipa_pm_pred_sample_func);
 
 	for (i = 0; i < params->threshold_size; i++)
 		clk_scaling->default_threshold[i] =
@@ -697,6 +806,7 @@ int ipa_pm_destroy(void)
 		return -EPERM;
 	}
 
+	cancel_delayed_work_sync(&ipa_pm_ctx->pred.work);
 	destroy_workqueue(ipa_pm_ctx->wq);
 
 	kfree(ipa_pm_ctx);
@@ -1362,6 +1472,14 @@ int ipa_pm_stat(char *buf, int size)
 		ipa_pm_ctx->aggregated_tput, clk->cur_vote);
 	cnt += result;
 
+	if (ipa3_ctx->ipa_pm_predictive_scaling) {
+		result = scnprintf(buf + cnt, size - cnt,
+			"\nMeasured tput: %d, Avg tput: %d, Predicted tput: %d, Bursts: %u",
+			ipa_pm_ctx->pred.last_tput, ipa_pm_ctx->pred.avg_tput,
+			ipa_pm_ctx->pred.pred_tput, ipa_pm_ctx->pred.bursts);
+		cnt += result;
+	}
+
 	result = scnprintf(buf + cnt, size - cnt, "\n\nRegistered Clients:\n");
 	cnt += result;
 
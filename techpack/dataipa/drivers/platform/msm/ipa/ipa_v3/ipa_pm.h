@@ -101,6 +101,7 @@ int ipa_pm_deactivate_all_deferred(void);
 int ipa_pm_stat(char *buf, int size);
 int ipa_pm_exceptions_stat(char *buf, int size);
 void ipa_pm_set_clock_index(int index);
+void ipa_pm_account_bytes(int ep_idx, u32 bytes);
 
 #else /* IS_ENABLED(CONFIG_IPA3) */
 
@@ -176,6 +177,10 @@ static inline int ipa_pm_exceptions_stat(char *buf, int size)
 {
 	return -EPERM;
 }
+
+static inline void ipa_pm_account_bytes(int ep_idx, u32 bytes)
+{
+}
 #endif /* IS_ENABLED(CONFIG_IPA3) */
 
 #endif /* _IPA_PM_H_ */
@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#include <linux/perf_event.h>
+#include "gsi.h"
+#include "ipa_i.h"
+
+#define IPA_PMU_NAME "ipa_gsi"
+
+/*
+ * perf config layout:
+ * config:0-7	event, see enum ipa_pmu_event
+ * config:8-15	GSI channel for the per channel and HOLB events
+ */
+#define IPA_PMU_EVENT(config) ((config) & 0xff)
+#define IPA_PMU_CHAN(config) (((config) >> 8) & 0xff)
+
+enum ipa_pmu_event {
+	IPA_PMU_GSI_BP_CYCLES = 0x00,
+	IPA_PMU_GSI_BP_PENDING_CYCLES = 0x01,
+	IPA_PMU_GSI_MCS_BUSY_CYCLES = 0x02,
+	IPA_PMU_GSI_MCS_IDLE_CYCLES = 0x03,
+	IPA_PMU_CHAN_QUEUED = 0x10,
+	IPA_PMU_CHAN_COMPLETED = 0x11,
+	IPA_PMU_CHAN_POLL_EMPTY = 0x12,
+	IPA_PMU_HOLB_ENABLE = 0x20,
+	IPA_PMU_HOLB_DISABLE = 0x21,
+};
+
+/*
+ * struct ipa_pmu_ctx - IPA/GSI perf PMU
+ * @pmu: registered perf PMU
+ * @lock: protects @prof
+ * @prof: last GSI profiling counters read while IPA was clocked
+ * @registered: PMU was registered with perf
+ */
+struct ipa_pmu_ctx {
+	struct pmu pmu;
+	spinlock_t lock;
+	struct gsi_hw_profiling_data prof;
+	bool registered;
+};
+
+static struct ipa_pmu_ctx ipa_pmu_ctx;
+
+static u64 ipa_pmu_read_gsi_prof(u8 evt)
+{
+	struct gsi_hw_profiling_data stats;
+	unsigned long flags;
+	u64 val;
+
+	IPA_ACTIVE_CLIENTS_PREP_SIMPLE(log_info);
+
+	spin_lock_irqsave(&ipa_pmu_ctx.lock, flags);
+	/*
+	 * perf reads from atomic context, so never wake IPA up here; the
+	 * profiling counters cannot move while IPA is clocked off.
+	 */
+	if (!ipa3_inc_client_enable_clks_no_block(&log_info)) {
+		if (!gsi_get_hw_profiling_stats(&stats))
+			ipa_pmu_ctx.prof = stats;
+		ipa3_dec_client_disable_clks_no_block(&log_info);
+	}
+
+	switch (evt) {
+	case IPA_PMU_GSI_BP_CYCLES:
+		val = ipa_pmu_ctx.prof.bp_cnt;
+		break;
+	case IPA_PMU_GSI_BP_PENDING_CYCLES:
+		val = ipa_pmu_ctx.prof.bp_and_pending_cnt;
+		break;
+	case IPA_PMU_GSI_MCS_BUSY_CYCLES:
+		val = ipa_pmu_ctx.prof.mcs_busy_cnt;
+		break;
+	default:
+		val = ipa_pmu_ctx.prof.mcs_idle_cnt;
+		break;
+	}
+	spin_unlock_irqrestore(&ipa_pmu_ctx.lock, flags);
+
+	return val;
+}
+
+static u64 ipa_pmu_read_counter(u64 config)
+{
+	struct gsi_chan_stats stats;
+	u32 enable_cnt, disable_cnt;
+	u8 evt = IPA_PMU_EVENT(config);
+	u8 chan = IPA_PMU_CHAN(config);
+
+	switch (evt) {
+	case IPA_PMU_GSI_BP_CYCLES:
+	case IPA_PMU_GSI_BP_PENDING_CYCLES:
+	case IPA_PMU_GSI_MCS_BUSY_CYCLES:
+	case IPA_PMU_GSI_MCS_IDLE_CYCLES:
+		return ipa_pmu_read_gsi_prof(evt);
+	case IPA_PMU_CHAN_QUEUED:
+	case IPA_PMU_CHAN_COMPLETED:
+	case IPA_PMU_CHAN_POLL_EMPTY:
+		if (gsi_get_chan_stats(chan, &stats))
+			return 0;
+		if (evt == IPA_PMU_CHAN_QUEUED)
+			return stats.queued;
+		if (evt == IPA_PMU_CHAN_COMPLETED)
+			return stats.completed;
+		return stats.poll_empty;
+	case IPA_PMU_HOLB_ENABLE:
+	case IPA_PMU_HOLB_DISABLE:
+		if (ipa3_uc_holb_get_event_cnt(chan, &enable_cnt,
+			&disable_cnt))
+			return 0;
+		return evt == IPA_PMU_HOLB_ENABLE ? enable_cnt : disable_cnt;
+	default:
+		return 0;
+	}
+}
+
+static void ipa_pmu_event_update(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	now = ipa_pmu_read_counter(event->attr.config);
+	prev = local64_xchg(&hwc->prev_count, now);
+	local64_add(now - prev, &event->count);
+}
+
+static int ipa_pmu_event_init(struct perf_event *event)
+{
+	u8 evt = IPA_PMU_EVENT(event->attr.config);
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* free running counters without overflow interrupt */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EOPNOTSUPP;
+
+	switch (evt) {
+	case IPA_PMU_GSI_BP_CYCLES:
+	case IPA_PMU_GSI_BP_PENDING_CYCLES:
+	case IPA_PMU_GSI_MCS_BUSY_CYCLES:
+	case IPA_PMU_GSI_MCS_IDLE_CYCLES:
+	case IPA_PMU_CHAN_QUEUED:
+	case IPA_PMU_CHAN_COMPLETED:
+	case IPA_PMU_CHAN_POLL_EMPTY:
+	case IPA_PMU_HOLB_ENABLE:
+	case IPA_PMU_HOLB_DISABLE:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	/* all counters are device wide, count them on one cpu only */
+	event->cpu = cpumask_first(cpu_online_mask);
+
+	return 0;
+}
+
+static void ipa_pmu_event_start(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count,
+		ipa_pmu_read_counter(event->attr.config));
+	hwc->state = 0;
+}
+
+static void ipa_pmu_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	ipa_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int ipa_pmu_event_add(struct perf_event *event, int flags)
+{
+	event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		ipa_pmu_event_start(event, flags);
+
+	return 0;
+}
+
+static void ipa_pmu_event_del(struct perf_event *event, int flags)
+{
+	ipa_pmu_event_stop(event, PERF_EF_UPDATE);
+}
+
+static void ipa_pmu_event_read(struct perf_event *event)
+{
+	ipa_pmu_event_update(event);
+}
+
+PMU_FORMAT_ATTR(event, "config:0-7");
+PMU_FORMAT_ATTR(chan, "config:8-15");
+
+static struct attribute *ipa_pmu_format_attrs[] = {
+	&format_attr_event.attr,
+	&format_attr_chan.attr,
+	NULL,
+};
+
+static const struct attribute_group ipa_pmu_format_group = {
+	.name = "format",
+	.attrs = ipa_pmu_format_attrs,
+};
+
+PMU_EVENT_ATTR_STRING(gsi_bp_cycles, ipa_pmu_evt_bp, "event=0x00");
+PMU_EVENT_ATTR_STRING(gsi_bp_pending_cycles, ipa_pmu_evt_bp_pending,
+	"event=0x01");
+PMU_EVENT_ATTR_STRING(gsi_mcs_busy_cycles, ipa_pmu_evt_mcs_busy,
+	"event=0x02");
+PMU_EVENT_ATTR_STRING(gsi_mcs_idle_cycles, ipa_pmu_evt_mcs_idle,
+	"event=0x03");
+PMU_EVENT_ATTR_STRING(chan_queued, ipa_pmu_evt_queued, "event=0x10,chan=?");
+PMU_EVENT_ATTR_STRING(chan_completed, ipa_pmu_evt_completed,
+	"event=0x11,chan=?");
+PMU_EVENT_ATTR_STRING(chan_poll_empty, ipa_pmu_evt_poll_empty,
+	"event=0x12,chan=?");
+PMU_EVENT_ATTR_STRING(holb_enable, ipa_pmu_evt_holb_en, "event=0x20,chan=?");
+PMU_EVENT_ATTR_STRING(holb_disable, ipa_pmu_evt_holb_dis,
+	"event=0x21,chan=?");
+
+static struct attribute *ipa_pmu_event_attrs[] = {
+	&ipa_pmu_evt_bp.attr.attr,
+	&ipa_pmu_evt_bp_pending.attr.attr,
+	&ipa_pmu_evt_mcs_busy.attr.attr,
+	&ipa_pmu_evt_mcs_idle.attr.attr,
+	&ipa_pmu_evt_queued.attr.attr,
+	&ipa_pmu_evt_completed.attr.attr,
+	&ipa_pmu_evt_poll_empty.attr.attr,
+	&ipa_pmu_evt_holb_en.attr.attr,
+	&ipa_pmu_evt_holb_dis.attr.attr,
+	NULL,
+};
+
+static const struct attribute_group ipa_pmu_event_group = {
+	.name = "events",
+	.attrs = ipa_pmu_event_attrs,
+};
+
+static ssize_t cpumask_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	return cpumap_print_to_pagebuf(true, buf,
+		cpumask_of(cpumask_first(cpu_online_mask)));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *ipa_pmu_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL,
+};
+
+static const struct attribute_group ipa_pmu_cpumask_group = {
+	.attrs = ipa_pmu_cpumask_attrs,
+};
+
+static const struct attribute_group *ipa_pmu_attr_groups[] = {
+	&ipa_pmu_format_group,
+	&ipa_pmu_event_group,
+	&ipa_pmu_cpumask_group,
+	NULL,
+};
+
+/**
+ * ipa3_pmu_init() - register the IPA/GSI counters as a perf PMU
+ *
+ * Return value: 0 on success, negative value otherwise
+ */
+int ipa3_pmu_init(void)
+{
+	int ret;
+
+	if (ipa_pmu_ctx.registered)
+		return 0;
+
+	spin_lock_init(&ipa_pmu_ctx.lock);
+	ipa_pmu_ctx.pmu = (struct pmu) {
+		.module = THIS_MODULE,
+		.task_ctx_nr = perf_invalid_context,
+		.capabilities = PERF_PMU_CAP_NO_EXCLUDE,
+		.attr_groups = ipa_pmu_attr_groups,
+		.event_init = ipa_pmu_event_init,
+		.add = ipa_pmu_event_add,
+		.del = ipa_pmu_event_del,
+		.start = ipa_pmu_event_start,
+		.stop = ipa_pmu_event_stop,
+		.read = ipa_pmu_event_read,
+	};
+
+	ret = perf_pmu_register(&ipa_pmu_ctx.pmu, IPA_PMU_NAME, -1);
+	if (ret) {
+		IPAERR("failed to register %s PMU %d\n", IPA_PMU_NAME, ret);
+		return ret;
+	}
+
+	ipa_pmu_ctx.registered = true;
+	return 0;
+}
+
+/**
+ * ipa3_pmu_destroy() - unregister the IPA/GSI perf PMU
+ */
+void ipa3_pmu_destroy(void)
+{
+	if (!ipa_pmu_ctx.registered)
+		return;
+
+	perf_pmu_unregister(&ipa_pmu_ctx.pmu);
+	ipa_pmu_ctx.registered = false;
+}
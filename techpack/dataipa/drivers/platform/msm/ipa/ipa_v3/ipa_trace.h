@@ -379,6 +379,39 @@ TRACE_EVENT(
 
 	TP_printk("client=%lu", __entry->client)
 );
+
+TRACE_EVENT(
+	ipa_pm_clk_scaling,
+
+	TP_PROTO(int voted_tput, int measured_tput, int pred_tput,
+		int old_idx, int new_idx, s64 latency_us),
+
+	TP_ARGS(voted_tput, measured_tput, pred_tput, old_idx, new_idx,
+		latency_us),
+
+	TP_STRUCT__entry(
+		__field(int,	voted_tput)
+		__field(int,	measured_tput)
+		__field(int,	pred_tput)
+		__field(int,	old_idx)
+		__field(int,	new_idx)
+		__field(s64,	latency_us)
+	),
+
+	TP_fast_assign(
+		__entry->voted_tput = voted_tput;
+		__entry->measured_tput = measured_tput;
+		__entry->pred_tput = pred_tput;
+		__entry->old_idx = old_idx;
+		__entry->new_idx = new_idx;
+		__entry->latency_us = latency_us;
+	),
+
+	TP_printk("voted=%d measured=%d pred=%d idx=%d->%d latency_us=%lld",
+		__entry->voted_tput, __entry->measured_tput,
+		__entry->pred_tput, __entry->old_idx, __entry->new_idx,
+		__entry->latency_us)
+);
 #endif /* _IPA_TRACE_H */
 
 /* This part must be outside protection */
@@ -244,3 +244,23 @@ void ipa3_uc_holb_event_log(uint16_t gsi_ch, bool enable,
 	holb_client->current_idx = (holb_client->current_idx + 1) %
 		IPA_HOLB_EVENT_LOG_MAX;
 }
+
+int ipa3_uc_holb_get_event_cnt(uint16_t gsi_ch, uint32_t *enable_cnt,
+	uint32_t *disable_cnt)
+{
+	struct ipa_uc_holb_client_info *holb_client;
+	int client_idx;
+
+	if (!ipa3_ctx->uc_ctx.ipa_use_uc_holb_monitor)
+		return -EPERM;
+
+	/* lockless for the same reason as ipa3_uc_holb_event_log() */
+	client_idx = ipa3_get_holb_client_idx_by_ch(gsi_ch);
+	if (client_idx == -EINVAL)
+		return -EINVAL;
+
+	holb_client = &(ipa3_ctx->uc_ctx.holb_monitor.client[client_idx]);
+	*enable_cnt = READ_ONCE(holb_client->enable_cnt);
+	*disable_cnt = READ_ONCE(holb_client->disable_cnt);
+	return 0;
+}
@@ -138,4 +138,16 @@ void ipa3_set_holb_client_by_ch(struct ipa_uc_holb_client_info client);
 void ipa3_uc_holb_event_log(uint16_t gsi_ch, bool enable,
 	uint32_t qtimer_lsb, uint32_t qtimer_msb);
 
+/**
+ * ipa3_uc_holb_get_event_cnt() - Get the accumulated HOLB event counts
+ * for specific gsi channel
+ * @gsi_ch: GSI Channel of the monitored client
+ * @enable_cnt: [out] number of HOLB enable events
+ * @disable_cnt: [out] number of HOLB disable events
+ *
+ * Return value: 0 on success, negative value otherwise
+ */
+int ipa3_uc_holb_get_event_cnt(uint16_t gsi_ch, uint32_t *enable_cnt,
+	uint32_t *disable_cnt);
+
 #endif /* IPA_UC_HOLB_MONITOR_H */
@@ -3,6 +3,9 @@
  * Copyright (c) 2020, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
 #include <linux/string.h>
 #include <linux/skbuff.h>
 #include <linux/workqueue.h>
@@ -26,6 +29,8 @@ enum ipa_rmnet_ctl_state {
 
 #define IPA_WWAN_CONS_DESC_FIFO_SZ 256
 #define RMNET_CTRL_QUEUE_MAX (2 * IPA_WWAN_CONS_DESC_FIFO_SZ)
+/* upper bound for the low latency RX busy-poll budget */
+#define RMNET_CTL_BUSY_POLL_MAX_US 500
 
 struct ipa3_rmnet_ctl_cb_info {
 	ipa_rmnet_ctl_ready_cb ready_cb;
@@ -46,6 +51,9 @@ struct ipa3_rmnet_ctl_stats {
 	u32 rx_pkt_dropped;
 	u64 tx_byte_dropped;
 	u64 rx_byte_dropped;
+	u32 tx_lat_cnt;
+	u32 tx_lat_max_us;
+	u64 tx_lat_total_us;
 };
 
 struct rmnet_ctl_ipa3_context {
@@ -62,6 +70,8 @@ struct rmnet_ctl_ipa3_context {
 	u32 rmnet_ctl_pm_hdl;
 	struct mutex lock;
 	struct workqueue_struct *wq;
+	u32 busy_poll_us;
+	bool lat_session;
 };
 
 static struct rmnet_ctl_ipa3_context *rmnet_ctl_ipa3_ctx;
@@ -76,6 +86,14 @@ static void apps_rmnet_ctl_receive_notify(void *priv,
 static int ipa3_rmnet_ctl_register_pm_client(void);
 static void ipa3_rmnet_ctl_deregister_pm_client(void);
 
+/* a latency session keeps its PM vote until the session ends */
+static void rmnet_ctl_pm_deferred_deactivate(void)
+{
+	if (READ_ONCE(rmnet_ctl_ipa3_ctx->lat_session))
+		return;
+	ipa_pm_deferred_deactivate(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
+}
+
 int ipa3_rmnet_ctl_init(void)
 {
 	char buff[IPA_RESOURCE_NAME_MAX];
@@ -434,6 +452,7 @@ int ipa3_rmnet_ctl_xmit(struct sk_buff *skb)
 	}
 
 	/* if queue is not empty, means we still have pending wq */
+	skb->tstamp = ktime_get();
 	if (skb_queue_len(&rmnet_ctl_ipa3_ctx->tx_queue) != 0) {
 		skb_queue_tail(&rmnet_ctl_ipa3_ctx->tx_queue, skb);
 		spin_unlock_irqrestore(&rmnet_ctl_ipa3_ctx->tx_lock,
@@ -502,7 +521,7 @@ int ipa3_rmnet_ctl_xmit(struct sk_buff *skb)
 	if (atomic_read(
 		&rmnet_ctl_ipa3_ctx->stats.outstanding_pkts)
 		== 0)
-		ipa_pm_deferred_deactivate(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
+		rmnet_ctl_pm_deferred_deactivate();
 	spin_unlock_irqrestore(&rmnet_ctl_ipa3_ctx->tx_lock, flags);
 	return ret;
 }
@@ -572,11 +591,30 @@ static void rmnet_ctl_wakeup_ipa(struct work_struct *work)
 	if (atomic_read(
 		&rmnet_ctl_ipa3_ctx->stats.outstanding_pkts)
 		== 0) {
-		ipa_pm_deferred_deactivate(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
+		rmnet_ctl_pm_deferred_deactivate();
 	}
 
 }
 
+/* skb->tstamp was set when rmnet_ctl handed the message to IPA */
+static void rmnet_ctl_tx_lat_update(struct sk_buff *skb)
+{
+	struct ipa3_rmnet_ctl_stats *stats = &rmnet_ctl_ipa3_ctx->stats;
+	unsigned long flags;
+	u32 lat_us;
+
+	if (!skb->tstamp)
+		return;
+
+	lat_us = ktime_us_delta(ktime_get(), skb->tstamp);
+	spin_lock_irqsave(&rmnet_ctl_ipa3_ctx->tx_lock, flags);
+	stats->tx_lat_cnt++;
+	stats->tx_lat_total_us += lat_us;
+	if (lat_us > stats->tx_lat_max_us)
+		stats->tx_lat_max_us = lat_us;
+	spin_unlock_irqrestore(&rmnet_ctl_ipa3_ctx->tx_lock, flags);
+}
+
 /**
  * apps_rmnet_ctl_tx_complete_notify() - Rx notify
  *
@@ -606,11 +644,12 @@ static void apps_rmnet_ctl_tx_complete_notify(void *priv,
 		return;
 	}
 
+	rmnet_ctl_tx_lat_update(skb);
 	atomic_dec(&rmnet_ctl_ipa3_ctx->stats.outstanding_pkts);
 
 	if (atomic_read(
 		&rmnet_ctl_ipa3_ctx->stats.outstanding_pkts) == 0)
-		ipa_pm_deferred_deactivate(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
+		rmnet_ctl_pm_deferred_deactivate();
 
 	kfree_skb(skb);
 }
@@ -639,6 +678,8 @@ static void apps_rmnet_ctl_receive_notify(void *priv,
 	len = low_lat_data->len;
 	if (evt == IPA_RECEIVE) {
 		IPADBG_LOW("Rx packet was received");
+		/* let rmnet_ctl measure its own delivery latency */
+		low_lat_data->tstamp = ktime_get();
 		rx_notify_cb_rx_data = (void *)data;
 		if (rmnet_ctl_ipa3_ctx->cb_info.rx_notify_cb) {
 			(*(rmnet_ctl_ipa3_ctx->cb_info.rx_notify_cb))(
@@ -682,7 +723,139 @@ static int ipa3_rmnet_ctl_register_pm_client(void)
 
 static void ipa3_rmnet_ctl_deregister_pm_client(void)
 {
+	rmnet_ctl_ipa3_ctx->lat_session = false;
 	ipa_pm_deactivate_sync(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
 	ipa_pm_deregister(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
 }
 
+/**
+ * ipa3_rmnet_ctl_busy_poll_us() - low latency RX busy-poll budget
+ *
+ * Returns the time the low latency consumer keeps polling an empty
+ * channel before going back to interrupt mode, 0 when disabled.
+ */
+u32 ipa3_rmnet_ctl_busy_poll_us(void)
+{
+	if (!rmnet_ctl_ipa3_ctx)
+		return 0;
+
+	return min_t(u32, READ_ONCE(rmnet_ctl_ipa3_ctx->busy_poll_us),
+		RMNET_CTL_BUSY_POLL_MAX_US);
+}
+
+/**
+ * ipa3_rmnet_ctl_set_lat_session() - hold the IPA PM vote for rmnet_ctl
+ *
+ * @enable: start or stop a latency critical session
+ *
+ * While a session is active the low latency pipes stay clocked, so flow
+ * control messages don't wait for an IPA wakeup on every transmit.
+ */
+int ipa3_rmnet_ctl_set_lat_session(bool enable)
+{
+	int ret = 0;
+
+	if (!rmnet_ctl_ipa3_ctx)
+		return -EAGAIN;
+
+	mutex_lock(&rmnet_ctl_ipa3_ctx->lock);
+	if (rmnet_ctl_ipa3_ctx->state != IPA_RMNET_CTL_REGD &&
+		rmnet_ctl_ipa3_ctx->state != IPA_RMNET_CTL_START) {
+		ret = -EPERM;
+		goto unlock;
+	}
+
+	if (enable == rmnet_ctl_ipa3_ctx->lat_session)
+		goto unlock;
+
+	if (enable) {
+		ret = ipa_pm_activate_sync(rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
+		if (ret) {
+			IPAERR("failed to activate rmnet_ctl PM %d\n", ret);
+			goto unlock;
+		}
+		WRITE_ONCE(rmnet_ctl_ipa3_ctx->lat_session, true);
+	} else {
+		WRITE_ONCE(rmnet_ctl_ipa3_ctx->lat_session, false);
+		if (!atomic_read(&rmnet_ctl_ipa3_ctx->stats.outstanding_pkts))
+			ipa_pm_deferred_deactivate(
+				rmnet_ctl_ipa3_ctx->rmnet_ctl_pm_hdl);
+	}
+	IPADBG("rmnet_ctl latency session %s\n", enable ? "on" : "off");
+
+unlock:
+	mutex_unlock(&rmnet_ctl_ipa3_ctx->lock);
+	return ret;
+}
+
+#ifndef CONFIG_DEBUG_FS
+int ipa3_rmnet_ctl_init_debugfs(struct dentry *parent) { return 0; }
+#else
+static int rmnet_ctl_stats_show(struct seq_file *s, void *unused)
+{
+	struct ipa3_rmnet_ctl_stats *stats = &rmnet_ctl_ipa3_ctx->stats;
+	unsigned long flags;
+	u64 avg;
+
+	spin_lock_irqsave(&rmnet_ctl_ipa3_ctx->tx_lock, flags);
+	avg = stats->tx_lat_cnt ?
+		div_u64(stats->tx_lat_total_us, stats->tx_lat_cnt) : 0;
+	seq_printf(s, "state=%d pipe_state=0x%x lat_session=%d\n",
+		rmnet_ctl_ipa3_ctx->state, rmnet_ctl_ipa3_ctx->pipe_state,
+		rmnet_ctl_ipa3_ctx->lat_session);
+	seq_printf(s, "busy_poll_us=%u\n", ipa3_rmnet_ctl_busy_poll_us());
+	seq_printf(s, "outstanding=%d queued=%u\n",
+		atomic_read(&stats->outstanding_pkts),
+		skb_queue_len(&rmnet_ctl_ipa3_ctx->tx_queue));
+	seq_printf(s, "tx_pkts=%u tx_bytes=%llu tx_drop=%u\n",
+		stats->tx_pkt_sent, stats->tx_byte_sent,
+		stats->tx_pkt_dropped);
+	seq_printf(s, "rx_pkts=%u rx_bytes=%llu rx_drop=%u\n",
+		stats->rx_pkt_rcvd, stats->rx_byte_rcvd,
+		stats->rx_pkt_dropped);
+	seq_printf(s, "tx_lat_us: cnt=%u avg=%llu max=%u\n",
+		stats->tx_lat_cnt, avg, stats->tx_lat_max_us);
+	spin_unlock_irqrestore(&rmnet_ctl_ipa3_ctx->tx_lock, flags);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rmnet_ctl_stats);
+
+static int rmnet_ctl_lat_session_get(void *data, u64 *val)
+{
+	*val = rmnet_ctl_ipa3_ctx->lat_session;
+	return 0;
+}
+
+static int rmnet_ctl_lat_session_set(void *data, u64 val)
+{
+	return ipa3_rmnet_ctl_set_lat_session(!!val);
+}
+DEFINE_DEBUGFS_ATTRIBUTE(rmnet_ctl_lat_session_fops,
+	rmnet_ctl_lat_session_get, rmnet_ctl_lat_session_set, "%llu\n");
+
+int ipa3_rmnet_ctl_init_debugfs(struct dentry *parent)
+{
+	const mode_t read_write_mode = 0664;
+	struct dentry *dent;
+
+	if (!rmnet_ctl_ipa3_ctx)
+		return 0;
+
+	dent = debugfs_create_dir("rmnet_ctl", parent);
+	if (IS_ERR_OR_NULL(dent)) {
+		IPAERR("fail to create folder in debug_fs\n");
+		return -EFAULT;
+	}
+
+	debugfs_create_u32("busy_poll_us", read_write_mode, dent,
+		&rmnet_ctl_ipa3_ctx->busy_poll_us);
+	debugfs_create_file("lat_session", read_write_mode, dent, NULL,
+		&rmnet_ctl_lat_session_fops);
+	debugfs_create_file("stats", 0444, dent, NULL,
+		&rmnet_ctl_stats_fops);
+
+	return 0;
+}
+#endif
+
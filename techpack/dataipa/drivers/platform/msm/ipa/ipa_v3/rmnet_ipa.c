@@ -1181,10 +1181,11 @@ static int ipa3_wwan_change_mtu(struct net_device *dev, int new_mtu)
 }
 
 /**
- * ipa3_wwan_xmit() - Transmits an skb.
+ * __ipa3_wwan_xmit() - Transmits an skb.
  *
  * @skb: skb to be transmitted
  * @dev: network device
+ * @xmit_more: the stack has more packets queued behind this one
  *
  * Return codes:
  * 0: success
@@ -1192,12 +1193,14 @@ static int ipa3_wwan_change_mtu(struct net_device *dev, int new_mtu)
  * later
  * -EFAULT: Error while transmitting the skb
  */
-static netdev_tx_t ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
+static netdev_tx_t __ipa3_wwan_xmit(struct sk_buff *skb,
+	struct net_device *dev, bool xmit_more)
 {
 	int ret = 0;
 	bool qmap_check;
 	struct ipa3_wwan_private *wwan_ptr = netdev_priv(dev);
 	unsigned long flags;
+	struct ipa_tx_meta meta = { .xmit_more = xmit_more };
 
 	if (rmnet_ipa3_ctx->ipa_config_is_apq) {
 		IPAWANERR_RL("IPA embedded data on APQ platform\n");
@@ -1293,7 +1296,7 @@ static netdev_tx_t ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 	 * both data packets and command will be routed to
 	 * IPA_CLIENT_Q6_WAN_CONS based on status configuration
 	 */
-	ret = ipa3_tx_dp(IPA_CLIENT_APPS_WAN_PROD, skb, NULL);
+	ret = ipa3_tx_dp(IPA_CLIENT_APPS_WAN_PROD, skb, &meta);
 	if (ret) {
 		atomic_dec(&wwan_ptr->outstanding_pkts);
 		if (ret == -EPIPE) {
@@ -1319,6 +1322,26 @@ static netdev_tx_t ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
 	return ret;
 }
 
+/**
+ * ipa3_wwan_xmit() - Transmits an skb, batching the GSI doorbell
+ * while the stack signals xmit_more.
+ *
+ * Any exit that does not hand a packet with a prompt doorbell to IPA
+ * flushes what earlier xmit_more packets left pending, so a stopped
+ * queue or a drop never strands descriptors in the ring.
+ */
+static netdev_tx_t ipa3_wwan_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+	bool xmit_more = netdev_xmit_more();
+	netdev_tx_t ret;
+
+	ret = __ipa3_wwan_xmit(skb, dev, xmit_more);
+	if (!xmit_more || ret != NETDEV_TX_OK)
+		ipa3_tx_dp_flush(IPA_CLIENT_APPS_WAN_PROD);
+
+	return ret;
+}
+
 static void ipa3_wwan_tx_timeout(struct net_device *dev)
 {
 	struct ipa3_wwan_private *wwan_ptr = netdev_priv(dev);
@@ -3652,11 +3675,13 @@ static int rmnet_ipa3_query_tethering_stats_hw(
 	struct ipa_quota_stats_all *con_stats;
 	enum ipa_client_type wlan_client;
 
-	/* qet HW-stats */
-	rc = ipa_get_teth_stats();
-	if (rc) {
-		IPAWANDBG("ipa_get_teth_stats failed %d,\n", rc);
-		return rc;
+	/* qet HW-stats, the periodic snapshot keeps the cache fresh */
+	if (!ipa_hw_stats_snap_active()) {
+		rc = ipa_get_teth_stats();
+		if (rc) {
+			IPAWANDBG("ipa_get_teth_stats failed %d,\n", rc);
+			return rc;
+		}
 	}
 
 	/* query DL stats */
@@ -5251,7 +5276,7 @@ static int ipa3_rmnet_poll(struct napi_struct *napi, int budget)
 	int rcvd_pkts = 0;
 
 	rcvd_pkts = ipa3_rx_poll(rmnet_ipa3_ctx->ipa3_to_apps_hdl,
-					NAPI_WEIGHT);
+					budget);
 	IPAWANDBG_LOW("rcvd packets: %d\n", rcvd_pkts);
 	return rcvd_pkts;
 }
@@ -38,6 +38,10 @@
 #define MAX_PANEL_JITTER		10
 #define DEFAULT_PANEL_PREFILL_LINES	25
 #define HIGH_REFRESH_RATE_THRESHOLD_TIME_US	500
+/* size of the controller command dma buffer shared by a command batch */
+#define DSI_PANEL_CMD_BATCH_MAX_BYTES	SZ_4K
+/* larger commands go out in non-embedded mode and can't share a batch */
+#define DSI_PANEL_CMD_BATCH_MAX_CMD_BYTES	256
 #define MIN_PREFILL_LINES      40
 
 static void dsi_dce_prepare_pps_header(char *buf, u32 pps_delay_ms)
@@ -423,13 +427,53 @@ static int dsi_panel_power_off(struct dsi_panel *panel)
 	return rc;
 }
 
+/* worst case bytes a command takes in the dma buffer, header and crc */
+static u32 dsi_panel_cmd_dma_len(struct dsi_cmd_desc *cmd)
+{
+	return ALIGN(cmd->msg.tx_len + 6, 4) + 4;
+}
+
+static bool dsi_panel_cmd_batchable(struct dsi_cmd_desc *cmd)
+{
+	return !cmd->msg.rx_len &&
+		(dsi_panel_cmd_dma_len(cmd) <=
+		 DSI_PANEL_CMD_BATCH_MAX_CMD_BYTES);
+}
+
+/*
+ * Decide if @cmds has to trigger the dma transfer of the batch it ends.
+ * Commands are queued in the controller dma buffer until one of them is
+ * flagged as the last command. With batching enabled the last command flags
+ * of the panel dtsi are ignored and a single transfer is triggered for all
+ * commands up to the next post wait, which has to be honoured after the
+ * command was sent, or until the dma buffer is full.
+ */
+static bool dsi_panel_cmd_batch_end(struct dsi_cmd_desc *cmds, u32 remaining,
+		u32 *batch_len)
+{
+	struct dsi_cmd_desc *next = cmds + 1;
+
+	*batch_len += dsi_panel_cmd_dma_len(cmds);
+
+	if (cmds->post_wait_ms || remaining <= 1 ||
+			!dsi_panel_cmd_batchable(cmds) ||
+			!dsi_panel_cmd_batchable(next) ||
+			(*batch_len + dsi_panel_cmd_dma_len(next) >
+			 DSI_PANEL_CMD_BATCH_MAX_BYTES)) {
+		*batch_len = 0;
+		return true;
+	}
+
+	return false;
+}
+
 int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 				enum dsi_cmd_set_type type)
 {
 	int rc = 0, i = 0;
 	ssize_t len;
 	struct dsi_cmd_desc *cmds;
-	u32 count;
+	u32 count, batch_len = 0;
 	enum dsi_cmd_set_state state;
 	struct dsi_display_mode *mode;
 	const struct mipi_dsi_host_ops *ops = panel->host->ops;
@@ -454,8 +498,15 @@ int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 		if (state == DSI_CMD_SET_STATE_LP)
 			cmds->msg.flags |= MIPI_DSI_MSG_USE_LPM;
 
-		if (cmds->last_command)
+		if (panel->cmd_batch_en) {
+			if (dsi_panel_cmd_batch_end(cmds, count - i,
+					&batch_len))
+				cmds->msg.flags |= MIPI_DSI_MSG_LASTCOMMAND;
+			else
+				cmds->msg.flags &= ~MIPI_DSI_MSG_LASTCOMMAND;
+		} else if (cmds->last_command) {
 			cmds->msg.flags |= MIPI_DSI_MSG_LASTCOMMAND;
+		}
 
 		if (type == DSI_CMD_SET_VID_TO_CMD_SWITCH)
 			cmds->msg.flags |= MIPI_DSI_MSG_ASYNC_OVERRIDE;
@@ -2268,6 +2319,9 @@ static int dsi_panel_parse_misc_features(struct dsi_panel *panel)
 	panel->skip_panel_off = utils->read_bool(utils->data,
 			"qcom,skip-panel-power-off");
 
+	panel->cmd_batch_en = utils->read_bool(utils->data,
+			"qcom,mdss-dsi-cmd-batch-enabled");
+
 	panel->spr_info.enable = false;
 	panel->spr_info.pack_type = MSM_DISPLAY_SPR_TYPE_MAX;
 
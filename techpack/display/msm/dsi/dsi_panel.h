@@ -252,6 +252,7 @@ struct dsi_panel {
 	bool skip_panel_off;
 	bool panel_initialized;
 	bool te_using_watchdog_timer;
+	bool cmd_batch_en;
 	struct dsi_qsync_capabilities qsync_caps;
 
 	char dce_pps_cmd[DSI_CMD_PPS_SIZE];
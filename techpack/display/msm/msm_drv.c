@@ -2248,6 +2248,7 @@ static int __init msm_drm_register(void)
 		return -EINVAL;
 
 	DBG("init");
+	msm_gem_pool_init();
 	sde_rsc_rpmh_register();
 	sde_rsc_register();
 	dsi_display_register();
@@ -2276,6 +2277,7 @@ static void __exit msm_drm_unregister(void)
 	dp_display_unregister();
 	dsi_display_unregister();
 	sde_rsc_unregister();
+	msm_gem_pool_destroy();
 }
 
 module_init(msm_drm_register);
@@ -87,10 +87,17 @@ static struct page **get_pages(struct drm_gem_object *obj)
 		struct page **p;
 		int npages = obj->size >> PAGE_SHIFT;
 
-		if (use_pages(obj))
-			p = drm_gem_get_pages(obj);
-		else
+		if (!use_pages(obj)) {
 			p = get_pages_vram(obj, npages);
+		} else if (msm_gem_pool_enabled()) {
+			p = msm_gem_pool_get_pages(npages);
+			if (IS_ERR(p))
+				p = drm_gem_get_pages(obj);
+			else
+				msm_obj->pool_pages = true;
+		} else {
+			p = drm_gem_get_pages(obj);
+		}
 
 		if (IS_ERR(p)) {
 			dev_err(dev->dev, "could not get pages: %ld\n",
@@ -151,10 +158,15 @@ static void put_pages(struct drm_gem_object *obj)
 			kfree(msm_obj->sgt);
 		}
 
-		if (use_pages(obj))
+		if (msm_obj->pool_pages) {
+			msm_gem_pool_put_pages(msm_obj->pages,
+					obj->size >> PAGE_SHIFT);
+			msm_obj->pool_pages = false;
+		} else if (use_pages(obj)) {
 			drm_gem_put_pages(obj, msm_obj->pages, true, false);
-		else
+		} else {
 			put_pages_vram(obj);
+		}
 
 		msm_obj->pages = NULL;
 	}
@@ -144,6 +144,9 @@ struct msm_gem_object {
 	 * new pagetables due to cb switch
 	 */
 	bool obj_dirty;
+
+	/* pages were allocated from the gem page pool */
+	bool pool_pages;
 };
 #define to_msm_bo(x) container_of(x, struct msm_gem_object, base)
 
@@ -181,6 +184,13 @@ enum msm_gem_lock {
 };
 
 void msm_gem_purge(struct drm_gem_object *obj, enum msm_gem_lock subclass);
+
+/* gem page pool, see msm_gem_pool.c */
+bool msm_gem_pool_enabled(void);
+struct page **msm_gem_pool_get_pages(int npages);
+void msm_gem_pool_put_pages(struct page **pages, int npages);
+void msm_gem_pool_init(void);
+void msm_gem_pool_destroy(void);
 void msm_gem_vunmap(struct drm_gem_object *obj, enum msm_gem_lock subclass);
 
 /* Created per submit-ioctl, to track bo's and cmdstream bufs, etc,
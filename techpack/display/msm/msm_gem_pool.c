@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#include <linux/highmem.h>
+#include <linux/module.h>
+#include <linux/shrinker.h>
+
+#include "msm_drv.h"
+#include "msm_gem.h"
+
+/* 64K chunks let the smmu map scanout buffers with large page entries */
+#define MSM_GEM_POOL_CHUNK_ORDER	4
+#define MSM_GEM_POOL_CHUNK_PAGES	(1 << MSM_GEM_POOL_CHUNK_ORDER)
+
+static bool gem_pool;
+MODULE_PARM_DESC(gem_pool, "Allocate gem object pages from the page pool");
+module_param(gem_pool, bool, 0600);
+
+static unsigned int gem_pool_max_pages = SZ_32M >> PAGE_SHIFT;
+MODULE_PARM_DESC(gem_pool_max_pages, "Max number of pages kept in the pool");
+module_param(gem_pool_max_pages, uint, 0600);
+
+/**
+ * struct msm_gem_pool - free pages kept for reuse by gem objects
+ * @lock: protects the page lists and the counters
+ * @chunks: list of free physically contiguous 64K chunks
+ * @pages: list of free single pages
+ * @count: total number of pages held by the pool
+ * @registered: shrinker was registered
+ */
+struct msm_gem_pool {
+	spinlock_t lock;
+	struct list_head chunks;
+	struct list_head pages;
+	unsigned long count;
+	bool registered;
+};
+
+static struct msm_gem_pool msm_gem_pool = {
+	.lock = __SPIN_LOCK_UNLOCKED(msm_gem_pool.lock),
+	.chunks = LIST_HEAD_INIT(msm_gem_pool.chunks),
+	.pages = LIST_HEAD_INIT(msm_gem_pool.pages),
+};
+
+bool msm_gem_pool_enabled(void)
+{
+	return READ_ONCE(gem_pool);
+}
+
+static void _msm_gem_pool_free(struct page *page, unsigned int order)
+{
+	unsigned int i;
+
+	/* chunks are split, every page has its own reference */
+	for (i = 0; i < (1 << order); i++)
+		__free_page(nth_page(page, i));
+}
+
+static struct page *_msm_gem_pool_get(unsigned int order)
+{
+	struct list_head *list = order ? &msm_gem_pool.chunks :
+			&msm_gem_pool.pages;
+	struct page *page;
+
+	spin_lock(&msm_gem_pool.lock);
+	page = list_first_entry_or_null(list, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		msm_gem_pool.count -= 1 << order;
+	}
+	spin_unlock(&msm_gem_pool.lock);
+
+	return page;
+}
+
+static void _msm_gem_pool_add(struct page *page, unsigned int order)
+{
+	struct list_head *list = order ? &msm_gem_pool.chunks :
+			&msm_gem_pool.pages;
+
+	spin_lock(&msm_gem_pool.lock);
+	if (msm_gem_pool.count + (1 << order) <=
+			READ_ONCE(gem_pool_max_pages)) {
+		list_add_tail(&page->lru, list);
+		msm_gem_pool.count += 1 << order;
+		page = NULL;
+	}
+	spin_unlock(&msm_gem_pool.lock);
+
+	if (page)
+		_msm_gem_pool_free(page, order);
+}
+
+static struct page *_msm_gem_pool_alloc(unsigned int order)
+{
+	struct page *page;
+	gfp_t gfp = GFP_KERNEL;
+
+	page = _msm_gem_pool_get(order);
+	if (page)
+		return page;
+
+	/* only take a chunk if it is readily available, never compact */
+	if (order)
+		gfp = (gfp | __GFP_NORETRY | __GFP_NOWARN) & ~__GFP_RECLAIM;
+
+	page = alloc_pages(gfp, order);
+	if (page && order)
+		split_page(page, order);
+
+	return page;
+}
+
+void msm_gem_pool_put_pages(struct page **pages, int npages)
+{
+	unsigned long pfn;
+	int i, j, n;
+
+	for (i = 0; i < npages; i += n) {
+		pfn = page_to_pfn(pages[i]);
+		n = 1;
+
+		if ((i + MSM_GEM_POOL_CHUNK_PAGES) <= npages &&
+				IS_ALIGNED(pfn, MSM_GEM_POOL_CHUNK_PAGES)) {
+			for (j = 1; j < MSM_GEM_POOL_CHUNK_PAGES; j++)
+				if (page_to_pfn(pages[i + j]) != pfn + j)
+					break;
+
+			if (j == MSM_GEM_POOL_CHUNK_PAGES)
+				n = MSM_GEM_POOL_CHUNK_PAGES;
+		}
+
+		_msm_gem_pool_add(pages[i],
+				n > 1 ? MSM_GEM_POOL_CHUNK_ORDER : 0);
+	}
+
+	kvfree(pages);
+}
+
+struct page **msm_gem_pool_get_pages(int npages)
+{
+	struct page **pages, *page;
+	unsigned int order;
+	int i = 0, j;
+
+	pages = kvmalloc_array(npages, sizeof(struct page *), GFP_KERNEL);
+	if (!pages)
+		return ERR_PTR(-ENOMEM);
+
+	while (i < npages) {
+		order = (npages - i >= MSM_GEM_POOL_CHUNK_PAGES) ?
+				MSM_GEM_POOL_CHUNK_ORDER : 0;
+
+		page = _msm_gem_pool_alloc(order);
+		if (!page && order) {
+			order = 0;
+			page = _msm_gem_pool_alloc(order);
+		}
+
+		if (!page) {
+			msm_gem_pool_put_pages(pages, i);
+			return ERR_PTR(-ENOMEM);
+		}
+
+		/* pages may come from other objects, clear them */
+		for (j = 0; j < (1 << order); j++) {
+			pages[i + j] = nth_page(page, j);
+			clear_highpage(pages[i + j]);
+		}
+
+		i += 1 << order;
+	}
+
+	return pages;
+}
+
+static unsigned long
+msm_gem_pool_shrink_count_objects(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	return READ_ONCE(msm_gem_pool.count);
+}
+
+static unsigned long
+msm_gem_pool_shrink_scan_objects(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	struct page *page;
+	unsigned int order;
+
+	while (freed < sc->nr_to_scan) {
+		/* give back single pages first, chunks are harder to get */
+		order = 0;
+		page = _msm_gem_pool_get(order);
+		if (!page) {
+			order = MSM_GEM_POOL_CHUNK_ORDER;
+			page = _msm_gem_pool_get(order);
+		}
+
+		if (!page)
+			break;
+
+		_msm_gem_pool_free(page, order);
+		freed += 1 << order;
+	}
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker msm_gem_pool_shrinker = {
+	.count_objects = msm_gem_pool_shrink_count_objects,
+	.scan_objects = msm_gem_pool_shrink_scan_objects,
+	.seeks = DEFAULT_SEEKS,
+};
+
+void msm_gem_pool_init(void)
+{
+	if (!register_shrinker(&msm_gem_pool_shrinker))
+		msm_gem_pool.registered = true;
+}
+
+void msm_gem_pool_destroy(void)
+{
+	struct page *page;
+
+	if (msm_gem_pool.registered) {
+		unregister_shrinker(&msm_gem_pool_shrinker);
+		msm_gem_pool.registered = false;
+	}
+
+	while ((page = _msm_gem_pool_get(0)))
+		_msm_gem_pool_free(page, 0);
+
+	while ((page = _msm_gem_pool_get(MSM_GEM_POOL_CHUNK_ORDER)))
+		_msm_gem_pool_free(page, MSM_GEM_POOL_CHUNK_ORDER);
+}
@@ -9,10 +9,74 @@
 #include <linux/irqdomain.h>
 #include <linux/irq.h>
 #include <linux/kthread.h>
+#include <linux/rcupdate.h>
+#include <linux/sched/clock.h>
 
 #include "sde_core_irq.h"
 #include "sde_power_handle.h"
 
+/**
+ * _sde_core_irq_wait_dispatch - wait for a running ISR to finish callbacks
+ * @irq_obj:		Pointer to sde irq object
+ *
+ * The ISR walks the callback snapshots without @cb_lock. Once a new snapshot
+ * is published this makes sure no CPU still runs callbacks from an old one.
+ */
+static void _sde_core_irq_wait_dispatch(struct sde_irq *irq_obj)
+{
+	/* Pairs with the barrier in sde_core_irq() */
+	smp_mb();
+	while (atomic_read(&irq_obj->dispatching))
+		cpu_relax();
+}
+
+/**
+ * _sde_core_irq_publish - publish the callback snapshot for an irq_idx
+ * @irq_obj:		Pointer to sde irq object
+ * @irq_idx:		interrupt index
+ *
+ * Rebuilds the snapshot from irq_cb_tbl[irq_idx]. Must hold @cb_lock.
+ */
+static int _sde_core_irq_publish(struct sde_irq *irq_obj, int irq_idx)
+{
+	struct sde_irq_cb_set *set, *old;
+	struct sde_irq_callback *cb;
+	u32 count = 0;
+
+	old = rcu_dereference_protected(irq_obj->cb_sets[irq_idx],
+			lockdep_is_held(&irq_obj->cb_lock));
+
+	list_for_each_entry(cb, &irq_obj->irq_cb_tbl[irq_idx], list)
+		count++;
+
+	set = count ? kmalloc(struct_size(set, cbs, count), GFP_ATOMIC) : NULL;
+	if (count && !set) {
+		/*
+		 * Out of memory, the live snapshot can still be shrunk in
+		 * place once no ISR is walking it.
+		 */
+		if (!old || count > old->count)
+			return -ENOMEM;
+
+		rcu_assign_pointer(irq_obj->cb_sets[irq_idx], NULL);
+		_sde_core_irq_wait_dispatch(irq_obj);
+		set = old;
+		old = NULL;
+	}
+
+	if (set) {
+		set->count = 0;
+		list_for_each_entry(cb, &irq_obj->irq_cb_tbl[irq_idx], list)
+			set->cbs[set->count++] = cb;
+	}
+
+	rcu_assign_pointer(irq_obj->cb_sets[irq_idx], set);
+	if (old)
+		kfree_rcu(old, rcu);
+
+	return 0;
+}
+
 /**
  * sde_core_irq_callback_handler - dispatch core interrupts
  * @arg:		private data of callback handler
@@ -22,32 +86,51 @@ static void sde_core_irq_callback_handler(void *arg, int irq_idx)
 {
 	struct sde_kms *sde_kms = arg;
 	struct sde_irq *irq_obj = &sde_kms->irq_obj;
+	struct sde_irq_cb_set __rcu **cb_sets = READ_ONCE(irq_obj->cb_sets);
+	atomic_t *irq_counts = READ_ONCE(irq_obj->irq_counts);
+	atomic_t *enable_counts = READ_ONCE(irq_obj->enable_counts);
+	struct sde_irq_stats *stats = READ_ONCE(irq_obj->stats);
+	struct sde_irq_cb_set *set = NULL;
 	struct sde_irq_callback *cb;
-	unsigned long irq_flags;
-	bool cb_tbl_error = false;
-	int enable_counts = 0;
+	int enable_count = 0;
+	u64 start, elapsed;
+	u32 i;
 
 	pr_debug("irq_idx=%d\n", irq_idx);
 
-	spin_lock_irqsave(&sde_kms->irq_obj.cb_lock, irq_flags);
-	if (list_empty(&irq_obj->irq_cb_tbl[irq_idx])) {
-		/* print error outside lock */
-		cb_tbl_error = true;
-		enable_counts = atomic_read(
-				&sde_kms->irq_obj.enable_counts[irq_idx]);
-	}
+	start = local_clock();
 
-	atomic_inc(&irq_obj->irq_counts[irq_idx]);
+	if (irq_counts)
+		atomic_inc(&irq_counts[irq_idx]);
 
 	/*
 	 * Perform registered function callback
 	 */
-	list_for_each_entry(cb, &irq_obj->irq_cb_tbl[irq_idx], list)
+	rcu_read_lock();
+	if (cb_sets)
+		set = rcu_dereference(cb_sets[irq_idx]);
+	for (i = 0; set && i < set->count; i++) {
+		cb = set->cbs[i];
 		if (cb->func)
 			cb->func(cb->arg, irq_idx);
-	spin_unlock_irqrestore(&sde_kms->irq_obj.cb_lock, irq_flags);
+	}
+	rcu_read_unlock();
+
+	if (set && stats) {
+		struct sde_irq_stats *stat = &stats[irq_idx];
+		u64 delay = start - irq_obj->entry_ns;
+
+		elapsed = local_clock() - start;
+		stat->delay_ns += delay;
+		stat->delay_max_ns = max(stat->delay_max_ns, delay);
+		stat->cb_ns += elapsed;
+		stat->cb_max_ns = max(stat->cb_max_ns, elapsed);
+	}
+
+	if (!set) {
+		if (enable_counts)
+			enable_count = atomic_read(&enable_counts[irq_idx]);
 
-	if (cb_tbl_error) {
 		/*
 		 * If enable count is zero and callback list is empty, then it's
 		 * not a fatal issue. Log this case as debug. If the enable
@@ -55,14 +138,14 @@ static void sde_core_irq_callback_handler(void *arg, int irq_idx)
 		 * issue. Log this case as error to ensure we don't have silent
 		 * IRQs running.
 		 */
-		if (!enable_counts) {
+		if (!enable_count) {
 			SDE_DEBUG("irq has no callback, idx %d enables %d\n",
-					irq_idx, enable_counts);
-			SDE_EVT32_IRQ(irq_idx, enable_counts);
+					irq_idx, enable_count);
+			SDE_EVT32_IRQ(irq_idx, enable_count);
 		} else {
 			SDE_ERROR("irq has no callback, idx %d enables %d\n",
-					irq_idx, enable_counts);
-			SDE_EVT32_IRQ(irq_idx, enable_counts, SDE_EVTLOG_ERROR);
+					irq_idx, enable_count);
+			SDE_EVT32_IRQ(irq_idx, enable_count, SDE_EVTLOG_ERROR);
 		}
 	}
 
@@ -278,10 +361,31 @@ u32 sde_core_irq_read(struct sde_kms *sde_kms, int irq_idx, bool clear)
 			irq_idx, clear);
 }
 
+/**
+ * _sde_core_irq_cb_idx - find the irq_idx a callback is registered on
+ * @irq_obj:		Pointer to sde irq object
+ * @irq_cb:		callback to look up, must hold @cb_lock
+ */
+static int _sde_core_irq_cb_idx(struct sde_irq *irq_obj,
+		struct sde_irq_callback *irq_cb)
+{
+	struct sde_irq_callback *cb;
+	int i;
+
+	for (i = 0; i < irq_obj->total_irqs; i++)
+		list_for_each_entry(cb, &irq_obj->irq_cb_tbl[i], list)
+			if (cb == irq_cb)
+				return i;
+
+	return -ENOENT;
+}
+
 int sde_core_irq_register_callback(struct sde_kms *sde_kms, int irq_idx,
 		struct sde_irq_callback *register_irq_cb)
 {
+	struct sde_irq *irq_obj;
 	unsigned long irq_flags;
+	int old_idx, ret;
 
 	if (!sde_kms || !sde_kms->irq_obj.irq_cb_tbl) {
 		SDE_ERROR("invalid params\n");
@@ -303,14 +407,34 @@ int sde_core_irq_register_callback(struct sde_kms *sde_kms, int irq_idx,
 
 	SDE_DEBUG("[%pS] irq_idx=%d\n", __builtin_return_address(0), irq_idx);
 
-	spin_lock_irqsave(&sde_kms->irq_obj.cb_lock, irq_flags);
+	irq_obj = &sde_kms->irq_obj;
+
+	spin_lock_irqsave(&irq_obj->cb_lock, irq_flags);
 	SDE_EVT32(irq_idx, register_irq_cb);
+
+	/* Registering again moves the callback to the new irq_idx */
+	old_idx = list_empty(&register_irq_cb->list) ? -ENOENT :
+			_sde_core_irq_cb_idx(irq_obj, register_irq_cb);
+
 	list_del_init(&register_irq_cb->list);
-	list_add_tail(&register_irq_cb->list,
-			&sde_kms->irq_obj.irq_cb_tbl[irq_idx]);
-	spin_unlock_irqrestore(&sde_kms->irq_obj.cb_lock, irq_flags);
+	list_add_tail(&register_irq_cb->list, &irq_obj->irq_cb_tbl[irq_idx]);
+	ret = _sde_core_irq_publish(irq_obj, irq_idx);
+	if (ret) {
+		list_del_init(&register_irq_cb->list);
+		_sde_core_irq_publish(irq_obj, irq_idx);
+	}
 
-	return 0;
+	if (old_idx >= 0 && old_idx != irq_idx) {
+		_sde_core_irq_publish(irq_obj, old_idx);
+		_sde_core_irq_wait_dispatch(irq_obj);
+	}
+	spin_unlock_irqrestore(&irq_obj->cb_lock, irq_flags);
+
+	if (ret)
+		SDE_ERROR("failed to register irq_idx=%d ret=%d\n",
+				irq_idx, ret);
+
+	return ret;
 }
 
 int sde_core_irq_unregister_callback(struct sde_kms *sde_kms, int irq_idx,
@@ -341,6 +465,13 @@ int sde_core_irq_unregister_callback(struct sde_kms *sde_kms, int irq_idx,
 	spin_lock_irqsave(&sde_kms->irq_obj.cb_lock, irq_flags);
 	SDE_EVT32(irq_idx, register_irq_cb);
 	list_del_init(&register_irq_cb->list);
+	if (_sde_core_irq_publish(&sde_kms->irq_obj, irq_idx))
+		SDE_ERROR("failed to update callbacks for irq_idx=%d\n",
+				irq_idx);
+
+	/* The caller may free the callback once this returns */
+	_sde_core_irq_wait_dispatch(&sde_kms->irq_obj);
+
 	/* empty callback list but interrupt is still enabled */
 	if (list_empty(&sde_kms->irq_obj.irq_cb_tbl[irq_idx]) &&
 			atomic_read(&sde_kms->irq_obj.enable_counts[irq_idx]))
@@ -386,10 +517,12 @@ static int sde_debugfs_core_irq_show(struct seq_file *s, void *v)
 {
 	struct sde_irq *irq_obj = s->private;
 	struct sde_irq_callback *cb;
+	struct sde_irq_stats stat;
 	unsigned long irq_flags;
 	int i, irq_count, enable_count, cb_count;
 
-	if (!irq_obj || !irq_obj->enable_counts || !irq_obj->irq_cb_tbl) {
+	if (!irq_obj || !irq_obj->enable_counts || !irq_obj->irq_cb_tbl ||
+			!irq_obj->stats) {
 		SDE_ERROR("invalid parameters\n");
 		return 0;
 	}
@@ -401,11 +534,22 @@ static int sde_debugfs_core_irq_show(struct seq_file *s, void *v)
 		enable_count = atomic_read(&irq_obj->enable_counts[i]);
 		list_for_each_entry(cb, &irq_obj->irq_cb_tbl[i], list)
 			cb_count++;
+		stat = irq_obj->stats[i];
 		spin_unlock_irqrestore(&irq_obj->cb_lock, irq_flags);
 
-		if (irq_count || enable_count || cb_count)
-			seq_printf(s, "idx:%d irq:%d enable:%d cb:%d\n",
-					i, irq_count, enable_count, cb_count);
+		if (!irq_count && !enable_count && !cb_count)
+			continue;
+
+		seq_printf(s, "idx:%d irq:%d enable:%d cb:%d", i, irq_count,
+				enable_count, cb_count);
+		if (irq_count)
+			seq_printf(s,
+				" delay_avg:%llu delay_max:%llu cb_avg:%llu cb_max:%llu",
+				div_u64(stat.delay_ns, irq_count),
+				stat.delay_max_ns,
+				div_u64(stat.cb_ns, irq_count),
+				stat.cb_max_ns);
+		seq_puts(s, "\n");
 	}
 
 	return 0;
@@ -475,8 +619,13 @@ void sde_core_irq_preinstall(struct sde_kms *sde_kms)
 			sizeof(atomic_t), GFP_KERNEL);
 	sde_kms->irq_obj.irq_counts = kcalloc(sde_kms->irq_obj.total_irqs,
 			sizeof(atomic_t), GFP_KERNEL);
+	sde_kms->irq_obj.cb_sets = kcalloc(sde_kms->irq_obj.total_irqs,
+			sizeof(*sde_kms->irq_obj.cb_sets), GFP_KERNEL);
+	sde_kms->irq_obj.stats = kcalloc(sde_kms->irq_obj.total_irqs,
+			sizeof(struct sde_irq_stats), GFP_KERNEL);
 	if (!sde_kms->irq_obj.irq_cb_tbl || !sde_kms->irq_obj.enable_counts
-			|| !sde_kms->irq_obj.irq_counts)
+			|| !sde_kms->irq_obj.irq_counts
+			|| !sde_kms->irq_obj.cb_sets || !sde_kms->irq_obj.stats)
 		return;
 
 	for (i = 0; i < sde_kms->irq_obj.total_irqs; i++) {
@@ -496,6 +645,10 @@ int sde_core_irq_postinstall(struct sde_kms *sde_kms)
 
 void sde_core_irq_uninstall(struct sde_kms *sde_kms)
 {
+	struct sde_irq *irq_obj;
+	struct sde_irq_cb_set __rcu **cb_sets;
+	atomic_t *enable_counts, *irq_counts;
+	struct sde_irq_stats *stats;
 	int i;
 	int rc;
 	unsigned long irq_flags;
@@ -505,6 +658,8 @@ void sde_core_irq_uninstall(struct sde_kms *sde_kms)
 		return;
 	}
 
+	irq_obj = &sde_kms->irq_obj;
+
 	rc = pm_runtime_get_sync(sde_kms->dev->dev);
 	if (rc < 0) {
 		SDE_ERROR("failed to enable power resource %d\n", rc);
@@ -521,15 +676,28 @@ void sde_core_irq_uninstall(struct sde_kms *sde_kms)
 	sde_disable_all_irqs(sde_kms);
 	pm_runtime_put_sync(sde_kms->dev->dev);
 
-	spin_lock_irqsave(&sde_kms->irq_obj.cb_lock, irq_flags);
-	kfree(sde_kms->irq_obj.irq_cb_tbl);
-	kfree(sde_kms->irq_obj.enable_counts);
-	kfree(sde_kms->irq_obj.irq_counts);
-	sde_kms->irq_obj.irq_cb_tbl = NULL;
-	sde_kms->irq_obj.enable_counts = NULL;
-	sde_kms->irq_obj.irq_counts = NULL;
-	sde_kms->irq_obj.total_irqs = 0;
-	spin_unlock_irqrestore(&sde_kms->irq_obj.cb_lock, irq_flags);
+	spin_lock_irqsave(&irq_obj->cb_lock, irq_flags);
+	cb_sets = irq_obj->cb_sets;
+	enable_counts = irq_obj->enable_counts;
+	irq_counts = irq_obj->irq_counts;
+	stats = irq_obj->stats;
+	WRITE_ONCE(irq_obj->cb_sets, NULL);
+	WRITE_ONCE(irq_obj->enable_counts, NULL);
+	WRITE_ONCE(irq_obj->irq_counts, NULL);
+	WRITE_ONCE(irq_obj->stats, NULL);
+	_sde_core_irq_wait_dispatch(irq_obj);
+
+	for (i = 0; cb_sets && i < irq_obj->total_irqs; i++)
+		kfree(rcu_dereference_protected(cb_sets[i], 1));
+
+	kfree(irq_obj->irq_cb_tbl);
+	kfree(cb_sets);
+	kfree(enable_counts);
+	kfree(irq_counts);
+	kfree(stats);
+	irq_obj->irq_cb_tbl = NULL;
+	irq_obj->total_irqs = 0;
+	spin_unlock_irqrestore(&irq_obj->cb_lock, irq_flags);
 }
 
 static void sde_core_irq_mask(struct irq_data *irqd)
@@ -631,6 +799,13 @@ int sde_core_irq_domain_fini(struct sde_kms *sde_kms)
 
 irqreturn_t sde_core_irq(struct sde_kms *sde_kms)
 {
+	struct sde_irq *irq_obj = &sde_kms->irq_obj;
+
+	/* Pairs with the barrier in _sde_core_irq_wait_dispatch() */
+	atomic_inc(&irq_obj->dispatching);
+	smp_mb__after_atomic();
+	irq_obj->entry_ns = local_clock();
+
 	/*
 	 * Read interrupt status from all sources. Interrupt status are
 	 * stored within hw_intr.
@@ -653,5 +828,8 @@ irqreturn_t sde_core_irq(struct sde_kms *sde_kms)
 			sde_core_irq_callback_handler,
 			sde_kms);
 
+	smp_mb__before_atomic();
+	atomic_dec(&irq_obj->dispatching);
+
 	return IRQ_HANDLED;
 }
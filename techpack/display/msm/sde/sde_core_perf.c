@@ -9,6 +9,7 @@
 #include <linux/errno.h>
 #include <linux/mutex.h>
 #include <linux/sort.h>
+#include <linux/seq_file.h>
 #include <linux/clk.h>
 #include <linux/bitmap.h>
 #include <linux/sde_rsc.h>
@@ -27,6 +28,16 @@
 #define SDE_PERF_MODE_STRING_SIZE	128
 #define SDE_PERF_THRESHOLD_HIGH_MIN     12800000
 
+/* percentage of the gate cycles the uidle policy aims to spend in fal10 */
+#define SDE_PERF_UIDLE_TARGET_RESIDENCY	50
+/* maximum the uidle policy moves the fal10 threshold from the catalog value */
+#define SDE_PERF_UIDLE_MAX_ADJ		2
+/* fal10 threshold and its exit threshold, 2 above it, are 4 bit fields */
+#define SDE_PERF_UIDLE_FAL10_MAX	13
+/* danger free windows needed before the threshold is lowered again */
+#define SDE_PERF_UIDLE_CLEAN_WINDOWS	4
+#define SDE_PERF_UIDLE_WINDOW_DEFAULT	64
+
 #define GET_H32(val) (val >> 32)
 #define GET_L32(val) (val & 0xffffffff)
 
@@ -571,13 +582,149 @@ static void _sde_core_perf_uidle_setup_cntr(struct sde_kms *sde_kms,
 	}
 }
 
+static void _sde_core_perf_uidle_select_mode(struct sde_core_perf *perf,
+	u32 fps, bool enable)
+{
+	struct sde_core_perf_uidle_stats *stats = &perf->uidle_stats;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->mode = -1;
+	stats->win_samples = 0;
+	stats->win_danger = 0;
+	stats->win_fal10_cycles = 0;
+	stats->win_cycles = 0;
+	stats->clean_windows = 0;
+
+	if (!enable)
+		goto unlock;
+
+	for (i = 0; i < SDE_PERF_UIDLE_MODES; i++) {
+		if (stats->modes[i].fps == fps) {
+			stats->mode = i;
+			goto unlock;
+		}
+	}
+
+	/* new panel mode, start over from the catalog threshold */
+	i = stats->next_mode;
+	stats->next_mode = (i + 1) % SDE_PERF_UIDLE_MODES;
+	stats->modes[i].fps = fps;
+	stats->modes[i].fal10_adj = 0;
+	stats->mode = i;
+
+unlock:
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+/* Must be called with the uidle stats lock held */
+static void _sde_core_perf_uidle_tune(struct sde_core_perf *perf)
+{
+	struct sde_core_perf_uidle_stats *stats = &perf->uidle_stats;
+	struct sde_core_perf_uidle_mode *mode;
+	u32 residency = 0;
+	int adj;
+
+	if (stats->mode < 0 || !READ_ONCE(perf->uidle_auto_threshold))
+		goto reset;
+
+	mode = &stats->modes[stats->mode];
+	adj = mode->fal10_adj;
+	if (stats->win_cycles)
+		residency = div64_u64(stats->win_fal10_cycles * 100,
+				stats->win_cycles);
+
+	if (stats->win_danger) {
+		/* fetch fell behind while idle, be more conservative */
+		stats->clean_windows = 0;
+		adj++;
+	} else if (++stats->clean_windows >= SDE_PERF_UIDLE_CLEAN_WINDOWS &&
+			stats->win_cycles &&
+			residency < SDE_PERF_UIDLE_TARGET_RESIDENCY) {
+		/* buffers stayed safe but fal10 was rarely used */
+		stats->clean_windows = 0;
+		adj--;
+	}
+
+	adj = clamp(adj, -SDE_PERF_UIDLE_MAX_ADJ, SDE_PERF_UIDLE_MAX_ADJ);
+	if (adj != mode->fal10_adj) {
+		mode->fal10_adj = adj;
+		stats->adjustments++;
+		SDE_EVT32(mode->fps, adj, residency, stats->win_danger);
+		trace_sde_perf_uidle_tune(mode->fps, adj, residency,
+				stats->win_danger);
+	}
+
+reset:
+	stats->win_samples = 0;
+	stats->win_danger = 0;
+	stats->win_fal10_cycles = 0;
+	stats->win_cycles = 0;
+}
+
+void sde_core_perf_uidle_sample(struct sde_core_perf *perf,
+		struct sde_uidle_cntr *cntr, struct sde_uidle_status *status)
+{
+	struct sde_core_perf_uidle_stats *stats;
+	unsigned long flags;
+	bool danger;
+	u64 cycles;
+
+	if (!perf || !cntr)
+		return;
+
+	stats = &perf->uidle_stats;
+	cycles = (u64)cntr->fal1_gate_cntr + cntr->fal10_gate_cntr +
+			cntr->fal_wait_gate_cntr;
+	danger = status && (status->uidle_danger_status_0 ||
+			status->uidle_danger_status_1);
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->samples++;
+	stats->fal1_entries += cntr->fal1_num_transitions_cntr;
+	stats->fal10_entries += cntr->fal10_num_transitions_cntr;
+	stats->fal1_cycles += cntr->fal1_gate_cntr;
+	stats->fal10_cycles += cntr->fal10_gate_cntr;
+	stats->wait_cycles += cntr->fal_wait_gate_cntr;
+	if (danger) {
+		stats->danger_samples++;
+		stats->win_danger++;
+	}
+
+	stats->win_samples++;
+	stats->win_fal10_cycles += cntr->fal10_gate_cntr;
+	stats->win_cycles += cycles;
+	if (stats->win_samples >= max_t(u32, READ_ONCE(perf->uidle_window), 1))
+		_sde_core_perf_uidle_tune(perf);
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+u32 sde_core_perf_uidle_fal10_threshold(struct sde_core_perf *perf)
+{
+	struct sde_core_perf_uidle_stats *stats = &perf->uidle_stats;
+	u32 threshold = perf->catalog->uidle_cfg.fal10_threshold;
+	unsigned long flags;
+	int adj = 0;
+
+	if (!threshold)
+		return 0;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	if (stats->mode >= 0 && READ_ONCE(perf->uidle_auto_threshold))
+		adj = stats->modes[stats->mode].fal10_adj;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	return clamp_t(int, threshold + adj, 1, SDE_PERF_UIDLE_FAL10_MAX);
+}
+
 void sde_core_perf_crtc_update_uidle(struct drm_crtc *crtc,
 	bool enable)
 {
 	struct drm_crtc *tmp_crtc;
 	struct sde_kms *kms;
 	bool disable_uidle = false;
-	u32 fps, num_crtc = 0;
+	u32 fps, uidle_fps = 0, num_crtc = 0;
 
 	if (!crtc) {
 		SDE_ERROR("invalid crtc\n");
@@ -627,22 +774,48 @@ void sde_core_perf_crtc_update_uidle(struct drm_crtc *crtc,
 				disable_uidle = true;
 				break;
 			}
+
+			uidle_fps = fps;
 		}
 	}
 
 	_sde_core_perf_enable_uidle(kms, crtc,
 		(enable && !disable_uidle) ? true : false);
+	_sde_core_perf_uidle_select_mode(&kms->perf, uidle_fps,
+		enable && !disable_uidle);
 
 	kms->perf.catalog->uidle_cfg.dirty = !enable;
 
 	/* If perf counters enabled, set them up now */
-	if (kms->catalog->uidle_cfg.debugfs_perf)
+	if (sde_core_perf_uidle_sampling(&kms->perf))
 		_sde_core_perf_uidle_setup_cntr(kms, enable);
 
 exit:
 	mutex_unlock(&sde_core_perf_lock);
 }
 
+static void _sde_core_perf_vote_stats_update(
+		struct sde_core_perf_vote_stats *stats, u64 val)
+{
+	int dir;
+
+	stats->votes++;
+	if (val == stats->last)
+		return;
+
+	dir = val > stats->last ? 1 : -1;
+	if (dir > 0)
+		stats->up++;
+	else
+		stats->down++;
+
+	if (stats->last_dir && dir != stats->last_dir)
+		stats->reversals++;
+
+	stats->last = val;
+	stats->last_dir = dir;
+}
+
 static void _sde_core_perf_crtc_update_bus(struct sde_kms *kms,
 		struct drm_crtc *crtc, u32 bus_id)
 {
@@ -694,6 +867,9 @@ static void _sde_core_perf_crtc_update_bus(struct sde_kms *kms,
 					bus_ib_quota);
 	}
 
+	_sde_core_perf_vote_stats_update(&kms->perf.bus_stats[bus_id],
+			bus_ab_quota);
+
 	client_vote = _get_sde_client_type(curr_client_type, &kms->perf);
 	switch (client_vote) {
 	case RT_CLIENT:
@@ -915,6 +1091,47 @@ static void _sde_core_perf_crtc_update_check(struct drm_crtc *crtc,
 	}
 }
 
+/*
+ * Raise the request of the coming frame to the peak of the last frames.
+ * Increases still take effect right away, while a decrease only reaches
+ * the vote once the higher frames are out of the window. Fluctuating
+ * compositions then keep one steady vote instead of ramping up and down.
+ */
+static void _sde_core_perf_predict(struct sde_kms *kms,
+		struct sde_crtc *sde_crtc)
+{
+	struct sde_core_perf_history *hist = &sde_crtc->perf_hist;
+	struct sde_core_perf_params *new = &sde_crtc->new_perf;
+	struct sde_core_perf_params *prev;
+	u32 frames, i, j, slot;
+
+	frames = min_t(u32, kms->perf.predict_frames,
+			SDE_PERF_PREDICT_MAX_FRAMES);
+	if (frames < 2) {
+		hist->cnt = 0;
+		return;
+	}
+
+	hist->params[hist->idx] = *new;
+	hist->idx = (hist->idx + 1) % SDE_PERF_PREDICT_MAX_FRAMES;
+	hist->cnt = min(hist->cnt + 1, frames);
+
+	/* entry 0 is the request just added */
+	for (i = 1; i < hist->cnt; i++) {
+		slot = (hist->idx + SDE_PERF_PREDICT_MAX_FRAMES - 1 - i) %
+				SDE_PERF_PREDICT_MAX_FRAMES;
+		prev = &hist->params[slot];
+
+		for (j = 0; j < SDE_POWER_HANDLE_DBUS_ID_MAX; j++) {
+			new->bw_ctl[j] = max(new->bw_ctl[j], prev->bw_ctl[j]);
+			new->max_per_pipe_ib[j] = max(new->max_per_pipe_ib[j],
+					prev->max_per_pipe_ib[j]);
+		}
+		new->core_clk_rate = max(new->core_clk_rate,
+				prev->core_clk_rate);
+	}
+}
+
 void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		int params_changed, bool stop_req)
 {
@@ -951,9 +1168,11 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 	 * crtc kickoff, so the same numbers are used during the
 	 * perf update that happens post kickoff.
 	 */
-	if (params_changed)
+	if (params_changed) {
 		memcpy(&sde_crtc->new_perf, &sde_cstate->new_perf,
 			sizeof(struct sde_core_perf_params));
+		_sde_core_perf_predict(kms, sde_crtc);
+	}
 
 	old = &sde_crtc->cur_perf;
 	new = &sde_crtc->new_perf;
@@ -965,6 +1184,7 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		SDE_DEBUG("crtc=%d disable\n", crtc->base.id);
 		memset(old, 0, sizeof(*old));
 		memset(new, 0, sizeof(*new));
+		sde_crtc->perf_hist.cnt = 0;
 		update_bus = ~0;
 		update_clk = 1;
 	}
@@ -1009,6 +1229,8 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		}
 
 		kms->perf.core_clk_rate = clk_rate;
+		_sde_core_perf_vote_stats_update(&kms->perf.clk_stats,
+				clk_rate);
 		SDE_DEBUG("update clk rate = %lld HZ\n", clk_rate);
 	}
 	mutex_unlock(&sde_core_perf_lock);
@@ -1162,6 +1384,91 @@ static ssize_t _sde_core_perf_mode_read(struct file *file,
 	return len;
 }
 
+static int _sde_core_perf_vote_stats_show(struct seq_file *s, void *data)
+{
+	struct sde_core_perf *perf = s->private;
+	struct sde_core_perf_vote_stats *stats;
+	int i;
+
+	mutex_lock(&sde_core_perf_lock);
+	seq_puts(s, "vote votes up down reversals last\n");
+	for (i = 0; i <= SDE_POWER_HANDLE_DBUS_ID_MAX; i++) {
+		if (i < SDE_POWER_HANDLE_DBUS_ID_MAX) {
+			stats = &perf->bus_stats[i];
+			seq_printf(s, "bus%d ", i);
+		} else {
+			stats = &perf->clk_stats;
+			seq_puts(s, "clk ");
+		}
+
+		seq_printf(s, "%llu %llu %llu %llu %llu\n", stats->votes,
+				stats->up, stats->down, stats->reversals,
+				stats->last);
+	}
+	mutex_unlock(&sde_core_perf_lock);
+
+	return 0;
+}
+
+static int _sde_core_perf_vote_stats_open(struct inode *inode,
+		struct file *file)
+{
+	return single_open(file, _sde_core_perf_vote_stats_show,
+			inode->i_private);
+}
+
+static const struct file_operations sde_core_perf_vote_stats_fops = {
+	.open = _sde_core_perf_vote_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int _sde_core_perf_uidle_stats_show(struct seq_file *s, void *data)
+{
+	struct sde_core_perf *perf = s->private;
+	struct sde_core_perf_uidle_stats stats;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&perf->uidle_stats.lock, flags);
+	stats = perf->uidle_stats;
+	spin_unlock_irqrestore(&perf->uidle_stats.lock, flags);
+
+	seq_printf(s, "samples:%llu danger_samples:%llu adjustments:%llu\n",
+			stats.samples, stats.danger_samples, stats.adjustments);
+	seq_printf(s, "entries: fal1:%llu fal10:%llu\n",
+			stats.fal1_entries, stats.fal10_entries);
+	seq_printf(s, "cycles: fal1:%llu fal10:%llu wait:%llu\n",
+			stats.fal1_cycles, stats.fal10_cycles,
+			stats.wait_cycles);
+
+	seq_puts(s, "fps fal10_adj active\n");
+	for (i = 0; i < SDE_PERF_UIDLE_MODES; i++) {
+		if (!stats.modes[i].fps)
+			continue;
+
+		seq_printf(s, "%u %d %d\n", stats.modes[i].fps,
+				stats.modes[i].fal10_adj, i == stats.mode);
+	}
+
+	return 0;
+}
+
+static int _sde_core_perf_uidle_stats_open(struct inode *inode,
+		struct file *file)
+{
+	return single_open(file, _sde_core_perf_uidle_stats_show,
+			inode->i_private);
+}
+
+static const struct file_operations sde_core_perf_uidle_stats_fops = {
+	.open = _sde_core_perf_uidle_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static const struct file_operations sde_core_perf_threshold_high_fops = {
 	.open = simple_open,
 	.read = _sde_core_perf_threshold_high_read,
@@ -1229,11 +1536,21 @@ int sde_core_perf_debugfs_init(struct sde_core_perf *perf,
 			&perf->fix_core_ab_vote);
 	debugfs_create_bool("idle_sys_cache_enable", 0600, perf->debugfs_root,
 			&perf->idle_sys_cache_enabled);
+	debugfs_create_u32("predict_frames", 0600, perf->debugfs_root,
+			&perf->predict_frames);
+	debugfs_create_file("vote_stats", 0400, perf->debugfs_root,
+			perf, &sde_core_perf_vote_stats_fops);
 
 	debugfs_create_u32("uidle_perf_cnt", 0600, perf->debugfs_root,
 			&sde_kms->catalog->uidle_cfg.debugfs_perf);
 	debugfs_create_bool("uidle_enable", 0600, perf->debugfs_root,
 			&sde_kms->catalog->uidle_cfg.debugfs_ctrl);
+	debugfs_create_bool("uidle_auto_threshold", 0600, perf->debugfs_root,
+			&perf->uidle_auto_threshold);
+	debugfs_create_u32("uidle_window", 0600, perf->debugfs_root,
+			&perf->uidle_window);
+	debugfs_create_file("uidle_stats", 0400, perf->debugfs_root,
+			perf, &sde_core_perf_uidle_stats_fops);
 
 	return 0;
 }
@@ -1299,6 +1616,9 @@ int sde_core_perf_init(struct sde_core_perf *perf,
 		perf->max_core_clk_rate = SDE_PERF_DEFAULT_MAX_CORE_CLK_RATE;
 	}
 	perf->idle_sys_cache_enabled = true;
+	perf->uidle_window = SDE_PERF_UIDLE_WINDOW_DEFAULT;
+	spin_lock_init(&perf->uidle_stats.lock);
+	perf->uidle_stats.mode = -1;
 
 	return 0;
 
@@ -13,9 +13,16 @@
 
 #include "sde_hw_catalog.h"
 #include "sde_power_handle.h"
+#include "sde_hw_uidle.h"
 
 #define SDE_PERF_DEFAULT_MAX_CORE_CLK_RATE	320000000
 
+/* maximum number of frames the predictive vote can look back */
+#define SDE_PERF_PREDICT_MAX_FRAMES	16
+
+/* panel modes the uidle threshold policy keeps a tuned threshold for */
+#define SDE_PERF_UIDLE_MODES		4
+
 /**
  *  uidle performance counters mode
  * @SDE_PERF_UIDLE_DISABLE: Disable logging (default)
@@ -42,6 +49,86 @@ struct sde_core_perf_params {
 	bool llcc_active[SDE_SYS_CACHE_MAX];
 };
 
+/**
+ * struct sde_core_perf_history - recent performance requests of a crtc
+ * @params: ring of the requested performance parameters
+ * @idx: next slot of @params to fill
+ * @cnt: number of valid entries in @params
+ */
+struct sde_core_perf_history {
+	struct sde_core_perf_params params[SDE_PERF_PREDICT_MAX_FRAMES];
+	u32 idx;
+	u32 cnt;
+};
+
+/**
+ * struct sde_core_perf_vote_stats - churn statistics of a clock/bus vote
+ * @votes: number of votes sent
+ * @up: votes raising the previous value
+ * @down: votes lowering the previous value
+ * @reversals: changes in the opposite direction of the change before
+ * @last: last voted value
+ * @last_dir: direction of the last change, 1 up, -1 down, 0 none yet
+ */
+struct sde_core_perf_vote_stats {
+	u64 votes;
+	u64 up;
+	u64 down;
+	u64 reversals;
+	u64 last;
+	int last_dir;
+};
+
+/**
+ * struct sde_core_perf_uidle_mode - tuned uidle threshold of a panel mode
+ * @fps: refresh rate of the mode, 0 if the entry is unused
+ * @fal10_adj: adjustment applied to the catalog fal10 threshold
+ */
+struct sde_core_perf_uidle_mode {
+	u32 fps;
+	int fal10_adj;
+};
+
+/**
+ * struct sde_core_perf_uidle_stats - uidle residency telemetry and policy
+ * @lock: protects the structure, samples are taken from the vsync irq
+ * @samples: number of vsyncs the counters were sampled at
+ * @fal1_entries: number of fal1 entries
+ * @fal10_entries: number of fal10 entries
+ * @fal1_cycles: cycles spent in fal1
+ * @fal10_cycles: cycles spent in fal10
+ * @wait_cycles: cycles spent waiting for fal entry
+ * @danger_samples: samples at which a pipe was in danger
+ * @win_samples: samples of the current policy window
+ * @win_danger: danger samples of the current policy window
+ * @win_fal10_cycles: fal10 cycles of the current policy window
+ * @win_cycles: all gate cycles of the current policy window
+ * @clean_windows: consecutive policy windows without a danger sample
+ * @adjustments: number of threshold changes made by the policy
+ * @modes: tuned thresholds of the recently used panel modes
+ * @mode: index of the mode uidle is enabled for, -1 if none
+ * @next_mode: entry to replace when a new panel mode shows up
+ */
+struct sde_core_perf_uidle_stats {
+	spinlock_t lock;
+	u64 samples;
+	u64 fal1_entries;
+	u64 fal10_entries;
+	u64 fal1_cycles;
+	u64 fal10_cycles;
+	u64 wait_cycles;
+	u64 danger_samples;
+	u32 win_samples;
+	u32 win_danger;
+	u64 win_fal10_cycles;
+	u64 win_cycles;
+	u32 clean_windows;
+	u64 adjustments;
+	struct sde_core_perf_uidle_mode modes[SDE_PERF_UIDLE_MODES];
+	int mode;
+	u32 next_mode;
+};
+
 /**
  * struct sde_core_perf_tune - definition of performance tuning control
  * @mode: performance mode
@@ -76,8 +163,16 @@ struct sde_core_perf_tune {
  * @bw_vote_mode_updated: bandwidth vote mode update
  * @llcc_active: status of the llcc, true if active.
  * @uidle_enabled: indicates if uidle is already enabled
+ * @uidle_auto_threshold: tune the uidle fal10 threshold of each panel mode
+ *                        from the observed residency
+ * @uidle_window: number of vsyncs the uidle policy evaluates at once
+ * @uidle_stats: uidle residency telemetry
  * @idle_sys_cache_enabled: override system cache enable state
  *                          for idle usecase
+ * @predict_frames: number of recent frames the crtc votes hold the peak of,
+ *                  0 or 1 to follow every commit
+ * @bus_stats: ab vote statistics of each data bus
+ * @clk_stats: core clock vote statistics
  */
 struct sde_core_perf {
 	struct drm_device *dev;
@@ -98,7 +193,13 @@ struct sde_core_perf {
 	bool bw_vote_mode_updated;
 	bool llcc_active[SDE_SYS_CACHE_MAX];
 	bool uidle_enabled;
+	bool uidle_auto_threshold;
+	u32 uidle_window;
+	struct sde_core_perf_uidle_stats uidle_stats;
 	bool idle_sys_cache_enabled;
+	u32 predict_frames;
+	struct sde_core_perf_vote_stats bus_stats[SDE_POWER_HANDLE_DBUS_ID_MAX];
+	struct sde_core_perf_vote_stats clk_stats;
 };
 
 /**
@@ -138,6 +239,34 @@ void sde_core_perf_crtc_release_bw(struct drm_crtc *crtc);
  */
 void sde_core_perf_crtc_update_uidle(struct drm_crtc *crtc, bool enable);
 
+/**
+ * sde_core_perf_uidle_sampling - check if uidle counters should be sampled
+ * @perf: Pointer to core performance context
+ * return: true if the telemetry or the threshold policy needs the counters
+ */
+static inline bool sde_core_perf_uidle_sampling(struct sde_core_perf *perf)
+{
+	return perf->catalog->uidle_cfg.debugfs_perf ||
+		READ_ONCE(perf->uidle_auto_threshold);
+}
+
+/**
+ * sde_core_perf_uidle_sample - account uidle counters read at a vsync
+ * @perf: Pointer to core performance context
+ * @cntr: counters read since the last sample
+ * @status: uidle status at the vsync
+ */
+void sde_core_perf_uidle_sample(struct sde_core_perf *perf,
+		struct sde_uidle_cntr *cntr, struct sde_uidle_status *status);
+
+/**
+ * sde_core_perf_uidle_fal10_threshold - get the fal10 threshold to program
+ * @perf: Pointer to core performance context
+ * return: catalog fal10 threshold with the policy adjustment of the
+ *         current panel mode applied
+ */
+u32 sde_core_perf_uidle_fal10_threshold(struct sde_core_perf *perf);
+
 /**
  * sde_core_uidle_setup_ctl - enable uidle DB control
  * @crtc: Pointer to crtc
@@ -2229,6 +2229,96 @@ static void _sde_crtc_dest_scaler_setup(struct drm_crtc *crtc)
 	}
 }
 
+/* Add a sample to the histogram of @stage, call with lat.lock held */
+static void _sde_crtc_lat_add(struct sde_crtc *sde_crtc,
+		enum sde_crtc_lat_stage stage, ktime_t start, ktime_t end)
+{
+	struct sde_crtc_lat_hist *hist = &sde_crtc->lat.hist[stage];
+	s64 delta = ktime_us_delta(end, start);
+	u32 us = delta > 0 ? min_t(s64, delta, U32_MAX) : 0;
+
+	hist->buckets[min_t(u32, us / SDE_CRTC_LAT_BUCKET_US,
+			SDE_CRTC_LAT_BUCKETS - 1)]++;
+	if (!hist->count || us < hist->min_us)
+		hist->min_us = us;
+	hist->max_us = max(hist->max_us, us);
+	hist->total_us += us;
+	hist->count++;
+}
+
+static void _sde_crtc_lat_sample(struct sde_crtc *sde_crtc,
+		enum sde_crtc_lat_stage stage, ktime_t start)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sde_crtc->lat.lock, flags);
+	_sde_crtc_lat_add(sde_crtc, stage, start, ktime_get());
+	spin_unlock_irqrestore(&sde_crtc->lat.lock, flags);
+}
+
+static void _sde_crtc_lat_kickoff(struct sde_crtc *sde_crtc)
+{
+	struct sde_crtc_lat_info *lat = &sde_crtc->lat;
+	ktime_t now = ktime_get();
+	unsigned long flags;
+
+	spin_lock_irqsave(&lat->lock, flags);
+	if (lat->begin_time)
+		_sde_crtc_lat_add(sde_crtc, SDE_CRTC_LAT_COMMIT_KICKOFF,
+				lat->begin_time, now);
+	lat->begin_time = 0;
+	lat->kickoff_time = now;
+
+	/* forget the oldest kickoff if its retire fence never came */
+	if (lat->retire_head - lat->retire_tail == SDE_CRTC_LAT_PENDING)
+		lat->retire_tail++;
+	lat->retire_time[lat->retire_head++ % SDE_CRTC_LAT_PENDING] = now;
+	spin_unlock_irqrestore(&lat->lock, flags);
+}
+
+static void _sde_crtc_lat_vblank(struct sde_crtc *sde_crtc)
+{
+	struct sde_crtc_lat_info *lat = &sde_crtc->lat;
+	unsigned long flags;
+
+	spin_lock_irqsave(&lat->lock, flags);
+	if (lat->kickoff_time) {
+		_sde_crtc_lat_add(sde_crtc, SDE_CRTC_LAT_KICKOFF_VSYNC,
+				lat->kickoff_time, ktime_get());
+		lat->kickoff_time = 0;
+	}
+	spin_unlock_irqrestore(&lat->lock, flags);
+}
+
+static void _sde_crtc_lat_retire(struct sde_crtc *sde_crtc)
+{
+	struct sde_crtc_lat_info *lat = &sde_crtc->lat;
+	unsigned long flags;
+	ktime_t start;
+
+	spin_lock_irqsave(&lat->lock, flags);
+	if (lat->retire_head != lat->retire_tail) {
+		start = lat->retire_time[lat->retire_tail++ %
+				SDE_CRTC_LAT_PENDING];
+		_sde_crtc_lat_add(sde_crtc, SDE_CRTC_LAT_RETIRE, start,
+				ktime_get());
+	}
+	spin_unlock_irqrestore(&lat->lock, flags);
+}
+
+/* Drop the pending timestamps, nothing is in flight after a disable */
+static void _sde_crtc_lat_reset_pending(struct sde_crtc *sde_crtc)
+{
+	struct sde_crtc_lat_info *lat = &sde_crtc->lat;
+	unsigned long flags;
+
+	spin_lock_irqsave(&lat->lock, flags);
+	lat->begin_time = 0;
+	lat->kickoff_time = 0;
+	lat->retire_tail = lat->retire_head;
+	spin_unlock_irqrestore(&lat->lock, flags);
+}
+
 static void sde_crtc_frame_event_cb(void *data, u32 event)
 {
 	struct drm_crtc *crtc = (struct drm_crtc *)data;
@@ -2291,12 +2381,27 @@ static void sde_crtc_frame_event_cb(void *data, u32 event)
 		}
 	}
 
+	if (event & SDE_ENCODER_FRAME_EVENT_SIGNAL_RETIRE_FENCE)
+		_sde_crtc_lat_retire(sde_crtc);
+
 	if ((event & SDE_ENCODER_FRAME_EVENT_SIGNAL_RETIRE_FENCE) &&
 		(sde_crtc && sde_crtc->retire_frame_event_sf)) {
 		sde_crtc->retire_frame_event_time = ktime_get();
 		sysfs_notify_dirent(sde_crtc->retire_frame_event_sf);
 	}
 
+	/*
+	 * The old buffers are no longer fetched once the frame is done, so
+	 * release them right away rather than after the event thread runs.
+	 */
+	if ((event & SDE_ENCODER_FRAME_EVENT_SIGNAL_RELEASE_FENCE) &&
+			READ_ONCE(sde_crtc->early_release)) {
+		sde_fence_signal(sde_crtc->output_fence, ktime_get(),
+				(event & SDE_ENCODER_FRAME_EVENT_ERROR)
+				? SDE_FENCE_SIGNAL_ERROR : SDE_FENCE_SIGNAL);
+		event &= ~SDE_ENCODER_FRAME_EVENT_SIGNAL_RELEASE_FENCE;
+	}
+
 	fevent->event = event;
 	fevent->crtc = crtc;
 	fevent->connector = cb_data->connector;
@@ -2463,6 +2568,8 @@ static void sde_crtc_vblank_cb(void *data)
 	sde_crtc->vblank_last_cb_time = ktime_get();
 	sysfs_notify_dirent(sde_crtc->vsync_event_sf);
 
+	_sde_crtc_lat_vblank(sde_crtc);
+
 	drm_crtc_handle_vblank(crtc);
 	DRM_DEBUG_VBL("crtc%d\n", crtc->base.id);
 	SDE_EVT32_VERBOSE(DRMID(crtc));
@@ -3358,6 +3465,7 @@ static void sde_crtc_atomic_begin(struct drm_crtc *crtc,
 
 	sde_crtc = to_sde_crtc(crtc);
 	dev = crtc->dev;
+	sde_crtc->lat.begin_time = ktime_get();
 
 	if (!sde_crtc->num_mixers) {
 		_sde_crtc_setup_mixers(crtc);
@@ -3430,6 +3538,25 @@ static void sde_crtc_atomic_begin(struct drm_crtc *crtc,
 	SDE_ATRACE_END("crtc_atomic_begin");
 }
 
+/*
+ * Track buffer reuse of the staged planes, the frame is static once all of
+ * them fetched unchanged content for static_cache_frames frames.
+ */
+static bool _sde_crtc_detect_static_frame(struct drm_crtc *crtc)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct drm_plane *plane;
+	u32 frames = U32_MAX;
+
+	drm_atomic_crtc_for_each_plane(plane, crtc)
+		frames = min(frames, sde_plane_update_static_frames(plane));
+
+	sde_crtc->static_frames = (frames == U32_MAX) ? 0 : frames;
+
+	return sde_crtc->static_cache_frames &&
+		sde_crtc->static_frames >= sde_crtc->static_cache_frames;
+}
+
 static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 		struct drm_crtc_state *old_crtc_state)
 {
@@ -3440,6 +3567,7 @@ static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 	struct msm_drm_private *priv;
 	struct sde_crtc_state *cstate;
 	struct sde_kms *sde_kms;
+	bool static_frame;
 	int i;
 
 	if (!crtc || !crtc->dev || !crtc->dev->dev_private) {
@@ -3471,12 +3599,26 @@ static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 	dev = crtc->dev;
 	priv = dev->dev_private;
 
+	static_frame = _sde_crtc_detect_static_frame(crtc);
+
 	if ((sde_crtc->cache_state == CACHE_STATE_PRE_CACHE) &&
-			sde_crtc_get_property(cstate, CRTC_PROP_CACHE_STATE))
+			sde_crtc_get_property(cstate, CRTC_PROP_CACHE_STATE)) {
 		sde_crtc_static_img_control(crtc, CACHE_STATE_FRAME_WRITE,
 				false);
-	else
+	} else if (static_frame) {
+		/*
+		 * Write this frame to the cache and read it from the next one
+		 * on, transitions that don't apply to the current state are
+		 * ignored.
+		 */
+		SDE_EVT32(DRMID(crtc), sde_crtc->cache_state,
+				sde_crtc->static_frames);
+		sde_crtc_static_img_control(crtc, CACHE_STATE_PRE_CACHE, false);
+		sde_crtc_static_img_control(crtc, CACHE_STATE_FRAME_WRITE,
+				false);
+	} else {
 		sde_crtc_static_img_control(crtc, CACHE_STATE_NORMAL, false);
+	}
 
 	/*
 	 * If no mixers has been allocated in sde_crtc_atomic_check(),
@@ -3888,6 +4030,7 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 		sde_encoder_kickoff(encoder, false, true);
 	}
 	sde_crtc->kickoff_in_progress = false;
+	_sde_crtc_lat_kickoff(sde_crtc);
 
 	/* store the event after frame trigger */
 	if (sde_crtc->event) {
@@ -4326,6 +4469,7 @@ static void sde_crtc_disable(struct drm_crtc *crtc)
 					ktime_get());
 	}
 
+	_sde_crtc_lat_reset_pending(sde_crtc);
 	_sde_crtc_reset(crtc);
 	sde_cp_crtc_disable(crtc);
 
@@ -5112,6 +5256,7 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 	struct sde_multirect_plane_states *multirect_plane = NULL;
 	struct drm_connector *conn;
 	struct drm_connector_list_iter conn_iter;
+	ktime_t check_start = 0;
 
 	if (!crtc) {
 		SDE_ERROR("invalid crtc\n");
@@ -5128,6 +5273,8 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 		goto end;
 	}
 
+	check_start = ktime_get();
+
 	pstates = kcalloc(SDE_PSTATES_MAX,
 			sizeof(struct plane_state), GFP_KERNEL);
 
@@ -5204,6 +5351,10 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 end:
 	kfree(pstates);
 	kfree(multirect_plane);
+
+	if (check_start)
+		_sde_crtc_lat_sample(sde_crtc, SDE_CRTC_LAT_ATOMIC_CHECK,
+				check_start);
 	return rc;
 }
 
@@ -6367,6 +6518,75 @@ static int _sde_debugfs_fence_status(struct inode *inode, struct file *file)
 				inode->i_private);
 }
 
+static const char * const sde_crtc_lat_names[SDE_CRTC_LAT_MAX] = {
+	[SDE_CRTC_LAT_ATOMIC_CHECK] = "atomic_check",
+	[SDE_CRTC_LAT_COMMIT_KICKOFF] = "commit_to_kickoff",
+	[SDE_CRTC_LAT_KICKOFF_VSYNC] = "kickoff_to_vsync",
+	[SDE_CRTC_LAT_RETIRE] = "kickoff_to_retire",
+};
+
+static int _sde_debugfs_latency_show(struct seq_file *s, void *data)
+{
+	struct sde_crtc *sde_crtc = s->private;
+	struct sde_crtc_lat_hist *hist;
+	unsigned long flags;
+	u32 n;
+	int i, j;
+
+	hist = kmalloc(sizeof(sde_crtc->lat.hist), GFP_KERNEL);
+	if (!hist)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&sde_crtc->lat.lock, flags);
+	memcpy(hist, sde_crtc->lat.hist, sizeof(sde_crtc->lat.hist));
+	spin_unlock_irqrestore(&sde_crtc->lat.lock, flags);
+
+	for (i = 0; i < SDE_CRTC_LAT_MAX; i++) {
+		seq_printf(s, "%s: count:%u min:%u avg:%llu max:%u us\n",
+			sde_crtc_lat_names[i], hist[i].count, hist[i].min_us,
+			hist[i].count ?
+			div_u64(hist[i].total_us, hist[i].count) : 0,
+			hist[i].max_us);
+
+		for (j = 0; j < SDE_CRTC_LAT_BUCKETS; j++) {
+			n = hist[i].buckets[j];
+			if (!n)
+				continue;
+
+			if (j == SDE_CRTC_LAT_BUCKETS - 1)
+				seq_printf(s, "\t>=%u us: %u\n",
+					j * SDE_CRTC_LAT_BUCKET_US, n);
+			else
+				seq_printf(s, "\t%u-%u us: %u\n",
+					j * SDE_CRTC_LAT_BUCKET_US,
+					(j + 1) * SDE_CRTC_LAT_BUCKET_US, n);
+		}
+	}
+
+	kfree(hist);
+	return 0;
+}
+
+static int _sde_debugfs_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, _sde_debugfs_latency_show, inode->i_private);
+}
+
+static ssize_t _sde_debugfs_latency_reset(struct file *file,
+		const char __user *user_buf, size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct sde_crtc *sde_crtc = s->private;
+	unsigned long flags;
+
+	/* any write clears the histograms */
+	spin_lock_irqsave(&sde_crtc->lat.lock, flags);
+	memset(sde_crtc->lat.hist, 0, sizeof(sde_crtc->lat.hist));
+	spin_unlock_irqrestore(&sde_crtc->lat.lock, flags);
+
+	return count;
+}
+
 static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 {
 	struct sde_crtc *sde_crtc;
@@ -6391,6 +6611,13 @@ static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 		.open =		_sde_debugfs_fence_status,
 		.read =		seq_read,
 	};
+	static const struct file_operations debugfs_latency_fops = {
+		.open =		_sde_debugfs_latency_open,
+		.read =		seq_read,
+		.write =	_sde_debugfs_latency_reset,
+		.llseek =	seq_lseek,
+		.release =	single_release,
+	};
 
 	if (!crtc)
 		return -EINVAL;
@@ -6419,6 +6646,12 @@ static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 					sde_crtc, &debugfs_fps_fops);
 	debugfs_create_file("fence_status", 0400, sde_crtc->debugfs_root,
 					sde_crtc, &debugfs_fence_fops);
+	debugfs_create_file("latency", 0600, sde_crtc->debugfs_root,
+					sde_crtc, &debugfs_latency_fops);
+	debugfs_create_u32("static_cache_frames", 0600, sde_crtc->debugfs_root,
+					&sde_crtc->static_cache_frames);
+	debugfs_create_bool("early_release", 0600, sde_crtc->debugfs_root,
+					&sde_crtc->early_release);
 
 	return 0;
 }
@@ -6756,6 +6989,7 @@ struct drm_crtc *sde_crtc_init(struct drm_device *dev, struct drm_plane *plane)
 	mutex_init(&sde_crtc->crtc_lock);
 	spin_lock_init(&sde_crtc->spin_lock);
 	spin_lock_init(&sde_crtc->fevent_spin_lock);
+	spin_lock_init(&sde_crtc->lat.lock);
 	atomic_set(&sde_crtc->frame_pending, 0);
 
 	sde_crtc->enabled = false;
@@ -217,6 +217,65 @@ struct sde_crtc_misr_info {
 	u32 misr_frame_count;
 };
 
+/**
+ * enum sde_crtc_lat_stage - commit pipeline stages with a latency histogram
+ * @SDE_CRTC_LAT_ATOMIC_CHECK: time spent in the crtc atomic check
+ * @SDE_CRTC_LAT_COMMIT_KICKOFF: crtc atomic begin to encoder kickoff
+ * @SDE_CRTC_LAT_KICKOFF_VSYNC: encoder kickoff to the next vblank
+ * @SDE_CRTC_LAT_RETIRE: encoder kickoff to the retire fence signal
+ * @SDE_CRTC_LAT_MAX: number of stages
+ */
+enum sde_crtc_lat_stage {
+	SDE_CRTC_LAT_ATOMIC_CHECK,
+	SDE_CRTC_LAT_COMMIT_KICKOFF,
+	SDE_CRTC_LAT_KICKOFF_VSYNC,
+	SDE_CRTC_LAT_RETIRE,
+	SDE_CRTC_LAT_MAX,
+};
+
+/* Latency histogram bucket width, the last bucket collects all outliers */
+#define SDE_CRTC_LAT_BUCKET_US	500
+#define SDE_CRTC_LAT_BUCKETS	34
+
+/* Kickoffs that can wait for their retire fence at the same time */
+#define SDE_CRTC_LAT_PENDING	4
+
+/**
+ * struct sde_crtc_lat_hist - latency histogram of one commit stage
+ * @buckets	: sample count of each SDE_CRTC_LAT_BUCKET_US wide bucket
+ * @count	: total number of samples
+ * @total_us	: sum of all samples in microseconds
+ * @min_us	: smallest sample in microseconds
+ * @max_us	: largest sample in microseconds
+ */
+struct sde_crtc_lat_hist {
+	u32 buckets[SDE_CRTC_LAT_BUCKETS];
+	u32 count;
+	u64 total_us;
+	u32 min_us;
+	u32 max_us;
+};
+
+/**
+ * struct sde_crtc_lat_info - commit pipeline latency statistics
+ * @lock	: protects the structure, samples are taken in irq context
+ * @hist	: histogram of each stage in enum sde_crtc_lat_stage
+ * @begin_time	: ktime of the last atomic begin, 0 once kicked off
+ * @kickoff_time: ktime of the last kickoff, 0 once a vblank was seen
+ * @retire_time	: ktimes of the kickoffs waiting for their retire fence
+ * @retire_head	: index of the next kickoff to add to @retire_time
+ * @retire_tail	: index of the oldest kickoff in @retire_time
+ */
+struct sde_crtc_lat_info {
+	spinlock_t lock;
+	struct sde_crtc_lat_hist hist[SDE_CRTC_LAT_MAX];
+	ktime_t begin_time;
+	ktime_t kickoff_time;
+	ktime_t retire_time[SDE_CRTC_LAT_PENDING];
+	u32 retire_head;
+	u32 retire_tail;
+};
+
 /*
  * Maximum number of free event structures to cache
  */
@@ -280,6 +339,7 @@ struct sde_crtc_misr_info {
  * @idle_notify_work: delayed worker to notify idle timeout to user space
  * @power_event   : registered power event handle
  * @cur_perf      : current performance committed to clock/bandwidth driver
+ * @perf_hist     : recent performance requests for the predictive vote
  * @plane_mask_old: keeps track of the planes used in the previous commit
  * @frame_trigger_mode: frame trigger mode
  * @cp_pu_feature_mask: mask indicating cp feature enable for partial update
@@ -297,8 +357,15 @@ struct sde_crtc_misr_info {
  * @target_bpp      : target bpp used to calculate compression ratio
  * @static_cache_read_work: delayed worker to transition cache state to read
  * @cache_state     : Current static image cache state
+ * @static_cache_frames: frames all planes must reuse their buffers for
+ *                    before the static image cache is used without an
+ *                    idle notification, 0 to disable
+ * @static_frames   : consecutive frames all planes reused their buffers
+ * @early_release   : signal release fences from the frame event interrupt
+ *                    instead of from the event thread
  * @dspp_blob_info  : blob containing dspp hw capability information
  * @cached_encoder_mask : cached encoder_mask for vblank work
+ * @lat             : commit pipeline latency histograms
  */
 struct sde_crtc {
 	struct drm_crtc base;
@@ -366,6 +433,7 @@ struct sde_crtc {
 
 	struct sde_core_perf_params cur_perf;
 	struct sde_core_perf_params new_perf;
+	struct sde_core_perf_history perf_hist;
 
 	u32 plane_mask_old;
 
@@ -392,9 +460,13 @@ struct sde_crtc {
 
 	struct kthread_delayed_work static_cache_read_work;
 	enum sde_crtc_cache_state cache_state;
+	u32 static_cache_frames;
+	u32 static_frames;
+	bool early_release;
 
 	struct drm_property_blob *dspp_blob_info;
 	u32 cached_encoder_mask;
+	struct sde_crtc_lat_info lat;
 };
 
 enum sde_crtc_dirty_flags {
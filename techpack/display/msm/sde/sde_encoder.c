@@ -3058,6 +3058,9 @@ void sde_encoder_perf_uidle_status(struct sde_kms *sde_kms,
 	struct sde_hw_uidle *uidle;
 	struct sde_uidle_cntr cntr;
 	struct sde_uidle_status status;
+	bool has_status = false;
+	bool tune;
+	u32 mode;
 
 	if (!sde_kms || !crtc || !sde_kms->hw_uidle) {
 		pr_err("invalid params %d %d\n",
@@ -3070,37 +3073,44 @@ void sde_encoder_perf_uidle_status(struct sde_kms *sde_kms,
 		return;
 
 	uidle = sde_kms->hw_uidle;
-	if ((sde_kms->catalog->uidle_cfg.debugfs_perf & SDE_PERF_UIDLE_STATUS)
+	mode = sde_kms->catalog->uidle_cfg.debugfs_perf;
+	tune = READ_ONCE(sde_kms->perf.uidle_auto_threshold);
+	if (((mode & SDE_PERF_UIDLE_STATUS) || tune)
 			&& uidle->ops.uidle_get_status) {
 
 		uidle->ops.uidle_get_status(uidle, &status);
-		trace_sde_perf_uidle_status(
-			crtc->base.id,
-			status.uidle_danger_status_0,
-			status.uidle_danger_status_1,
-			status.uidle_safe_status_0,
-			status.uidle_safe_status_1,
-			status.uidle_idle_status_0,
-			status.uidle_idle_status_1,
-			status.uidle_fal_status_0,
-			status.uidle_fal_status_1,
-			status.uidle_status,
-			status.uidle_en_fal10);
-	}
-
-	if ((sde_kms->catalog->uidle_cfg.debugfs_perf & SDE_PERF_UIDLE_CNT)
+		has_status = true;
+		if (mode & SDE_PERF_UIDLE_STATUS)
+			trace_sde_perf_uidle_status(
+				crtc->base.id,
+				status.uidle_danger_status_0,
+				status.uidle_danger_status_1,
+				status.uidle_safe_status_0,
+				status.uidle_safe_status_1,
+				status.uidle_idle_status_0,
+				status.uidle_idle_status_1,
+				status.uidle_fal_status_0,
+				status.uidle_fal_status_1,
+				status.uidle_status,
+				status.uidle_en_fal10);
+	}
+
+	if (((mode & SDE_PERF_UIDLE_CNT) || tune)
 			&& uidle->ops.uidle_get_cntr) {
 
 		uidle->ops.uidle_get_cntr(uidle, &cntr);
-		trace_sde_perf_uidle_cntr(
-			crtc->base.id,
-			cntr.fal1_gate_cntr,
-			cntr.fal10_gate_cntr,
-			cntr.fal_wait_gate_cntr,
-			cntr.fal1_num_transitions_cntr,
-			cntr.fal10_num_transitions_cntr,
-			cntr.min_gate_cntr,
-			cntr.max_gate_cntr);
+		sde_core_perf_uidle_sample(&sde_kms->perf, &cntr,
+			has_status ? &status : NULL);
+		if (mode & SDE_PERF_UIDLE_CNT)
+			trace_sde_perf_uidle_cntr(
+				crtc->base.id,
+				cntr.fal1_gate_cntr,
+				cntr.fal10_gate_cntr,
+				cntr.fal_wait_gate_cntr,
+				cntr.fal1_num_transitions_cntr,
+				cntr.fal10_num_transitions_cntr,
+				cntr.min_gate_cntr,
+				cntr.max_gate_cntr);
 	}
 }
 
@@ -3122,7 +3132,7 @@ static void sde_encoder_vblank_callback(struct drm_encoder *drm_enc,
 	spin_unlock_irqrestore(&sde_enc->enc_spinlock, lock_flags);
 
 	if (phy_enc->sde_kms &&
-			phy_enc->sde_kms->catalog->uidle_cfg.debugfs_perf)
+			sde_core_perf_uidle_sampling(&phy_enc->sde_kms->perf))
 		sde_encoder_perf_uidle_status(phy_enc->sde_kms, sde_enc->crtc);
 
 	atomic_inc(&phy_enc->vsync_cnt);
@@ -1039,6 +1039,31 @@ static void _sde_encoder_phys_wb_update_flush(struct sde_encoder_phys *phys_enc)
 			hw_wb->idx - WB_0);
 }
 
+/**
+ * _sde_encoder_phys_wb_stream_fb - pick the output of streaming writeback
+ * @phys_enc:	Pointer to physical encoder
+ * @fb:		Output framebuffer of the current atomic state
+ * Returns:	Framebuffer to write in this frame
+ */
+static struct drm_framebuffer *_sde_encoder_phys_wb_stream_fb(
+		struct sde_encoder_phys *phys_enc, struct drm_framebuffer *fb)
+{
+	struct sde_encoder_phys_wb *wb_enc = to_sde_encoder_phys_wb(phys_enc);
+	u32 fb_mode;
+
+	if (!fb || !phys_enc->connector)
+		return fb;
+
+	/* secure buffers are not kept mapped across frames */
+	fb_mode = sde_connector_get_property(phys_enc->connector->state,
+			CONNECTOR_PROP_FB_TRANSLATION_MODE);
+	if (fb_mode == SDE_DRM_FB_SEC)
+		return fb;
+
+	return sde_wb_stream_get_fb(wb_enc->wb_dev, fb,
+			wb_enc->aspace[SDE_IOMMU_DOMAIN_UNSECURE]);
+}
+
 /**
  * sde_encoder_phys_wb_setup - setup writeback encoder
  * @phys_enc:	Pointer to physical encoder
@@ -1069,6 +1094,7 @@ static void sde_encoder_phys_wb_setup(
 	} else {
 		fb = sde_wb_get_output_fb(wb_enc->wb_dev);
 		sde_wb_get_output_roi(wb_enc->wb_dev, wb_roi);
+		fb = _sde_encoder_phys_wb_stream_fb(phys_enc, fb);
 	}
 
 	if (!fb) {
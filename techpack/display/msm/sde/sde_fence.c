@@ -178,6 +178,26 @@ static struct dma_fence_ops sde_fence_ops = {
 	.timeline_value_str = sde_fence_timeline_value_str,
 };
 
+/*
+ * Keep the list sorted by timeline value, so a trigger can stop at the
+ * first fence which is not signaled yet. Fences are created in timeline
+ * order except for different offsets, so search from the tail.
+ */
+static void _sde_fence_list_add(struct sde_fence_context *ctx,
+		struct sde_fence *sde_fence)
+{
+	struct sde_fence *fc;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	list_for_each_entry_reverse(fc, &ctx->fence_list_head, fence_list) {
+		if ((int)(fc->base.seqno - sde_fence->base.seqno) <= 0)
+			break;
+	}
+	list_add(&sde_fence->fence_list, &fc->fence_list);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
 /**
  * _sde_fence_create_fd - create fence object and return an fd for it
  * This function is NOT thread-safe.
@@ -230,9 +250,7 @@ static int _sde_fence_create_fd(void *fence_ctx, uint32_t val)
 	fd_install(fd, sync_file->file);
 	sde_fence->fd = fd;
 
-	spin_lock(&ctx->list_lock);
-	list_add_tail(&sde_fence->fence_list, &ctx->fence_list_head);
-	spin_unlock(&ctx->list_lock);
+	_sde_fence_list_add(ctx, sde_fence);
 
 exit:
 	return fd;
@@ -260,7 +278,6 @@ struct sde_fence_context *sde_fence_init(const char *name, uint32_t drm_id)
 	ctx->context = dma_fence_context_alloc(1);
 
 	spin_lock_init(&ctx->lock);
-	spin_lock_init(&ctx->list_lock);
 	INIT_LIST_HEAD(&ctx->fence_list_head);
 
 	return ctx;
@@ -293,30 +310,42 @@ static void _sde_fence_trigger(struct sde_fence_context *ctx, bool error)
 {
 	unsigned long flags;
 	struct sde_fence *fc, *next;
-	bool is_signaled = false;
+	LIST_HEAD(signaled);
+	u32 count = 0;
 
 	kref_get(&ctx->kref);
 
-	spin_lock(&ctx->list_lock);
-	if (list_empty(&ctx->fence_list_head)) {
-		SDE_DEBUG("nothing to trigger!\n");
-		goto end;
-	}
-
+	/* signal the whole batch with one hold of the timeline lock */
+	spin_lock_irqsave(&ctx->lock, flags);
 	list_for_each_entry_safe(fc, next, &ctx->fence_list_head, fence_list) {
-		spin_lock_irqsave(&ctx->lock, flags);
-		if (error)
+		/* errors are flagged on all pending fences of the timeline */
+		if (error && !test_bit(DMA_FENCE_FLAG_SIGNALED_BIT,
+				&fc->base.flags))
 			dma_fence_set_error(&fc->base, -EBUSY);
-		is_signaled = dma_fence_is_signaled_locked(&fc->base);
-		spin_unlock_irqrestore(&ctx->lock, flags);
 
-		if (is_signaled) {
-			list_del_init(&fc->fence_list);
-			dma_fence_put(&fc->base);
+		if (!dma_fence_is_signaled_locked(&fc->base)) {
+			if (error)
+				continue;
+			break;
 		}
+
+		list_move_tail(&fc->fence_list, &signaled);
+		count++;
+	}
+
+	ctx->signal_count += count;
+	ctx->max_batch = max(ctx->max_batch, count);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	if (!count)
+		SDE_DEBUG("nothing to trigger!\n");
+
+	/* drop the list references outside of the lock */
+	list_for_each_entry_safe(fc, next, &signaled, fence_list) {
+		list_del_init(&fc->fence_list);
+		dma_fence_put(&fc->base);
 	}
-end:
-	spin_unlock(&ctx->list_lock);
+
 	kref_put(&ctx->kref, sde_fence_destroy);
 }
 
@@ -449,6 +478,7 @@ void sde_debugfs_timeline_dump(struct sde_fence_context *ctx,
 	char *obj_name;
 	struct sde_fence *fc, *next;
 	struct dma_fence *fence;
+	unsigned long flags;
 
 	if (!ctx || !drm_obj) {
 		SDE_ERROR("invalid input params\n");
@@ -471,10 +501,13 @@ void sde_debugfs_timeline_dump(struct sde_fence_context *ctx,
 		obj_name, drm_obj->id, drm_obj->type, ctx->done_count,
 		ctx->commit_count);
 
-	spin_lock(&ctx->list_lock);
+	spin_lock_irqsave(&ctx->lock, flags);
+	seq_printf(*s, "signal_count:%llu max_batch:%u\n",
+		ctx->signal_count, ctx->max_batch);
+
 	list_for_each_entry_safe(fc, next, &ctx->fence_list_head, fence_list) {
 		fence = &fc->base;
 		sde_fence_list_dump(fence, s);
 	}
-	spin_unlock(&ctx->list_lock);
+	spin_unlock_irqrestore(&ctx->lock, flags);
 }
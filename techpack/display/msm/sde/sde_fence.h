@@ -22,10 +22,12 @@
  * @done_count: Number of completed commits since bootup
  * @drm_id: ID number of owning DRM Object
  * @ref: kref counter on timeline
- * @lock: spinlock for fence counter protection
- * @list_lock: spinlock for timeline protection
+ * @lock: spinlock for fence counter and fence list protection
  * @context: fence context
- * @list_head: fence list to hold all the fence created on this context
+ * @list_head: fence list to hold all the fence created on this context,
+ *	sorted by the timeline value the fences signal at
+ * @signal_count: number of fences signaled on this timeline
+ * @max_batch: highest number of fences signaled by a single trigger
  * @name: name of fence context/timeline
  */
 struct sde_fence_context {
@@ -34,9 +36,10 @@ struct sde_fence_context {
 	uint32_t drm_id;
 	struct kref kref;
 	spinlock_t lock;
-	spinlock_t list_lock;
 	u64 context;
 	struct list_head fence_list_head;
+	u64 signal_count;
+	u32 max_batch;
 	char name[SDE_FENCE_NAME_SIZE];
 };
 
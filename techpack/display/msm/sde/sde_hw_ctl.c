@@ -768,6 +768,7 @@ static int sde_hw_ctl_reset_control(struct sde_hw_ctl *ctx)
 	c = &ctx->hw;
 	pr_debug("issuing hw ctl reset for ctl:%d\n", ctx->idx);
 	SDE_REG_WRITE(c, CTL_SW_RESET, 0x1);
+	sde_hw_reg_shadow_invalidate_all();
 	if (sde_hw_ctl_poll_reset_status(ctx, SDE_REG_RESET_TIMEOUT_US))
 		return -EINVAL;
 
@@ -785,6 +786,7 @@ static void sde_hw_ctl_hard_reset(struct sde_hw_ctl *ctx, bool enable)
 	pr_debug("hw ctl hard reset for ctl:%d, %d\n",
 			ctx->idx - CTL_0, enable);
 	SDE_REG_WRITE(c, CTL_SW_RESET_OVERRIDE, enable);
+	sde_hw_reg_shadow_invalidate_all();
 }
 
 static int sde_hw_ctl_wait_reset_status(struct sde_hw_ctl *ctx)
@@ -822,10 +824,10 @@ static void sde_hw_ctl_clear_all_blendstages(struct sde_hw_ctl *ctx)
 	for (i = 0; i < ctx->mixer_count; i++) {
 		int mixer_id = ctx->mixer_hw_caps[i].id;
 
-		SDE_REG_WRITE(c, CTL_LAYER(mixer_id), 0);
-		SDE_REG_WRITE(c, CTL_LAYER_EXT(mixer_id), 0);
-		SDE_REG_WRITE(c, CTL_LAYER_EXT2(mixer_id), 0);
-		SDE_REG_WRITE(c, CTL_LAYER_EXT3(mixer_id), 0);
+		SDE_REG_WRITE_DELTA(c, CTL_LAYER(mixer_id), 0);
+		SDE_REG_WRITE_DELTA(c, CTL_LAYER_EXT(mixer_id), 0);
+		SDE_REG_WRITE_DELTA(c, CTL_LAYER_EXT2(mixer_id), 0);
+		SDE_REG_WRITE_DELTA(c, CTL_LAYER_EXT3(mixer_id), 0);
 	}
 	SDE_REG_WRITE(c, CTL_FETCH_PIPE_ACTIVE, 0);
 }
@@ -970,10 +972,10 @@ static void sde_hw_ctl_setup_blendstage(struct sde_hw_ctl *ctx,
 			(stage_cfg && !stage_cfg->stage[0][0])))
 		cfg.cfg |= CTL_MIXER_BORDER_OUT;
 
-	SDE_REG_WRITE(c, CTL_LAYER(lm), cfg.cfg);
-	SDE_REG_WRITE(c, CTL_LAYER_EXT(lm), cfg.ext);
-	SDE_REG_WRITE(c, CTL_LAYER_EXT2(lm), cfg.ext2);
-	SDE_REG_WRITE(c, CTL_LAYER_EXT3(lm), cfg.ext3);
+	SDE_REG_WRITE_DELTA(c, CTL_LAYER(lm), cfg.cfg);
+	SDE_REG_WRITE_DELTA(c, CTL_LAYER_EXT(lm), cfg.ext);
+	SDE_REG_WRITE_DELTA(c, CTL_LAYER_EXT2(lm), cfg.ext2);
+	SDE_REG_WRITE_DELTA(c, CTL_LAYER_EXT3(lm), cfg.ext3);
 }
 
 static u32 sde_hw_ctl_get_staged_sspp(struct sde_hw_ctl *ctx, enum sde_lm lm,
@@ -1436,6 +1438,10 @@ struct sde_hw_ctl *sde_hw_ctl_init(enum sde_ctl idx,
 	sde_dbg_reg_register_dump_range(SDE_DBG_NAME, cfg->name, c->hw.blk_off,
 			c->hw.blk_off + c->hw.length, c->hw.xin_id);
 
+	/* only the layer mixing registers are programmed through the shadow */
+	if (sde_hw_reg_shadow_init(&c->hw))
+		SDE_DEBUG("no register shadow for ctl %d\n", idx - CTL_0);
+
 	return c;
 
 blk_init_error:
@@ -1446,7 +1452,9 @@ struct sde_hw_ctl *sde_hw_ctl_init(enum sde_ctl idx,
 
 void sde_hw_ctl_destroy(struct sde_hw_ctl *ctx)
 {
-	if (ctx)
+	if (ctx) {
 		sde_hw_blk_destroy(&ctx->base);
+		sde_hw_reg_shadow_destroy(&ctx->hw);
+	}
 	kfree(ctx);
 }
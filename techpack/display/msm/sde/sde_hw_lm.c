@@ -84,14 +84,14 @@ static void sde_hw_lm_setup_out(struct sde_hw_mixer *ctx,
 	op_mode = SDE_REG_READ(c, LM_OP_MODE);
 
 	outsize = mixer->out_height << 16 | mixer->out_width;
-	SDE_REG_WRITE(c, LM_OUT_SIZE, outsize);
+	SDE_REG_WRITE_DELTA(c, LM_OUT_SIZE, outsize);
 
 	/* SPLIT_LEFT_RIGHT */
 	if (mixer->right_mixer)
 		op_mode |= BIT(31);
 	else
 		op_mode &= ~BIT(31);
-	SDE_REG_WRITE(c, LM_OP_MODE, op_mode);
+	SDE_REG_WRITE_DELTA(c, LM_OP_MODE, op_mode);
 }
 
 static void sde_hw_lm_setup_border_color(struct sde_hw_mixer *ctx,
@@ -101,10 +101,10 @@ static void sde_hw_lm_setup_border_color(struct sde_hw_mixer *ctx,
 	struct sde_hw_blk_reg_map *c = &ctx->hw;
 
 	if (border_en) {
-		SDE_REG_WRITE(c, LM_BORDER_COLOR_0,
+		SDE_REG_WRITE_DELTA(c, LM_BORDER_COLOR_0,
 			(color->color_0 & 0xFFF) |
 			((color->color_1 & 0xFFF) << 0x10));
-		SDE_REG_WRITE(c, LM_BORDER_COLOR_1,
+		SDE_REG_WRITE_DELTA(c, LM_BORDER_COLOR_1,
 			(color->color_2 & 0xFFF) |
 			((color->color_3 & 0xFFF) << 0x10));
 	}
@@ -126,8 +126,8 @@ static void sde_hw_lm_setup_blend_config_combined_alpha(
 		return;
 
 	const_alpha = (bg_alpha & 0xFF) | ((fg_alpha & 0xFF) << 16);
-	SDE_REG_WRITE(c, LM_BLEND0_CONST_ALPHA + stage_off, const_alpha);
-	SDE_REG_WRITE(c, LM_BLEND0_OP + stage_off, blend_op);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_CONST_ALPHA + stage_off, const_alpha);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_OP + stage_off, blend_op);
 }
 
 static void sde_hw_lm_setup_blend_config(struct sde_hw_mixer *ctx,
@@ -143,9 +143,9 @@ static void sde_hw_lm_setup_blend_config(struct sde_hw_mixer *ctx,
 	if (WARN_ON(stage_off < 0))
 		return;
 
-	SDE_REG_WRITE(c, LM_BLEND0_FG_ALPHA + stage_off, fg_alpha);
-	SDE_REG_WRITE(c, LM_BLEND0_BG_ALPHA + stage_off, bg_alpha);
-	SDE_REG_WRITE(c, LM_BLEND0_OP + stage_off, blend_op);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_FG_ALPHA + stage_off, fg_alpha);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_BG_ALPHA + stage_off, bg_alpha);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_OP + stage_off, blend_op);
 }
 
 static void sde_hw_lm_setup_color3(struct sde_hw_mixer *ctx,
@@ -159,7 +159,7 @@ static void sde_hw_lm_setup_color3(struct sde_hw_mixer *ctx,
 
 	op_mode = (op_mode & (BIT(31) | BIT(30))) | mixer_op_mode;
 
-	SDE_REG_WRITE(c, LM_OP_MODE, op_mode);
+	SDE_REG_WRITE_DELTA(c, LM_OP_MODE, op_mode);
 }
 
 static void sde_hw_lm_gc(struct sde_hw_mixer *mixer,
@@ -186,7 +186,7 @@ static void sde_hw_lm_clear_dim_layer(struct sde_hw_mixer *ctx)
 		 */
 		val = SDE_REG_READ(c, LM_BLEND0_OP + stage_off);
 		val &= reset;
-		SDE_REG_WRITE(c, LM_BLEND0_OP + stage_off, val);
+		SDE_REG_WRITE_DELTA(c, LM_BLEND0_OP + stage_off, val);
 	}
 }
 
@@ -209,17 +209,17 @@ static void sde_hw_lm_setup_dim_layer(struct sde_hw_mixer *ctx,
 	alpha = dim_layer->color_fill.color_3 & 0xFF;
 	val = ((dim_layer->color_fill.color_1 << 2) & 0xFFF) << 16 |
 			((dim_layer->color_fill.color_0 << 2) & 0xFFF);
-	SDE_REG_WRITE(c, LM_FG_COLOR_FILL_COLOR_0 + stage_off, val);
+	SDE_REG_WRITE_DELTA(c, LM_FG_COLOR_FILL_COLOR_0 + stage_off, val);
 
 	val = (alpha << 4) << 16 |
 			((dim_layer->color_fill.color_2 << 2) & 0xFFF);
-	SDE_REG_WRITE(c, LM_FG_COLOR_FILL_COLOR_1 + stage_off, val);
+	SDE_REG_WRITE_DELTA(c, LM_FG_COLOR_FILL_COLOR_1 + stage_off, val);
 
 	val = dim_layer->rect.h << 16 | dim_layer->rect.w;
-	SDE_REG_WRITE(c, LM_FG_COLOR_FILL_SIZE + stage_off, val);
+	SDE_REG_WRITE_DELTA(c, LM_FG_COLOR_FILL_SIZE + stage_off, val);
 
 	val = dim_layer->rect.y << 16 | dim_layer->rect.x;
-	SDE_REG_WRITE(c, LM_FG_COLOR_FILL_XY + stage_off, val);
+	SDE_REG_WRITE_DELTA(c, LM_FG_COLOR_FILL_XY + stage_off, val);
 
 	val = BIT(16); /* enable dim layer */
 	val |= SDE_BLEND_FG_ALPHA_FG_CONST | SDE_BLEND_BG_ALPHA_BG_CONST;
@@ -227,9 +227,9 @@ static void sde_hw_lm_setup_dim_layer(struct sde_hw_mixer *ctx,
 		val |= BIT(17);
 	else
 		val &= ~BIT(17);
-	SDE_REG_WRITE(c, LM_BLEND0_OP + stage_off, val);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_OP + stage_off, val);
 	val = (alpha << 16) | (0xff - alpha);
-	SDE_REG_WRITE(c, LM_BLEND0_CONST_ALPHA + stage_off, val);
+	SDE_REG_WRITE_DELTA(c, LM_BLEND0_CONST_ALPHA + stage_off, val);
 }
 
 static void sde_hw_lm_setup_misr(struct sde_hw_mixer *ctx,
@@ -338,6 +338,10 @@ struct sde_hw_mixer *sde_hw_lm_init(enum sde_lm idx,
 	sde_dbg_reg_register_dump_range(SDE_DBG_NAME, cfg->name, c->hw.blk_off,
 			c->hw.blk_off + c->hw.length, c->hw.xin_id);
 
+	/* blend setup is mostly unchanged between commits, skip rewrites */
+	if (sde_hw_reg_shadow_init(&c->hw))
+		SDE_DEBUG("no register shadow for lm %d\n", idx - LM_0);
+
 	return c;
 
 blk_init_error:
@@ -348,7 +352,9 @@ struct sde_hw_mixer *sde_hw_lm_init(enum sde_lm idx,
 
 void sde_hw_lm_destroy(struct sde_hw_mixer *lm)
 {
-	if (lm)
+	if (lm) {
 		sde_hw_blk_destroy(&lm->base);
+		sde_hw_reg_shadow_destroy(&lm->hw);
+	}
 	kfree(lm);
 }
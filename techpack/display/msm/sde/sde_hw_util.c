@@ -13,6 +13,9 @@
 /* using a file static variables for debugfs access */
 static u32 sde_hw_util_log_mask = SDE_DBG_MASK_NONE;
 
+/* bumped to invalidate all register shadows at once */
+static atomic_t sde_hw_reg_shadow_gen = ATOMIC_INIT(1);
+
 /* SDE_SCALER_QSEED3 */
 #define QSEED3_HW_VERSION                  0x00
 #define QSEED3_OP_MODE                     0x04
@@ -68,7 +71,7 @@ static u32 sde_hw_util_log_mask = SDE_DBG_MASK_NONE;
 typedef void (*scaler_lut_type)(struct sde_hw_blk_reg_map *,
 		struct sde_hw_scaler3_cfg *, u32);
 
-void sde_reg_write(struct sde_hw_blk_reg_map *c,
+static void _sde_reg_write(struct sde_hw_blk_reg_map *c,
 		u32 reg_off,
 		u32 val,
 		const char *name)
@@ -82,6 +85,93 @@ void sde_reg_write(struct sde_hw_blk_reg_map *c,
 	SDE_REG_LOG(GET_REG_BLK_ID(c), val, c->blk_off + reg_off);
 }
 
+void sde_reg_write(struct sde_hw_blk_reg_map *c,
+		u32 reg_off,
+		u32 val,
+		const char *name)
+{
+	u32 idx = reg_off >> 2;
+
+	/* plain writes take the register out of the shadow */
+	if (c->shadow && idx < c->shadow->count)
+		__clear_bit(idx, c->shadow->valid);
+
+	_sde_reg_write(c, reg_off, val, name);
+}
+
+void sde_reg_write_delta(struct sde_hw_blk_reg_map *c,
+		u32 reg_off,
+		u32 val,
+		const char *name)
+{
+	struct sde_hw_reg_shadow *shadow = c->shadow;
+	u32 idx = reg_off >> 2;
+	u32 gen;
+
+	if (!shadow || idx >= shadow->count) {
+		_sde_reg_write(c, reg_off, val, name);
+		return;
+	}
+
+	gen = atomic_read(&sde_hw_reg_shadow_gen);
+	if (shadow->gen != gen) {
+		bitmap_zero(shadow->valid, shadow->count);
+		shadow->gen = gen;
+	}
+
+	if (test_bit(idx, shadow->valid) && shadow->vals[idx] == val)
+		return;
+
+	_sde_reg_write(c, reg_off, val, name);
+	shadow->vals[idx] = val;
+	__set_bit(idx, shadow->valid);
+}
+
+int sde_hw_reg_shadow_init(struct sde_hw_blk_reg_map *c)
+{
+	struct sde_hw_reg_shadow *shadow;
+	u32 count = c->length >> 2;
+
+	if (!count)
+		return -EINVAL;
+
+	shadow = kzalloc(sizeof(*shadow), GFP_KERNEL);
+	if (!shadow)
+		return -ENOMEM;
+
+	shadow->vals = kcalloc(count, sizeof(*shadow->vals), GFP_KERNEL);
+	shadow->valid = bitmap_zalloc(count, GFP_KERNEL);
+	if (!shadow->vals || !shadow->valid) {
+		kfree(shadow->vals);
+		bitmap_free(shadow->valid);
+		kfree(shadow);
+		return -ENOMEM;
+	}
+
+	shadow->count = count;
+	c->shadow = shadow;
+
+	return 0;
+}
+
+void sde_hw_reg_shadow_destroy(struct sde_hw_blk_reg_map *c)
+{
+	struct sde_hw_reg_shadow *shadow = c->shadow;
+
+	if (!shadow)
+		return;
+
+	c->shadow = NULL;
+	kfree(shadow->vals);
+	bitmap_free(shadow->valid);
+	kfree(shadow);
+}
+
+void sde_hw_reg_shadow_invalidate_all(void)
+{
+	atomic_inc(&sde_hw_reg_shadow_gen);
+}
+
 int sde_reg_read(struct sde_hw_blk_reg_map *c, u32 reg_off)
 {
 	return readl_relaxed(c->base_off + c->blk_off + reg_off);
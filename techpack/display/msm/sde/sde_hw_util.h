@@ -19,6 +19,20 @@
 
 struct sde_format_extended;
 
+/**
+ * struct sde_hw_reg_shadow - last values written to a register block
+ * @vals:  value last written to each register of the block
+ * @valid: bitmap of the registers whose @vals match the hardware
+ * @gen:   shadow generation @valid was built in
+ * @count: number of registers in the block
+ */
+struct sde_hw_reg_shadow {
+	u32 *vals;
+	unsigned long *valid;
+	u32 gen;
+	u32 count;
+};
+
 /*
  * This is the common struct maintained by each sub block
  * for mapping the register offsets in this block to the
@@ -28,6 +42,7 @@ struct sde_format_extended;
  * @length        length of register block offset
  * @xin_id        xin id
  * @hwversion     mdss hw version number
+ * @shadow        optional shadow copy for SDE_REG_WRITE_DELTA
  */
 struct sde_hw_blk_reg_map {
 	void __iomem *base_off;
@@ -36,6 +51,7 @@ struct sde_hw_blk_reg_map {
 	u32 xin_id;
 	u32 hwversion;
 	u32 log_mask;
+	struct sde_hw_reg_shadow *shadow;
 };
 
 /**
@@ -178,7 +194,45 @@ void sde_reg_write(struct sde_hw_blk_reg_map *c,
 		const char *name);
 int sde_reg_read(struct sde_hw_blk_reg_map *c, u32 reg_off);
 
+/**
+ * sde_reg_write_delta - write a register unless it already holds the value
+ * @c: register block, writes go straight to hardware without a shadow
+ * @reg_off: register offset within the block
+ * @val: value to write
+ * @name: register name for logging
+ *
+ * Only meant for double buffered configuration registers that are
+ * programmed every commit with mostly the same values. Trigger and
+ * self clearing registers must keep using SDE_REG_WRITE.
+ */
+void sde_reg_write_delta(struct sde_hw_blk_reg_map *c,
+		u32 reg_off,
+		u32 val,
+		const char *name);
+
+/**
+ * sde_hw_reg_shadow_init - attach a shadow copy to a register block
+ * @c: register block with a valid length
+ * Return: 0 on success, error code otherwise
+ */
+int sde_hw_reg_shadow_init(struct sde_hw_blk_reg_map *c);
+
+/**
+ * sde_hw_reg_shadow_destroy - detach and free the shadow of a register block
+ * @c: register block
+ */
+void sde_hw_reg_shadow_destroy(struct sde_hw_blk_reg_map *c);
+
+/**
+ * sde_hw_reg_shadow_invalidate_all - forget the contents of all shadows
+ *
+ * Must be called whenever the hardware registers may have changed behind
+ * the driver, e.g. after power collapse, block resets or a VM handoff.
+ */
+void sde_hw_reg_shadow_invalidate_all(void);
+
 #define SDE_REG_WRITE(c, off, val) sde_reg_write(c, off, val, #off)
+#define SDE_REG_WRITE_DELTA(c, off, val) sde_reg_write_delta(c, off, val, #off)
 #define SDE_REG_READ(c, off) sde_reg_read(c, off)
 
 #define MISR_FRAME_COUNT_MASK		0xFF
@@ -2909,6 +2909,8 @@ static int sde_kms_check_vm_request(struct msm_kms *kms,
 
 	if ((new_vm_req == VM_REQ_ACQUIRE) && !vm_ops->vm_owns_hw(sde_kms)) {
 		rc = vm_ops->vm_acquire(sde_kms);
+		/* the other VM programmed the hardware in the meantime */
+		sde_hw_reg_shadow_invalidate_all();
 		if (rc) {
 			SDE_ERROR(
 			"VM acquire failed; o_state:%d, n_state:%d, hw_owner:%d, rc:%d\n",
@@ -4321,6 +4323,9 @@ static void sde_kms_handle_power_event(u32 event_type, void *usr)
 		sde_irq_update(msm_kms, true);
 		sde_kms->first_kickoff = true;
 
+		/* register contents are lost across power collapse */
+		sde_hw_reg_shadow_invalidate_all();
+
 		/**
 		 * Rotator sid needs to be programmed since uefi doesn't
 		 * configure it during continuous splash
@@ -217,20 +217,54 @@ struct sde_irq_callback {
 	void *arg;
 };
 
+/*
+ * struct sde_irq_cb_set - RCU published snapshot of one irq_idx's callbacks
+ * @rcu: rcu head used to free a replaced snapshot
+ * @count: number of entries in @cbs
+ * @cbs: registered callbacks, in registration order
+ */
+struct sde_irq_cb_set {
+	struct rcu_head rcu;
+	u32 count;
+	struct sde_irq_callback *cbs[];
+};
+
+/*
+ * struct sde_irq_stats - per irq_idx dispatch statistics
+ * @delay_ns: total time from top level ISR entry to dispatch of this irq_idx
+ * @delay_max_ns: worst case of @delay_ns
+ * @cb_ns: total time spent in the registered callbacks
+ * @cb_max_ns: worst case of @cb_ns
+ */
+struct sde_irq_stats {
+	u64 delay_ns;
+	u64 delay_max_ns;
+	u64 cb_ns;
+	u64 cb_max_ns;
+};
+
 /**
  * struct sde_irq: IRQ structure contains callback registration info
  * @total_irq:    total number of irq_idx obtained from HW interrupts mapping
- * @irq_cb_tbl:   array of IRQ callbacks setting
+ * @irq_cb_tbl:   array of IRQ callbacks setting, writer side under @cb_lock
+ * @cb_sets:      array of RCU snapshots of @irq_cb_tbl walked by the ISR
  * @enable_counts array of IRQ enable counts
- * @cb_lock:      callback lock
+ * @stats:        array of per irq_idx dispatch statistics
+ * @cb_lock:      callback registration lock, not taken by the ISR
+ * @dispatching:  nonzero while the ISR is dispatching callbacks
+ * @entry_ns:     local clock at entry of the current top level ISR
  * @debugfs_file: debugfs file for irq statistics
  */
 struct sde_irq {
 	u32 total_irqs;
 	struct list_head *irq_cb_tbl;
+	struct sde_irq_cb_set __rcu **cb_sets;
 	atomic_t *enable_counts;
 	atomic_t *irq_counts;
+	struct sde_irq_stats *stats;
 	spinlock_t cb_lock;
+	atomic_t dispatching;
+	u64 entry_ns;
 	struct dentry *debugfs_file;
 };
 
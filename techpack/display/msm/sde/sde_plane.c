@@ -21,6 +21,7 @@
 
 #include <linux/debugfs.h>
 #include <linux/dma-buf.h>
+#include <linux/jhash.h>
 #include <drm/sde_drm.h>
 #include <drm/msm_drm_pp.h>
 
@@ -84,6 +85,74 @@ enum sde_plane_qos {
 	SDE_PLANE_QOS_PANIC_CTRL = BIT(2),
 };
 
+/**
+ * struct sde_plane_check_key - inputs of the sspp source/scaler validation
+ * @modifier: framebuffer format modifier
+ * @format: framebuffer fourcc
+ * @fb_width: framebuffer width
+ * @fb_height: framebuffer height
+ * @src: source rectangle, integer pixels
+ * @dst: destination rectangle
+ * @excl_rect: exclusion rectangle
+ * @rotation: plane rotation
+ * @deci_w: horizontal decimation property
+ * @deci_h: vertical decimation property
+ * @src_config: source config property
+ * @rt_client: plane is attached to a real-time crtc
+ * @default_scale: default scaler forced through debugfs
+ * @scaler_check_state: scaler v2 validation state on entry
+ * @pre_down: inline pre-downscale configuration on entry
+ * @scaler_src_w: scaler v2 source width of each color plane
+ * @scaler_src_h: scaler v2 source height of each color plane
+ * @roi_w: pixel extension horizontal roi of each color plane
+ * @roi_h: pixel extension vertical roi of each color plane
+ * @left_ftch: pixel extension left overfetch of each color plane
+ * @right_ftch: pixel extension right overfetch of each color plane
+ * @top_ftch: pixel extension top overfetch of each color plane
+ * @btm_ftch: pixel extension bottom overfetch of each color plane
+ */
+struct sde_plane_check_key {
+	u64 modifier;
+	u32 format;
+	u32 fb_width;
+	u32 fb_height;
+	struct sde_rect src;
+	struct sde_rect dst;
+	struct sde_rect excl_rect;
+	u32 rotation;
+	u32 deci_w;
+	u32 deci_h;
+	u32 src_config;
+	u32 rt_client;
+	u32 default_scale;
+	u32 scaler_check_state;
+	struct sde_hw_inline_pre_downscale_cfg pre_down;
+	u32 scaler_src_w[SDE_MAX_PLANES];
+	u32 scaler_src_h[SDE_MAX_PLANES];
+	u32 roi_w[SDE_MAX_PLANES];
+	u32 roi_h[SDE_MAX_PLANES];
+	int left_ftch[SDE_MAX_PLANES];
+	int right_ftch[SDE_MAX_PLANES];
+	int top_ftch[SDE_MAX_PLANES];
+	int btm_ftch[SDE_MAX_PLANES];
+};
+
+/**
+ * struct sde_plane_check_cache - last successful sspp validation of a plane
+ * @valid: cache holds a validated configuration
+ * @hash: hash of @key for a quick mismatch test
+ * @key: validated configuration
+ * @pre_down: pre-downscale configuration computed by the validation
+ * @scaler_check_state: scaler v2 validation state computed by the validation
+ */
+struct sde_plane_check_cache {
+	bool valid;
+	u32 hash;
+	struct sde_plane_check_key key;
+	struct sde_hw_inline_pre_downscale_cfg pre_down;
+	enum sde_plane_sclcheck_state scaler_check_state;
+};
+
 /*
  * struct sde_plane - local sde plane structure
  * @aspace: address space pointer
@@ -95,6 +164,9 @@ enum sde_plane_qos {
  * @revalidate: force revalidation of all the plane properties
  * @xin_halt_forced_clk: whether or not clocks were forced on for xin halt
  * @blob_rot_caps: Pointer to rotator capability blob
+ * @check_cache: Result of the last successful source/scaler validation
+ * @static_fb: framebuffer of the previous frame, only used for comparison
+ * @static_frames: number of consecutive frames @static_fb was reused
  */
 struct sde_plane {
 	struct drm_plane base;
@@ -140,6 +212,11 @@ struct sde_plane {
 	/* debugfs related stuff */
 	struct dentry *debugfs_root;
 	bool debugfs_default_scale;
+
+	struct sde_plane_check_cache check_cache;
+
+	struct drm_framebuffer *static_fb;
+	u32 static_frames;
 };
 
 #define to_sde_plane(x) container_of(x, struct sde_plane, base)
@@ -2596,6 +2673,129 @@ static int _sde_plane_sspp_atomic_check_helper(struct sde_plane *psde,
 	return ret;
 }
 
+static void _sde_plane_check_key_init(struct sde_plane *psde,
+		struct sde_plane_state *pstate, struct drm_plane_state *state,
+		struct sde_rect *src, struct sde_rect *dst,
+		struct sde_plane_check_key *key)
+{
+	struct drm_crtc_state *new_cstate;
+	int i;
+
+	memset(key, 0, sizeof(*key));
+
+	key->modifier = state->fb->modifier;
+	key->format = state->fb->format->format;
+	key->fb_width = state->fb->width;
+	key->fb_height = state->fb->height;
+	key->src = *src;
+	key->dst = *dst;
+	key->excl_rect = pstate->excl_rect;
+	key->rotation = pstate->rotation;
+	key->deci_w = sde_plane_get_property(pstate, PLANE_PROP_H_DECIMATE);
+	key->deci_h = sde_plane_get_property(pstate, PLANE_PROP_V_DECIMATE);
+	key->src_config = sde_plane_get_property(pstate,
+			PLANE_PROP_SRC_CONFIG);
+
+	new_cstate = drm_atomic_get_new_crtc_state(state->state, state->crtc);
+	key->rt_client = sde_crtc_is_rt_client(state->crtc, new_cstate);
+	key->default_scale = psde->debugfs_default_scale;
+	key->scaler_check_state = pstate->scaler_check_state;
+	key->pre_down = pstate->pre_down;
+
+	/* only the scaler v2 validation looks at the user scaler data */
+	if (psde->debugfs_default_scale ||
+	    (pstate->scaler_check_state != SDE_PLANE_SCLCHECK_SCALER_V2 &&
+	    pstate->scaler_check_state != SDE_PLANE_SCLCHECK_SCALER_V2_CHECK))
+		return;
+
+	for (i = 0; i < SDE_MAX_PLANES; i++) {
+		key->scaler_src_w[i] = pstate->scaler3_cfg.src_width[i];
+		key->scaler_src_h[i] = pstate->scaler3_cfg.src_height[i];
+		key->roi_w[i] = pstate->pixel_ext.roi_w[i];
+		key->roi_h[i] = pstate->pixel_ext.roi_h[i];
+		key->left_ftch[i] = pstate->pixel_ext.left_ftch[i];
+		key->right_ftch[i] = pstate->pixel_ext.right_ftch[i];
+		key->top_ftch[i] = pstate->pixel_ext.top_ftch[i];
+		key->btm_ftch[i] = pstate->pixel_ext.btm_ftch[i];
+	}
+}
+
+/*
+ * Reuse the result of the last validation if the configuration is unchanged,
+ * static compositions then skip the source, decimation and scaler checks.
+ */
+static bool _sde_plane_check_cache_lookup(struct sde_plane *psde,
+		struct sde_plane_state *pstate,
+		struct sde_plane_check_key *key, u32 hash)
+{
+	struct sde_plane_check_cache *cache = &psde->check_cache;
+
+	if (!cache->valid || cache->hash != hash ||
+			memcmp(&cache->key, key, sizeof(*key)))
+		return false;
+
+	pstate->pre_down = cache->pre_down;
+	pstate->scaler_check_state = cache->scaler_check_state;
+
+	return true;
+}
+
+static void _sde_plane_check_cache_update(struct sde_plane *psde,
+		struct sde_plane_state *pstate,
+		struct sde_plane_check_key *key, u32 hash, int ret)
+{
+	struct sde_plane_check_cache *cache = &psde->check_cache;
+
+	cache->valid = !ret;
+	if (ret)
+		return;
+
+	cache->hash = hash;
+	cache->key = *key;
+	cache->pre_down = pstate->pre_down;
+	cache->scaler_check_state = pstate->scaler_check_state;
+}
+
+static int _sde_plane_sspp_atomic_check_cfg(struct sde_plane *psde,
+		struct sde_plane_state *pstate, struct drm_plane_state *state,
+		const struct sde_format *fmt, struct sde_rect *src,
+		struct sde_rect *dst, u32 width, u32 height)
+{
+	struct sde_plane_check_key key;
+	u32 hash;
+	int ret;
+
+	if (!state->state || !state->crtc) {
+		SDE_ERROR_PLANE(psde, "invalid arguments\n");
+		return -EINVAL;
+	}
+
+	_sde_plane_check_key_init(psde, pstate, state, src, dst, &key);
+	hash = jhash(&key, sizeof(key), 0);
+
+	if (_sde_plane_check_cache_lookup(psde, pstate, &key, hash)) {
+		SDE_DEBUG_PLANE(psde, "configuration unchanged\n");
+		return 0;
+	}
+
+	ret = _sde_plane_sspp_atomic_check_helper(psde, fmt, *src, *dst, width,
+			height);
+	if (ret)
+		goto end;
+
+	ret = _sde_atomic_check_decimation_scaler(state, psde, fmt, pstate,
+		src, dst, width, height);
+	if (ret)
+		goto end;
+
+	ret = _sde_atomic_check_excl_rect(psde, pstate,
+		src, fmt, ret);
+
+end:
+	_sde_plane_check_cache_update(psde, pstate, &key, hash, ret);
+	return ret;
+}
+
 static int sde_plane_sspp_atomic_check(struct drm_plane *plane,
 		struct drm_plane_state *state)
 {
@@ -2649,18 +2849,8 @@ static int sde_plane_sspp_atomic_check(struct drm_plane *plane,
 	msm_fmt = msm_framebuffer_format(fb);
 	fmt = to_sde_format(msm_fmt);
 
-	ret = _sde_plane_sspp_atomic_check_helper(psde, fmt, src, dst, width,
-			height);
-	if (ret)
-		return ret;
-
-	ret = _sde_atomic_check_decimation_scaler(state, psde, fmt, pstate,
-		&src, &dst, width, height);
-	if (ret)
-		return ret;
-
-	ret = _sde_atomic_check_excl_rect(psde, pstate,
-		&src, fmt, ret);
+	ret = _sde_plane_sspp_atomic_check_cfg(psde, pstate, state, fmt,
+			&src, &dst, width, height);
 	if (ret)
 		return ret;
 
@@ -2840,6 +3030,36 @@ void sde_plane_static_img_control(struct drm_plane *plane,
 		_sde_plane_sspp_setup_sys_cache(psde, pstate, false);
 }
 
+u32 sde_plane_update_static_frames(struct drm_plane *plane)
+{
+	struct sde_plane *psde;
+	struct sde_plane_state *pstate;
+
+	if (!plane || !plane->state) {
+		SDE_ERROR("invalid plane\n");
+		return 0;
+	}
+
+	psde = to_sde_plane(plane);
+	pstate = to_sde_plane_state(plane->state);
+
+	/*
+	 * A new acquire fence means the buffer was rendered again. The
+	 * result only steers the system cache, a wrong guess costs
+	 * bandwidth but never shows stale content.
+	 */
+	if (plane->state->fb && plane->state->fb == psde->static_fb &&
+			!pstate->input_fence) {
+		if (psde->static_frames < U32_MAX)
+			psde->static_frames++;
+	} else {
+		psde->static_fb = plane->state->fb;
+		psde->static_frames = 0;
+	}
+
+	return psde->static_frames;
+}
+
 static void _sde_plane_map_prop_to_dirty_bits(void)
 {
 	plane_prop_array[PLANE_PROP_SCALER_V1] =
@@ -2905,6 +3125,7 @@ static void _sde_plane_setup_uidle(struct drm_crtc *crtc,
 {
 	struct sde_hw_pipe_uidle_cfg cfg;
 	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_kms *kms = _sde_plane_get_kms(&psde->base);
 	u32 fal1_threshold_max = 15;
 
 	u32 line_time = sde_get_linetime(&crtc->mode,
@@ -2913,8 +3134,8 @@ static void _sde_plane_setup_uidle(struct drm_crtc *crtc,
 		psde->catalog->uidle_cfg.fal1_target_idle_time * 1000; /* nS */
 	u32 fal10_target_idle_time_ns =
 		psde->catalog->uidle_cfg.fal10_target_idle_time * 1000; /* nS */
-	u32 fal10_threshold =
-		psde->catalog->uidle_cfg.fal10_threshold; /* uS */
+	u32 fal10_threshold = kms ?
+		sde_core_perf_uidle_fal10_threshold(&kms->perf) : 0; /* uS */
 
 	if (line_time && fal10_threshold && fal10_target_idle_time_ns &&
 		fal1_target_idle_time_ns) {
@@ -351,4 +351,14 @@ bool sde_plane_is_cache_required(struct drm_plane *plane,
 void sde_plane_static_img_control(struct drm_plane *plane,
 		enum sde_crtc_cache_state state);
 
+/**
+ * sde_plane_update_static_frames - account for a frame of the plane
+ * @plane: Pointer to drm plane structure
+ *
+ * Must be called once per commit of the crtc the plane is staged on.
+ * Returns: number of consecutive previous frames the plane fetched the
+ *	same buffer content in, 0 if the content changed with this frame
+ */
+u32 sde_plane_update_static_frames(struct drm_plane *plane);
+
 #endif /* _SDE_PLANE_H_ */
@@ -727,6 +727,115 @@ static int _sde_rm_hw_blk_create_new(struct sde_rm *rm,
 	return rc;
 }
 
+static struct sde_rm_hw_blk *_sde_rm_find_blk(struct sde_rm *rm,
+		enum sde_hw_blk_type type, uint32_t id)
+{
+	struct sde_rm_hw_blk *blk;
+
+	list_for_each_entry(blk, &rm->hw_blks[type], list)
+		if (blk->id == id)
+			return blk;
+
+	return NULL;
+}
+
+/*
+ * Resolve the blocks hardwired to each layer mixer and the mixers and ctls
+ * each topology can use once, so reservations don't have to walk the block
+ * lists of the hw catalog on every modeset.
+ */
+static int _sde_rm_init_topology_masks(struct sde_rm *rm)
+{
+	struct sde_rm_hw_blk *blk;
+	struct sde_rm_lm_blks *entry;
+	const struct sde_rm_topology_def *top;
+	u32 lm_present = 0;
+	int i;
+
+	list_for_each_entry(blk, &rm->hw_blks[SDE_HW_BLK_LM], list) {
+		const struct sde_lm_cfg *lm_cfg = to_sde_hw_mixer(blk->hw)->cap;
+
+		if (blk->id >= LM_MAX) {
+			SDE_ERROR("invalid lm id %d\n", blk->id);
+			return -EINVAL;
+		}
+
+		entry = &rm->lm_tbl[blk->id];
+		entry->lm = blk;
+		entry->dspp = _sde_rm_find_blk(rm, SDE_HW_BLK_DSPP,
+				lm_cfg->dspp);
+		entry->ds = _sde_rm_find_blk(rm, SDE_HW_BLK_DS, lm_cfg->ds);
+		entry->pp = _sde_rm_find_blk(rm, SDE_HW_BLK_PINGPONG,
+				lm_cfg->pingpong);
+		entry->peer_mask = lm_cfg->lm_pair_mask;
+		lm_present |= BIT(blk->id);
+	}
+
+	for (i = 0; i < LM_MAX; i++)
+		rm->lm_tbl[i].peer_mask &= lm_present;
+
+	for (i = 0; i < SDE_RM_TOPOLOGY_MAX; i++) {
+		top = &rm->topology_tbl[i];
+		if (top->top_name >= SDE_RM_TOPOLOGY_MAX)
+			continue;
+
+		list_for_each_entry(blk, &rm->hw_blks[SDE_HW_BLK_LM], list) {
+			struct sde_hw_pingpong *hw_pp;
+
+			entry = &rm->lm_tbl[blk->id];
+			if (top->num_lm > 1 && !entry->peer_mask)
+				continue;
+
+			if (top->top_name == SDE_RM_TOPOLOGY_PPSPLIT) {
+				if (!entry->pp)
+					continue;
+
+				hw_pp = to_sde_hw_pingpong(entry->pp->hw);
+				if (!test_bit(SDE_PINGPONG_SPLIT,
+						&hw_pp->caps->features))
+					continue;
+			}
+
+			rm->top_lm_mask[top->top_name] |= BIT(blk->id);
+		}
+
+		list_for_each_entry(blk, &rm->hw_blks[SDE_HW_BLK_CTL], list) {
+			const struct sde_hw_ctl *ctl = to_sde_hw_ctl(blk->hw);
+			unsigned long features = ctl->caps->features;
+			bool has_split_display, has_ppsplit;
+
+			if (blk->id >= BITS_PER_TYPE(u32)) {
+				SDE_ERROR("invalid ctl id %d\n", blk->id);
+				return -EINVAL;
+			}
+
+			has_split_display = BIT(SDE_CTL_SPLIT_DISPLAY) &
+					features;
+			has_ppsplit = BIT(SDE_CTL_PINGPONG_SPLIT) & features;
+
+			/* preferred ctls are checked against the display */
+			if (!(BIT(SDE_CTL_PRIMARY_PREF) & features) &&
+				!(BIT(SDE_CTL_SECONDARY_PREF) & features)) {
+				if (top->needs_split_display !=
+						has_split_display)
+					continue;
+
+				if (top->top_name == SDE_RM_TOPOLOGY_PPSPLIT &&
+						!has_ppsplit)
+					continue;
+			}
+
+			rm->top_ctl_mask[top->top_name] |= BIT(blk->id);
+		}
+
+		SDE_DEBUG("topology %d lm_mask 0x%x ctl_mask 0x%x\n",
+				top->top_name, rm->top_lm_mask[top->top_name],
+				rm->top_ctl_mask[top->top_name]);
+	}
+
+	return 0;
+}
+
 int sde_rm_init(struct sde_rm *rm,
 		struct sde_mdss_cfg *cat,
 		void __iomem *mmio,
@@ -795,6 +904,8 @@ int sde_rm_init(struct sde_rm *rm,
 	}
 
 	rc = _sde_rm_hw_blk_create_new(rm, cat, mmio);
+	if (!rc)
+		rc = _sde_rm_init_topology_masks(rm);
 	if (!rc)
 		return 0;
 
@@ -851,17 +962,8 @@ static bool _sde_rm_reserve_dspp(
 		struct sde_rm_hw_blk *lm,
 		struct sde_rm_hw_blk **dspp)
 {
-	struct sde_rm_hw_iter iter;
-
 	if (lm_cfg->dspp != DSPP_MAX) {
-		sde_rm_init_hw_iter(&iter, 0, SDE_HW_BLK_DSPP);
-		while (_sde_rm_get_hw_locked(rm, &iter)) {
-			if (iter.blk->id == lm_cfg->dspp) {
-				*dspp = iter.blk;
-				break;
-			}
-		}
-
+		*dspp = rm->lm_tbl[lm->id].dspp;
 		if (!*dspp) {
 			SDE_DEBUG("lm %d failed to retrieve dspp %d\n", lm->id,
 					lm_cfg->dspp);
@@ -886,17 +988,8 @@ static bool _sde_rm_reserve_ds(
 		struct sde_rm_hw_blk *lm,
 		struct sde_rm_hw_blk **ds)
 {
-	struct sde_rm_hw_iter iter;
-
 	if (lm_cfg->ds != DS_MAX) {
-		sde_rm_init_hw_iter(&iter, 0, SDE_HW_BLK_DS);
-		while (_sde_rm_get_hw_locked(rm, &iter)) {
-			if (iter.blk->id == lm_cfg->ds) {
-				*ds = iter.blk;
-				break;
-			}
-		}
-
+		*ds = rm->lm_tbl[lm->id].ds;
 		if (!*ds) {
 			SDE_DEBUG("lm %d failed to retrieve ds %d\n", lm->id,
 					lm_cfg->ds);
@@ -924,16 +1017,7 @@ static bool _sde_rm_reserve_pp(
 		struct sde_rm_hw_blk **ds,
 		struct sde_rm_hw_blk **pp)
 {
-	struct sde_rm_hw_iter iter;
-
-	sde_rm_init_hw_iter(&iter, 0, SDE_HW_BLK_PINGPONG);
-	while (_sde_rm_get_hw_locked(rm, &iter)) {
-		if (iter.blk->id == lm_cfg->pingpong) {
-			*pp = iter.blk;
-			break;
-		}
-	}
-
+	*pp = rm->lm_tbl[lm->id].pp;
 	if (!*pp) {
 		SDE_ERROR("failed to get pp on lm %d\n", lm_cfg->pingpong);
 		return false;
@@ -1093,7 +1177,7 @@ static int _sde_rm_reserve_lms(
 	struct sde_rm_hw_blk *ds[MAX_BLOCKS];
 	struct sde_rm_hw_blk *pp[MAX_BLOCKS];
 	struct sde_rm_hw_iter iter_i, iter_j;
-	u32 lm_mask = 0, conn_lm_mask = 0;
+	u32 lm_mask = 0, conn_lm_mask = 0, cand_mask, peer_mask;
 	int lm_count = 0;
 	int i, rc = 0;
 
@@ -1105,11 +1189,22 @@ static int _sde_rm_reserve_lms(
 	if (RM_RQ_CWB(reqs))
 		conn_lm_mask = reqs->conn_lm_mask;
 
+	/* drop mixers the topology can't use or other displays hold */
+	cand_mask = rm->top_lm_mask[reqs->topology->top_name];
+	for (i = 0; i < LM_MAX; i++) {
+		if (rm->lm_tbl[i].lm &&
+				RESERVED_BY_OTHER(rm->lm_tbl[i].lm, rsvp))
+			cand_mask &= ~BIT(i);
+	}
+	SDE_DEBUG("topology %d candidate lm mask 0x%x\n",
+			reqs->topology->top_name, cand_mask);
+
 	/* Find a primary mixer */
 	sde_rm_init_hw_iter(&iter_i, 0, SDE_HW_BLK_LM);
 	while (lm_count != reqs->topology->num_lm &&
 			_sde_rm_get_hw_locked(rm, &iter_i)) {
-		if (lm_mask & (1 << iter_i.blk->id))
+		if ((lm_mask & (1 << iter_i.blk->id)) ||
+				!(cand_mask & BIT(iter_i.blk->id)))
 			continue;
 
 		lm[lm_count] = iter_i.blk;
@@ -1142,10 +1237,12 @@ static int _sde_rm_reserve_lms(
 			break;
 
 		/* Valid primary mixer found, find matching peers */
+		peer_mask = rm->lm_tbl[iter_i.blk->id].peer_mask;
 		sde_rm_init_hw_iter(&iter_j, 0, SDE_HW_BLK_LM);
 
 		while (_sde_rm_get_hw_locked(rm, &iter_j)) {
-			if (lm_mask & (1 << iter_j.blk->id))
+			if ((lm_mask & (1 << iter_j.blk->id)) ||
+					!(peer_mask & BIT(iter_j.blk->id)))
 				continue;
 
 			lm[lm_count] = iter_j.blk;
@@ -1253,6 +1350,10 @@ static int _sde_rm_reserve_ctls(
 		if (RESERVED_BY_OTHER(iter.blk, rsvp))
 			continue;
 
+		if (!_ctl_ids &&
+			!(rm->top_ctl_mask[top->top_name] & BIT(iter.blk->id)))
+			continue;
+
 		has_split_display = BIT(SDE_CTL_SPLIT_DISPLAY) & features;
 		has_ppsplit = BIT(SDE_CTL_PINGPONG_SPLIT) & features;
 		primary_pref = BIT(SDE_CTL_PRIMARY_PREF) & features;
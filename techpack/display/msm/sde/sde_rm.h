@@ -148,6 +148,28 @@ struct sde_rm_topology_def {
 	enum msm_display_compression_type comp_type;
 };
 
+/**
+ *  struct sde_rm_hw_blk - resource manager internal structure
+ *	forward declaration for single iterator definition without void pointer
+ */
+struct sde_rm_hw_blk;
+
+/**
+ * struct sde_rm_lm_blks - hardwired blocks of a layer mixer, built at init
+ * @lm: layer mixer block, NULL if the mixer id is not present
+ * @dspp: dspp block tied to the layer mixer, NULL if none
+ * @ds: destination scaler block tied to the layer mixer, NULL if none
+ * @pp: pingpong block tied to the layer mixer
+ * @peer_mask: mask of mixer ids which can be paired with this mixer
+ */
+struct sde_rm_lm_blks {
+	struct sde_rm_hw_blk *lm;
+	struct sde_rm_hw_blk *dspp;
+	struct sde_rm_hw_blk *ds;
+	struct sde_rm_hw_blk *pp;
+	u32 peer_mask;
+};
+
 /**
  * struct sde_rm - SDE dynamic hardware resource manager
  * @dev: device handle for event logging purposes
@@ -159,6 +181,11 @@ struct sde_rm_topology_def {
  * @rsvp_next_seq: sequence number for next reservation for debugging purposes
  * @rm_lock: resource manager mutex
  * @avail_res: Pointer with curr available resources
+ * @lm_tbl: hardwired blocks of each layer mixer, indexed by mixer id
+ * @top_lm_mask: per topology mask of mixer ids which can be the primary
+ *	mixer of the topology, based on the static hw capabilities
+ * @top_ctl_mask: per topology mask of ctl ids which can serve the topology,
+ *	based on the static hw capabilities
  */
 struct sde_rm {
 	struct drm_device *dev;
@@ -170,14 +197,11 @@ struct sde_rm {
 	struct mutex rm_lock;
 	const struct sde_rm_topology_def *topology_tbl;
 	struct msm_resource_caps_info avail_res;
+	struct sde_rm_lm_blks lm_tbl[LM_MAX];
+	u32 top_lm_mask[SDE_RM_TOPOLOGY_MAX];
+	u32 top_ctl_mask[SDE_RM_TOPOLOGY_MAX];
 };
 
-/**
- *  struct sde_rm_hw_blk - resource manager internal structure
- *	forward declaration for single iterator definition without void pointer
- */
-struct sde_rm_hw_blk;
-
 /**
  * struct sde_rm_hw_iter - iterator for use with sde_rm
  * @hw: sde_hw object requested, or NULL on failure
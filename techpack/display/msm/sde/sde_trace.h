@@ -390,6 +390,34 @@ TRACE_EVENT(sde_perf_uidle_status,
 			)
 );
 
+TRACE_EVENT(sde_perf_uidle_tune,
+	TP_PROTO(u32 fps,
+			int fal10_adj,
+			u32 residency,
+			u32 danger),
+	TP_ARGS(fps,
+			fal10_adj,
+			residency,
+			danger),
+	TP_STRUCT__entry(
+			__field(u32, fps)
+			__field(int, fal10_adj)
+			__field(u32, residency)
+			__field(u32, danger)),
+	TP_fast_assign(
+			__entry->fps = fps;
+			__entry->fal10_adj = fal10_adj;
+			__entry->residency = residency;
+			__entry->danger = danger;),
+	 TP_printk(
+		"fps:%u fal10_adj:%d residency:%u%% danger:%u",
+			__entry->fps,
+			__entry->fal10_adj,
+			__entry->residency,
+			__entry->danger
+			)
+);
+
 #define sde_atrace trace_tracing_mark_write
 
 #define SDE_ATRACE_END(name) sde_atrace('E', current, name, 0)
@@ -255,6 +255,90 @@ int sde_wb_connector_set_modes(struct sde_wb_device *wb_dev,
 	return ret;
 }
 
+/* must be called with wb_lock held */
+static void _sde_wb_stream_release(struct sde_wb_device *wb_dev)
+{
+	struct sde_wb_stream *stream = &wb_dev->stream;
+	u32 i;
+
+	for (i = 0; i < stream->num_fbs; i++) {
+		msm_framebuffer_cleanup(stream->fb[i], stream->aspace);
+		drm_framebuffer_put(stream->fb[i]);
+		stream->fb[i] = NULL;
+	}
+
+	stream->num_fbs = 0;
+	stream->next = 0;
+	stream->aspace = NULL;
+}
+
+/* must be called with wb_lock held */
+static int _sde_wb_stream_add(struct sde_wb_device *wb_dev,
+		struct drm_framebuffer *fb,
+		struct msm_gem_address_space *aspace)
+{
+	struct sde_wb_stream *stream = &wb_dev->stream;
+	int rc;
+
+	/* keep the buffer mapped while it is in the ring */
+	rc = msm_framebuffer_prepare(fb, aspace);
+	if (rc) {
+		SDE_ERROR("failed to prepare stream fb %d, %d\n",
+				fb->base.id, rc);
+		return rc;
+	}
+
+	drm_framebuffer_get(fb);
+	stream->aspace = aspace;
+	stream->fb[stream->num_fbs++] = fb;
+
+	SDE_EVT32(wb_dev->wb_idx - WB_0, fb->base.id, stream->num_fbs,
+			stream->count);
+
+	return 0;
+}
+
+struct drm_framebuffer *sde_wb_stream_get_fb(struct sde_wb_device *wb_dev,
+		struct drm_framebuffer *fb,
+		struct msm_gem_address_space *aspace)
+{
+	struct sde_wb_stream *stream;
+	u32 i;
+
+	if (!wb_dev || !fb)
+		return fb;
+
+	stream = &wb_dev->stream;
+
+	mutex_lock(&wb_dev->wb_lock);
+	if (!stream->count)
+		goto end;
+
+	if (stream->num_fbs && stream->aspace != aspace)
+		_sde_wb_stream_release(wb_dev);
+
+	for (i = 0; i < stream->num_fbs; i++)
+		if (stream->fb[i] == fb)
+			break;
+
+	/* the client committed a new buffer, register the ring again */
+	if (i == stream->num_fbs && stream->num_fbs == stream->count)
+		_sde_wb_stream_release(wb_dev);
+
+	if (stream->num_fbs < stream->count) {
+		if (i == stream->num_fbs)
+			_sde_wb_stream_add(wb_dev, fb, aspace);
+		goto end;
+	}
+
+	fb = stream->fb[stream->next];
+	stream->next = (stream->next + 1) % stream->count;
+end:
+	mutex_unlock(&wb_dev->wb_lock);
+
+	return fb;
+}
+
 int sde_wb_connector_set_property(struct drm_connector *connector,
 		struct drm_connector_state *state,
 		int property_index,
@@ -290,6 +374,13 @@ int sde_wb_connector_set_property(struct drm_connector *connector,
 			rc = -EINVAL;
 			goto done;
 		}
+	} else if (property_index == CONNECTOR_PROP_WB_STREAM_BUFS) {
+		mutex_lock(&wb_dev->wb_lock);
+		if (wb_dev->stream.count != value) {
+			_sde_wb_stream_release(wb_dev);
+			wb_dev->stream.count = value;
+		}
+		mutex_unlock(&wb_dev->wb_lock);
 	}
 
 done:
@@ -445,6 +536,9 @@ int sde_wb_connector_post_init(struct drm_connector *connector, void *display)
 			0, e_fb_translation_mode,
 			ARRAY_SIZE(e_fb_translation_mode), 0,
 			CONNECTOR_PROP_FB_TRANSLATION_MODE);
+	msm_property_install_range(&c_conn->property_info, "WB_STREAM_BUFS",
+			0x0, 0, SDE_WB_STREAM_MAX_BUFS, 0,
+			CONNECTOR_PROP_WB_STREAM_BUFS);
 
 	return 0;
 }
@@ -734,6 +828,11 @@ int sde_wb_drm_deinit(struct sde_wb_device *wb_dev)
 
 	SDE_DEBUG("\n");
 
+	mutex_lock(&wb_dev->wb_lock);
+	_sde_wb_stream_release(wb_dev);
+	wb_dev->stream.count = 0;
+	mutex_unlock(&wb_dev->wb_lock);
+
 	return rc;
 }
 
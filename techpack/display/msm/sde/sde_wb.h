@@ -12,6 +12,25 @@
 #include "sde_kms.h"
 #include "sde_connector.h"
 
+/* maximum number of output buffers in a writeback stream ring */
+#define SDE_WB_STREAM_MAX_BUFS	8
+
+/**
+ * struct sde_wb_stream - ring of output buffers for streaming writeback
+ * @count:	Number of buffers requested by the client, 0 if not streaming
+ * @num_fbs:	Number of buffers registered so far
+ * @next:	Ring index of the buffer written by the next frame
+ * @aspace:	Address space the registered buffers are prepared for
+ * @fb:		Registered output buffers, kept prepared while in the ring
+ */
+struct sde_wb_stream {
+	u32 count;
+	u32 num_fbs;
+	u32 next;
+	struct msm_gem_address_space *aspace;
+	struct drm_framebuffer *fb[SDE_WB_STREAM_MAX_BUFS];
+};
+
 /**
  * struct sde_wb_device - Writeback device context
  * @drm_dev:		Pointer to controlling DRM device
@@ -27,6 +46,7 @@
  * @max_mixer_width:    Max width supported by SDE LM HW block
  * @count_modes:	Length of writeback connector modes array
  * @modes:		Writeback connector modes array
+ * @stream:		Output buffer ring of streaming writeback
  */
 struct sde_wb_device {
 	struct drm_device *drm_dev;
@@ -47,6 +67,8 @@ struct sde_wb_device {
 
 	u32 count_modes;
 	struct drm_mode_modeinfo *modes;
+
+	struct sde_wb_stream stream;
 };
 
 /**
@@ -76,6 +98,22 @@ struct drm_framebuffer *sde_wb_get_output_fb(struct sde_wb_device *wb_dev);
  */
 int sde_wb_get_output_roi(struct sde_wb_device *wb_dev, struct sde_rect *roi);
 
+/**
+ * sde_wb_stream_get_fb - get the buffer to write for streaming writeback
+ * @wb_dev:	Pointer to writeback device
+ * @fb:		Output framebuffer of the current atomic state
+ * @aspace:	Address space the output is written through
+ *
+ * The first frames after WB_STREAM_BUFS is set register the committed
+ * output buffers in the stream ring. Once the ring is complete every frame
+ * writes the next ring buffer, without the client changing FB_ID. A commit
+ * with a buffer outside of the ring registers the ring again.
+ * Returns:	Framebuffer to write, @fb if streaming is off
+ */
+struct drm_framebuffer *sde_wb_stream_get_fb(struct sde_wb_device *wb_dev,
+		struct drm_framebuffer *fb,
+		struct msm_gem_address_space *aspace);
+
 /**
  * sde_wb_get_num_of_displays - get total number of writeback devices
  * Returns:	Number of writeback devices
@@ -252,6 +290,13 @@ int sde_wb_get_output_roi(struct sde_wb_device *wb_dev, struct sde_rect *roi)
 	return 0;
 }
 static inline
+struct drm_framebuffer *sde_wb_stream_get_fb(struct sde_wb_device *wb_dev,
+		struct drm_framebuffer *fb,
+		struct msm_gem_address_space *aspace)
+{
+	return fb;
+}
+static inline
 u32 sde_wb_get_num_of_displays(void)
 {
 	return 0;
@@ -9,6 +9,7 @@
 #include <stdarg.h>
 #include <linux/debugfs.h>
 #include <linux/list.h>
+#include <linux/mutex.h>
 #include <soc/qcom/minidump.h>
 
 /* select an uncommon hex value for the limiter */
@@ -96,6 +97,12 @@ enum sde_dbg_dump_context {
  * entry array access.
  */
 #define SDE_EVTLOG_ENTRY	(SDE_EVTLOG_PRINT_ENTRY * 32)
+
+/*
+ * evtlog entries kept for each cpu. Must be a power of two so the ring
+ * indexes can wrap around.
+ */
+#define SDE_EVTLOG_CPU_ENTRY	(SDE_EVTLOG_ENTRY / 8)
 #define SDE_EVTLOG_MAX_DATA 15
 #define SDE_EVTLOG_BUF_MAX 512
 #define SDE_EVTLOG_BUF_ALIGN 32
@@ -117,18 +124,34 @@ struct sde_dbg_evtlog_log {
 };
 
 /**
- * @last_dump: Index of last entry to be output during evtlog dumps
- * @filter_list: Linked list of currently active filter strings
+ * struct sde_dbg_evtlog_ring - event log of a single cpu
+ * @logs: Entries logged on the cpu, only ever written by that cpu
+ * @curr: Number of entries logged on the cpu, wraps around @logs
+ * @next: Index of the next entry to be output during evtlog dumps
+ * @last_dump: Index after the last entry to be output during evtlog dumps
  */
-struct sde_dbg_evtlog {
-	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_ENTRY];
-	u32 first;
-	u32 last;
-	u32 last_dump;
+struct sde_dbg_evtlog_ring {
+	struct sde_dbg_evtlog_log logs[SDE_EVTLOG_CPU_ENTRY];
 	u32 curr;
 	u32 next;
+	u32 last_dump;
+};
+
+/**
+ * @rings: Per cpu event logs, merged by timestamp during dumps
+ * @nr_rings: Number of entries in @rings
+ * @prev_time: Time of the last entry output during evtlog dumps
+ * @spin_lock: Protects the dump state of the rings
+ * @filter_lock: Serializes updates of @filter_list
+ * @filter_list: RCU list of currently active filter strings
+ */
+struct sde_dbg_evtlog {
+	struct sde_dbg_evtlog_ring *rings;
+	u32 nr_rings;
+	s64 prev_time;
 	u32 enable;
 	spinlock_t spin_lock;
+	struct mutex filter_lock;
 	struct list_head filter_list;
 };
 
@@ -329,6 +352,12 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 		char *evtlog_buf, ssize_t evtlog_buf_size,
 		bool update_last_entry, bool full_dump);
 
+/**
+ * sde_evtlog_dump_rewind - make the next dump start at the oldest entries
+ * @evtlog:		pointer to evtlog
+ */
+void sde_evtlog_dump_rewind(struct sde_dbg_evtlog *evtlog);
+
 /**
  * sde_dbg_init_dbg_buses - initialize debug bus dumping support for the chipset
  * @hwversion:		Chipset revision
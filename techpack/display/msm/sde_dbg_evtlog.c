@@ -14,6 +14,7 @@
 #include <linux/dma-buf.h>
 #include <linux/slab.h>
 #include <linux/sched/clock.h>
+#include <linux/rculist.h>
 
 #include "sde_dbg.h"
 #include "sde_trace.h"
@@ -25,7 +26,8 @@ struct sde_evtlog_filter {
 	char filter[SDE_EVTLOG_FILTER_STRSIZE];
 };
 
-static bool _sde_evtlog_is_filtered_no_lock(
+/* Must be called under rcu_read_lock() */
+static bool _sde_evtlog_is_filtered(
 		struct sde_dbg_evtlog *evtlog, const char *str)
 {
 	struct sde_evtlog_filter *filter_node;
@@ -42,7 +44,7 @@ static bool _sde_evtlog_is_filtered_no_lock(
 	 * a matching entry is not in the list.
 	 */
 	rc = !list_empty(&evtlog->filter_list);
-	list_for_each_entry(filter_node, &evtlog->filter_list, list)
+	list_for_each_entry_rcu(filter_node, &evtlog->filter_list, list)
 		if (strnstr(str, filter_node->filter, len)) {
 			rc = false;
 			break;
@@ -62,7 +64,9 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	unsigned long flags;
 	int i, val = 0;
 	va_list args;
+	struct sde_dbg_evtlog_ring *ring;
 	struct sde_dbg_evtlog_log *log;
+	bool filtered;
 
 	if (!evtlog)
 		return;
@@ -70,12 +74,21 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	if (!sde_evtlog_is_enabled(evtlog, flag))
 		return;
 
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
+	rcu_read_lock();
+	filtered = _sde_evtlog_is_filtered(evtlog, name);
+	rcu_read_unlock();
 
-	if (_sde_evtlog_is_filtered_no_lock(evtlog, name))
-		goto exit;
+	if (filtered)
+		return;
 
-	log = &evtlog->logs[evtlog->curr];
+	/*
+	 * Each cpu only writes its own ring, disabling local interrupts is
+	 * enough to keep nested events out of the entry being filled in.
+	 */
+	local_irq_save(flags);
+
+	ring = &evtlog->rings[smp_processor_id()];
+	log = &ring->logs[ring->curr % SDE_EVTLOG_CPU_ENTRY];
 	log->time = local_clock();
 	log->name = name;
 	log->line = line;
@@ -94,12 +107,11 @@ void sde_evtlog_log(struct sde_dbg_evtlog *evtlog, const char *name, int line,
 	}
 	va_end(args);
 	log->data_cnt = i;
-	evtlog->curr = (evtlog->curr + 1) % SDE_EVTLOG_ENTRY;
-	evtlog->last++;
+	WRITE_ONCE(ring->curr, ring->curr + 1);
 
 	trace_sde_evtlog(name, line, log->data_cnt, log->data);
-exit:
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+
+	local_irq_restore(flags);
 }
 
 void sde_reglog_log(u8 blk_id, u32 val, u32 addr)
@@ -122,36 +134,66 @@ void sde_reglog_log(u8 blk_id, u32 val, u32 addr)
 	reglog->last++;
 }
 
+/* Ring holding the oldest entry that is left to dump, NULL if there is none */
+static struct sde_dbg_evtlog_ring *_sde_evtlog_dump_oldest(
+		struct sde_dbg_evtlog *evtlog)
+{
+	struct sde_dbg_evtlog_ring *ring, *oldest = NULL;
+	s64 time, oldest_time = 0;
+	u32 i;
+
+	for (i = 0; i < evtlog->nr_rings; i++) {
+		ring = &evtlog->rings[i];
+		if (ring->next == ring->last_dump)
+			continue;
+
+		time = ring->logs[ring->next % SDE_EVTLOG_CPU_ENTRY].time;
+		if (!oldest || time < oldest_time) {
+			oldest = ring;
+			oldest_time = time;
+		}
+	}
+
+	return oldest;
+}
+
 /* always dump the last entries which are not dumped yet */
 static bool _sde_evtlog_dump_calc_range(struct sde_dbg_evtlog *evtlog,
 		bool update_last_entry, bool full_dump)
 {
-	int max_entries = full_dump ? SDE_EVTLOG_ENTRY : SDE_EVTLOG_PRINT_ENTRY;
+	u32 max_entries = full_dump ? SDE_EVTLOG_ENTRY : SDE_EVTLOG_PRINT_ENTRY;
+	struct sde_dbg_evtlog_ring *ring;
+	u32 i, pending = 0, skipped = 0;
 
 	if (!evtlog)
 		return false;
 
-	evtlog->first = evtlog->next;
+	for (i = 0; i < evtlog->nr_rings; i++) {
+		ring = &evtlog->rings[i];
 
-	if (update_last_entry)
-		evtlog->last_dump = evtlog->last;
+		if (update_last_entry) {
+			ring->last_dump = READ_ONCE(ring->curr);
 
-	if (evtlog->last_dump == evtlog->first)
-		return false;
+			/* anything older was overwritten already */
+			if (ring->last_dump - ring->next > SDE_EVTLOG_CPU_ENTRY)
+				ring->next = ring->last_dump -
+					SDE_EVTLOG_CPU_ENTRY;
+		}
 
-	if (evtlog->last_dump < evtlog->first) {
-		evtlog->first %= SDE_EVTLOG_ENTRY;
-		if (evtlog->last_dump < evtlog->first)
-			evtlog->last_dump += SDE_EVTLOG_ENTRY;
+		pending += ring->last_dump - ring->next;
 	}
 
-	if ((evtlog->last_dump - evtlog->first) > max_entries) {
-		pr_info("evtlog skipping %d entries, last=%d\n",
-			evtlog->last_dump - evtlog->first -
-			max_entries, evtlog->last_dump - 1);
-		evtlog->first = evtlog->last_dump - max_entries;
+	if (!pending)
+		return false;
+
+	/* keep the most recent entries of all cpus */
+	if (update_last_entry) {
+		for (; pending > max_entries; pending--, skipped++)
+			_sde_evtlog_dump_oldest(evtlog)->next++;
+
+		if (skipped)
+			pr_info("evtlog skipping %u entries\n", skipped);
 	}
-	evtlog->next = evtlog->first + 1;
 
 	return true;
 }
@@ -162,8 +204,10 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 {
 	int i;
 	ssize_t off = 0;
-	struct sde_dbg_evtlog_log *log, *prev_log;
+	struct sde_dbg_evtlog_ring *ring;
+	struct sde_dbg_evtlog_log log;
 	unsigned long flags;
+	u32 index;
 
 	if (!evtlog || !evtlog_buf)
 		return 0;
@@ -174,12 +218,23 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	if (!_sde_evtlog_dump_calc_range(evtlog, update_last_entry, full_dump))
 		goto exit;
 
-	log = &evtlog->logs[evtlog->first % SDE_EVTLOG_ENTRY];
+	/* merge the rings of all cpus by timestamp */
+	ring = _sde_evtlog_dump_oldest(evtlog);
+	index = ring->next++;
+
+	/*
+	 * The owning cpu can overwrite the entry while it is printed if the
+	 * dump falls a whole ring behind. Work on a copy so that only the
+	 * content might be stale.
+	 */
+	log = ring->logs[index % SDE_EVTLOG_CPU_ENTRY];
+	log.data_cnt = min_t(u32, log.data_cnt, SDE_EVTLOG_MAX_DATA);
 
-	prev_log = &evtlog->logs[(evtlog->first - 1) % SDE_EVTLOG_ENTRY];
+	if (update_last_entry)
+		evtlog->prev_time = log.time;
 
 	off = snprintf((evtlog_buf + off), (evtlog_buf_size - off), "%s:%-4d",
-		log->name, log->line);
+		log.name, log.line);
 
 	if (off < SDE_EVTLOG_BUF_ALIGN) {
 		memset((evtlog_buf + off), 0x20, (SDE_EVTLOG_BUF_ALIGN - off));
@@ -187,12 +242,13 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	}
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-		"=>[%-8d:%-11llu:%9llu][%-4d]:[%-4d]:", evtlog->first,
-		log->time, (log->time - prev_log->time), log->pid, log->cpu);
+		"=>[%-8d:%-11llu:%9llu][%-4d]:[%-4d]:", index,
+		log.time, (log.time - evtlog->prev_time), log.pid, log.cpu);
+	evtlog->prev_time = log.time;
 
-	for (i = 0; i < log->data_cnt; i++)
+	for (i = 0; i < log.data_cnt; i++)
 		off += snprintf((evtlog_buf + off), (evtlog_buf_size - off),
-			"%x ", log->data[i]);
+			"%x ", log.data[i]);
 
 	off += snprintf((evtlog_buf + off), (evtlog_buf_size - off), "\n");
 exit:
@@ -201,6 +257,24 @@ ssize_t sde_evtlog_dump_to_buffer(struct sde_dbg_evtlog *evtlog,
 	return off;
 }
 
+void sde_evtlog_dump_rewind(struct sde_dbg_evtlog *evtlog)
+{
+	struct sde_dbg_evtlog_ring *ring;
+	unsigned long flags;
+	u32 i, curr;
+
+	if (!evtlog)
+		return;
+
+	spin_lock_irqsave(&evtlog->spin_lock, flags);
+	for (i = 0; i < evtlog->nr_rings; i++) {
+		ring = &evtlog->rings[i];
+		curr = READ_ONCE(ring->curr);
+		ring->next = curr - min_t(u32, curr, SDE_EVTLOG_CPU_ENTRY);
+	}
+	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+}
+
 void sde_evtlog_dump_all(struct sde_dbg_evtlog *evtlog)
 {
 	char buf[SDE_EVTLOG_BUF_MAX];
@@ -224,11 +298,21 @@ struct sde_dbg_evtlog *sde_evtlog_init(void)
 	if (!evtlog)
 		return ERR_PTR(-ENOMEM);
 
-	if (sde_mini_dump_add_region("evt_log", sizeof(*evtlog),
-			evtlog) < 0)
+	evtlog->nr_rings = nr_cpu_ids;
+	evtlog->rings = kcalloc(evtlog->nr_rings, sizeof(*evtlog->rings),
+			GFP_KERNEL);
+	if (!evtlog->rings) {
+		kfree(evtlog);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	if (sde_mini_dump_add_region("evt_log",
+			evtlog->nr_rings * sizeof(*evtlog->rings),
+			evtlog->rings) < 0)
 		pr_err("minidump add region failed for evtlog\n");
 
 	spin_lock_init(&evtlog->spin_lock);
+	mutex_init(&evtlog->filter_lock);
 	evtlog->enable = SDE_EVTLOG_DEFAULT_ENABLE;
 
 	INIT_LIST_HEAD(&evtlog->filter_list);
@@ -256,13 +340,12 @@ int sde_evtlog_get_filter(struct sde_dbg_evtlog *evtlog, int index,
 		char *buf, size_t bufsz)
 {
 	struct sde_evtlog_filter *filter_node;
-	unsigned long flags;
 	int rc = -EFAULT;
 
 	if (!evtlog || !buf || !bufsz || index < 0)
 		return -EINVAL;
 
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
+	mutex_lock(&evtlog->filter_lock);
 	list_for_each_entry(filter_node, &evtlog->filter_list, list) {
 		if (index--)
 			continue;
@@ -272,7 +355,7 @@ int sde_evtlog_get_filter(struct sde_dbg_evtlog *evtlog, int index,
 		rc = 0;
 		break;
 	}
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+	mutex_unlock(&evtlog->filter_lock);
 
 	return rc;
 }
@@ -281,7 +364,6 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 {
 	struct sde_evtlog_filter *filter_node, *tmp;
 	struct list_head free_list;
-	unsigned long flags;
 	char *flt;
 
 	if (!evtlog)
@@ -291,14 +373,12 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 
 	/*
 	 * Clear active filter list and cache filter_nodes locally
-	 * to reduce memory fragmentation.
+	 * to reduce memory fragmentation. The nodes are only reused
+	 * once no logger can be walking the old list anymore.
 	 */
-	spin_lock_irqsave(&evtlog->spin_lock, flags);
-	list_for_each_entry_safe(filter_node, tmp, &evtlog->filter_list, list) {
-		list_del_init(&filter_node->list);
-		list_add_tail(&filter_node->list, &free_list);
-	}
-	spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+	mutex_lock(&evtlog->filter_lock);
+	list_splice_init_rcu(&evtlog->filter_list, &free_list,
+			synchronize_rcu);
 
 	/*
 	 * Parse incoming filter request string and build up a new
@@ -326,10 +406,9 @@ void sde_evtlog_set_filter(struct sde_dbg_evtlog *evtlog, char *filter)
 		(void)strlcpy(filter_node->filter, flt,
 				SDE_EVTLOG_FILTER_STRSIZE);
 
-		spin_lock_irqsave(&evtlog->spin_lock, flags);
-		list_add_tail(&filter_node->list, &evtlog->filter_list);
-		spin_unlock_irqrestore(&evtlog->spin_lock, flags);
+		list_add_tail_rcu(&filter_node->list, &evtlog->filter_list);
 	}
+	mutex_unlock(&evtlog->filter_lock);
 
 	/*
 	 * Free any unused filter_nodes back to the system.
@@ -351,6 +430,7 @@ void sde_evtlog_destroy(struct sde_dbg_evtlog *evtlog)
 		list_del(&filter_node->list);
 		kfree(filter_node);
 	}
+	kfree(evtlog->rings);
 	kfree(evtlog);
 }
 
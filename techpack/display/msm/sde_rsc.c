@@ -61,6 +61,13 @@
 
 #define DEFAULT_PANEL_MIN_V_PREFILL	35
 
+/* hold primary idle switches back if the next commit is this close */
+#define DEFAULT_IDLE_HOLD_MS		50
+
+/* prewake this long before the predicted commit, then wait this long */
+#define PREWAKE_LEAD_US			2000
+#define PREWAKE_TIMEOUT_MS		PRIMARY_VBLANK_WORST_CASE_MS
+
 static struct sde_rsc_priv *rsc_prv_list[MAX_RSC_COUNT];
 static struct device *rpmh_dev[MAX_RSC_COUNT];
 
@@ -878,6 +885,151 @@ static int sde_rsc_hw_init(struct sde_rsc_priv *rsc)
 	return ret;
 }
 
+static int _sde_rsc_state_update(struct sde_rsc_priv *rsc,
+	struct sde_rsc_client *caller_client, enum sde_rsc_state state,
+	struct sde_rsc_cmd_config *config, int crtc_id,
+	int *wait_vblank_crtc_id);
+static void _sde_rsc_prewake_schedule(struct sde_rsc_priv *rsc);
+
+static void _sde_rsc_transition_stats(struct sde_rsc_priv *rsc,
+	enum sde_rsc_state state, ktime_t start)
+{
+	struct sde_rsc_transition_stats *stats = &rsc->stats;
+	u32 lat_us = ktime_us_delta(ktime_get(), start);
+
+	if (state >= SDE_RSC_STATE_MAX)
+		return;
+
+	stats->count[state]++;
+	stats->total_us[state] += lat_us;
+	stats->max_us[state] = max(stats->max_us[state], lat_us);
+	SDE_EVT32_VERBOSE(state, lat_us);
+}
+
+/*
+ * Track how long the primary client stays idle; the average gap predicts
+ * when the next commit will wake the rsc up again.
+ */
+static void _sde_rsc_primary_predict(struct sde_rsc_priv *rsc,
+	enum sde_rsc_state state)
+{
+	ktime_t now = ktime_get();
+	u64 gap_ns;
+
+	if (state == SDE_RSC_IDLE_STATE) {
+		if (!rsc->idle_entry_ts)
+			rsc->idle_entry_ts = now;
+		return;
+	}
+
+	if (!rsc->idle_entry_ts)
+		return;
+
+	gap_ns = ktime_to_ns(ktime_sub(now, rsc->idle_entry_ts));
+	rsc->idle_entry_ts = 0;
+	if (!rsc->idle_gap_ns)
+		rsc->idle_gap_ns = gap_ns;
+	else
+		rsc->idle_gap_ns = (rsc->idle_gap_ns * 3 + gap_ns) >> 2;
+
+	if (rsc->idle_hold_pending) {
+		rsc->idle_hold_pending = false;
+		cancel_delayed_work(&rsc->idle_hold_work);
+		rsc->stats.idle_avoided++;
+	}
+}
+
+/*
+ * A primary idle request is held back, with the rsc left in its current
+ * state, when the next commit is predicted sooner than idle_hold_ms. The
+ * commit then finds the rsc already in the right state; otherwise the
+ * idle switch happens once the hold window expires.
+ */
+static bool _sde_rsc_idle_hold(struct sde_rsc_priv *rsc,
+	struct sde_rsc_client *caller_client, enum sde_rsc_state state,
+	struct sde_rsc_cmd_config *config, int crtc_id)
+{
+	u64 hold_ns = (u64)rsc->idle_hold_ms * NSEC_PER_MSEC;
+
+	if (state != SDE_RSC_IDLE_STATE || config || !hold_ns ||
+			!rsc->idle_gap_ns || rsc->idle_gap_ns >= hold_ns ||
+			rsc->current_state == SDE_RSC_IDLE_STATE ||
+			rsc->idle_hold_pending)
+		return false;
+
+	caller_client->crtc_id = crtc_id;
+	caller_client->current_state = state;
+	rsc->idle_hold_pending = true;
+	rsc->stats.idle_held++;
+	schedule_delayed_work(&rsc->idle_hold_work,
+			msecs_to_jiffies(rsc->idle_hold_ms));
+	SDE_EVT32(caller_client->id, rsc->current_state, rsc->idle_gap_ns);
+
+	return true;
+}
+
+static void _sde_rsc_idle_hold_work(struct work_struct *work)
+{
+	struct sde_rsc_priv *rsc = container_of(to_delayed_work(work),
+			struct sde_rsc_priv, idle_hold_work);
+	struct sde_rsc_client *primary;
+	int wait_vblank_crtc_id;
+
+	mutex_lock(&rsc->client_lock);
+	primary = rsc->primary_client;
+	if (!rsc->idle_hold_pending || !primary ||
+			primary->current_state != SDE_RSC_IDLE_STATE)
+		goto end;
+
+	rsc->idle_hold_pending = false;
+	/* the display is idle, nobody waits for the vblank */
+	_sde_rsc_state_update(rsc, primary, SDE_RSC_IDLE_STATE, NULL,
+			primary->crtc_id, &wait_vblank_crtc_id);
+	if (rsc->current_state == SDE_RSC_IDLE_STATE)
+		_sde_rsc_prewake_schedule(rsc);
+end:
+	mutex_unlock(&rsc->client_lock);
+}
+
+/*
+ * Power the rsc resources up shortly before the predicted commit so the
+ * idle exit at commit time only has to switch the hw state.
+ */
+static void _sde_rsc_prewake_schedule(struct sde_rsc_priv *rsc)
+{
+	u64 delay_us;
+
+	if (!rsc->idle_hold_ms || !rsc->idle_gap_ns || rsc->prewake_active)
+		return;
+
+	delay_us = div_u64(rsc->idle_gap_ns, NSEC_PER_USEC);
+	if (delay_us <= PREWAKE_LEAD_US)
+		return;
+
+	mod_delayed_work(system_highpri_wq, &rsc->prewake_work,
+			usecs_to_jiffies(delay_us - PREWAKE_LEAD_US));
+}
+
+static void _sde_rsc_prewake_work(struct work_struct *work)
+{
+	struct sde_rsc_priv *rsc = container_of(to_delayed_work(work),
+			struct sde_rsc_priv, prewake_work);
+
+	mutex_lock(&rsc->client_lock);
+	if (rsc->prewake_active) {
+		/* no commit showed up, drop the early power vote */
+		rsc->prewake_active = false;
+		sde_rsc_resource_disable(rsc);
+		rsc->stats.prewake_miss++;
+	} else if (rsc->current_state == SDE_RSC_IDLE_STATE &&
+			!sde_rsc_resource_enable(rsc)) {
+		rsc->prewake_active = true;
+		schedule_delayed_work(&rsc->prewake_work,
+				msecs_to_jiffies(PREWAKE_TIMEOUT_MS));
+	}
+	mutex_unlock(&rsc->client_lock);
+}
+
 /**
  * sde_rsc_client_state_update() - rsc client state update
  * Video mode, cmd mode and clk state are suppoed as modes. A client need to
@@ -921,6 +1073,43 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 		*wait_vblank_crtc_id = SDE_RSC_INVALID_CRTC_ID;
 
 	mutex_lock(&rsc->client_lock);
+	if (caller_client == rsc->primary_client) {
+		_sde_rsc_primary_predict(rsc, state);
+		if (_sde_rsc_idle_hold(rsc, caller_client, state, config,
+				crtc_id)) {
+			mutex_unlock(&rsc->client_lock);
+			return 0;
+		}
+	}
+
+	rc = _sde_rsc_state_update(rsc, caller_client, state, config, crtc_id,
+			wait_vblank_crtc_id);
+
+	/* drop the early vote only once the switch holds its own */
+	if (rsc->prewake_active && state != SDE_RSC_IDLE_STATE) {
+		rsc->prewake_active = false;
+		cancel_delayed_work(&rsc->prewake_work);
+		sde_rsc_resource_disable(rsc);
+		rsc->stats.prewake_hit++;
+	}
+
+	if (caller_client == rsc->primary_client &&
+			rsc->current_state == SDE_RSC_IDLE_STATE)
+		_sde_rsc_prewake_schedule(rsc);
+
+	mutex_unlock(&rsc->client_lock);
+	return rc;
+}
+EXPORT_SYMBOL(sde_rsc_client_state_update);
+
+static int _sde_rsc_state_update(struct sde_rsc_priv *rsc,
+	struct sde_rsc_client *caller_client, enum sde_rsc_state state,
+	struct sde_rsc_cmd_config *config, int crtc_id,
+	int *wait_vblank_crtc_id)
+{
+	int rc = 0;
+	ktime_t start;
+
 	SDE_EVT32_VERBOSE(caller_client->id, caller_client->current_state,
 			state, rsc->current_state, SDE_EVTLOG_FUNC_ENTRY);
 
@@ -966,6 +1155,7 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 		}
 	}
 
+	start = ktime_get();
 	switch (state) {
 	case SDE_RSC_IDLE_STATE:
 		rc = sde_rsc_switch_to_idle(rsc, NULL, rsc->primary_client,
@@ -1018,6 +1208,8 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 	SDE_ATRACE_INT("rsc_state", state);
 	SDE_EVT32(caller_client->id, caller_client->current_state,
 			state, rsc->current_state, SDE_EVTLOG_FUNC_EXIT);
+	if (rsc->current_state != state)
+		_sde_rsc_transition_stats(rsc, state, start);
 	rsc->current_state = state;
 	rsc->update_tcs_content = true;
 
@@ -1025,10 +1217,8 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 	if (rsc->current_state == SDE_RSC_IDLE_STATE)
 		sde_rsc_resource_disable(rsc);
 end:
-	mutex_unlock(&rsc->client_lock);
 	return rc;
 }
-EXPORT_SYMBOL(sde_rsc_client_state_update);
 
 /**
  * sde_rsc_client_vote() - ab/ib vote from rsc client
@@ -1227,6 +1417,21 @@ static int _sde_debugfs_counters_show(struct seq_file *s, void *data)
 	if (!rsc)
 		return -EINVAL;
 
+	mutex_lock(&rsc->client_lock);
+	seq_puts(s, "rsc transitions:\n");
+	for (i = 0; i < SDE_RSC_STATE_MAX; ++i)
+		seq_printf(s, "\tstate[%d] count:%u avg_us:%llu max_us:%u\n",
+			i, rsc->stats.count[i],
+			rsc->stats.count[i] ? div_u64(rsc->stats.total_us[i],
+				rsc->stats.count[i]) : 0,
+			rsc->stats.max_us[i]);
+	seq_printf(s, "idle gap predicted:%llu us hold:%u ms\n",
+		div_u64(rsc->idle_gap_ns, NSEC_PER_USEC), rsc->idle_hold_ms);
+	seq_printf(s, "idle held:%u avoided:%u prewake hit:%u miss:%u\n",
+		rsc->stats.idle_held, rsc->stats.idle_avoided,
+		rsc->stats.prewake_hit, rsc->stats.prewake_miss);
+	mutex_unlock(&rsc->client_lock);
+
 	if (!rsc->hw_ops.get_counters) {
 		seq_puts(s, "counters are not supported on this target\n");
 		return 0;
@@ -1605,6 +1810,8 @@ static void _sde_rsc_init_debugfs(struct sde_rsc_priv *rsc, char *name)
 
 	debugfs_create_x32("debug_mode", 0600, rsc->debugfs_root,
 							&rsc->debug_mode);
+	debugfs_create_u32("idle_hold_ms", 0600, rsc->debugfs_root,
+							&rsc->idle_hold_ms);
 }
 #else
 static void _sde_rsc_init_debugfs(struct sde_rsc_priv *rsc, char *name)
@@ -1618,6 +1825,10 @@ static void sde_rsc_deinit(struct platform_device *pdev,
 	if (!rsc)
 		return;
 
+	cancel_delayed_work_sync(&rsc->idle_hold_work);
+	cancel_delayed_work_sync(&rsc->prewake_work);
+	if (rsc->prewake_active)
+		sde_rsc_resource_disable(rsc);
 	sde_rsc_resource_disable(rsc);
 	if (rsc->sw_fs_enabled)
 		regulator_disable(rsc->fs);
@@ -1799,6 +2010,9 @@ static int sde_rsc_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&rsc->event_list);
 	mutex_init(&rsc->client_lock);
 	init_waitqueue_head(&rsc->rsc_vsync_waitq);
+	INIT_DELAYED_WORK(&rsc->idle_hold_work, _sde_rsc_idle_hold_work);
+	INIT_DELAYED_WORK(&rsc->prewake_work, _sde_rsc_prewake_work);
+	rsc->idle_hold_ms = DEFAULT_IDLE_HOLD_MS;
 	atomic_set(&rsc->resource_refcount, 0);
 
 	pr_info("sde rsc index:%d probed successfully\n",
@@ -8,6 +8,8 @@
 #define _SDE_RSC_PRIV_H_
 
 #include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 #include <linux/sde_io_util.h>
 #include <linux/sde_rsc.h>
 
@@ -25,6 +27,8 @@
 
 #define MAX_COUNT_SIZE_SUPPORTED	128
 
+#define SDE_RSC_STATE_MAX		(SDE_RSC_VID_STATE + 1)
+
 #define SDE_RSC_REV_1			0x1
 #define SDE_RSC_REV_2			0x2
 #define SDE_RSC_REV_3			0x3
@@ -148,6 +152,26 @@ struct sde_rsc_bw_config {
 	u64	new_ab_vote[SDE_POWER_HANDLE_DBUS_ID_MAX];
 	u64	new_ib_vote[SDE_POWER_HANDLE_DBUS_ID_MAX];
 };
+/**
+ * struct sde_rsc_transition_stats: rsc state transition statistics
+ * @count:		transitions into each state
+ * @total_us:		accumulated transition latency per state
+ * @max_us:		worst transition latency per state
+ * @idle_held:		primary idle requests held back
+ * @idle_avoided:	held back idle switches cancelled by a new commit
+ * @prewake_hit:	prewakes followed by a commit
+ * @prewake_miss:	prewakes that timed out without a commit
+ */
+struct sde_rsc_transition_stats {
+	u32 count[SDE_RSC_STATE_MAX];
+	u64 total_us[SDE_RSC_STATE_MAX];
+	u32 max_us[SDE_RSC_STATE_MAX];
+	u32 idle_held;
+	u32 idle_avoided;
+	u32 prewake_hit;
+	u32 prewake_miss;
+};
+
 /**
  * struct sde_rsc_priv: sde resource state coordinator(rsc) private handle
  * @version:		rsc sequence version
@@ -197,6 +221,15 @@ struct sde_rsc_bw_config {
  * profiling_supp:	Indicates if HW has support for profiling counters
  * profiling_en:	Flag for rsc lpm profiling counters, true=enabled
  * post_poms:		bool if a panel mode change occurred
+ * idle_hold_ms:	primary idle requests are held back if the next commit
+ *			is predicted within this window, 0 disables it
+ * idle_hold_work:	performs a held back idle switch
+ * idle_hold_pending:	an idle switch is held back
+ * prewake_work:	powers up rsc resources ahead of the predicted commit
+ * prewake_active:	prewake holds a resource refcount
+ * idle_entry_ts:	time the primary client went idle
+ * idle_gap_ns:		average primary idle gap, drives the prediction
+ * stats:		transition counters and latencies
  */
 struct sde_rsc_priv {
 	u32 version;
@@ -244,6 +277,15 @@ struct sde_rsc_priv {
 	bool profiling_en;
 
 	bool post_poms;
+
+	u32 idle_hold_ms;
+	struct delayed_work idle_hold_work;
+	bool idle_hold_pending;
+	struct delayed_work prewake_work;
+	bool prewake_active;
+	ktime_t idle_entry_ts;
+	u64 idle_gap_ns;
+	struct sde_rsc_transition_stats stats;
 };
 
 /**